@@ -10,6 +10,7 @@
 #endif
 
 #include <iomanip>
+#include <math.h>
 #include <sys/time.h>
 
 #include "Activity.h"
@@ -17,7 +18,8 @@
 #include "AxisName.h"
 #include "UnitMgr.h"
 
-Activity::Activity()
+Activity::Activity() :
+	m_hrZoneHistogram(NUM_HR_HISTOGRAM_ZONES)
 {
 	SegmentType nullSegment = { 0, 0, 0 };
 
@@ -204,6 +206,7 @@ bool Activity::ProcessHrmReading(const SensorReading& reading)
 			m_currentHeartRateBpm.endTime = reading.time + 1;
 			m_totalHeartRateReadings += m_currentHeartRateBpm.value.doubleVal;
 			m_numHeartRateReadings++;
+			m_hrZoneHistogram.AddReading(reading.time, HeartRateZone());
 			
 			if (m_currentHeartRateBpm.value.doubleVal > m_maxHeartRateBpm.value.doubleVal)
 			{
@@ -346,6 +349,15 @@ ActivityAttributeType Activity::QueryActivityAttribute(const std::string& attrib
 		result.valid = (m_numHeartRateReadings > 0) && (timeSinceLastUpdate < 3000);
 #endif
 	}
+	else if (attributeName.find(ACTIVITY_ATTRIBUTE_TIME_IN_HR_ZONE) == 0)
+	{
+		uint8_t zone = ZoneHistogram::ZoneFromAttributeName(attributeName, ACTIVITY_ATTRIBUTE_TIME_IN_HR_ZONE);
+
+		result.value.timeVal = (time_t)llround(m_hrZoneHistogram.SecondsInZone(zone));
+		result.valueType = TYPE_TIME;
+		result.measureType = MEASURE_TIME;
+		result.valid = (zone >= 1) && (zone <= m_hrZoneHistogram.NumZones()) && (m_numHeartRateReadings > 0);
+	}
 	else if (attributeName.compare(ACTIVITY_ATTRIBUTE_ELAPSED_TIME) == 0)
 	{
 		result.value.timeVal = ElapsedTimeInSeconds() - NumSecondsPaused();
@@ -615,6 +627,39 @@ uint64_t Activity::CurrentTimeInMs(void) const
 	return secs + ms;
 }
 
+bool Activity::SaveState(ActivitySnapshot& snapshot) const
+{
+	snapshot.WriteDouble(m_additionalWeightKg);
+	snapshot.WriteUInt64(m_lastHeartRateUpdateTimeMs);
+	snapshot.WriteSegment(m_currentHeartRateBpm);
+	snapshot.WriteSegment(m_maxHeartRateBpm);
+	snapshot.WriteDouble(m_totalHeartRateReadings);
+	snapshot.WriteUInt16(m_numHeartRateReadings);
+	m_hrZoneHistogram.SaveState(snapshot);
+	snapshot.WriteTime(m_msPreviouslySpentPaused);
+	snapshot.WriteSensorReading(m_lastAccelReading);
+	snapshot.WriteSensorReading(m_mostRecentSensorReading);
+	snapshot.WriteUInt64(m_threatCount);
+	snapshot.WriteUInt64(m_totalThreatCount);
+	return true;
+}
+
+bool Activity::LoadState(ActivitySnapshot& snapshot)
+{
+	return snapshot.ReadDouble(m_additionalWeightKg) &&
+		snapshot.ReadUInt64(m_lastHeartRateUpdateTimeMs) &&
+		snapshot.ReadSegment(m_currentHeartRateBpm) &&
+		snapshot.ReadSegment(m_maxHeartRateBpm) &&
+		snapshot.ReadDouble(m_totalHeartRateReadings) &&
+		snapshot.ReadUInt16(m_numHeartRateReadings) &&
+		m_hrZoneHistogram.LoadState(snapshot) &&
+		snapshot.ReadTime(m_msPreviouslySpentPaused) &&
+		snapshot.ReadSensorReading(m_lastAccelReading) &&
+		snapshot.ReadSensorReading(m_mostRecentSensorReading) &&
+		snapshot.ReadUInt64(m_threatCount) &&
+		snapshot.ReadUInt64(m_totalThreatCount);
+}
+
 void Activity::BuildAttributeList(std::vector<std::string>& attributes) const
 {
 	attributes.push_back(ACTIVITY_ATTRIBUTE_HEART_RATE);
@@ -634,6 +679,10 @@ void Activity::BuildSummaryAttributeList(std::vector<std::string>& attributes) c
 	attributes.push_back(ACTIVITY_ATTRIBUTE_ELAPSED_TIME);
 	attributes.push_back(ACTIVITY_ATTRIBUTE_TIME_PAUSED);
 	attributes.push_back(ACTIVITY_ATTRIBUTE_CALORIES_BURNED);
+	for (uint8_t zone = 1; zone <= m_hrZoneHistogram.NumZones(); ++zone)
+	{
+		attributes.push_back(ZoneHistogram::AttributeName(ACTIVITY_ATTRIBUTE_TIME_IN_HR_ZONE, zone));
+	}
 }
 
 std::string Activity::FormatTimeStr(time_t timeVal) const
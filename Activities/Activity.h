@@ -13,6 +13,7 @@
 #include <time.h>
 
 #include "ActivityAttributeType.h"
+#include "ActivitySnapshot.h"
 #include "ActivityType.h"
 #include "IntervalSession.h"
 #include "PacePlan.h"
@@ -20,6 +21,7 @@
 #include "SensorReading.h"
 #include "UnitSystem.h"
 #include "User.h"
+#include "ZoneHistogram.h"
 
 typedef std::map<std::string, ActivityAttributeType> ActivityAttributeMap;
 typedef std::pair<std::string, ActivityAttributeType> ActivityAttributePair;
@@ -76,6 +78,9 @@ public:
 	virtual bool ProcessSensorReading(const SensorReading& reading);
 	virtual void OnFinishedLoadingSensorData(void) {}; // Called when done loading sensor data from the database
 
+	virtual bool SaveState(ActivitySnapshot& snapshot) const; // Serializes everything derived from the sensor data, returns FALSE if this activity type can't be snapshotted
+	virtual bool LoadState(ActivitySnapshot& snapshot); // Restores the state written by SaveState, used instead of replaying the sensor data
+
 	virtual ActivityAttributeType QueryActivityAttribute(const std::string& attributeName) const;
 	virtual void SetActivityAttribute(const std::string& attributeName, ActivityAttributeType attributeValue);
 
@@ -89,6 +94,7 @@ public:
 	virtual SegmentType MaxHeartRate(void) const { return m_maxHeartRateBpm; };
 	virtual double HeartRatePercentage(void) const { return m_currentHeartRateBpm.value.doubleVal / m_athlete.EstimateMaxHeartRate(); };
 	virtual uint8_t HeartRateZone(void) const;
+	virtual const ZoneHistogram& HeartRateZoneHistogram(void) const { return m_hrZoneHistogram; };
 
 	virtual time_t NumSecondsPaused(void) const { return NumMillisecondsPaused() / (double)1000.0; };
 	virtual time_t NumMillisecondsPaused(void) const;
@@ -141,6 +147,7 @@ protected:
 	SegmentType          m_maxHeartRateBpm;           // the hightest single heart rate monitor sample
 	double               m_totalHeartRateReadings;    // the sum of all heart rate monitor samples
 	uint16_t             m_numHeartRateReadings;      // the total number of heart rate monitor samples
+	ZoneHistogram        m_hrZoneHistogram;           // time spent in each heart rate zone
 	time_t               m_startTimeSecs;             // clock time at start
 	time_t               m_endTimeSecs;               // clock time at end
 	bool                 m_isPaused;                  // TRUE if activity is paused, FALSE otherwise
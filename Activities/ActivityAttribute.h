@@ -29,7 +29,11 @@
 #define ACTIVITY_ATTRIBUTE_NORMALIZED_POWER           "Normalized Power"        // normalized power calculation
 #define ACTIVITY_ATTRIBUTE_MAX_POWER                  "Maximum Power"           // maximum power meter reading
 #define ACTIVITY_ATTRIBUTE_POWER_ZONE                 "Power Zone"              // current power zone
+#define ACTIVITY_ATTRIBUTE_TIME_IN_POWER_ZONE         "Time In Power Zone "     // "Time In Power Zone 1", etc.
 #define ACTIVITY_ATTRIBUTE_POWER_TO_WEIGHT            "Power To Weight"         // current power to weight (watts/kg)
+#define ACTIVITY_ATTRIBUTE_MEAN_MAX_POWER             "Mean Maximal Power "     // "Mean Maximal Power 300", etc., the best average power over that many seconds
+#define ACTIVITY_ATTRIBUTE_W_PRIME_BALANCE            "W' Balance"              // kilojoules of W' left, from the rider's critical power model
+#define ACTIVITY_ATTRIBUTE_LOWEST_W_PRIME_BALANCE     "Lowest W' Balance"       // the lowest W' balance so far
 #define ACTIVITY_ATTRIBUTE_NUM_WHEEL_REVOLUTIONS      "Num. Wheel Revolutions"  // the number of wheel revolutions (from the wheel speed sensor)
 #define ACTIVITY_ATTRIBUTE_WHEEL_SPEED                "Wheel Speed"             // wheel speed
 #define ACTIVITY_ATTRIBUTE_REPS                       "Repetitions"             // number of repetitions (either computed or from theuser)
@@ -61,6 +65,7 @@
 #define ACTIVITY_ATTRIBUTE_MAX_HEART_RATE             "Maximum Heart Rate"      // highest heart rate (bpm)
 #define ACTIVITY_ATTRIBUTE_HEART_RATE_PERCENTAGE      "Heart Rate Percentage"   // % of maximum heart rate
 #define ACTIVITY_ATTRIBUTE_HEART_RATE_ZONE            "Heart Rate Zone"         // % of maximum heart rate, as a zone
+#define ACTIVITY_ATTRIBUTE_TIME_IN_HR_ZONE            "Time In Heart Rate Zone " // "Time In Heart Rate Zone 1", etc.
 #define ACTIVITY_ATTRIBUTE_ELAPSED_TIME               "Elapsed Time"            // total elapsed time (seconds)
 #define ACTIVITY_ATTRIBUTE_TIME_PAUSED                "Time Paused"             // total time paused (seconds)
 #define ACTIVITY_ATTRIBUTE_LATITUDE                   "Latitude"                // current latitude
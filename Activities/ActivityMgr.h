@@ -13,6 +13,7 @@
 #include "ActivityViewType.h"
 #include "Callbacks.h"
 #include "Coordinate.h"
+#include "CriticalPowerModelType.h"
 #include "DayType.h"
 #include "FileFormat.h"
 #include "Gender.h"
@@ -58,6 +59,7 @@ extern "C" {
 	// Functions for managing the activity hash.
 	bool CreateOrUpdateActivityHash(const char* const activityId, const char* const hash);
 	char* GetHashForActivityId(const char* const activityId);
+	char* ComputeActivityHash(const char* const activityId); // Hashes the stored locations, saves, and returns the hash
 
 	// Methods for managing the activity sync status.
 	bool IsActivitySynched(const char* const activityId, const char* const destination);
@@ -153,6 +155,11 @@ extern "C" {
 	bool LoadHistoricalActivitySummaryData(const char* const activityId);
 	bool SaveHistoricalActivitySummaryData(const char* const activityId);
 
+	// Functions for prefetching history in the background.
+	void PrefetchAdjacentHistoricalActivities(const char* const activityId);
+	void CancelHistoricalActivityPrefetch(void);
+	void SetHistoricalActivityPrefetchMemoryBudget(size_t numBytes);
+
 	// Functions for unloading history.
 	void FreeHistoricalActivityList(void);
 	void FreeHistoricalActivityObject(const char* const activityId);
@@ -204,6 +211,7 @@ extern "C" {
 	// Functions for estimating the athlete's fitness.
 	double EstimateFtp(void);
 	double EstimateMaxHr(void);
+	bool EstimateCriticalPower(CriticalPowerModelType modelType, double* criticalPower, double* wPrime, double* maxPower); // W' is in joules, maxPower is only set by the three parameter model, any of them can be NULL
 
 	// Functions for querying training zones.
 	double GetHrZone(uint8_t zoneNum);
@@ -269,9 +277,12 @@ extern "C" {
 
 	// Functions for importing/exporting activities.
 	bool ImportActivityFromFile(const char* const fileName, const char* const activityType, const char* const activityId);
+	bool ImportActivitiesFromDirectory(const char* const dirName, const char* const activityType, ImportProgressCallback callback, void* context);
 	char* ExportActivityFromDatabase(const char* const activityId, FileFormat format, const char* const dirName);
+	size_t ExportActivityFromDatabaseToFormats(const char* const activityId, const FileFormat* const formats, size_t numFormats, const char* const dirName, char** fileNames);
 	char* ExportActivityUsingCallbackData(const char* const activityId, FileFormat format, const char* const dirName, time_t startTime, const char* const sportType, NextCoordinateCallback nextCoordinateCallback, void* context);
 	char* ExportActivitySummary(const char* activityType, const char* const dirName);
+	bool ExportHistoryToColumnarFiles(const char* const dirName); // Every activity and its sensor data, for bulk analysis
 	const char* FileFormatToExtension(FileFormat format);
 
 	// Functions for processing sensor reads.
@@ -301,13 +312,50 @@ extern "C" {
 
 	// Functions for managing routes.
 	bool InitializeRouteList(void);
+	bool InitializeRouteListAtTolerance(double maxToleranceMeters); // Loads the coarsest stored copy of each route within the tolerance
 	bool ImportRouteFromFile(const char* const routeId, const char* const fileName);
 	char* RetrieveRouteInfoAsJSON(size_t routeIndex);
 	bool RetrieveRouteCoordinate(size_t routeIndex, size_t coordinateIndex, Coordinate* const coordinate);
 	bool DeleteRoute(const char* const routeId);
+	bool MatchActivityToRoutes(const char* const activityId, RouteMatchCallback callback, void* context); // Reports each time the activity followed a route from start to finish
 
 	// Functions for creating a heat map.
-	bool CreateHeatMap(HeatMapPointCallback callback, void* context);
+	bool CreateHeatMap(uint32_t zoom, HeatMapTileCallback callback, void* context);
+
+	// Functions for searching the geospatial index.
+	bool StartGeoIndexBackfill(void); // Indexes activities recorded before the index existed, on a background thread
+	void StopGeoIndexBackfill(void);
+	bool IsGeoIndexBackfillRunning(void);
+	bool QueryActivitiesInBoundingBox(double minLatitude, double minLongitude, double maxLatitude, double maxLongitude, GeoIndexMatchCallback callback, void* context);
+	bool QueryActivitiesNearCoordinate(double latitude, double longitude, double radiusMeters, GeoIndexMatchCallback callback, void* context);
+
+	// Functions for personal records.
+	bool StartPersonalRecordsUpdate(void); // Finds the best efforts of activities recorded before records were kept, on a background thread
+	bool StartPersonalRecordsRebuild(void); // Finds every activity's best efforts again, e.g. after adding a distance
+	void StopPersonalRecordsUpdate(void);
+	bool IsPersonalRecordsUpdateRunning(void);
+	bool AddPersonalRecordDistance(double distanceMeters);
+	bool RemovePersonalRecordDistance(double distanceMeters);
+	bool RetrievePersonalRecord(const char* const activityType, double distanceMeters, uint64_t* const elapsedMs, char** const pActivityId);
+	bool RetrievePersonalRecords(const char* const activityType, BestEffortCallback callback, void* context); // The fastest time over each distance, shortest first
+	bool RetrieveActivityBestEfforts(const char* const activityId, BestEffortCallback callback, void* context);
+
+	// Functions for training load.
+	bool RebuildTrainingLoad(void); // Scores every activity again, e.g. after the user's FTP or heart rates change
+	bool RetrieveTrainingLoad(time_t startTime, time_t endTime, TrainingLoadCallback callback, void* context); // One call per local calendar day, days are counted from the Unix epoch
+
+	// Functions for time in zone.
+	bool RebuildZoneTimes(void); // Reads every activity's time in zone from its summary again
+	bool RetrieveZoneTimes(time_t startTime, time_t endTime, ZoneTimeCallback callback, void* context); // One call per zone, heart rate zones first, for the local calendar days in the range
+
+	// Functions for mean maximal power.
+	bool RebuildPowerCurves(void); // Reads every activity's mean maximal power curve from its summary again
+	bool RetrieveMeanMaxPowerCurve(time_t startTime, time_t endTime, PowerCurveCallback callback, void* context); // Best of the cycling activities that started in the range, shortest duration first
+
+	// Functions for recomputing activity summaries, e.g. after a change to the calorie model.
+	bool StartSummaryRecompute(bool recomputeAll, SummaryRecomputeProgressCallback callback, void* context); // Resumes where the last one stopped unless recomputeAll is set, the callback is called on a background thread
+	void StopSummaryRecompute(void);
+	bool IsSummaryRecomputeRunning(void);
 
 	// Functions for doing coordinate calculations.
 	double DistanceBetweenCoordinates(const Coordinate c1, const Coordinate c2);
@@ -8,30 +8,44 @@
 #include "ActivityMgr.h"
 #include "ActivityAttribute.h"
 #include "ActivityFactory.h"
+#include "ActivityHasher.h"
+#include "ActivityPrefetcher.h"
+#include "ActivitySnapshot.h"
 #include "ActivitySummary.h"
 #include "AxisName.h"
+#include "BulkImporter.h"
+#include "CompressedStream.h"
+#include "CriticalPower.h"
 #include "Database.h"
 #include "DataExporter.h"
 #include "DataImporter.h"
 #include "Distance.h"
+#include "GeoIndex.h"
 #include "HeatMapGenerator.h"
 #include "HeartRateCalculator.h"
 #include "IntervalSession.h"
 #include "Params.h"
+#include "PersonalRecords.h"
+#include "RouteMatcher.h"
+#include "SummaryRecomputer.h"
+#include "TrainingLoad.h"
 #include "WorkoutImporter.h"
 #include "WorkoutPlanGenerator.h"
 #include "WorkoutScheduler.h"
+#include "ZoneTimeRollup.h"
 #include "ZonesCalculator.h"
 
 #include "Cycling.h"
 #include "FtpCalculator.h"
 #include "Hike.h"
 #include "LiftingActivity.h"
+#include "Measure.h"
 #include "MountainBiking.h"
 #include "PoolSwim.h"
 #include "Route.h"
 #include "Run.h"
 #include "Shoes.h"
+#include "UnitConversionFactors.h"
 #include "UnitMgr.h"
 #include "User.h"
 
@@ -170,6 +184,11 @@ extern "C" {
 	bool             g_autoStartEnabled = false;
 	std::mutex       g_dbLock;
 	std::mutex       g_historicalActivityLock;
+	ActivityPrefetcher* g_pPrefetcher = NULL;
+	ActivityHasher   g_liveHasher; // hash of the current activity, updated as each location is stored
+	GeoIndexBackfill* g_pGeoIndexBackfill = NULL;
+	PersonalRecordsUpdater* g_pPersonalRecordsUpdater = NULL;
+	SummaryRecomputeUpdater* g_pSummaryRecomputeUpdater = NULL;
 
 	ActivitySummaryList           g_historicalActivityList; // cache of completed activities
 	std::map<std::string, size_t> g_activityIdMap;          // maps activity IDs to activity indexes
@@ -186,6 +205,8 @@ extern "C" {
 		return (activityIndex < g_historicalActivityList.size()) && (activityIndex != ACTIVITY_INDEX_UNKNOWN);
 	}
 
+	void DestroyHistoricalActivityPrefetcher(void);
+
 	//
 	// Functions for managing the database.
 	//
@@ -247,6 +268,19 @@ extern "C" {
 
 		if (g_pDatabase)
 		{
+			HeatMapGenerator generator;
+
+			// The heat map needs the locations to know which counts to take back out.
+			generator.RemoveActivity((*g_pDatabase), activityId);
+
+			// The training load needs the activity's day to know which days to roll up again.
+			TrainingLoad load;
+			load.RemoveActivity((*g_pDatabase), activityId);
+
+			// As does the weekly time in zone.
+			ZoneTimeRollup rollup;
+			rollup.RemoveActivity((*g_pDatabase), activityId);
+
 			deleted = g_pDatabase->DeleteActivity(activityId);
 		}
 
@@ -287,6 +321,12 @@ extern "C" {
 	{
 		bool deleted = false;
 
+		// The backfill takes the database lock between activities, so it has to be stopped without holding it.
+		StopGeoIndexBackfill();
+		StopPersonalRecordsUpdate();
+		StopSummaryRecompute();
+		DestroyHistoricalActivityPrefetcher();
+
 		g_dbLock.lock();
 
 		if (g_pDatabase)
@@ -303,6 +343,11 @@ extern "C" {
 	{
 		bool deleted = false;
 
+		StopGeoIndexBackfill();
+		StopPersonalRecordsUpdate();
+		StopSummaryRecompute();
+		DestroyHistoricalActivityPrefetcher();
+
 		g_dbLock.lock();
 
 		if (g_pDatabase)
@@ -602,6 +647,22 @@ extern "C" {
 	// Functions for managing the activity hash.
 	//
 
+	// Caller should hold the database lock.
+	static bool StoreActivityHash(const std::string& activityId, const std::string& hash)
+	{
+		std::string oldHash;
+
+		if (g_pDatabase->RetrieveHashForActivityId(activityId, oldHash))
+		{
+			if (oldHash == hash)
+			{
+				return true;
+			}
+			return g_pDatabase->UpdateActivityHash(activityId, hash);
+		}
+		return g_pDatabase->CreateActivityHash(activityId, hash);
+	}
+
 	bool CreateOrUpdateActivityHash(const char* const activityId, const char* const hash)
 	{
 		// Sanity checks.
@@ -620,15 +681,33 @@ extern "C" {
 
 		if (g_pDatabase)
 		{
-			std::string oldHash;
+			result = StoreActivityHash(activityId, hash);
+		}
 
-			if (g_pDatabase->RetrieveHashForActivityId(activityId, oldHash))
-			{
-				result = g_pDatabase->UpdateActivityHash(activityId, hash);
-			}
-			else
+		g_dbLock.unlock();
+
+		return result;
+	}
+
+	char* ComputeActivityHash(const char* const activityId)
+	{
+		// Sanity check.
+		if (activityId == NULL)
+		{
+			return NULL;
+		}
+
+		char* result = NULL;
+
+		g_dbLock.lock();
+
+		if (g_pDatabase)
+		{
+			std::string hash;
+
+			if (ActivityHasher::HashActivityFromDatabase(g_pDatabase, activityId, hash) && StoreActivityHash(activityId, hash))
 			{
-				result = g_pDatabase->CreateActivityHash(activityId, hash);
+				result = strdup(hash.c_str());
 			}
 		}
 
@@ -876,12 +955,22 @@ extern "C" {
 		if (ftp < 0.1) // Estimate only if we weren't provided one
 			ftp = EstimateFtp();
 
+		// For W' balance. Without enough history to fit a model, FTP stands in for critical power.
+		double criticalPower = (double)0.0;
+		double wPrime = (double)0.0;
+		if (!EstimateCriticalPower(CRITICAL_POWER_MODEL_TWO_PARAMETER, &criticalPower, &wPrime, NULL))
+		{
+			criticalPower = ftp;
+			wPrime = CRITICAL_POWER_DEFAULT_W_PRIME;
+		}
+
 		g_user.SetActivityLevel(level);
 		g_user.SetGender(gender);
 		g_user.SetBirthDate(bday);
 		g_user.SetWeightKg(weightKg);
 		g_user.SetHeightCm(heightCm);
 		g_user.SetFtp(ftp);
+		g_user.SetCriticalPower(criticalPower, wPrime);
 		g_user.SetRestingHr(restingHr);
 		g_user.SetMaxHr(maxHr);
 		g_user.SetVO2Max(vo2Max);
@@ -2111,6 +2200,16 @@ extern "C" {
 		return ACTIVITY_INDEX_UNKNOWN;
 	}
 
+	/// Internal function - if the prefetcher loaded this activity then it now belongs to the foreground.
+	/// The caller is expected to hold g_historicalActivityLock, which is what keeps the prefetcher from evicting it.
+	void ClaimPrefetchedHistoricalActivity(size_t activityIndex)
+	{
+		if (g_pPrefetcher)
+		{
+			g_pPrefetcher->Claim(activityIndex);
+		}
+	}
+
 	//
 	// Functions for loading history.
 	//
@@ -2195,6 +2294,7 @@ extern "C" {
 		g_dbLock.lock();
 
 		size_t activityIndex = ConvertActivityIdToActivityIndex(activityId);
+		ClaimPrefetchedHistoricalActivity(activityIndex);
 
 		if (g_pActivityFactory && ValidActivityIndex(activityIndex))
 		{
@@ -2257,8 +2357,66 @@ extern "C" {
 		return result;
 	}
 
+	/// Internal function - writes the derived state of a stopped activity so that it can be reloaded without replaying its sensor data.
+	/// The caller is expected to hold g_dbLock.
+	bool SaveActivitySnapshot(const Activity* const pActivity)
+	{
+		ActivitySnapshot snapshot;
+
+		snapshot.WriteHeader(pActivity->GetType());
+		if (pActivity->SaveState(snapshot))
+		{
+			return g_pDatabase->CreateActivitySnapshot(pActivity->GetId(), ACTIVITY_SNAPSHOT_VERSION, snapshot.GetData());
+		}
+		return false;
+	}
+
+	/// Internal function - restores the activity object from its snapshot. Returns FALSE if there isn't one or if it is stale,
+	/// in which case the activity object is left in its freshly created state and the sensor data must be replayed.
+	/// The caller is expected to hold g_dbLock.
+	bool LoadActivitySnapshot(ActivitySummary& summary)
+	{
+		uint32_t version = 0;
+		std::vector<uint8_t> state;
+
+		if (!g_pDatabase->RetrieveActivitySnapshot(summary.activityId, version, state))
+		{
+			return false;
+		}
+		if (version != ACTIVITY_SNAPSHOT_VERSION)
+		{
+			return false;
+		}
+
+		ActivitySnapshot snapshot(state.data(), state.size());
+
+		if (snapshot.ReadHeader(summary.pActivity->GetType()))
+		{
+			if (summary.pActivity->LoadState(snapshot))
+			{
+				return true;
+			}
+
+			// A truncated snapshot could leave the object half populated, so start over with a new one.
+			delete summary.pActivity;
+			summary.pActivity = NULL;
+			g_pActivityFactory->CreateActivity(summary, *g_pDatabase);
+
+			MovingActivity* pMovingActivity = dynamic_cast<MovingActivity*>(summary.pActivity);
+			if (pMovingActivity)
+			{
+				LapSummaryList laps;
+
+				g_pDatabase->RetrieveLaps(summary.activityId, laps);
+				pMovingActivity->SetLaps(laps);
+			}
+		}
+		return false;
+	}
+
 	/// Internal function - not exported because of the mutex around g_historicalActivityList
-	bool LoadHistoricalActivitySensorData(const char* const activityId, SensorType sensor, SensorDataCallback callback, void* context)
+	/// If replay is FALSE then the readings are only cached, they are not sent to the activity object.
+	bool LoadHistoricalActivitySensorData(const char* const activityId, SensorType sensor, SensorDataCallback callback, void* context, bool replay)
 	{
 		bool result = false;
 
@@ -2281,7 +2439,7 @@ extern "C" {
 					{
 						if (g_pDatabase->RetrieveActivityAccelerometerReadings(summary.activityId, summary.accelerometerReadings))
 						{
-							for (auto iter = summary.accelerometerReadings.begin(); iter != summary.accelerometerReadings.end(); ++iter)
+							for (auto iter = summary.accelerometerReadings.begin(); iter != summary.accelerometerReadings.end() && replay; ++iter)
 							{
 								summary.pActivity->ProcessSensorReading((*iter));
 								if (callback)
@@ -2300,7 +2458,7 @@ extern "C" {
 					{
 						if (g_pDatabase->RetrieveActivityPositionReadings(summary.activityId, summary.locationPoints))
 						{
-							for (auto iter = summary.locationPoints.begin(); iter != summary.locationPoints.end(); ++iter)
+							for (auto iter = summary.locationPoints.begin(); iter != summary.locationPoints.end() && replay; ++iter)
 							{
 								summary.pActivity->ProcessSensorReading((*iter));
 								if (callback)
@@ -2319,7 +2477,7 @@ extern "C" {
 					{
 						if (g_pDatabase->RetrieveActivityHeartRateMonitorReadings(summary.activityId, summary.heartRateMonitorReadings))
 						{
-							for (auto iter = summary.heartRateMonitorReadings.begin(); iter != summary.heartRateMonitorReadings.end(); ++iter)
+							for (auto iter = summary.heartRateMonitorReadings.begin(); iter != summary.heartRateMonitorReadings.end() && replay; ++iter)
 							{
 								const SensorReading& reading = (*iter);
 								summary.pActivity->ProcessSensorReading(reading);
@@ -2339,7 +2497,7 @@ extern "C" {
 					{
 						if (g_pDatabase->RetrieveActivityCadenceReadings(summary.activityId, summary.cadenceReadings))
 						{
-							for (auto iter = summary.cadenceReadings.begin(); iter != summary.cadenceReadings.end(); ++iter)
+							for (auto iter = summary.cadenceReadings.begin(); iter != summary.cadenceReadings.end() && replay; ++iter)
 							{
 								const SensorReading& reading = (*iter);
 								summary.pActivity->ProcessSensorReading(reading);
@@ -2362,7 +2520,7 @@ extern "C" {
 					{
 						if (g_pDatabase->RetrieveActivityPowerMeterReadings(summary.activityId, summary.powerReadings))
 						{
-							for (auto iter = summary.powerReadings.begin(); iter != summary.powerReadings.end(); ++iter)
+							for (auto iter = summary.powerReadings.begin(); iter != summary.powerReadings.end() && replay; ++iter)
 							{
 								const SensorReading& reading = (*iter);
 								summary.pActivity->ProcessSensorReading(reading);
@@ -2386,7 +2544,7 @@ extern "C" {
 					{
 						if (g_pDatabase->RetrieveActivityEventReadings(summary.activityId, summary.eventReadings))
 						{
-							for (auto iter = summary.eventReadings.begin(); iter != summary.eventReadings.end(); ++iter)
+							for (auto iter = summary.eventReadings.begin(); iter != summary.eventReadings.end() && replay; ++iter)
 							{
 								const SensorReading& reading = (*iter);
 								if (reading.type == SENSOR_TYPE_RADAR)
@@ -2435,18 +2593,42 @@ extern "C" {
 			if (summary.pActivity)
 			{
 				std::vector<SensorType> sensorTypes;
+				bool restored = false;
+				bool readingsCached = summary.locationPoints.size() > 0 || summary.accelerometerReadings.size() > 0 ||
+					summary.heartRateMonitorReadings.size() > 0 || summary.cadenceReadings.size() > 0 ||
+					summary.powerReadings.size() > 0 || summary.eventReadings.size() > 0;
+
+				// A completed activity can be restored from its snapshot, which is much quicker than replaying every reading.
+				if (g_pDatabase && summary.endTime != 0)
+				{
+					g_dbLock.lock();
+					restored = LoadActivitySnapshot(summary);
+					g_dbLock.unlock();
+				}
 
 				summary.pActivity->ListUsableSensors(sensorTypes);
 
 				for (auto iter = sensorTypes.begin(); iter != sensorTypes.end() && result; ++iter)
 				{
-					if (!LoadHistoricalActivitySensorData(activityId, (*iter), NULL, NULL))
+					if (!LoadHistoricalActivitySensorData(activityId, (*iter), NULL, NULL, !restored))
 					{
 						result = false;
 					}
 				}
 
-				summary.pActivity->OnFinishedLoadingSensorData();
+				if (!restored)
+				{
+					summary.pActivity->OnFinishedLoadingSensorData();
+
+					// Write a fresh snapshot so the next load can skip the replay. Cached readings are not replayed,
+					// so in that case the object doesn't reflect the complete activity and shouldn't be saved.
+					if (result && !readingsCached && g_pDatabase && summary.endTime != 0)
+					{
+						g_dbLock.lock();
+						SaveActivitySnapshot(summary.pActivity);
+						g_dbLock.unlock();
+					}
+				}
 			}
 			else
 			{
@@ -2540,6 +2722,15 @@ extern "C" {
 						result = g_pDatabase->CreateSummaryData(summary.activityId, attribute, value);
 					}
 				}
+
+				if (result)
+				{
+					ZoneTimeRollup rollup;
+					rollup.AddActivity((*g_pDatabase), summary.activityId);
+
+					CriticalPower criticalPower;
+					criticalPower.AddActivity((*g_pDatabase), summary.activityId);
+				}
 			}
 		}
 
@@ -2550,176 +2741,499 @@ extern "C" {
 	}
 
 	//
-	// Functions for unloading history.
+	// Functions for prefetching history in the background.
 	//
 
-	void FreeHistoricalActivityList()
+	/// Internal function - rough estimate of the heap used by a list of readings.
+	size_t EstimateSensorReadingListBytes(const SensorReadingList& readings)
 	{
-		g_historicalActivityLock.lock();
+		const size_t BYTES_PER_VALUE = 80; // map node, key string and value
 
-		for (auto iter = g_historicalActivityList.begin(); iter != g_historicalActivityList.end(); ++iter)
+		if (readings.size() == 0)
 		{
-			ActivitySummary& summary = (*iter);
-
-			if (summary.pActivity)
-			{
-				delete summary.pActivity;
-				summary.pActivity = NULL;
-			}
-
-			summary.locationPoints.clear();
-			summary.accelerometerReadings.clear();
-			summary.heartRateMonitorReadings.clear();
-			summary.cadenceReadings.clear();
-			summary.powerReadings.clear();
-			summary.summaryAttributes.clear();
+			return 0;
 		}
-
-		g_historicalActivityList.clear();
-		g_activityIdMap.clear();
-
-		g_historicalActivityLock.unlock();
+		return readings.size() * (sizeof(SensorReading) + readings.at(0).reading.size() * BYTES_PER_VALUE);
 	}
 
-	void FreeHistoricalActivityObject(const char* const activityId)
+	/// Internal function - estimated heap used by an activity's cached readings and derived data.
+	/// The caller is expected to hold g_historicalActivityLock.
+	size_t EstimateHistoricalActivityBytes(const ActivitySummary& summary)
 	{
-		g_historicalActivityLock.lock();
+		size_t numBytes = 0;
+		const MovingActivity* pMovingActivity = dynamic_cast<const MovingActivity*>(summary.pActivity);
 
-		size_t activityIndex = ConvertActivityIdToActivityIndex(activityId);
+		numBytes += EstimateSensorReadingListBytes(summary.locationPoints);
+		numBytes += EstimateSensorReadingListBytes(summary.accelerometerReadings);
+		numBytes += EstimateSensorReadingListBytes(summary.heartRateMonitorReadings);
+		numBytes += EstimateSensorReadingListBytes(summary.cadenceReadings);
+		numBytes += EstimateSensorReadingListBytes(summary.powerReadings);
+		numBytes += EstimateSensorReadingListBytes(summary.eventReadings);
 
-		if (activityIndex < g_historicalActivityList.size())
+		if (pMovingActivity)
 		{
-			ActivitySummary& summary = g_historicalActivityList.at(activityIndex);
-
-			if (summary.pActivity)
-			{
-				delete summary.pActivity;
-				summary.pActivity = NULL;
-			}
+			numBytes += pMovingActivity->GetCoordinates().size() * sizeof(Coordinate);
+			numBytes += pMovingActivity->GetDistances().size() * sizeof(TimeDistancePair);
 		}
-
-		g_historicalActivityLock.unlock();
+		return numBytes;
 	}
 
-	void FreeHistoricalActivitySensorData(const char* const activityId)
+	/// Internal function - the summary's cache for the given sensor, or NULL if that sensor's readings aren't cached.
+	SensorReadingList* HistoricalActivitySensorReadingList(ActivitySummary& summary, SensorType sensor)
 	{
-		g_historicalActivityLock.lock();
-
-		size_t activityIndex = ConvertActivityIdToActivityIndex(activityId);
-
-		if (ValidActivityIndex(activityIndex))
+		switch (sensor)
 		{
-			ActivitySummary& summary = g_historicalActivityList.at(activityIndex);
-
-			summary.locationPoints.clear();
-			summary.accelerometerReadings.clear();
-			summary.heartRateMonitorReadings.clear();
-			summary.cadenceReadings.clear();
-			summary.powerReadings.clear();
+		case SENSOR_TYPE_ACCELEROMETER:
+			return &summary.accelerometerReadings;
+		case SENSOR_TYPE_LOCATION:
+			return &summary.locationPoints;
+		case SENSOR_TYPE_HEART_RATE:
+			return &summary.heartRateMonitorReadings;
+		case SENSOR_TYPE_CADENCE:
+			return &summary.cadenceReadings;
+		case SENSOR_TYPE_POWER:
+			return &summary.powerReadings;
+		case SENSOR_TYPE_RADAR:
+			return &summary.eventReadings;
+		default:
+			break;
 		}
+		return NULL;
+	}
 
-		g_historicalActivityLock.unlock();
+	/// Internal function - reads one sensor's readings from the database. The caller is expected to hold g_dbLock.
+	bool RetrieveHistoricalActivitySensorReadings(const std::string& activityId, SensorType sensor, SensorReadingList& readings)
+	{
+		switch (sensor)
+		{
+		case SENSOR_TYPE_ACCELEROMETER:
+			return g_pDatabase->RetrieveActivityAccelerometerReadings(activityId, readings);
+		case SENSOR_TYPE_LOCATION:
+			return g_pDatabase->RetrieveActivityPositionReadings(activityId, readings);
+		case SENSOR_TYPE_HEART_RATE:
+			return g_pDatabase->RetrieveActivityHeartRateMonitorReadings(activityId, readings);
+		case SENSOR_TYPE_CADENCE:
+			return g_pDatabase->RetrieveActivityCadenceReadings(activityId, readings);
+		case SENSOR_TYPE_POWER:
+			return g_pDatabase->RetrieveActivityPowerMeterReadings(activityId, readings);
+		case SENSOR_TYPE_RADAR:
+			return g_pDatabase->RetrieveActivityEventReadings(activityId, readings);
+		default:
+			break;
+		}
+		return true;
 	}
 
-	void FreeHistoricalActivitySummaryData(const char* const activityId)
+	/// Internal function - called on the prefetcher's worker thread.
+	/// The activity is built in a private summary without holding g_historicalActivityLock, so the foreground is never
+	/// kept waiting on the load or the replay, and is only published to the history list once it is complete.
+	bool PrefetchHistoricalActivity(ActivityPrefetcher& prefetcher, size_t activityIndex, void*)
 	{
-		g_historicalActivityLock.lock();
+		const size_t CANCEL_CHECK_INTERVAL = 256;
 
-		size_t activityIndex = ConvertActivityIdToActivityIndex(activityId);
+		ActivitySummary loaded;
+		bool alreadyLoaded = true;
+
+		g_historicalActivityLock.lock();
 
 		if (ValidActivityIndex(activityIndex))
 		{
-			ActivitySummary& summary = g_historicalActivityList.at(activityIndex);
+			const ActivitySummary& summary = g_historicalActivityList.at(activityIndex);
 
-			summary.summaryAttributes.clear();
+			// Leave anything the foreground has already loaded alone.
+			alreadyLoaded = (summary.pActivity != NULL);
+			if (!alreadyLoaded)
+			{
+				loaded.activityId = summary.activityId;
+				loaded.userId = summary.userId;
+				loaded.startTime = summary.startTime;
+				loaded.endTime = summary.endTime;
+				loaded.type = summary.type;
+			}
 		}
 
 		g_historicalActivityLock.unlock();
-	}
-
-	//
-	// Functions for accessing historical data.
-	//
 
-	bool GetHistoricalActivityStartAndEndTimeByIndex(size_t activityIndex, time_t* const startTime, time_t* const endTime)
-	{
-		bool result = false;
-		
-		g_historicalActivityLock.lock();
-		
-		if (ValidActivityIndex(activityIndex))
+		if (alreadyLoaded || !g_pActivityFactory)
 		{
-			if (startTime)
-				(*startTime) = g_historicalActivityList.at(activityIndex).startTime;
-			if (endTime)
-				(*endTime) = g_historicalActivityList.at(activityIndex).endTime;
-			result = true;
+			return false;
 		}
-		
-		g_historicalActivityLock.unlock();
-		
-		return result;
-	}
 
-	bool GetHistoricalActivityStartAndEndTime(const char* const activityId, time_t* const startTime, time_t* const endTime)
-	{
-		size_t activityIndex = ConvertActivityIdToActivityIndex(activityId);
-		return GetHistoricalActivityStartAndEndTimeByIndex(activityIndex, startTime, endTime);
-	}
+		// Same sequence as the foreground, but into our own copy of the summary.
+		bool restored = false;
+		bool result = false;
 
-	// Finds the most recent sensor reading and uses it as the end time for the activity.
-	// This is useful if the activity was not ended properly (app crash, phone reboot, etc.)
-	void FixHistoricalActivityEndTime(const char* const activityId)
-	{
-		size_t activityIndex = ConvertActivityIdToActivityIndex(activityId);
+		g_dbLock.lock();
 
-		if (ValidActivityIndex(activityIndex))
+		if (g_pDatabase)
 		{
-			ActivitySummary& summary = g_historicalActivityList.at(activityIndex);
+			g_pActivityFactory->CreateActivity(loaded, *g_pDatabase);
 
-			// Has the sensor data been loaded? We'll need it for fixing the activity end time.
-			if (g_pActivityFactory && !summary.pActivity)
+			MovingActivity* pMovingActivity = dynamic_cast<MovingActivity*>(loaded.pActivity);
+			if (pMovingActivity)
 			{
-				CreateHistoricalActivityObject(activityId);
-				LoadHistoricalActivityLapData(summary.activityId.c_str());
-				LoadAllHistoricalActivitySensorData(summary.activityId.c_str());
+				LapSummaryList laps;
+
+				g_pDatabase->RetrieveLaps(loaded.activityId, laps);
+				pMovingActivity->SetLaps(laps);
 			}
-			
-			// If we haven't loaded the sensor data by now then give up.
-			if (summary.pActivity)
+			if (loaded.pActivity && loaded.endTime != 0)
 			{
-				summary.pActivity->SetEndTimeFromSensorReadings();
-				summary.endTime = summary.pActivity->GetEndTimeSecs();
+				restored = LoadActivitySnapshot(loaded);
+			}
+			result = (loaded.pActivity != NULL);
+		}
 
-				g_dbLock.lock();
+		g_dbLock.unlock();
 
-				if (g_pDatabase)
+		if (result)
+		{
+			std::vector<SensorType> sensorTypes;
+			loaded.pActivity->ListUsableSensors(sensorTypes);
+
+			for (auto sensorIter = sensorTypes.begin(); sensorIter != sensorTypes.end() && result; ++sensorIter)
+			{
+				SensorType sensor = (*sensorIter);
+				SensorReadingList* readings = HistoricalActivitySensorReadingList(loaded, sensor);
+
+				if (prefetcher.IsCancelled())
 				{
-					g_pDatabase->UpdateActivityEndTime(summary.activityId, summary.endTime);
+					result = false;
+					break;
+				}
+				if (!readings)
+				{
+					continue;
 				}
 
+				g_dbLock.lock();
+				result = g_pDatabase && RetrieveHistoricalActivitySensorReadings(loaded.activityId, sensor, (*readings));
 				g_dbLock.unlock();
-			}
-		}
-	}
-
-	char* GetHistoricalActivityType(const char* const activityId)
-	{
-		char* result = NULL;
 
-		g_historicalActivityLock.lock();
+				size_t count = 0;
+				for (auto iter = readings->begin(); iter != readings->end() && result && !restored; ++iter)
+				{
+					if (sensor != SENSOR_TYPE_RADAR || iter->type == SENSOR_TYPE_RADAR)
+					{
+						loaded.pActivity->ProcessSensorReading((*iter));
+					}
+					if ((++count % CANCEL_CHECK_INTERVAL == 0) && prefetcher.IsCancelled())
+					{
+						result = false;
+					}
+				}
+			}
 
-		size_t activityIndex = ConvertActivityIdToActivityIndex(activityId);
+			if (result && !restored)
+			{
+				loaded.pActivity->OnFinishedLoadingSensorData();
 
-		if (ValidActivityIndex(activityIndex))
-		{
-			result = strdup(g_historicalActivityList.at(activityIndex).type.c_str());
+				if (loaded.endTime != 0)
+				{
+					g_dbLock.lock();
+					if (g_pDatabase)
+						SaveActivitySnapshot(loaded.pActivity);
+					g_dbLock.unlock();
+				}
+			}
 		}
 
-		g_historicalActivityLock.unlock();
+		// Publish. If the foreground got to this activity first, or the list was rebuilt underneath us, ours is discarded.
+		if (result)
+		{
+			result = false;
 
-		return result;
-	}
+			g_historicalActivityLock.lock();
+
+			if (ValidActivityIndex(activityIndex))
+			{
+				ActivitySummary& summary = g_historicalActivityList.at(activityIndex);
+
+				if (!summary.pActivity && summary.activityId.compare(loaded.activityId) == 0)
+				{
+					summary.pActivity = loaded.pActivity;
+					summary.locationPoints.swap(loaded.locationPoints);
+					summary.accelerometerReadings.swap(loaded.accelerometerReadings);
+					summary.heartRateMonitorReadings.swap(loaded.heartRateMonitorReadings);
+					summary.cadenceReadings.swap(loaded.cadenceReadings);
+					summary.powerReadings.swap(loaded.powerReadings);
+					summary.eventReadings.swap(loaded.eventReadings);
+					loaded.pActivity = NULL;
+
+					// Adopted under the same lock the foreground claims under, so a claim can't slip in between.
+					prefetcher.Adopt(activityIndex, EstimateHistoricalActivityBytes(summary));
+					result = true;
+				}
+			}
+
+			g_historicalActivityLock.unlock();
+		}
+
+		if (loaded.pActivity)
+		{
+			delete loaded.pActivity;
+			loaded.pActivity = NULL;
+		}
+		return result;
+	}
+
+	/// Internal function - called on the prefetcher's worker thread.
+	void EvictPrefetchedHistoricalActivity(ActivityPrefetcher& prefetcher, size_t activityIndex, void*)
+	{
+		g_historicalActivityLock.lock();
+
+		// Only free the activity if the foreground hasn't claimed it since the prefetcher picked it.
+		if (prefetcher.Release(activityIndex) && ValidActivityIndex(activityIndex))
+		{
+			ActivitySummary& summary = g_historicalActivityList.at(activityIndex);
+
+			summary.locationPoints.clear();
+			summary.accelerometerReadings.clear();
+			summary.heartRateMonitorReadings.clear();
+			summary.cadenceReadings.clear();
+			summary.powerReadings.clear();
+			summary.eventReadings.clear();
+
+			if (summary.pActivity)
+			{
+				delete summary.pActivity;
+				summary.pActivity = NULL;
+			}
+		}
+
+		g_historicalActivityLock.unlock();
+	}
+
+	/// Internal function - creates the prefetcher the first time it is needed.
+	ActivityPrefetcher* HistoricalActivityPrefetcher(void)
+	{
+		if (!g_pPrefetcher)
+		{
+			g_pPrefetcher = new ActivityPrefetcher(PrefetchHistoricalActivity, EvictPrefetchedHistoricalActivity, NULL);
+		}
+		return g_pPrefetcher;
+	}
+
+	/// Internal function - stops the worker thread, abandoning whatever it was loading. Anything it already
+	/// published stays in the history list and is freed with it.
+	void DestroyHistoricalActivityPrefetcher(void)
+	{
+		if (g_pPrefetcher)
+		{
+			delete g_pPrefetcher;
+			g_pPrefetcher = NULL;
+		}
+	}
+
+	/// Call this when the user opens an activity from the history list. The activities the user is likely
+	/// to open next are loaded on a background thread.
+	void PrefetchAdjacentHistoricalActivities(const char* const activityId)
+	{
+		if (!activityId)
+		{
+			return;
+		}
+
+		g_historicalActivityLock.lock();
+		size_t activityIndex = ConvertActivityIdToActivityIndex(activityId);
+		size_t numActivities = g_historicalActivityList.size();
+		g_historicalActivityLock.unlock();
+
+		HistoricalActivityPrefetcher()->OnActivityViewed(activityIndex, numActivities);
+	}
+
+	void CancelHistoricalActivityPrefetch(void)
+	{
+		if (g_pPrefetcher)
+		{
+			g_pPrefetcher->Cancel();
+		}
+	}
+
+	void SetHistoricalActivityPrefetchMemoryBudget(size_t numBytes)
+	{
+		HistoricalActivityPrefetcher()->SetMemoryBudget(numBytes);
+	}
+
+	//
+	// Functions for unloading history.
+	//
+
+	void FreeHistoricalActivityList()
+	{
+		// The indexes the prefetcher knows about are about to become meaningless.
+		if (g_pPrefetcher)
+		{
+			g_pPrefetcher->Reset();
+		}
+
+		g_historicalActivityLock.lock();
+
+		for (auto iter = g_historicalActivityList.begin(); iter != g_historicalActivityList.end(); ++iter)
+		{
+			ActivitySummary& summary = (*iter);
+
+			if (summary.pActivity)
+			{
+				delete summary.pActivity;
+				summary.pActivity = NULL;
+			}
+
+			summary.locationPoints.clear();
+			summary.accelerometerReadings.clear();
+			summary.heartRateMonitorReadings.clear();
+			summary.cadenceReadings.clear();
+			summary.powerReadings.clear();
+			summary.eventReadings.clear();
+			summary.summaryAttributes.clear();
+		}
+
+		g_historicalActivityList.clear();
+		g_activityIdMap.clear();
+
+		g_historicalActivityLock.unlock();
+	}
+
+	void FreeHistoricalActivityObject(const char* const activityId)
+	{
+		g_historicalActivityLock.lock();
+
+		size_t activityIndex = ConvertActivityIdToActivityIndex(activityId);
+
+		if (activityIndex < g_historicalActivityList.size())
+		{
+			ActivitySummary& summary = g_historicalActivityList.at(activityIndex);
+
+			if (summary.pActivity)
+			{
+				delete summary.pActivity;
+				summary.pActivity = NULL;
+			}
+		}
+
+		g_historicalActivityLock.unlock();
+	}
+
+	void FreeHistoricalActivitySensorData(const char* const activityId)
+	{
+		g_historicalActivityLock.lock();
+
+		size_t activityIndex = ConvertActivityIdToActivityIndex(activityId);
+
+		if (ValidActivityIndex(activityIndex))
+		{
+			ActivitySummary& summary = g_historicalActivityList.at(activityIndex);
+
+			summary.locationPoints.clear();
+			summary.accelerometerReadings.clear();
+			summary.heartRateMonitorReadings.clear();
+			summary.cadenceReadings.clear();
+			summary.powerReadings.clear();
+			summary.eventReadings.clear();
+		}
+
+		g_historicalActivityLock.unlock();
+	}
+
+	void FreeHistoricalActivitySummaryData(const char* const activityId)
+	{
+		g_historicalActivityLock.lock();
+
+		size_t activityIndex = ConvertActivityIdToActivityIndex(activityId);
+
+		if (ValidActivityIndex(activityIndex))
+		{
+			ActivitySummary& summary = g_historicalActivityList.at(activityIndex);
+
+			summary.summaryAttributes.clear();
+		}
+
+		g_historicalActivityLock.unlock();
+	}
+
+	//
+	// Functions for accessing historical data.
+	//
+
+	bool GetHistoricalActivityStartAndEndTimeByIndex(size_t activityIndex, time_t* const startTime, time_t* const endTime)
+	{
+		bool result = false;
+		
+		g_historicalActivityLock.lock();
+		
+		if (ValidActivityIndex(activityIndex))
+		{
+			if (startTime)
+				(*startTime) = g_historicalActivityList.at(activityIndex).startTime;
+			if (endTime)
+				(*endTime) = g_historicalActivityList.at(activityIndex).endTime;
+			result = true;
+		}
+		
+		g_historicalActivityLock.unlock();
+		
+		return result;
+	}
+
+	bool GetHistoricalActivityStartAndEndTime(const char* const activityId, time_t* const startTime, time_t* const endTime)
+	{
+		size_t activityIndex = ConvertActivityIdToActivityIndex(activityId);
+		return GetHistoricalActivityStartAndEndTimeByIndex(activityIndex, startTime, endTime);
+	}
+
+	// Finds the most recent sensor reading and uses it as the end time for the activity.
+	// This is useful if the activity was not ended properly (app crash, phone reboot, etc.)
+	void FixHistoricalActivityEndTime(const char* const activityId)
+	{
+		size_t activityIndex = ConvertActivityIdToActivityIndex(activityId);
+
+		if (ValidActivityIndex(activityIndex))
+		{
+			ActivitySummary& summary = g_historicalActivityList.at(activityIndex);
+
+			// Has the sensor data been loaded? We'll need it for fixing the activity end time.
+			if (g_pActivityFactory && !summary.pActivity)
+			{
+				CreateHistoricalActivityObject(activityId);
+				LoadHistoricalActivityLapData(summary.activityId.c_str());
+				LoadAllHistoricalActivitySensorData(summary.activityId.c_str());
+			}
+			
+			// If we haven't loaded the sensor data by now then give up.
+			if (summary.pActivity)
+			{
+				summary.pActivity->SetEndTimeFromSensorReadings();
+				summary.endTime = summary.pActivity->GetEndTimeSecs();
+
+				g_dbLock.lock();
+
+				if (g_pDatabase)
+				{
+					g_pDatabase->UpdateActivityEndTime(summary.activityId, summary.endTime);
+				}
+
+				g_dbLock.unlock();
+			}
+		}
+	}
+
+	char* GetHistoricalActivityType(const char* const activityId)
+	{
+		char* result = NULL;
+
+		g_historicalActivityLock.lock();
+
+		size_t activityIndex = ConvertActivityIdToActivityIndex(activityId);
+
+		if (ValidActivityIndex(activityIndex))
+		{
+			result = strdup(g_historicalActivityList.at(activityIndex).type.c_str());
+		}
+
+		g_historicalActivityLock.unlock();
+
+		return result;
+	}
 
 	char* GetHistoricalActivityName(const char* const activityId)
 	{
@@ -3174,10 +3688,18 @@ extern "C" {
 
 		if (g_pDatabase)
 		{
-			result  = g_pDatabase->TrimActivityAccelerometerReadings(activityId, newTime, fromStart);
-			result &= g_pDatabase->TrimActivityCadenceReadings(activityId, newTime, fromStart);
-			result &= g_pDatabase->TrimActivityPositionReadings(activityId, newTime, fromStart);
-			result &= g_pDatabase->TrimActivityHeartRateMonitorReadings(activityId, newTime, fromStart);
+			HeatMapGenerator generator;
+
+			// The heat map needs the untrimmed locations to know which counts to take back out.
+			result = generator.RemoveActivity((*g_pDatabase), activityId);
+			if (result)
+			{
+				result  = g_pDatabase->TrimActivityAccelerometerReadings(activityId, newTime, fromStart);
+				result &= g_pDatabase->TrimActivityCadenceReadings(activityId, newTime, fromStart);
+				result &= g_pDatabase->TrimActivityPositionReadings(activityId, newTime, fromStart);
+				result &= g_pDatabase->TrimActivityHeartRateMonitorReadings(activityId, newTime, fromStart);
+				result &= g_pDatabase->DeleteActivitySnapshot(activityId);
+			}
 
 			if (result)
 			{
@@ -3188,15 +3710,35 @@ extern "C" {
 				else
 					result = g_pDatabase->UpdateActivityEndTime(activityId, (time_t)newTime);
 			}
-		}
-
-		g_dbLock.unlock();
-
-		return result;
-	}
-
-	//
-	// Functions for listing activity types.
+			if (result)
+			{
+				result = generator.AddActivity((*g_pDatabase), activityId);
+			}
+			if (result)
+			{
+				GeoIndex geoIndex;
+				result = geoIndex.IndexActivity((*g_pDatabase), activityId);
+			}
+			if (result)
+			{
+				PersonalRecords records;
+				result = records.AddActivity((*g_pDatabase), activityId);
+			}
+			if (result)
+			{
+				TrainingLoad load;
+				load.SetUser(g_user);
+				result = load.AddActivity((*g_pDatabase), activityId);
+			}
+		}
+
+		g_dbLock.unlock();
+
+		return result;
+	}
+
+	//
+	// Functions for listing activity types.
 	//
 
 	bool IsNameOfStrengthActivity(const std::string& name)
@@ -3294,11 +3836,17 @@ extern "C" {
 	// Functions for estimating the athlete's fitness.
 	//
 
-	// InitializeHistoricalActivityList and LoadAllHistoricalActivitySummaryData should be called before calling this.
 	double EstimateFtp(void)
 	{
+		double ftp = (double)0.0;
+
 		// First look through actual data.
-		double ftp = FtpCalculator::Estimate(g_historicalActivityList);
+		g_dbLock.lock();
+		if (g_pDatabase)
+		{
+			ftp = FtpCalculator::Estimate((*g_pDatabase));
+		}
+		g_dbLock.unlock();
 		
 		// If we didn't get anything meaningful from actual data, fall back on a 1.0 w/kg estimate.
 		if (ftp < 0.1)
@@ -3306,11 +3854,42 @@ extern "C" {
 		return ftp;
 	}
 
-	// InitializeHistoricalActivityList and LoadAllHistoricalActivitySummaryData should be called before calling this.
+	bool EstimateCriticalPower(CriticalPowerModelType modelType, double* criticalPower, double* wPrime, double* maxPower)
+	{
+		bool result = false;
+		CriticalPowerModel model;
+
+		g_dbLock.lock();
+		if (g_pDatabase)
+		{
+			CriticalPower estimator;
+			result = estimator.Estimate((*g_pDatabase), modelType, model);
+		}
+		g_dbLock.unlock();
+
+		if (result)
+		{
+			if (criticalPower)
+				(*criticalPower) = model.criticalPower;
+			if (wPrime)
+				(*wPrime) = model.wPrime;
+			if (maxPower)
+				(*maxPower) = model.maxPower;
+		}
+		return result;
+	}
+
 	double EstimateMaxHr(void)
 	{
+		double hr = (double)0.0;
+
 		// First look through actual data.
-		double hr = HeartRateCalculator::EstimateMaxHrFromData(g_historicalActivityList);
+		g_dbLock.lock();
+		if (g_pDatabase)
+		{
+			hr = HeartRateCalculator::EstimateMaxHrFromData((*g_pDatabase));
+		}
+		g_dbLock.unlock();
 		
 		// If we didn't get anything meaningful from actual data, fall back on industry standard estimates.
 		if (hr < 0.1)
@@ -3354,6 +3933,29 @@ extern "C" {
 		std::string error;
 		std::string result;
 
+		// The training load has the last four weeks of activities, and how hard they were, so the generator doesn't
+		// have to look through the whole history.
+		g_dbLock.lock();
+		if (g_pDatabase)
+		{
+			const int64_t DAYS_IN_FOUR_WEEKS = 28;
+			time_t now = time(NULL);
+			TrainingLoad load;
+			TrainingLoadDayList days;
+			TrainingLoadActivityList recentActivities;
+			int64_t today = TrainingLoad::DayNumber(now);
+
+			load.SetUser(g_user);
+			if (load.Update((*g_pDatabase)) &&
+				load.GetDays((*g_pDatabase), today, today, days) &&
+				load.GetActivities((*g_pDatabase), now - (DAYS_IN_FOUR_WEEKS * 24 * 60 * 60), now + 1, recentActivities) &&
+				days.size() == 1)
+			{
+				g_workoutGen.SetTrainingLoad(days.front(), recentActivities);
+			}
+		}
+		g_dbLock.unlock();
+
 		// Calculate inputs from activities in the database.
 		std::map<std::string, double> inputs = g_workoutGen.CalculateInputs(g_historicalActivityList,
 			goal, goalType, goalDate, hasSwimmingPoolAccess, hasOpenWaterSwimAccess, hasBicycle);
@@ -3760,6 +4362,12 @@ extern "C" {
 				
 				g_pCurrentActivity = summary.pActivity;
 				summary.pActivity = NULL;
+
+				// Pick the hash up from the locations that were already recorded.
+				g_dbLock.lock();
+				g_liveHasher.Reset();
+				g_liveHasher.AddLocationsFromDatabase(g_pDatabase, summary.activityId);
+				g_dbLock.unlock();
 			}
 		}
 	}
@@ -3811,6 +4419,7 @@ extern "C" {
 					if (g_pDatabase->StartActivity(activityId, "", g_pCurrentActivity->GetType(), "", g_pCurrentActivity->GetStartTimeSecs()))
 					{
 						g_pCurrentActivity->SetId(activityId);
+						g_liveHasher.Reset();
 						result = true;
 					}
 				}
@@ -3839,6 +4448,7 @@ extern "C" {
 					if (g_pDatabase->StartActivity(activityId, "", g_pCurrentActivity->GetType(), "", g_pCurrentActivity->GetStartTimeSecs()))
 					{
 						g_pCurrentActivity->SetId(activityId);
+						g_liveHasher.Reset();
 						result = true;
 					}
 				}
@@ -3863,6 +4473,29 @@ extern "C" {
 			if (g_pDatabase)
 			{
 				result = g_pDatabase->StopActivity(g_pCurrentActivity->GetEndTimeSecs(), g_pCurrentActivity->GetId());
+				if (result)
+				{
+					SaveActivitySnapshot(g_pCurrentActivity);
+
+					// The hash was kept up to date while recording, so storing it doesn't take another pass over the data.
+					if (g_liveHasher.NumLocations() > 0)
+					{
+						StoreActivityHash(g_pCurrentActivity->GetId(), g_liveHasher.Finish());
+					}
+
+					HeatMapGenerator generator;
+					generator.AddActivity((*g_pDatabase), g_pCurrentActivity->GetId());
+
+					GeoIndex geoIndex;
+					geoIndex.IndexActivity((*g_pDatabase), g_pCurrentActivity->GetId());
+
+					PersonalRecords records;
+					records.AddActivity((*g_pDatabase), g_pCurrentActivity->GetId());
+
+					TrainingLoad load;
+					load.SetUser(g_user);
+					load.AddActivity((*g_pDatabase), g_pCurrentActivity->GetId());
+				}
 			}
 
 			g_dbLock.unlock();
@@ -3903,6 +4536,15 @@ extern "C" {
 					result = g_pDatabase->CreateSummaryData(g_pCurrentActivity->GetId(), attribute, value);
 				}
 			}
+
+			// Computed by the current code, so there's no need for a summary recompute to revisit it.
+			g_pDatabase->UpdateSummaryVersion(g_pCurrentActivity->GetId(), ACTIVITY_SUMMARY_VERSION);
+
+			ZoneTimeRollup rollup;
+			rollup.AddActivity((*g_pDatabase), g_pCurrentActivity->GetId());
+
+			CriticalPower criticalPower;
+			criticalPower.AddActivity((*g_pDatabase), g_pCurrentActivity->GetId());
 		}
 
 		g_dbLock.unlock();
@@ -4122,29 +4764,44 @@ extern "C" {
 
 		if (pFileName && pActivityType && activityId)
 		{
-			std::string fileName = pFileName;
-			std::string fileExtension = fileName.substr(fileName.find_last_of(".") + 1);
 			DataImporter importer;
 
 			g_dbLock.lock();
-
-			if (fileExtension.compare("gpx") == 0)
-			{
-				result = importer.ImportFromGpx(pFileName, pActivityType, activityId, g_pDatabase);
-			}
-			else if (fileExtension.compare("tcx") == 0)
-			{
-				result = importer.ImportFromTcx(pFileName, pActivityType, activityId, g_pDatabase);
-			}
-			else if (fileExtension.compare("fit") == 0)
-			{
-				result = importer.ImportFromFit(pFileName, pActivityType, activityId, g_pDatabase);
-			}
-			else if (fileExtension.compare("csv") == 0)
+			result = importer.ImportFromFile(pFileName, pActivityType, activityId, g_pDatabase);
+			if (result)
 			{
-				result = importer.ImportFromCsv(pFileName, pActivityType, activityId, g_pDatabase);
+				GeoIndex geoIndex;
+				geoIndex.IndexActivity((*g_pDatabase), activityId);
+
+				PersonalRecords records;
+				records.AddActivity((*g_pDatabase), activityId);
+
+				TrainingLoad load;
+				load.SetUser(g_user);
+				load.AddActivity((*g_pDatabase), activityId);
 			}
+			g_dbLock.unlock();
+		}
+		return result;
+	}
 
+	bool ImportActivitiesFromDirectory(const char* const pDirName, const char* const pActivityType, ImportProgressCallback callback, void* context)
+	{
+		bool result = false;
+
+		if (g_pDatabase && pDirName && pActivityType)
+		{
+			// Files are parsed in parallel, the database lock is only held while each parsed activity is written.
+			BulkImporter importer(g_pDatabase, g_dbLock);
+
+			importer.SetProgressCallback(callback, context);
+			result = importer.ImportDirectory(pDirName, pActivityType);
+
+			// Score everything that was imported at once, so the days are only rolled up once.
+			TrainingLoad load;
+			load.SetUser(g_user);
+			g_dbLock.lock();
+			load.Update((*g_pDatabase));
 			g_dbLock.unlock();
 		}
 		return result;
@@ -4187,6 +4844,55 @@ extern "C" {
 		return result;
 	}
 
+	// Writes every format in a single pass over the activity's sensor data. Each entry in fileNames is set to a copy of
+	// the file name, or NULL if that format failed, and must be freed by the caller. Returns the number of files written.
+	size_t ExportActivityFromDatabaseToFormats(const char* const activityId, const FileFormat* const formats, size_t numFormats, const char* const pDirName, char** fileNames)
+	{
+		size_t numExported = 0;
+		const Activity* pActivity = NULL;
+
+		for (size_t i = 0; i < numFormats; ++i)
+		{
+			fileNames[i] = NULL;
+		}
+
+		for (auto iter = g_historicalActivityList.begin(); iter != g_historicalActivityList.end(); ++iter)
+		{
+			const ActivitySummary& current = (*iter);
+
+			if (current.activityId.compare(activityId) == 0)
+			{
+				if (!current.pActivity)
+				{
+					CreateHistoricalActivityObject(activityId);
+				}
+				pActivity = current.pActivity;
+				break;
+			}
+		}
+
+		if (pActivity)
+		{
+			std::vector<FileFormat> formatList(formats, formats + numFormats);
+			std::vector<std::string> fileNameList;
+			DataExporter exporter;
+
+			g_dbLock.lock();
+			exporter.ExportActivityFromDatabase(formatList, pDirName, fileNameList, g_pDatabase, pActivity);
+			g_dbLock.unlock();
+
+			for (size_t i = 0; i < fileNameList.size() && i < numFormats; ++i)
+			{
+				if (fileNameList.at(i).size() > 0)
+				{
+					fileNames[i] = strdup(fileNameList.at(i).c_str());
+					++numExported;
+				}
+			}
+		}
+		return numExported;
+	}
+
 	char* ExportActivityUsingCallbackData(const char* const activityId, FileFormat format, const char* const pDirName, time_t startTime, const char* const sportType, NextCoordinateCallback nextCoordinateCallback, void* context)
 	{
 		char* result = NULL;
@@ -4217,6 +4923,39 @@ extern "C" {
 		return result;
 	}
 
+	bool ExportHistoryToColumnarFiles(const char* const dirName)
+	{
+		bool result = false;
+
+		if (dirName)
+		{
+			std::vector<std::string> fileNames;
+			std::string dbFileName;
+			DataExporter exporter;
+			Database db;
+
+			g_dbLock.lock();
+			if (g_pDatabase)
+			{
+				dbFileName = g_pDatabase->GetFileName();
+			}
+			g_dbLock.unlock();
+
+			// Exporting the whole history can take minutes, so it reads through its own connection rather than
+			// holding the shared one (and g_dbLock) and stalling the activity being recorded.
+			if (dbFileName.size() > 0 && db.OpenReadOnly(dbFileName))
+			{
+				if (db.CreateStatements())
+				{
+					result = exporter.ExportHistoryToColumnarFiles(&db, dirName, fileNames);
+				}
+				db.DeleteStatements();
+				db.Close();
+			}
+		}
+		return result;
+	}
+
 	const char* FileFormatToExtension(FileFormat format)
 	{
 		switch (format)
@@ -4256,6 +4995,10 @@ extern "C" {
 			if (processed && g_pDatabase)
 			{
 				processed = g_pDatabase->CreateSensorReading(g_pCurrentActivity->GetId(), reading);
+				if (processed)
+				{
+					g_liveHasher.AddSensorReading(reading);
+				}
 			}
 
 			g_dbLock.unlock();
@@ -4539,6 +5282,31 @@ extern "C" {
 		return result;
 	}
 
+	static bool PersonalRecordDistanceForAttribute(const std::string& attributeName, double& distanceM)
+	{
+		static const std::pair<const char*, double> distances[] = {
+			{ ACTIVITY_ATTRIBUTE_FASTEST_400M, 400.0 },
+			{ ACTIVITY_ATTRIBUTE_FASTEST_KM, 1000.0 },
+			{ ACTIVITY_ATTRIBUTE_FASTEST_MILE, METERS_PER_MILE },
+			{ ACTIVITY_ATTRIBUTE_FASTEST_5K, 5000.0 },
+			{ ACTIVITY_ATTRIBUTE_FASTEST_10K, 10000.0 },
+			{ ACTIVITY_ATTRIBUTE_FASTEST_HALF_MARATHON, METERS_PER_HALF_MARATHON },
+			{ ACTIVITY_ATTRIBUTE_FASTEST_MARATHON, METERS_PER_MARATHON },
+			{ ACTIVITY_ATTRIBUTE_FASTEST_METRIC_CENTURY, 100000.0 },
+			{ ACTIVITY_ATTRIBUTE_FASTEST_CENTURY, METERS_PER_CENTURY },
+		};
+
+		for (size_t i = 0; i < sizeof(distances) / sizeof(distances[0]); ++i)
+		{
+			if (attributeName.compare(distances[i].first) == 0)
+			{
+				distanceM = distances[i].second;
+				return true;
+			}
+		}
+		return false;
+	}
+
 	ActivityAttributeType QueryBestActivityAttributeByActivityType(const char* const pAttributeName, const char* const pActivityType, bool smallestIsBest, char** const pActivityId)
 	{
 		ActivityAttributeType result;
@@ -4555,6 +5323,39 @@ extern "C" {
 
 		std::string attributeName = pAttributeName;
 		std::string activityId;
+		double recordDistanceM = 0.0;
+
+		// The fastest times over the standard distances are kept as personal records, so there's no need to look
+		// through every activity for them. Fall back to looking if the record hasn't been found yet.
+		if (smallestIsBest && PersonalRecordDistanceForAttribute(attributeName, recordDistanceM))
+		{
+			BestEffort record;
+			bool found = false;
+
+			g_dbLock.lock();
+			if (g_pDatabase)
+			{
+				PersonalRecords records;
+				found = records.GetRecord((*g_pDatabase), pActivityType, recordDistanceM, record);
+			}
+			g_dbLock.unlock();
+
+			if (found)
+			{
+				result.value.timeVal = (time_t)((record.elapsedMs + 500) / 1000);
+				result.valueType = TYPE_TIME;
+				result.measureType = MEASURE_TIME;
+				result.startTime = record.startTime;
+				result.endTime = record.startTime + record.elapsedMs;
+				result.valid = true;
+
+				if (pActivityId)
+				{
+					(*pActivityId) = strdup(record.activityId.c_str());
+				}
+				return result;
+			}
+		}
 
 		// Look through all activity summaries.
 		for (auto iter = g_historicalActivityList.begin(); iter != g_historicalActivityList.end(); ++iter)
@@ -4654,12 +5455,17 @@ extern "C" {
 	//
 
 	bool InitializeRouteList(void)
+	{
+		return InitializeRouteListAtTolerance((double)0.0);
+	}
+
+	bool InitializeRouteListAtTolerance(double maxToleranceMeters)
 	{
 		bool result = false;
 
 		g_routes.clear();
 		g_dbLock.lock();
-		result = g_pDatabase->RetrieveRoutes(g_routes);
+		result = g_pDatabase->RetrieveRoutes(g_routes, maxToleranceMeters);
 		g_dbLock.unlock();
 		return result;
 	}
@@ -4668,8 +5474,7 @@ extern "C" {
 	{
 		bool result = false;
 		
-		std::string fileName = pFileName;
-		std::string fileExtension = fileName.substr(fileName.find_last_of(".") + 1);
+		std::string fileExtension = FileLib::FileExtensionIgnoringCompression(pFileName);
 		DataImporter importer;
 
 		g_dbLock.lock();
@@ -4733,7 +5538,38 @@ extern "C" {
 		g_dbLock.lock();
 		result = g_pDatabase->DeleteRoute(routeId);
 		result &= g_pDatabase->DeleteRouteCoordinates(routeId);
+		result &= g_pDatabase->DeleteRoutePolylines(routeId);
+		g_dbLock.unlock();
+		return result;
+	}
+
+	bool MatchActivityToRoutes(const char* const activityId, RouteMatchCallback callback, void* context)
+	{
+		bool result = false;
+		RouteMatchList matches;
+
+		if (!activityId)
+		{
+			return false;
+		}
+
+		g_dbLock.lock();
+
+		if (g_pDatabase)
+		{
+			RouteMatcher matcher;
+			result = matcher.MatchActivity((*g_pDatabase), activityId, matches);
+		}
+
 		g_dbLock.unlock();
+
+		if (result)
+		{
+			for (auto iter = matches.begin(); iter != matches.end(); ++iter)
+			{
+				callback((*iter).routeId.c_str(), (*iter).entryIndex, (*iter).exitIndex, (*iter).entryTime, (*iter).exitTime, context);
+			}
+		}
 		return result;
 	}
 
@@ -4741,21 +5577,493 @@ extern "C" {
 	// Functions for creating a heat map.
 	//
 
-	bool CreateHeatMap(HeatMapPointCallback callback, void* context)
+	bool CreateHeatMap(uint32_t zoom, HeatMapTileCallback callback, void* context)
 	{
-		HeatMap heatMap;
-		HeatMapGenerator generator;
+		bool result = false;
+
+		g_dbLock.lock();
 
-		if (generator.CreateHeatMap((*g_pDatabase), heatMap))
+		if (g_pDatabase)
 		{
-			for (auto iter = heatMap.begin(); iter != heatMap.end(); ++iter)
-			{
-				HeatMapValue& value = (*iter);
-				callback(value.coord, value.count, context);
-			}
-			return true;
+			HeatMapGenerator generator;
+			result = generator.CreateHeatMap((*g_pDatabase), zoom, callback, context);
 		}
-		return false;
+
+		g_dbLock.unlock();
+
+		return result;
+	}
+
+	//
+	// Functions for searching the geospatial index.
+	//
+
+	bool StartGeoIndexBackfill(void)
+	{
+		if (!g_pDatabase)
+		{
+			return false;
+		}
+		if (!g_pGeoIndexBackfill)
+		{
+			g_pGeoIndexBackfill = new GeoIndexBackfill(g_pDatabase, g_dbLock);
+		}
+		return g_pGeoIndexBackfill->Start();
+	}
+
+	void StopGeoIndexBackfill(void)
+	{
+		if (g_pGeoIndexBackfill)
+		{
+			g_pGeoIndexBackfill->Stop();
+		}
+	}
+
+	bool IsGeoIndexBackfillRunning(void)
+	{
+		return g_pGeoIndexBackfill && g_pGeoIndexBackfill->IsRunning();
+	}
+
+	static void ReportGeoIndexMatches(const GeoIndexMatchList& matches, GeoIndexMatchCallback callback, void* context)
+	{
+		for (auto iter = matches.begin(); iter != matches.end(); ++iter)
+		{
+			callback((*iter).activityId.c_str(), (*iter).startTime, (*iter).endTime, context);
+		}
+	}
+
+	bool QueryActivitiesInBoundingBox(double minLatitude, double minLongitude, double maxLatitude, double maxLongitude, GeoIndexMatchCallback callback, void* context)
+	{
+		bool result = false;
+		GeoIndexMatchList matches;
+
+		g_dbLock.lock();
+
+		if (g_pDatabase)
+		{
+			GeoIndex geoIndex;
+			GeoBoundingBox box;
+
+			box.minLatitude = minLatitude;
+			box.maxLatitude = maxLatitude;
+			box.minLongitude = minLongitude;
+			box.maxLongitude = maxLongitude;
+			result = geoIndex.QueryBoundingBox((*g_pDatabase), box, matches);
+		}
+
+		g_dbLock.unlock();
+
+		// The callback is made without the lock, so the caller is free to look up the activities it was given.
+		if (result)
+		{
+			ReportGeoIndexMatches(matches, callback, context);
+		}
+		return result;
+	}
+
+	bool QueryActivitiesNearCoordinate(double latitude, double longitude, double radiusMeters, GeoIndexMatchCallback callback, void* context)
+	{
+		bool result = false;
+		GeoIndexMatchList matches;
+
+		g_dbLock.lock();
+
+		if (g_pDatabase)
+		{
+			GeoIndex geoIndex;
+			result = geoIndex.QueryRadius((*g_pDatabase), latitude, longitude, radiusMeters, matches);
+		}
+
+		g_dbLock.unlock();
+
+		if (result)
+		{
+			ReportGeoIndexMatches(matches, callback, context);
+		}
+		return result;
+	}
+
+	//
+	// Functions for personal records.
+	//
+
+	static bool StartPersonalRecordsUpdater(bool rebuild)
+	{
+		if (!g_pDatabase)
+		{
+			return false;
+		}
+		if (!g_pPersonalRecordsUpdater)
+		{
+			g_pPersonalRecordsUpdater = new PersonalRecordsUpdater(g_pDatabase, g_dbLock);
+		}
+		return g_pPersonalRecordsUpdater->Start(rebuild);
+	}
+
+	bool StartPersonalRecordsUpdate(void)
+	{
+		return StartPersonalRecordsUpdater(false);
+	}
+
+	bool StartPersonalRecordsRebuild(void)
+	{
+		// A rebuild can't start while an update is still running, so finish that one first.
+		StopPersonalRecordsUpdate();
+		return StartPersonalRecordsUpdater(true);
+	}
+
+	void StopPersonalRecordsUpdate(void)
+	{
+		if (g_pPersonalRecordsUpdater)
+		{
+			g_pPersonalRecordsUpdater->Stop();
+		}
+	}
+
+	bool IsPersonalRecordsUpdateRunning(void)
+	{
+		return g_pPersonalRecordsUpdater && g_pPersonalRecordsUpdater->IsRunning();
+	}
+
+	bool AddPersonalRecordDistance(double distanceMeters)
+	{
+		bool result = false;
+
+		g_dbLock.lock();
+
+		if (g_pDatabase)
+		{
+			PersonalRecords records;
+			result = records.AddDistance((*g_pDatabase), distanceMeters);
+		}
+
+		g_dbLock.unlock();
+
+		return result;
+	}
+
+	bool RemovePersonalRecordDistance(double distanceMeters)
+	{
+		bool result = false;
+
+		g_dbLock.lock();
+
+		if (g_pDatabase)
+		{
+			PersonalRecords records;
+			result = records.RemoveDistance((*g_pDatabase), distanceMeters);
+		}
+
+		g_dbLock.unlock();
+
+		return result;
+	}
+
+	bool RetrievePersonalRecord(const char* const activityType, double distanceMeters, uint64_t* const elapsedMs, char** const pActivityId)
+	{
+		if (activityType == NULL)
+		{
+			return false;
+		}
+
+		bool result = false;
+		BestEffort record;
+
+		g_dbLock.lock();
+
+		if (g_pDatabase)
+		{
+			PersonalRecords records;
+			result = records.GetRecord((*g_pDatabase), activityType, distanceMeters, record);
+		}
+
+		g_dbLock.unlock();
+
+		if (result)
+		{
+			if (elapsedMs)
+			{
+				(*elapsedMs) = record.elapsedMs;
+			}
+			if (pActivityId)
+			{
+				(*pActivityId) = strdup(record.activityId.c_str());
+			}
+		}
+		return result;
+	}
+
+	static void ReportBestEfforts(const BestEffortList& efforts, BestEffortCallback callback, void* context)
+	{
+		for (auto iter = efforts.begin(); iter != efforts.end(); ++iter)
+		{
+			callback((*iter).activityId.c_str(), (*iter).distanceM, (*iter).elapsedMs, (*iter).startTime, context);
+		}
+	}
+
+	bool RetrievePersonalRecords(const char* const activityType, BestEffortCallback callback, void* context)
+	{
+		if (activityType == NULL)
+		{
+			return false;
+		}
+
+		bool result = false;
+		BestEffortList efforts;
+
+		g_dbLock.lock();
+
+		if (g_pDatabase)
+		{
+			PersonalRecords records;
+			result = records.GetRecords((*g_pDatabase), activityType, efforts);
+		}
+
+		g_dbLock.unlock();
+
+		if (result)
+		{
+			ReportBestEfforts(efforts, callback, context);
+		}
+		return result;
+	}
+
+	bool RetrieveActivityBestEfforts(const char* const activityId, BestEffortCallback callback, void* context)
+	{
+		if (activityId == NULL)
+		{
+			return false;
+		}
+
+		bool result = false;
+		BestEffortList efforts;
+
+		g_dbLock.lock();
+
+		if (g_pDatabase)
+		{
+			PersonalRecords records;
+			result = records.GetActivityBestEfforts((*g_pDatabase), activityId, efforts);
+		}
+
+		g_dbLock.unlock();
+
+		if (result)
+		{
+			ReportBestEfforts(efforts, callback, context);
+		}
+		return result;
+	}
+
+	//
+	// Functions for training load.
+	//
+
+	bool RebuildTrainingLoad(void)
+	{
+		bool result = false;
+
+		g_dbLock.lock();
+
+		if (g_pDatabase)
+		{
+			TrainingLoad load;
+			load.SetUser(g_user);
+			result = load.Rebuild((*g_pDatabase));
+		}
+
+		g_dbLock.unlock();
+
+		return result;
+	}
+
+	bool RetrieveTrainingLoad(time_t startTime, time_t endTime, TrainingLoadCallback callback, void* context)
+	{
+		if (callback == NULL || endTime < startTime)
+		{
+			return false;
+		}
+
+		bool result = false;
+		TrainingLoadDayList days;
+
+		g_dbLock.lock();
+
+		if (g_pDatabase)
+		{
+			TrainingLoad load;
+			load.SetUser(g_user);
+			result = load.Update((*g_pDatabase)) && load.GetDays((*g_pDatabase), TrainingLoad::DayNumber(startTime), TrainingLoad::DayNumber(endTime), days);
+		}
+
+		g_dbLock.unlock();
+
+		if (result)
+		{
+			for (auto iter = days.begin(); iter != days.end(); ++iter)
+			{
+				callback((*iter).day, (*iter).stress, (*iter).ctl, (*iter).atl, (*iter).tsb, context);
+			}
+		}
+		return result;
+	}
+
+	//
+	// Functions for time in zone.
+	//
+
+	bool RebuildZoneTimes(void)
+	{
+		bool result = false;
+
+		g_dbLock.lock();
+
+		if (g_pDatabase)
+		{
+			ZoneTimeRollup rollup;
+
+			if (g_pDatabase->BeginTransaction())
+			{
+				result = rollup.Rebuild((*g_pDatabase));
+
+				if (result)
+				{
+					result = g_pDatabase->CommitTransaction();
+				}
+				else
+				{
+					g_pDatabase->RollbackTransaction();
+				}
+			}
+		}
+
+		g_dbLock.unlock();
+
+		return result;
+	}
+
+	bool RetrieveZoneTimes(time_t startTime, time_t endTime, ZoneTimeCallback callback, void* context)
+	{
+		if (callback == NULL || endTime < startTime)
+		{
+			return false;
+		}
+
+		bool result = false;
+		ZoneTimeList times;
+
+		g_dbLock.lock();
+
+		if (g_pDatabase)
+		{
+			ZoneTimeRollup rollup;
+			result = rollup.GetZoneTimes((*g_pDatabase), TrainingLoad::DayNumber(startTime), TrainingLoad::DayNumber(endTime), times);
+		}
+
+		g_dbLock.unlock();
+
+		if (result)
+		{
+			for (auto iter = times.begin(); iter != times.end(); ++iter)
+			{
+				callback((*iter).zoneType, (*iter).zone, (*iter).seconds, context);
+			}
+		}
+		return result;
+	}
+
+	//
+	// Functions for mean maximal power.
+	//
+
+	bool RebuildPowerCurves(void)
+	{
+		bool result = false;
+
+		g_dbLock.lock();
+
+		if (g_pDatabase)
+		{
+			CriticalPower criticalPower;
+
+			if (g_pDatabase->BeginTransaction())
+			{
+				result = criticalPower.Rebuild((*g_pDatabase));
+
+				if (result)
+				{
+					result = g_pDatabase->CommitTransaction();
+				}
+				else
+				{
+					g_pDatabase->RollbackTransaction();
+				}
+			}
+		}
+
+		g_dbLock.unlock();
+
+		return result;
+	}
+
+	bool RetrieveMeanMaxPowerCurve(time_t startTime, time_t endTime, PowerCurveCallback callback, void* context)
+	{
+		if (callback == NULL || endTime < startTime)
+		{
+			return false;
+		}
+
+		bool result = false;
+		PowerCurvePointList points;
+
+		g_dbLock.lock();
+
+		if (g_pDatabase)
+		{
+			CriticalPower criticalPower;
+			result = criticalPower.GetCurve((*g_pDatabase), startTime, endTime, points);
+		}
+
+		g_dbLock.unlock();
+
+		if (result)
+		{
+			for (auto iter = points.begin(); iter != points.end(); ++iter)
+			{
+				callback((*iter).durationSecs, (*iter).watts, context);
+			}
+		}
+		return result;
+	}
+
+	//
+	// Functions for recomputing activity summaries.
+	//
+
+	bool StartSummaryRecompute(bool recomputeAll, SummaryRecomputeProgressCallback callback, void* context)
+	{
+		if (!g_pDatabase)
+		{
+			return false;
+		}
+		if (!g_pSummaryRecomputeUpdater)
+		{
+			g_pSummaryRecomputeUpdater = new SummaryRecomputeUpdater(g_pDatabase, g_dbLock);
+		}
+		return g_pSummaryRecomputeUpdater->Start(recomputeAll, g_user, callback, context);
+	}
+
+	void StopSummaryRecompute(void)
+	{
+		if (g_pSummaryRecomputeUpdater)
+		{
+			g_pSummaryRecomputeUpdater->Stop();
+		}
+	}
+
+	bool IsSummaryRecomputeRunning(void)
+	{
+		return g_pSummaryRecomputeUpdater && g_pSummaryRecomputeUpdater->IsRunning();
 	}
 
 	//
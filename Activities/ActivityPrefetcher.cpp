@@ -0,0 +1,307 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "ActivityPrefetcher.h"
+
+#ifdef __APPLE__
+#include <pthread/qos.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#define INDEX_NOT_SET (size_t)-1
+
+ActivityPrefetcher::ActivityPrefetcher(PrefetchLoadFunc loadFunc, PrefetchEvictFunc evictFunc, void* context)
+{
+	m_loadFunc = loadFunc;
+	m_evictFunc = evictFunc;
+	m_context = context;
+	m_generation = 0;
+	m_loadGeneration = 0;
+	m_epoch = 0;
+	m_loadEpoch = 0;
+	m_stop = false;
+	m_bytesUsed = 0;
+	m_memoryBudget = PREFETCH_DEFAULT_MEMORY_BUDGET;
+	m_lookahead = PREFETCH_DEFAULT_LOOKAHEAD;
+	m_lastViewedIndex = INDEX_NOT_SET;
+	m_direction = 1;
+	m_worker = std::thread(&ActivityPrefetcher::Run, this);
+}
+
+ActivityPrefetcher::~ActivityPrefetcher()
+{
+	m_mutex.lock();
+	m_stop = true;
+	m_queue.clear();
+	++m_generation;
+	m_mutex.unlock();
+
+	m_cv.notify_all();
+
+	if (m_worker.joinable())
+	{
+		m_worker.join();
+	}
+}
+
+void ActivityPrefetcher::SetMemoryBudget(size_t numBytes)
+{
+	m_mutex.lock();
+	m_memoryBudget = numBytes;
+	m_mutex.unlock();
+}
+
+void ActivityPrefetcher::SetLookahead(size_t numActivities)
+{
+	m_mutex.lock();
+	m_lookahead = numActivities;
+	m_mutex.unlock();
+}
+
+void ActivityPrefetcher::OnActivityViewed(size_t activityIndex, size_t numActivities)
+{
+	if (activityIndex >= numActivities)
+	{
+		return;
+	}
+
+	m_mutex.lock();
+
+	// Infer the direction from the previous position. A jump of more than the lookahead means the user went somewhere
+	// else entirely, so whatever is still queued is of no use.
+	if (m_lastViewedIndex != INDEX_NOT_SET)
+	{
+		size_t distance = activityIndex > m_lastViewedIndex ? activityIndex - m_lastViewedIndex : m_lastViewedIndex - activityIndex;
+
+		if (activityIndex > m_lastViewedIndex)
+			m_direction = 1;
+		else if (activityIndex < m_lastViewedIndex)
+			m_direction = -1;
+
+		if (distance > m_lookahead)
+		{
+			++m_generation;
+		}
+	}
+	m_lastViewedIndex = activityIndex;
+
+	// The activity being viewed belongs to the foreground now.
+	auto iter = m_prefetched.find(activityIndex);
+	if (iter != m_prefetched.end())
+	{
+		m_bytesUsed -= (*iter).second;
+		m_prefetched.erase(iter);
+	}
+
+	// Queue the next few activities in the direction of travel, closest first.
+	m_queue.clear();
+	for (size_t i = 1; i <= m_lookahead; ++i)
+	{
+		if (m_direction > 0)
+		{
+			if (activityIndex + i >= numActivities)
+				break;
+			m_queue.push_back(activityIndex + i);
+		}
+		else
+		{
+			if (i > activityIndex)
+				break;
+			m_queue.push_back(activityIndex - i);
+		}
+	}
+
+	m_mutex.unlock();
+	m_cv.notify_one();
+}
+
+void ActivityPrefetcher::Cancel(void)
+{
+	m_mutex.lock();
+	m_queue.clear();
+	++m_generation;
+	m_mutex.unlock();
+}
+
+void ActivityPrefetcher::Reset(void)
+{
+	m_mutex.lock();
+	m_queue.clear();
+	m_prefetched.clear();
+	m_bytesUsed = 0;
+	m_lastViewedIndex = INDEX_NOT_SET;
+	m_direction = 1;
+	++m_generation;
+	++m_epoch;
+	m_mutex.unlock();
+}
+
+void ActivityPrefetcher::Claim(size_t activityIndex)
+{
+	m_mutex.lock();
+
+	auto iter = m_prefetched.find(activityIndex);
+	if (iter != m_prefetched.end())
+	{
+		m_bytesUsed -= (*iter).second;
+		m_prefetched.erase(iter);
+	}
+
+	m_mutex.unlock();
+}
+
+bool ActivityPrefetcher::Adopt(size_t activityIndex, size_t numBytes)
+{
+	bool adopted = false;
+
+	m_mutex.lock();
+
+	// If the list was reset while we were loading then the index no longer refers to the same activity,
+	// and if the user is already looking at it then it belongs to the foreground.
+	if (m_loadEpoch == m_epoch && activityIndex != m_lastViewedIndex && m_prefetched.count(activityIndex) == 0)
+	{
+		m_prefetched[activityIndex] = numBytes;
+		m_bytesUsed += numBytes;
+		adopted = true;
+	}
+
+	m_mutex.unlock();
+
+	return adopted;
+}
+
+bool ActivityPrefetcher::Release(size_t activityIndex)
+{
+	bool released = false;
+
+	m_mutex.lock();
+
+	auto iter = m_prefetched.find(activityIndex);
+	if (iter != m_prefetched.end())
+	{
+		m_bytesUsed -= (*iter).second;
+		m_prefetched.erase(iter);
+		released = true;
+	}
+
+	m_mutex.unlock();
+
+	return released;
+}
+
+/// Evicts the prefetched activities that are farthest from the user until we're back under budget.
+/// Returns FALSE if that isn't possible without evicting something in the lookahead window.
+bool ActivityPrefetcher::MakeRoom(uint32_t generation)
+{
+	while (true)
+	{
+		size_t victim = INDEX_NOT_SET;
+		size_t victimDistance = 0;
+
+		m_mutex.lock();
+
+		if (m_bytesUsed < m_memoryBudget)
+		{
+			m_mutex.unlock();
+			return true;
+		}
+		if (generation != m_generation)
+		{
+			m_mutex.unlock();
+			return false;
+		}
+
+		for (auto iter = m_prefetched.begin(); iter != m_prefetched.end(); ++iter)
+		{
+			size_t index = (*iter).first;
+			size_t distance = index > m_lastViewedIndex ? index - m_lastViewedIndex : m_lastViewedIndex - index;
+
+			if (distance > m_lookahead && distance > victimDistance)
+			{
+				victim = index;
+				victimDistance = distance;
+			}
+		}
+
+		if (victim == INDEX_NOT_SET)
+		{
+			m_mutex.unlock();
+			return false;
+		}
+
+		m_mutex.unlock();
+
+		// The entry stays in the map until the callback releases it under the foreground's lock, so a claim that
+		// comes in first wins and the activity is left alone.
+		m_evictFunc(*this, victim, m_context);
+
+		m_mutex.lock();
+		bool stuck = m_prefetched.count(victim) > 0;
+		m_mutex.unlock();
+
+		if (stuck)
+		{
+			return false;
+		}
+	}
+}
+
+void ActivityPrefetcher::Run(void)
+{
+	// This is speculative work, so stay out of the way of the UI.
+#ifdef __APPLE__
+	pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+#else
+	setpriority(PRIO_PROCESS, 0, 10);
+#endif
+
+	while (true)
+	{
+		size_t activityIndex = 0;
+		uint32_t generation = 0;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			m_cv.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+			if (m_stop)
+			{
+				break;
+			}
+
+			activityIndex = m_queue.front();
+			m_queue.pop_front();
+			generation = m_generation;
+
+			if (m_prefetched.count(activityIndex) > 0)
+			{
+				continue;
+			}
+		}
+
+		if (!MakeRoom(generation))
+		{
+			Cancel();
+			continue;
+		}
+
+		m_mutex.lock();
+		m_loadGeneration = generation;
+		m_loadEpoch = m_epoch;
+		m_mutex.unlock();
+
+		// Another cancel may have come in while we were evicting.
+		if (IsCancelled())
+		{
+			continue;
+		}
+
+		// The callback publishes the activity and calls Adopt itself, there's nothing more to do here either way.
+		m_loadFunc(*this, activityIndex, m_context);
+	}
+}
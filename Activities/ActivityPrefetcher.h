@@ -0,0 +1,98 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __ACTIVITY_PREFETCHER__
+#define __ACTIVITY_PREFETCHER__
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+
+#define PREFETCH_DEFAULT_LOOKAHEAD     3
+#define PREFETCH_DEFAULT_MEMORY_BUDGET (24 * 1024 * 1024)
+
+class ActivityPrefetcher;
+
+typedef bool (*PrefetchLoadFunc)(ActivityPrefetcher& prefetcher, size_t activityIndex, void* context); // Loads the activity and hands it to Adopt, returns FALSE on error or cancellation
+typedef void (*PrefetchEvictFunc)(ActivityPrefetcher& prefetcher, size_t activityIndex, void* context); // Frees the activity, but only if Release says the prefetcher still owns it
+
+/**
+* Loads historical activities ahead of the user on a low priority worker thread.
+*
+* The prefetcher watches which activity the user is looking at, infers the direction the user is moving through the
+* history list, and loads the next few activities in that direction. The loading itself is delegated to the callbacks
+* so that prefetched data lands in the same caches the foreground uses. Activities that were prefetched but never
+* claimed by the foreground are evicted, farthest first, to stay within the memory budget.
+*
+* Ownership changes hands under the foreground's lock: the load callback calls Adopt, and the evict callback calls
+* Release, while holding the same lock that the foreground holds when it calls Claim. That way an activity is never
+* freed by the prefetcher after the foreground has started using it.
+*/
+class ActivityPrefetcher
+{
+public:
+	ActivityPrefetcher(PrefetchLoadFunc loadFunc, PrefetchEvictFunc evictFunc, void* context);
+	virtual ~ActivityPrefetcher();
+
+	void SetMemoryBudget(size_t numBytes);
+	void SetLookahead(size_t numActivities);
+
+	/// @brief Called when the user views an activity, queues the activities that are likely to be viewed next.
+	void OnActivityViewed(size_t activityIndex, size_t numActivities);
+
+	/// @brief Drops any queued work. The load callback is expected to poll IsCancelled and abandon the activity it is loading.
+	void Cancel(void);
+
+	/// @brief Forgets everything that was prefetched, used when the history list is rebuilt and the indexes become meaningless.
+	void Reset(void);
+
+	/// @brief The foreground is now using this activity, so it must never be evicted by the prefetcher.
+	void Claim(size_t activityIndex);
+
+	/// @brief Called by the load callback once the activity is in the caches, with the foreground's lock held.
+	/// Returns FALSE if the activity is no longer wanted, in which case the foreground owns it.
+	bool Adopt(size_t activityIndex, size_t numBytes);
+
+	/// @brief Called by the evict callback with the foreground's lock held. Returns TRUE if the activity may be freed.
+	bool Release(size_t activityIndex);
+
+	/// @brief Polled by the load callback, TRUE if the activity being loaded is no longer wanted.
+	bool IsCancelled(void) const { return m_stop || m_loadGeneration != m_generation; };
+
+private:
+	PrefetchLoadFunc            m_loadFunc;
+	PrefetchEvictFunc           m_evictFunc;
+	void*                       m_context;
+
+	std::thread                 m_worker;
+	std::mutex                  m_mutex;
+	std::condition_variable     m_cv;
+	std::atomic<uint32_t>       m_generation;     // incremented on every cancel, work from an older generation is discarded
+	std::atomic<uint32_t>       m_loadGeneration; // generation of the activity currently being loaded
+	uint32_t                    m_epoch;          // incremented on every reset, indexes from an older epoch refer to a different list
+	uint32_t                    m_loadEpoch;      // epoch of the activity currently being loaded
+	std::atomic<bool>           m_stop;
+
+	std::deque<size_t>          m_queue;      // activity indexes waiting to be loaded
+	std::map<size_t, size_t>    m_prefetched; // activity index -> approximate bytes, for activities the prefetcher loaded and still owns
+	size_t                      m_bytesUsed;
+	size_t                      m_memoryBudget;
+	size_t                      m_lookahead;
+	size_t                      m_lastViewedIndex;
+	int                         m_direction;  // +1 when moving towards newer activities, -1 when moving towards older ones
+
+	void Run(void);
+	bool MakeRoom(uint32_t generation);
+};
+
+#endif
@@ -0,0 +1,335 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <string.h>
+
+#include "ActivitySnapshot.h"
+
+#define SNAPSHOT_MAGIC 0x5354574f // "OWTS"
+
+ActivitySnapshot::ActivitySnapshot()
+{
+	m_readOffset = 0;
+}
+
+ActivitySnapshot::ActivitySnapshot(const uint8_t* data, size_t dataLen)
+{
+	if (data && dataLen > 0)
+	{
+		m_data.assign(data, data + dataLen);
+	}
+	m_readOffset = 0;
+}
+
+ActivitySnapshot::~ActivitySnapshot()
+{
+}
+
+void ActivitySnapshot::WriteBytes(const void* src, size_t len)
+{
+	const uint8_t* bytes = (const uint8_t*)src;
+	m_data.insert(m_data.end(), bytes, bytes + len);
+}
+
+bool ActivitySnapshot::ReadBytes(void* dest, size_t len)
+{
+	if (m_readOffset + len > m_data.size())
+	{
+		return false;
+	}
+	memcpy(dest, m_data.data() + m_readOffset, len);
+	m_readOffset += len;
+	return true;
+}
+
+void ActivitySnapshot::WriteHeader(const std::string& activityType)
+{
+	WriteUInt32(SNAPSHOT_MAGIC);
+	WriteUInt32(ACTIVITY_SNAPSHOT_VERSION);
+	WriteString(activityType);
+}
+
+bool ActivitySnapshot::ReadHeader(const std::string& activityType)
+{
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	std::string type;
+
+	if (!(ReadUInt32(magic) && ReadUInt32(version) && ReadString(type)))
+	{
+		return false;
+	}
+	return (magic == SNAPSHOT_MAGIC) && (version == ACTIVITY_SNAPSHOT_VERSION) && (type.compare(activityType) == 0);
+}
+
+void ActivitySnapshot::WriteBool(bool value)
+{
+	uint8_t temp = value ? 1 : 0;
+	WriteBytes(&temp, sizeof(temp));
+}
+
+void ActivitySnapshot::WriteUInt16(uint16_t value)
+{
+	WriteBytes(&value, sizeof(value));
+}
+
+void ActivitySnapshot::WriteUInt32(uint32_t value)
+{
+	WriteBytes(&value, sizeof(value));
+}
+
+void ActivitySnapshot::WriteUInt64(uint64_t value)
+{
+	WriteBytes(&value, sizeof(value));
+}
+
+void ActivitySnapshot::WriteDouble(double value)
+{
+	WriteBytes(&value, sizeof(value));
+}
+
+void ActivitySnapshot::WriteString(const std::string& value)
+{
+	WriteUInt32((uint32_t)value.size());
+	WriteBytes(value.data(), value.size());
+}
+
+void ActivitySnapshot::WriteSegment(const SegmentType& value)
+{
+	// Written as raw bytes so that whichever member of the union is in use survives the round trip.
+	WriteBytes(&value.value, sizeof(value.value));
+	WriteUInt64(value.startTime);
+	WriteUInt64(value.endTime);
+}
+
+void ActivitySnapshot::WriteCoordinate(const Coordinate& value)
+{
+	WriteDouble(value.latitude);
+	WriteDouble(value.longitude);
+	WriteDouble(value.altitude);
+	WriteDouble(value.horizontalAccuracy);
+	WriteDouble(value.verticalAccuracy);
+	WriteUInt64(value.time);
+}
+
+void ActivitySnapshot::WriteSensorReading(const SensorReading& value)
+{
+	WriteUInt32((uint32_t)value.type);
+	WriteUInt64(value.time);
+	WriteUInt32((uint32_t)value.reading.size());
+	for (auto iter = value.reading.begin(); iter != value.reading.end(); ++iter)
+	{
+		WriteString((*iter).first);
+		WriteDouble((*iter).second);
+	}
+}
+
+void ActivitySnapshot::WriteAttribute(const ActivityAttributeType& value)
+{
+	WriteBytes(&value.value, sizeof(value.value));
+	WriteUInt32((uint32_t)value.valueType);
+	WriteUInt32((uint32_t)value.measureType);
+	WriteUInt32((uint32_t)value.unitSystem);
+	WriteUInt64(value.startTime);
+	WriteUInt64(value.endTime);
+	WriteBool(value.valid);
+}
+
+void ActivitySnapshot::WriteAttributeMap(const std::map<std::string, ActivityAttributeType>& values)
+{
+	WriteUInt32((uint32_t)values.size());
+	for (auto iter = values.begin(); iter != values.end(); ++iter)
+	{
+		WriteString((*iter).first);
+		WriteAttribute((*iter).second);
+	}
+}
+
+void ActivitySnapshot::WriteDoubleList(const std::vector<double>& values)
+{
+	WriteUInt32((uint32_t)values.size());
+	WriteBytes(values.data(), values.size() * sizeof(double));
+}
+
+void ActivitySnapshot::WriteCoordinateList(const std::vector<Coordinate>& values)
+{
+	WriteUInt32((uint32_t)values.size());
+	for (auto iter = values.begin(); iter != values.end(); ++iter)
+	{
+		WriteCoordinate((*iter));
+	}
+}
+
+bool ActivitySnapshot::ReadBool(bool& value)
+{
+	uint8_t temp = 0;
+	if (!ReadBytes(&temp, sizeof(temp)))
+		return false;
+	value = (temp != 0);
+	return true;
+}
+
+bool ActivitySnapshot::ReadUInt16(uint16_t& value)
+{
+	return ReadBytes(&value, sizeof(value));
+}
+
+bool ActivitySnapshot::ReadUInt32(uint32_t& value)
+{
+	return ReadBytes(&value, sizeof(value));
+}
+
+bool ActivitySnapshot::ReadUInt64(uint64_t& value)
+{
+	return ReadBytes(&value, sizeof(value));
+}
+
+bool ActivitySnapshot::ReadDouble(double& value)
+{
+	return ReadBytes(&value, sizeof(value));
+}
+
+bool ActivitySnapshot::ReadTime(time_t& value)
+{
+	uint64_t temp = 0;
+	if (!ReadUInt64(temp))
+		return false;
+	value = (time_t)temp;
+	return true;
+}
+
+bool ActivitySnapshot::ReadString(std::string& value)
+{
+	uint32_t len = 0;
+	if (!ReadUInt32(len))
+		return false;
+	if (m_readOffset + len > m_data.size())
+		return false;
+	value.assign((const char*)m_data.data() + m_readOffset, len);
+	m_readOffset += len;
+	return true;
+}
+
+bool ActivitySnapshot::ReadSegment(SegmentType& value)
+{
+	return ReadBytes(&value.value, sizeof(value.value)) &&
+		ReadUInt64(value.startTime) &&
+		ReadUInt64(value.endTime);
+}
+
+bool ActivitySnapshot::ReadCoordinate(Coordinate& value)
+{
+	return ReadDouble(value.latitude) &&
+		ReadDouble(value.longitude) &&
+		ReadDouble(value.altitude) &&
+		ReadDouble(value.horizontalAccuracy) &&
+		ReadDouble(value.verticalAccuracy) &&
+		ReadUInt64(value.time);
+}
+
+bool ActivitySnapshot::ReadSensorReading(SensorReading& value)
+{
+	uint32_t type = 0;
+	uint32_t count = 0;
+
+	if (!(ReadUInt32(type) && ReadUInt64(value.time) && ReadUInt32(count)))
+		return false;
+
+	value.type = (SensorType)type;
+	value.reading.clear();
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		std::string name;
+		double num = (double)0.0;
+
+		if (!(ReadString(name) && ReadDouble(num)))
+			return false;
+		value.reading.insert(SensorNameValuePair(name, num));
+	}
+	return true;
+}
+
+bool ActivitySnapshot::ReadAttribute(ActivityAttributeType& value)
+{
+	uint32_t valueType = 0;
+	uint32_t measureType = 0;
+	uint32_t unitSystem = 0;
+
+	if (!(ReadBytes(&value.value, sizeof(value.value)) &&
+		ReadUInt32(valueType) &&
+		ReadUInt32(measureType) &&
+		ReadUInt32(unitSystem) &&
+		ReadUInt64(value.startTime) &&
+		ReadUInt64(value.endTime) &&
+		ReadBool(value.valid)))
+	{
+		return false;
+	}
+
+	value.valueType = (ActivityAttributeValueType)valueType;
+	value.measureType = (ActivityAttributeMeasureType)measureType;
+	value.unitSystem = (UnitSystem)unitSystem;
+	return true;
+}
+
+bool ActivitySnapshot::ReadAttributeMap(std::map<std::string, ActivityAttributeType>& values)
+{
+	uint32_t count = 0;
+
+	if (!ReadUInt32(count))
+		return false;
+
+	values.clear();
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		std::string name;
+		ActivityAttributeType value;
+
+		if (!(ReadString(name) && ReadAttribute(value)))
+			return false;
+		values.insert(std::pair<std::string, ActivityAttributeType>(name, value));
+	}
+	return true;
+}
+
+bool ActivitySnapshot::ReadDoubleList(std::vector<double>& values)
+{
+	uint32_t count = 0;
+
+	if (!ReadUInt32(count))
+		return false;
+	if (m_readOffset + (size_t)count * sizeof(double) > m_data.size())
+		return false;
+
+	values.resize(count);
+	return ReadBytes(values.data(), count * sizeof(double));
+}
+
+bool ActivitySnapshot::ReadCoordinateList(std::vector<Coordinate>& values)
+{
+	uint32_t count = 0;
+
+	if (!ReadUInt32(count))
+		return false;
+	if (m_readOffset + (size_t)count * (5 * sizeof(double) + sizeof(uint64_t)) > m_data.size())
+		return false;
+
+	values.clear();
+	values.reserve(count);
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		Coordinate coordinate;
+
+		if (!ReadCoordinate(coordinate))
+			return false;
+		values.push_back(coordinate);
+	}
+	return true;
+}
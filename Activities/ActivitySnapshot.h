@@ -0,0 +1,84 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __ACTIVITY_SNAPSHOT__
+#define __ACTIVITY_SNAPSHOT__
+
+#pragma once
+
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "ActivityAttributeType.h"
+#include "Coordinate.h"
+#include "SegmentType.h"
+#include "SensorReading.h"
+
+// Bump this whenever the layout of any Activity's SaveState/LoadState changes.
+// Snapshots with a different version are considered stale and the activity is rebuilt by replaying its sensor data.
+#define ACTIVITY_SNAPSHOT_VERSION 5
+
+/**
+* Binary buffer used to persist the derived state of an activity.
+*
+* Activities write their state with the Write* methods and read it back, in the same order, with the Read* methods.
+* All values are stored in native byte order since snapshots never leave the device that created them.
+*/
+class ActivitySnapshot
+{
+public:
+	ActivitySnapshot();
+	ActivitySnapshot(const uint8_t* data, size_t dataLen);
+	virtual ~ActivitySnapshot();
+
+	const std::vector<uint8_t>& GetData(void) const { return m_data; };
+
+	void WriteHeader(const std::string& activityType);
+	bool ReadHeader(const std::string& activityType);
+
+	void WriteBool(bool value);
+	void WriteUInt16(uint16_t value);
+	void WriteUInt32(uint32_t value);
+	void WriteUInt64(uint64_t value);
+	void WriteDouble(double value);
+	void WriteString(const std::string& value);
+	void WriteSegment(const SegmentType& value);
+	void WriteCoordinate(const Coordinate& value);
+	void WriteSensorReading(const SensorReading& value);
+	void WriteAttribute(const ActivityAttributeType& value);
+	void WriteAttributeMap(const std::map<std::string, ActivityAttributeType>& values);
+	void WriteDoubleList(const std::vector<double>& values);
+	void WriteCoordinateList(const std::vector<Coordinate>& values);
+
+	bool ReadBool(bool& value);
+	bool ReadUInt16(uint16_t& value);
+	bool ReadUInt32(uint32_t& value);
+	bool ReadUInt64(uint64_t& value);
+	bool ReadDouble(double& value);
+	bool ReadString(std::string& value);
+	bool ReadSegment(SegmentType& value);
+	bool ReadCoordinate(Coordinate& value);
+	bool ReadSensorReading(SensorReading& value);
+	bool ReadAttribute(ActivityAttributeType& value);
+	bool ReadAttributeMap(std::map<std::string, ActivityAttributeType>& values);
+	bool ReadDoubleList(std::vector<double>& values);
+	bool ReadCoordinateList(std::vector<Coordinate>& values);
+
+	bool ReadTime(time_t& value);
+	void WriteTime(time_t value) { WriteUInt64((uint64_t)value); };
+
+private:
+	std::vector<uint8_t> m_data;
+	size_t               m_readOffset;
+
+	void WriteBytes(const void* src, size_t len);
+	bool ReadBytes(void* dest, size_t len);
+};
+
+#endif
@@ -10,6 +10,7 @@
 
 #include "Coordinate.h"
 #include "SensorType.h"
+#include "ZoneType.h"
 
 /**
 * These callbacks are used to return lists of data from the backend..
@@ -21,7 +22,13 @@ extern "C" {
 
 	typedef void (*SensorDataCallback)(const char* activityId, void* context);
 	typedef void (*CoordinateCallback)(Coordinate coordinate, void* context);
-	typedef void (*HeatMapPointCallback)(Coordinate coordinate, uint32_t count, void* context);
+	typedef void (*HeatMapTileCallback)(uint32_t zoom, uint32_t tileX, uint32_t tileY, const uint32_t* counts, void* context);
+	typedef void (*GeoIndexMatchCallback)(const char* activityId, uint64_t startTimeMs, uint64_t endTimeMs, void* context);
+	typedef void (*BestEffortCallback)(const char* activityId, double distanceMeters, uint64_t elapsedMs, uint64_t startTimeMs, void* context);
+	typedef void (*TrainingLoadCallback)(int64_t day, double stress, double ctl, double atl, double tsb, void* context);
+	typedef void (*ZoneTimeCallback)(ZoneType zoneType, uint8_t zone, double seconds, void* context);
+	typedef void (*PowerCurveCallback)(uint32_t durationSecs, double watts, void* context);
+	typedef void (*RouteMatchCallback)(const char* routeId, size_t entryIndex, size_t exitIndex, uint64_t entryTimeMs, uint64_t exitTimeMs, void* context);
 	typedef void (*TagCallback)(const char* name, void* context);
 	typedef void (*ActivityTypeCallback)(const char* name, void* context);
 	typedef void (*AttributeNameCallback)(const char* name, void* context);
@@ -29,6 +36,8 @@ extern "C" {
 	typedef bool (*NextCoordinateCallback)(const char* activityId, Coordinate* coordinate, void* context);
 	typedef void (*WeightCallback)(time_t timestamp, double value, void* context);
 	typedef void (*SyncCallback)(const char* destination, void* context);
+	typedef void (*ImportProgressCallback)(const char* fileName, const char* activityId, bool succeeded, size_t numCompleted, size_t numFiles, void* context);
+	typedef void (*SummaryRecomputeProgressCallback)(const char* activityId, bool succeeded, size_t numCompleted, size_t numActivities, void* context);
 
 #ifdef __cplusplus
 }
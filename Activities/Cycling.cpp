@@ -13,7 +13,9 @@
 #include "UnitMgr.h"
 #include "UnitConversionFactors.h"
 
-Cycling::Cycling() : MovingActivity()
+Cycling::Cycling() :
+	MovingActivity(),
+	m_powerZoneHistogram(NUM_POWER_HISTOGRAM_ZONES)
 {
 	m_speedDataSource                   = SPEED_FROM_LOCATION_DATA;
 
@@ -57,6 +59,16 @@ Cycling::~Cycling()
 {
 }
 
+void Cycling::SetAthleteProfile(const User& athlete)
+{
+	MovingActivity::SetAthleteProfile(athlete);
+
+	if (athlete.HasCriticalPower())
+	{
+		m_wPrimeBalance.SetModel(athlete.GetCriticalPower(), athlete.GetWPrime());
+	}
+}
+
 void Cycling::ListUsableSensors(std::vector<SensorType>& sensorTypes) const
 {
 	sensorTypes.push_back(SENSOR_TYPE_CADENCE);
@@ -144,6 +156,14 @@ bool Cycling::ProcessPowerMeterReading(const SensorReading& reading)
 			m_totalPowerReadings += m_currentPower;
 			m_numPowerReadings++;
 
+			// Zones are by the power of each reading, not the 3 second average used for the current zone, so that
+			// short efforts are counted in full.
+			m_powerZoneHistogram.AddReading(reading.time, m_athlete.GetZoneForPower(m_currentPower));
+
+			// Both by time rather than by number of readings, so that they don't depend on how often the meter reports.
+			m_powerCurve.AddReading(reading.time, m_currentPower);
+			m_wPrimeBalance.AddReading(reading.time, m_currentPower);
+
 			// Update the maximum power value.
 			if (m_currentPower > m_maximumPower)
 			{
@@ -213,6 +233,89 @@ bool Cycling::ProcessPowerMeterReading(const SensorReading& reading)
 	return MovingActivity::ProcessPowerMeterReading(reading);
 }
 
+bool Cycling::SaveState(ActivitySnapshot& snapshot) const
+{
+	if (!MovingActivity::SaveState(snapshot))
+		return false;
+
+	snapshot.WriteUInt32((uint32_t)m_speedDataSource);
+	snapshot.WriteDouble(m_distanceAtFirstWheelSpeedReadingM);
+	snapshot.WriteDouble(m_currentCadence);
+	snapshot.WriteDouble(m_maximumCadence);
+	snapshot.WriteDouble(m_totalCadenceReadings);
+	snapshot.WriteDouble(m_currentPower);
+	snapshot.WriteDouble(m_totalPowerReadings);
+	snapshot.WriteDouble(m_maximumPower);
+	snapshot.WriteDouble(m_3SecPower);
+	snapshot.WriteDouble(m_20MinPower);
+	snapshot.WriteDouble(m_1HourPower);
+	snapshot.WriteDouble(m_highest3SecPower);
+	snapshot.WriteDouble(m_highest20MinPower);
+	snapshot.WriteDouble(m_highest1HourPower);
+	snapshot.WriteDoubleList(m_recentPowerReadings3Sec);
+	snapshot.WriteDoubleList(m_recentPowerReadings20Min);
+	snapshot.WriteDoubleList(m_recentPowerReadings1Hour);
+	snapshot.WriteDoubleList(m_normalizedPowerBuffer);
+	snapshot.WriteDoubleList(m_current30SecBuffer);
+	snapshot.WriteUInt64(m_current30SecBufferStartTime);
+	m_powerZoneHistogram.SaveState(snapshot);
+	m_powerCurve.SaveState(snapshot);
+	m_wPrimeBalance.SaveState(snapshot);
+	snapshot.WriteUInt16(m_numCadenceReadings);
+	snapshot.WriteUInt16(m_numPowerReadings);
+	snapshot.WriteUInt16(m_firstWheelSpeedReading);
+	snapshot.WriteUInt64(m_firstWheelSpeedTime);
+	snapshot.WriteUInt16(m_currentWheelSpeedReading);
+	snapshot.WriteUInt64(m_currentWheelSpeedTime);
+	snapshot.WriteUInt16(m_lastWheelSpeedReading);
+	snapshot.WriteUInt64(m_lastWheelSpeedTime);
+	snapshot.WriteUInt64(m_lastCadenceUpdateTimeMs);
+	snapshot.WriteUInt64(m_lastPowerUpdateTimeMs);
+	return true;
+}
+
+bool Cycling::LoadState(ActivitySnapshot& snapshot)
+{
+	uint32_t speedDataSource = 0;
+
+	if (!(MovingActivity::LoadState(snapshot) && snapshot.ReadUInt32(speedDataSource)))
+		return false;
+	m_speedDataSource = (SpeedDataSource)speedDataSource;
+
+	return snapshot.ReadDouble(m_distanceAtFirstWheelSpeedReadingM) &&
+		snapshot.ReadDouble(m_currentCadence) &&
+		snapshot.ReadDouble(m_maximumCadence) &&
+		snapshot.ReadDouble(m_totalCadenceReadings) &&
+		snapshot.ReadDouble(m_currentPower) &&
+		snapshot.ReadDouble(m_totalPowerReadings) &&
+		snapshot.ReadDouble(m_maximumPower) &&
+		snapshot.ReadDouble(m_3SecPower) &&
+		snapshot.ReadDouble(m_20MinPower) &&
+		snapshot.ReadDouble(m_1HourPower) &&
+		snapshot.ReadDouble(m_highest3SecPower) &&
+		snapshot.ReadDouble(m_highest20MinPower) &&
+		snapshot.ReadDouble(m_highest1HourPower) &&
+		snapshot.ReadDoubleList(m_recentPowerReadings3Sec) &&
+		snapshot.ReadDoubleList(m_recentPowerReadings20Min) &&
+		snapshot.ReadDoubleList(m_recentPowerReadings1Hour) &&
+		snapshot.ReadDoubleList(m_normalizedPowerBuffer) &&
+		snapshot.ReadDoubleList(m_current30SecBuffer) &&
+		snapshot.ReadUInt64(m_current30SecBufferStartTime) &&
+		m_powerZoneHistogram.LoadState(snapshot) &&
+		m_powerCurve.LoadState(snapshot) &&
+		m_wPrimeBalance.LoadState(snapshot) &&
+		snapshot.ReadUInt16(m_numCadenceReadings) &&
+		snapshot.ReadUInt16(m_numPowerReadings) &&
+		snapshot.ReadUInt16(m_firstWheelSpeedReading) &&
+		snapshot.ReadUInt64(m_firstWheelSpeedTime) &&
+		snapshot.ReadUInt16(m_currentWheelSpeedReading) &&
+		snapshot.ReadUInt64(m_currentWheelSpeedTime) &&
+		snapshot.ReadUInt16(m_lastWheelSpeedReading) &&
+		snapshot.ReadUInt64(m_lastWheelSpeedTime) &&
+		snapshot.ReadUInt64(m_lastCadenceUpdateTimeMs) &&
+		snapshot.ReadUInt64(m_lastPowerUpdateTimeMs);
+}
+
 ActivityAttributeType Cycling::QueryActivityAttribute(const std::string& attributeName) const
 {
 	ActivityAttributeType result;
@@ -394,6 +497,42 @@ ActivityAttributeType Cycling::QueryActivityAttribute(const std::string& attribu
 		result.endTime = segment.endTime;
 		result.valid = m_firstWheelSpeedReading > 0;
 	}
+	else if (attributeName.find(ACTIVITY_ATTRIBUTE_TIME_IN_POWER_ZONE) == 0)
+	{
+		uint8_t zone = ZoneHistogram::ZoneFromAttributeName(attributeName, ACTIVITY_ATTRIBUTE_TIME_IN_POWER_ZONE);
+
+		result.value.timeVal = (time_t)llround(m_powerZoneHistogram.SecondsInZone(zone));
+		result.valueType = TYPE_TIME;
+		result.measureType = MEASURE_TIME;
+		result.valid = (zone >= 1) && (zone <= m_powerZoneHistogram.NumZones()) && (m_numPowerReadings > 0);
+	}
+	else if (attributeName.find(ACTIVITY_ATTRIBUTE_MEAN_MAX_POWER) == 0)
+	{
+		uint32_t durationSecs = PowerCurve::DurationFromAttributeName(attributeName);
+
+		result.value.doubleVal = m_powerCurve.BestPower(durationSecs);
+		result.valueType = TYPE_DOUBLE;
+		result.measureType = MEASURE_POWER;
+		result.valid = result.value.doubleVal > (double)0.0;
+	}
+	else if (attributeName.compare(ACTIVITY_ATTRIBUTE_W_PRIME_BALANCE) == 0)
+	{
+		uint64_t timeSinceLastUpdate = 0;
+		if (!HasStopped())
+			timeSinceLastUpdate = CurrentTimeInMs() - m_lastPowerUpdateTimeMs;
+
+		result.value.doubleVal = m_wPrimeBalance.Balance() / (double)1000.0;
+		result.valueType = TYPE_DOUBLE;
+		result.measureType = MEASURE_NOT_SET;
+		result.valid = m_wPrimeBalance.HasModel() && m_wPrimeBalance.HasReadings() && (timeSinceLastUpdate < 3000);
+	}
+	else if (attributeName.compare(ACTIVITY_ATTRIBUTE_LOWEST_W_PRIME_BALANCE) == 0)
+	{
+		result.value.doubleVal = m_wPrimeBalance.LowestBalance() / (double)1000.0;
+		result.valueType = TYPE_DOUBLE;
+		result.measureType = MEASURE_NOT_SET;
+		result.valid = m_wPrimeBalance.HasModel() && m_wPrimeBalance.HasReadings();
+	}
 	else
 	{
 		result = MovingActivity::QueryActivityAttribute(attributeName);
@@ -487,6 +626,7 @@ void Cycling::BuildAttributeList(std::vector<std::string>& attributes) const
 	attributes.push_back(ACTIVITY_ATTRIBUTE_HIGHEST_1_HOUR_POWER);
 	attributes.push_back(ACTIVITY_ATTRIBUTE_POWER_ZONE);
 	attributes.push_back(ACTIVITY_ATTRIBUTE_POWER_TO_WEIGHT);
+	attributes.push_back(ACTIVITY_ATTRIBUTE_W_PRIME_BALANCE);
 	attributes.push_back(ACTIVITY_ATTRIBUTE_FASTEST_CENTURY);
 	attributes.push_back(ACTIVITY_ATTRIBUTE_FASTEST_METRIC_CENTURY);
 	attributes.push_back(ACTIVITY_ATTRIBUTE_NUM_WHEEL_REVOLUTIONS);
@@ -505,5 +645,14 @@ void Cycling::BuildSummaryAttributeList(std::vector<std::string>& attributes) co
 	attributes.push_back(ACTIVITY_ATTRIBUTE_FASTEST_CENTURY);
 	attributes.push_back(ACTIVITY_ATTRIBUTE_FASTEST_METRIC_CENTURY);
 	attributes.push_back(ACTIVITY_ATTRIBUTE_NUM_WHEEL_REVOLUTIONS);
+	for (uint8_t zone = 1; zone <= m_powerZoneHistogram.NumZones(); ++zone)
+	{
+		attributes.push_back(ZoneHistogram::AttributeName(ACTIVITY_ATTRIBUTE_TIME_IN_POWER_ZONE, zone));
+	}
+	attributes.push_back(ACTIVITY_ATTRIBUTE_LOWEST_W_PRIME_BALANCE);
+	for (auto iter = PowerCurve::Durations().begin(); iter != PowerCurve::Durations().end(); ++iter)
+	{
+		attributes.push_back(PowerCurve::AttributeName((*iter)));
+	}
 	MovingActivity::BuildSummaryAttributeList(attributes);
 }
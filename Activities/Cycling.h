@@ -10,7 +10,9 @@
 
 #include "Bike.h"
 #include "MovingActivity.h"
+#include "PowerCurve.h"
 #include "Statistics.h"
+#include "WPrimeBalance.h"
 
 typedef enum SpeedDataSource
 {
@@ -29,6 +31,11 @@ public:
 
 	virtual void ListUsableSensors(std::vector<SensorType>& sensorTypes) const;
 
+	virtual void SetAthleteProfile(const User& athlete);
+
+	virtual bool SaveState(ActivitySnapshot& snapshot) const;
+	virtual bool LoadState(ActivitySnapshot& snapshot);
+
 	virtual ActivityAttributeType QueryActivityAttribute(const std::string& attributeName) const;
 
 	virtual void SetBikeProfile(const Bike& bike) { m_bike = bike; };
@@ -54,6 +61,8 @@ public:
 	virtual double HighestTwentyMinPower(void) const { return m_highest20MinPower; };
 	virtual double HighestOneHourPower(void) const { return m_highest1HourPower; };
 	virtual uint8_t CurrentPowerZone(void) const;
+	virtual const ZoneHistogram& PowerZoneHistogram(void) const { return m_powerZoneHistogram; };
+	virtual const PowerCurve& MeanMaxPowerCurve(void) const { return m_powerCurve; };
 
 	virtual uint16_t NumWheelRevolutions(void) const { return m_currentWheelSpeedReading - m_firstWheelSpeedReading; };
 
@@ -91,6 +100,9 @@ protected:
 	std::vector<double> m_normalizedPowerBuffer; // Contains 30 second power averages
 	std::vector<double> m_current30SecBuffer; // Contains data from the most recent 30 second power block, needed for normalized power calculation
 	uint64_t        m_current30SecBufferStartTime; // Used with the normalized power calculation
+	ZoneHistogram   m_powerZoneHistogram; // Time spent in each power zone, by the power of each reading
+	PowerCurve      m_powerCurve; // Best average power over each of a set of durations
+	WPrimeBalance   m_wPrimeBalance; // W' left, if the athlete has a critical power model
 
 	uint16_t        m_numCadenceReadings; // Used with the average cadence calculation
 	uint16_t        m_numPowerReadings; // Used with the average power calculation
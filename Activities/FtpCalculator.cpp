@@ -7,6 +7,20 @@
 
 #include "FtpCalculator.h"
 #include "ActivityAttribute.h"
+#include "Database.h"
+
+#include <algorithm>
+
+// Activity types whose power data counts towards the estimate.
+static const std::vector<std::string> g_ftpActivityTypes = { ACTIVITY_TYPE_CYCLING, ACTIVITY_TYPE_STATIONARY_CYCLING, ACTIVITY_TYPE_VIRTUAL_CYCLING, ACTIVITY_TYPE_DUATHLON, ACTIVITY_TYPE_TRIATHLON };
+
+// Only the last six months are considered.
+#define FTP_HISTORY_SECS ((365.25 / 2.0) * 24.0 * 60.0 * 60.0)
+
+const std::vector<std::string>& FtpCalculator::ActivityTypes(void)
+{
+	return g_ftpActivityTypes;
+}
 
 double FtpCalculator::Estimate(double best20MinPower, double best1HourPower)
 {
@@ -27,7 +41,7 @@ double FtpCalculator::Estimate(double best20MinPower, double best1HourPower)
 double FtpCalculator::Estimate(const ActivitySummaryList& historicalActivities)
 {
 	double bestEstimate = (double)0.0;
-	time_t cutoffTime = time(NULL) - ((365.25 / 2.0) * 24.0 * 60.0 * 60.0); // last six months
+	time_t cutoffTime = time(NULL) - FTP_HISTORY_SECS; // last six months
 
 	// Look through all activity summaries.
 	for (auto iter = historicalActivities.begin(); iter != historicalActivities.end(); ++iter)
@@ -36,11 +50,7 @@ double FtpCalculator::Estimate(const ActivitySummaryList& historicalActivities)
 
 		if (summary.startTime > cutoffTime)
 		{
-			if ((summary.type.compare(ACTIVITY_TYPE_CYCLING) == 0) ||
-				(summary.type.compare(ACTIVITY_TYPE_STATIONARY_CYCLING) == 0) ||
-				(summary.type.compare(ACTIVITY_TYPE_VIRTUAL_CYCLING) == 0) ||
-				(summary.type.compare(ACTIVITY_TYPE_DUATHLON) == 0) ||
-				(summary.type.compare(ACTIVITY_TYPE_TRIATHLON) == 0))
+			if (std::find(g_ftpActivityTypes.begin(), g_ftpActivityTypes.end(), summary.type) != g_ftpActivityTypes.end())
 			{
 				double best20MinPower = (double)0.0;
 				double best1HourPower = (double)0.0;
@@ -69,3 +79,23 @@ double FtpCalculator::Estimate(const ActivitySummaryList& historicalActivities)
 	}
 	return bestEstimate;
 }
+
+double FtpCalculator::Estimate(Database& db)
+{
+	time_t now = time(NULL);
+	time_t cutoffTime = now - FTP_HISTORY_SECS; // last six months
+	std::string activityId;
+	double best20MinPower = (double)0.0;
+	double best1HourPower = (double)0.0;
+
+	// The best estimate from any one activity is also the estimate from the best of each effort, so just look those up.
+	if (!db.RetrieveBestSummaryValue(g_ftpActivityTypes, ACTIVITY_ATTRIBUTE_HIGHEST_20_MIN_POWER, cutoffTime + 1, now + 1, false, activityId, best20MinPower))
+	{
+		best20MinPower = (double)0.0;
+	}
+	if (!db.RetrieveBestSummaryValue(g_ftpActivityTypes, ACTIVITY_ATTRIBUTE_HIGHEST_1_HOUR_POWER, cutoffTime + 1, now + 1, false, activityId, best1HourPower))
+	{
+		best1HourPower = (double)0.0;
+	}
+	return FtpCalculator::Estimate(best20MinPower, best1HourPower);
+}
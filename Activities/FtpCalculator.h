@@ -10,6 +10,8 @@
 
 #include "ActivitySummary.h"
 
+class Database;
+
 class FtpCalculator
 {
 public:
@@ -18,6 +20,13 @@ public:
 
 	static double Estimate(double best20MinPower, double best1HourPower);
 	static double Estimate(const ActivitySummaryList& historicalActivities);
+
+	/// @brief Same as above, but reads the best efforts of the last six months straight from the database instead of
+	/// looking through every activity. The caller must hold the database lock.
+	static double Estimate(Database& db);
+
+	/// @brief The activity types whose power data counts towards the estimate.
+	static const std::vector<std::string>& ActivityTypes(void);
 };
 
 #endif
@@ -3,6 +3,15 @@
 
 #include "HeartRateCalculator.h"
 #include "ActivityAttribute.h"
+#include "Database.h"
+
+#include <algorithm>
+
+// Activity types whose heart rate data counts towards the estimate.
+static const std::vector<std::string> g_maxHrActivityTypes = { ACTIVITY_TYPE_CYCLING, ACTIVITY_TYPE_STATIONARY_CYCLING, ACTIVITY_TYPE_VIRTUAL_CYCLING, ACTIVITY_TYPE_DUATHLON, ACTIVITY_TYPE_TRIATHLON, ACTIVITY_TYPE_RUNNING, ACTIVITY_TYPE_TREADMILL };
+
+// Only the last six months are considered.
+#define MAX_HR_HISTORY_SECS ((365.25 / 2.0) * 24.0 * 60.0 * 60.0)
 
 double HeartRateCalculator::EstimateMaxHrFromAge(double ageInYears)
 {
@@ -13,7 +22,7 @@ double HeartRateCalculator::EstimateMaxHrFromAge(double ageInYears)
 double HeartRateCalculator::EstimateMaxHrFromData(const ActivitySummaryList& historicalActivities)
 {
 	double bestEstimate = (double)0.0;
-	time_t cutoffTime = time(NULL) - ((365.25 / 2.0) * 24.0 * 60.0 * 60.0); // last six months
+	time_t cutoffTime = time(NULL) - MAX_HR_HISTORY_SECS; // last six months
 
 	// Look through all activity summaries.
 	for (auto iter = historicalActivities.begin(); iter != historicalActivities.end(); ++iter)
@@ -22,13 +31,7 @@ double HeartRateCalculator::EstimateMaxHrFromData(const ActivitySummaryList& his
 
 		if (summary.startTime > cutoffTime)
 		{
-			if ((summary.type.compare(ACTIVITY_TYPE_CYCLING) == 0) ||
-				(summary.type.compare(ACTIVITY_TYPE_STATIONARY_CYCLING) == 0) ||
-				(summary.type.compare(ACTIVITY_TYPE_VIRTUAL_CYCLING) == 0) ||
-				(summary.type.compare(ACTIVITY_TYPE_DUATHLON) == 0) ||
-				(summary.type.compare(ACTIVITY_TYPE_TRIATHLON) == 0) ||
-				(summary.type.compare(ACTIVITY_TYPE_RUNNING) == 0) ||
-				(summary.type.compare(ACTIVITY_TYPE_TREADMILL) == 0))
+			if (std::find(g_maxHrActivityTypes.begin(), g_maxHrActivityTypes.end(), summary.type) != g_maxHrActivityTypes.end())
 			{
 				double maxHr = (double)0.0;
 
@@ -48,3 +51,17 @@ double HeartRateCalculator::EstimateMaxHrFromData(const ActivitySummaryList& his
 	}
 	return bestEstimate;
 }
+
+double HeartRateCalculator::EstimateMaxHrFromData(Database& db)
+{
+	time_t now = time(NULL);
+	time_t cutoffTime = now - MAX_HR_HISTORY_SECS; // last six months
+	std::string activityId;
+	double maxHr = (double)0.0;
+
+	if (db.RetrieveBestSummaryValue(g_maxHrActivityTypes, ACTIVITY_ATTRIBUTE_MAX_HEART_RATE, cutoffTime + 1, now + 1, false, activityId, maxHr) && maxHr > (double)0.0)
+	{
+		return maxHr;
+	}
+	return (double)0.0;
+}
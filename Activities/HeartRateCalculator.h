@@ -6,6 +6,8 @@
 
 #include "ActivitySummary.h"
 
+class Database;
+
 class HeartRateCalculator
 {
 public:
@@ -14,6 +16,10 @@ public:
 
 	static double EstimateMaxHrFromAge(double ageInYears);
 	static double EstimateMaxHrFromData(const ActivitySummaryList& historicalActivities);
+
+	/// @brief Same as above, but reads the highest heart rate of the last six months straight from the database instead
+	/// of looking through every activity. The caller must hold the database lock.
+	static double EstimateMaxHrFromData(Database& db);
 };
 
 #endif
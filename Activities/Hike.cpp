@@ -22,6 +22,21 @@ bool Hike::ProcessAccelerometerReading(const SensorReading& reading)
 	return false;
 }
 
+bool Hike::SaveState(ActivitySnapshot& snapshot) const
+{
+	if (!Walk::SaveState(snapshot))
+		return false;
+
+	snapshot.WriteUInt16(m_stepsTaken);
+	return true;
+}
+
+bool Hike::LoadState(ActivitySnapshot& snapshot)
+{
+	return Walk::LoadState(snapshot) &&
+		snapshot.ReadUInt16(m_stepsTaken);
+}
+
 double Hike::CaloriesBurned(void) const
 {
 	double avgHeartRate = AverageHeartRate();
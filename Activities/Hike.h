@@ -23,6 +23,9 @@ public:
 
 	virtual double CaloriesBurned(void) const;
 	
+	virtual bool SaveState(ActivitySnapshot& snapshot) const;
+	virtual bool LoadState(ActivitySnapshot& snapshot);
+
 	virtual uint16_t StepsTaken(void) const { return m_stepsTaken; };
 
 	virtual void BuildAttributeList(std::vector<std::string>& attributes);
@@ -3,6 +3,11 @@
 
 #include "IntensityCalculator.h"
 
+#include <math.h>
+
+// Fraction of heart rate reserve that can be held for about an hour, used to put TRIMP on the same scale as TSS.
+#define THRESHOLD_HEART_RATE_RESERVE_FRACTION 0.85
+
 IntensityCalculator::IntensityCalculator()
 {
 }
@@ -22,3 +27,17 @@ double IntensityCalculator::CalculateIntensityScoreFromPower(double workoutDurat
 	double intFac = np / ftp;
 	return (workoutDurationSecs * np * intFac) / (ftp * (double)36.0);
 }
+
+double IntensityCalculator::CalculateTrimp(double durationMins, double heartRateReserveFraction, bool female)
+{
+	// Banister's training impulse, which weights time by an exponential of the fraction of heart rate reserve.
+	double weight = female ? ((double)0.86 * exp((double)1.67 * heartRateReserveFraction)) : ((double)0.64 * exp((double)1.92 * heartRateReserveFraction));
+	return durationMins * heartRateReserveFraction * weight;
+}
+
+double IntensityCalculator::CalculateIntensityScoreFromTrimp(double trimp, bool female)
+{
+	// Scale so that an hour at threshold heart rate scores 100, the same as an hour at FTP does with power.
+	double thresholdTrimp = CalculateTrimp((double)60.0, THRESHOLD_HEART_RATE_RESERVE_FRACTION, female);
+	return (trimp / thresholdTrimp) * (double)100.0;
+}
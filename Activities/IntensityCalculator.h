@@ -12,6 +12,8 @@ public:
 
 	double EstimateIntensityScore(double workoutDurationSecs, double avgWorkoutPaceMetersPerSec, double thresholdPaceMetersPerHour);
 	double CalculateIntensityScoreFromPower(double workoutDurationSecs, double np, double ftp);
+	double CalculateTrimp(double durationMins, double heartRateReserveFraction, bool female);
+	double CalculateIntensityScoreFromTrimp(double trimp, bool female);
 };
 
 #endif
@@ -30,6 +30,8 @@ public:
 
 	virtual void ListUsableSensors(std::vector<SensorType>& sensorTypes) const;
 
+	virtual bool SaveState(ActivitySnapshot&) const { return false; }; // The computed rep list isn't serializable, always rebuild it from the accelerometer data
+
 	virtual ActivityAttributeType QueryActivityAttribute(const std::string& attributeName) const;
 	virtual void SetActivityAttribute(const std::string& attributeName, ActivityAttributeType attributeValue);
 
@@ -92,6 +92,152 @@ void MovingActivity::ListUsableSensors(std::vector<SensorType>& sensorTypes) con
 	sensorTypes.push_back(SENSOR_TYPE_RADAR);
 }
 
+bool MovingActivity::SaveState(ActivitySnapshot& snapshot) const
+{
+	if (!Activity::SaveState(snapshot))
+		return false;
+
+	snapshot.WriteCoordinate(m_currentLoc);
+	snapshot.WriteCoordinate(m_previousLoc);
+	snapshot.WriteCoordinateList(m_smoothedLocBuffer);
+	snapshot.WriteBool(m_previousLocSet);
+	snapshot.WriteDouble(m_prevDistanceTraveledRawM);
+	snapshot.WriteDouble(m_distanceTraveledRawM);
+	snapshot.WriteDouble(m_distanceTraveledSmoothedM);
+	snapshot.WriteDouble(m_totalAscentM);
+	snapshot.WriteDouble(m_currentGradient);
+	snapshot.WriteDouble(m_avgGradient);
+	snapshot.WriteDoubleList(m_altitudeBuffer);
+	snapshot.WriteUInt64(m_stoppedTimeMS);
+
+	snapshot.WriteSegment(m_minAltitudeM);
+	snapshot.WriteSegment(m_maxAltitudeM);
+	snapshot.WriteSegment(m_biggestClimbM);
+	snapshot.WriteSegment(m_fastestVerticalSpeed);
+	snapshot.WriteSegment(m_fastestPace);
+	snapshot.WriteSegment(m_fastestSpeed);
+	snapshot.WriteSegment(m_fastestCenturySec);
+	snapshot.WriteSegment(m_fastestMetricCenturySec);
+	snapshot.WriteSegment(m_fastestMarathonSec);
+	snapshot.WriteSegment(m_fastestHalfMarathonSec);
+	snapshot.WriteSegment(m_fastest10KSec);
+	snapshot.WriteSegment(m_fastest5KSec);
+	snapshot.WriteSegment(m_fastestMileSec);
+	snapshot.WriteSegment(m_fastestKmSec);
+	snapshot.WriteSegment(m_fastest400MSec);
+	snapshot.WriteSegment(m_lastCenturySec);
+	snapshot.WriteSegment(m_lastMetricCenturySec);
+	snapshot.WriteSegment(m_lastMarathonSec);
+	snapshot.WriteSegment(m_lastHalfMarathonSec);
+	snapshot.WriteSegment(m_last10KSec);
+	snapshot.WriteSegment(m_last5KSec);
+	snapshot.WriteSegment(m_lastMileSec);
+	snapshot.WriteSegment(m_lastKmSec);
+	snapshot.WriteSegment(m_last400MSec);
+
+	snapshot.WriteCoordinateList(m_coordinates);
+
+	snapshot.WriteUInt32((uint32_t)m_distances.size());
+	for (auto iter = m_distances.begin(); iter != m_distances.end(); ++iter)
+	{
+		snapshot.WriteDouble((*iter).distanceM);
+		snapshot.WriteDouble((*iter).verticalDistanceM);
+		snapshot.WriteUInt64((*iter).time);
+	}
+
+	snapshot.WriteUInt32((uint32_t)m_laps.size());
+	for (auto iter = m_laps.begin(); iter != m_laps.end(); ++iter)
+	{
+		snapshot.WriteUInt64((*iter).startTimeMs);
+		snapshot.WriteDouble((*iter).startingDistanceMeters);
+		snapshot.WriteDouble((*iter).startingCalorieCount);
+	}
+
+	snapshot.WriteAttributeMap(m_splitTimesKMs);
+	snapshot.WriteAttributeMap(m_splitTimesMiles);
+	return true;
+}
+
+bool MovingActivity::LoadState(ActivitySnapshot& snapshot)
+{
+	if (!Activity::LoadState(snapshot))
+		return false;
+
+	bool result = snapshot.ReadCoordinate(m_currentLoc) &&
+		snapshot.ReadCoordinate(m_previousLoc) &&
+		snapshot.ReadCoordinateList(m_smoothedLocBuffer) &&
+		snapshot.ReadBool(m_previousLocSet) &&
+		snapshot.ReadDouble(m_prevDistanceTraveledRawM) &&
+		snapshot.ReadDouble(m_distanceTraveledRawM) &&
+		snapshot.ReadDouble(m_distanceTraveledSmoothedM) &&
+		snapshot.ReadDouble(m_totalAscentM) &&
+		snapshot.ReadDouble(m_currentGradient) &&
+		snapshot.ReadDouble(m_avgGradient) &&
+		snapshot.ReadDoubleList(m_altitudeBuffer) &&
+		snapshot.ReadUInt64(m_stoppedTimeMS);
+
+	if (!result)
+		return false;
+
+	result = snapshot.ReadSegment(m_minAltitudeM) &&
+		snapshot.ReadSegment(m_maxAltitudeM) &&
+		snapshot.ReadSegment(m_biggestClimbM) &&
+		snapshot.ReadSegment(m_fastestVerticalSpeed) &&
+		snapshot.ReadSegment(m_fastestPace) &&
+		snapshot.ReadSegment(m_fastestSpeed) &&
+		snapshot.ReadSegment(m_fastestCenturySec) &&
+		snapshot.ReadSegment(m_fastestMetricCenturySec) &&
+		snapshot.ReadSegment(m_fastestMarathonSec) &&
+		snapshot.ReadSegment(m_fastestHalfMarathonSec) &&
+		snapshot.ReadSegment(m_fastest10KSec) &&
+		snapshot.ReadSegment(m_fastest5KSec) &&
+		snapshot.ReadSegment(m_fastestMileSec) &&
+		snapshot.ReadSegment(m_fastestKmSec) &&
+		snapshot.ReadSegment(m_fastest400MSec) &&
+		snapshot.ReadSegment(m_lastCenturySec) &&
+		snapshot.ReadSegment(m_lastMetricCenturySec) &&
+		snapshot.ReadSegment(m_lastMarathonSec) &&
+		snapshot.ReadSegment(m_lastHalfMarathonSec) &&
+		snapshot.ReadSegment(m_last10KSec) &&
+		snapshot.ReadSegment(m_last5KSec) &&
+		snapshot.ReadSegment(m_lastMileSec) &&
+		snapshot.ReadSegment(m_lastKmSec) &&
+		snapshot.ReadSegment(m_last400MSec);
+	if (!result)
+		return false;
+
+	if (!snapshot.ReadCoordinateList(m_coordinates))
+		return false;
+
+	uint32_t numDistances = 0;
+	if (!snapshot.ReadUInt32(numDistances))
+		return false;
+	m_distances.clear();
+	for (uint32_t i = 0; i < numDistances; ++i)
+	{
+		TimeDistancePair pair;
+
+		if (!(snapshot.ReadDouble(pair.distanceM) && snapshot.ReadDouble(pair.verticalDistanceM) && snapshot.ReadUInt64(pair.time)))
+			return false;
+		m_distances.push_back(pair);
+	}
+
+	uint32_t numLaps = 0;
+	if (!snapshot.ReadUInt32(numLaps))
+		return false;
+	m_laps.clear();
+	for (uint32_t i = 0; i < numLaps; ++i)
+	{
+		LapSummary lap;
+
+		if (!(snapshot.ReadUInt64(lap.startTimeMs) && snapshot.ReadDouble(lap.startingDistanceMeters) && snapshot.ReadDouble(lap.startingCalorieCount)))
+			return false;
+		m_laps.push_back(lap);
+	}
+
+	return snapshot.ReadAttributeMap(m_splitTimesKMs) && snapshot.ReadAttributeMap(m_splitTimesMiles);
+}
+
 void MovingActivity::RecomputeRecordTimes(void)
 {
 	double   distance  = (double)0.0;
@@ -49,6 +49,9 @@ public:
 	
 	virtual void ListUsableSensors(std::vector<SensorType>& sensorTypes) const;
 	
+	virtual bool SaveState(ActivitySnapshot& snapshot) const;
+	virtual bool LoadState(ActivitySnapshot& snapshot);
+	
 	virtual bool GetCoordinate(size_t pointIndex, Coordinate* const pCoordinate) const;
 	
 	virtual ActivityAttributeType QueryActivityAttribute(const std::string& attributeName) const;
@@ -0,0 +1,141 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "PowerCurve.h"
+#include "ActivityAttribute.h"
+
+#include <sstream>
+#include <stdlib.h>
+#include <string.h>
+
+// Enough points at the short end for the three parameter model, and from two to twenty minutes for the two parameter one.
+static const std::vector<uint32_t> g_powerCurveDurations = { 1, 5, 10, 15, 30, 60, 120, 180, 240, 300, 420, 600, 900, 1200, 1800, 2700, 3600, 5400, 7200 };
+
+PowerCurve::PowerCurve() :
+	m_bestPower(g_powerCurveDurations.size(), (double)0.0),
+	m_totals(g_powerCurveDurations.back() + 1, (double)0.0)
+{
+	m_numSteps = 0;
+	m_startTimeMs = 0;
+	m_lastTimeMs = 0;
+}
+
+PowerCurve::~PowerCurve()
+{
+}
+
+const std::vector<uint32_t>& PowerCurve::Durations(void)
+{
+	return g_powerCurveDurations;
+}
+
+void PowerCurve::AddStep(double watts)
+{
+	size_t ringSize = m_totals.size();
+
+	++m_numSteps;
+
+	double total = m_totals[(m_numSteps - 1) % ringSize] + watts;
+	m_totals[m_numSteps % ringSize] = total;
+
+	for (size_t i = 0; i < g_powerCurveDurations.size(); ++i)
+	{
+		uint32_t durationSecs = g_powerCurveDurations[i];
+
+		// The durations are sorted, so none of the rest fit either.
+		if (durationSecs > m_numSteps)
+		{
+			break;
+		}
+
+		double average = (total - m_totals[(m_numSteps - durationSecs) % ringSize]) / (double)durationSecs;
+		if (average > m_bestPower[i])
+		{
+			m_bestPower[i] = average;
+		}
+	}
+}
+
+void PowerCurve::AddReading(uint64_t timeMs, double watts)
+{
+	// Out of order readings are ignored.
+	if (m_lastTimeMs > 0 && timeMs <= m_lastTimeMs)
+	{
+		return;
+	}
+
+	// The first reading, and the first after a pause, start a new stretch.
+	if (m_lastTimeMs == 0 || timeMs - m_lastTimeMs > POWER_CURVE_MAX_GAP_MS)
+	{
+		m_numSteps = 0;
+		m_startTimeMs = timeMs;
+		m_totals[0] = (double)0.0;
+	}
+	else
+	{
+		uint64_t numSteps = (timeMs - m_startTimeMs) / 1000;
+
+		while (m_numSteps < numSteps)
+		{
+			AddStep(watts);
+		}
+	}
+	m_lastTimeMs = timeMs;
+}
+
+double PowerCurve::BestPower(uint32_t durationSecs) const
+{
+	for (size_t i = 0; i < g_powerCurveDurations.size(); ++i)
+	{
+		if (g_powerCurveDurations[i] == durationSecs)
+		{
+			return m_bestPower[i];
+		}
+	}
+	return (double)0.0;
+}
+
+void PowerCurve::SaveState(ActivitySnapshot& snapshot) const
+{
+	snapshot.WriteDoubleList(m_bestPower);
+}
+
+bool PowerCurve::LoadState(ActivitySnapshot& snapshot)
+{
+	// Only the curve itself is kept, so any readings after this start a new stretch.
+	m_numSteps = 0;
+	m_startTimeMs = 0;
+	m_lastTimeMs = 0;
+
+	return snapshot.ReadDoubleList(m_bestPower) &&
+		(m_bestPower.size() == g_powerCurveDurations.size());
+}
+
+std::string PowerCurve::AttributeName(uint32_t durationSecs)
+{
+	std::stringstream attributeNameStream;
+
+	attributeNameStream << ACTIVITY_ATTRIBUTE_MEAN_MAX_POWER;
+	attributeNameStream << durationSecs;
+	return attributeNameStream.str();
+}
+
+uint32_t PowerCurve::DurationFromAttributeName(const std::string& attributeName)
+{
+	if (attributeName.find(ACTIVITY_ATTRIBUTE_MEAN_MAX_POWER) != 0)
+	{
+		return 0;
+	}
+
+	unsigned long long durationSecs = strtoull(attributeName.c_str() + strlen(ACTIVITY_ATTRIBUTE_MEAN_MAX_POWER), NULL, 10);
+
+	if (durationSecs > UINT32_MAX)
+	{
+		return 0;
+	}
+	return (uint32_t)durationSecs;
+}
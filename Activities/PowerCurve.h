@@ -0,0 +1,63 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __POWERCURVE__
+#define __POWERCURVE__
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "ActivitySnapshot.h"
+
+#define POWER_CURVE_MAX_GAP_MS 10000 // Gaps between readings longer than this are pauses, and no effort spans one
+
+/**
+* The best average power over each of a fixed set of durations, i.e. the mean maximal power curve, kept up to date as
+* the readings arrive.
+*
+* Readings are spread over one second steps, each reading covering the time since the reading before it. A running
+* total of the steps, kept for as far back as the longest duration, means that the average over each duration ending
+* at the latest step is a subtraction, so each step costs one comparison per duration.
+*/
+class PowerCurve
+{
+public:
+	PowerCurve();
+	virtual ~PowerCurve();
+
+	void AddReading(uint64_t timeMs, double watts);
+
+	/// @brief The durations, in seconds, shortest first.
+	static const std::vector<uint32_t>& Durations(void);
+
+	/// @brief Best average power over the duration, or zero if the activity hasn't been that long yet.
+	double BestPower(uint32_t durationSecs) const;
+
+	void SaveState(ActivitySnapshot& snapshot) const;
+	bool LoadState(ActivitySnapshot& snapshot);
+
+	/// @brief Summary attributes are named with ACTIVITY_ATTRIBUTE_MEAN_MAX_POWER followed by the duration, e.g.
+	/// "Mean Maximal Power 300".
+	static std::string AttributeName(uint32_t durationSecs);
+
+	/// @brief Returns the duration from an attribute name made by AttributeName, or zero if it isn't one.
+	static uint32_t DurationFromAttributeName(const std::string& attributeName);
+
+private:
+	std::vector<double> m_bestPower;     // Best average power over each duration
+	std::vector<double> m_totals;        // Running total of the steps, as a ring buffer one longer than the longest duration
+	uint64_t            m_numSteps;      // Steps since the start of the current stretch of readings
+	uint64_t            m_startTimeMs;   // Time of the reading that started the current stretch
+	uint64_t            m_lastTimeMs;    // Time of the most recent reading, zero if there hasn't been one
+
+	void AddStep(double watts);
+};
+
+#endif
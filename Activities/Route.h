@@ -13,6 +13,7 @@ typedef struct Route
 	std::string             name;
 	std::string             description;
 	std::vector<Coordinate> coordinates;
+	double                  toleranceM;  // How far the coordinates may stray from the original route, zero for full resolution
 } Route;
 
 #endif
@@ -0,0 +1,248 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "RoutePolyline.h"
+
+#include <math.h>
+#include <utility>
+
+#define METERS_PER_DEGREE    111319.49 // At the equator, for the local projection used while simplifying
+#define DEGREE_SCALE         1e7       // Encoded latitude and longitude units per degree
+#define ALTITUDE_SCALE       100.0     // Encoded altitude units per meter
+
+static void WriteVarint(std::vector<uint8_t>& data, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		data.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	data.push_back((uint8_t)value);
+}
+
+static bool ReadVarint(const uint8_t* data, size_t dataLen, size_t& offset, uint64_t& value)
+{
+	value = 0;
+
+	for (unsigned int shift = 0; shift < 64; shift += 7)
+	{
+		if (offset >= dataLen)
+		{
+			return false;
+		}
+
+		uint8_t byte = data[offset++];
+
+		value |= (uint64_t)(byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void WriteSignedVarint(std::vector<uint8_t>& data, int64_t value)
+{
+	// Zig-zag, so small negative deltas are as short as small positive ones.
+	WriteVarint(data, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+static bool ReadSignedVarint(const uint8_t* data, size_t dataLen, size_t& offset, int64_t& value)
+{
+	uint64_t temp = 0;
+
+	if (!ReadVarint(data, dataLen, offset, temp))
+	{
+		return false;
+	}
+	value = (int64_t)(temp >> 1) ^ -(int64_t)(temp & 1);
+	return true;
+}
+
+void RoutePolyline::Simplify(const std::vector<Coordinate>& points, double toleranceM, std::vector<Coordinate>& simplified)
+{
+	simplified.clear();
+
+	size_t numPoints = points.size();
+	if (numPoints <= 2 || toleranceM <= (double)0.0)
+	{
+		simplified = points;
+		return;
+	}
+
+	// Project onto a flat plane, in meters, around the first point. Routes are small enough that this is accurate
+	// to well within any tolerance we'd use, and it is much cheaper than great circle math for every comparison.
+	double metersPerDegreeLon = METERS_PER_DEGREE * cos(points[0].latitude * M_PI / 180.0);
+	std::vector<double> x(numPoints);
+	std::vector<double> y(numPoints);
+
+	for (size_t i = 0; i < numPoints; ++i)
+	{
+		x[i] = (points[i].longitude - points[0].longitude) * metersPerDegreeLon;
+		y[i] = (points[i].latitude - points[0].latitude) * METERS_PER_DEGREE;
+	}
+
+	std::vector<bool> keep(numPoints, false);
+	std::vector<std::pair<size_t, size_t>> stack;
+	double toleranceSquared = toleranceM * toleranceM;
+
+	keep[0] = true;
+	keep[numPoints - 1] = true;
+
+	// An explicit stack instead of recursion, since a 50,000 point route that doubles back on itself could
+	// otherwise recurse once per point.
+	stack.push_back(std::make_pair((size_t)0, numPoints - 1));
+	while (!stack.empty())
+	{
+		size_t first = stack.back().first;
+		size_t last = stack.back().second;
+		stack.pop_back();
+
+		if (last <= first + 1)
+		{
+			continue;
+		}
+
+		double dx = x[last] - x[first];
+		double dy = y[last] - y[first];
+		double segmentLenSquared = dx * dx + dy * dy;
+		double maxDistSquared = (double)0.0;
+		size_t farthest = first;
+
+		for (size_t i = first + 1; i < last; ++i)
+		{
+			double px = x[i] - x[first];
+			double py = y[i] - y[first];
+
+			// Distance to the segment rather than the infinite line, so points beyond either end (i.e. an out
+			// and back) are measured from the nearest end.
+			if (segmentLenSquared > (double)0.0)
+			{
+				double t = (px * dx + py * dy) / segmentLenSquared;
+
+				if (t > (double)1.0)
+				{
+					px = x[i] - x[last];
+					py = y[i] - y[last];
+				}
+				else if (t > (double)0.0)
+				{
+					px -= t * dx;
+					py -= t * dy;
+				}
+			}
+
+			double distSquared = px * px + py * py;
+			if (distSquared > maxDistSquared)
+			{
+				maxDistSquared = distSquared;
+				farthest = i;
+			}
+		}
+
+		if (maxDistSquared > toleranceSquared)
+		{
+			keep[farthest] = true;
+			stack.push_back(std::make_pair(first, farthest));
+			stack.push_back(std::make_pair(farthest, last));
+		}
+	}
+
+	for (size_t i = 0; i < numPoints; ++i)
+	{
+		if (keep[i])
+		{
+			simplified.push_back(points[i]);
+		}
+	}
+}
+
+void RoutePolyline::Encode(const std::vector<Coordinate>& points, std::vector<uint8_t>& data)
+{
+	int64_t prevLat = 0;
+	int64_t prevLon = 0;
+	int64_t prevAlt = 0;
+
+	data.clear();
+	data.reserve(points.size() * 6 + 8);
+	data.push_back(ROUTE_POLYLINE_VERSION);
+	WriteVarint(data, points.size());
+
+	for (auto iter = points.begin(); iter != points.end(); ++iter)
+	{
+		int64_t lat = llround((*iter).latitude * DEGREE_SCALE);
+		int64_t lon = llround((*iter).longitude * DEGREE_SCALE);
+		int64_t alt = llround((*iter).altitude * ALTITUDE_SCALE);
+
+		WriteSignedVarint(data, lat - prevLat);
+		WriteSignedVarint(data, lon - prevLon);
+		WriteSignedVarint(data, alt - prevAlt);
+
+		prevLat = lat;
+		prevLon = lon;
+		prevAlt = alt;
+	}
+}
+
+bool RoutePolyline::Decode(const uint8_t* data, size_t dataLen, std::vector<Coordinate>& points)
+{
+	size_t offset = 0;
+	uint64_t numPoints = 0;
+
+	points.clear();
+
+	if (dataLen == 0 || data[offset++] != ROUTE_POLYLINE_VERSION)
+	{
+		return false;
+	}
+	if (!ReadVarint(data, dataLen, offset, numPoints))
+	{
+		return false;
+	}
+
+	// Every point takes at least three bytes, which also keeps a corrupt count from reserving too much.
+	if (numPoints > (dataLen - offset) / 3)
+	{
+		return false;
+	}
+	points.reserve((size_t)numPoints);
+
+	int64_t lat = 0;
+	int64_t lon = 0;
+	int64_t alt = 0;
+
+	for (uint64_t i = 0; i < numPoints; ++i)
+	{
+		int64_t deltaLat = 0;
+		int64_t deltaLon = 0;
+		int64_t deltaAlt = 0;
+
+		if (!(ReadSignedVarint(data, dataLen, offset, deltaLat) &&
+			  ReadSignedVarint(data, dataLen, offset, deltaLon) &&
+			  ReadSignedVarint(data, dataLen, offset, deltaAlt)))
+		{
+			points.clear();
+			return false;
+		}
+
+		lat += deltaLat;
+		lon += deltaLon;
+		alt += deltaAlt;
+
+		Coordinate coordinate;
+
+		coordinate.latitude  = (double)lat / DEGREE_SCALE;
+		coordinate.longitude = (double)lon / DEGREE_SCALE;
+		coordinate.altitude  = (double)alt / ALTITUDE_SCALE;
+		coordinate.horizontalAccuracy = (double)0.0;
+		coordinate.verticalAccuracy   = (double)0.0;
+		coordinate.time = 0;
+		points.push_back(coordinate);
+	}
+	return offset == dataLen;
+}
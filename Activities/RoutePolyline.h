@@ -0,0 +1,45 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __ROUTEPOLYLINE__
+#define __ROUTEPOLYLINE__
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "Coordinate.h"
+
+#define ROUTE_POLYLINE_VERSION       1
+
+// Tolerances, in meters, of the simplified copies that are stored alongside the full resolution route.
+#define ROUTE_POLYLINE_NUM_TOLERANCES 3
+#define ROUTE_POLYLINE_TOLERANCES_M   { 2.0, 10.0, 50.0 }
+
+/**
+* Simplifies routes and packs them into compact buffers for storage.
+*
+* Simplification is Douglas-Peucker: no point that is dropped is further than the tolerance from the simplified line.
+*
+* Encoded routes start with a version byte and the number of points. Latitude and longitude are stored in units of
+* 1e-7 degrees and altitude in centimeters, each as the zig-zag varint encoded difference from the previous point,
+* so a typical point takes three to six bytes instead of the twenty four it takes as doubles.
+*/
+class RoutePolyline
+{
+public:
+	/// @brief Copies the points that have to be kept so that none of the others is more than toleranceM from the result.
+	/// The first and last points are always kept.
+	static void Simplify(const std::vector<Coordinate>& points, double toleranceM, std::vector<Coordinate>& simplified);
+
+	static void Encode(const std::vector<Coordinate>& points, std::vector<uint8_t>& data);
+	static bool Decode(const uint8_t* data, size_t dataLen, std::vector<Coordinate>& points);
+};
+
+#endif
@@ -38,6 +38,23 @@ void Swim::OnFinishedLoadingSensorData(void)
 	Activity::OnFinishedLoadingSensorData();
 }
 
+bool Swim::SaveState(ActivitySnapshot& snapshot) const
+{
+	if (!MovingActivity::SaveState(snapshot))
+		return false;
+
+	snapshot.WriteUInt64(m_lastStrokeCalculationTime);
+	snapshot.WriteUInt16(m_strokesTaken);
+	return true;
+}
+
+bool Swim::LoadState(ActivitySnapshot& snapshot)
+{
+	return MovingActivity::LoadState(snapshot) &&
+		snapshot.ReadUInt64(m_lastStrokeCalculationTime) &&
+		snapshot.ReadUInt16(m_strokesTaken);
+}
+
 bool Swim::ProcessAccelerometerReading(const SensorReading& reading)
 {
 	try
@@ -30,6 +30,9 @@ public:
 
 	virtual void OnFinishedLoadingSensorData(void);
 
+	virtual bool SaveState(ActivitySnapshot& snapshot) const;
+	virtual bool LoadState(ActivitySnapshot& snapshot);
+
 	virtual uint16_t StrokesTaken(void) const { return m_strokesTaken; };
 
 	virtual void BuildAttributeList(std::vector<std::string>& attributes) const;
@@ -19,6 +19,25 @@ Treadmill::~Treadmill()
 {
 }
 
+bool Treadmill::SaveState(ActivitySnapshot& snapshot) const
+{
+	if (!Walk::SaveState(snapshot))
+		return false;
+
+	snapshot.WriteDouble(m_currentStrideReading);
+	snapshot.WriteDouble(m_prevDistanceReading);
+	snapshot.WriteBool(m_firstIteration);
+	return true;
+}
+
+bool Treadmill::LoadState(ActivitySnapshot& snapshot)
+{
+	return Walk::LoadState(snapshot) &&
+		snapshot.ReadDouble(m_currentStrideReading) &&
+		snapshot.ReadDouble(m_prevDistanceReading) &&
+		snapshot.ReadBool(m_firstIteration);
+}
+
 bool Treadmill::ProcessLocationReading(const SensorReading& reading)
 {
 	return false;
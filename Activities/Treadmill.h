@@ -21,6 +21,9 @@ public:
 
 	virtual void ListUsableSensors(std::vector<SensorType>& sensorTypes) const;
 
+	virtual bool SaveState(ActivitySnapshot& snapshot) const;
+	virtual bool LoadState(ActivitySnapshot& snapshot);
+
 protected:
 	virtual bool ProcessLocationReading(const SensorReading& reading);
 	virtual bool ProcessFootPodReading(const SensorReading& reading);
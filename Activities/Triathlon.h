@@ -33,6 +33,8 @@ public:
 
 	virtual void ListUsableSensors(std::vector<SensorType>& sensorTypes) const;
 
+	virtual bool SaveState(ActivitySnapshot&) const { return false; }; // State is spread across the sub-activities, always rebuild from the sensor data
+
 	virtual bool Start(void);
 	virtual bool Stop(void);
 	virtual void Pause(void);
@@ -0,0 +1,83 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "WPrimeBalance.h"
+
+#include <math.h>
+
+WPrimeBalance::WPrimeBalance()
+{
+	m_criticalPower = (double)0.0;
+	m_wPrime = (double)0.0;
+	m_balance = (double)0.0;
+	m_lowestBalance = (double)0.0;
+	m_lastTimeMs = 0;
+}
+
+WPrimeBalance::~WPrimeBalance()
+{
+}
+
+void WPrimeBalance::SetModel(double criticalPower, double wPrime)
+{
+	m_criticalPower = criticalPower;
+	m_wPrime = wPrime;
+	m_balance = wPrime;
+	m_lowestBalance = wPrime;
+	m_lastTimeMs = 0;
+}
+
+void WPrimeBalance::AddReading(uint64_t timeMs, double watts)
+{
+	if (!HasModel())
+	{
+		return;
+	}
+
+	// The first reading, and any that arrive out of order, only mark the time.
+	if (m_lastTimeMs > 0 && timeMs > m_lastTimeMs)
+	{
+		double elapsedSecs = (double)(timeMs - m_lastTimeMs) / (double)1000.0;
+
+		if (watts > m_criticalPower)
+		{
+			m_balance -= (watts - m_criticalPower) * elapsedSecs;
+		}
+		else
+		{
+			// dW/dt = (W' - W) * (CP - P) / W', solved for constant power over the interval.
+			m_balance = m_wPrime - (m_wPrime - m_balance) * exp(-(m_criticalPower - watts) * elapsedSecs / m_wPrime);
+		}
+
+		if (m_balance < m_lowestBalance)
+		{
+			m_lowestBalance = m_balance;
+		}
+	}
+	if (timeMs > m_lastTimeMs)
+	{
+		m_lastTimeMs = timeMs;
+	}
+}
+
+void WPrimeBalance::SaveState(ActivitySnapshot& snapshot) const
+{
+	snapshot.WriteDouble(m_criticalPower);
+	snapshot.WriteDouble(m_wPrime);
+	snapshot.WriteDouble(m_balance);
+	snapshot.WriteDouble(m_lowestBalance);
+	snapshot.WriteUInt64(m_lastTimeMs);
+}
+
+bool WPrimeBalance::LoadState(ActivitySnapshot& snapshot)
+{
+	return snapshot.ReadDouble(m_criticalPower) &&
+		snapshot.ReadDouble(m_wPrime) &&
+		snapshot.ReadDouble(m_balance) &&
+		snapshot.ReadDouble(m_lowestBalance) &&
+		snapshot.ReadUInt64(m_lastTimeMs);
+}
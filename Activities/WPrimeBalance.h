@@ -0,0 +1,53 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __WPRIMEBALANCE__
+#define __WPRIMEBALANCE__
+
+#pragma once
+
+#include <stdint.h>
+
+#include "ActivitySnapshot.h"
+
+/**
+* W' balance: how much of the rider's capacity for work above critical power (W') is left.
+*
+* Uses the differential form of the model (Skiba et al., 2015). Above critical power the balance falls by the work done
+* above it. Below critical power it recovers towards W' at a rate proportional to how far below critical power the
+* rider is, and to how much has been used. Power is taken to be constant between readings, over which the recovery has
+* an exact solution, so each reading is a single step however far apart they are, and pauses count as recovery.
+*/
+class WPrimeBalance
+{
+public:
+	WPrimeBalance();
+	virtual ~WPrimeBalance();
+
+	/// @brief Critical power in watts and W' in joules. The balance starts out full.
+	void SetModel(double criticalPower, double wPrime);
+	bool HasModel(void) const { return m_criticalPower > 0.0 && m_wPrime > 0.0; };
+
+	void AddReading(uint64_t timeMs, double watts);
+
+	/// @brief In joules. Goes below zero if the rider does more work above critical power than the model allows for.
+	double Balance(void) const { return m_balance; };
+	double LowestBalance(void) const { return m_lowestBalance; };
+	bool HasReadings(void) const { return m_lastTimeMs > 0; };
+
+	void SaveState(ActivitySnapshot& snapshot) const;
+	bool LoadState(ActivitySnapshot& snapshot);
+
+private:
+	double   m_criticalPower; // Watts
+	double   m_wPrime;        // Joules
+	double   m_balance;       // Joules
+	double   m_lowestBalance; // Joules
+	uint64_t m_lastTimeMs;    // Time of the most recent reading, zero if there hasn't been one
+};
+
+#endif
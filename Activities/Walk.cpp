@@ -19,6 +19,7 @@ Walk::Walk() : MovingActivity()
 {
 	m_lastStepCalculationTime = 0;
 	m_stepsTaken = 0;
+	m_hasAccelerometerData = false;
 }
 
 Walk::~Walk()
@@ -51,6 +52,25 @@ void Walk::OnFinishedLoadingSensorData(void)
 	Activity::OnFinishedLoadingSensorData();
 }
 
+bool Walk::SaveState(ActivitySnapshot& snapshot) const
+{
+	if (!MovingActivity::SaveState(snapshot))
+		return false;
+
+	snapshot.WriteUInt64(m_lastStepCalculationTime);
+	snapshot.WriteUInt16(m_stepsTaken);
+	snapshot.WriteBool(m_hasAccelerometerData);
+	return true;
+}
+
+bool Walk::LoadState(ActivitySnapshot& snapshot)
+{
+	return MovingActivity::LoadState(snapshot) &&
+		snapshot.ReadUInt64(m_lastStepCalculationTime) &&
+		snapshot.ReadUInt16(m_stepsTaken) &&
+		snapshot.ReadBool(m_hasAccelerometerData);
+}
+
 bool Walk::ProcessAccelerometerReading(const SensorReading& reading)
 {
 	try
@@ -58,6 +78,7 @@ bool Walk::ProcessAccelerometerReading(const SensorReading& reading)
 		if (reading.reading.count(AXIS_NAME_Y) > 0)
 		{
 			m_graphLine.push_back(reading.reading.at(AXIS_NAME_Y));
+			m_hasAccelerometerData = true;
 			
 			time_t endTime = GetEndTimeSecs();
 			if (endTime == 0) // Activity is in progress; if loading from the database we'll do all the calculations at the end.
@@ -90,7 +111,7 @@ ActivityAttributeType Walk::QueryActivityAttribute(const std::string& attributeN
 		result.value.intVal = StepsTaken();
 		result.valueType = TYPE_INTEGER;
 		result.measureType = MEASURE_COUNT;
-		result.valid = m_graphLine.size() > 0;
+		result.valid = m_hasAccelerometerData;
 	}
 	else
 	{
@@ -28,6 +28,9 @@ public:
 
 	virtual void OnFinishedLoadingSensorData(void);
 
+	virtual bool SaveState(ActivitySnapshot& snapshot) const;
+	virtual bool LoadState(ActivitySnapshot& snapshot);
+
 	virtual ActivityAttributeType QueryActivityAttribute(const std::string& attributeName) const;
 
 	virtual double CaloriesBurned(void) const;
@@ -45,6 +48,7 @@ protected:
 	Peaks::Peaks        m_peakFinder;
 	uint64_t            m_lastStepCalculationTime; // timestamp of when we last ran the step calculation, so we're not calling it for every accelerometer reading
 	uint16_t            m_stepsTaken;
+	bool                m_hasAccelerometerData;    // m_graphLine isn't part of the snapshot, so this says whether the step count means anything
 
 protected:
 	void CalculateStepsTaken();
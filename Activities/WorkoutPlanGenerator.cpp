@@ -7,6 +7,7 @@
 
 #include "WorkoutPlanGenerator.h"
 #include "ActivityAttribute.h"
+#include "ActivityType.h"
 #include "BikePlanGenerator.h"
 #include "Cycling.h"
 #include "FtpCalculator.h"
@@ -23,6 +24,7 @@
 
 WorkoutPlanGenerator::WorkoutPlanGenerator()
 {
+	m_hasTrainingLoad = false;
 	Reset();
 }
 
@@ -73,6 +75,13 @@ void WorkoutPlanGenerator::InsertAdditionalAttributes(const char* const activity
 	m_additionalActivitySummaries.insert(std::make_pair(tempActivityId, activitySummary));
 }
 
+void WorkoutPlanGenerator::SetTrainingLoad(const TrainingLoadDay& today, const TrainingLoadActivityList& recentActivities)
+{
+	m_trainingLoad = today;
+	m_recentTrainingLoadActivities = recentActivities;
+	m_hasTrainingLoad = true;
+}
+
 std::map<std::string, double> WorkoutPlanGenerator::CalculateInputs(const ActivitySummaryList& historicalActivities, Goal goal, GoalType goalType, time_t goalDate, bool hasSwimmingPoolAccess, bool hasOpenWaterSwimAccess, bool hasBicycle)
 {
 	std::map<std::string, double> inputs;
@@ -104,11 +113,23 @@ std::map<std::string, double> WorkoutPlanGenerator::CalculateInputs(const Activi
 	// Need last four weeks averages and bests.
 	//
 
-	// Search activities in our database.
-	for (auto iter = historicalActivities.begin(); iter != historicalActivities.end(); ++iter)
+	// Search activities in our database. The training load already has the last four weeks, so there's no need to
+	// look through the rest of the history.
+	if (m_hasTrainingLoad)
 	{
-		const ActivitySummary& summary = (*iter);
-		ProcessActivitySummary(summary);
+		for (auto iter = m_recentTrainingLoadActivities.begin(); iter != m_recentTrainingLoadActivities.end(); ++iter)
+		{
+			const TrainingLoadActivity& activity = (*iter);
+			ProcessTrainingLoadActivity(activity);
+		}
+	}
+	else
+	{
+		for (auto iter = historicalActivities.begin(); iter != historicalActivities.end(); ++iter)
+		{
+			const ActivitySummary& summary = (*iter);
+			ProcessActivitySummary(summary);
+		}
 	}
 
 	// Search activities from HealthKit.
@@ -140,9 +161,13 @@ std::map<std::string, double> WorkoutPlanGenerator::CalculateInputs(const Activi
 	// Append run training paces.
 	this->CalculateRunTrainingPaces(inputs);
 	
-	// Get the user's current estimated cycling FTP.
-	FtpCalculator ftpCalc;
-	double thresholdPower = ftpCalc.Estimate(historicalActivities);
+	// Get the user's cycling FTP, or estimate it if they haven't told us.
+	double thresholdPower = m_user.GetFtp();
+	if (thresholdPower <= (double)0.0)
+	{
+		FtpCalculator ftpCalc;
+		thresholdPower = ftpCalc.Estimate(historicalActivities);
+	}
 	inputs.insert(std::pair<std::string, double>(WORKOUT_INPUT_THRESHOLD_POWER, thresholdPower));
 	
 	//
@@ -186,6 +211,12 @@ std::map<std::string, double> WorkoutPlanGenerator::CalculateInputs(const Activi
 	inputs.insert(std::pair<std::string, double>(WORKOUT_INPUT_NUM_RUNS_LAST_FOUR_WEEKS, m_runCount));
 	inputs.insert(std::pair<std::string, double>(WORKOUT_INPUT_NUM_RIDES_LAST_FOUR_WEEKS, m_bikeCount));
 	inputs.insert(std::pair<std::string, double>(WORKOUT_INPUT_NUM_SWIMS_LAST_FOUR_WEEKS, m_swimCount));
+	if (m_hasTrainingLoad)
+	{
+		inputs.insert(std::pair<std::string, double>(WORKOUT_INPUT_CHRONIC_TRAINING_LOAD, m_trainingLoad.ctl));
+		inputs.insert(std::pair<std::string, double>(WORKOUT_INPUT_ACUTE_TRAINING_LOAD, m_trainingLoad.atl));
+		inputs.insert(std::pair<std::string, double>(WORKOUT_INPUT_TRAINING_STRESS_BALANCE, m_trainingLoad.tsb));
+	}
 
 	// Append the goal distances.
 	this->CalculateGoalDistances(inputs);
@@ -399,6 +430,53 @@ void WorkoutPlanGenerator::ProcessActivitySummary(const ActivitySummary& summary
 	}
 }
 
+void WorkoutPlanGenerator::ProcessTrainingLoadActivity(const TrainingLoadActivity& activity)
+{
+	const uint64_t SECS_PER_WEEK = 7.0 * 24.0 * 60.0 * 60.0;
+	time_t now = time(NULL);
+	ActivitySummary summary;
+	ActivityAttributeType distanceAttr;
+
+	// The distance is all that ProcessActivitySummary needs.
+	distanceAttr.value.doubleVal = activity.distanceM / 1000.0; // meters to km
+	distanceAttr.valueType = TYPE_DOUBLE;
+	distanceAttr.measureType = MEASURE_DISTANCE;
+	distanceAttr.unitSystem = UNIT_SYSTEM_METRIC;
+	distanceAttr.startTime = 0;
+	distanceAttr.endTime = 0;
+	distanceAttr.valid = activity.distanceM > (double)0.0;
+
+	summary.activityId = activity.activityId;
+	summary.startTime = activity.startTime;
+	summary.endTime = activity.endTime;
+	summary.type = activity.activityType;
+	summary.summaryAttributes.insert(std::make_pair(ACTIVITY_ATTRIBUTE_DISTANCE_TRAVELED, distanceAttr));
+	summary.pActivity = NULL;
+	ProcessActivitySummary(summary);
+
+	// Total up the training stress of each of the recent four weeks.
+	if (activity.startTime <= now - (time_t)(4 * SECS_PER_WEEK))
+	{
+		return;
+	}
+
+	size_t index = (size_t)((now - activity.startTime) / SECS_PER_WEEK);
+
+	if (index > 3)
+		index = 3;
+
+	if (activity.activityType.compare(ACTIVITY_TYPE_RUNNING) == 0)
+		m_runIntensityByWeek[index] += activity.stress;
+	else if (activity.activityType.compare(ACTIVITY_TYPE_CYCLING) == 0 ||
+	         activity.activityType.compare(ACTIVITY_TYPE_MOUNTAIN_BIKING) == 0 ||
+	         activity.activityType.compare(ACTIVITY_TYPE_STATIONARY_CYCLING) == 0 ||
+	         activity.activityType.compare(ACTIVITY_TYPE_VIRTUAL_CYCLING) == 0)
+		m_cyclingIntensityByWeek[index] += activity.stress;
+	else if (activity.activityType.compare(ACTIVITY_TYPE_POOL_SWIMMING) == 0 ||
+	         activity.activityType.compare(ACTIVITY_TYPE_OPEN_WATER_SWIMMING) == 0)
+		m_swimIntensityByWeek[index] += activity.stress;
+}
+
 void WorkoutPlanGenerator::CalculateRunTrainingPaces(std::map<std::string, double>& inputs)
 {
 	TrainingPaceCalculator paceCalc;
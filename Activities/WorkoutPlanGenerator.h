@@ -15,6 +15,7 @@
 #include "ActivitySummary.h"
 #include "Goal.h"
 #include "GoalType.h"
+#include "TrainingLoadDay.h"
 #include "Workout.h"
 #include "WorkoutList.h"
 
@@ -33,6 +34,10 @@ public:
 	/// @brief For adding data that is not in this application's workout database, such as HealthKit, for example.
 	void InsertAdditionalAttributes(const char* const activityId, const char* const activityType, time_t startTime, time_t endTime, ActivityAttributeType distanceAttr);
 
+	/// @brief Supplies today's training load and the scored activities from the last four weeks (see TrainingLoad).
+	/// When set, CalculateInputs works from these instead of looking through the user's entire history.
+	void SetTrainingLoad(const TrainingLoadDay& today, const TrainingLoadActivityList& recentActivities);
+
 	/// @brief Looks through the user's activities and generates the inputs that will feed the workout generation algorithm.
 	std::map<std::string, double> CalculateInputs(const ActivitySummaryList& historicalActivities, Goal goal, GoalType goalType, time_t goalDate, bool hasSwimmingPoolAccess, bool hasOpenWaterSwimAccess, bool hasBicycle);
 
@@ -64,11 +69,15 @@ private:
 	size_t m_runCount;                     // For average run distance
 	size_t m_bikeCount;                    // For average bike distance
 	size_t m_swimCount;                    // For average swim distance
+	bool   m_hasTrainingLoad;              // True if SetTrainingLoad was called
 
 	std::map<std::string, ActivitySummary> m_additionalActivitySummaries; // populated by InsertAdditionalAttributesForWorkoutGeneration
+	TrainingLoadDay m_trainingLoad; // populated by SetTrainingLoad
+	TrainingLoadActivityList m_recentTrainingLoadActivities; // populated by SetTrainingLoad
 
 	void Reset(void);
 	void ProcessActivitySummary(const ActivitySummary& summary);
+	void ProcessTrainingLoadActivity(const TrainingLoadActivity& activity);
 	void CalculateRunTrainingPaces(std::map<std::string, double>& inputs);
 	void CalculateGoalDistances(std::map<std::string, double>& inputs);
 };
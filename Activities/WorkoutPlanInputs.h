@@ -52,5 +52,8 @@
 #define WORKOUT_INPUT_NUM_RUNS_LAST_FOUR_WEEKS            "Number of Runs (Last 4 Weeks)"
 #define WORKOUT_INPUT_NUM_SWIMS_LAST_FOUR_WEEKS           "Number of Swims (Last 4 Weeks)"
 #define WORKOUT_INPUT_THRESHOLD_POWER                     "FTP"
+#define WORKOUT_INPUT_CHRONIC_TRAINING_LOAD               "Chronic Training Load"      // CTL (fitness), 42 day weighted average of daily training stress
+#define WORKOUT_INPUT_ACUTE_TRAINING_LOAD                 "Acute Training Load"        // ATL (fatigue), 7 day weighted average of daily training stress
+#define WORKOUT_INPUT_TRAINING_STRESS_BALANCE             "Training Stress Balance"    // TSB (form), yesterday's CTL minus ATL
 
 #endif
@@ -6,18 +6,85 @@
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include "WorkoutScheduler.h"
-#include "Signals.h"
-#include "Statistics.h"
 
 #include <algorithm>
+#include <functional>
+#include <math.h>
 #include <random>
+#include <thread>
 #include <utility>
 #include <time.h>
 
 #define SECS_PER_DAY 86400
+#define NUM_SMOOTHED_DAYS (DAYS_PER_WEEK - WORKOUT_SCHEDULER_SMOOTHING_WINDOW + 1)
+
+/**
+* The standard deviation of the daily stress, smoothed with a moving average. Changing one day's stress only changes
+* the averages whose window covers that day, so the score is kept up to date as days change, rather than worked out
+* from scratch for every arrangement that is tried.
+*/
+class ScheduleScore
+{
+public:
+	ScheduleScore(const double dailyStress[DAYS_PER_WEEK])
+	{
+		for (size_t dayIndex = 0; dayIndex < DAYS_PER_WEEK; ++dayIndex)
+			m_dailyStress[dayIndex] = dailyStress[dayIndex];
+
+		m_sum = 0.0;
+		m_sumSquares = 0.0;
+		for (size_t i = 0; i < NUM_SMOOTHED_DAYS; ++i)
+		{
+			double total = 0.0;
+
+			for (size_t j = 0; j < WORKOUT_SCHEDULER_SMOOTHING_WINDOW; ++j)
+				total += m_dailyStress[i + j];
+			m_smoothed[i] = total / (double)WORKOUT_SCHEDULER_SMOOTHING_WINDOW;
+			m_sum += m_smoothed[i];
+			m_sumSquares += m_smoothed[i] * m_smoothed[i];
+		}
+	}
+
+	double GetDay(size_t dayIndex) const { return m_dailyStress[dayIndex]; };
+
+	void SetDay(size_t dayIndex, double stress)
+	{
+		double change = (stress - m_dailyStress[dayIndex]) / (double)WORKOUT_SCHEDULER_SMOOTHING_WINDOW;
+		size_t first = (dayIndex + 1 >= WORKOUT_SCHEDULER_SMOOTHING_WINDOW) ? (dayIndex + 1 - WORKOUT_SCHEDULER_SMOOTHING_WINDOW) : 0;
+		size_t last = std::min(dayIndex, (size_t)NUM_SMOOTHED_DAYS - 1);
+
+		m_dailyStress[dayIndex] = stress;
+		for (size_t i = first; i <= last; ++i)
+		{
+			double newValue = m_smoothed[i] + change;
+
+			m_sum += newValue - m_smoothed[i];
+			m_sumSquares += (newValue * newValue) - (m_smoothed[i] * m_smoothed[i]);
+			m_smoothed[i] = newValue;
+		}
+	}
+
+	double Score() const
+	{
+		double mean = m_sum / (double)NUM_SMOOTHED_DAYS;
+		double variance = (m_sumSquares / (double)NUM_SMOOTHED_DAYS) - (mean * mean);
+
+		return (variance > 0.0) ? sqrt(variance) : 0.0;
+	}
+
+private:
+	double m_dailyStress[DAYS_PER_WEEK];
+	double m_smoothed[NUM_SMOOTHED_DAYS];
+	double m_sum;
+	double m_sumSquares;
+};
 
 WorkoutScheduler::WorkoutScheduler()
 {
+	m_algorithm = SCHEDULING_ALGORITHM_OPTIMIZER;
+	m_seed = WORKOUT_SCHEDULER_DEFAULT_SEED;
+	m_numRuns = WORKOUT_SCHEDULER_DEFAULT_NUM_RUNS;
+	m_numThreads = 0;
 }
 
 WorkoutScheduler::~WorkoutScheduler()
@@ -53,7 +120,6 @@ time_t WorkoutScheduler::TimestampOfNextDayOfWeek(DayType firstDayOfWeek)
 double WorkoutScheduler::ScoreSchedule(const WorkoutList week[DAYS_PER_WEEK])
 {
 	double dailyStressScores[DAYS_PER_WEEK] = { 0.0 };
-	double smoothedScores[DAYS_PER_WEEK] = { 0.0 };
 
 	// Compute the average daily stress.
 	for (size_t dayIndex = 0; dayIndex < DAYS_PER_WEEK; ++dayIndex)
@@ -66,9 +132,34 @@ double WorkoutScheduler::ScoreSchedule(const WorkoutList week[DAYS_PER_WEEK])
 		}
 	}
 
-	size_t numSmoothedPoints = LibMath::Signals::smooth(dailyStressScores, smoothedScores, DAYS_PER_WEEK, 2);
-	double avgSmoothedScores = LibMath::Statistics::averageDouble(smoothedScores, numSmoothedPoints);
-	return LibMath::Statistics::standardDeviation(smoothedScores, numSmoothedPoints, avgSmoothedScores);
+	ScheduleScore score(dailyStressScores);
+	return score.Score();
+}
+
+/// @brief Scores a schedule returned by ScheduleWorkouts, based on the daily stress scores. Lower is better.
+/// @param schedule - list of workouts, with their scheduled times set
+/// @param startTime - Midnight UTC on the first day of the week
+double WorkoutScheduler::ScoreSchedule(const WorkoutList& schedule, time_t startTime)
+{
+	double dailyStressScores[DAYS_PER_WEEK] = { 0.0 };
+
+	for (auto iter = schedule.begin(); iter != schedule.end(); ++iter)
+	{
+		const std::unique_ptr<Workout>& workout = (*iter);
+
+		if (workout->GetScheduledTime() >= startTime)
+		{
+			size_t dayIndex = (size_t)((workout->GetScheduledTime() - startTime) / SECS_PER_DAY);
+
+			if (dayIndex < DAYS_PER_WEEK)
+			{
+				dailyStressScores[dayIndex] += workout->GetEstimatedIntensityScore();
+			}
+		}
+	}
+
+	ScheduleScore score(dailyStressScores);
+	return score.Score();
 }
 
 size_t WorkoutScheduler::CountNumDaysSet(uint8_t possibleDays[DAYS_PER_WEEK])
@@ -170,19 +261,310 @@ void WorkoutScheduler::RandomScheduler(WorkoutList& workouts, WorkoutList week[D
 	}
 }
 
-/// @brief Organizes the workouts into a schedule for the next week. Implements a very basic constraint solving algorithm.
+/// @brief Tries ten random arrangements, and keeps the best of them and one simple deterministic arrangement.
+/// @param workouts - list of workouts that need to be scheduled
+/// @param week - workouts that are already scheduled, index 0 is the first day of the week
+/// @param unschedulableDays - list of day indexes for which we should not schedule any (more) workouts
+/// @param startTime - Midnight UTC on the first day of the week
+WorkoutList WorkoutScheduler::ScheduleWithRandomRestarts(WorkoutList& workouts, WorkoutList week[DAYS_PER_WEEK], const DayIndexList& unschedulableDays, time_t startTime)
+{
+	WorkoutList newWeek[DAYS_PER_WEEK];
+
+	// Assign workouts to days. Keep track of the one with the best score.
+	// Start with a simple deterministic algorithm and then try to beat it.
+	WorkoutList bestSchedule = CopyWorkoutList(workouts);
+	DeterministicScheduler(bestSchedule, week, unschedulableDays, startTime);
+	double bestScheduleScore = ScoreSchedule(week);
+
+	// Try and best the first arrangement, by randomly re-arranging the schedule
+	// and seeing if we can get a better score.
+	for (size_t i = 0; i < 10; ++i)
+	{
+		WorkoutList newSchedule = CopyWorkoutList(workouts);
+		RandomScheduler(newSchedule, newWeek, unschedulableDays, startTime);
+		double newScheduleScore = ScoreSchedule(newWeek);
+
+		if (newScheduleScore < bestScheduleScore)
+		{
+			bestSchedule = CopyWorkoutList(newSchedule);
+ 	 		bestScheduleScore = newScheduleScore;
+		}
+	}
+	
+	return bestSchedule;
+}
+
+/// @brief Finds the best arrangement when each workout can have a free day to itself, by trying every one.
+/// Workouts with the same stress are interchangeable, so only one order of them is tried.
+/// @return The score of the best arrangement, whose days are returned in bestDays
+double WorkoutScheduler::SolveExhaustively(const SchedulingProblem& problem, DayIndexList& bestDays)
+{
+	size_t numWorkouts = problem.workoutStress.size();
+	size_t numFreeDays = problem.freeDays.size();
+	std::vector<size_t> order(numWorkouts);
+	DayIndexList days(numWorkouts);
+	std::vector<bool> used(numFreeDays, false);
+	std::vector<size_t> freeDayIndex(numWorkouts);
+	ScheduleScore score(problem.fixedStress);
+	double bestScore = -1.0;
+
+	for (size_t i = 0; i < numWorkouts; ++i)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&problem](size_t a, size_t b) { return problem.workoutStress[a] > problem.workoutStress[b]; });
+
+	// Depth first over the workouts, most stressful first, trying each free day that's still open.
+	std::function<void(size_t)> place = [&](size_t depth)
+	{
+		if (depth == numWorkouts)
+		{
+			double current = score.Score();
+
+			if (bestScore < 0.0 || current < bestScore)
+			{
+				bestScore = current;
+				bestDays = days;
+			}
+			return;
+		}
+
+		size_t workoutIndex = order[depth];
+		double stress = problem.workoutStress[workoutIndex];
+		size_t firstFreeDay = 0;
+
+		// Same stress as the previous workout, so only put it on a later day than that one.
+		if (depth > 0 && problem.workoutStress[order[depth - 1]] == stress)
+			firstFreeDay = freeDayIndex[depth - 1] + 1;
+
+		for (size_t i = firstFreeDay; i < numFreeDays; ++i)
+		{
+			if (used[i])
+				continue;
+
+			size_t dayIndex = problem.freeDays[i];
+			double before = score.GetDay(dayIndex);
+
+			used[i] = true;
+			freeDayIndex[depth] = i;
+			days[workoutIndex] = dayIndex;
+			score.SetDay(dayIndex, before + stress);
+			place(depth + 1);
+			score.SetDay(dayIndex, before);
+			used[i] = false;
+		}
+	};
+	place(0);
+
+	return bestScore;
+}
+
+/// @brief Simulated annealing, moving one workout to another free day, or swapping it with a workout on a full day.
+/// @return The score of the best arrangement found, whose days are returned in bestDays
+double WorkoutScheduler::Anneal(const SchedulingProblem& problem, uint64_t seed, DayIndexList& bestDays)
+{
+	std::mt19937_64 generator(seed);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	size_t numWorkouts = problem.workoutStress.size();
+	size_t numFreeDays = problem.freeDays.size();
+	DayIndexList days;
+	std::vector<size_t> numOnDay(DAYS_PER_WEEK, 0);
+	ScheduleScore score(problem.fixedStress);
+
+	// Start from a random arrangement that fits.
+	DayIndexList slots;
+	for (size_t i = 0; i < problem.dayCapacity; ++i)
+		slots.insert(slots.end(), problem.freeDays.begin(), problem.freeDays.end());
+	std::shuffle(slots.begin(), slots.end(), generator);
+	for (size_t i = 0; i < numWorkouts; ++i)
+	{
+		size_t dayIndex = slots[i];
+
+		days.push_back(dayIndex);
+		++numOnDay[dayIndex];
+		score.SetDay(dayIndex, score.GetDay(dayIndex) + problem.workoutStress[i]);
+	}
+
+	double currentScore = score.Score();
+	double bestScore = currentScore;
+	bestDays = days;
+
+	// Start hot enough to accept moving an average workout onto a busy day now and then, and cool to nearly nothing.
+	double averageStress = 0.0;
+	for (auto iter = problem.workoutStress.begin(); iter != problem.workoutStress.end(); ++iter)
+		averageStress += (*iter);
+	averageStress /= (double)numWorkouts;
+
+	double temperature = std::max(averageStress, 1.0) * 0.25;
+	double cooling = pow(0.001, 1.0 / (double)WORKOUT_SCHEDULER_ANNEALING_STEPS);
+
+	for (size_t step = 0; step < WORKOUT_SCHEDULER_ANNEALING_STEPS; ++step, temperature *= cooling)
+	{
+		size_t workoutIndex = (size_t)(generator() % numWorkouts);
+		size_t fromDay = days[workoutIndex];
+		size_t toDay = problem.freeDays[(size_t)(generator() % numFreeDays)];
+		size_t otherIndex = numWorkouts;
+
+		if (toDay == fromDay)
+			continue;
+
+		// A full day means swapping with one of the workouts already on it.
+		if (numOnDay[toDay] >= problem.dayCapacity)
+		{
+			size_t pick = (size_t)(generator() % numOnDay[toDay]);
+
+			for (size_t i = 0; i < numWorkouts; ++i)
+			{
+				if (days[i] == toDay && pick-- == 0)
+				{
+					otherIndex = i;
+					break;
+				}
+			}
+		}
+
+		double moved = problem.workoutStress[workoutIndex] - ((otherIndex < numWorkouts) ? problem.workoutStress[otherIndex] : 0.0);
+		double fromBefore = score.GetDay(fromDay);
+		double toBefore = score.GetDay(toDay);
+
+		score.SetDay(fromDay, fromBefore - moved);
+		score.SetDay(toDay, toBefore + moved);
+
+		double newScore = score.Score();
+		double delta = newScore - currentScore;
+
+		if (delta <= 0.0 || uniform(generator) < exp(-delta / temperature))
+		{
+			days[workoutIndex] = toDay;
+			if (otherIndex < numWorkouts)
+				days[otherIndex] = fromDay;
+			else
+			{
+				--numOnDay[fromDay];
+				++numOnDay[toDay];
+			}
+			currentScore = newScore;
+
+			if (currentScore < bestScore)
+			{
+				bestScore = currentScore;
+				bestDays = days;
+			}
+		}
+		else
+		{
+			score.SetDay(fromDay, fromBefore);
+			score.SetDay(toDay, toBefore);
+		}
+	}
+
+	return bestScore;
+}
+
+/// @brief Spreads the workouts across the free days so that the stress is as even as possible.
+/// @param workouts - list of workouts that need to be scheduled
+/// @param week - workouts that are already scheduled, index 0 is the first day of the week
+/// @param unschedulableDays - list of day indexes for which we should not schedule any (more) workouts
+/// @param startTime - Midnight UTC on the first day of the week
+WorkoutList WorkoutScheduler::ScheduleWithOptimizer(WorkoutList& workouts, WorkoutList week[DAYS_PER_WEEK], const DayIndexList& unschedulableDays, time_t startTime)
+{
+	WorkoutList schedule = CopyWorkoutList(workouts);
+	SchedulingProblem problem;
+	std::vector<Workout*> movable;
+
+	for (size_t dayIndex = 0; dayIndex < DAYS_PER_WEEK; ++dayIndex)
+	{
+		problem.fixedStress[dayIndex] = GetEstimatedIntensityScore(week[dayIndex]);
+
+		if (std::find(unschedulableDays.begin(), unschedulableDays.end(), dayIndex) == unschedulableDays.end())
+			problem.freeDays.push_back(dayIndex);
+	}
+
+	// Everything is booked, so double up wherever it does the least harm.
+	if (problem.freeDays.empty())
+	{
+		for (size_t dayIndex = 0; dayIndex < DAYS_PER_WEEK; ++dayIndex)
+			problem.freeDays.push_back(dayIndex);
+	}
+
+	for (auto iter = schedule.begin(); iter != schedule.end(); ++iter)
+	{
+		std::unique_ptr<Workout>& workout = (*iter);
+
+		if (workout->GetScheduledTime() == 0)
+		{
+			movable.push_back(workout.get());
+			problem.workoutStress.push_back(workout->GetEstimatedIntensityScore());
+		}
+	}
+	if (movable.empty())
+	{
+		return schedule;
+	}
+
+	size_t numFreeDays = problem.freeDays.size();
+	DayIndexList bestDays;
+
+	problem.dayCapacity = (movable.size() + numFreeDays - 1) / numFreeDays;
+
+	if (problem.dayCapacity == 1)
+	{
+		SolveExhaustively(problem, bestDays);
+	}
+	else
+	{
+		// Independent runs, each with its own seed, spread across the threads. The best run wins, ties going to the
+		// lowest numbered run, so the result doesn't depend on the number of threads.
+		size_t numRuns = std::max(m_numRuns, (size_t)1);
+		size_t numThreads = m_numThreads ? m_numThreads : std::max(std::thread::hardware_concurrency(), 1U);
+		std::vector<DayIndexList> runDays(numRuns);
+		std::vector<double> runScores(numRuns, 0.0);
+		std::vector<std::thread> threads;
+
+		numThreads = std::min(numThreads, numRuns);
+		for (size_t threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+		{
+			threads.push_back(std::thread([&, threadIndex]()
+			{
+				for (size_t run = threadIndex; run < numRuns; run += numThreads)
+				{
+					runScores[run] = Anneal(problem, m_seed + run, runDays[run]);
+				}
+			}));
+		}
+		for (auto iter = threads.begin(); iter != threads.end(); ++iter)
+		{
+			(*iter).join();
+		}
+
+		size_t bestRun = 0;
+		for (size_t run = 1; run < numRuns; ++run)
+		{
+			if (runScores[run] < runScores[bestRun])
+				bestRun = run;
+		}
+		bestDays = runDays[bestRun];
+	}
+
+	for (size_t i = 0; i < movable.size(); ++i)
+	{
+		movable[i]->SetScheduledTime(startTime + (bestDays[i] * SECS_PER_DAY));
+	}
+	return schedule;
+}
+
+/// @brief Organizes the workouts into a schedule for the next week.
 /// @param workouts - list of workouts that need to be scheduled
 /// @param startTime - Midnight UTC on the first day of the week
 WorkoutList WorkoutScheduler::ScheduleWorkouts(WorkoutList& workouts, time_t startTime, DayType preferredLongRunDay)
 {
-	// Shuffle the deck.
-	auto rng = std::default_random_engine{};
-	std::shuffle(std::begin(workouts), std::end(workouts), rng);
+	if (m_algorithm == SCHEDULING_ALGORITHM_RANDOM_RESTARTS)
+	{
+		// Shuffle the deck.
+		auto rng = std::default_random_engine{};
+		std::shuffle(std::begin(workouts), std::end(workouts), rng);
+	}
 
 	// This will server as our calendar for next week.
 	WorkoutList week[DAYS_PER_WEEK];
-	WorkoutList bestWeek[DAYS_PER_WEEK];
-	WorkoutList newWeek[DAYS_PER_WEEK];
 	
 	// Do not schedule anything on these days.
 	DayIndexList unschedulableDays;
@@ -192,12 +574,15 @@ WorkoutList WorkoutScheduler::ScheduleWorkouts(WorkoutList& workouts, time_t sta
 	{
 		std::unique_ptr<Workout>& workout = (*iter);
 
-		if (workout->GetType() == WORKOUT_TYPE_EVENT)
+		if (workout->GetType() == WORKOUT_TYPE_EVENT && workout->GetScheduledTime() >= startTime)
 		{
-			size_t dayIndex = (size_t)((workout->GetScheduledTime() - startTime) / DAYS_PER_WEEK);
+			size_t dayIndex = (size_t)((workout->GetScheduledTime() - startTime) / SECS_PER_DAY);
 
-			week[dayIndex].push_back(std::unique_ptr<Workout>(new Workout(*workout)));
-			unschedulableDays.push_back(dayIndex);
+			if (dayIndex < DAYS_PER_WEEK)
+			{
+				week[dayIndex].push_back(std::unique_ptr<Workout>(new Workout(*workout)));
+				unschedulableDays.push_back(dayIndex);
+			}
 		}
 	}
 
@@ -220,26 +605,9 @@ WorkoutList WorkoutScheduler::ScheduleWorkouts(WorkoutList& workouts, time_t sta
 		}
 	}
 
-	// Assign workouts to days. Keep track of the one with the best score.
-	// Start with a simple deterministic algorithm and then try to beat it.
-	WorkoutList bestSchedule = CopyWorkoutList(workouts);
-	DeterministicScheduler(bestSchedule, week, unschedulableDays, startTime);
-	double bestScheduleScore = ScoreSchedule(week);
-
-	// Try and best the first arrangement, by randomly re-arranging the schedule
-	// and seeing if we can get a better score.
-	for (size_t i = 0; i < 10; ++i)
+	if (m_algorithm == SCHEDULING_ALGORITHM_RANDOM_RESTARTS)
 	{
-		WorkoutList newSchedule = CopyWorkoutList(workouts);
-		RandomScheduler(newSchedule, newWeek, unschedulableDays, startTime);
-		double newScheduleScore = ScoreSchedule(newWeek);
-
-		if (newScheduleScore < bestScheduleScore)
-		{
-			bestSchedule = CopyWorkoutList(newSchedule);
- 	 		bestScheduleScore = newScheduleScore;
-		}
+		return ScheduleWithRandomRestarts(workouts, week, unschedulableDays, startTime);
 	}
-	
-	return bestSchedule;
+	return ScheduleWithOptimizer(workouts, week, unschedulableDays, startTime);
 }
@@ -12,12 +12,30 @@
 #include "Workout.h"
 #include "WorkoutList.h"
 
+#include <stdint.h>
+#include <vector>
+
 #define DAYS_PER_WEEK 7
 
+#define WORKOUT_SCHEDULER_SMOOTHING_WINDOW  2    // Consecutive days averaged together when judging how evenly the stress is spread
+#define WORKOUT_SCHEDULER_DEFAULT_SEED      1
+#define WORKOUT_SCHEDULER_DEFAULT_NUM_RUNS  8    // Independent annealing runs, spread across the threads
+#define WORKOUT_SCHEDULER_ANNEALING_STEPS   5000 // Moves tried by each annealing run
+
 typedef std::vector<size_t> DayIndexList;
 
+typedef enum SchedulingAlgorithm
+{
+	SCHEDULING_ALGORITHM_RANDOM_RESTARTS = 0, // A simple deterministic arrangement, then ten random ones
+	SCHEDULING_ALGORITHM_OPTIMIZER            // Tries every arrangement when each workout can have a day to itself, anneals otherwise
+} SchedulingAlgorithm;
+
 /**
 * Assigns workouts to days, based on user preferences and estimated training stress.
+*
+* Events stay on their day and the long run goes on the preferred day. The rest of the workouts are arranged so that
+* the stress is spread as evenly across the week as possible, i.e. to minimize the score from ScoreSchedule. The
+* optimizer's results only depend on the seed, not on the number of threads.
 */
 class WorkoutScheduler
 {
@@ -25,15 +43,40 @@ public:
 	WorkoutScheduler();
 	virtual ~WorkoutScheduler();
 
+	void SetAlgorithm(SchedulingAlgorithm algorithm) { m_algorithm = algorithm; };
+	void SetSeed(uint64_t seed) { m_seed = seed; };
+	void SetNumRuns(size_t numRuns) { m_numRuns = numRuns; };
+	void SetNumThreads(size_t numThreads) { m_numThreads = numThreads; }; // Zero uses one thread per core
+
 	time_t TimestampOfNextDayOfWeek(DayType firstDayOfWeek);
 	WorkoutList ScheduleWorkouts(WorkoutList& workouts, time_t startTime, DayType preferredLongRunDay);
 
+	/// @brief Scores a schedule returned by ScheduleWorkouts. Lower is better.
+	double ScoreSchedule(const WorkoutList& schedule, time_t startTime);
+
 private:
+	typedef struct SchedulingProblem
+	{
+		double              fixedStress[DAYS_PER_WEEK]; // stress from the workouts that can't be moved
+		DayIndexList        freeDays;                   // days the other workouts may go on
+		std::vector<double> workoutStress;              // stress of each of the other workouts
+		size_t              dayCapacity;                // most workouts on any one free day
+	} SchedulingProblem;
+
+	SchedulingAlgorithm m_algorithm;
+	uint64_t            m_seed;
+	size_t              m_numRuns;
+	size_t              m_numThreads;
+
 	double ScoreSchedule(const WorkoutList week[DAYS_PER_WEEK]);
 	size_t CountNumDaysSet(uint8_t possibleDays[DAYS_PER_WEEK]);
 	void ListSchedulableDays(const WorkoutList week[DAYS_PER_WEEK], const DayIndexList& unschedulableDays, uint8_t possibleDays[DAYS_PER_WEEK]);
 	void DeterministicScheduler(WorkoutList& workouts, WorkoutList week[DAYS_PER_WEEK], const DayIndexList& unschedulableDays, time_t startTime);
 	void RandomScheduler(WorkoutList& workouts, WorkoutList week[DAYS_PER_WEEK], const DayIndexList& unschedulableDays, time_t startTime);
+	WorkoutList ScheduleWithRandomRestarts(WorkoutList& workouts, WorkoutList week[DAYS_PER_WEEK], const DayIndexList& unschedulableDays, time_t startTime);
+	WorkoutList ScheduleWithOptimizer(WorkoutList& workouts, WorkoutList week[DAYS_PER_WEEK], const DayIndexList& unschedulableDays, time_t startTime);
+	double SolveExhaustively(const SchedulingProblem& problem, DayIndexList& bestDays);
+	double Anneal(const SchedulingProblem& problem, uint64_t seed, DayIndexList& bestDays);
 };
 
 #endif
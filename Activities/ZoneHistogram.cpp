@@ -0,0 +1,89 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "ZoneHistogram.h"
+
+#include <sstream>
+#include <stdlib.h>
+#include <string.h>
+
+ZoneHistogram::ZoneHistogram(size_t numZones) :
+	m_zoneSecs(numZones, (double)0.0)
+{
+	m_lastTimeMs = 0;
+}
+
+ZoneHistogram::~ZoneHistogram()
+{
+}
+
+void ZoneHistogram::AddReading(uint64_t timeMs, uint8_t zone)
+{
+	// The first reading, and any that arrive out of order, only mark the time.
+	if (m_lastTimeMs > 0 && timeMs > m_lastTimeMs)
+	{
+		uint64_t elapsedMs = timeMs - m_lastTimeMs;
+
+		if (elapsedMs <= ZONE_HISTOGRAM_MAX_GAP_MS && zone >= 1 && zone <= m_zoneSecs.size())
+		{
+			m_zoneSecs[zone - 1] += (double)elapsedMs / (double)1000.0;
+		}
+	}
+	if (timeMs > m_lastTimeMs)
+	{
+		m_lastTimeMs = timeMs;
+	}
+}
+
+double ZoneHistogram::SecondsInZone(uint8_t zone) const
+{
+	if (zone < 1 || zone > m_zoneSecs.size())
+	{
+		return (double)0.0;
+	}
+	return m_zoneSecs[zone - 1];
+}
+
+void ZoneHistogram::SaveState(ActivitySnapshot& snapshot) const
+{
+	snapshot.WriteDoubleList(m_zoneSecs);
+	snapshot.WriteUInt64(m_lastTimeMs);
+}
+
+bool ZoneHistogram::LoadState(ActivitySnapshot& snapshot)
+{
+	size_t numZones = m_zoneSecs.size();
+
+	return snapshot.ReadDoubleList(m_zoneSecs) &&
+		(m_zoneSecs.size() == numZones) &&
+		snapshot.ReadUInt64(m_lastTimeMs);
+}
+
+std::string ZoneHistogram::AttributeName(const char* const prefix, uint8_t zone)
+{
+	std::stringstream attributeNameStream;
+
+	attributeNameStream << prefix;
+	attributeNameStream << (int)zone;
+	return attributeNameStream.str();
+}
+
+uint8_t ZoneHistogram::ZoneFromAttributeName(const std::string& attributeName, const char* const prefix)
+{
+	if (attributeName.find(prefix) != 0)
+	{
+		return 0;
+	}
+
+	unsigned long long zone = strtoull(attributeName.c_str() + strlen(prefix), NULL, 10);
+
+	if (zone > UINT8_MAX)
+	{
+		return 0;
+	}
+	return (uint8_t)zone;
+}
@@ -0,0 +1,56 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __ZONEHISTOGRAM__
+#define __ZONEHISTOGRAM__
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "ActivitySnapshot.h"
+#include "ZonesCalculator.h"
+
+#define NUM_HR_HISTOGRAM_ZONES    NUM_HR_ZONES          // User::GetZoneForHeartRate returns zones 1 to 5
+#define NUM_POWER_HISTOGRAM_ZONES (NUM_POWER_ZONES + 1) // User::GetZoneForPower returns zones 1 to 7, everything above the last threshold is zone 7
+#define ZONE_HISTOGRAM_MAX_GAP_MS 10000                 // Gaps between readings longer than this are pauses, and don't count
+
+/**
+* Time spent in each zone, added up as the readings arrive.
+*
+* Each reading's zone is credited with the time since the reading before it, so the histogram is always up to date
+* and answering "how long was spent in each zone" never means going back over the readings.
+*/
+class ZoneHistogram
+{
+public:
+	ZoneHistogram(size_t numZones);
+	virtual ~ZoneHistogram();
+
+	/// @brief Zones are numbered from 1, as they are by User.
+	void AddReading(uint64_t timeMs, uint8_t zone);
+
+	size_t NumZones(void) const { return m_zoneSecs.size(); };
+	double SecondsInZone(uint8_t zone) const;
+
+	void SaveState(ActivitySnapshot& snapshot) const;
+	bool LoadState(ActivitySnapshot& snapshot);
+
+	/// @brief Summary attributes are named with a prefix followed by the zone number, e.g. "Time In Power Zone 3".
+	static std::string AttributeName(const char* const prefix, uint8_t zone);
+
+	/// @brief Returns the zone number from an attribute name made by AttributeName, or zero if it isn't one.
+	static uint8_t ZoneFromAttributeName(const std::string& attributeName, const char* const prefix);
+
+private:
+	std::vector<double> m_zoneSecs;   // Seconds spent in each zone, zone 1 first
+	uint64_t            m_lastTimeMs; // Time of the most recent reading, zero if there hasn't been one
+};
+
+#endif
@@ -0,0 +1,17 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __ZONETYPE__
+#define __ZONETYPE__
+
+typedef enum ZoneType
+{
+	ZONE_TYPE_HEART_RATE = 0,
+	ZONE_TYPE_POWER
+} ZoneType;
+
+#endif
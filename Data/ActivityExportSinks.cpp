@@ -0,0 +1,846 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "ActivityExportSinks.h"
+#include "ActivityAttribute.h"
+#include "AxisName.h"
+#include "CsvFileWriter.h"
+#include "Defines.h"
+#include "FitFileWriter.h"
+#include "GpxFileWriter.h"
+#include "TcxFileWriter.h"
+
+#include <algorithm>
+
+/// Running totals for a FIT lap or session, accumulated from the records as they are written.
+typedef struct FitSummaryAccumulator
+{
+	uint32_t startTime = FIT_INVALID_UINT32;
+	uint32_t endTime = FIT_INVALID_UINT32;
+	double   startDistanceM = 0.0;
+	double   endDistanceM = 0.0;
+	double   maxSpeed = 0.0;
+	double   ascentM = 0.0;
+	double   descentM = 0.0;
+	double   totalHeartRate = 0.0;
+	double   totalCadence = 0.0;
+	double   totalPower = 0.0;
+	size_t   numHeartRates = 0;
+	size_t   numCadences = 0;
+	size_t   numPowers = 0;
+	uint8_t  maxHeartRate = 0;
+	uint8_t  maxCadence = 0;
+	uint16_t maxPower = 0;
+
+	void Add(const FileLib::FitRecord& rec, double distanceM, double speed, double climbM)
+	{
+		if (startTime == FIT_INVALID_UINT32)
+		{
+			startTime = rec.timestamp;
+		}
+		endTime = rec.timestamp;
+		endDistanceM = distanceM;
+		maxSpeed = std::max(maxSpeed, speed);
+		if (climbM > 0.0)
+			ascentM += climbM;
+		else
+			descentM -= climbM;
+		if (rec.heartRate != FIT_INVALID_UINT8)
+		{
+			totalHeartRate += rec.heartRate;
+			++numHeartRates;
+			maxHeartRate = std::max(maxHeartRate, rec.heartRate);
+		}
+		if (rec.cadence != FIT_INVALID_UINT8)
+		{
+			totalCadence += rec.cadence;
+			++numCadences;
+			maxCadence = std::max(maxCadence, rec.cadence);
+		}
+		if (rec.power != FIT_INVALID_UINT16)
+		{
+			totalPower += rec.power;
+			++numPowers;
+			maxPower = std::max(maxPower, rec.power);
+		}
+	}
+
+	void Fill(FileLib::FitLap& lap, uint32_t lapStartTime, uint32_t lapEndTime, double calories) const
+	{
+		double elapsedSecs = (lapEndTime > lapStartTime) ? (double)(lapEndTime - lapStartTime) : 0.0;
+		double distanceM = endDistanceM - startDistanceM;
+
+		lap.timestamp = lapEndTime;
+		lap.startTime = lapStartTime;
+		lap.totalElapsedTime = (uint32_t)(elapsedSecs * 1000.0);
+		lap.totalTimerTime = lap.totalElapsedTime;
+		lap.totalDistance = (uint32_t)(distanceM * 100.0);
+		if (calories >= 0.0)
+			lap.totalCalories = (uint16_t)calories;
+		if (elapsedSecs > 0.0)
+			lap.avgSpeed = (uint16_t)std::min(distanceM / elapsedSecs * 1000.0, (double)(FIT_INVALID_UINT16 - 1));
+		lap.maxSpeed = (uint16_t)std::min(maxSpeed * 1000.0, (double)(FIT_INVALID_UINT16 - 1));
+		if (numHeartRates > 0)
+		{
+			lap.avgHeartRate = (uint8_t)(totalHeartRate / numHeartRates);
+			lap.maxHeartRate = maxHeartRate;
+		}
+		if (numCadences > 0)
+		{
+			lap.avgCadence = (uint8_t)(totalCadence / numCadences);
+			lap.maxCadence = maxCadence;
+		}
+		if (numPowers > 0)
+		{
+			lap.avgPower = (uint16_t)(totalPower / numPowers);
+			lap.maxPower = maxPower;
+		}
+		lap.totalAscent = (uint16_t)ascentM;
+		lap.totalDescent = (uint16_t)descentM;
+	}
+} FitSummaryAccumulator;
+
+//
+// TCX
+//
+
+class TcxExportSink : public ActivityExportSink
+{
+public:
+	TcxExportSink()
+	{
+		m_pInfo = NULL;
+		m_activityStarted = false;
+		m_lapStarted = false;
+		m_trackStarted = false;
+	};
+
+	bool Open(const std::string& fileName, const ExportActivityInfo& info)
+	{
+		if (!info.isMovingActivity || !m_writer.CreateFile(fileName))
+		{
+			return false;
+		}
+
+		m_pInfo = &info;
+		m_activityStarted = m_writer.StartActivity(info.type);
+		if (m_activityStarted)
+		{
+			m_writer.WriteId((time_t)(info.startTimeMs / 1000));
+		}
+		return true;
+	};
+
+	void Write(const ExportRecord& record)
+	{
+		if (!m_activityStarted)
+		{
+			return;
+		}
+
+		switch (record.type)
+		{
+		case EXPORT_RECORD_LAP_START:
+			{
+				const ExportLapInfo& lap = m_pInfo->laps.at(record.lapIndex);
+
+				m_lapStarted = m_writer.StartLap(lap.startTimeMs);
+				if (m_lapStarted)
+				{
+					// The TCX requires TotalTimeSeconds, DistanceMeters, and Calories for each lap.
+					m_writer.StoreLapSeconds(lap.lapTimeSecs);
+					m_writer.StoreLapDistance(lap.lapDistanceM);
+					m_writer.StoreLapCalories((uint16_t)lap.lapCalories);
+					m_trackStarted = m_writer.StartTrack();
+				}
+			}
+			break;
+		case EXPORT_RECORD_POINT:
+			if (m_trackStarted)
+			{
+				m_writer.StartTrackpoint();
+				m_writer.StoreTime(record.time);
+				m_writer.StorePosition(record.values[0], record.values[1]);
+				m_writer.StoreAltitudeMeters(record.values[2]);
+				m_writer.StoreDistanceMeters(record.segmentDistanceM);
+
+				if (record.haveHeartRate)
+				{
+					m_writer.StoreHeartRateBpm((uint8_t)record.heartRate);
+				}
+				if (record.haveCadence)
+				{
+					m_writer.StoreCadenceRpm((uint8_t)record.cadence);
+				}
+				if (record.havePower)
+				{
+					m_writer.StartTrackpointExtensions();
+					m_writer.StorePowerInWatts(record.power);
+					m_writer.EndTrackpointExtensions();
+				}
+
+				m_writer.EndTrackpoint();
+			}
+			break;
+		case EXPORT_RECORD_LAP_END:
+			if (m_trackStarted)
+			{
+				m_result = m_writer.EndTrack();
+			}
+			if (m_lapStarted)
+			{
+				m_writer.EndLap();
+			}
+			m_lapStarted = false;
+			m_trackStarted = false;
+			break;
+		default:
+			break;
+		}
+	};
+
+	bool Close(void)
+	{
+		if (m_activityStarted)
+		{
+			m_writer.EndActivity();
+		}
+		m_writer.CloseFile();
+		return m_result;
+	};
+
+private:
+	FileLib::TcxFileWriter    m_writer;
+	const ExportActivityInfo* m_pInfo;
+	bool                      m_activityStarted;
+	bool                      m_lapStarted;
+	bool                      m_trackStarted;
+};
+
+//
+// GPX
+//
+
+class GpxExportSink : public ActivityExportSink
+{
+public:
+	GpxExportSink()
+	{
+		m_trackStarted = false;
+		m_segmentStarted = false;
+	};
+
+	bool Open(const std::string& fileName, const ExportActivityInfo& info)
+	{
+		if (!m_writer.CreateFile(fileName, APP_NAME))
+		{
+			return false;
+		}
+
+		m_writer.WriteMetadata(info.startTimeSecs);
+
+		m_trackStarted = m_writer.StartTrack();
+		if (m_trackStarted && info.haveSummary)
+		{
+			// Write the activity name or Untitled if it isn't set.
+			if (info.name.size() == 0)
+			{
+				m_writer.WriteName("Untitled");
+			}
+			else
+			{
+				m_writer.WriteName(info.name);
+			}
+
+			// Write the activity type.
+			if (info.summaryType.size() > 0)
+			{
+				m_writer.WriteType(info.summaryType);
+			}
+		}
+		return true;
+	};
+
+	void Write(const ExportRecord& record)
+	{
+		if (!m_trackStarted)
+		{
+			return;
+		}
+
+		switch (record.type)
+		{
+		case EXPORT_RECORD_LAP_START:
+			m_segmentStarted = m_writer.StartTrackSegment();
+			break;
+		case EXPORT_RECORD_POINT:
+			if (m_segmentStarted)
+			{
+				m_writer.StartTrackPoint(record.values[0], record.values[1], record.values[2], record.time);
+
+				if (record.haveHeartRate || record.haveCadence)
+				{
+					m_writer.StartExtensions();
+					m_writer.StartTrackPointExtensions();
+
+					if (record.haveHeartRate)
+					{
+						m_writer.StoreHeartRateBpm((uint8_t)record.heartRate);
+					}
+					if (record.haveCadence)
+					{
+						m_writer.StoreCadenceRpm((uint8_t)record.cadence);
+					}
+					if (record.havePower)
+					{
+						m_writer.StorePowerInWatts((uint32_t)record.power);
+					}
+
+					m_writer.EndTrackPointExtensions();
+					m_writer.EndExtensions();
+				}
+
+				m_writer.EndTrackPoint();
+			}
+			break;
+		case EXPORT_RECORD_LAP_END:
+			if (m_segmentStarted)
+			{
+				m_writer.EndTrackSegment();
+			}
+			m_segmentStarted = false;
+			break;
+		default:
+			break;
+		}
+	};
+
+	bool Close(void)
+	{
+		if (m_trackStarted)
+		{
+			m_result = m_writer.EndTrack();
+		}
+		m_writer.CloseFile();
+		return m_result;
+	};
+
+private:
+	FileLib::GpxFileWriter m_writer;
+	bool                   m_trackStarted;
+	bool                   m_segmentStarted;
+};
+
+//
+// FIT
+//
+
+class FitExportSink : public ActivityExportSink
+{
+public:
+	FitExportSink()
+	{
+		m_pInfo = NULL;
+		m_sportType = 0;
+		m_activityStartTime = 0;
+		m_activityEndTime = 0;
+		m_distanceM = 0.0;
+		m_prevDistanceM = 0.0;
+		m_prevAltitude = 0.0;
+		m_prevTimestamp = FIT_INVALID_UINT32;
+		m_numLaps = 0;
+	};
+
+	bool Open(const std::string& fileName, const ExportActivityInfo& info)
+	{
+		if (!info.isMovingActivity || !m_writer.CreateFile(fileName))
+		{
+			return false;
+		}
+
+		m_pInfo = &info;
+		m_sportType = FileLib::FitFileWriter::SportTypeToEnum(info.type);
+		m_activityStartTime = FileLib::FitFileWriter::UnixTimestampToFitTimestamp(info.startTimeSecs);
+		m_activityEndTime = FileLib::FitFileWriter::UnixTimestampToFitTimestamp(info.endTimeSecs);
+
+		FileLib::FitDeviceInfo deviceInfo;
+		deviceInfo.timestamp = m_activityStartTime;
+		deviceInfo.productName = APP_NAME;
+
+		m_result = m_writer.WriteDeviceInfo(deviceInfo) && m_writer.WriteSport(m_sportType) && m_writer.StartActivity(m_activityStartTime);
+		return true;
+	};
+
+	void Write(const ExportRecord& record)
+	{
+		if (!m_result)
+		{
+			return;
+		}
+
+		switch (record.type)
+		{
+		case EXPORT_RECORD_LAP_START:
+			m_lapTotals = FitSummaryAccumulator();
+			m_lapTotals.startDistanceM = m_distanceM;
+			m_lapTotals.endDistanceM = m_distanceM;
+			break;
+		case EXPORT_RECORD_POINT:
+			WriteRecord(record);
+			break;
+		case EXPORT_RECORD_LAP_END:
+			WriteLap(record.lapIndex);
+			break;
+		default:
+			break;
+		}
+	};
+
+	bool Close(void)
+	{
+		//
+		// Write the session and activity summaries.
+		//
+
+		if (m_result)
+		{
+			FileLib::FitSession session;
+			uint32_t activityEndTime = m_activityEndTime;
+
+			if (m_pInfo->endTimeSecs == 0)
+			{
+				activityEndTime = m_sessionTotals.endTime;
+			}
+
+			m_sessionTotals.startDistanceM = 0.0;
+			m_sessionTotals.Fill(session, m_activityStartTime, activityEndTime, m_pInfo->calories);
+			session.messageIndex = 0;
+			session.sport = m_sportType;
+			session.firstLapIndex = 0;
+			session.numLaps = m_numLaps;
+
+			FileLib::FitActivity activity;
+
+			time_t endTimeSecs = m_pInfo->endTimeSecs;
+			struct tm localEndTime;
+
+			activity.timestamp = activityEndTime;
+			activity.totalTimerTime = session.totalTimerTime;
+			activity.numSessions = 1;
+			if (localtime_r(&endTimeSecs, &localEndTime))
+			{
+				activity.localTimestamp = (uint32_t)(activityEndTime + localEndTime.tm_gmtoff);
+			}
+
+			m_result = m_writer.EndActivity(activityEndTime) &&
+				m_writer.WriteSession(session) &&
+				m_writer.WriteActivity(activity);
+		}
+
+		//
+		// Fill in the header and CRC, then write everything.
+		//
+
+		m_result &= m_writer.CloseFile();
+		return m_result;
+	};
+
+private:
+	FileLib::FitFileWriter    m_writer;
+	const ExportActivityInfo* m_pInfo;
+	uint8_t                   m_sportType;
+	uint32_t                  m_activityStartTime;
+	uint32_t                  m_activityEndTime;
+	FitSummaryAccumulator     m_sessionTotals;
+	FitSummaryAccumulator     m_lapTotals;
+	double                    m_distanceM;
+	double                    m_prevDistanceM;
+	double                    m_prevAltitude;
+	uint32_t                  m_prevTimestamp;
+	uint16_t                  m_numLaps;
+
+	void WriteRecord(const ExportRecord& record)
+	{
+		FileLib::FitRecord rec;
+
+		rec.timestamp = FileLib::FitFileWriter::UnixTimestampToFitTimestamp(record.time / 1000);
+		rec.positionLong = FileLib::FitFileWriter::DegreesToSemicircles(record.values[1]);
+		rec.positionLat = FileLib::FitFileWriter::DegreesToSemicircles(record.values[0]);
+		rec.altitude = (uint16_t)((record.values[2] + 500.0) * 5.0);
+
+		// FIT records carry the distance from the start of the activity.
+		m_distanceM = record.totalDistanceM;
+		rec.distance = (uint32_t)(m_distanceM * 100.0);
+
+		double speed = 0.0;
+		double climbM = 0.0;
+		if (m_prevTimestamp != FIT_INVALID_UINT32)
+		{
+			if (rec.timestamp > m_prevTimestamp)
+				speed = (m_distanceM - m_prevDistanceM) / (double)(rec.timestamp - m_prevTimestamp);
+			climbM = record.values[2] - m_prevAltitude;
+		}
+		if (speed >= 0.0 && speed * 1000.0 < FIT_INVALID_UINT16)
+		{
+			rec.speed = (uint16_t)(speed * 1000.0);
+		}
+
+		if (record.haveHeartRate)
+		{
+			rec.heartRate = (uint8_t)record.heartRate;
+		}
+		if (record.haveCadence)
+		{
+			rec.cadence = (uint8_t)record.cadence;
+		}
+		if (record.havePower)
+		{
+			rec.power = (uint16_t)record.power;
+		}
+
+		m_result = m_writer.WriteRecord(rec);
+		if (m_result)
+		{
+			m_lapTotals.Add(rec, m_distanceM, speed, climbM);
+			m_sessionTotals.Add(rec, m_distanceM, speed, climbM);
+
+			m_prevTimestamp = rec.timestamp;
+			m_prevDistanceM = m_distanceM;
+			m_prevAltitude = record.values[2];
+		}
+	};
+
+	void WriteLap(size_t lapIndex)
+	{
+		const ExportLapInfo& lapInfo = m_pInfo->laps.at(lapIndex);
+		FileLib::FitLap lap;
+
+		uint32_t lapStartTime = FileLib::FitFileWriter::UnixTimestampToFitTimestamp(lapInfo.startTimeMs / 1000);
+		uint32_t lapEndTime = (lapInfo.endTimeMs != 0) ? FileLib::FitFileWriter::UnixTimestampToFitTimestamp(lapInfo.endTimeMs / 1000) : m_lapTotals.endTime;
+		bool lastLap = (lapIndex + 1 == m_pInfo->laps.size());
+
+		m_lapTotals.Fill(lap, lapStartTime, lapEndTime, lapInfo.endCalories - lapInfo.startCalories);
+		lap.messageIndex = m_numLaps;
+		lap.lapTrigger = lastLap ? FIT_LAP_TRIGGER_SESSION_END : FIT_LAP_TRIGGER_MANUAL;
+		lap.sport = m_sportType;
+
+		m_result = m_writer.WriteLap(lap);
+		++m_numLaps;
+	};
+};
+
+//
+// CSV
+//
+
+class CsvExportSink : public ActivityExportSink
+{
+public:
+	CsvExportSink()
+	{
+		m_isMovingActivity = false;
+		m_wroteLocationTitles = false;
+		m_numValues = 0;
+	};
+
+	bool Open(const std::string& fileName, const ExportActivityInfo& info)
+	{
+		if (!m_writer.CreateFile(fileName))
+		{
+			return false;
+		}
+
+		m_isMovingActivity = info.isMovingActivity;
+		m_result = true;
+		return true;
+	};
+
+	void Write(const ExportRecord& record)
+	{
+		if (!m_result)
+		{
+			return;
+		}
+
+		switch (record.type)
+		{
+		case EXPORT_RECORD_POINT:
+			// Only moving activities have a position section.
+			if (m_isMovingActivity)
+			{
+				if (!m_wroteLocationTitles)
+				{
+					std::vector<std::string> titles;
+					titles.push_back(ACTIVITY_ATTRIBUTE_ELAPSED_TIME);
+					titles.push_back(ACTIVITY_ATTRIBUTE_LATITUDE);
+					titles.push_back(ACTIVITY_ATTRIBUTE_LONGITUDE);
+					titles.push_back(ACTIVITY_ATTRIBUTE_ALTITUDE);
+					titles.push_back(ACTIVITY_ATTRIBUTE_DISTANCE_TRAVELED);
+
+					m_result = m_writer.WriteValues(titles);
+					m_wroteLocationTitles = true;
+				}
+
+				m_values.clear();
+				m_values.push_back(record.time);
+				m_values.push_back(record.values[0]);
+				m_values.push_back(record.values[1]);
+				m_values.push_back(record.values[2]);
+				m_values.push_back(record.segmentDistanceM);
+
+				m_result = m_result && m_writer.WriteValues(m_values);
+			}
+			break;
+		case EXPORT_RECORD_SENSOR_START:
+			{
+				std::vector<std::string> titles;
+				titles.push_back(ACTIVITY_ATTRIBUTE_ELAPSED_TIME);
+
+				switch (record.sensorType)
+				{
+				case SENSOR_TYPE_ACCELEROMETER:
+					titles.push_back(ACTIVITY_ATTRIBUTE_X);
+					titles.push_back(ACTIVITY_ATTRIBUTE_Y);
+					titles.push_back(ACTIVITY_ATTRIBUTE_Z);
+					break;
+				case SENSOR_TYPE_HEART_RATE:
+					titles.push_back(ACTIVITY_ATTRIBUTE_HEART_RATE);
+					break;
+				case SENSOR_TYPE_CADENCE:
+					titles.push_back(ACTIVITY_ATTRIBUTE_CADENCE);
+					break;
+				default:
+					break;
+				}
+
+				m_numValues = titles.size() - 1;
+				m_result = m_writer.WriteValues(titles);
+			}
+			break;
+		case EXPORT_RECORD_SENSOR_READING:
+			m_values.clear();
+			m_values.push_back(record.time);
+			for (size_t i = 0; i < m_numValues; ++i)
+			{
+				m_values.push_back(record.values[i]);
+			}
+			m_result = m_writer.WriteValues(m_values);
+			break;
+		default:
+			break;
+		}
+	};
+
+	bool Close(void)
+	{
+		m_writer.CloseFile();
+		return m_result;
+	};
+
+	bool WantsSensorReadings(void) const { return true; };
+
+private:
+	FileLib::CsvFileWriter m_writer;
+	std::vector<double>    m_values;
+	bool                   m_isMovingActivity;
+	bool                   m_wroteLocationTitles;
+	size_t                 m_numValues; // Values in each of the current sensor's readings
+};
+
+ActivityExportSink* CreateActivityExportSink(FileFormat format)
+{
+	switch (format)
+	{
+	case FILE_TCX:
+		return new TcxExportSink();
+	case FILE_GPX:
+		return new GpxExportSink();
+	case FILE_CSV:
+		return new CsvExportSink();
+	case FILE_FIT:
+		return new FitExportSink();
+	case FILE_UNKNOWN:
+	case FILE_TEXT:
+	case FILE_ZWO:
+	default:
+		break;
+	}
+	return NULL;
+}
+
+//
+// Fan out
+//
+
+ActivityExportFanOut::ActivityExportFanOut()
+{
+	m_threaded = false;
+}
+
+ActivityExportFanOut::~ActivityExportFanOut()
+{
+	// Don't leave the writers running if Finish was never called.
+	for (auto iter = m_writers.begin(); iter != m_writers.end(); ++iter)
+	{
+		SinkWriter* pWriter = (*iter).get();
+
+		if (pWriter->thread.joinable())
+		{
+			{
+				std::unique_lock<std::mutex> lock(pWriter->queueMutex);
+				pWriter->finished = true;
+				pWriter->queueNotEmpty.notify_one();
+			}
+			pWriter->thread.join();
+		}
+	}
+}
+
+void ActivityExportFanOut::AddSink(ActivityExportSink* pSink)
+{
+	std::unique_ptr<SinkWriter> writer(new SinkWriter());
+
+	writer->sink.reset(pSink);
+	writer->finished = false;
+	writer->result = false;
+	m_writers.push_back(std::move(writer));
+}
+
+bool ActivityExportFanOut::WantsSensorReadings(void) const
+{
+	for (auto iter = m_writers.begin(); iter != m_writers.end(); ++iter)
+	{
+		if ((*iter)->sink->WantsSensorReadings())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void ActivityExportFanOut::Start(void)
+{
+	// A single sink is written directly, there's nothing to overlap with.
+	m_threaded = m_writers.size() > 1;
+
+	if (m_threaded)
+	{
+		m_chunk = std::make_shared<ExportRecordList>();
+		m_chunk->reserve(EXPORT_CHUNK_SIZE);
+
+		for (auto iter = m_writers.begin(); iter != m_writers.end(); ++iter)
+		{
+			(*iter)->thread = std::thread(&ActivityExportFanOut::WriteChunks, (*iter).get());
+		}
+	}
+}
+
+void ActivityExportFanOut::Write(const ExportRecord& record)
+{
+	if (m_threaded)
+	{
+		m_chunk->push_back(record);
+		if (m_chunk->size() >= EXPORT_CHUNK_SIZE)
+		{
+			Dispatch();
+		}
+	}
+	else
+	{
+		for (auto iter = m_writers.begin(); iter != m_writers.end(); ++iter)
+		{
+			(*iter)->sink->Write(record);
+		}
+	}
+}
+
+void ActivityExportFanOut::Finish(std::vector<bool>& results)
+{
+	if (m_threaded)
+	{
+		Dispatch();
+
+		for (auto iter = m_writers.begin(); iter != m_writers.end(); ++iter)
+		{
+			SinkWriter* pWriter = (*iter).get();
+
+			std::unique_lock<std::mutex> lock(pWriter->queueMutex);
+			pWriter->finished = true;
+			pWriter->queueNotEmpty.notify_one();
+		}
+		for (auto iter = m_writers.begin(); iter != m_writers.end(); ++iter)
+		{
+			(*iter)->thread.join();
+		}
+	}
+	else
+	{
+		for (auto iter = m_writers.begin(); iter != m_writers.end(); ++iter)
+		{
+			(*iter)->result = (*iter)->sink->Close();
+		}
+	}
+
+	results.clear();
+	for (auto iter = m_writers.begin(); iter != m_writers.end(); ++iter)
+	{
+		results.push_back((*iter)->result);
+	}
+}
+
+void ActivityExportFanOut::Dispatch(void)
+{
+	if (m_chunk->empty())
+	{
+		return;
+	}
+
+	// Every writer gets the same chunk, it's freed once the slowest one is done with it.
+	ExportChunk chunk = m_chunk;
+
+	for (auto iter = m_writers.begin(); iter != m_writers.end(); ++iter)
+	{
+		SinkWriter* pWriter = (*iter).get();
+
+		std::unique_lock<std::mutex> lock(pWriter->queueMutex);
+		pWriter->queueNotFull.wait(lock, [pWriter] { return pWriter->queue.size() < EXPORT_MAX_QUEUED_CHUNKS; });
+		pWriter->queue.push_back(chunk);
+		pWriter->queueNotEmpty.notify_one();
+	}
+
+	m_chunk = std::make_shared<ExportRecordList>();
+	m_chunk->reserve(EXPORT_CHUNK_SIZE);
+}
+
+void ActivityExportFanOut::WriteChunks(SinkWriter* pWriter)
+{
+	while (true)
+	{
+		ExportChunk chunk;
+
+		{
+			std::unique_lock<std::mutex> lock(pWriter->queueMutex);
+			pWriter->queueNotEmpty.wait(lock, [pWriter] { return !pWriter->queue.empty() || pWriter->finished; });
+
+			if (pWriter->queue.empty())
+			{
+				break;
+			}
+			chunk = pWriter->queue.front();
+			pWriter->queue.pop_front();
+			pWriter->queueNotFull.notify_one();
+		}
+
+		for (auto iter = chunk->begin(); iter != chunk->end(); ++iter)
+		{
+			pWriter->sink->Write(*iter);
+		}
+	}
+
+	// Closing can be the expensive part (i.e. the FIT CRC and compression), so it happens here too.
+	pWriter->result = pWriter->sink->Close();
+}
@@ -0,0 +1,155 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __ACTIVITYEXPORTSINKS__
+#define __ACTIVITYEXPORTSINKS__
+
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FileFormat.h"
+#include "SensorType.h"
+
+#define EXPORT_CHUNK_SIZE         1024 // Records handed to the writer threads at a time
+#define EXPORT_MAX_QUEUED_CHUNKS  4    // Chunks waiting for each writer, bounds memory use
+
+typedef enum ExportRecordType
+{
+	EXPORT_RECORD_LAP_START = 0, // lapIndex is the lap being started
+	EXPORT_RECORD_POINT,         // Location, with the sensor readings nearest to it in time
+	EXPORT_RECORD_LAP_END,       // lapIndex is the lap being finished
+	EXPORT_RECORD_SENSOR_START,  // The raw readings for sensorType follow
+	EXPORT_RECORD_SENSOR_READING // Raw reading, only sent to sinks that want them
+} ExportRecordType;
+
+/// One entry in the merged stream that is sent to every format writer.
+typedef struct ExportRecord
+{
+	ExportRecordType type;
+	uint64_t         time;             // Milliseconds since the epoch
+	size_t           lapIndex;
+	SensorType       sensorType;
+	double           values[3];        // Latitude, longitude, and altitude for points, otherwise the raw reading
+	double           segmentDistanceM; // Distance from the previous point
+	double           totalDistanceM;   // Distance from the first point
+	double           heartRate;
+	double           cadence;
+	double           power;
+	bool             haveHeartRate;    // FALSE if there wasn't a reading near the point
+	bool             haveCadence;
+	bool             havePower;
+} ExportRecord;
+
+typedef std::vector<ExportRecord> ExportRecordList;
+
+typedef struct ExportLapInfo
+{
+	uint64_t startTimeMs;
+	uint64_t endTimeMs;       // Zero if the activity hasn't ended
+	double   startCalories;
+	double   endCalories;
+	uint64_t lapTimeSecs;     // Lap attributes computed by the activity
+	double   lapDistanceM;
+	double   lapCalories;
+} ExportLapInfo;
+
+/// Everything the writers need to know about the activity, gathered before the sensor data is read.
+typedef struct ExportActivityInfo
+{
+	std::string                activityId;
+	std::string                type;
+	bool                       isMovingActivity;
+	bool                       haveSummary;   // The name and summary type were read from the database
+	std::string                name;
+	std::string                summaryType;
+	time_t                     startTimeSecs;
+	time_t                     endTimeSecs;
+	uint64_t                   startTimeMs;
+	uint64_t                   endTimeMs;
+	double                     calories;
+	std::vector<ExportLapInfo> laps;          // Always at least one
+} ExportActivityInfo;
+
+/**
+* Writes the export stream to one file format.
+*/
+class ActivityExportSink
+{
+public:
+	ActivityExportSink() { m_result = false; };
+	virtual ~ActivityExportSink() {};
+
+	virtual bool Open(const std::string& fileName, const ExportActivityInfo& info) = 0;
+	virtual void Write(const ExportRecord& record) = 0;
+	virtual bool Close(void) = 0;
+
+	/// @brief TRUE if the raw sensor readings should be sent, after the points.
+	virtual bool WantsSensorReadings(void) const { return false; };
+
+protected:
+	bool m_result;
+};
+
+/**
+* Sends the export stream to any number of sinks.
+*
+* With more than one sink, each sink gets its own thread and records are passed along in chunks, so the formatting,
+* compression, and file I/O for each format all happen in parallel while the caller reads the database.
+*/
+class ActivityExportFanOut
+{
+public:
+	ActivityExportFanOut();
+	virtual ~ActivityExportFanOut();
+
+	/// @brief Takes ownership of the sink. It should already be open.
+	void AddSink(ActivityExportSink* pSink);
+
+	bool WantsSensorReadings(void) const;
+
+	void Start(void);
+	void Write(const ExportRecord& record);
+
+	/// @brief Flushes everything, waits for the writers, and closes each sink. The results are in the order the sinks were added.
+	void Finish(std::vector<bool>& results);
+
+private:
+	typedef std::shared_ptr<const ExportRecordList> ExportChunk;
+
+	typedef struct SinkWriter
+	{
+		std::unique_ptr<ActivityExportSink> sink;
+		std::thread                         thread;
+		std::mutex                          queueMutex;
+		std::condition_variable             queueNotEmpty;
+		std::condition_variable             queueNotFull;
+		std::deque<ExportChunk>             queue;
+		bool                                finished; // No more chunks are coming
+		bool                                result;   // Returned by the sink when it was closed
+	} SinkWriter;
+
+	std::vector<std::unique_ptr<SinkWriter>> m_writers;
+	std::shared_ptr<ExportRecordList>        m_chunk;
+	bool                                     m_threaded;
+
+	void Dispatch(void);
+	static void WriteChunks(SinkWriter* pWriter);
+};
+
+/// @brief Creates the sink for the given export format, NULL if the format can't be exported this way.
+ActivityExportSink* CreateActivityExportSink(FileFormat format);
+
+#endif
@@ -0,0 +1,299 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "ActivityHasher.h"
+#include "ActivityAttribute.h"
+#include "Database.h"
+#include "ImportBatch.h"
+#include "SensorCursor.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static const uint64_t SHA512_ROUND_CONSTANTS[80] = {
+	0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+	0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+	0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+	0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+	0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+	0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+	0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+	0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+	0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+	0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+	0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+	0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+	0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+	0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+	0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+	0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+	0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+	0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+	0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+	0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+};
+
+static inline uint64_t RotateRight(uint64_t x, unsigned int n)
+{
+	return (x >> n) | (x << (64 - n));
+}
+
+ActivityHasher::ActivityHasher()
+{
+	Reset();
+}
+
+ActivityHasher::~ActivityHasher()
+{
+}
+
+void ActivityHasher::Reset(void)
+{
+	m_state[0] = 0x6a09e667f3bcc908ULL;
+	m_state[1] = 0xbb67ae8584caa73bULL;
+	m_state[2] = 0x3c6ef372fe94f82bULL;
+	m_state[3] = 0xa54ff53a5f1d36f1ULL;
+	m_state[4] = 0x510e527fade682d1ULL;
+	m_state[5] = 0x9b05688c2b3e6c1fULL;
+	m_state[6] = 0x1f83d9abfb41bd6bULL;
+	m_state[7] = 0x5be0cd19137e2179ULL;
+	m_numBytes = 0;
+	m_blockLen = 0;
+	m_numLocations = 0;
+}
+
+void ActivityHasher::AddLocation(uint64_t timeMs, double latitude, double longitude, double altitude)
+{
+	char buf[24];
+	int len = snprintf(buf, sizeof(buf), "%llu", (unsigned long long)timeMs);
+
+	Update((const uint8_t*)buf, (size_t)len);
+	UpdateCoordinate(latitude);
+	UpdateCoordinate(longitude);
+	UpdateCoordinate(altitude);
+	++m_numLocations;
+}
+
+void ActivityHasher::AddSensorReading(const SensorReading& reading)
+{
+	if (reading.type != SENSOR_TYPE_LOCATION)
+	{
+		return;
+	}
+
+	auto latIter = reading.reading.find(ACTIVITY_ATTRIBUTE_LATITUDE);
+	auto lonIter = reading.reading.find(ACTIVITY_ATTRIBUTE_LONGITUDE);
+	auto altIter = reading.reading.find(ACTIVITY_ATTRIBUTE_ALTITUDE);
+
+	if (latIter != reading.reading.end() && lonIter != reading.reading.end() && altIter != reading.reading.end())
+	{
+		AddLocation(reading.time, latIter->second, lonIter->second, altIter->second);
+	}
+}
+
+std::string ActivityHasher::Finish(void)
+{
+	uint64_t numBits = m_numBytes * 8;
+
+	// Pad with a one bit, then zeros, then the 128 bit message length (the top 64 bits are always zero here).
+	uint8_t padding[ACTIVITY_HASH_BLOCK_LEN + 16];
+	size_t padLen = (m_blockLen < 112) ? (112 - m_blockLen) : (240 - m_blockLen);
+
+	memset(padding, 0, sizeof(padding));
+	padding[0] = 0x80;
+	for (size_t i = 0; i < 8; ++i)
+	{
+		padding[padLen + 8 + i] = (uint8_t)(numBits >> (56 - 8 * i));
+	}
+	Update(padding, padLen + 16);
+
+	static const char hexDigits[] = "0123456789ABCDEF";
+	std::string digest;
+
+	digest.reserve(ACTIVITY_HASH_DIGEST_LEN * 2);
+	for (size_t i = 0; i < 8; ++i)
+	{
+		for (int shift = 56; shift >= 0; shift -= 8)
+		{
+			uint8_t byte = (uint8_t)(m_state[i] >> shift);
+			digest.push_back(hexDigits[byte >> 4]);
+			digest.push_back(hexDigits[byte & 0x0f]);
+		}
+	}
+
+	Reset();
+	return digest;
+}
+
+bool ActivityHasher::AddLocationsFromDatabase(Database* const pDatabase, const std::string& activityId)
+{
+	SensorCursor cursor;
+
+	// Locations come back in the order they were recorded, which is the order they are hashed in.
+	if (!pDatabase->OpenSensorCursor(activityId, SENSOR_TYPE_LOCATION, cursor))
+	{
+		return false;
+	}
+	while (cursor.IsValid())
+	{
+		AddLocation(cursor.Time(), cursor.Value(0), cursor.Value(1), cursor.Value(2));
+		cursor.Next();
+	}
+	return !cursor.Failed();
+}
+
+bool ActivityHasher::HashActivityFromDatabase(Database* const pDatabase, const std::string& activityId, std::string& hash)
+{
+	ActivityHasher hasher;
+
+	if (!hasher.AddLocationsFromDatabase(pDatabase, activityId))
+	{
+		return false;
+	}
+
+	hash = hasher.Finish();
+	return true;
+}
+
+std::string ActivityHasher::HashImportBatch(const ImportBatch& batch)
+{
+	ActivityHasher hasher;
+
+	for (size_t i = 0; i < batch.locationTimes.size(); ++i)
+	{
+		hasher.AddLocation(batch.locationTimes[i], batch.latitudes[i], batch.longitudes[i], batch.altitudes[i]);
+	}
+	return hasher.Finish();
+}
+
+void ActivityHasher::Update(const uint8_t* data, size_t dataLen)
+{
+	m_numBytes += dataLen;
+
+	while (dataLen > 0)
+	{
+		// Whole blocks are hashed straight out of the caller's buffer.
+		if (m_blockLen == 0 && dataLen >= ACTIVITY_HASH_BLOCK_LEN)
+		{
+			Transform(data);
+			data += ACTIVITY_HASH_BLOCK_LEN;
+			dataLen -= ACTIVITY_HASH_BLOCK_LEN;
+			continue;
+		}
+
+		size_t numToCopy = ACTIVITY_HASH_BLOCK_LEN - m_blockLen;
+		if (numToCopy > dataLen)
+			numToCopy = dataLen;
+
+		memcpy(m_block + m_blockLen, data, numToCopy);
+		m_blockLen += numToCopy;
+		data += numToCopy;
+		dataLen -= numToCopy;
+
+		if (m_blockLen == ACTIVITY_HASH_BLOCK_LEN)
+		{
+			Transform(m_block);
+			m_blockLen = 0;
+		}
+	}
+}
+
+void ActivityHasher::UpdateCoordinate(double value)
+{
+	// Six decimal places with a comma between each group of three digits, i.e. "1,234.567890", which is how
+	// NSNumberFormatter's decimal style formats it.
+	char digits[64];
+	int len = snprintf(digits, sizeof(digits), "%.6f", value);
+
+	if (len <= 0 || (size_t)len >= sizeof(digits))
+	{
+		return;
+	}
+
+	char grouped[96];
+	const char* src = digits;
+	size_t outLen = 0;
+
+	if (*src == '-')
+	{
+		grouped[outLen++] = *src++;
+	}
+
+	size_t numIntegerDigits = strcspn(src, ".");
+
+	for (size_t i = 0; i < numIntegerDigits; ++i)
+	{
+		if (i > 0 && (numIntegerDigits - i) % 3 == 0)
+		{
+			grouped[outLen++] = ',';
+		}
+		grouped[outLen++] = src[i];
+	}
+	while (src[numIntegerDigits] != '\0')
+	{
+		grouped[outLen++] = src[numIntegerDigits++];
+	}
+
+	Update((const uint8_t*)grouped, outLen);
+}
+
+void ActivityHasher::Transform(const uint8_t* block)
+{
+	uint64_t w[80];
+
+	for (size_t i = 0; i < 16; ++i)
+	{
+		w[i] = 0;
+		for (size_t j = 0; j < 8; ++j)
+		{
+			w[i] = (w[i] << 8) | block[i * 8 + j];
+		}
+	}
+	for (size_t i = 16; i < 80; ++i)
+	{
+		uint64_t s0 = RotateRight(w[i - 15], 1) ^ RotateRight(w[i - 15], 8) ^ (w[i - 15] >> 7);
+		uint64_t s1 = RotateRight(w[i - 2], 19) ^ RotateRight(w[i - 2], 61) ^ (w[i - 2] >> 6);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+
+	uint64_t a = m_state[0];
+	uint64_t b = m_state[1];
+	uint64_t c = m_state[2];
+	uint64_t d = m_state[3];
+	uint64_t e = m_state[4];
+	uint64_t f = m_state[5];
+	uint64_t g = m_state[6];
+	uint64_t h = m_state[7];
+
+	for (size_t i = 0; i < 80; ++i)
+	{
+		uint64_t s1 = RotateRight(e, 14) ^ RotateRight(e, 18) ^ RotateRight(e, 41);
+		uint64_t ch = (e & f) ^ (~e & g);
+		uint64_t temp1 = h + s1 + ch + SHA512_ROUND_CONSTANTS[i] + w[i];
+		uint64_t s0 = RotateRight(a, 28) ^ RotateRight(a, 34) ^ RotateRight(a, 39);
+		uint64_t maj = (a & b) ^ (a & c) ^ (b & c);
+		uint64_t temp2 = s0 + maj;
+
+		h = g;
+		g = f;
+		f = e;
+		e = d + temp1;
+		d = c;
+		c = b;
+		b = a;
+		a = temp1 + temp2;
+	}
+
+	m_state[0] += a;
+	m_state[1] += b;
+	m_state[2] += c;
+	m_state[3] += d;
+	m_state[4] += e;
+	m_state[5] += f;
+	m_state[6] += g;
+	m_state[7] += h;
+}
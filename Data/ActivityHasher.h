@@ -0,0 +1,72 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __ACTIVITYHASHER__
+#define __ACTIVITYHASHER__
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+#include "SensorReading.h"
+
+class Database;
+class ImportBatch;
+
+#define ACTIVITY_HASH_DIGEST_LEN 64 // SHA-512
+#define ACTIVITY_HASH_BLOCK_LEN  128
+
+/**
+* Computes the hash that identifies an activity for sync and duplicate detection.
+*
+* The hash is the SHA-512 of the location readings in the order they were recorded. Each reading contributes its
+* time in milliseconds followed by its latitude, longitude, and altitude, each with six decimal places and thousands
+* separators, with nothing in between. This is the same text the iOS app has always hashed (see ActivityHash.m),
+* so hashes computed here match the ones already stored and uploaded. The digest is upper case hex.
+*
+* Readings are hashed as they arrive, so the hash can be kept up to date while recording or computed from a
+* database cursor without loading the activity.
+*/
+class ActivityHasher
+{
+public:
+	ActivityHasher();
+	virtual ~ActivityHasher();
+
+	void Reset(void);
+
+	void AddLocation(uint64_t timeMs, double latitude, double longitude, double altitude);
+
+	/// @brief Only location readings are part of the hash, anything else is ignored.
+	void AddSensorReading(const SensorReading& reading);
+
+	/// @brief Adds the activity's stored locations, i.e. to pick up where a recording that was interrupted left off.
+	bool AddLocationsFromDatabase(Database* const pDatabase, const std::string& activityId);
+
+	size_t NumLocations(void) const { return m_numLocations; };
+
+	/// @brief Returns the digest of everything added since the last reset, then resets.
+	std::string Finish(void);
+
+	static bool HashActivityFromDatabase(Database* const pDatabase, const std::string& activityId, std::string& hash);
+	static std::string HashImportBatch(const ImportBatch& batch);
+
+private:
+	uint64_t m_state[8];
+	uint64_t m_numBytes;
+	uint8_t  m_block[ACTIVITY_HASH_BLOCK_LEN];
+	size_t   m_blockLen;
+	size_t   m_numLocations;
+
+	void Update(const uint8_t* data, size_t dataLen);
+	void UpdateCoordinate(double value);
+	void Transform(const uint8_t* block);
+};
+
+#endif
@@ -0,0 +1,90 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "BackgroundJob.h"
+
+BackgroundJob::BackgroundJob()
+{
+	m_running = false;
+	m_stop = false;
+}
+
+BackgroundJob::~BackgroundJob()
+{
+	Stop();
+}
+
+bool BackgroundJob::Start(JobFunc func)
+{
+	if (m_running)
+	{
+		return true;
+	}
+
+	// A previous run may have finished on its own, leaving a thread that still has to be joined.
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+
+	m_stop = false;
+	m_running = true;
+	m_thread = std::thread(&BackgroundJob::Run, this, func);
+	return true;
+}
+
+void BackgroundJob::Stop(void)
+{
+	m_stop = true;
+
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+}
+
+void BackgroundJob::Run(JobFunc func)
+{
+	func(m_stop);
+	m_running = false;
+}
+
+WorkerPool::WorkerPool()
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+	Join();
+}
+
+void WorkerPool::Start(size_t numWorkers, WorkerFunc func)
+{
+	for (size_t i = 0; i < numWorkers; ++i)
+	{
+		m_threads.push_back(std::thread(func, i));
+	}
+}
+
+void WorkerPool::Join(void)
+{
+	for (auto iter = m_threads.begin(); iter != m_threads.end(); ++iter)
+	{
+		if ((*iter).joinable())
+		{
+			(*iter).join();
+		}
+	}
+	m_threads.clear();
+}
+
+size_t WorkerPool::DefaultNumWorkers(void)
+{
+	size_t numCores = std::thread::hardware_concurrency();
+
+	return (numCores > 1) ? (numCores - 1) : 1;
+}
@@ -0,0 +1,72 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __BACKGROUNDJOB__
+#define __BACKGROUNDJOB__
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+/**
+* Runs a long job, such as an index backfill, on its own thread so that it can be stopped before the database is
+* closed. The job is expected to check the stop flag between units of work and to leave the database in a state that
+* the next run can carry on from.
+*/
+class BackgroundJob
+{
+public:
+	typedef std::function<void(const std::atomic<bool>& stop)> JobFunc;
+
+	BackgroundJob();
+	virtual ~BackgroundJob();
+
+	/// @brief Starts the job on the background thread, does nothing if a job is already running.
+	bool Start(JobFunc func);
+
+	/// @brief Asks the job to stop and waits for it to finish what it is working on.
+	void Stop(void);
+
+	bool IsRunning(void) const { return m_running; };
+
+private:
+	std::thread       m_thread;
+	std::atomic<bool> m_running;
+	std::atomic<bool> m_stop;
+
+	void Run(JobFunc func);
+};
+
+/**
+* A fixed number of threads running the same function, e.g. each taking items off a WorkQueue until it is done.
+*/
+class WorkerPool
+{
+public:
+	typedef std::function<void(size_t workerIndex)> WorkerFunc;
+
+	WorkerPool();
+	virtual ~WorkerPool();
+
+	/// @brief Starts the workers. Each is given its index, from zero to numWorkers - 1.
+	void Start(size_t numWorkers, WorkerFunc func);
+
+	/// @brief Waits for every worker to return.
+	void Join(void);
+
+	/// @brief The number of workers to use when the caller doesn't say. One core is left for the thread that feeds
+	/// the workers, or takes their results.
+	static size_t DefaultNumWorkers(void);
+
+private:
+	std::vector<std::thread> m_threads;
+};
+
+#endif
@@ -0,0 +1,28 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __BESTEFFORT__
+#define __BESTEFFORT__
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+typedef struct BestEffort
+{
+	std::string activityId;
+	std::string activityType;
+	double      distanceM;
+	uint64_t    elapsedMs; // time taken to cover the distance, in milliseconds
+	uint64_t    startTime; // time in milliseconds at which the effort started
+} BestEffort;
+
+typedef std::vector<BestEffort> BestEffortList;
+
+#endif
@@ -0,0 +1,205 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "BulkImporter.h"
+#include "BackgroundJob.h"
+#include "DataImporter.h"
+#include "GeoIndex.h"
+#include "PersonalRecords.h"
+#include "CompressedStream.h"
+
+#ifndef __ANDROID__
+#include <uuid/uuid.h>
+#endif
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+
+BulkImporter::BulkImporter(Database* pDatabase, std::mutex& dbLock) :
+	m_pDb(pDatabase),
+	m_dbLock(dbLock),
+	m_nextFile(0),
+	m_queue(BULK_IMPORT_MAX_QUEUED_BATCHES)
+{
+	m_numWorkers = WorkerPool::DefaultNumWorkers();
+	m_progressCallback = NULL;
+	m_progressContext = NULL;
+	m_numImported = 0;
+	m_numDuplicates = 0;
+}
+
+BulkImporter::~BulkImporter()
+{
+}
+
+bool BulkImporter::IsSupportedFile(const std::string& fileName)
+{
+	std::string fileExtension = FileLib::FileExtensionIgnoringCompression(fileName);
+
+	return fileExtension.compare("gpx") == 0 ||
+		fileExtension.compare("tcx") == 0 ||
+		fileExtension.compare("fit") == 0 ||
+		fileExtension.compare("csv") == 0;
+}
+
+bool BulkImporter::ImportDirectory(const std::string& dirName, const std::string& activityType)
+{
+	std::vector<std::string> fileNames;
+	std::error_code err;
+
+	for (auto iter = std::filesystem::directory_iterator(dirName, err); !err && iter != std::filesystem::directory_iterator(); iter.increment(err))
+	{
+		if (iter->is_regular_file() && IsSupportedFile(iter->path()))
+		{
+			fileNames.push_back(iter->path());
+		}
+	}
+	if (err)
+	{
+		return false;
+	}
+
+	// Import in a predictable order, directory iteration order is up to the file system.
+	std::sort(fileNames.begin(), fileNames.end());
+	return ImportFiles(fileNames, activityType);
+}
+
+bool BulkImporter::ImportFiles(const std::vector<std::string>& fileNames, const std::string& activityType)
+{
+	if (!m_pDb)
+	{
+		return false;
+	}
+
+	m_fileNames = fileNames;
+	m_activityType = activityType;
+	m_nextFile = 0;
+	m_numImported = 0;
+	m_numDuplicates = 0;
+	m_errors.clear();
+
+	size_t numWorkers = std::min(m_numWorkers, m_fileNames.size());
+	WorkerPool workers;
+
+	m_queue.Open(numWorkers);
+	workers.Start(numWorkers, [this](size_t) { ParseFiles(); });
+
+	WriteBatches();
+
+	workers.Join();
+	return m_errors.empty();
+}
+
+void BulkImporter::ParseFiles(void)
+{
+	size_t fileIndex = 0;
+
+	while ((fileIndex = m_nextFile++) < m_fileNames.size())
+	{
+		ParsedFile parsed;
+		DataImporter importer;
+		std::unique_ptr<ImportBatch> batch(new ImportBatch());
+		std::string activityId = GenerateActivityId();
+
+		parsed.fileName = m_fileNames.at(fileIndex);
+		if (activityId.size() > 0 && importer.ImportFromFile(parsed.fileName, m_activityType, activityId, *batch))
+		{
+			parsed.batch = std::move(batch);
+		}
+
+		m_queue.Push(std::move(parsed));
+	}
+
+	m_queue.ProducerFinished();
+}
+
+void BulkImporter::WriteBatches(void)
+{
+	size_t numCompleted = 0;
+	ParsedFile parsed;
+
+	while (m_queue.Pop(parsed))
+	{
+		bool succeeded = false;
+		std::string activityId;
+
+		if (parsed.batch)
+		{
+			std::string duplicateId;
+
+			activityId = parsed.batch->activityId;
+
+			m_dbLock.lock();
+			succeeded = DataImporter::StoreImportBatch(m_pDb, *parsed.batch, duplicateId);
+			if (succeeded && duplicateId.empty())
+			{
+				GeoIndex geoIndex;
+				geoIndex.IndexActivity(*m_pDb, parsed.batch->activityId);
+
+				PersonalRecords records;
+				records.AddActivity(*m_pDb, parsed.batch->activityId);
+			}
+			m_dbLock.unlock();
+
+			if (succeeded && duplicateId.size() > 0)
+			{
+				++m_numDuplicates;
+				activityId = duplicateId;
+			}
+			else if (succeeded)
+			{
+				++m_numImported;
+			}
+			else
+			{
+				m_errors.push_back({ parsed.fileName, "Failed to write the activity to the database." });
+				activityId.clear();
+			}
+		}
+		else
+		{
+			m_errors.push_back({ parsed.fileName, "Failed to parse the file." });
+		}
+
+		++numCompleted;
+		if (m_progressCallback)
+		{
+			m_progressCallback(parsed.fileName.c_str(), activityId.c_str(), succeeded, numCompleted, m_fileNames.size(), m_progressContext);
+		}
+	}
+}
+
+std::string BulkImporter::GenerateActivityId(void)
+{
+	char idBuf[37];
+
+#ifdef __ANDROID__
+	// There's no libuuid in the NDK, so build a random (version 4) UUID, which is also what java.util.UUID gives the app.
+	std::random_device rng;
+	uint8_t id[16];
+
+	for (size_t i = 0; i < sizeof(id); i += 4)
+	{
+		uint32_t bits = rng();
+		memcpy(&id[i], &bits, 4);
+	}
+	id[6] = (id[6] & 0x0f) | 0x40; // version 4
+	id[8] = (id[8] & 0x3f) | 0x80; // RFC 4122 variant
+
+	snprintf(idBuf, sizeof(idBuf), "%02X%02X%02X%02X-%02X%02X-%02X%02X-%02X%02X-%02X%02X%02X%02X%02X%02X",
+		id[0], id[1], id[2], id[3], id[4], id[5], id[6], id[7], id[8], id[9], id[10], id[11], id[12], id[13], id[14], id[15]);
+#else
+	uuid_t id;
+
+	// Same format as the activity IDs generated by the app (uppercase, with dashes).
+	uuid_generate(id);
+	uuid_unparse_upper(id, idBuf);
+#endif
+	return std::string(idBuf);
+}
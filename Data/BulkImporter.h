@@ -0,0 +1,96 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __BULKIMPORTER__
+#define __BULKIMPORTER__
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Database.h"
+#include "ImportBatch.h"
+#include "WorkQueue.h"
+
+#define BULK_IMPORT_MAX_QUEUED_BATCHES 8 // Parsed activities waiting for the writer, bounds memory use
+
+// Called on the writer thread after each file has either been stored or has failed. If the file was a duplicate of an
+// activity that was already stored, it counts as having succeeded and the ID is that of the existing activity.
+typedef void (*BulkImportProgressFunc)(const char* const fileName, const char* const activityId, bool succeeded, size_t numCompleted, size_t numFiles, void* context);
+
+typedef struct BulkImportError
+{
+	std::string fileName;
+	std::string reason;
+} BulkImportError;
+
+/**
+* Imports a directory full of activity files.
+*
+* Parsing is the expensive part of an import and doesn't need the database, so a pool of worker threads parses
+* files into ImportBatch objects. A single writer (the calling thread) takes the batches off a bounded queue and
+* stores each one in its own transaction, which keeps SQLite from contending with itself and guarantees that an
+* interrupted import never leaves a partially stored activity behind. Activities that are already in the database
+* (going by their hash, which the workers compute while parsing) are skipped.
+*/
+class BulkImporter
+{
+public:
+	BulkImporter(Database* pDatabase, std::mutex& dbLock);
+	virtual ~BulkImporter();
+
+	void SetNumWorkers(size_t numWorkers) { m_numWorkers = numWorkers; };
+	void SetProgressCallback(BulkImportProgressFunc func, void* context) { m_progressCallback = func; m_progressContext = context; };
+
+	/// @brief Imports every supported file (GPX, TCX, FIT, CSV, any of which may be gzip or zstd compressed) in the
+	/// directory. Subdirectories are not searched.
+	/// Returns FALSE if the directory could not be read or if any of the files failed to import.
+	bool ImportDirectory(const std::string& dirName, const std::string& activityType);
+
+	/// @brief Imports the given files, returns FALSE if any of them failed to import.
+	bool ImportFiles(const std::vector<std::string>& fileNames, const std::string& activityType);
+
+	size_t GetNumImported(void) const { return m_numImported; };
+	size_t GetNumDuplicates(void) const { return m_numDuplicates; };
+	const std::vector<BulkImportError>& GetErrors(void) const { return m_errors; };
+
+	static bool IsSupportedFile(const std::string& fileName);
+
+private:
+	typedef struct ParsedFile
+	{
+		std::string                  fileName;
+		std::unique_ptr<ImportBatch> batch; // NULL if the file could not be parsed
+	} ParsedFile;
+
+	Database*                    m_pDb;
+	std::mutex&                  m_dbLock;
+	size_t                       m_numWorkers;
+	BulkImportProgressFunc       m_progressCallback;
+	void*                        m_progressContext;
+
+	std::vector<std::string>     m_fileNames;
+	std::string                  m_activityType;
+	std::atomic<size_t>          m_nextFile;      // index of the next file for a worker to parse
+
+	WorkQueue<ParsedFile>        m_queue;         // Parsed files waiting for the writer
+
+	size_t                       m_numImported;
+	size_t                       m_numDuplicates; // Files that were skipped because the activity was already stored
+	std::vector<BulkImportError> m_errors;
+
+	void ParseFiles(void);
+	void WriteBatches(void);
+
+	static std::string GenerateActivityId(void);
+};
+
+#endif
@@ -0,0 +1,301 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "CriticalPower.h"
+#include "FtpCalculator.h"
+#include "PowerCurve.h"
+
+#include <algorithm>
+#include <math.h>
+
+#define SECS_PER_DAY            86400
+#define MIN_K_SECS              0.01   // Range of k searched by the three parameter fit
+#define MAX_K_SECS              1000.0
+#define NUM_K_GRID_STEPS        100    // Coarse search, evenly spaced in log(k)
+#define NUM_K_REFINE_STEPS      50     // Golden section search around the best of the coarse steps
+
+CriticalPower::CriticalPower()
+{
+}
+
+CriticalPower::~CriticalPower()
+{
+}
+
+void CriticalPower::ParseSummary(const ActivityAttributeMap& summary, PowerCurvePointList& points)
+{
+	for (auto iter = summary.begin(); iter != summary.end(); ++iter)
+	{
+		const ActivityAttributeType& value = (*iter).second;
+		PowerCurvePoint point;
+
+		if (!value.valid || value.valueType != TYPE_DOUBLE || value.value.doubleVal <= (double)0.0)
+		{
+			continue;
+		}
+		if ((point.durationSecs = PowerCurve::DurationFromAttributeName((*iter).first)) == 0)
+		{
+			continue;
+		}
+
+		point.watts = value.value.doubleVal;
+		points.push_back(point);
+	}
+
+	// The summary is sorted by name, which isn't the same as by duration.
+	std::sort(points.begin(), points.end(), [](const PowerCurvePoint& a, const PowerCurvePoint& b) { return a.durationSecs < b.durationSecs; });
+}
+
+bool CriticalPower::AddActivity(Database& db, const std::string& activityId)
+{
+	ActivityAttributeMap values;
+	PowerCurvePointList points;
+
+	// An activity without a summary, or without power, just doesn't have a curve.
+	db.RetrieveSummaryData(activityId, values);
+	ParseSummary(values, points);
+
+	return db.CreatePowerCurve(activityId, points);
+}
+
+bool CriticalPower::Rebuild(Database& db)
+{
+	ActivitySummaryList activities;
+
+	if (!(db.DeleteAllPowerCurves() && db.RetrieveActivities(activities)))
+	{
+		return false;
+	}
+
+	for (auto iter = activities.begin(); iter != activities.end(); ++iter)
+	{
+		ActivityAttributeMap values;
+		PowerCurvePointList points;
+
+		db.RetrieveSummaryData((*iter).activityId, values);
+		ParseSummary(values, points);
+
+		if (points.size() > 0 && !db.CreatePowerCurve((*iter).activityId, points))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool CriticalPower::GetCurve(Database& db, time_t startTime, time_t endTime, PowerCurvePointList& points)
+{
+	points.clear();
+	return db.RetrieveMeanMaxPowerCurve(FtpCalculator::ActivityTypes(), startTime, endTime, points);
+}
+
+bool CriticalPower::Estimate(Database& db, CriticalPowerModelType modelType, CriticalPowerModel& model)
+{
+	time_t now = time(NULL);
+	PowerCurvePointList points;
+
+	if (!GetCurve(db, now - (CRITICAL_POWER_HISTORY_DAYS * SECS_PER_DAY), now + 1, points))
+	{
+		return false;
+	}
+	return Fit(points, modelType, model);
+}
+
+bool CriticalPower::FitLine(const std::vector<double>& x, const std::vector<double>& y, double& slope, double& intercept, double& sse)
+{
+	size_t n = x.size();
+
+	if (n < 2 || y.size() != n)
+	{
+		return false;
+	}
+
+	double meanX = (double)0.0;
+	double meanY = (double)0.0;
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		meanX += x[i];
+		meanY += y[i];
+	}
+	meanX /= (double)n;
+	meanY /= (double)n;
+
+	double sxx = (double)0.0;
+	double sxy = (double)0.0;
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		sxx += (x[i] - meanX) * (x[i] - meanX);
+		sxy += (x[i] - meanX) * (y[i] - meanY);
+	}
+	if (sxx <= (double)0.0)
+	{
+		return false;
+	}
+
+	slope = sxy / sxx;
+	intercept = meanY - slope * meanX;
+
+	sse = (double)0.0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		double residual = y[i] - (intercept + slope * x[i]);
+		sse += residual * residual;
+	}
+	return true;
+}
+
+bool CriticalPower::FitTwoParameter(const PowerCurvePointList& points, CriticalPowerModel& model)
+{
+	std::vector<double> x;
+	std::vector<double> y;
+
+	for (auto iter = points.begin(); iter != points.end(); ++iter)
+	{
+		if ((*iter).durationSecs >= CRITICAL_POWER_2P_MIN_SECS && (*iter).durationSecs <= CRITICAL_POWER_2P_MAX_SECS)
+		{
+			x.push_back((double)1.0 / (double)(*iter).durationSecs);
+			y.push_back((*iter).watts);
+		}
+	}
+
+	double wPrime = (double)0.0;
+	double criticalPower = (double)0.0;
+	double sse = (double)0.0;
+
+	if (!FitLine(x, y, wPrime, criticalPower, sse) || wPrime <= (double)0.0 || criticalPower <= (double)0.0)
+	{
+		return false;
+	}
+
+	model.criticalPower = criticalPower;
+	model.wPrime = wPrime;
+	model.maxPower = (double)0.0;
+	model.rmse = sqrt(sse / (double)x.size());
+	model.numPoints = x.size();
+	return true;
+}
+
+bool CriticalPower::FitThreeParameter(const PowerCurvePointList& points, CriticalPowerModel& model)
+{
+	std::vector<double> t;
+	std::vector<double> y;
+
+	for (auto iter = points.begin(); iter != points.end(); ++iter)
+	{
+		if ((*iter).durationSecs >= CRITICAL_POWER_3P_MIN_SECS && (*iter).durationSecs <= CRITICAL_POWER_3P_MAX_SECS)
+		{
+			t.push_back((double)(*iter).durationSecs);
+			y.push_back((*iter).watts);
+		}
+	}
+	if (t.size() < 3)
+	{
+		return false;
+	}
+
+	// For a given k the model is a straight line in 1 / (t + k), with W' as the slope and CP as the intercept. Returns
+	// the squared error, or infinity if the fit doesn't make physical sense.
+	std::vector<double> x(t.size());
+	auto fitForK = [&](double k, double& wPrime, double& criticalPower) -> double
+	{
+		double sse = (double)0.0;
+
+		for (size_t i = 0; i < t.size(); ++i)
+		{
+			x[i] = (double)1.0 / (t[i] + k);
+		}
+		if (!FitLine(x, y, wPrime, criticalPower, sse) || wPrime <= (double)0.0 || criticalPower <= (double)0.0)
+		{
+			return INFINITY;
+		}
+		return sse;
+	};
+
+	double wPrime = (double)0.0;
+	double criticalPower = (double)0.0;
+	double logMin = log(MIN_K_SECS);
+	double logStep = (log(MAX_K_SECS) - logMin) / (double)(NUM_K_GRID_STEPS - 1);
+	double bestSse = INFINITY;
+	size_t bestStep = 0;
+
+	for (size_t step = 0; step < NUM_K_GRID_STEPS; ++step)
+	{
+		double sse = fitForK(exp(logMin + logStep * (double)step), wPrime, criticalPower);
+
+		if (sse < bestSse)
+		{
+			bestSse = sse;
+			bestStep = step;
+		}
+	}
+	if (isinf(bestSse))
+	{
+		return false;
+	}
+
+	// Narrow it down between the neighbours of the best step.
+	const double invPhi = (sqrt(5.0) - 1.0) / 2.0;
+	double lo = logMin + logStep * (double)(bestStep > 0 ? bestStep - 1 : 0);
+	double hi = logMin + logStep * (double)std::min(bestStep + 1, (size_t)NUM_K_GRID_STEPS - 1);
+	double a = hi - invPhi * (hi - lo);
+	double b = lo + invPhi * (hi - lo);
+	double sseA = fitForK(exp(a), wPrime, criticalPower);
+	double sseB = fitForK(exp(b), wPrime, criticalPower);
+
+	for (size_t step = 0; step < NUM_K_REFINE_STEPS; ++step)
+	{
+		if (sseA < sseB)
+		{
+			hi = b;
+			b = a;
+			sseB = sseA;
+			a = hi - invPhi * (hi - lo);
+			sseA = fitForK(exp(a), wPrime, criticalPower);
+		}
+		else
+		{
+			lo = a;
+			a = b;
+			sseA = sseB;
+			b = lo + invPhi * (hi - lo);
+			sseB = fitForK(exp(b), wPrime, criticalPower);
+		}
+	}
+
+	double k = exp((lo + hi) / 2.0);
+	double sse = fitForK(k, wPrime, criticalPower);
+
+	// The coarse step can still be the better of the two if the error is flat or ragged around it.
+	if (!(sse <= bestSse))
+	{
+		k = exp(logMin + logStep * (double)bestStep);
+		sse = fitForK(k, wPrime, criticalPower);
+	}
+
+	model.criticalPower = criticalPower;
+	model.wPrime = wPrime;
+	model.maxPower = criticalPower + wPrime / k;
+	model.rmse = sqrt(sse / (double)t.size());
+	model.numPoints = t.size();
+	return true;
+}
+
+bool CriticalPower::Fit(const PowerCurvePointList& points, CriticalPowerModelType modelType, CriticalPowerModel& model)
+{
+	model.modelType = modelType;
+
+	switch (modelType)
+	{
+	case CRITICAL_POWER_MODEL_TWO_PARAMETER:
+		return FitTwoParameter(points, model);
+	case CRITICAL_POWER_MODEL_THREE_PARAMETER:
+		return FitThreeParameter(points, model);
+	}
+	return false;
+}
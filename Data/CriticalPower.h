@@ -0,0 +1,83 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __CRITICALPOWER__
+#define __CRITICALPOWER__
+
+#pragma once
+
+#include "CriticalPowerModelType.h"
+#include "Database.h"
+#include "PowerCurvePoint.h"
+
+#include <stdint.h>
+#include <string>
+#include <time.h>
+
+#define CRITICAL_POWER_HISTORY_DAYS    90      // The mean maximal power curve is the best of the activities in this many days
+#define CRITICAL_POWER_2P_MIN_SECS     120     // The two parameter model is fitted to efforts from two to twenty minutes
+#define CRITICAL_POWER_2P_MAX_SECS     1200
+#define CRITICAL_POWER_3P_MIN_SECS     1       // The three parameter model also covers the short efforts
+#define CRITICAL_POWER_3P_MAX_SECS     1200
+#define CRITICAL_POWER_DEFAULT_W_PRIME 20000.0 // Joules, a typical W' for when there isn't enough history to fit one
+
+typedef struct CriticalPowerModel
+{
+	CriticalPowerModelType modelType;
+	double                 criticalPower; // watts
+	double                 wPrime;        // joules
+	double                 maxPower;      // watts, only for the three parameter model
+	double                 rmse;          // root mean square error of the fit, in watts
+	size_t                 numPoints;     // points of the curve that the model was fitted to
+} CriticalPowerModel;
+
+/**
+* Fits critical power (CP) and W' to the rider's mean maximal power curve.
+*
+* Each cycling activity's curve is worked out as the readings arrive (see PowerCurve) and stored in its summary. This
+* copies the curves out of the summaries into a table of their own, so that the curve for any range of time is a
+* single query that takes the best of the activities' curves, and the raw power data never has to be read again.
+*
+* The two parameter model, P = CP + W' / t, is linear in 1 / t and has a closed form least squares fit. The three
+* parameter model, P = CP + W' / (t + k) with k = W' / (Pmax - CP), is linear once k is fixed, so it is fitted by
+* searching for the k with the smallest squared error.
+*
+* All methods expect the caller to hold the database lock.
+*/
+class CriticalPower
+{
+public:
+	CriticalPower();
+	virtual ~CriticalPower();
+
+	/// @brief Reads the activity's curve from its summary, replacing any it already had. Must be called whenever the
+	/// summary is saved. Database::DeleteActivity removes it.
+	bool AddActivity(Database& db, const std::string& activityId);
+
+	/// @brief Throws away every curve and reads them all again from the summaries.
+	bool Rebuild(Database& db);
+
+	/// @brief The best of the curves of the cycling activities that started in the given time range.
+	bool GetCurve(Database& db, time_t startTime, time_t endTime, PowerCurvePointList& points);
+
+	/// @brief Fits the model to the curve of the last CRITICAL_POWER_HISTORY_DAYS.
+	bool Estimate(Database& db, CriticalPowerModelType modelType, CriticalPowerModel& model);
+
+	/// @brief Fits the model to the points of the curve in the model's range of durations. Fails if there aren't
+	/// enough of them, or if the fit doesn't make physical sense.
+	static bool Fit(const PowerCurvePointList& points, CriticalPowerModelType modelType, CriticalPowerModel& model);
+
+	/// @brief Picks the mean maximal power attributes out of a summary, shortest duration first.
+	static void ParseSummary(const ActivityAttributeMap& summary, PowerCurvePointList& points);
+
+private:
+	static bool FitTwoParameter(const PowerCurvePointList& points, CriticalPowerModel& model);
+	static bool FitThreeParameter(const PowerCurvePointList& points, CriticalPowerModel& model);
+	static bool FitLine(const std::vector<double>& x, const std::vector<double>& y, double& slope, double& intercept, double& sse);
+};
+
+#endif
@@ -7,49 +7,29 @@
 
 #include "DataExporter.h"
 #include "ActivityAttribute.h"
-#include "AxisName.h"
 #include "Defines.h"
-#include "FitFileWriter.h"
+#include "Distance.h"
+#include "ColumnarFileWriter.h"
 #include "GpxFileWriter.h"
 #include "TcxFileWriter.h"
 #include "CsvFileWriter.h"
 #include "MovingActivity.h"
+#include "SensorCursor.h"
 #include "TcxTags.h"
 #include "ZwoFileWriter.h"
 
+#include <algorithm>
+#include <time.h>
+
 DataExporter::DataExporter()
 {
+	m_compression = FileLib::COMPRESSION_NONE;
 }
 
 DataExporter::~DataExporter()
 {
 }
 
-bool DataExporter::NearestSensorReading(uint64_t timeMs, const SensorReadingList& list, SensorReadingList::const_iterator& iter)
-{
-	while ((iter != list.end()) && ((*iter).time < timeMs))
-	{
-		++iter;
-	}
-	while ((iter != list.begin()) && ((*iter).time > timeMs))
-	{
-		--iter;
-	}
-	
-	if (iter == list.begin() || iter == list.end())
-	{
-		return false;
-	}
-	
-	uint64_t sensorTime = (*iter).time;
-	uint64_t timeDiff;
-	if (sensorTime > timeMs)
-		timeDiff = sensorTime - timeMs;
-	else
-		timeDiff = timeMs - sensorTime;
-	return (timeDiff < 3000);
-}
-
 bool DataExporter::ExportToTcxUsingCallbacks(const std::string& fileName, time_t startTime, const std::string& activityId, const std::string& activityType, NextCoordinateCallback nextCoordinateCallback, void* context)
 {
 	bool result = false;
@@ -137,638 +117,270 @@ bool DataExporter::ExportToGpxUsingCallbacks(const std::string& fileName, time_t
 	return result;
 }
 
-bool DataExporter::ExportActivityFromDatabaseToFit(const std::string& fileName, Database* const pDatabase, const Activity* const pActivity)
+void DataExporter::ReadActivityExportInfo(Database* const pDatabase, const Activity* const pActivity, ExportActivityInfo& info)
 {
-	const MovingActivity* const pMovingActivity = dynamic_cast<const MovingActivity* const>(pActivity);
-	if (!pMovingActivity)
+	LapSummaryList lapList;
+	ActivitySummary summary;
+
+	info.activityId = pActivity->GetId();
+	info.type = pActivity->GetType();
+	info.isMovingActivity = dynamic_cast<const MovingActivity* const>(pActivity) != NULL;
+	info.haveSummary = pDatabase->RetrieveActivity(info.activityId, summary);
+	if (info.haveSummary)
 	{
-		return false;
+		info.name = summary.name;
+		info.summaryType = summary.type;
 	}
+	info.startTimeSecs = pActivity->GetStartTimeSecs();
+	info.endTimeSecs = pActivity->GetEndTimeSecs();
+	info.startTimeMs = pActivity->GetStartTimeMs();
+	info.endTimeMs = pActivity->GetEndTimeMs();
+	info.calories = pActivity->CaloriesBurned();
 
-	bool result = false;
-	FileLib::FitFileWriter writer;
+	pDatabase->RetrieveLaps(info.activityId, lapList);
 
-	if (writer.CreateFile(fileName))
+	// Each lap summary marks the start of the next lap, so there is always one more lap than there are summaries.
+	for (size_t lapIndex = 0; lapIndex <= lapList.size(); ++lapIndex)
 	{
-		uint8_t fitSportType = FileLib::FitFileWriter::SportTypeToEnum(pActivity->GetType());
+		ExportLapInfo lap;
 
-		if (writer.StartActivity() && writer.WriteSport(fitSportType))
+		if (lapIndex == 0)
 		{
-			std::string activityId = pActivity->GetId();
-
-			const CoordinateList& coordinateList = pMovingActivity->GetCoordinates();
-
-			LapSummaryList lapList;
-			SensorReadingList hrList;
-			SensorReadingList cadenceList;
-			SensorReadingList powerList;
-
-			pDatabase->RetrieveLaps(pActivity->GetId(), lapList);
-			pDatabase->RetrieveSensorReadingsOfType(activityId, SENSOR_TYPE_HEART_RATE, hrList);
-			pDatabase->RetrieveSensorReadingsOfType(activityId, SENSOR_TYPE_CADENCE, cadenceList);
-			pDatabase->RetrieveSensorReadingsOfType(activityId, SENSOR_TYPE_POWER, powerList);
-
-			CoordinateList::const_iterator coordinateIter = coordinateList.begin();
-			LapSummaryList::const_iterator lapIter = lapList.begin();
-			SensorReadingList::const_iterator hrIter = hrList.begin();
-			SensorReadingList::const_iterator cadenceIter = cadenceList.begin();
-			SensorReadingList::const_iterator powerIter = powerList.begin();
-
-			uint64_t lapStartTimeMs = pActivity->GetStartTimeMs();
-			uint64_t lapEndTimeMs = 0;
-			uint16_t lapNum = 1;
-
-			bool done = false;
-
-			//
-			// Write the definition message that describes what the records will look like.
-			//
-			
-			do
-			{
-				//
-				// Compute the lap end time.
-				//
-
-				if (lapIter == lapList.end())
-				{
-					lapEndTimeMs = pActivity->GetEndTimeMs();
-					done = true;
-				}
-				else
-				{
-					lapEndTimeMs = (*lapIter).startTimeMs;
-				}
-
-				//
-				// Write the lap message.
-				//
-
-				uint32_t lapStartTimeFit = FileLib::FitFileWriter::UnixTimestampToFitTimestamp(lapStartTimeMs / 1000);
-
-				if (writer.StartLap(lapStartTimeFit))
-				{
-					while (coordinateIter != coordinateList.end())
-					{
-						const Coordinate& coordinate = (*coordinateIter);
-						
-						if ((coordinate.time > lapEndTimeMs) && (lapEndTimeMs != 0))
-						{
-							break;
-						}
-						
-						FileLib::FitRecord rec;
-
-						rec.timestamp = FileLib::FitFileWriter::UnixTimestampToFitTimestamp(coordinate.time / 1000);
-						rec.positionLong = FileLib::FitFileWriter::DegreesToSemicircles(coordinate.longitude);
-						rec.positionLat = FileLib::FitFileWriter::DegreesToSemicircles(coordinate.latitude);
-						rec.altitude = (coordinate.altitude + 500) * 5.0;
-
-						bool moreHrData = NearestSensorReading(coordinate.time, hrList, hrIter);
-						bool moreCadenceData = NearestSensorReading(coordinate.time, cadenceList, cadenceIter);
-						bool morePowerData = NearestSensorReading(coordinate.time, powerList, powerIter);
-
-						if (moreHrData)
-						{
-							double rate = (*hrIter).reading.at(ACTIVITY_ATTRIBUTE_HEART_RATE);
-							rec.heartRate = (uint8_t)rate;
-						}
-						else
-						{
-							rec.heartRate = FIT_INVALID_UINT8;
-						}
-						if (moreCadenceData)
-						{
-							double cadence = (*cadenceIter).reading.at(ACTIVITY_ATTRIBUTE_CADENCE);
-							rec.cadence256 = (uint16_t)cadence;
-						}
-						else
-						{
-							rec.cadence256 = FIT_INVALID_UINT16;
-						}
-						if (morePowerData)
-						{
-							double power = (*powerIter).reading.at(ACTIVITY_ATTRIBUTE_POWER);
-							rec.power = (uint16_t)power;
-						}
-						else
-						{
-							rec.power = FIT_INVALID_UINT16;
-						}
-
-						result = writer.WriteRecord(rec);
-						if (!result)
-						{
-							break;
-						}
-
-						coordinateIter++;
-					}
-				}
-
-				lapStartTimeMs = lapEndTimeMs;
-
-				if (lapIter != lapList.end())
-				{
-					lapIter++;
-					lapNum++;
-				}
+			lap.startTimeMs = info.startTimeMs;
+			lap.startCalories = 0.0;
+		}
+		else
+		{
+			lap.startTimeMs = lapList.at(lapIndex - 1).startTimeMs;
+			lap.startCalories = lapList.at(lapIndex - 1).startingCalorieCount;
+		}
+		if (lapIndex < lapList.size())
+		{
+			lap.endTimeMs = lapList.at(lapIndex).startTimeMs;
+			lap.endCalories = lapList.at(lapIndex).startingCalorieCount;
+		}
+		else
+		{
+			lap.endTimeMs = info.endTimeMs;
+			lap.endCalories = info.calories;
+		}
 
-			} while (!done);
+		// The lap attributes are numbered from one.
+		lap.lapTimeSecs = 0;
+		lap.lapDistanceM = 0.0;
+		lap.lapCalories = 0.0;
+		if (info.isMovingActivity)
+		{
+			std::string lapNum = std::to_string(lapIndex + 1);
 
-			lapList.clear();
-			hrList.clear();
-			cadenceList.clear();
+			lap.lapTimeSecs = (uint64_t)pActivity->QueryActivityAttribute(ACTIVITY_ATTRIBUTE_LAP_TIME + lapNum).value.timeVal;
+			lap.lapDistanceM = pActivity->QueryActivityAttribute(ACTIVITY_ATTRIBUTE_LAP_DISTANCE + lapNum).value.doubleVal;
+			lap.lapCalories = pActivity->QueryActivityAttribute(ACTIVITY_ATTRIBUTE_LAP_CALORIES + lapNum).value.doubleVal;
 		}
 
-		//
-		// Update the header with the number of bytes written.
-		//
-
-		writer.CloseFile();
+		info.laps.push_back(lap);
 	}
-
-	return result;
 }
 
-bool DataExporter::ExportActivityFromDatabaseToTcx(const std::string& fileName, Database* const pDatabase, const Activity* const pActivity)
+bool DataExporter::StreamActivityFromDatabase(Database* const pDatabase, const ExportActivityInfo& info, ActivityExportFanOut& fanOut, bool& readingsLoaded)
 {
-	const MovingActivity* const pMovingActivity = dynamic_cast<const MovingActivity* const>(pActivity);
-	if (!pMovingActivity)
+	SensorCursor coordinateCursor;
+	SensorCursor hrCursor;
+	SensorCursor cadenceCursor;
+	SensorCursor powerCursor;
+
+	// Everything is read from the database once, one row per table at a time, merged by time.
+	pDatabase->OpenSensorCursor(info.activityId, SENSOR_TYPE_LOCATION, coordinateCursor);
+	pDatabase->OpenSensorCursor(info.activityId, SENSOR_TYPE_HEART_RATE, hrCursor);
+	pDatabase->OpenSensorCursor(info.activityId, SENSOR_TYPE_CADENCE, cadenceCursor);
+	pDatabase->OpenSensorCursor(info.activityId, SENSOR_TYPE_POWER, powerCursor);
+
+	ExportRecord record;
+	record.sensorType = SENSOR_TYPE_LOCATION;
+	record.segmentDistanceM = 0.0;
+	record.totalDistanceM = 0.0;
+	record.heartRate = 0.0;
+	record.cadence = 0.0;
+	record.power = 0.0;
+	record.haveHeartRate = false;
+	record.haveCadence = false;
+	record.havePower = false;
+
+	bool firstPoint = true;
+
+	for (size_t lapIndex = 0; lapIndex < info.laps.size(); ++lapIndex)
 	{
-		return false;
-	}
+		const ExportLapInfo& lap = info.laps.at(lapIndex);
 
-	bool result = false;
-	FileLib::TcxFileWriter writer;
-
-	if (writer.CreateFile(fileName))
-	{
-		if (writer.StartActivity(pActivity->GetType()))
-		{
-			std::string activityId = pActivity->GetId();
+		record.type = EXPORT_RECORD_LAP_START;
+		record.time = lap.startTimeMs;
+		record.lapIndex = lapIndex;
+		fanOut.Write(record);
 
-			const CoordinateList& coordinateList = pMovingActivity->GetCoordinates();
-			const TimeDistancePairList& distanceList = pMovingActivity->GetDistances();
-
-			LapSummaryList lapList;
-			SensorReadingList hrList;
-			SensorReadingList cadenceList;
-			SensorReadingList powerList;
-
-			pDatabase->RetrieveLaps(pActivity->GetId(), lapList);
-			pDatabase->RetrieveSensorReadingsOfType(activityId, SENSOR_TYPE_HEART_RATE, hrList);
-			pDatabase->RetrieveSensorReadingsOfType(activityId, SENSOR_TYPE_CADENCE, cadenceList);
-			pDatabase->RetrieveSensorReadingsOfType(activityId, SENSOR_TYPE_POWER, powerList);
-
-			CoordinateList::const_iterator coordinateIter = coordinateList.begin();
-			TimeDistancePairList::const_iterator distanceIter = distanceList.begin();
-			LapSummaryList::const_iterator lapIter = lapList.begin();
-			SensorReadingList::const_iterator hrIter = hrList.begin();
-			SensorReadingList::const_iterator cadenceIter = cadenceList.begin();
-			SensorReadingList::const_iterator powerIter = powerList.begin();
-
-			uint64_t lapStartTimeMs = pActivity->GetStartTimeMs();
-			uint64_t lapEndTimeMs = 0;
-			uint16_t lapNum = 1;
+		record.type = EXPORT_RECORD_POINT;
 
-			bool done = false;
-
-			writer.WriteId((time_t)(lapStartTimeMs / 1000));
+		while (coordinateCursor.IsValid())
+		{
+			uint64_t coordinateTime = coordinateCursor.Time();
 
-			do
+			if ((coordinateTime > lap.endTimeMs) && (lap.endTimeMs != 0))
 			{
-				// Compute the lap end time.
-				if (lapIter == lapList.end())
-				{
-					lapEndTimeMs = pActivity->GetEndTimeMs();
-					done = true;
-				}
-				else
-				{
-					lapEndTimeMs = (*lapIter).startTimeMs;
-				}
-
-				if (writer.StartLap(lapStartTimeMs))
-				{
-					// The TCX requires TotalTimeSeconds, DistanceMeters, and Calories for each lap.
-					std::string attributeName = ACTIVITY_ATTRIBUTE_LAP_TIME + std::to_string(lapNum);
-					ActivityAttributeType attr = pActivity->QueryActivityAttribute(attributeName);
-					writer.StoreLapSeconds((uint64_t)attr.value.timeVal);
-					attributeName = ACTIVITY_ATTRIBUTE_LAP_DISTANCE + std::to_string(lapNum);
-					attr = pActivity->QueryActivityAttribute(attributeName);
-					writer.StoreLapDistance(attr.value.doubleVal);
-					attributeName = ACTIVITY_ATTRIBUTE_LAP_CALORIES + std::to_string(lapNum);
-					attr = pActivity->QueryActivityAttribute(attributeName);
-					writer.StoreLapCalories((uint16_t)attr.value.doubleVal);					
-					
-					if (writer.StartTrack())
-					{
-						while ((coordinateIter != coordinateList.end()) && (distanceIter != distanceList.end()))
-						{
-							const Coordinate& coordinate = (*coordinateIter);
-							const TimeDistancePair& timeDistance = (*distanceIter);
-							
-							if ((coordinate.time > lapEndTimeMs) && (lapEndTimeMs != 0))
-							{
-								break;
-							}
-
-							writer.StartTrackpoint();
-							writer.StoreTime(coordinate.time);
-							writer.StorePosition(coordinate.latitude, coordinate.longitude);
-							writer.StoreAltitudeMeters(coordinate.altitude);
-
-							if (coordinateIter != coordinateList.begin())
-							{
-								writer.StoreDistanceMeters(timeDistance.distanceM);
-								distanceIter++;
-							}
-							else
-							{
-								writer.StoreDistanceMeters((double)0.0);
-							}
-
-							bool moreHrData = NearestSensorReading(coordinate.time, hrList, hrIter);
-							bool moreCadenceData = NearestSensorReading(coordinate.time, cadenceList, cadenceIter);
-							bool morePowerData = NearestSensorReading(coordinate.time, powerList, powerIter);
-							
-							if (moreHrData)
-							{
-								double rate = (*hrIter).reading.at(ACTIVITY_ATTRIBUTE_HEART_RATE);
-								writer.StoreHeartRateBpm((uint8_t)rate);
-							}
-							if (moreCadenceData)
-							{
-								double cadence = (*cadenceIter).reading.at(ACTIVITY_ATTRIBUTE_CADENCE);
-								writer.StoreCadenceRpm((uint8_t)cadence);
-							}
-							if (morePowerData)
-							{
-								double power = (*powerIter).reading.at(ACTIVITY_ATTRIBUTE_POWER);
-								writer.StartTrackpointExtensions();
-								writer.StorePowerInWatts(power);
-								writer.EndTrackpointExtensions();
-							}
-							
-							writer.EndTrackpoint();
-
-							coordinateIter++;
-						}
+				break;
+			}
 
-						result = writer.EndTrack();
-					}
-					writer.EndLap();
-				}
+			double latitude = coordinateCursor.Value(0);
+			double longitude = coordinateCursor.Value(1);
+			double altitude = coordinateCursor.Value(2);
 
-				lapStartTimeMs = lapEndTimeMs;
+			// Same distance calculation the activity uses, so the exported distances match what was displayed.
+			if (firstPoint)
+			{
+				record.segmentDistanceM = 0.0;
+				firstPoint = false;
+			}
+			else
+			{
+				record.segmentDistanceM = LibMath::Distance::haversineDistance(record.values[0], record.values[1], record.values[2], latitude, longitude, altitude);
+			}
+			record.totalDistanceM += record.segmentDistanceM;
 
-				if (lapIter != lapList.end())
-				{
-					lapIter++;
-					lapNum++;
-				}
+			record.time = coordinateTime;
+			record.values[0] = latitude;
+			record.values[1] = longitude;
+			record.values[2] = altitude;
 
-			} while (!done);
+			record.haveHeartRate = hrCursor.SeekNearest(coordinateTime, record.heartRate);
+			record.haveCadence = cadenceCursor.SeekNearest(coordinateTime, record.cadence);
+			record.havePower = powerCursor.SeekNearest(coordinateTime, record.power);
 
-			writer.EndActivity();
+			fanOut.Write(record);
 
-			lapList.clear();
-			hrList.clear();
-			cadenceList.clear();
+			coordinateCursor.Next();
 		}
 
-		writer.CloseFile();
+		record.type = EXPORT_RECORD_LAP_END;
+		record.time = lap.endTimeMs;
+		fanOut.Write(record);
 	}
-	return result;
-}
 
-bool DataExporter::ExportActivityFromDatabaseToGpx(const std::string& fileName, Database* const pDatabase, const Activity* const pActivity)
-{
-	bool result = false;
-	FileLib::GpxFileWriter writer;
+	// The raw readings are only read if one of the formats includes them.
+	readingsLoaded = true;
 
-	if (writer.CreateFile(fileName, APP_NAME))
+	if (fanOut.WantsSensorReadings())
 	{
-		std::string activityId = pActivity->GetId();
-
-		CoordinateList coordinateList;
-		LapSummaryList lapList;
-		SensorReadingList hrList;
-		SensorReadingList cadenceList;
-		SensorReadingList powerList;
-
-		pDatabase->RetrieveActivityPositionReadings(activityId, coordinateList);
-		pDatabase->RetrieveLaps(activityId, lapList);
-		pDatabase->RetrieveSensorReadingsOfType(activityId, SENSOR_TYPE_HEART_RATE, hrList);
-		pDatabase->RetrieveSensorReadingsOfType(activityId, SENSOR_TYPE_CADENCE, cadenceList);
-		pDatabase->RetrieveSensorReadingsOfType(activityId, SENSOR_TYPE_POWER, powerList);
-
-		CoordinateList::const_iterator coordinateIter = coordinateList.begin();
-		LapSummaryList::const_iterator lapIter = lapList.begin();
-		SensorReadingList::const_iterator hrIter = hrList.begin();
-		SensorReadingList::const_iterator cadenceIter = cadenceList.begin();
-		SensorReadingList::const_iterator powerIter = powerList.begin();
-
-		time_t activityStartTimeSec = 0;
-		time_t activityEndTimeSec = 0;
-
-		pDatabase->RetrieveActivityStartAndEndTime(activityId, activityStartTimeSec, activityEndTimeSec);
-
-		uint64_t lapStartTimeMs = (uint64_t)activityStartTimeSec * 1000;
-		uint64_t lapEndTimeMs = 0;
-
-		bool done = false;
+		typedef struct RawSensor
+		{
+			SensorType type;
+			size_t     numValues;
+		} RawSensor;
 
-		writer.WriteMetadata((time_t)(lapStartTimeMs / 1000));
+		const RawSensor rawSensors[] = {
+			{ SENSOR_TYPE_ACCELEROMETER, 3 },
+			{ SENSOR_TYPE_HEART_RATE, 1 },
+			{ SENSOR_TYPE_CADENCE, 1 },
+		};
 
-		if (writer.StartTrack())
+		for (size_t sensorIndex = 0; sensorIndex < sizeof(rawSensors) / sizeof(rawSensors[0]); ++sensorIndex)
 		{
-			ActivitySummary summary;
+			const RawSensor& sensor = rawSensors[sensorIndex];
+			SensorCursor cursor;
 
-			if (pDatabase->RetrieveActivity(activityId, summary))
+			if (pDatabase->OpenSensorCursor(info.activityId, sensor.type, cursor) && cursor.IsValid())
 			{
-				// Write the activity name or Untitled if it isn't set.
-				if (summary.name.size() == 0)
-				{
-					writer.WriteName("Untitled");				
-				}
-				else
-				{
-					writer.WriteName(summary.name);
-				}
+				record.type = EXPORT_RECORD_SENSOR_START;
+				record.sensorType = sensor.type;
+				record.time = cursor.Time();
+				fanOut.Write(record);
 
-				// Write the activity type.
-				if (summary.type.size() > 0)
-				{
-					writer.WriteType(summary.type);
-				}
-			}
+				record.type = EXPORT_RECORD_SENSOR_READING;
 
-			do
-			{
-				// Compute the lap end time.
-				if (lapIter == lapList.end())
-				{
-					lapEndTimeMs = (uint64_t)activityEndTimeSec * 1000;
-					done = true;
-				}
-				else
+				while (cursor.IsValid())
 				{
-					lapEndTimeMs = (*lapIter).startTimeMs;
-				}
-
-				if (writer.StartTrackSegment())
-				{
-					while (coordinateIter != coordinateList.end())
+					record.time = cursor.Time();
+					for (size_t i = 0; i < sensor.numValues; ++i)
 					{
-						const Coordinate& coordinate = (*coordinateIter);
-
-						if ((coordinate.time > lapEndTimeMs) && (lapEndTimeMs != 0))
-						{
-							break;
-						}
-
-						writer.StartTrackPoint(coordinate.latitude, coordinate.longitude, coordinate.altitude, coordinate.time);
-
-						bool moreHrData = NearestSensorReading(coordinate.time, hrList, hrIter);
-						bool moreCadenceData = NearestSensorReading(coordinate.time, cadenceList, cadenceIter);
-						bool morePowerData = NearestSensorReading(coordinate.time, powerList, powerIter);
-
-						if (moreHrData || moreCadenceData)
-						{
-							writer.StartExtensions();
-							writer.StartTrackPointExtensions();
-
-							if (moreHrData)
-							{
-								const SensorReading& reading = (*hrIter);
-								double rate = reading.reading.at(ACTIVITY_ATTRIBUTE_HEART_RATE);
-								writer.StoreHeartRateBpm((uint8_t)rate);
-							}
-							if (moreCadenceData)
-							{
-								const SensorReading& reading = (*cadenceIter);
-								double cadence = reading.reading.at(ACTIVITY_ATTRIBUTE_CADENCE);
-								writer.StoreCadenceRpm((uint8_t)cadence);
-							}
-							if (morePowerData)
-							{
-								const SensorReading& reading = (*powerIter);
-								double power = reading.reading.at(ACTIVITY_ATTRIBUTE_POWER);
-								writer.StorePowerInWatts((uint32_t)power);
-							}
-
-							writer.EndTrackPointExtensions();
-							writer.EndExtensions();
-						}
-
-						writer.EndTrackPoint();
-
-						coordinateIter++;
+						record.values[i] = cursor.Value(i);
 					}
-					writer.EndTrackSegment();
-				}
+					fanOut.Write(record);
 
-				if (lapIter != lapList.end())
-				{
-					lapIter++;
+					cursor.Next();
 				}
-
-			} while (!done);
-
-			result = writer.EndTrack();
+				readingsLoaded &= !cursor.Failed();
+			}
 		}
-
-		coordinateList.clear();
-		lapList.clear();
-		hrList.clear();
-		cadenceList.clear();
-		
-		writer.CloseFile();
 	}
-	return result;
+
+	return !coordinateCursor.Failed();
 }
 
-bool DataExporter::ExportPositionDataToCsv(FileLib::CsvFileWriter& writer, const MovingActivity* const pMovingActivity)
+bool DataExporter::ExportActivityFromDatabase(const std::vector<FileFormat>& formats, const std::string& dirName, std::vector<std::string>& fileNames, Database* const pDatabase, const Activity* const pActivity)
 {
-	bool result = true;
-
-	const CoordinateList& coordinateList = pMovingActivity->GetCoordinates();
-	const TimeDistancePairList& distanceList = pMovingActivity->GetDistances();
-
-	if (coordinateList.size() > 0)
+	if (!pActivity)
 	{
-		std::vector<std::string> titles;
-		titles.push_back(ACTIVITY_ATTRIBUTE_ELAPSED_TIME);
-		titles.push_back(ACTIVITY_ATTRIBUTE_LATITUDE);
-		titles.push_back(ACTIVITY_ATTRIBUTE_LONGITUDE);
-		titles.push_back(ACTIVITY_ATTRIBUTE_ALTITUDE);
-		titles.push_back(ACTIVITY_ATTRIBUTE_DISTANCE_TRAVELED);
-
-		result = writer.WriteValues(titles);
-
-		CoordinateList::const_iterator coordinateIter = coordinateList.begin();
-		TimeDistancePairList::const_iterator distanceIter = distanceList.begin();
-		
-		while ((coordinateIter != coordinateList.end()) && (distanceIter != distanceList.end()) && result)
-		{
-			const Coordinate& coordinate = (*coordinateIter);
-			const TimeDistancePair& timeDistance = (*distanceIter);
-			
-			std::vector<double> values;
-			values.push_back(coordinate.time);
-			values.push_back(coordinate.latitude);
-			values.push_back(coordinate.longitude);
-			values.push_back(coordinate.altitude);
-			
-			if (coordinateIter != coordinateList.begin())
-			{
-				values.push_back(timeDistance.distanceM);
-				distanceIter++;
-			}
-			else
-			{
-				values.push_back((double)0.0);
-			}
-			coordinateIter++;
-			
-			result = writer.WriteValues(values);
-		}
+		return false;
 	}
-	return result;
-}
 
-bool DataExporter::ExportAccelerometerDataToCsv(FileLib::CsvFileWriter& writer, const std::string& activityId, Database* const pDatabase)
-{
-	SensorReadingList accelList;
-	bool loaded = pDatabase->RetrieveSensorReadingsOfType(activityId, SENSOR_TYPE_ACCELEROMETER, accelList);
+	ExportActivityInfo info;
+	ActivityExportFanOut fanOut;
+	std::vector<size_t> sinkFormatIndexes; // Which of the formats each sink is writing
+	std::vector<bool> sinkWantsReadings;
 	bool result = true;
 
-	if (loaded && (accelList.size() > 0))
+	ReadActivityExportInfo(pDatabase, pActivity, info);
+
+	fileNames.clear();
+
+	for (size_t formatIndex = 0; formatIndex < formats.size(); ++formatIndex)
 	{
-		std::vector<std::string> titles;
-		titles.push_back(ACTIVITY_ATTRIBUTE_ELAPSED_TIME);
-		titles.push_back(ACTIVITY_ATTRIBUTE_X);
-		titles.push_back(ACTIVITY_ATTRIBUTE_Y);
-		titles.push_back(ACTIVITY_ATTRIBUTE_Z);
-		
-		result = writer.WriteValues(titles);
+		FileFormat format = formats.at(formatIndex);
+		std::string fileName = dirName;
 
-		SensorReadingList::const_iterator accelIter = accelList.begin();
+		if (fileName.length() == 0 || fileName.at(fileName.length() - 1) != '/')
+			fileName.append("/");
+		fileName.append(GenerateFileName(format, pActivity->GetStartTimeSecs(), pActivity->GetType()));
+		fileNames.push_back(fileName);
 
-		while (accelIter != accelList.end() && result)
+		ActivityExportSink* pSink = CreateActivityExportSink(format);
+
+		if (pSink && pSink->Open(fileName, info))
 		{
-			const SensorReading& reading = (*accelIter);
-
-			double x = reading.reading.at(AXIS_NAME_X);
-			double y = reading.reading.at(AXIS_NAME_Y);
-			double z = reading.reading.at(AXIS_NAME_Z);
-
-			std::vector<double> values;
-			values.push_back(reading.time);
-			values.push_back(x);
-			values.push_back(y);
-			values.push_back(z);
-			
-			result = writer.WriteValues(values);
-			
-			++accelIter;
+			sinkFormatIndexes.push_back(formatIndex);
+			sinkWantsReadings.push_back(pSink->WantsSensorReadings());
+			fanOut.AddSink(pSink);
 		}
-	}
-	return result;
-}
-
-bool DataExporter::ExportHeartRateDataToCsv(FileLib::CsvFileWriter& writer, const std::string& activityId, Database* const pDatabase)
-{
-	SensorReadingList hrList;
-	bool loaded = pDatabase->RetrieveSensorReadingsOfType(activityId, SENSOR_TYPE_HEART_RATE, hrList);
-	bool result = true;
-
-	if (loaded && (hrList.size() > 0))
-	{
-		std::vector<std::string> titles;
-		titles.push_back(ACTIVITY_ATTRIBUTE_ELAPSED_TIME);
-		titles.push_back(ACTIVITY_ATTRIBUTE_HEART_RATE);
-		
-		result = writer.WriteValues(titles);
-		
-		SensorReadingList::const_iterator hrIter = hrList.begin();
-		
-		while (hrIter != hrList.end() && result)
+		else
 		{
-			const SensorReading& reading = (*hrIter);
-			
-			double rate = reading.reading.at(ACTIVITY_ATTRIBUTE_HEART_RATE);
-			
-			std::vector<double> values;
-			values.push_back(reading.time);
-			values.push_back(rate);
-			
-			result = writer.WriteValues(values);
-			
-			++hrIter;
+			delete pSink;
+			fileNames.back().clear();
+			result = false;
 		}
 	}
-	return result;
-}
-
-bool DataExporter::ExportCadenceDataToCsv(FileLib::CsvFileWriter& writer, const std::string& activityId, Database* const pDatabase)
-{
-	SensorReadingList cadenceList;
-	bool loaded = pDatabase->RetrieveSensorReadingsOfType(activityId, SENSOR_TYPE_CADENCE, cadenceList);
-	bool result = true;
 
-	if (loaded && (cadenceList.size() > 0))
+	if (sinkFormatIndexes.empty())
 	{
-		std::vector<std::string> titles;
-		titles.push_back(ACTIVITY_ATTRIBUTE_ELAPSED_TIME);
-		titles.push_back(ACTIVITY_ATTRIBUTE_CADENCE);
-		
-		result = writer.WriteValues(titles);
-		
-		SensorReadingList::const_iterator cadenceIter = cadenceList.begin();
-		
-		while (cadenceIter != cadenceList.end() && result)
-		{
-			const SensorReading& reading = (*cadenceIter);
-			
-			double rate = reading.reading.at(ACTIVITY_ATTRIBUTE_CADENCE);
-			
-			std::vector<double> values;
-			values.push_back(reading.time);
-			values.push_back(rate);
-			
-			result = writer.WriteValues(values);
-			
-			++cadenceIter;
-		}
+		return false;
 	}
-	return result;
-}
 
-bool DataExporter::ExportActivityFromDatabaseToCsv(const std::string& fileName, Database* const pDatabase, const Activity* const pActivity)
-{
-	bool result = false;
-	FileLib::CsvFileWriter writer;
+	//
+	// One pass over the sensor data, with every file being written at the same time.
+	//
 
-	if (writer.CreateFile(fileName))
+	std::vector<bool> sinkResults;
+	bool readingsLoaded = false;
+
+	fanOut.Start();
+	bool pointsLoaded = StreamActivityFromDatabase(pDatabase, info, fanOut, readingsLoaded);
+	fanOut.Finish(sinkResults);
+
+	for (size_t sinkIndex = 0; sinkIndex < sinkResults.size(); ++sinkIndex)
 	{
-		const MovingActivity* const pMovingActivity = dynamic_cast<const MovingActivity* const>(pActivity);
-		if (pMovingActivity)
-		{
-			result = ExportPositionDataToCsv(writer, pMovingActivity);
-		}
-		else
+		bool sinkResult = sinkResults.at(sinkIndex) && pointsLoaded && (readingsLoaded || !sinkWantsReadings.at(sinkIndex));
+
+		if (!sinkResult)
 		{
-			result = true;
+			fileNames.at(sinkFormatIndexes.at(sinkIndex)).clear();
+			result = false;
 		}
-
-		result &= ExportAccelerometerDataToCsv(writer, pActivity->GetId(), pDatabase);
-		result &= ExportHeartRateDataToCsv(writer, pActivity->GetId(), pDatabase);
-		result &= ExportCadenceDataToCsv(writer, pActivity->GetId(), pDatabase);
-
-		writer.CloseFile();
 	}
 	return result;
 }
@@ -802,6 +414,7 @@ std::string DataExporter::GenerateFileName(FileFormat format, const std::string&
 		default:
 			break;
 	}
+	fileName.append(FileLib::CompressionFileExtension(m_compression));
 
 	return fileName;
 }
@@ -846,37 +459,20 @@ std::string DataExporter::GenerateFileName(FileFormat format, time_t startTime,
 		default:
 			break;
 	}
+	fileName.append(FileLib::CompressionFileExtension(m_compression));
 
 	return fileName;
 }
 
 bool DataExporter::ExportActivityFromDatabase(FileFormat format, std::string& fileName, Database* const pDatabase, const Activity* const pActivity)
 {
-	if (pActivity)
-	{
-		if (fileName.length() == 0 || fileName.at(fileName.length() - 1) != '/')
-			fileName.append("/");
-		fileName.append(GenerateFileName(format, pActivity->GetStartTimeSecs(), pActivity->GetType()));
+	std::vector<FileFormat> formats(1, format);
+	std::vector<std::string> fileNames;
 
-		switch (format)
-		{
-			case FILE_UNKNOWN:
-				return false;
-			case FILE_TEXT:
-				return false;
-			case FILE_TCX:
-				return ExportActivityFromDatabaseToTcx(fileName, pDatabase, pActivity);
-			case FILE_GPX:
-				return ExportActivityFromDatabaseToGpx(fileName, pDatabase, pActivity);
-			case FILE_CSV:
-				return ExportActivityFromDatabaseToCsv(fileName, pDatabase, pActivity);
-			case FILE_ZWO:
-				return false;
-			case FILE_FIT:
-				return ExportActivityFromDatabaseToFit(fileName, pDatabase, pActivity);
-			default:
-				return false;
-		}
+	if (ExportActivityFromDatabase(formats, fileName, fileNames, pDatabase, pActivity))
+	{
+		fileName = fileNames.at(0);
+		return true;
 	}
 	return false;
 }
@@ -994,6 +590,179 @@ bool DataExporter::ExportActivitySummary(const ActivitySummaryList& activities,
 	return result;
 }
 
+#define COLUMNAR_FILE_EXTENSION ".owtc"
+#define NUM_COLUMNAR_SENSOR_TABLES 7
+
+typedef struct ColumnarSensorTable
+{
+	SensorType  sensorType;
+	const char* tableName;
+	size_t      numValues;
+	const char* valueNames[SENSOR_CURSOR_MAX_VALUES];
+} ColumnarSensorTable;
+
+// Column names are the same as in the database, so existing queries are easy to port.
+static const ColumnarSensorTable COLUMNAR_SENSOR_TABLES[NUM_COLUMNAR_SENSOR_TABLES] = {
+	{ SENSOR_TYPE_LOCATION, "gps", 3, { "latitude", "longitude", "altitude" } },
+	{ SENSOR_TYPE_ACCELEROMETER, "accelerometer", 3, { "x", "y", "z" } },
+	{ SENSOR_TYPE_HEART_RATE, "hrm", 1, { "value" } },
+	{ SENSOR_TYPE_CADENCE, "cadence", 1, { "value" } },
+	{ SENSOR_TYPE_WHEEL_SPEED, "wheel_speed", 1, { "value" } },
+	{ SENSOR_TYPE_POWER, "power_meter", 1, { "value" } },
+	{ SENSOR_TYPE_FOOT_POD, "foot_pod", 1, { "value" } },
+};
+
+typedef struct ColumnarExportContext
+{
+	Database*                   pDatabase;
+	FileLib::ColumnarFileWriter activityWriter;
+	FileLib::ColumnarFileWriter attributeWriter;
+	FileLib::ColumnarFileWriter sensorWriters[NUM_COLUMNAR_SENSOR_TABLES];
+} ColumnarExportContext;
+
+static bool ExportActivityColumns(const ActivitySummary& summary, void* context)
+{
+	ColumnarExportContext* pContext = (ColumnarExportContext*)context;
+	bool result = true;
+
+	// One row per activity. Column order is the order they were added in ExportHistoryToColumnarFiles.
+	FileLib::ColumnarFileWriter& activityWriter = pContext->activityWriter;
+
+	activityWriter.SetString(0, summary.activityId);
+	activityWriter.SetString(1, summary.userId);
+	activityWriter.SetString(2, summary.type);
+	activityWriter.SetString(3, summary.name);
+	activityWriter.SetString(4, summary.description);
+	activityWriter.SetInt(5, (int64_t)summary.startTime);
+	activityWriter.SetInt(6, (int64_t)summary.endTime);
+	result &= activityWriter.EndRow();
+
+	// One row per summary attribute, since each activity type has a different set.
+	ActivityAttributeMap attributes;
+
+	if (pContext->pDatabase->RetrieveSummaryData(summary.activityId, attributes))
+	{
+		FileLib::ColumnarFileWriter& attributeWriter = pContext->attributeWriter;
+
+		for (auto iter = attributes.begin(); iter != attributes.end(); ++iter)
+		{
+			const ActivityAttributeType& value = iter->second;
+			double temp = (double)0.0;
+
+			switch (value.valueType)
+			{
+				case TYPE_TIME:
+					temp = (double)value.value.timeVal;
+					break;
+				case TYPE_DOUBLE:
+					temp = value.value.doubleVal;
+					break;
+				case TYPE_INTEGER:
+					temp = (double)value.value.intVal;
+					break;
+				case TYPE_NOT_SET:
+				default:
+					continue;
+			}
+
+			attributeWriter.SetString(0, summary.activityId);
+			attributeWriter.SetString(1, iter->first);
+			attributeWriter.SetDouble(2, temp);
+			result &= attributeWriter.EndRow();
+		}
+	}
+
+	// Sensor readings are streamed straight from the database into the writers, which hold at most one row group each.
+	for (size_t tableIndex = 0; tableIndex < NUM_COLUMNAR_SENSOR_TABLES; ++tableIndex)
+	{
+		const ColumnarSensorTable& table = COLUMNAR_SENSOR_TABLES[tableIndex];
+		FileLib::ColumnarFileWriter& sensorWriter = pContext->sensorWriters[tableIndex];
+		SensorCursor cursor;
+
+		if (!pContext->pDatabase->OpenSensorCursor(summary.activityId, table.sensorType, cursor))
+		{
+			continue;
+		}
+		while (cursor.IsValid())
+		{
+			sensorWriter.SetString(0, summary.activityId);
+			sensorWriter.SetInt(1, (int64_t)cursor.Time());
+			for (size_t i = 0; i < table.numValues; ++i)
+			{
+				sensorWriter.SetDouble(2 + i, cursor.Value(i));
+			}
+			result &= sensorWriter.EndRow();
+			cursor.Next();
+		}
+		result &= !cursor.Failed();
+	}
+
+	return result;
+}
+
+bool DataExporter::ExportHistoryToColumnarFiles(Database* const pDatabase, const std::string& dirName, std::vector<std::string>& fileNames)
+{
+	std::unique_ptr<ColumnarExportContext> context(new ColumnarExportContext());
+	std::vector<std::pair<FileLib::ColumnarFileWriter*, std::string>> writers;
+	bool result = true;
+
+	context->pDatabase = pDatabase;
+	fileNames.clear();
+
+	context->activityWriter.AddColumn("activity_id", FileLib::COLUMN_TYPE_STRING);
+	context->activityWriter.AddColumn("user_id", FileLib::COLUMN_TYPE_STRING);
+	context->activityWriter.AddColumn("type", FileLib::COLUMN_TYPE_STRING);
+	context->activityWriter.AddColumn("name", FileLib::COLUMN_TYPE_STRING);
+	context->activityWriter.AddColumn("description", FileLib::COLUMN_TYPE_STRING);
+	context->activityWriter.AddColumn("start_time", FileLib::COLUMN_TYPE_INT64);
+	context->activityWriter.AddColumn("end_time", FileLib::COLUMN_TYPE_INT64);
+	writers.push_back(std::make_pair(&context->activityWriter, std::string("activity")));
+
+	context->attributeWriter.AddColumn("activity_id", FileLib::COLUMN_TYPE_STRING);
+	context->attributeWriter.AddColumn("attribute", FileLib::COLUMN_TYPE_STRING);
+	context->attributeWriter.AddColumn("value", FileLib::COLUMN_TYPE_DOUBLE);
+	writers.push_back(std::make_pair(&context->attributeWriter, std::string("activity_summary")));
+
+	for (size_t tableIndex = 0; tableIndex < NUM_COLUMNAR_SENSOR_TABLES; ++tableIndex)
+	{
+		const ColumnarSensorTable& table = COLUMNAR_SENSOR_TABLES[tableIndex];
+		FileLib::ColumnarFileWriter& sensorWriter = context->sensorWriters[tableIndex];
+
+		sensorWriter.AddColumn("activity_id", FileLib::COLUMN_TYPE_STRING);
+		sensorWriter.AddColumn("time", FileLib::COLUMN_TYPE_INT64);
+		for (size_t i = 0; i < table.numValues; ++i)
+		{
+			sensorWriter.AddColumn(table.valueNames[i], FileLib::COLUMN_TYPE_DOUBLE);
+		}
+		writers.push_back(std::make_pair(&sensorWriter, std::string(table.tableName)));
+	}
+
+	for (auto iter = writers.begin(); result && iter != writers.end(); ++iter)
+	{
+		std::string fileName = dirName + "/" + iter->second + COLUMNAR_FILE_EXTENSION;
+
+		result = iter->first->CreateFile(fileName);
+		if (result)
+		{
+			fileNames.push_back(fileName);
+		}
+	}
+
+	if (result)
+	{
+		result = pDatabase->ProcessAllActivities(ExportActivityColumns, context.get());
+	}
+
+	for (auto iter = writers.begin(); iter != writers.end(); ++iter)
+	{
+		if (iter->first->IsOpen())
+		{
+			result &= iter->first->Close();
+		}
+	}
+	return result;
+}
+
 bool DataExporter::ExportWorkoutFromDatabase(FileFormat format, std::string& fileName, Database* const pDatabase, const std::string& workoutId)
 {
 	bool result = false;
@@ -10,10 +10,13 @@
 
 #include <stdint.h>
 #include <string>
+#include <vector>
 
 #include "Activity.h"
+#include "ActivityExportSinks.h"
 #include "ActivitySummary.h"
 #include "Callbacks.h"
+#include "CompressedStream.h"
 #include "CsvFileWriter.h"
 #include "Database.h"
 #include "MovingActivity.h"
@@ -25,29 +28,35 @@ public:
 	DataExporter();
 	virtual ~DataExporter();
 
+	/// @brief When set, exported files are compressed as they are written and get the matching extension (i.e. ".gpx.gz").
+	void SetCompression(FileLib::CompressionType compression) { m_compression = compression; };
+
 	bool ExportActivityFromDatabase(FileFormat format, std::string& fileName, Database* const pDatabase, const Activity* const pActivity);
+
+	/// @brief Exports the activity to several formats with a single pass over its sensor data, writing each file on its own thread.
+	/// fileNames receives the name of each file, in the same order as the formats, or an empty string for each format that failed.
+	/// Returns FALSE if any of the formats failed.
+	bool ExportActivityFromDatabase(const std::vector<FileFormat>& formats, const std::string& dirName, std::vector<std::string>& fileNames, Database* const pDatabase, const Activity* const pActivity);
 	bool ExportActivityUsingCallbackData(FileFormat format, std::string& fileName, time_t startTime, const std::string& sportType, const std::string& activityId, NextCoordinateCallback nextCoordinateCallback, void* context);
 
 	bool ExportActivitySummary(const ActivitySummaryList& activities, const std::string& activityType, std::string& fileName);
 
+	/// @brief Writes the whole history to columnar files (see ColumnarFileWriter) for bulk analysis: one for the activities,
+	/// one for their summary attributes, and one for each sensor table. Activities are read one at a time, in ID order, so
+	/// memory use doesn't grow with the size of the history. fileNames receives the name of each file that was written.
+	bool ExportHistoryToColumnarFiles(Database* const pDatabase, const std::string& dirName, std::vector<std::string>& fileNames);
+
 	bool ExportWorkoutFromDatabase(FileFormat format, std::string& fileName, Database* const pDatabase, const std::string& workoutId);
 
 protected:
 	bool ExportToTcxUsingCallbacks(const std::string& fileName, time_t startTime, const std::string& activityId, const std::string& activityType, NextCoordinateCallback nextCoordinateCallback, void* context);
 	bool ExportToGpxUsingCallbacks(const std::string& fileName, time_t startTime, const std::string& activityId, NextCoordinateCallback nextCoordinateCallback, void* context);
 
-	bool ExportActivityFromDatabaseToFit(const std::string& fileName, Database* const pDatabase, const Activity* const pActivity);
-	bool ExportActivityFromDatabaseToTcx(const std::string& fileName, Database* const pDatabase, const Activity* const pActivity);
-	bool ExportActivityFromDatabaseToGpx(const std::string& fileName, Database* const pDatabase, const Activity* const pActivity);
-	bool ExportActivityFromDatabaseToCsv(const std::string& fileName, Database* const pDatabase, const Activity* const pActivity);
+	void ReadActivityExportInfo(Database* const pDatabase, const Activity* const pActivity, ExportActivityInfo& info);
+	bool StreamActivityFromDatabase(Database* const pDatabase, const ExportActivityInfo& info, ActivityExportFanOut& fanOut, bool& readingsLoaded);
 
 private:
-	bool NearestSensorReading(uint64_t time, const SensorReadingList& list, SensorReadingList::const_iterator& iter);
-
-	bool ExportPositionDataToCsv(FileLib::CsvFileWriter& writer, const MovingActivity* const pMovingActivity);
-	bool ExportAccelerometerDataToCsv(FileLib::CsvFileWriter& writer, const std::string& activityId, Database* const pDatabase);
-	bool ExportHeartRateDataToCsv(FileLib::CsvFileWriter& writer, const std::string& activityId, Database* const pDatabase);
-	bool ExportCadenceDataToCsv(FileLib::CsvFileWriter& writer, const std::string& activityId, Database* const pDatabase);
+	FileLib::CompressionType m_compression;
 
 	std::string GenerateFileName(FileFormat format, const std::string& name);
 	std::string GenerateFileName(FileFormat format, time_t startTime, const std::string& sportType);
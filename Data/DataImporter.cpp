@@ -8,18 +8,30 @@
 #include "DataImporter.h"
 
 #include "ActivityAttribute.h"
+#include "ActivityHasher.h"
 #include "AxisName.h"
 #include "TcxFileReader.h"
+#include "FitFileReader.h"
 #include "GpxFileReader.h"
 #include "KmlFileReader.h"
+#include "CsvFileReader.h"
+#include "CompressedStream.h"
+#include "ParseUtils.h"
 
+#include <algorithm>
 #include <filesystem>
+#include <strings.h>
 
 DataImporter::DataImporter()
 {
 	m_pDb = NULL;
+	m_pBatch = NULL;
 	m_lastTime = 0;
+	m_lastAltitude = (double)0.0;
 	m_started = false;
+	m_numLaps = 0;
+	m_lapDistance = (double)0.0;
+	m_lapCalories = (double)0.0;
 }
 
 DataImporter::~DataImporter()
@@ -62,6 +74,33 @@ bool OnNewGpxRouteLocation(double lat, double lon, double ele, uint64_t time, vo
 	return false;
 }
 
+bool OnNewFitRecord(const FileLib::FitRecordData& record, void* context)
+{
+	if (context)
+	{
+		return ((DataImporter*)context)->NewFitRecord(record);
+	}
+	return false;
+}
+
+bool OnNewFitLap(const FileLib::FitLapData& lap, void* context)
+{
+	if (context)
+	{
+		return ((DataImporter*)context)->NewFitLap(lap);
+	}
+	return false;
+}
+
+bool OnNewFitRouteRecord(const FileLib::FitRecordData& record, void* context)
+{
+	if (context && record.hasPosition)
+	{
+		return ((DataImporter*)context)->NewFitRouteRecord(record);
+	}
+	return false;
+}
+
 void OnNewActivityType(const char* const activityType, void* context)
 {
 	if (context)
@@ -70,11 +109,108 @@ void OnNewActivityType(const char* const activityType, void* context)
 	}
 }
 
-bool DataImporter::ImportFromFit(const std::string& fileName, const std::string& activityType, const std::string& activityId, Database* pDatabase)
+bool DataImporter::ImportFromFile(const std::string& fileName, const std::string& activityType, const std::string& activityId, Database* pDatabase)
 {
+	// Parse into memory first, so that duplicates can be detected before anything is written.
+	if (pDatabase && !m_pBatch)
+	{
+		ImportBatch batch;
+		std::string duplicateId;
+
+		if (!ImportFromFile(fileName, activityType, activityId, batch))
+		{
+			return false;
+		}
+		return StoreImportBatch(pDatabase, batch, duplicateId) && duplicateId.empty();
+	}
+
+	// Compressed files (i.e. "run.tcx.gz") are handled by the readers, only the underlying format matters here.
+	std::string fileExtension = FileLib::FileExtensionIgnoringCompression(fileName);
+
+	if (fileExtension.compare("gpx") == 0)
+	{
+		return ImportFromGpx(fileName, activityType, activityId, pDatabase);
+	}
+	else if (fileExtension.compare("tcx") == 0)
+	{
+		return ImportFromTcx(fileName, activityType, activityId, pDatabase);
+	}
+	else if (fileExtension.compare("fit") == 0)
+	{
+		return ImportFromFit(fileName, activityType, activityId, pDatabase);
+	}
+	else if (fileExtension.compare("csv") == 0)
+	{
+		return ImportFromCsv(fileName, activityType, activityId, pDatabase);
+	}
 	return false;
 }
 
+bool DataImporter::ImportFromFile(const std::string& fileName, const std::string& activityType, const std::string& activityId, ImportBatch& batch)
+{
+	batch.Clear();
+	batch.activityId = activityId;
+	batch.activityType = activityType;
+	batch.fileName = fileName;
+
+	m_pBatch = &batch;
+	bool result = ImportFromFile(fileName, activityType, activityId, (Database*)NULL);
+	m_pBatch = NULL;
+
+	// An activity without any data isn't worth storing.
+	if (!(result && batch.started))
+	{
+		return false;
+	}
+
+	// Activities without locations would all have the same hash, so they don't get one.
+	if (batch.locationTimes.size() > 0)
+	{
+		batch.hash = ActivityHasher::HashImportBatch(batch);
+	}
+	return true;
+}
+
+bool DataImporter::StoreImportBatch(Database* pDatabase, const ImportBatch& batch, std::string& duplicateId)
+{
+	duplicateId.clear();
+
+	if (batch.hash.size() > 0 && pDatabase->RetrieveActivityIdFromHash(batch.hash, duplicateId))
+	{
+		return true;
+	}
+	duplicateId.clear();
+	return pDatabase->CreateImportedActivity(batch);
+}
+
+bool DataImporter::ImportFromFit(const std::string& fileName, const std::string& activityType, const std::string& activityId, Database* pDatabase)
+{
+	bool result = false;
+	FileLib::FitFileReader reader;
+
+	m_pDb = pDatabase;
+	m_activityType = activityType;
+	m_activityId = activityId;
+	m_started = false;
+	m_lastTime = 0;
+	m_lastAltitude = (double)0.0;
+	m_numLaps = 0;
+	m_lapDistance = (double)0.0;
+	m_lapCalories = (double)0.0;
+
+	reader.SetActivityTypeCallback(OnNewActivityType, this);
+	reader.SetNewRecordCallback(OnNewFitRecord, this);
+	reader.SetNewLapCallback(OnNewFitLap, this);
+	result = reader.ParseFile(fileName);
+
+	if (result && HasDestination() && (m_lastTime > 0))
+	{
+		time_t endTimeSecs = (time_t)(m_lastTime / 1000);
+		result = StoreActivityEnd(endTimeSecs);
+	}
+	return result;
+}
+
 bool DataImporter::ImportFromTcx(const std::string& fileName, const std::string& activityType, const std::string& activityId, Database* pDatabase)
 {
 	bool result = false;
@@ -90,10 +226,10 @@ bool DataImporter::ImportFromTcx(const std::string& fileName, const std::string&
 	reader.SetNewLocationCallback(OnNewTcxLocation, this);
 	result = reader.ParseFile(fileName);
 
-	if (result && m_pDb && (m_lastTime > 0))
+	if (result && HasDestination() && (m_lastTime > 0))
 	{
 		time_t endTimeSecs = (time_t)(m_lastTime / 1000);
-		result = m_pDb->StopActivity(endTimeSecs, m_activityId);
+		result = StoreActivityEnd(endTimeSecs);
 	}
 	return result;
 }
@@ -113,87 +249,61 @@ bool DataImporter::ImportFromGpx(const std::string& fileName, const std::string&
 	reader.SetNewLocationCallback(OnNewGpxLocation, this);
 	result = reader.ParseFile(fileName);
 
-	if (result && m_pDb && (m_lastTime > 0))
+	if (result && HasDestination() && (m_lastTime > 0))
 	{
 		time_t endTimeSecs = (time_t)(m_lastTime / 1000);
-		result = m_pDb->StopActivity(endTimeSecs, m_activityId);
+		result = StoreActivityEnd(endTimeSecs);
 	}
 	return result;
 }
 
-template<char delimiter>
-class ColumnDelimiter : public std::string
-{
-};
-
-std::istream& operator>>(std::istream& is, ColumnDelimiter<','>& output)
+bool OnNewCsvRow(const std::vector<std::string_view>& fields, void* context)
 {
-   std::getline(is, output, ',');
-   return is;
+	if (context)
+	{
+		return ((DataImporter*)context)->NewCsvRow(fields);
+	}
+	return false;
 }
 
 bool DataImporter::ImportFromCsv(const std::string& fileName, const std::string& activityType, const std::string& activityId, Database* pDatabase)
 {
 	bool result = false;
+	FileLib::CsvFileReader reader;
+	ImportBatch batch;
 
 	m_pDb = pDatabase;
 	m_activityType = activityType;
 	m_activityId = activityId;
 	m_started = false;
 	m_lastTime = 0;
+	m_csvColumns.clear();
 
-	std::ifstream in(fileName);
-	std::string str;
-
-	while (std::getline(in, str))
+	// CSV files are mostly sensor data, so when writing straight to the database collect everything first and
+	// store it in a single transaction rather than a statement per value.
+	bool useOwnBatch = (m_pDb != NULL) && (m_pBatch == NULL);
+	if (useOwnBatch)
 	{
-		std::istringstream iss(str);
-		std::vector<std::string> results((std::istream_iterator<ColumnDelimiter<','>>(iss)), std::istream_iterator<ColumnDelimiter<','>>());
-
-		if (results.size() == 4)
-		{
-			time_t ts = atol(results[0].c_str());
-			
-			if (ts > 0) // Skip rows with an invalid timestamp.
-			{
-				double x = atof(results[1].c_str());
-				double y = atof(results[2].c_str());
-				double z = atof(results[3].c_str());
-
-				if (!m_started)
-				{
-					if (m_pDb)
-					{
-						time_t startTimeSecs = (time_t)(ts / 1000);
-						result = m_pDb->StartActivity(m_activityId, "", m_activityType, "", startTimeSecs);
-					}
-					m_started = true;
-				}
-
-				if (m_pDb)
-				{
-					SensorReading reading;
-
-					reading.time = ts;
-					reading.type = SENSOR_TYPE_ACCELEROMETER;
-					reading.reading.insert(SensorNameValuePair(AXIS_NAME_X, x));
-					reading.reading.insert(SensorNameValuePair(AXIS_NAME_Y, y));
-					reading.reading.insert(SensorNameValuePair(AXIS_NAME_Z, z));
-
-					result = m_pDb->CreateSensorReading(m_activityId, reading);
-					
-					m_lastTime = ts;
-				}
-			}
-		}
+		batch.activityId = activityId;
+		batch.activityType = activityType;
+		batch.fileName = fileName;
+		m_pBatch = &batch;
 	}
 
-	if (m_pDb)
+	reader.SetNewRowCallback(OnNewCsvRow, this);
+	result = reader.ParseFile(fileName) && m_started;
+
+	if (result && HasDestination())
 	{
 		time_t endTimeSecs = (time_t)(m_lastTime / 1000);
-		result = m_pDb->StopActivity(endTimeSecs, m_activityId);
+		result = StoreActivityEnd(endTimeSecs);
 	}
 
+	if (useOwnBatch)
+	{
+		m_pBatch = NULL;
+		result = result && m_pDb->CreateImportedActivity(batch);
+	}
 	return result;
 }
 
@@ -204,6 +314,7 @@ bool DataImporter::ImportRouteFromKml(const std::string& fileName, const std::st
 	m_pDb = pDatabase;
 	m_started = false;
 	m_routeId = routeId;
+	m_routeCoordinates.clear();
 
 	return reader.ParseFile(fileName);
 }
@@ -216,11 +327,12 @@ bool DataImporter::ImportRouteFromGpx(const std::string& fileName, const std::st
 	m_pDb = pDatabase;
 	m_started = false;
 	m_routeId = routeId;
+	m_routeCoordinates.clear();
 
 	std::string fileNameOnly = std::filesystem::path(fileName).filename();
 	pDatabase->CreateRoute(routeId, fileNameOnly, "");
 	reader.SetNewLocationCallback(OnNewGpxRouteLocation, this);
-	result = reader.ParseFile(fileName);
+	result = reader.ParseFile(fileName) && StoreRouteCoordinates();
 	return result;
 }
 
@@ -232,17 +344,32 @@ bool DataImporter::ImportRouteFromTcx(const std::string& fileName, const std::st
 	m_pDb = pDatabase;
 	m_started = false;
 	m_routeId = routeId;
+	m_routeCoordinates.clear();
 
 	std::string fileNameOnly = std::filesystem::path(fileName).filename();
 	pDatabase->CreateRoute(routeId, fileNameOnly, "");
 	reader.SetNewLocationCallback(OnNewTcxRouteLocation, this);
-	result = reader.ParseFile(fileName);
+	result = reader.ParseFile(fileName) && StoreRouteCoordinates();
 	return result;
 }
 
 bool DataImporter::ImportRouteFromFit(const std::string& fileName, const std::string& routeId, Database* pDatabase)
 {
-	return false;
+	bool result = false;
+	FileLib::FitFileReader reader;
+
+	m_pDb = pDatabase;
+	m_started = false;
+	m_lastAltitude = (double)0.0;
+	m_routeId = routeId;
+	m_routeCoordinates.clear();
+
+	// Courses use the same record messages as activities, only the positions matter here.
+	std::string fileNameOnly = std::filesystem::path(fileName).filename();
+	pDatabase->CreateRoute(routeId, fileNameOnly, "");
+	reader.SetNewRecordCallback(OnNewFitRouteRecord, this);
+	result = reader.ParseFile(fileName) && StoreRouteCoordinates();
+	return result;
 }
 
 bool DataImporter::NewLocation(double lat, double lon, double ele, double hr, double power, double cadence, uint64_t time)
@@ -251,16 +378,16 @@ bool DataImporter::NewLocation(double lat, double lon, double ele, double hr, do
 
 	if (!m_started)
 	{
-		if (m_pDb)
+		if (HasDestination())
 		{
 			time_t startTimeSecs = (time_t)(time / 1000);
 
-			result = m_pDb->StartActivity(m_activityId, "", m_activityType, "", startTimeSecs);
+			result = StoreActivityStart(startTimeSecs);
 		}
 		m_started = true;
 	}
 
-	if (m_pDb)
+	if (HasDestination())
 	{
 		SensorReading locationReading;
 
@@ -269,34 +396,19 @@ bool DataImporter::NewLocation(double lat, double lon, double ele, double hr, do
 		locationReading.reading.insert(SensorNameValuePair(ACTIVITY_ATTRIBUTE_LATITUDE, lat));
 		locationReading.reading.insert(SensorNameValuePair(ACTIVITY_ATTRIBUTE_LONGITUDE, lon));
 		locationReading.reading.insert(SensorNameValuePair(ACTIVITY_ATTRIBUTE_ALTITUDE, ele));
-		result = m_pDb->CreateSensorReading(m_activityId, locationReading);
+		result = StoreSensorReading(locationReading);
 
 		if (hr >= (double)0.0)
 		{
-			SensorReading hrReading;
-
-			hrReading.type = SENSOR_TYPE_HEART_RATE;
-			hrReading.reading.insert(SensorNameValuePair(ACTIVITY_ATTRIBUTE_HEART_RATE, hr));
-			hrReading.time = time;
-			result = m_pDb->CreateSensorReading(m_activityId, hrReading);
+			result = StoreSensorValue(SENSOR_TYPE_HEART_RATE, ACTIVITY_ATTRIBUTE_HEART_RATE, hr, time);
 		}
 		if (power >= (double)0.0)
 		{
-			SensorReading powerReading;
-
-			powerReading.type = SENSOR_TYPE_HEART_RATE;
-			powerReading.reading.insert(SensorNameValuePair(ACTIVITY_ATTRIBUTE_POWER, power));
-			powerReading.time = time;
-			result = m_pDb->CreateSensorReading(m_activityId, powerReading);
+			result = StoreSensorValue(SENSOR_TYPE_POWER, ACTIVITY_ATTRIBUTE_POWER, power, time);
 		}
 		if (cadence >= (double)0.0)
 		{
-			SensorReading cadenceReading;
-
-			cadenceReading.type = SENSOR_TYPE_HEART_RATE;
-			cadenceReading.reading.insert(SensorNameValuePair(ACTIVITY_ATTRIBUTE_CADENCE, cadence));
-			cadenceReading.time = time;
-			result = m_pDb->CreateSensorReading(m_activityId, cadenceReading);
+			result = StoreSensorValue(SENSOR_TYPE_CADENCE, ACTIVITY_ATTRIBUTE_CADENCE, cadence, time);
 		}
 	}
 
@@ -316,8 +428,237 @@ bool DataImporter::NewRouteLocation(double lat, double lon, double ele)
 		coordinate.latitude = lat;
 		coordinate.longitude = lon;
 		coordinate.altitude = ele;
-		result = m_pDb->CreateRoutePoint(m_routeId, coordinate);
+		coordinate.horizontalAccuracy = (double)0.0;
+		coordinate.verticalAccuracy = (double)0.0;
+		m_routeCoordinates.push_back(coordinate);
+		result = true;
+	}
+	return result;
+}
+
+bool DataImporter::StoreRouteCoordinates(void)
+{
+	bool result = false;
+
+	// Courses can have tens of thousands of points, so rather than a row for each, the route is encoded into a
+	// handful of rows at different resolutions.
+	if (m_pDb && !m_routeCoordinates.empty())
+	{
+		result = m_pDb->CreateRoutePolylines(m_routeId, m_routeCoordinates);
 	}
+	m_routeCoordinates.clear();
+	return result;
+}
+
+bool DataImporter::StartActivityIfNeeded(uint64_t time)
+{
+	bool result = true;
+
+	if (!m_started)
+	{
+		if (HasDestination())
+		{
+			time_t startTimeSecs = (time_t)(time / 1000);
+
+			result = StoreActivityStart(startTimeSecs);
+		}
+		m_started = true;
+	}
+	return result;
+}
+
+bool DataImporter::NewFitRecord(const FileLib::FitRecordData& record)
+{
+	// Records with a position look just like a TCX track point.
+	if (record.hasPosition)
+	{
+		return NewLocation(record.latitude, record.longitude, FitRecordAltitude(record), record.heartRate, record.power, record.cadence, record.timestampMs);
+	}
+
+	// Indoor activities have no position, but the sensor data is still worth keeping.
+	bool result = StartActivityIfNeeded(record.timestampMs);
+
+	if (HasDestination())
+	{
+		if (record.heartRate >= (double)0.0)
+		{
+			result = StoreSensorValue(SENSOR_TYPE_HEART_RATE, ACTIVITY_ATTRIBUTE_HEART_RATE, record.heartRate, record.timestampMs);
+		}
+		if (record.power >= (double)0.0)
+		{
+			result = StoreSensorValue(SENSOR_TYPE_POWER, ACTIVITY_ATTRIBUTE_POWER, record.power, record.timestampMs);
+		}
+		if (record.cadence >= (double)0.0)
+		{
+			result = StoreSensorValue(SENSOR_TYPE_CADENCE, ACTIVITY_ATTRIBUTE_CADENCE, record.cadence, record.timestampMs);
+		}
+	}
+
+	m_lastTime = record.timestampMs;
+	return result;
+}
+
+bool DataImporter::NewFitRouteRecord(const FileLib::FitRecordData& record)
+{
+	return NewRouteLocation(record.latitude, record.longitude, FitRecordAltitude(record));
+}
+
+/// Records don't always include the altitude, in which case the last one we saw still applies.
+/// Until the first one shows up we use zero, same as a TCX track point without an altitude.
+double DataImporter::FitRecordAltitude(const FileLib::FitRecordData& record)
+{
+	if (record.hasAltitude)
+	{
+		m_lastAltitude = record.altitude;
+	}
+	return m_lastAltitude;
+}
+
+bool DataImporter::NewFitLap(const FileLib::FitLapData& lap)
+{
+	bool result = true;
+
+	// We only store where each lap after the first one begins, the first lap starts with the activity.
+	if (HasDestination() && m_started && lap.startTimeMs > 0 && m_numLaps > 0)
+	{
+		LapSummary summary;
+
+		summary.startTimeMs = lap.startTimeMs;
+		summary.startingDistanceMeters = m_lapDistance;
+		summary.startingCalorieCount = m_lapCalories;
+		result = StoreLap(summary);
+	}
+
+	++m_numLaps;
+	if (lap.totalDistance > (double)0.0)
+		m_lapDistance += lap.totalDistance;
+	if (lap.totalCalories > (double)0.0)
+		m_lapCalories += lap.totalCalories;
+	return result;
+}
+
+typedef struct CsvColumnTitle
+{
+	const char* title;
+	CsvColumn   column;
+} CsvColumnTitle;
+
+// Titles written by the CSV exporter, plus a few common alternatives for the time column.
+static const CsvColumnTitle CSV_COLUMN_TITLES[] = {
+	{ ACTIVITY_ATTRIBUTE_ELAPSED_TIME, CSV_COLUMN_TIME },
+	{ "Time", CSV_COLUMN_TIME },
+	{ "Timestamp", CSV_COLUMN_TIME },
+	{ ACTIVITY_ATTRIBUTE_LATITUDE, CSV_COLUMN_LATITUDE },
+	{ ACTIVITY_ATTRIBUTE_LONGITUDE, CSV_COLUMN_LONGITUDE },
+	{ ACTIVITY_ATTRIBUTE_ALTITUDE, CSV_COLUMN_ALTITUDE },
+	{ ACTIVITY_ATTRIBUTE_HEART_RATE, CSV_COLUMN_HEART_RATE },
+	{ ACTIVITY_ATTRIBUTE_POWER, CSV_COLUMN_POWER },
+	{ ACTIVITY_ATTRIBUTE_CADENCE, CSV_COLUMN_CADENCE },
+	{ ACTIVITY_ATTRIBUTE_X, CSV_COLUMN_X },
+	{ ACTIVITY_ATTRIBUTE_Y, CSV_COLUMN_Y },
+	{ ACTIVITY_ATTRIBUTE_Z, CSV_COLUMN_Z },
+};
+
+void DataImporter::MapCsvColumns(const std::vector<std::string_view>& titles)
+{
+	m_csvColumns.assign(titles.size(), CSV_COLUMN_UNKNOWN);
+
+	for (size_t i = 0; i < titles.size(); ++i)
+	{
+		std::string_view title = titles.at(i);
+
+		while (title.size() > 0 && isspace((unsigned char)title.front()))
+			title.remove_prefix(1);
+		while (title.size() > 0 && isspace((unsigned char)title.back()))
+			title.remove_suffix(1);
+
+		for (const CsvColumnTitle& columnTitle : CSV_COLUMN_TITLES)
+		{
+			if (strlen(columnTitle.title) == title.size() && strncasecmp(columnTitle.title, title.data(), title.size()) == 0)
+			{
+				m_csvColumns.at(i) = columnTitle.column;
+				break;
+			}
+		}
+	}
+}
+
+bool DataImporter::NewCsvRow(const std::vector<std::string_view>& fields)
+{
+	double values[CSV_COLUMN_COUNT];
+	bool present[CSV_COLUMN_COUNT] = { false };
+	double firstValue = (double)0.0;
+
+	// Files written by the exporter contain several sections (position, accelerometer, heart rate, etc.),
+	// each starting with its own title row. Anything that doesn't start with a number is treated as a title row.
+	if (fields.size() == 0 || !FileLib::ParseDouble(fields.at(0).data(), fields.at(0).size(), firstValue))
+	{
+		MapCsvColumns(fields);
+		return true;
+	}
+
+	// Older accelerometer files don't have titles, just time, x, y, and z.
+	if (m_csvColumns.size() == 0 && fields.size() == 4)
+	{
+		m_csvColumns = { CSV_COLUMN_TIME, CSV_COLUMN_X, CSV_COLUMN_Y, CSV_COLUMN_Z };
+	}
+
+	// Empty or unparseable fields are treated as missing.
+	for (size_t i = 0; i < fields.size() && i < m_csvColumns.size(); ++i)
+	{
+		CsvColumn column = m_csvColumns.at(i);
+
+		if (column != CSV_COLUMN_UNKNOWN)
+		{
+			present[column] = FileLib::ParseDouble(fields.at(i).data(), fields.at(i).size(), values[column]);
+		}
+	}
+
+	// Skip rows with an invalid timestamp.
+	if (!present[CSV_COLUMN_TIME] || values[CSV_COLUMN_TIME] <= (double)0.0)
+	{
+		return true;
+	}
+
+	uint64_t time = (uint64_t)values[CSV_COLUMN_TIME];
+	uint64_t lastTime = std::max(time, m_lastTime); // Each section starts over at the beginning of the activity
+	bool result = true;
+
+	if (present[CSV_COLUMN_LATITUDE] && present[CSV_COLUMN_LONGITUDE])
+	{
+		result = NewLocation(values[CSV_COLUMN_LATITUDE],
+			values[CSV_COLUMN_LONGITUDE],
+			present[CSV_COLUMN_ALTITUDE] ? values[CSV_COLUMN_ALTITUDE] : (double)0.0,
+			present[CSV_COLUMN_HEART_RATE] ? values[CSV_COLUMN_HEART_RATE] : TCX_VALUE_NOT_SET,
+			present[CSV_COLUMN_POWER] ? values[CSV_COLUMN_POWER] : TCX_VALUE_NOT_SET,
+			present[CSV_COLUMN_CADENCE] ? values[CSV_COLUMN_CADENCE] : TCX_VALUE_NOT_SET,
+			time);
+	}
+	else
+	{
+		result = StartActivityIfNeeded(time);
+
+		if (present[CSV_COLUMN_HEART_RATE])
+			result &= StoreSensorValue(SENSOR_TYPE_HEART_RATE, ACTIVITY_ATTRIBUTE_HEART_RATE, values[CSV_COLUMN_HEART_RATE], time);
+		if (present[CSV_COLUMN_POWER])
+			result &= StoreSensorValue(SENSOR_TYPE_POWER, ACTIVITY_ATTRIBUTE_POWER, values[CSV_COLUMN_POWER], time);
+		if (present[CSV_COLUMN_CADENCE])
+			result &= StoreSensorValue(SENSOR_TYPE_CADENCE, ACTIVITY_ATTRIBUTE_CADENCE, values[CSV_COLUMN_CADENCE], time);
+	}
+
+	if (present[CSV_COLUMN_X] && present[CSV_COLUMN_Y] && present[CSV_COLUMN_Z])
+	{
+		SensorReading reading;
+
+		reading.time = time;
+		reading.type = SENSOR_TYPE_ACCELEROMETER;
+		reading.reading.insert(SensorNameValuePair(AXIS_NAME_X, values[CSV_COLUMN_X]));
+		reading.reading.insert(SensorNameValuePair(AXIS_NAME_Y, values[CSV_COLUMN_Y]));
+		reading.reading.insert(SensorNameValuePair(AXIS_NAME_Z, values[CSV_COLUMN_Z]));
+		result &= StoreSensorReading(reading);
+	}
+
+	m_lastTime = lastTime;
 	return result;
 }
 
@@ -326,8 +667,80 @@ void DataImporter::SetActivityType(const std::string& activityType)
 	m_activityType = activityType;
 	
 	// If we already created the activity in the database then update.
-	if (m_started && m_pDb)
+	if (m_pBatch)
+	{
+		m_pBatch->activityType = m_activityType;
+	}
+	else if (m_started && m_pDb)
 	{
 		m_pDb->UpdateActivityType(m_activityId, m_activityType);
 	}
 }
+
+bool DataImporter::StoreActivityStart(time_t startTimeSecs)
+{
+	if (m_pBatch)
+	{
+		m_pBatch->activityType = m_activityType;
+		m_pBatch->startTime = startTimeSecs;
+		m_pBatch->endTime = 0;
+		m_pBatch->started = true;
+		return true;
+	}
+	if (m_pDb)
+	{
+		return m_pDb->StartActivity(m_activityId, "", m_activityType, "", startTimeSecs);
+	}
+	return false;
+}
+
+bool DataImporter::StoreActivityEnd(time_t endTimeSecs)
+{
+	if (m_pBatch)
+	{
+		m_pBatch->endTime = endTimeSecs;
+		return true;
+	}
+	if (m_pDb)
+	{
+		return m_pDb->StopActivity(endTimeSecs, m_activityId);
+	}
+	return false;
+}
+
+bool DataImporter::StoreSensorReading(const SensorReading& reading)
+{
+	if (m_pBatch)
+	{
+		return m_pBatch->AddSensorReading(reading);
+	}
+	if (m_pDb)
+	{
+		return m_pDb->CreateSensorReading(m_activityId, reading);
+	}
+	return false;
+}
+
+bool DataImporter::StoreSensorValue(SensorType type, const char* const name, double value, uint64_t time)
+{
+	SensorReading reading;
+
+	reading.type = type;
+	reading.reading.insert(SensorNameValuePair(name, value));
+	reading.time = time;
+	return StoreSensorReading(reading);
+}
+
+bool DataImporter::StoreLap(const LapSummary& lap)
+{
+	if (m_pBatch)
+	{
+		m_pBatch->laps.push_back(lap);
+		return true;
+	}
+	if (m_pDb)
+	{
+		return m_pDb->CreateLap(m_activityId, lap);
+	}
+	return false;
+}
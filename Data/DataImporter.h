@@ -9,16 +9,48 @@
 #define __DATAIMPORTER__
 
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "Database.h"
+#include "ImportBatch.h"
+#include "FitFileReader.h"
 #include "KmlFileReader.h"
 
+// What a column of a CSV file holds, determined from its title row.
+typedef enum CsvColumn
+{
+	CSV_COLUMN_UNKNOWN = 0,
+	CSV_COLUMN_TIME,
+	CSV_COLUMN_LATITUDE,
+	CSV_COLUMN_LONGITUDE,
+	CSV_COLUMN_ALTITUDE,
+	CSV_COLUMN_HEART_RATE,
+	CSV_COLUMN_POWER,
+	CSV_COLUMN_CADENCE,
+	CSV_COLUMN_X,
+	CSV_COLUMN_Y,
+	CSV_COLUMN_Z,
+	CSV_COLUMN_COUNT
+} CsvColumn;
+
 class DataImporter
 {
 public:
 	DataImporter();
 	virtual ~DataImporter();
 
+	/// @brief Imports the activity into the database, the format is determined from the file extension.
+	/// Returns FALSE without storing anything if the same activity has already been stored.
+	bool ImportFromFile(const std::string& fileName, const std::string& activityType, const std::string& activityId, Database* pDatabase);
+
+	/// @brief Parses the activity into memory without touching the database, so it can be done on any thread.
+	bool ImportFromFile(const std::string& fileName, const std::string& activityType, const std::string& activityId, ImportBatch& batch);
+
+	/// @brief Writes a parsed activity to the database, unless an activity with the same hash is already stored.
+	/// In that case nothing is written, duplicateId is set to the existing activity, and the result is TRUE.
+	static bool StoreImportBatch(Database* pDatabase, const ImportBatch& batch, std::string& duplicateId);
+
 	bool ImportFromFit(const std::string& fileName, const std::string& activityType, const std::string& activityId, Database* pDatabase);
 	bool ImportFromTcx(const std::string& fileName, const std::string& activityType, const std::string& activityId, Database* pDatabase);
 	bool ImportFromGpx(const std::string& fileName, const std::string& activityType, const std::string& activityId, Database* pDatabase);
@@ -31,16 +63,39 @@ public:
 
 	bool NewLocation(double lat, double lon, double ele, double hr, double power, double cadence, uint64_t time);
 	bool NewRouteLocation(double lat, double lon, double ele);
+	bool NewFitRecord(const FileLib::FitRecordData& record);
+	bool NewFitRouteRecord(const FileLib::FitRecordData& record);
+	bool NewFitLap(const FileLib::FitLapData& lap);
+	bool NewCsvRow(const std::vector<std::string_view>& fields);
 
 	void SetActivityType(const std::string& activityType);
 
 protected:
-	Database*   m_pDb;
-	std::string m_activityType;
-	std::string m_activityId;
-	std::string m_routeId;
-	uint64_t    m_lastTime;
-	bool        m_started;
+	Database*              m_pDb;
+	ImportBatch*           m_pBatch; // When set, activity data is collected here instead of being written to m_pDb
+	std::string            m_activityType;
+	std::string            m_activityId;
+	std::string            m_routeId;
+	CoordinateList         m_routeCoordinates; // Collected while parsing a route, then stored all at once
+	uint64_t               m_lastTime;
+	double                 m_lastAltitude; // FIT records may omit the altitude, so the previous one is carried forward
+	bool                   m_started;
+	size_t                 m_numLaps;
+	double                 m_lapDistance; // Running totals, FIT laps only store their own distance and calories
+	double                 m_lapCalories;
+	std::vector<CsvColumn> m_csvColumns; // Meaning of each CSV column, from the most recent title row
+
+	bool StartActivityIfNeeded(uint64_t time);
+	double FitRecordAltitude(const FileLib::FitRecordData& record);
+	void MapCsvColumns(const std::vector<std::string_view>& titles);
+
+	bool HasDestination(void) const { return m_pDb || m_pBatch; };
+	bool StoreActivityStart(time_t startTimeSecs);
+	bool StoreActivityEnd(time_t endTimeSecs);
+	bool StoreSensorReading(const SensorReading& reading);
+	bool StoreSensorValue(SensorType type, const char* const name, double value, uint64_t time);
+	bool StoreLap(const LapSummary& lap);
+	bool StoreRouteCoordinates(void);
 };
 
 #endif
@@ -8,10 +8,15 @@
 #include "Database.h"
 #include "ActivityAttribute.h"
 #include "AxisName.h"
+#include "RoutePolyline.h"
 
+#include <algorithm>
 #include <iostream>
 #include <stdlib.h>
 
+#define MAX_ROWS_PER_INSERT 100 // Rows per multi-row insert statement when bulk importing
+#define MAX_PARAMS_PER_INSERT 999 // SQLITE_MAX_VARIABLE_NUMBER on older versions of SQLite
+
 Database::Database()
 {
 	m_pDb = NULL;
@@ -25,7 +30,20 @@ Database::~Database()
 
 bool Database::Open(const std::string& dbFileName)
 {
-	return (sqlite3_open(dbFileName.c_str(), &m_pDb) == SQLITE_OK);
+	if (sqlite3_open(dbFileName.c_str(), &m_pDb) != SQLITE_OK)
+	{
+		return false;
+	}
+
+	// With a write ahead log, the read only connections used by background jobs and exports don't keep the recorder
+	// from writing sensor data, and the recorder doesn't keep them from reading. In-memory databases just ignore this.
+	ExecuteQuery("pragma journal_mode=WAL");
+	return true;
+}
+
+bool Database::OpenReadOnly(const std::string& dbFileName)
+{
+	return (sqlite3_open_v2(dbFileName.c_str(), &m_pDb, SQLITE_OPEN_READONLY, NULL) == SQLITE_OK);
 }
 
 bool Database::Close(void)
@@ -40,6 +58,22 @@ bool Database::Close(void)
 	return result;
 }
 
+std::string Database::GetFileName(void) const
+{
+	const char* fileName = m_pDb ? sqlite3_db_filename(m_pDb, "main") : NULL;
+
+	if (fileName)
+	{
+		return fileName;
+	}
+	return "";
+}
+
+bool Database::SetBusyTimeout(int timeoutMs)
+{
+	return m_pDb && (sqlite3_busy_timeout(m_pDb, timeoutMs) == SQLITE_OK);
+}
+
 bool Database::DoesTableHaveColumn(const std::string& tableName, const std::string& columnName)
 {
 	bool result = false;
@@ -234,9 +268,139 @@ bool Database::CreateTables(void)
 		sql = "create table route_coordinate (id integer primary key, route_id text, latitude double, longitude double, altitude double)";
 		queries.push_back(sql);
 	}
+	if (!DoesTableExist("heat_map_cell"))
+	{
+		sql = "create table heat_map_cell (cell integer primary key, count integer)";
+		queries.push_back(sql);
+	}
+	if (!DoesTableExist("heat_map_activity"))
+	{
+		sql = "create table heat_map_activity (activity_id text primary key)";
+		queries.push_back(sql);
+	}
+	if (!DoesTableExist("route_polyline"))
+	{
+		sql = "create table route_polyline (id integer primary key, route_id text, tolerance double, num_points integer, coordinates blob)";
+		queries.push_back(sql);
+		sql = "create index route_polyline_index on route_polyline (route_id)";
+		queries.push_back(sql);
+	}
+	if (!DoesTableExist("activity_snapshot"))
+	{
+		sql = "create table activity_snapshot (id integer primary key, activity_id text, version integer, state blob, unique(activity_id) on conflict replace)";
+		queries.push_back(sql);
+	}
+	if (!DoesTableExist("geo_index_activity"))
+	{
+		sql = "create table geo_index_activity (id integer primary key, activity_id text unique, start_time unsigned big int, end_time unsigned big int)";
+		queries.push_back(sql);
+	}
+	if (!DoesTableExist("geo_index_chunk"))
+	{
+		sql = "create table geo_index_chunk (id integer primary key, activity_id text, chunk_num integer, first_row integer, last_row integer, start_time unsigned big int, end_time unsigned big int)";
+		queries.push_back(sql);
+		sql = "create index geo_index_chunk_index on geo_index_chunk (activity_id)";
+		queries.push_back(sql);
+	}
+	if (!DoesTableExist("best_effort"))
+	{
+		sql = "create table best_effort (id integer primary key, activity_id text, activity_type text, distance double, elapsed_ms unsigned big int, start_time unsigned big int)";
+		queries.push_back(sql);
+		sql = "create index best_effort_record_index on best_effort (activity_type, distance, elapsed_ms)";
+		queries.push_back(sql);
+		sql = "create index best_effort_activity_index on best_effort (activity_id)";
+		queries.push_back(sql);
+	}
+	if (!DoesTableExist("best_effort_activity"))
+	{
+		sql = "create table best_effort_activity (activity_id text primary key)";
+		queries.push_back(sql);
+	}
+	if (!DoesTableExist("best_effort_distance"))
+	{
+		sql = "create table best_effort_distance (distance double primary key)";
+		queries.push_back(sql);
+	}
+	if (!DoesTableExist("personal_record"))
+	{
+		sql = "create table personal_record (activity_type text, distance double, activity_id text, elapsed_ms unsigned big int, start_time unsigned big int, primary key (activity_type, distance))";
+		queries.push_back(sql);
+	}
+	if (!DoesTableExist("training_load_activity"))
+	{
+		sql = "create table training_load_activity (activity_id text primary key, activity_type text, start_time unsigned big int, end_time unsigned big int, day big int, distance double, stress double)";
+		queries.push_back(sql);
+		sql = "create index training_load_activity_day_index on training_load_activity (day)";
+		queries.push_back(sql);
+		sql = "create index training_load_activity_start_index on training_load_activity (start_time)";
+		queries.push_back(sql);
+	}
+	if (!DoesTableExist("training_load_day"))
+	{
+		sql = "create table training_load_day (day integer primary key, stress double, ctl double, atl double, tsb double)";
+		queries.push_back(sql);
+	}
+	if (!DoesTableExist("zone_time_activity"))
+	{
+		sql = "create table zone_time_activity (activity_id text, day big int, week big int, zone_type integer, zone integer, seconds double, primary key (activity_id, zone_type, zone))";
+		queries.push_back(sql);
+		sql = "create index zone_time_activity_day_index on zone_time_activity (day)";
+		queries.push_back(sql);
+	}
+	if (!DoesTableExist("zone_time_week"))
+	{
+		sql = "create table zone_time_week (week integer, zone_type integer, zone integer, seconds double, primary key (week, zone_type, zone))";
+		queries.push_back(sql);
+	}
+	if (!DoesTableExist("power_curve"))
+	{
+		sql = "create table power_curve (activity_id text, duration integer, watts double, primary key (activity_id, duration))";
+		queries.push_back(sql);
+	}
+	if (!DoesTableExist("activity_summary_version"))
+	{
+		sql = "create table activity_summary_version (activity_id text primary key, version integer)";
+		queries.push_back(sql);
+	}
 
 	int result = ExecuteQueries(queries);
-	return (result == SQLITE_OK || result == SQLITE_DONE);
+	bool created = (result == SQLITE_OK || result == SQLITE_DONE);
+
+	// The bounding boxes go in R*Trees, keyed by the row id of the matching geo_index_activity, geo_index_chunk, or
+	// full resolution route_polyline row. R*Tree is an optional part of SQLite, so fall back to ordinary tables with
+	// the same columns, which answer the same queries by scanning.
+	const char* boxTables[] = { "geo_index_activity_box", "geo_index_chunk_box", "route_box" };
+
+	for (size_t i = 0; created && i < sizeof(boxTables) / sizeof(boxTables[0]); ++i)
+	{
+		if (!DoesTableExist(boxTables[i]))
+		{
+			std::string tableName = boxTables[i];
+
+			result = ExecuteQuery("create virtual table " + tableName + " using rtree(id, min_lat, max_lat, min_lon, max_lon)");
+			if (result != SQLITE_OK && result != SQLITE_DONE)
+			{
+				result = ExecuteQuery("create table " + tableName + " (id integer primary key, min_lat double, max_lat double, min_lon double, max_lon double)");
+			}
+			created = (result == SQLITE_OK || result == SQLITE_DONE);
+		}
+	}
+
+	// Lets RetrieveBestSummaryValue read just the activities of the given types in the given time range. Databases made
+	// before this index existed already have the activity table, so it is created on its own.
+	if (created)
+	{
+		result = ExecuteQuery("create index if not exists activity_type_start_index on activity (type, start_time)");
+		created = (result == SQLITE_OK || result == SQLITE_DONE);
+	}
+
+	// Duplicate detection looks activities up by hash. Same as above, older databases may have the table without the index.
+	if (created)
+	{
+		result = ExecuteQuery("create index if not exists activity_hash_index on activity_hash (hash)");
+		created = (result == SQLITE_OK || result == SQLITE_DONE);
+	}
+	return created;
 }
 
 bool Database::DeleteTables(void)
@@ -294,6 +458,44 @@ bool Database::DeleteTables(void)
 	queries.push_back(sql);
 	sql = "drop table route_coordinate";
 	queries.push_back(sql);
+	sql = "drop table route_polyline";
+	queries.push_back(sql);
+	sql = "drop table heat_map_cell";
+	queries.push_back(sql);
+	sql = "drop table heat_map_activity";
+	queries.push_back(sql);
+	sql = "drop table activity_snapshot";
+	queries.push_back(sql);
+	sql = "drop table geo_index_activity";
+	queries.push_back(sql);
+	sql = "drop table geo_index_activity_box";
+	queries.push_back(sql);
+	sql = "drop table geo_index_chunk";
+	queries.push_back(sql);
+	sql = "drop table geo_index_chunk_box";
+	queries.push_back(sql);
+	sql = "drop table route_box";
+	queries.push_back(sql);
+	sql = "drop table best_effort";
+	queries.push_back(sql);
+	sql = "drop table best_effort_activity";
+	queries.push_back(sql);
+	sql = "drop table best_effort_distance";
+	queries.push_back(sql);
+	sql = "drop table personal_record";
+	queries.push_back(sql);
+	sql = "drop table training_load_activity";
+	queries.push_back(sql);
+	sql = "drop table training_load_day";
+	queries.push_back(sql);
+	sql = "drop table zone_time_activity";
+	queries.push_back(sql);
+	sql = "drop table zone_time_week";
+	queries.push_back(sql);
+	sql = "drop table power_curve";
+	queries.push_back(sql);
+	sql = "drop table activity_summary_version";
+	queries.push_back(sql);
 
 	int result = ExecuteQueries(queries);
 	return (result == SQLITE_OK || result == SQLITE_DONE);
@@ -319,7 +521,7 @@ bool Database::CreateStatements(void)
 		return false;
 	if (sqlite3_prepare_v2(m_pDb, "select activity_id, attribute, value, start_time, end_time, value_type, measure_type, units from activity_summary where activity_id = ?", -1, &m_selectActivitySummaryStatement, 0) != SQLITE_OK)
 		return false;
-	if (sqlite3_prepare_v2(m_pDb, "select activity_id from activity_hash where hash = ? limit 1", -1, &m_selectActivityIdFromHashStatement, 0) != SQLITE_OK)
+	if (sqlite3_prepare_v2(m_pDb, "select activity_hash.activity_id from activity_hash inner join activity on activity.activity_id = activity_hash.activity_id where activity_hash.hash = ? limit 1", -1, &m_selectActivityIdFromHashStatement, 0) != SQLITE_OK)
 		return false;
 	if (sqlite3_prepare_v2(m_pDb, "select hash from activity_hash where activity_id = ? limit 1", -1, &m_selectActivityHashFromIdStatement, 0) != SQLITE_OK)
 		return false;
@@ -331,46 +533,57 @@ void Database::DeleteStatements(void)
 	if (m_accelerometerInsertStatement)
 	{
 		sqlite3_finalize(m_accelerometerInsertStatement);
+		m_accelerometerInsertStatement = NULL;
 	}
 	if (m_locationInsertStatement)
 	{
 		sqlite3_finalize(m_locationInsertStatement);
+		m_locationInsertStatement = NULL;
 	}
 	if (m_heartRateInsertStatement)
 	{
 		sqlite3_finalize(m_heartRateInsertStatement);
+		m_heartRateInsertStatement = NULL;
 	}
 	if (m_cadenceInsertStatement)
 	{
 		sqlite3_finalize(m_cadenceInsertStatement);
+		m_cadenceInsertStatement = NULL;
 	}
 	if (m_wheelSpeedInsertStatement)
 	{
 		sqlite3_finalize(m_wheelSpeedInsertStatement);
+		m_wheelSpeedInsertStatement = NULL;
 	}
 	if (m_powerInsertStatement)
 	{
 		sqlite3_finalize(m_powerInsertStatement);
+		m_powerInsertStatement = NULL;
 	}
 	if (m_footPodStatement)
 	{
 		sqlite3_finalize(m_footPodStatement);
+		m_footPodStatement = NULL;
 	}
 	if (m_eventStatement)
 	{
 		sqlite3_finalize(m_eventStatement);
+		m_eventStatement = NULL;
 	}
 	if (m_selectActivitySummaryStatement)
 	{
 		sqlite3_finalize(m_selectActivitySummaryStatement);
+		m_selectActivitySummaryStatement = NULL;
 	}
 	if (m_selectActivityIdFromHashStatement)
 	{
 		sqlite3_finalize(m_selectActivityIdFromHashStatement);
+		m_selectActivityIdFromHashStatement = NULL;
 	}
 	if (m_selectActivityHashFromIdStatement)
 	{
 		sqlite3_finalize(m_selectActivityHashFromIdStatement);
+		m_selectActivityHashFromIdStatement = NULL;
 	}
 }
 
@@ -383,6 +596,21 @@ bool Database::Reset(void)
 	return result;
 }
 
+bool Database::BeginTransaction(void)
+{
+	return ExecuteQuery("begin transaction") == SQLITE_DONE;
+}
+
+bool Database::CommitTransaction(void)
+{
+	return ExecuteQuery("commit transaction") == SQLITE_DONE;
+}
+
+bool Database::RollbackTransaction(void)
+{
+	return ExecuteQuery("rollback transaction") == SQLITE_DONE;
+}
+
 bool Database::CreateBike(const Bike& bike)
 {
 	sqlite3_stmt* statement = NULL;
@@ -1168,6 +1396,11 @@ bool Database::CreateRoutePoint(const std::string& routeId, const Coordinate& co
 }
 
 bool Database::RetrieveRoutes(std::vector<Route>& routes)
+{
+	return RetrieveRoutes(routes, (double)0.0);
+}
+
+bool Database::RetrieveRoutes(std::vector<Route>& routes, double maxToleranceM)
 {
 	bool result = false;
 	sqlite3_stmt* statement = NULL;
@@ -1181,7 +1414,13 @@ bool Database::RetrieveRoutes(std::vector<Route>& routes)
 			route.routeId.append((const char*)sqlite3_column_text(statement, 0));
 			route.name.append((const char*)sqlite3_column_text(statement, 1));
 			route.description.append((const char*)sqlite3_column_text(statement, 2));
-			this->RetrieveRouteCoordinates(route.routeId, route.coordinates);
+			route.toleranceM = (double)0.0;
+
+			// Routes imported before polylines were added only have a row per point.
+			if (!this->RetrieveRoutePolyline(route.routeId, maxToleranceM, route.coordinates, route.toleranceM))
+			{
+				this->RetrieveRouteCoordinates(route.routeId, route.coordinates);
+			}
 			
 			routes.push_back(route);
 		}
@@ -1272,6 +1511,187 @@ bool Database::DeleteRouteCoordinates(const std::string& routeId)
 	return result == SQLITE_DONE;
 }
 
+bool Database::CreateRoutePolylines(const std::string& routeId, const CoordinateList& coordinates)
+{
+	const double tolerances[ROUTE_POLYLINE_NUM_TOLERANCES] = ROUTE_POLYLINE_TOLERANCES_M;
+	sqlite3_stmt* statement = NULL;
+	sqlite3_stmt* boxStatement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "insert into route_polyline (id,route_id,tolerance,num_points,coordinates) values (NULL,?,?,?,?)", -1, &statement, 0) != SQLITE_OK ||
+		sqlite3_prepare_v2(m_pDb, "insert into route_box (id,min_lat,max_lat,min_lon,max_lon) values (?,?,?,?,?)", -1, &boxStatement, 0) != SQLITE_OK)
+	{
+		sqlite3_finalize(statement);
+		return false;
+	}
+	if (!BeginTransaction())
+	{
+		sqlite3_finalize(statement);
+		sqlite3_finalize(boxStatement);
+		return false;
+	}
+
+	CoordinateList simplified;
+	std::vector<uint8_t> data;
+	size_t prevNumPoints = coordinates.size();
+	bool result = true;
+
+	for (size_t i = 0; result && i <= ROUTE_POLYLINE_NUM_TOLERANCES; ++i)
+	{
+		double toleranceM = (double)0.0;
+		const CoordinateList* pPoints = &coordinates;
+
+		// The full resolution route first, then each simplified copy that is actually smaller than the one before it.
+		if (i > 0)
+		{
+			toleranceM = tolerances[i - 1];
+			RoutePolyline::Simplify(coordinates, toleranceM, simplified);
+			if (simplified.size() >= prevNumPoints)
+			{
+				continue;
+			}
+			pPoints = &simplified;
+			prevNumPoints = simplified.size();
+		}
+
+		RoutePolyline::Encode(*pPoints, data);
+
+		sqlite3_bind_text(statement, 1, routeId.c_str(), -1, SQLITE_TRANSIENT);
+		sqlite3_bind_double(statement, 2, toleranceM);
+		sqlite3_bind_int64(statement, 3, (sqlite3_int64)pPoints->size());
+		sqlite3_bind_blob(statement, 4, data.data(), (int)data.size(), SQLITE_TRANSIENT);
+		result = sqlite3_step(statement) == SQLITE_DONE;
+		sqlite3_reset(statement);
+
+		// The full resolution copy's bounding box goes in the spatial index, so routes can be found by area.
+		if (result && i == 0 && !coordinates.empty())
+		{
+			GeoBoundingBox box;
+
+			box.minLatitude = box.maxLatitude = coordinates.front().latitude;
+			box.minLongitude = box.maxLongitude = coordinates.front().longitude;
+			for (auto iter = coordinates.begin(); iter != coordinates.end(); ++iter)
+			{
+				box.minLatitude = std::min(box.minLatitude, (*iter).latitude);
+				box.maxLatitude = std::max(box.maxLatitude, (*iter).latitude);
+				box.minLongitude = std::min(box.minLongitude, (*iter).longitude);
+				box.maxLongitude = std::max(box.maxLongitude, (*iter).longitude);
+			}
+
+			sqlite3_bind_int64(boxStatement, 1, sqlite3_last_insert_rowid(m_pDb));
+			sqlite3_bind_double(boxStatement, 2, box.minLatitude);
+			sqlite3_bind_double(boxStatement, 3, box.maxLatitude);
+			sqlite3_bind_double(boxStatement, 4, box.minLongitude);
+			sqlite3_bind_double(boxStatement, 5, box.maxLongitude);
+			result = sqlite3_step(boxStatement) == SQLITE_DONE;
+		}
+	}
+
+	sqlite3_finalize(statement);
+	sqlite3_finalize(boxStatement);
+
+	if (result)
+	{
+		result = CommitTransaction();
+	}
+	else
+	{
+		RollbackTransaction();
+	}
+	return result;
+}
+
+bool Database::RetrieveRoutePolyline(const std::string& routeId, double maxToleranceM, CoordinateList& coordinates, double& toleranceM)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	coordinates.clear();
+
+	if (sqlite3_prepare_v2(m_pDb, "select tolerance,coordinates from route_polyline where route_id = ? and tolerance <= ? order by tolerance desc limit 1", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_text(statement, 1, routeId.c_str(), -1, SQLITE_TRANSIENT);
+		sqlite3_bind_double(statement, 2, maxToleranceM);
+
+		if (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			const uint8_t* blob = (const uint8_t*)sqlite3_column_blob(statement, 1);
+			int blobLen = sqlite3_column_bytes(statement, 1);
+
+			toleranceM = sqlite3_column_double(statement, 0);
+			result = blob && RoutePolyline::Decode(blob, (size_t)blobLen, coordinates);
+		}
+		sqlite3_finalize(statement);
+	}
+	return result;
+}
+
+bool Database::RetrieveRouteIdsWithinBox(const GeoBoundingBox& box, std::vector<std::string>& routeIds)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select p.route_id from route_box b join route_polyline p on p.id = b.id where b.min_lat >= ? and b.max_lat <= ? and b.min_lon >= ? and b.max_lon <= ?", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_double(statement, 1, box.minLatitude);
+		sqlite3_bind_double(statement, 2, box.maxLatitude);
+		sqlite3_bind_double(statement, 3, box.minLongitude);
+		sqlite3_bind_double(statement, 4, box.maxLongitude);
+
+		while (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			routeIds.push_back((const char*)sqlite3_column_text(statement, 0));
+		}
+
+		sqlite3_finalize(statement);
+		result = true;
+	}
+	return result;
+}
+
+bool Database::RetrieveRouteIdsNotInRouteIndex(std::vector<std::string>& routeIds)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select route_id from route where route_id not in (select p.route_id from route_box b join route_polyline p on p.id = b.id)", -1, &statement, 0) == SQLITE_OK)
+	{
+		while (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			routeIds.push_back((const char*)sqlite3_column_text(statement, 0));
+		}
+
+		sqlite3_finalize(statement);
+		result = true;
+	}
+	return result;
+}
+
+bool Database::DeleteRoutePolylines(const std::string& routeId)
+{
+	sqlite3_stmt* statement = NULL;
+
+	int result = sqlite3_prepare_v2(m_pDb, "delete from route_box where id in (select id from route_polyline where route_id = ?)", -1, &statement, 0);
+	if (result == SQLITE_OK)
+	{
+		sqlite3_bind_text(statement, 1, routeId.c_str(), -1, SQLITE_TRANSIENT);
+		result = sqlite3_step(statement);
+		sqlite3_finalize(statement);
+	}
+	if (result != SQLITE_DONE)
+	{
+		return false;
+	}
+
+	result = sqlite3_prepare_v2(m_pDb, "delete from route_polyline where route_id = ?", -1, &statement, 0);
+	if (result == SQLITE_OK)
+	{
+		sqlite3_bind_text(statement, 1, routeId.c_str(), -1, SQLITE_TRANSIENT);
+		result = sqlite3_step(statement);
+		sqlite3_finalize(statement);
+	}
+	return result == SQLITE_DONE;
+}
+
 bool Database::StartActivity(const std::string& activityId, const std::string& userId, const std::string& activityType, const std::string& activityDescription, time_t startTime)
 {
 	sqlite3_stmt* statement = NULL;
@@ -1373,7 +1793,34 @@ bool Database::DeleteActivity(const std::string& activityId)
 	sqlStream.str(std::string());
 	sqlStream.clear();
 
+	sqlStream << "delete from activity_summary_version where activity_id = '" << activityId << "'";
+	queries.push_back(sqlStream.str());
+	sqlStream.str(std::string());
+	sqlStream.clear();
+
+	sqlStream << "delete from activity_snapshot where activity_id = '" << activityId << "'";
+	queries.push_back(sqlStream.str());
+	sqlStream.str(std::string());
+	sqlStream.clear();
+
+	sqlStream << "delete from activity_hash where activity_id = '" << activityId << "'";
+	queries.push_back(sqlStream.str());
+	sqlStream.str(std::string());
+	sqlStream.clear();
+
 	int result = ExecuteQueries(queries);
+	if (result == SQLITE_OK || result == SQLITE_DONE)
+	{
+		result = DeleteGeoIndexEntries(activityId) ? SQLITE_DONE : SQLITE_ERROR;
+	}
+	if (result == SQLITE_OK || result == SQLITE_DONE)
+	{
+		result = DeleteBestEfforts(activityId) ? SQLITE_DONE : SQLITE_ERROR;
+	}
+	if (result == SQLITE_OK || result == SQLITE_DONE)
+	{
+		result = DeletePowerCurve(activityId) ? SQLITE_DONE : SQLITE_ERROR;
+	}
 	return (result == SQLITE_OK || result == SQLITE_DONE);
 }
 
@@ -1440,10 +1887,45 @@ bool Database::RetrieveActivities(ActivitySummaryList& activities)
 	return result;
 }
 
-bool Database::MergeActivities(const std::string& activityId1, const std::string& activityId2)
+bool Database::ProcessAllActivities(activityCallback callback, void* context)
 {
-	std::vector<std::string> queries;
-	std::ostringstream sqlStream;
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select activity_id, user_id, type, name, description, start_time, end_time from activity order by activity_id", -1, &statement, 0) == SQLITE_OK)
+	{
+		result = true;
+
+		while (result && sqlite3_step(statement) == SQLITE_ROW)
+		{
+			ActivitySummary summary;
+
+			summary.activityId.append((const char*)sqlite3_column_text(statement, 0));
+			const char* userId = (const char*)sqlite3_column_text(statement, 1);
+			if (userId)
+				summary.userId.append(userId);
+			summary.type.append((const char*)sqlite3_column_text(statement, 2));
+			const char* name = (const char*)sqlite3_column_text(statement, 3);
+			if (name)
+				summary.name.append(name);
+			const char* desc = (const char*)sqlite3_column_text(statement, 4);
+			if (desc)
+				summary.description.append(desc);
+			summary.startTime = (time_t)sqlite3_column_int64(statement, 5);
+			summary.endTime = (time_t)sqlite3_column_int64(statement, 6);
+
+			result = callback(summary, context);
+		}
+
+		sqlite3_finalize(statement);
+	}
+	return result;
+}
+
+bool Database::MergeActivities(const std::string& activityId1, const std::string& activityId2)
+{
+	std::vector<std::string> queries;
+	std::ostringstream sqlStream;
 		
 	sqlStream << "update lap set activity_id = '" << activityId1 << "' where activity_id = '" << activityId2 << "'";
 	queries.push_back(sqlStream.str());
@@ -1494,6 +1976,11 @@ bool Database::MergeActivities(const std::string& activityId1, const std::string
 	queries.push_back(sqlStream.str());
 	sqlStream.str(std::string());
 	sqlStream.clear();
+
+	sqlStream << "delete from activity_snapshot where activity_id in ('" << activityId1 << "', '" << activityId2 << "')";
+	queries.push_back(sqlStream.str());
+	sqlStream.str(std::string());
+	sqlStream.clear();
 	
 	sqlStream << "delete from activity where activity_id = '" << activityId2 << "'";
 	queries.push_back(sqlStream.str());
@@ -1640,6 +2127,68 @@ bool Database::CreateLap(const std::string& activityId, const LapSummary& lap)
 	return result == SQLITE_DONE;
 }
 
+bool Database::CreateImportedActivity(const ImportBatch& batch)
+{
+	const std::string& activityId = batch.activityId;
+
+	if (!BeginTransaction())
+	{
+		return false;
+	}
+
+	bool result = StartActivity(activityId, "", batch.activityType, "", batch.startTime);
+	result = result && StopActivity(batch.endTime, activityId);
+
+	result = result && InsertRows("gps", 5, batch.locationTimes.size(), [&](sqlite3_stmt* statement, int param, size_t row) {
+		sqlite3_bind_text(statement, param, activityId.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_int64(statement, param + 1, batch.locationTimes[row]);
+		sqlite3_bind_double(statement, param + 2, batch.latitudes[row]);
+		sqlite3_bind_double(statement, param + 3, batch.longitudes[row]);
+		sqlite3_bind_double(statement, param + 4, batch.altitudes[row]);
+	});
+	result = result && InsertRows("accelerometer", 5, batch.accelerometerTimes.size(), [&](sqlite3_stmt* statement, int param, size_t row) {
+		sqlite3_bind_text(statement, param, activityId.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_int64(statement, param + 1, batch.accelerometerTimes[row]);
+		sqlite3_bind_double(statement, param + 2, batch.accelerometerX[row]);
+		sqlite3_bind_double(statement, param + 3, batch.accelerometerY[row]);
+		sqlite3_bind_double(statement, param + 4, batch.accelerometerZ[row]);
+	});
+	result = result && InsertRows("hrm", 3, batch.heartRateTimes.size(), [&](sqlite3_stmt* statement, int param, size_t row) {
+		sqlite3_bind_text(statement, param, activityId.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_int64(statement, param + 1, batch.heartRateTimes[row]);
+		sqlite3_bind_double(statement, param + 2, batch.heartRates[row]);
+	});
+	result = result && InsertRows("cadence", 3, batch.cadenceTimes.size(), [&](sqlite3_stmt* statement, int param, size_t row) {
+		sqlite3_bind_text(statement, param, activityId.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_int64(statement, param + 1, batch.cadenceTimes[row]);
+		sqlite3_bind_double(statement, param + 2, batch.cadences[row]);
+	});
+	result = result && InsertRows("power_meter", 3, batch.powerTimes.size(), [&](sqlite3_stmt* statement, int param, size_t row) {
+		sqlite3_bind_text(statement, param, activityId.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_int64(statement, param + 1, batch.powerTimes[row]);
+		sqlite3_bind_double(statement, param + 2, batch.powers[row]);
+	});
+
+	for (auto iter = batch.laps.begin(); result && iter != batch.laps.end(); ++iter)
+	{
+		result = CreateLap(activityId, (*iter));
+	}
+	if (result && batch.hash.size() > 0)
+	{
+		result = CreateActivityHash(activityId, batch.hash);
+	}
+
+	if (result)
+	{
+		result = CommitTransaction();
+	}
+	if (!result)
+	{
+		RollbackTransaction();
+	}
+	return result;
+}
+
 bool Database::RetrieveLaps(const std::string& activityId, LapSummaryList& laps)
 {
 	bool result = false;
@@ -1851,6 +2400,114 @@ bool Database::RetrieveSummaryData(const std::string& activityId, ActivityAttrib
 	return result;
 }
 
+bool Database::DeleteSummaryData(const std::string& activityId)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "delete from activity_summary where activity_id = ?", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_text(statement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+		result = sqlite3_step(statement) == SQLITE_DONE;
+		sqlite3_finalize(statement);
+	}
+	return result;
+}
+
+bool Database::UpdateSummaryVersion(const std::string& activityId, uint32_t version)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "insert or replace into activity_summary_version values (?,?)", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_text(statement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+		sqlite3_bind_int(statement, 2, version);
+		result = sqlite3_step(statement) == SQLITE_DONE;
+		sqlite3_finalize(statement);
+	}
+	return result;
+}
+
+bool Database::RetrieveActivitiesWithStaleSummaries(uint32_t version, ActivitySummaryList& activities)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	// Activities that are still being recorded get their summary when they are stopped.
+	if (sqlite3_prepare_v2(m_pDb, "select a.activity_id, a.type, a.start_time, a.end_time from activity a left join activity_summary_version v on v.activity_id = a.activity_id " \
+		"where a.end_time > 0 and (v.version is null or v.version < ?) order by a.start_time", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_int(statement, 1, version);
+
+		while (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			ActivitySummary summary;
+
+			summary.activityId = (const char*)sqlite3_column_text(statement, 0);
+			summary.type = (const char*)sqlite3_column_text(statement, 1);
+			summary.startTime = (time_t)sqlite3_column_int64(statement, 2);
+			summary.endTime = (time_t)sqlite3_column_int64(statement, 3);
+			summary.pActivity = NULL;
+			activities.push_back(summary);
+		}
+
+		sqlite3_finalize(statement);
+		result = true;
+	}
+	return result;
+}
+
+bool Database::DeleteAllSummaryVersions(void)
+{
+	return ExecuteQuery("delete from activity_summary_version") == SQLITE_DONE;
+}
+
+bool Database::RetrieveBestSummaryValue(const std::vector<std::string>& activityTypes, const std::string& attribute, time_t startTime, time_t endTime, bool smallestIsBest, std::string& activityId, double& value)
+{
+	if (activityTypes.empty())
+	{
+		return false;
+	}
+
+	// One placeholder per activity type. The index on (type, start_time) turns this into a range read for each type,
+	// and each activity's value is then a single lookup on the (activity_id, attribute) key of the summary table.
+	std::string sql = "select a.activity_id, s.value from activity a join activity_summary s on s.activity_id = a.activity_id and s.attribute = ? where a.type in (?";
+	for (size_t i = 1; i < activityTypes.size(); ++i)
+	{
+		sql += ",?";
+	}
+	sql += ") and a.start_time >= ? and a.start_time < ? order by s.value";
+	sql += smallestIsBest ? " asc" : " desc";
+	sql += " limit 1";
+
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, sql.c_str(), -1, &statement, 0) == SQLITE_OK)
+	{
+		int paramIndex = 1;
+
+		sqlite3_bind_text(statement, paramIndex++, attribute.c_str(), -1, SQLITE_TRANSIENT);
+		for (auto iter = activityTypes.begin(); iter != activityTypes.end(); ++iter)
+		{
+			sqlite3_bind_text(statement, paramIndex++, (*iter).c_str(), -1, SQLITE_TRANSIENT);
+		}
+		sqlite3_bind_int64(statement, paramIndex++, (sqlite3_int64)startTime);
+		sqlite3_bind_int64(statement, paramIndex++, (sqlite3_int64)endTime);
+
+		if (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			activityId = (const char*)sqlite3_column_text(statement, 0);
+			value = sqlite3_column_double(statement, 1);
+			result = true;
+		}
+
+		sqlite3_finalize(statement);
+	}
+	return result;
+}
+
 bool Database::CreateActivityHash(const std::string& activityId, const std::string& hash)
 {
 	sqlite3_stmt* statement = NULL;
@@ -1870,6 +2527,8 @@ bool Database::RetrieveActivityIdFromHash(const std::string& hash, std::string&
 {
 	bool result = false;
 
+	// The statement joins against the activity table, so a hash left behind by a deleted activity doesn't count.
+
 	sqlite3_bind_text(m_selectActivityIdFromHashStatement, 1, hash.c_str(), -1, SQLITE_TRANSIENT);
 
 	if (sqlite3_step(m_selectActivityIdFromHashStatement) == SQLITE_ROW)
@@ -1917,6 +2576,64 @@ bool Database::UpdateActivityHash(const std::string& activityId, const std::stri
 	return result == SQLITE_DONE;
 }
 
+bool Database::CreateActivitySnapshot(const std::string& activityId, uint32_t version, const std::vector<uint8_t>& state)
+{
+	sqlite3_stmt* statement = NULL;
+
+	int result = sqlite3_prepare_v2(m_pDb, "insert into activity_snapshot values (NULL,?,?,?)", -1, &statement, 0);
+	if (result == SQLITE_OK)
+	{
+		sqlite3_bind_text(statement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+		sqlite3_bind_int(statement, 2, version);
+		sqlite3_bind_blob(statement, 3, state.data(), (int)state.size(), SQLITE_TRANSIENT);
+		result = sqlite3_step(statement);
+		sqlite3_finalize(statement);
+	}
+	return result == SQLITE_DONE;
+}
+
+bool Database::RetrieveActivitySnapshot(const std::string& activityId, uint32_t& version, std::vector<uint8_t>& state)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select version, state from activity_snapshot where activity_id = ? limit 1", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_text(statement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+
+		if (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			const uint8_t* blob = (const uint8_t*)sqlite3_column_blob(statement, 1);
+			int blobLen = sqlite3_column_bytes(statement, 1);
+
+			version = (uint32_t)sqlite3_column_int(statement, 0);
+			state.clear();
+			if (blob && blobLen > 0)
+			{
+				state.assign(blob, blob + blobLen);
+			}
+			result = true;
+		}
+
+		sqlite3_finalize(statement);
+	}
+	return result;
+}
+
+bool Database::DeleteActivitySnapshot(const std::string& activityId)
+{
+	sqlite3_stmt* statement = NULL;
+
+	int result = sqlite3_prepare_v2(m_pDb, "delete from activity_snapshot where activity_id = ?", -1, &statement, 0);
+	if (result == SQLITE_OK)
+	{
+		sqlite3_bind_text(statement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+		result = sqlite3_step(statement);
+		sqlite3_finalize(statement);
+	}
+	return result == SQLITE_DONE;
+}
+
 bool Database::CreateActivitySync(const std::string& activityId, const std::string& destination)
 {
 	sqlite3_stmt* statement = NULL;
@@ -2290,21 +3007,16 @@ bool Database::CreateEventReading(const std::string& activityId, const SensorRea
 	return result == SQLITE_DONE;
 }
 
-bool Database::ProcessAllCoordinates(coordinateCallback callback, void* context)
+bool Database::RetrieveActivityIdsNotInHeatMap(std::vector<std::string>& activityIds)
 {
 	bool result = false;
 	sqlite3_stmt* statement = NULL;
 
-	if (sqlite3_prepare_v2(m_pDb, "select time,latitude,longitude,altitude from gps", -1, &statement, 0) == SQLITE_OK)
+	if (sqlite3_prepare_v2(m_pDb, "select activity_id from activity where activity_id not in (select activity_id from heat_map_activity) order by activity_id", -1, &statement, 0) == SQLITE_OK)
 	{
 		while (sqlite3_step(statement) == SQLITE_ROW)
 		{
-			uint64_t time      = sqlite3_column_int64(statement, 0);
-			double   latitude  = sqlite3_column_double(statement, 1);
-			double   longitude = sqlite3_column_double(statement, 2);
-			double   altitude  = sqlite3_column_double(statement, 3);
-			
-			callback(time, latitude, longitude, altitude, context);
+			activityIds.push_back((const char*)sqlite3_column_text(statement, 0));
 		}
 
 		sqlite3_finalize(statement);
@@ -2313,75 +3025,1369 @@ bool Database::ProcessAllCoordinates(coordinateCallback callback, void* context)
 	return result;
 }
 
-bool Database::CreateSensorReading(const std::string& activityId, const SensorReading& reading)
+bool Database::RetrieveHeatMapActivityCount(size_t& numActivities)
 {
-	switch (reading.type)
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select count(*) from heat_map_activity", -1, &statement, 0) == SQLITE_OK)
 	{
-		case SENSOR_TYPE_UNKNOWN:
-			break;
-		case SENSOR_TYPE_ACCELEROMETER:
-			return CreateAccelerometerReading(activityId, reading);
-		case SENSOR_TYPE_LOCATION:
-			return CreateLocationReading(activityId, reading);
-		case SENSOR_TYPE_HEART_RATE:
-			return CreateHrmReading(activityId, reading);
-		case SENSOR_TYPE_CADENCE:
-			return CreateCadenceReading(activityId, reading);
-		case SENSOR_TYPE_WHEEL_SPEED:
-			return CreateWheelSpeedReading(activityId, reading);
-		case SENSOR_TYPE_POWER:
-			return CreatePowerMeterReading(activityId, reading);
-		case SENSOR_TYPE_FOOT_POD:
-			return CreateFootPodReading(activityId, reading);
-		case SENSOR_TYPE_SCALE:
-			break;
-		case SENSOR_TYPE_LIGHT:
-			break;
-		case SENSOR_TYPE_RADAR:
-			return CreateEventReading(activityId, reading);
-		case SENSOR_TYPE_GOPRO:
-			break;
-		case SENSOR_TYPE_NEARBY:
-			break;
-		case NUM_SENSOR_TYPES:
-			break;
+		if (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			numActivities = (size_t)sqlite3_column_int64(statement, 0);
+			result = true;
+		}
+		sqlite3_finalize(statement);
 	}
-	return false;
+	return result;
 }
 
-bool Database::RetrieveSensorReadingsOfType(const std::string& activityId, SensorType type, SensorReadingList& readings)
+bool Database::IsActivityInHeatMap(const std::string& activityId)
 {
-	switch (type)
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select activity_id from heat_map_activity where activity_id = ? limit 1", -1, &statement, 0) == SQLITE_OK)
 	{
-		case SENSOR_TYPE_UNKNOWN:
-			break;
-		case SENSOR_TYPE_ACCELEROMETER:
-			return RetrieveActivityAccelerometerReadings(activityId, readings);
-		case SENSOR_TYPE_LOCATION:
-			return RetrieveActivityPositionReadings(activityId, readings);
-		case SENSOR_TYPE_HEART_RATE:
-			return RetrieveActivityHeartRateMonitorReadings(activityId, readings);
-		case SENSOR_TYPE_CADENCE:
-			return RetrieveActivityCadenceReadings(activityId, readings);
-		case SENSOR_TYPE_WHEEL_SPEED:
-			return RetrieveActivityWheelSpeedReadings(activityId, readings);
-		case SENSOR_TYPE_POWER:
-			return RetrieveActivityPowerMeterReadings(activityId, readings);
-		case SENSOR_TYPE_FOOT_POD:
-			return RetrieveActivityFootPodReadings(activityId, readings);
-		case SENSOR_TYPE_SCALE:
-			break;
-		case SENSOR_TYPE_LIGHT:
-			break;
-		case SENSOR_TYPE_RADAR:
-			break;
-		case SENSOR_TYPE_GOPRO:
-			break;
-		case SENSOR_TYPE_NEARBY:
-			break;
-		case NUM_SENSOR_TYPES:
-			break;
+		sqlite3_bind_text(statement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+		result = sqlite3_step(statement) == SQLITE_ROW;
+		sqlite3_finalize(statement);
 	}
+	return result;
+}
+
+bool Database::AddHeatMapCounts(const std::unordered_map<uint64_t, uint32_t>& counts, const std::vector<std::string>& activityIds)
+{
+	sqlite3_stmt* cellStatement = NULL;
+	sqlite3_stmt* activityStatement = NULL;
+	bool result = false;
+
+	if (sqlite3_prepare_v2(m_pDb, "insert into heat_map_cell (cell,count) values (?,?) on conflict(cell) do update set count = count + excluded.count", -1, &cellStatement, 0) == SQLITE_OK &&
+		sqlite3_prepare_v2(m_pDb, "insert or ignore into heat_map_activity (activity_id) values (?)", -1, &activityStatement, 0) == SQLITE_OK &&
+		BeginTransaction())
+	{
+		result = true;
+
+		for (auto iter = counts.begin(); result && iter != counts.end(); ++iter)
+		{
+			sqlite3_bind_int64(cellStatement, 1, (sqlite3_int64)iter->first);
+			sqlite3_bind_int64(cellStatement, 2, (sqlite3_int64)iter->second);
+			result = sqlite3_step(cellStatement) == SQLITE_DONE;
+			sqlite3_reset(cellStatement);
+		}
+		for (auto iter = activityIds.begin(); result && iter != activityIds.end(); ++iter)
+		{
+			sqlite3_bind_text(activityStatement, 1, (*iter).c_str(), -1, SQLITE_TRANSIENT);
+			result = sqlite3_step(activityStatement) == SQLITE_DONE;
+			sqlite3_reset(activityStatement);
+		}
+
+		if (result)
+		{
+			result = CommitTransaction();
+		}
+		else
+		{
+			RollbackTransaction();
+		}
+	}
+
+	sqlite3_finalize(cellStatement);
+	sqlite3_finalize(activityStatement);
+	return result;
+}
+
+bool Database::SubtractHeatMapCounts(const std::unordered_map<uint64_t, uint32_t>& counts, const std::string& activityId)
+{
+	sqlite3_stmt* cellStatement = NULL;
+	sqlite3_stmt* emptyCellStatement = NULL;
+	sqlite3_stmt* activityStatement = NULL;
+	bool result = false;
+
+	if (sqlite3_prepare_v2(m_pDb, "update heat_map_cell set count = count - ? where cell = ?", -1, &cellStatement, 0) == SQLITE_OK &&
+		sqlite3_prepare_v2(m_pDb, "delete from heat_map_cell where cell = ? and count <= 0", -1, &emptyCellStatement, 0) == SQLITE_OK &&
+		sqlite3_prepare_v2(m_pDb, "delete from heat_map_activity where activity_id = ?", -1, &activityStatement, 0) == SQLITE_OK &&
+		BeginTransaction())
+	{
+		result = true;
+
+		for (auto iter = counts.begin(); result && iter != counts.end(); ++iter)
+		{
+			sqlite3_bind_int64(cellStatement, 1, (sqlite3_int64)iter->second);
+			sqlite3_bind_int64(cellStatement, 2, (sqlite3_int64)iter->first);
+			result = sqlite3_step(cellStatement) == SQLITE_DONE;
+			sqlite3_reset(cellStatement);
+
+			if (result)
+			{
+				sqlite3_bind_int64(emptyCellStatement, 1, (sqlite3_int64)iter->first);
+				result = sqlite3_step(emptyCellStatement) == SQLITE_DONE;
+				sqlite3_reset(emptyCellStatement);
+			}
+		}
+		if (result)
+		{
+			sqlite3_bind_text(activityStatement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+			result = sqlite3_step(activityStatement) == SQLITE_DONE;
+		}
+
+		if (result)
+		{
+			result = CommitTransaction();
+		}
+		else
+		{
+			RollbackTransaction();
+		}
+	}
+
+	sqlite3_finalize(cellStatement);
+	sqlite3_finalize(emptyCellStatement);
+	sqlite3_finalize(activityStatement);
+	return result;
+}
+
+bool Database::ProcessHeatMapCells(uint64_t firstKey, uint64_t lastKey, heatMapCellCallback callback, void* context)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	// The cell key is the row id, so this is a range scan in key order.
+	if (sqlite3_prepare_v2(m_pDb, "select cell,count from heat_map_cell where cell >= ? and cell < ? order by cell", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_int64(statement, 1, (sqlite3_int64)firstKey);
+		sqlite3_bind_int64(statement, 2, (sqlite3_int64)lastKey);
+
+		while (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			callback((uint64_t)sqlite3_column_int64(statement, 0), (uint32_t)sqlite3_column_int64(statement, 1), context);
+		}
+
+		sqlite3_finalize(statement);
+		result = true;
+	}
+	return result;
+}
+
+bool Database::CreateGeoIndexEntries(const std::string& activityId, const std::vector<GeoIndexChunk>& chunks)
+{
+	sqlite3_stmt* activityStatement = NULL;
+	sqlite3_stmt* activityBoxStatement = NULL;
+	sqlite3_stmt* chunkStatement = NULL;
+	sqlite3_stmt* chunkBoxStatement = NULL;
+	bool result = false;
+
+	if (sqlite3_prepare_v2(m_pDb, "insert into geo_index_activity (id,activity_id,start_time,end_time) values (NULL,?,?,?)", -1, &activityStatement, 0) == SQLITE_OK &&
+		sqlite3_prepare_v2(m_pDb, "insert into geo_index_activity_box (id,min_lat,max_lat,min_lon,max_lon) values (?,?,?,?,?)", -1, &activityBoxStatement, 0) == SQLITE_OK &&
+		sqlite3_prepare_v2(m_pDb, "insert into geo_index_chunk (id,activity_id,chunk_num,first_row,last_row,start_time,end_time) values (NULL,?,?,?,?,?,?)", -1, &chunkStatement, 0) == SQLITE_OK &&
+		sqlite3_prepare_v2(m_pDb, "insert into geo_index_chunk_box (id,min_lat,max_lat,min_lon,max_lon) values (?,?,?,?,?)", -1, &chunkBoxStatement, 0) == SQLITE_OK &&
+		BeginTransaction())
+	{
+		// Replaces whatever was indexed before, e.g. when an activity that was indexed while recording is finished.
+		result = DeleteGeoIndexEntries(activityId);
+
+		if (result)
+		{
+			sqlite3_bind_text(activityStatement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+			sqlite3_bind_int64(activityStatement, 2, chunks.empty() ? 0 : (sqlite3_int64)chunks.front().startTime);
+			sqlite3_bind_int64(activityStatement, 3, chunks.empty() ? 0 : (sqlite3_int64)chunks.back().endTime);
+			result = sqlite3_step(activityStatement) == SQLITE_DONE;
+		}
+
+		if (result && !chunks.empty())
+		{
+			GeoBoundingBox box = chunks.front().box;
+
+			for (auto iter = chunks.begin(); iter != chunks.end(); ++iter)
+			{
+				box.minLatitude = std::min(box.minLatitude, (*iter).box.minLatitude);
+				box.maxLatitude = std::max(box.maxLatitude, (*iter).box.maxLatitude);
+				box.minLongitude = std::min(box.minLongitude, (*iter).box.minLongitude);
+				box.maxLongitude = std::max(box.maxLongitude, (*iter).box.maxLongitude);
+			}
+
+			sqlite3_bind_int64(activityBoxStatement, 1, sqlite3_last_insert_rowid(m_pDb));
+			sqlite3_bind_double(activityBoxStatement, 2, box.minLatitude);
+			sqlite3_bind_double(activityBoxStatement, 3, box.maxLatitude);
+			sqlite3_bind_double(activityBoxStatement, 4, box.minLongitude);
+			sqlite3_bind_double(activityBoxStatement, 5, box.maxLongitude);
+			result = sqlite3_step(activityBoxStatement) == SQLITE_DONE;
+		}
+
+		for (auto iter = chunks.begin(); result && iter != chunks.end(); ++iter)
+		{
+			const GeoIndexChunk& chunk = (*iter);
+
+			sqlite3_bind_text(chunkStatement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+			sqlite3_bind_int64(chunkStatement, 2, (sqlite3_int64)chunk.chunkNum);
+			sqlite3_bind_int64(chunkStatement, 3, (sqlite3_int64)chunk.firstRowId);
+			sqlite3_bind_int64(chunkStatement, 4, (sqlite3_int64)chunk.lastRowId);
+			sqlite3_bind_int64(chunkStatement, 5, (sqlite3_int64)chunk.startTime);
+			sqlite3_bind_int64(chunkStatement, 6, (sqlite3_int64)chunk.endTime);
+			result = sqlite3_step(chunkStatement) == SQLITE_DONE;
+			sqlite3_reset(chunkStatement);
+
+			if (result)
+			{
+				sqlite3_bind_int64(chunkBoxStatement, 1, sqlite3_last_insert_rowid(m_pDb));
+				sqlite3_bind_double(chunkBoxStatement, 2, chunk.box.minLatitude);
+				sqlite3_bind_double(chunkBoxStatement, 3, chunk.box.maxLatitude);
+				sqlite3_bind_double(chunkBoxStatement, 4, chunk.box.minLongitude);
+				sqlite3_bind_double(chunkBoxStatement, 5, chunk.box.maxLongitude);
+				result = sqlite3_step(chunkBoxStatement) == SQLITE_DONE;
+				sqlite3_reset(chunkBoxStatement);
+			}
+		}
+
+		if (result)
+		{
+			result = CommitTransaction();
+		}
+		else
+		{
+			RollbackTransaction();
+		}
+	}
+
+	sqlite3_finalize(activityStatement);
+	sqlite3_finalize(activityBoxStatement);
+	sqlite3_finalize(chunkStatement);
+	sqlite3_finalize(chunkBoxStatement);
+	return result;
+}
+
+bool Database::RetrieveActivityIdsNotInGeoIndex(size_t maxActivities, std::vector<std::string>& activityIds)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	// Newest first, since those are the ones most likely to be searched for.
+	if (sqlite3_prepare_v2(m_pDb, "select activity_id from activity where activity_id not in (select activity_id from geo_index_activity) order by start_time desc limit ?", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_int64(statement, 1, (sqlite3_int64)maxActivities);
+
+		while (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			activityIds.push_back((const char*)sqlite3_column_text(statement, 0));
+		}
+
+		sqlite3_finalize(statement);
+		result = true;
+	}
+	return result;
+}
+
+bool Database::RetrieveGeoIndexActivityIds(const GeoBoundingBox& box, std::vector<std::string>& activityIds)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select a.activity_id from geo_index_activity_box b join geo_index_activity a on a.id = b.id where b.max_lat >= ? and b.min_lat <= ? and b.max_lon >= ? and b.min_lon <= ? order by a.activity_id", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_double(statement, 1, box.minLatitude);
+		sqlite3_bind_double(statement, 2, box.maxLatitude);
+		sqlite3_bind_double(statement, 3, box.minLongitude);
+		sqlite3_bind_double(statement, 4, box.maxLongitude);
+
+		while (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			activityIds.push_back((const char*)sqlite3_column_text(statement, 0));
+		}
+
+		sqlite3_finalize(statement);
+		result = true;
+	}
+	return result;
+}
+
+bool Database::RetrieveGeoIndexChunks(const GeoBoundingBox& box, std::vector<GeoIndexChunk>& chunks)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select c.activity_id,c.chunk_num,c.first_row,c.last_row,c.start_time,c.end_time,b.min_lat,b.max_lat,b.min_lon,b.max_lon from geo_index_chunk_box b join geo_index_chunk c on c.id = b.id where b.max_lat >= ? and b.min_lat <= ? and b.max_lon >= ? and b.min_lon <= ? order by c.activity_id,c.chunk_num", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_double(statement, 1, box.minLatitude);
+		sqlite3_bind_double(statement, 2, box.maxLatitude);
+		sqlite3_bind_double(statement, 3, box.minLongitude);
+		sqlite3_bind_double(statement, 4, box.maxLongitude);
+
+		while (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			GeoIndexChunk chunk;
+
+			chunk.activityId = (const char*)sqlite3_column_text(statement, 0);
+			chunk.chunkNum = (uint32_t)sqlite3_column_int64(statement, 1);
+			chunk.firstRowId = sqlite3_column_int64(statement, 2);
+			chunk.lastRowId = sqlite3_column_int64(statement, 3);
+			chunk.startTime = (uint64_t)sqlite3_column_int64(statement, 4);
+			chunk.endTime = (uint64_t)sqlite3_column_int64(statement, 5);
+			chunk.box.minLatitude = sqlite3_column_double(statement, 6);
+			chunk.box.maxLatitude = sqlite3_column_double(statement, 7);
+			chunk.box.minLongitude = sqlite3_column_double(statement, 8);
+			chunk.box.maxLongitude = sqlite3_column_double(statement, 9);
+			chunks.push_back(chunk);
+		}
+
+		sqlite3_finalize(statement);
+		result = true;
+	}
+	return result;
+}
+
+bool Database::DeleteGeoIndexEntries(const std::string& activityId)
+{
+	const char* queries[] = {
+		"delete from geo_index_activity_box where id in (select id from geo_index_activity where activity_id = ?)",
+		"delete from geo_index_activity where activity_id = ?",
+		"delete from geo_index_chunk_box where id in (select id from geo_index_chunk where activity_id = ?)",
+		"delete from geo_index_chunk where activity_id = ?"
+	};
+	bool result = true;
+
+	for (size_t i = 0; result && i < sizeof(queries) / sizeof(queries[0]); ++i)
+	{
+		sqlite3_stmt* statement = NULL;
+
+		result = sqlite3_prepare_v2(m_pDb, queries[i], -1, &statement, 0) == SQLITE_OK;
+		if (result)
+		{
+			sqlite3_bind_text(statement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+			result = sqlite3_step(statement) == SQLITE_DONE;
+		}
+		sqlite3_finalize(statement);
+	}
+	return result;
+}
+
+bool Database::DeleteBestEffortRows(const std::string& activityId, PersonalRecordKeys& keys)
+{
+	sqlite3_stmt* selectStatement = NULL;
+	sqlite3_stmt* deleteStatement = NULL;
+	sqlite3_stmt* markerStatement = NULL;
+	bool result = false;
+
+	if (sqlite3_prepare_v2(m_pDb, "select activity_type, distance from best_effort where activity_id = ?", -1, &selectStatement, 0) == SQLITE_OK &&
+		sqlite3_prepare_v2(m_pDb, "delete from best_effort where activity_id = ?", -1, &deleteStatement, 0) == SQLITE_OK &&
+		sqlite3_prepare_v2(m_pDb, "delete from best_effort_activity where activity_id = ?", -1, &markerStatement, 0) == SQLITE_OK)
+	{
+		// Remember which records these efforts might have been, so they can be worked out again.
+		sqlite3_bind_text(selectStatement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+		while (sqlite3_step(selectStatement) == SQLITE_ROW)
+		{
+			keys.insert(std::make_pair(std::string((const char*)sqlite3_column_text(selectStatement, 0)), sqlite3_column_double(selectStatement, 1)));
+		}
+
+		sqlite3_bind_text(deleteStatement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+		sqlite3_bind_text(markerStatement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+		result = sqlite3_step(deleteStatement) == SQLITE_DONE && sqlite3_step(markerStatement) == SQLITE_DONE;
+	}
+
+	sqlite3_finalize(selectStatement);
+	sqlite3_finalize(deleteStatement);
+	sqlite3_finalize(markerStatement);
+	return result;
+}
+
+bool Database::RefreshPersonalRecords(const PersonalRecordKeys& keys)
+{
+	sqlite3_stmt* deleteStatement = NULL;
+	sqlite3_stmt* insertStatement = NULL;
+	bool result = false;
+
+	// Each record is the first row of the best_effort_record_index for its activity type and distance, so this is a
+	// lookup rather than a scan of every effort.
+	if (sqlite3_prepare_v2(m_pDb, "delete from personal_record where activity_type = ? and distance = ?", -1, &deleteStatement, 0) == SQLITE_OK &&
+		sqlite3_prepare_v2(m_pDb, "insert into personal_record (activity_type,distance,activity_id,elapsed_ms,start_time) select activity_type,distance,activity_id,elapsed_ms,start_time from best_effort where activity_type = ? and distance = ? order by elapsed_ms limit 1", -1, &insertStatement, 0) == SQLITE_OK)
+	{
+		result = true;
+
+		for (auto iter = keys.begin(); result && iter != keys.end(); ++iter)
+		{
+			sqlite3_bind_text(deleteStatement, 1, iter->first.c_str(), -1, SQLITE_TRANSIENT);
+			sqlite3_bind_double(deleteStatement, 2, iter->second);
+			result = sqlite3_step(deleteStatement) == SQLITE_DONE;
+			sqlite3_reset(deleteStatement);
+
+			if (result)
+			{
+				sqlite3_bind_text(insertStatement, 1, iter->first.c_str(), -1, SQLITE_TRANSIENT);
+				sqlite3_bind_double(insertStatement, 2, iter->second);
+				result = sqlite3_step(insertStatement) == SQLITE_DONE;
+				sqlite3_reset(insertStatement);
+			}
+		}
+	}
+
+	sqlite3_finalize(deleteStatement);
+	sqlite3_finalize(insertStatement);
+	return result;
+}
+
+bool Database::CreateBestEfforts(const std::vector<std::string>& activityIds, const BestEffortList& efforts, bool replace)
+{
+	sqlite3_stmt* existsStatement = NULL;
+	sqlite3_stmt* markerStatement = NULL;
+	sqlite3_stmt* effortStatement = NULL;
+	bool result = false;
+
+	if (sqlite3_prepare_v2(m_pDb, "select count(*) from best_effort_activity where activity_id = ?", -1, &existsStatement, 0) == SQLITE_OK &&
+		sqlite3_prepare_v2(m_pDb, "insert into best_effort_activity (activity_id) select activity_id from activity where activity_id = ?", -1, &markerStatement, 0) == SQLITE_OK &&
+		sqlite3_prepare_v2(m_pDb, "insert into best_effort (id,activity_id,activity_type,distance,elapsed_ms,start_time) values (NULL,?,?,?,?,?)", -1, &effortStatement, 0) == SQLITE_OK &&
+		BeginTransaction())
+	{
+		PersonalRecordKeys keys;
+		std::set<std::string> storeIds;
+
+		result = true;
+
+		for (auto iter = activityIds.begin(); result && iter != activityIds.end(); ++iter)
+		{
+			const std::string& activityId = (*iter);
+
+			// Efforts found in the background are out of date if the activity was finished, trimmed, or deleted
+			// while they were being worked out.
+			if (!replace)
+			{
+				sqlite3_bind_text(existsStatement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+				bool exists = sqlite3_step(existsStatement) == SQLITE_ROW && sqlite3_column_int64(existsStatement, 0) > 0;
+				sqlite3_reset(existsStatement);
+
+				if (exists)
+				{
+					continue;
+				}
+			}
+
+			result = DeleteBestEffortRows(activityId, keys);
+			if (result)
+			{
+				sqlite3_bind_text(markerStatement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+				result = sqlite3_step(markerStatement) == SQLITE_DONE;
+				if (result && sqlite3_changes(m_pDb) > 0)
+				{
+					storeIds.insert(activityId);
+				}
+				sqlite3_reset(markerStatement);
+			}
+		}
+
+		for (auto iter = efforts.begin(); result && iter != efforts.end(); ++iter)
+		{
+			const BestEffort& effort = (*iter);
+
+			if (storeIds.count(effort.activityId) == 0)
+			{
+				continue;
+			}
+
+			sqlite3_bind_text(effortStatement, 1, effort.activityId.c_str(), -1, SQLITE_TRANSIENT);
+			sqlite3_bind_text(effortStatement, 2, effort.activityType.c_str(), -1, SQLITE_TRANSIENT);
+			sqlite3_bind_double(effortStatement, 3, effort.distanceM);
+			sqlite3_bind_int64(effortStatement, 4, (sqlite3_int64)effort.elapsedMs);
+			sqlite3_bind_int64(effortStatement, 5, (sqlite3_int64)effort.startTime);
+			result = sqlite3_step(effortStatement) == SQLITE_DONE;
+			sqlite3_reset(effortStatement);
+
+			keys.insert(std::make_pair(effort.activityType, effort.distanceM));
+		}
+
+		if (result)
+		{
+			result = RefreshPersonalRecords(keys);
+		}
+
+		if (result)
+		{
+			result = CommitTransaction();
+		}
+		else
+		{
+			RollbackTransaction();
+		}
+	}
+
+	sqlite3_finalize(existsStatement);
+	sqlite3_finalize(markerStatement);
+	sqlite3_finalize(effortStatement);
+	return result;
+}
+
+bool Database::RetrieveActivitiesWithoutBestEfforts(ActivitySummaryList& activities)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select activity_id, type from activity where activity_id not in (select activity_id from best_effort_activity) order by start_time", -1, &statement, 0) == SQLITE_OK)
+	{
+		while (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			ActivitySummary summary;
+
+			summary.activityId = (const char*)sqlite3_column_text(statement, 0);
+			summary.type = (const char*)sqlite3_column_text(statement, 1);
+			summary.pActivity = NULL;
+			activities.push_back(summary);
+		}
+
+		sqlite3_finalize(statement);
+		result = true;
+	}
+	return result;
+}
+
+static void ReadBestEffortRow(sqlite3_stmt* statement, BestEffort& effort)
+{
+	effort.activityId = (const char*)sqlite3_column_text(statement, 0);
+	effort.activityType = (const char*)sqlite3_column_text(statement, 1);
+	effort.distanceM = sqlite3_column_double(statement, 2);
+	effort.elapsedMs = (uint64_t)sqlite3_column_int64(statement, 3);
+	effort.startTime = (uint64_t)sqlite3_column_int64(statement, 4);
+}
+
+bool Database::RetrieveBestEfforts(const std::string& activityId, BestEffortList& efforts)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select activity_id, activity_type, distance, elapsed_ms, start_time from best_effort where activity_id = ? order by distance", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_text(statement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+
+		while (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			BestEffort effort;
+
+			ReadBestEffortRow(statement, effort);
+			efforts.push_back(effort);
+		}
+
+		sqlite3_finalize(statement);
+		result = true;
+	}
+	return result;
+}
+
+bool Database::RetrievePersonalRecord(const std::string& activityType, double distanceM, BestEffort& record)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select activity_id, activity_type, distance, elapsed_ms, start_time from personal_record where activity_type = ? and distance = ?", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_text(statement, 1, activityType.c_str(), -1, SQLITE_TRANSIENT);
+		sqlite3_bind_double(statement, 2, distanceM);
+
+		if (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			ReadBestEffortRow(statement, record);
+			result = true;
+		}
+
+		sqlite3_finalize(statement);
+	}
+	return result;
+}
+
+bool Database::RetrievePersonalRecords(const std::string& activityType, BestEffortList& records)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select activity_id, activity_type, distance, elapsed_ms, start_time from personal_record where activity_type = ? order by distance", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_text(statement, 1, activityType.c_str(), -1, SQLITE_TRANSIENT);
+
+		while (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			BestEffort record;
+
+			ReadBestEffortRow(statement, record);
+			records.push_back(record);
+		}
+
+		sqlite3_finalize(statement);
+		result = true;
+	}
+	return result;
+}
+
+bool Database::DeleteBestEfforts(const std::string& activityId)
+{
+	PersonalRecordKeys keys;
+	bool result = false;
+
+	if (BeginTransaction())
+	{
+		result = DeleteBestEffortRows(activityId, keys) && RefreshPersonalRecords(keys);
+
+		if (result)
+		{
+			result = CommitTransaction();
+		}
+		else
+		{
+			RollbackTransaction();
+		}
+	}
+	return result;
+}
+
+bool Database::DeleteAllBestEfforts(void)
+{
+	const char* queries[] = { "delete from best_effort", "delete from best_effort_activity", "delete from personal_record" };
+	bool result = true;
+
+	for (size_t i = 0; result && i < sizeof(queries) / sizeof(queries[0]); ++i)
+	{
+		int queryResult = ExecuteQuery(queries[i]);
+		result = (queryResult == SQLITE_OK || queryResult == SQLITE_DONE);
+	}
+	return result;
+}
+
+bool Database::CreateBestEffortDistance(double distanceM)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "insert or ignore into best_effort_distance (distance) values (?)", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_double(statement, 1, distanceM);
+		result = sqlite3_step(statement) == SQLITE_DONE;
+		sqlite3_finalize(statement);
+	}
+	return result;
+}
+
+bool Database::RetrieveBestEffortDistances(std::vector<double>& distancesM)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select distance from best_effort_distance order by distance", -1, &statement, 0) == SQLITE_OK)
+	{
+		while (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			double distance = sqlite3_column_double(statement, 0);
+
+			// Already one of the defaults.
+			if (std::find(distancesM.begin(), distancesM.end(), distance) == distancesM.end())
+			{
+				distancesM.push_back(distance);
+			}
+		}
+
+		sqlite3_finalize(statement);
+		result = true;
+	}
+	return result;
+}
+
+bool Database::DeleteBestEffortDistance(double distanceM)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "delete from best_effort_distance where distance = ?", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_double(statement, 1, distanceM);
+		result = sqlite3_step(statement) == SQLITE_DONE;
+		sqlite3_finalize(statement);
+	}
+	return result;
+}
+
+bool Database::CreateTrainingLoadActivities(const TrainingLoadActivityList& activities)
+{
+	sqlite3_stmt* statement = NULL;
+	bool result = false;
+
+	// Only stored while the activity itself still exists, since it may have been deleted while it was being scored.
+	if (sqlite3_prepare_v2(m_pDb, "insert or replace into training_load_activity (activity_id,activity_type,start_time,end_time,day,distance,stress) select activity_id,?,?,?,?,?,? from activity where activity_id = ?", -1, &statement, 0) == SQLITE_OK &&
+		BeginTransaction())
+	{
+		result = true;
+
+		for (auto iter = activities.begin(); result && iter != activities.end(); ++iter)
+		{
+			const TrainingLoadActivity& activity = (*iter);
+
+			sqlite3_bind_text(statement, 1, activity.activityType.c_str(), -1, SQLITE_TRANSIENT);
+			sqlite3_bind_int64(statement, 2, (sqlite3_int64)activity.startTime);
+			sqlite3_bind_int64(statement, 3, (sqlite3_int64)activity.endTime);
+			sqlite3_bind_int64(statement, 4, (sqlite3_int64)activity.day);
+			sqlite3_bind_double(statement, 5, activity.distanceM);
+			sqlite3_bind_double(statement, 6, activity.stress);
+			sqlite3_bind_text(statement, 7, activity.activityId.c_str(), -1, SQLITE_TRANSIENT);
+			result = sqlite3_step(statement) == SQLITE_DONE;
+			sqlite3_reset(statement);
+		}
+
+		if (result)
+		{
+			result = CommitTransaction();
+		}
+		else
+		{
+			RollbackTransaction();
+		}
+	}
+
+	sqlite3_finalize(statement);
+	return result;
+}
+
+static void ReadTrainingLoadActivityRow(sqlite3_stmt* statement, TrainingLoadActivity& activity)
+{
+	activity.activityId = (const char*)sqlite3_column_text(statement, 0);
+	activity.activityType = (const char*)sqlite3_column_text(statement, 1);
+	activity.startTime = (time_t)sqlite3_column_int64(statement, 2);
+	activity.endTime = (time_t)sqlite3_column_int64(statement, 3);
+	activity.day = (int64_t)sqlite3_column_int64(statement, 4);
+	activity.distanceM = sqlite3_column_double(statement, 5);
+	activity.stress = sqlite3_column_double(statement, 6);
+}
+
+bool Database::RetrieveTrainingLoadActivity(const std::string& activityId, TrainingLoadActivity& activity)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select activity_id, activity_type, start_time, end_time, day, distance, stress from training_load_activity where activity_id = ?", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_text(statement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+
+		if (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			ReadTrainingLoadActivityRow(statement, activity);
+			result = true;
+		}
+
+		sqlite3_finalize(statement);
+	}
+	return result;
+}
+
+bool Database::RetrieveTrainingLoadActivities(time_t startTime, time_t endTime, TrainingLoadActivityList& activities)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select activity_id, activity_type, start_time, end_time, day, distance, stress from training_load_activity where start_time >= ? and start_time < ? order by start_time", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_int64(statement, 1, (sqlite3_int64)startTime);
+		sqlite3_bind_int64(statement, 2, (sqlite3_int64)endTime);
+
+		while (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			TrainingLoadActivity activity;
+
+			ReadTrainingLoadActivityRow(statement, activity);
+			activities.push_back(activity);
+		}
+
+		sqlite3_finalize(statement);
+		result = true;
+	}
+	return result;
+}
+
+bool Database::RetrieveActivitiesWithoutTrainingLoad(ActivitySummaryList& activities)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	// Activities that are still being recorded don't have an end time yet, and are scored when they are stopped.
+	if (sqlite3_prepare_v2(m_pDb, "select activity_id, type, start_time, end_time from activity where end_time > 0 and activity_id not in (select activity_id from training_load_activity) order by start_time", -1, &statement, 0) == SQLITE_OK)
+	{
+		while (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			ActivitySummary summary;
+
+			summary.activityId = (const char*)sqlite3_column_text(statement, 0);
+			summary.type = (const char*)sqlite3_column_text(statement, 1);
+			summary.startTime = (time_t)sqlite3_column_int64(statement, 2);
+			summary.endTime = (time_t)sqlite3_column_int64(statement, 3);
+			summary.pActivity = NULL;
+			activities.push_back(summary);
+		}
+
+		sqlite3_finalize(statement);
+		result = true;
+	}
+	return result;
+}
+
+bool Database::DeleteTrainingLoadActivity(const std::string& activityId)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "delete from training_load_activity where activity_id = ?", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_text(statement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+		result = sqlite3_step(statement) == SQLITE_DONE;
+		sqlite3_finalize(statement);
+	}
+	return result;
+}
+
+bool Database::DeleteAllTrainingLoad(void)
+{
+	const char* queries[] = { "delete from training_load_activity", "delete from training_load_day" };
+	bool result = true;
+
+	for (size_t i = 0; result && i < sizeof(queries) / sizeof(queries[0]); ++i)
+	{
+		int queryResult = ExecuteQuery(queries[i]);
+		result = (queryResult == SQLITE_OK || queryResult == SQLITE_DONE);
+	}
+	return result;
+}
+
+bool Database::RetrieveTrainingLoadDailyStress(int64_t fromDay, std::vector<std::pair<int64_t, double>>& dailyStress)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select day, sum(stress) from training_load_activity where day >= ? group by day order by day", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_int64(statement, 1, (sqlite3_int64)fromDay);
+
+		while (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			dailyStress.push_back(std::make_pair((int64_t)sqlite3_column_int64(statement, 0), sqlite3_column_double(statement, 1)));
+		}
+
+		sqlite3_finalize(statement);
+		result = true;
+	}
+	return result;
+}
+
+static void ReadTrainingLoadDayRow(sqlite3_stmt* statement, TrainingLoadDay& day)
+{
+	day.day = (int64_t)sqlite3_column_int64(statement, 0);
+	day.stress = sqlite3_column_double(statement, 1);
+	day.ctl = sqlite3_column_double(statement, 2);
+	day.atl = sqlite3_column_double(statement, 3);
+	day.tsb = sqlite3_column_double(statement, 4);
+}
+
+bool Database::RetrieveTrainingLoadDays(int64_t firstDay, int64_t lastDay, TrainingLoadDayList& days)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select day, stress, ctl, atl, tsb from training_load_day where day >= ? and day <= ? order by day", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_int64(statement, 1, (sqlite3_int64)firstDay);
+		sqlite3_bind_int64(statement, 2, (sqlite3_int64)lastDay);
+
+		while (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			TrainingLoadDay day;
+
+			ReadTrainingLoadDayRow(statement, day);
+			days.push_back(day);
+		}
+
+		sqlite3_finalize(statement);
+		result = true;
+	}
+	return result;
+}
+
+bool Database::RetrieveTrainingLoadDayBefore(int64_t day, TrainingLoadDay& prevDay)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select day, stress, ctl, atl, tsb from training_load_day where day < ? order by day desc limit 1", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_int64(statement, 1, (sqlite3_int64)day);
+
+		if (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			ReadTrainingLoadDayRow(statement, prevDay);
+			result = true;
+		}
+
+		sqlite3_finalize(statement);
+	}
+	return result;
+}
+
+bool Database::ReplaceTrainingLoadDays(int64_t fromDay, const TrainingLoadDayList& days)
+{
+	sqlite3_stmt* deleteStatement = NULL;
+	sqlite3_stmt* insertStatement = NULL;
+	bool result = false;
+
+	if (sqlite3_prepare_v2(m_pDb, "delete from training_load_day where day >= ?", -1, &deleteStatement, 0) == SQLITE_OK &&
+		sqlite3_prepare_v2(m_pDb, "insert into training_load_day (day,stress,ctl,atl,tsb) values (?,?,?,?,?)", -1, &insertStatement, 0) == SQLITE_OK &&
+		BeginTransaction())
+	{
+		sqlite3_bind_int64(deleteStatement, 1, (sqlite3_int64)fromDay);
+		result = sqlite3_step(deleteStatement) == SQLITE_DONE;
+
+		for (auto iter = days.begin(); result && iter != days.end(); ++iter)
+		{
+			const TrainingLoadDay& day = (*iter);
+
+			sqlite3_bind_int64(insertStatement, 1, (sqlite3_int64)day.day);
+			sqlite3_bind_double(insertStatement, 2, day.stress);
+			sqlite3_bind_double(insertStatement, 3, day.ctl);
+			sqlite3_bind_double(insertStatement, 4, day.atl);
+			sqlite3_bind_double(insertStatement, 5, day.tsb);
+			result = sqlite3_step(insertStatement) == SQLITE_DONE;
+			sqlite3_reset(insertStatement);
+		}
+
+		if (result)
+		{
+			result = CommitTransaction();
+		}
+		else
+		{
+			RollbackTransaction();
+		}
+	}
+
+	sqlite3_finalize(deleteStatement);
+	sqlite3_finalize(insertStatement);
+	return result;
+}
+
+bool Database::CreateZoneTimes(const std::string& activityId, int64_t day, int64_t week, const ZoneTimeList& times)
+{
+	sqlite3_stmt* statement = NULL;
+
+	if (!DeleteZoneTimes(activityId))
+	{
+		return false;
+	}
+
+	int result = sqlite3_prepare_v2(m_pDb, "insert into zone_time_activity values (?,?,?,?,?,?)", -1, &statement, 0);
+	if (result == SQLITE_OK)
+	{
+		result = SQLITE_DONE;
+
+		for (auto iter = times.begin(); iter != times.end() && result == SQLITE_DONE; ++iter)
+		{
+			sqlite3_bind_text(statement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+			sqlite3_bind_int64(statement, 2, day);
+			sqlite3_bind_int64(statement, 3, week);
+			sqlite3_bind_int(statement, 4, (*iter).zoneType);
+			sqlite3_bind_int(statement, 5, (*iter).zone);
+			sqlite3_bind_double(statement, 6, (*iter).seconds);
+			result = sqlite3_step(statement);
+			sqlite3_reset(statement);
+		}
+		sqlite3_finalize(statement);
+	}
+	return result == SQLITE_DONE;
+}
+
+bool Database::RetrieveZoneTimeWeek(const std::string& activityId, int64_t& week)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select week from zone_time_activity where activity_id = ? limit 1", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_text(statement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+
+		if (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			week = (int64_t)sqlite3_column_int64(statement, 0);
+			result = true;
+		}
+		sqlite3_finalize(statement);
+	}
+	return result;
+}
+
+static bool ReadZoneTimes(sqlite3_stmt* statement, ZoneTimeList& times)
+{
+	int result;
+
+	while ((result = sqlite3_step(statement)) == SQLITE_ROW)
+	{
+		ZoneTime time;
+
+		time.zoneType = (ZoneType)sqlite3_column_int(statement, 0);
+		time.zone = (uint8_t)sqlite3_column_int(statement, 1);
+		time.seconds = sqlite3_column_double(statement, 2);
+		times.push_back(time);
+	}
+	return result == SQLITE_DONE;
+}
+
+bool Database::RetrieveZoneTimesForDays(int64_t firstDay, int64_t lastDay, ZoneTimeList& times)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select zone_type, zone, sum(seconds) from zone_time_activity where day >= ? and day <= ? group by zone_type, zone order by zone_type, zone", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_int64(statement, 1, firstDay);
+		sqlite3_bind_int64(statement, 2, lastDay);
+		result = ReadZoneTimes(statement, times);
+		sqlite3_finalize(statement);
+	}
+	return result;
+}
+
+bool Database::RetrieveZoneTimesForWeeks(int64_t firstWeek, int64_t lastWeek, ZoneTimeList& times)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select zone_type, zone, sum(seconds) from zone_time_week where week >= ? and week <= ? group by zone_type, zone order by zone_type, zone", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_int64(statement, 1, firstWeek);
+		sqlite3_bind_int64(statement, 2, lastWeek);
+		result = ReadZoneTimes(statement, times);
+		sqlite3_finalize(statement);
+	}
+	return result;
+}
+
+bool Database::UpdateZoneTimeWeeks(int64_t firstWeek, int64_t lastWeek)
+{
+	const char* queries[] = {
+		"delete from zone_time_week where week >= ?1 and week <= ?2",
+		"insert into zone_time_week select week, zone_type, zone, sum(seconds) from zone_time_activity where week >= ?1 and week <= ?2 group by week, zone_type, zone"
+	};
+	bool result = true;
+
+	for (size_t i = 0; result && i < sizeof(queries) / sizeof(queries[0]); ++i)
+	{
+		sqlite3_stmt* statement = NULL;
+
+		result = false;
+		if (sqlite3_prepare_v2(m_pDb, queries[i], -1, &statement, 0) == SQLITE_OK)
+		{
+			sqlite3_bind_int64(statement, 1, firstWeek);
+			sqlite3_bind_int64(statement, 2, lastWeek);
+			result = sqlite3_step(statement) == SQLITE_DONE;
+			sqlite3_finalize(statement);
+		}
+	}
+	return result;
+}
+
+bool Database::DeleteZoneTimes(const std::string& activityId)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "delete from zone_time_activity where activity_id = ?", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_text(statement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+		result = sqlite3_step(statement) == SQLITE_DONE;
+		sqlite3_finalize(statement);
+	}
+	return result;
+}
+
+bool Database::DeleteAllZoneTimes(void)
+{
+	const char* queries[] = { "delete from zone_time_activity", "delete from zone_time_week" };
+	bool result = true;
+
+	for (size_t i = 0; result && i < sizeof(queries) / sizeof(queries[0]); ++i)
+	{
+		int queryResult = ExecuteQuery(queries[i]);
+		result = (queryResult == SQLITE_OK || queryResult == SQLITE_DONE);
+	}
+	return result;
+}
+
+bool Database::CreatePowerCurve(const std::string& activityId, const PowerCurvePointList& points)
+{
+	sqlite3_stmt* statement = NULL;
+
+	if (!DeletePowerCurve(activityId))
+	{
+		return false;
+	}
+
+	int result = sqlite3_prepare_v2(m_pDb, "insert into power_curve values (?,?,?)", -1, &statement, 0);
+	if (result == SQLITE_OK)
+	{
+		result = SQLITE_DONE;
+
+		for (auto iter = points.begin(); iter != points.end() && result == SQLITE_DONE; ++iter)
+		{
+			sqlite3_bind_text(statement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+			sqlite3_bind_int64(statement, 2, (*iter).durationSecs);
+			sqlite3_bind_double(statement, 3, (*iter).watts);
+			result = sqlite3_step(statement);
+			sqlite3_reset(statement);
+		}
+		sqlite3_finalize(statement);
+	}
+	return result == SQLITE_DONE;
+}
+
+bool Database::RetrieveMeanMaxPowerCurve(const std::vector<std::string>& activityTypes, time_t startTime, time_t endTime, PowerCurvePointList& points)
+{
+	if (activityTypes.empty())
+	{
+		return false;
+	}
+
+	// As with RetrieveBestSummaryValue, the activities come from a range read of the (type, start_time) index for each
+	// type, and each activity's curve is then a range read of the power_curve key.
+	std::string sql = "select c.duration, max(c.watts) from activity a join power_curve c on c.activity_id = a.activity_id where a.type in (?";
+	for (size_t i = 1; i < activityTypes.size(); ++i)
+	{
+		sql += ",?";
+	}
+	sql += ") and a.start_time >= ? and a.start_time < ? group by c.duration order by c.duration";
+
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, sql.c_str(), -1, &statement, 0) == SQLITE_OK)
+	{
+		int paramIndex = 1;
+		int stepResult;
+
+		for (auto iter = activityTypes.begin(); iter != activityTypes.end(); ++iter)
+		{
+			sqlite3_bind_text(statement, paramIndex++, (*iter).c_str(), -1, SQLITE_TRANSIENT);
+		}
+		sqlite3_bind_int64(statement, paramIndex++, (sqlite3_int64)startTime);
+		sqlite3_bind_int64(statement, paramIndex++, (sqlite3_int64)endTime);
+
+		while ((stepResult = sqlite3_step(statement)) == SQLITE_ROW)
+		{
+			PowerCurvePoint point;
+
+			point.durationSecs = (uint32_t)sqlite3_column_int64(statement, 0);
+			point.watts = sqlite3_column_double(statement, 1);
+			points.push_back(point);
+		}
+		result = (stepResult == SQLITE_DONE);
+
+		sqlite3_finalize(statement);
+	}
+	return result;
+}
+
+bool Database::DeletePowerCurve(const std::string& activityId)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "delete from power_curve where activity_id = ?", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_text(statement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+		result = sqlite3_step(statement) == SQLITE_DONE;
+		sqlite3_finalize(statement);
+	}
+	return result;
+}
+
+bool Database::DeleteAllPowerCurves(void)
+{
+	int result = ExecuteQuery("delete from power_curve");
+	return (result == SQLITE_OK || result == SQLITE_DONE);
+}
+
+bool Database::ProcessAllCoordinates(coordinateCallback callback, void* context)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select time,latitude,longitude,altitude from gps", -1, &statement, 0) == SQLITE_OK)
+	{
+		while (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			uint64_t time      = sqlite3_column_int64(statement, 0);
+			double   latitude  = sqlite3_column_double(statement, 1);
+			double   longitude = sqlite3_column_double(statement, 2);
+			double   altitude  = sqlite3_column_double(statement, 3);
+			
+			callback(time, latitude, longitude, altitude, context);
+		}
+
+		sqlite3_finalize(statement);
+		result = true;
+	}
+	return result;
+}
+
+bool Database::ProcessActivityLocationRows(const std::string& activityId, locationRowCallback callback, void* context)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, "select id,time,latitude,longitude from gps where activity_id = ? order by id", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_text(statement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT);
+
+		while (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			callback(sqlite3_column_int64(statement, 0), (uint64_t)sqlite3_column_int64(statement, 1), sqlite3_column_double(statement, 2), sqlite3_column_double(statement, 3), context);
+		}
+
+		sqlite3_finalize(statement);
+		result = true;
+	}
+	return result;
+}
+
+bool Database::ProcessLocationRows(const std::string& activityId, int64_t firstRowId, int64_t lastRowId, locationRowCallback callback, void* context)
+{
+	bool result = false;
+	sqlite3_stmt* statement = NULL;
+
+	// The row id is the primary key, so this reads just the rows in the range. Another activity's locations can be
+	// interleaved with these if both were being written at the same time, hence checking the activity as well. The
+	// unary plus keeps SQLite from using the activity index instead, which would read every one of its locations.
+	if (sqlite3_prepare_v2(m_pDb, "select id,time,latitude,longitude from gps where id >= ? and id <= ? and +activity_id = ? order by id", -1, &statement, 0) == SQLITE_OK)
+	{
+		sqlite3_bind_int64(statement, 1, (sqlite3_int64)firstRowId);
+		sqlite3_bind_int64(statement, 2, (sqlite3_int64)lastRowId);
+		sqlite3_bind_text(statement, 3, activityId.c_str(), -1, SQLITE_TRANSIENT);
+
+		while (sqlite3_step(statement) == SQLITE_ROW)
+		{
+			callback(sqlite3_column_int64(statement, 0), (uint64_t)sqlite3_column_int64(statement, 1), sqlite3_column_double(statement, 2), sqlite3_column_double(statement, 3), context);
+		}
+
+		sqlite3_finalize(statement);
+		result = true;
+	}
+	return result;
+}
+
+bool Database::CreateSensorReading(const std::string& activityId, const SensorReading& reading)
+{
+	switch (reading.type)
+	{
+		case SENSOR_TYPE_UNKNOWN:
+			break;
+		case SENSOR_TYPE_ACCELEROMETER:
+			return CreateAccelerometerReading(activityId, reading);
+		case SENSOR_TYPE_LOCATION:
+			return CreateLocationReading(activityId, reading);
+		case SENSOR_TYPE_HEART_RATE:
+			return CreateHrmReading(activityId, reading);
+		case SENSOR_TYPE_CADENCE:
+			return CreateCadenceReading(activityId, reading);
+		case SENSOR_TYPE_WHEEL_SPEED:
+			return CreateWheelSpeedReading(activityId, reading);
+		case SENSOR_TYPE_POWER:
+			return CreatePowerMeterReading(activityId, reading);
+		case SENSOR_TYPE_FOOT_POD:
+			return CreateFootPodReading(activityId, reading);
+		case SENSOR_TYPE_SCALE:
+			break;
+		case SENSOR_TYPE_LIGHT:
+			break;
+		case SENSOR_TYPE_RADAR:
+			return CreateEventReading(activityId, reading);
+		case SENSOR_TYPE_GOPRO:
+			break;
+		case SENSOR_TYPE_NEARBY:
+			break;
+		case NUM_SENSOR_TYPES:
+			break;
+	}
+	return false;
+}
+
+bool Database::RetrieveSensorReadingsOfType(const std::string& activityId, SensorType type, SensorReadingList& readings)
+{
+	switch (type)
+	{
+		case SENSOR_TYPE_UNKNOWN:
+			break;
+		case SENSOR_TYPE_ACCELEROMETER:
+			return RetrieveActivityAccelerometerReadings(activityId, readings);
+		case SENSOR_TYPE_LOCATION:
+			return RetrieveActivityPositionReadings(activityId, readings);
+		case SENSOR_TYPE_HEART_RATE:
+			return RetrieveActivityHeartRateMonitorReadings(activityId, readings);
+		case SENSOR_TYPE_CADENCE:
+			return RetrieveActivityCadenceReadings(activityId, readings);
+		case SENSOR_TYPE_WHEEL_SPEED:
+			return RetrieveActivityWheelSpeedReadings(activityId, readings);
+		case SENSOR_TYPE_POWER:
+			return RetrieveActivityPowerMeterReadings(activityId, readings);
+		case SENSOR_TYPE_FOOT_POD:
+			return RetrieveActivityFootPodReadings(activityId, readings);
+		case SENSOR_TYPE_SCALE:
+			break;
+		case SENSOR_TYPE_LIGHT:
+			break;
+		case SENSOR_TYPE_RADAR:
+			break;
+		case SENSOR_TYPE_GOPRO:
+			break;
+		case SENSOR_TYPE_NEARBY:
+			break;
+		case NUM_SENSOR_TYPES:
+			break;
+	}
+	return false;
+}
+
+bool Database::OpenSensorCursor(const std::string& activityId, SensorType type, SensorCursor& cursor)
+{
+	std::string sql;
+	size_t numValues = 1;
+
+	// Readings are appended as they are recorded, so id order is time order. The activity_id index is ordered
+	// by id within each activity, so this doesn't need a sort.
+	switch (type)
+	{
+		case SENSOR_TYPE_ACCELEROMETER:
+			sql = "select time,x,y,z from accelerometer where activity_id = ? order by id";
+			numValues = 3;
+			break;
+		case SENSOR_TYPE_LOCATION:
+			sql = "select time,latitude,longitude,altitude from gps where activity_id = ? order by id";
+			numValues = 3;
+			break;
+		case SENSOR_TYPE_HEART_RATE:
+			sql = "select time,value from hrm where activity_id = ? order by id";
+			break;
+		case SENSOR_TYPE_CADENCE:
+			sql = "select time,value from cadence where activity_id = ? order by id";
+			break;
+		case SENSOR_TYPE_WHEEL_SPEED:
+			sql = "select time,value from wheel_speed where activity_id = ? order by id";
+			break;
+		case SENSOR_TYPE_POWER:
+			sql = "select time,value from power_meter where activity_id = ? order by id";
+			break;
+		case SENSOR_TYPE_FOOT_POD:
+			sql = "select time,value from foot_pod where activity_id = ? order by id";
+			break;
+		default:
+			cursor.Close();
+			return false;
+	}
+
+	sqlite3_stmt* statement = NULL;
+
+	if (sqlite3_prepare_v2(m_pDb, sql.c_str(), -1, &statement, 0) == SQLITE_OK)
+	{
+		if (sqlite3_bind_text(statement, 1, activityId.c_str(), -1, SQLITE_TRANSIENT) == SQLITE_OK)
+		{
+			cursor.Attach(statement, numValues);
+			return !cursor.Failed();
+		}
+		sqlite3_finalize(statement);
+	}
+	cursor.Close();
 	return false;
 }
 
@@ -2981,6 +4987,80 @@ bool Database::TrimActivityFootPodReadings(const std::string& activityId, uint64
 	return result;
 }
 
+bool Database::InsertRows(const std::string& tableName, size_t numParams, size_t numRows, BindRowFunc bindRow)
+{
+	size_t rowsPerInsert = MAX_PARAMS_PER_INSERT / numParams;
+	if (rowsPerInsert > MAX_ROWS_PER_INSERT)
+		rowsPerInsert = MAX_ROWS_PER_INSERT;
+
+	// Builds "insert into <table> values (NULL,?,?),(NULL,?,?),..." for the given number of rows.
+	auto buildQuery = [&](size_t rowCount) {
+		std::string rowStr = "(NULL";
+		for (size_t i = 0; i < numParams; ++i)
+			rowStr += ",?";
+		rowStr += ")";
+
+		std::string query = "insert into " + tableName + " values ";
+		query.reserve(query.size() + rowCount * (rowStr.size() + 1));
+		for (size_t i = 0; i < rowCount; ++i)
+		{
+			if (i > 0)
+				query += ",";
+			query += rowStr;
+		}
+		return query;
+	};
+
+	// Steps the statement once for the given rows, then resets it so it can be reused.
+	auto insertRows = [&](sqlite3_stmt* statement, size_t firstRow, size_t rowCount) {
+		for (size_t i = 0; i < rowCount; ++i)
+		{
+			bindRow(statement, (int)(i * numParams) + 1, firstRow + i);
+		}
+
+		int result = sqlite3_step(statement);
+
+		sqlite3_clear_bindings(statement);
+		sqlite3_reset(statement);
+		return result == SQLITE_DONE;
+	};
+
+	bool result = true;
+	size_t row = 0;
+	size_t numFullInserts = numRows / rowsPerInsert;
+
+	// The full size statement is prepared once and reused for every chunk.
+	if (numFullInserts > 0)
+	{
+		sqlite3_stmt* statement = NULL;
+
+		if (sqlite3_prepare_v2(m_pDb, buildQuery(rowsPerInsert).c_str(), -1, &statement, 0) != SQLITE_OK)
+		{
+			return false;
+		}
+		for (size_t i = 0; result && i < numFullInserts; ++i, row += rowsPerInsert)
+		{
+			result = insertRows(statement, row, rowsPerInsert);
+		}
+		sqlite3_finalize(statement);
+	}
+
+	// Whatever is left over.
+	if (result && row < numRows)
+	{
+		sqlite3_stmt* statement = NULL;
+		size_t remainder = numRows - row;
+
+		if (sqlite3_prepare_v2(m_pDb, buildQuery(remainder).c_str(), -1, &statement, 0) != SQLITE_OK)
+		{
+			return false;
+		}
+		result = insertRows(statement, row, remainder);
+		sqlite3_finalize(statement);
+	}
+	return result;
+}
+
 int Database::ExecuteQuery(const std::string& query)
 {
 	sqlite3_stmt* statement = NULL;
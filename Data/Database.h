@@ -8,6 +8,9 @@
 #ifndef __DATABASE__
 #define __DATABASE__
 
+#include <functional>
+#include <set>
+#include <unordered_map>
 #include <vector>
 #include <sstream>
 #include <sqlite3.h>
@@ -16,17 +19,24 @@
 #include "ActivityAttributeType.h"
 #include "ActivitySummary.h"
 #include "ActivityViewType.h"
+#include "BestEffort.h"
 #include "Bike.h"
 #include "Callbacks.h"
 #include "Coordinate.h"
+#include "GeoIndexChunk.h"
+#include "ImportBatch.h"
 #include "IntervalSession.h"
 #include "MovingActivity.h"
 #include "PacePlan.h"
+#include "PowerCurvePoint.h"
 #include "Route.h"
+#include "SensorCursor.h"
 #include "SensorReading.h"
 #include "ServiceHistory.h"
 #include "Shoes.h"
+#include "TrainingLoadDay.h"
 #include "Workout.h"
+#include "ZoneTime.h"
 
 class Database
 {
@@ -35,7 +45,10 @@ public:
 	virtual ~Database();
 
 	bool Open(const std::string& dbFileName);
+	bool OpenReadOnly(const std::string& dbFileName); // A second connection, for reading from another thread
 	bool Close(void);
+	std::string GetFileName(void) const; // Empty for an in-memory database
+	bool SetBusyTimeout(int timeoutMs); // How long to wait for another connection to finish, rather than failing
 
 	bool CreateTables(void);
 	bool DeleteTables(void);
@@ -43,6 +56,12 @@ public:
 	void DeleteStatements(void);
 	bool Reset(void);
 
+	// Methods for grouping statements so that they succeed or fail together.
+
+	bool BeginTransaction(void);
+	bool CommitTransaction(void);
+	bool RollbackTransaction(void);
+
 	// Methods for managing the bicycle inventory.
 
 	bool CreateBike(const Bike& bike);
@@ -103,11 +122,21 @@ public:
 	bool CreateRoute(const std::string& routeId, const std::string& name, const std::string& description);
 	bool CreateRoutePoint(const std::string& routeId, const Coordinate& coordinate);
 	bool RetrieveRoutes(std::vector<Route>& routes);
+	bool RetrieveRoutes(std::vector<Route>& routes, double maxToleranceM);
 	bool RetrieveRoute(const std::string& routeId);
 	bool RetrieveRouteCoordinates(const std::string& routeId, CoordinateList& coordinates);
 	bool DeleteRoute(const std::string& routeId);
 	bool DeleteRouteCoordinates(const std::string& routeId);
 
+	/// @brief Stores the route at full resolution and simplified to each of ROUTE_POLYLINE_TOLERANCES_M, each as a single encoded row.
+	bool CreateRoutePolylines(const std::string& routeId, const CoordinateList& coordinates);
+
+	/// @brief Retrieves the coarsest stored version of the route that is within maxToleranceM of the original.
+	bool RetrieveRoutePolyline(const std::string& routeId, double maxToleranceM, CoordinateList& coordinates, double& toleranceM);
+	bool RetrieveRouteIdsWithinBox(const GeoBoundingBox& box, std::vector<std::string>& routeIds); // Routes that lie entirely inside the box
+	bool RetrieveRouteIdsNotInRouteIndex(std::vector<std::string>& routeIds); // Routes stored before they had a bounding box
+	bool DeleteRoutePolylines(const std::string& routeId);
+
 	// Methods for managing activities.
 
 	bool StartActivity(const std::string& activityId, const std::string& userId, const std::string& activityType, const std::string& activityDescription, time_t startTime);
@@ -115,6 +144,11 @@ public:
 	bool DeleteActivity(const std::string& activityId);
 	bool RetrieveActivity(const std::string& activityId, ActivitySummary& summary);
 	bool RetrieveActivities(ActivitySummaryList& activities);
+
+	/// @brief Calls the callback for each activity, in activity ID order, one row at a time. Returning FALSE stops.
+	typedef bool (*activityCallback)(const ActivitySummary& summary, void* context);
+	bool ProcessAllActivities(activityCallback callback, void* context);
+
 	bool MergeActivities(const std::string& activityId1, const std::string& activityId2);
 
 	bool RetrieveActivityStartAndEndTime(const std::string& activityId, time_t& startTime, time_t& endTime);
@@ -128,6 +162,10 @@ public:
 	bool UpdateActivityDescription(const std::string& activityId, const std::string& description);
 
 	bool CreateLap(const std::string& activityId, const LapSummary& lap);
+
+	/// @brief Writes an entire parsed activity (activity row, readings, laps, and hash) in a single transaction.
+	/// Either all of it is stored or none of it is.
+	bool CreateImportedActivity(const ImportBatch& batch);
 	bool RetrieveLaps(const std::string& activityId, LapSummaryList& laps);
 
 	// Methods for managing tags.
@@ -141,6 +179,17 @@ public:
 
 	bool CreateSummaryData(const std::string& activityId, const std::string& attribute, ActivityAttributeType value);
 	bool RetrieveSummaryData(const std::string& activityId, ActivityAttributeMap& values);
+	bool DeleteSummaryData(const std::string& activityId);
+
+	// Methods for tracking which version of the activity code computed each activity's summary (see SummaryRecomputer).
+
+	bool UpdateSummaryVersion(const std::string& activityId, uint32_t version);
+	bool RetrieveActivitiesWithStaleSummaries(uint32_t version, ActivitySummaryList& activities); // Summaries computed before the given version, oldest first
+	bool DeleteAllSummaryVersions(void);
+
+	/// @brief Finds the highest (or lowest) stored summary value of the attribute, among activities of the given types
+	/// that started in [startTime, endTime). Returns false if there isn't one.
+	bool RetrieveBestSummaryValue(const std::vector<std::string>& activityTypes, const std::string& attribute, time_t startTime, time_t endTime, bool smallestIsBest, std::string& activityId, double& value);
 
 	// Methods for managing activity hashes.
 
@@ -149,6 +198,12 @@ public:
 	bool RetrieveHashForActivityId(const std::string& activityId, std::string& hash);
 	bool UpdateActivityHash(const std::string& activityId, const std::string& hash);
 
+	// Methods for managing activity state snapshots (derived state that would otherwise be rebuilt by replaying the sensor data).
+
+	bool CreateActivitySnapshot(const std::string& activityId, uint32_t version, const std::vector<uint8_t>& state);
+	bool RetrieveActivitySnapshot(const std::string& activityId, uint32_t& version, std::vector<uint8_t>& state);
+	bool DeleteActivitySnapshot(const std::string& activityId);
+
 	// Methods for managing activity sync status.
 
 	bool CreateActivitySync(const std::string& activityId, const std::string& destination);
@@ -163,11 +218,81 @@ public:
 	bool RetrieveNewestWeightMeasurement(time_t& measurementTime, double& weightKg);
 	bool RetrieveAllWeightMeasurements(std::vector<std::pair<time_t, double>>& measurements);
 
+	// Methods for managing the heat map (see HeatMapGenerator).
+
+	bool RetrieveActivityIdsNotInHeatMap(std::vector<std::string>& activityIds);
+	bool RetrieveHeatMapActivityCount(size_t& numActivities);
+	bool IsActivityInHeatMap(const std::string& activityId);
+	bool AddHeatMapCounts(const std::unordered_map<uint64_t, uint32_t>& counts, const std::vector<std::string>& activityIds);
+	bool SubtractHeatMapCounts(const std::unordered_map<uint64_t, uint32_t>& counts, const std::string& activityId);
+
+	/// @brief Calls the callback for each cell with a key from firstKey up to, but not including, lastKey, in key order.
+	typedef void (*heatMapCellCallback)(uint64_t key, uint32_t count, void* context);
+	bool ProcessHeatMapCells(uint64_t firstKey, uint64_t lastKey, heatMapCellCallback callback, void* context);
+
+	// Methods for managing the geospatial index (see GeoIndex).
+
+	bool CreateGeoIndexEntries(const std::string& activityId, const std::vector<GeoIndexChunk>& chunks);
+	bool RetrieveActivityIdsNotInGeoIndex(size_t maxActivities, std::vector<std::string>& activityIds);
+	bool RetrieveGeoIndexActivityIds(const GeoBoundingBox& box, std::vector<std::string>& activityIds);
+	bool RetrieveGeoIndexChunks(const GeoBoundingBox& box, std::vector<GeoIndexChunk>& chunks);
+	bool DeleteGeoIndexEntries(const std::string& activityId);
+
+	// Methods for managing best efforts and personal records (see PersonalRecords).
+
+	/// @brief Replaces the best efforts of each of the activities, and refreshes the affected personal records, in a
+	/// single transaction. Unless replace is set, activities that already have their best efforts are left alone.
+	bool CreateBestEfforts(const std::vector<std::string>& activityIds, const BestEffortList& efforts, bool replace);
+	bool RetrieveActivitiesWithoutBestEfforts(ActivitySummaryList& activities);
+	bool RetrieveBestEfforts(const std::string& activityId, BestEffortList& efforts);
+	bool RetrievePersonalRecord(const std::string& activityType, double distanceM, BestEffort& record);
+	bool RetrievePersonalRecords(const std::string& activityType, BestEffortList& records);
+	bool DeleteBestEfforts(const std::string& activityId);
+	bool DeleteAllBestEfforts(void);
+	bool CreateBestEffortDistance(double distanceM);
+	bool RetrieveBestEffortDistances(std::vector<double>& distancesM); // Appends the user's distances, in order
+	bool DeleteBestEffortDistance(double distanceM);
+
+	// Methods for managing training load (see TrainingLoad).
+
+	bool CreateTrainingLoadActivities(const TrainingLoadActivityList& activities); // Replaces any existing scores, in a single transaction
+	bool RetrieveTrainingLoadActivity(const std::string& activityId, TrainingLoadActivity& activity);
+	bool RetrieveTrainingLoadActivities(time_t startTime, time_t endTime, TrainingLoadActivityList& activities);
+	bool RetrieveActivitiesWithoutTrainingLoad(ActivitySummaryList& activities);
+	bool DeleteTrainingLoadActivity(const std::string& activityId);
+	bool DeleteAllTrainingLoad(void);
+	bool RetrieveTrainingLoadDailyStress(int64_t fromDay, std::vector<std::pair<int64_t, double>>& dailyStress); // Total stress of each day with activities, in order
+	bool RetrieveTrainingLoadDays(int64_t firstDay, int64_t lastDay, TrainingLoadDayList& days);
+	bool RetrieveTrainingLoadDayBefore(int64_t day, TrainingLoadDay& prevDay); // False if there isn't one
+	bool ReplaceTrainingLoadDays(int64_t fromDay, const TrainingLoadDayList& days); // Replaces every day from fromDay on, in a single transaction
+
+	// Methods for managing time in zone (see ZoneTimeRollup). None of them start a transaction, so they can be part of the caller's.
+
+	bool CreateZoneTimes(const std::string& activityId, int64_t day, int64_t week, const ZoneTimeList& times); // Replaces the activity's existing times
+	bool RetrieveZoneTimeWeek(const std::string& activityId, int64_t& week); // False if the activity doesn't have any times
+	bool RetrieveZoneTimesForDays(int64_t firstDay, int64_t lastDay, ZoneTimeList& times); // Totals of the activities on those days
+	bool RetrieveZoneTimesForWeeks(int64_t firstWeek, int64_t lastWeek, ZoneTimeList& times); // Totals of the weekly rollup
+	bool UpdateZoneTimeWeeks(int64_t firstWeek, int64_t lastWeek); // Rolls up the activities' times again, for those weeks
+	bool DeleteZoneTimes(const std::string& activityId);
+	bool DeleteAllZoneTimes(void);
+
+	// Methods for managing mean maximal power curves (see CriticalPower).
+
+	bool CreatePowerCurve(const std::string& activityId, const PowerCurvePointList& points); // Replaces the activity's existing curve
+	bool RetrieveMeanMaxPowerCurve(const std::vector<std::string>& activityTypes, time_t startTime, time_t endTime, PowerCurvePointList& points); // Best of the activities' curves, shortest duration first
+	bool DeletePowerCurve(const std::string& activityId);
+	bool DeleteAllPowerCurves(void);
+
 	// Methods for retrieving activity sensor data.
 
 	typedef void (*coordinateCallback)(uint64_t time, double latitude, double longitude, double altitude, void* context);
 	bool ProcessAllCoordinates(coordinateCallback callback, void* context);
 
+	/// @brief Calls the callback for each of the activity's locations along with its row in the gps table, in the order they were recorded.
+	typedef void (*locationRowCallback)(int64_t rowId, uint64_t time, double latitude, double longitude, void* context);
+	bool ProcessActivityLocationRows(const std::string& activityId, locationRowCallback callback, void* context);
+	bool ProcessLocationRows(const std::string& activityId, int64_t firstRowId, int64_t lastRowId, locationRowCallback callback, void* context);
+
 	bool CreateSensorReading(const std::string& activityId, const SensorReading& reading);
 	bool RetrieveSensorReadingsOfType(const std::string& activityId, SensorType type, SensorReadingList& readings);
 	bool RetrieveActivityPositionReadings(const std::string& activityId, CoordinateList& coordinates);
@@ -181,6 +306,10 @@ public:
 	bool RetrieveActivityFootPodReadings(const std::string& activityId, SensorReadingList& readings);
 	bool RetrieveActivityEventReadings(const std::string& activityId, SensorReadingList& readings);
 
+	/// @brief Opens a cursor over the readings of the given type, in the order they were recorded, without loading them.
+	/// Location and accelerometer cursors have three values (latitude, longitude, altitude or x, y, z), the others have one.
+	bool OpenSensorCursor(const std::string& activityId, SensorType type, SensorCursor& cursor);
+
 	// Methods for trimming activity data.
 
 	bool TrimActivityPositionReadings(const std::string& activityId, uint64_t timeStamp, bool fromStart);
@@ -217,6 +346,13 @@ private:
 	bool CreateFootPodReading(const std::string& activityId, const SensorReading& reading);
 	bool CreateEventReading(const std::string& activityId, const SensorReading& reading);
 
+	typedef std::function<void(sqlite3_stmt* statement, int firstParam, size_t row)> BindRowFunc;
+	bool InsertRows(const std::string& tableName, size_t numParams, size_t numRows, BindRowFunc bindRow);
+
+	typedef std::set<std::pair<std::string, double>> PersonalRecordKeys; // activity type and distance
+	bool DeleteBestEffortRows(const std::string& activityId, PersonalRecordKeys& keys);
+	bool RefreshPersonalRecords(const PersonalRecordKeys& keys);
+
 	int ExecuteQuery(const std::string& query);
 	int ExecuteQueries(const std::vector<std::string>& queries);
 };
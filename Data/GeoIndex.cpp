@@ -0,0 +1,322 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "GeoIndex.h"
+#include "Distance.h"
+
+#include <math.h>
+
+#define METERS_PER_DEGREE_LATITUDE 111319.49
+
+typedef struct ChunkBuilder
+{
+	std::vector<GeoIndexChunk> chunks;
+	GeoIndexChunk              current;
+	size_t                     numPoints; // Locations in the current chunk
+} ChunkBuilder;
+
+static void FlushChunk(ChunkBuilder* pBuilder)
+{
+	if (pBuilder->numPoints > 0)
+	{
+		pBuilder->chunks.push_back(pBuilder->current);
+		pBuilder->current.chunkNum++;
+		pBuilder->numPoints = 0;
+	}
+}
+
+static void AddLocationRow(int64_t rowId, uint64_t time, double latitude, double longitude, void* context)
+{
+	ChunkBuilder* pBuilder = (ChunkBuilder*)context;
+	GeoIndexChunk& chunk = pBuilder->current;
+
+	if (isnan(latitude) || isnan(longitude))
+	{
+		return;
+	}
+
+	if (pBuilder->numPoints == 0)
+	{
+		chunk.firstRowId = rowId;
+		chunk.startTime = time;
+		chunk.box.minLatitude = chunk.box.maxLatitude = latitude;
+		chunk.box.minLongitude = chunk.box.maxLongitude = longitude;
+	}
+	else
+	{
+		if (latitude < chunk.box.minLatitude)
+			chunk.box.minLatitude = latitude;
+		if (latitude > chunk.box.maxLatitude)
+			chunk.box.maxLatitude = latitude;
+		if (longitude < chunk.box.minLongitude)
+			chunk.box.minLongitude = longitude;
+		if (longitude > chunk.box.maxLongitude)
+			chunk.box.maxLongitude = longitude;
+	}
+	chunk.lastRowId = rowId;
+	chunk.endTime = time;
+
+	if (++pBuilder->numPoints >= GEO_INDEX_POINTS_PER_CHUNK)
+	{
+		FlushChunk(pBuilder);
+	}
+}
+
+typedef struct MatchState
+{
+	GeoIndexMatchList* pMatches;
+	GeoIndexMatch      current;
+	bool               inside; // TRUE if the previous location was inside the area
+	const void*        area;
+	bool               (*contains)(double latitude, double longitude, const void* area);
+} MatchState;
+
+static void EndMatch(MatchState* pState)
+{
+	if (pState->inside)
+	{
+		pState->pMatches->push_back(pState->current);
+		pState->inside = false;
+	}
+}
+
+static void MatchLocationRow(int64_t, uint64_t time, double latitude, double longitude, void* context)
+{
+	MatchState* pState = (MatchState*)context;
+
+	if (isnan(latitude) || isnan(longitude))
+	{
+		return;
+	}
+
+	if (pState->contains(latitude, longitude, pState->area))
+	{
+		if (!pState->inside)
+		{
+			pState->current.startTime = time;
+			pState->inside = true;
+		}
+		pState->current.endTime = time;
+	}
+	else
+	{
+		EndMatch(pState);
+	}
+}
+
+static bool BoxContains(double latitude, double longitude, const void* area)
+{
+	const GeoBoundingBox* pBox = (const GeoBoundingBox*)area;
+
+	return latitude >= pBox->minLatitude && latitude <= pBox->maxLatitude &&
+	       longitude >= pBox->minLongitude && longitude <= pBox->maxLongitude;
+}
+
+typedef struct Circle
+{
+	double latitude;
+	double longitude;
+	double radiusM;
+} Circle;
+
+static bool CircleContains(double latitude, double longitude, const void* area)
+{
+	const Circle* pCircle = (const Circle*)area;
+
+	return LibMath::Distance::haversineDistance(pCircle->latitude, pCircle->longitude, 0.0, latitude, longitude, 0.0) <= pCircle->radiusM;
+}
+
+GeoIndex::GeoIndex()
+{
+}
+
+GeoIndex::~GeoIndex()
+{
+}
+
+bool GeoIndex::IndexActivity(Database& db, const std::string& activityId)
+{
+	ChunkBuilder builder;
+
+	builder.current.activityId = activityId;
+	builder.current.chunkNum = 0;
+	builder.numPoints = 0;
+
+	if (!db.ProcessActivityLocationRows(activityId, AddLocationRow, &builder))
+	{
+		return false;
+	}
+	FlushChunk(&builder);
+
+	// Activities without any locations are still recorded, so the backfill knows they're done.
+	return db.CreateGeoIndexEntries(activityId, builder.chunks);
+}
+
+bool GeoIndex::Query(Database& db, const GeoBoundingBox& searchBox, ContainsFunc contains, const void* area, GeoIndexMatchList& matches)
+{
+	std::vector<GeoIndexChunk> chunks;
+
+	// Chunks come back sorted by activity, then by position in the activity.
+	if (!db.RetrieveGeoIndexChunks(searchBox, chunks))
+	{
+		return false;
+	}
+
+	MatchState state;
+	const GeoIndexChunk* pPrevChunk = NULL;
+	bool result = true;
+
+	state.pMatches = &matches;
+	state.inside = false;
+	state.area = area;
+	state.contains = contains;
+
+	for (auto iter = chunks.begin(); result && iter != chunks.end(); ++iter)
+	{
+		const GeoIndexChunk& chunk = (*iter);
+
+		// A visit can only carry on from the previous chunk if that chunk was the one right before this one. If a
+		// chunk in between was skipped then none of its locations were in the area, so the visit ended there.
+		if (!pPrevChunk || pPrevChunk->activityId.compare(chunk.activityId) != 0 || pPrevChunk->chunkNum + 1 != chunk.chunkNum)
+		{
+			EndMatch(&state);
+			state.current.activityId = chunk.activityId;
+		}
+
+		result = db.ProcessLocationRows(chunk.activityId, chunk.firstRowId, chunk.lastRowId, MatchLocationRow, &state);
+		pPrevChunk = &chunk;
+	}
+	EndMatch(&state);
+
+	return result;
+}
+
+bool GeoIndex::QueryBoundingBox(Database& db, const GeoBoundingBox& box, GeoIndexMatchList& matches)
+{
+	if (box.minLatitude > box.maxLatitude || box.minLongitude > box.maxLongitude)
+	{
+		return false;
+	}
+	return Query(db, box, BoxContains, &box, matches);
+}
+
+bool GeoIndex::QueryActivities(Database& db, const GeoBoundingBox& box, std::vector<std::string>& activityIds)
+{
+	if (box.minLatitude > box.maxLatitude || box.minLongitude > box.maxLongitude)
+	{
+		return false;
+	}
+	return db.RetrieveGeoIndexActivityIds(box, activityIds);
+}
+
+bool GeoIndex::QueryRadius(Database& db, double latitude, double longitude, double radiusM, GeoIndexMatchList& matches)
+{
+	if (radiusM < (double)0.0)
+	{
+		return false;
+	}
+
+	Circle circle;
+	GeoBoundingBox searchBox;
+	double latitudeDelta = radiusM / METERS_PER_DEGREE_LATITUDE;
+	double cosLatitude = cos((fabs(latitude) + latitudeDelta) * M_PI / 180.0);
+
+	circle.latitude = latitude;
+	circle.longitude = longitude;
+	circle.radiusM = radiusM;
+
+	searchBox.minLatitude = fmax(latitude - latitudeDelta, -90.0);
+	searchBox.maxLatitude = fmin(latitude + latitudeDelta, 90.0);
+
+	// Degrees of longitude shrink towards the poles, so widen the box using the latitude nearest the pole. Circles that
+	// reach the pole or cross the antimeridian search every longitude, which is slower but still correct.
+	if (cosLatitude > (double)0.0 && searchBox.maxLatitude < 90.0 && searchBox.minLatitude > -90.0)
+	{
+		double longitudeDelta = latitudeDelta / cosLatitude;
+
+		searchBox.minLongitude = longitude - longitudeDelta;
+		searchBox.maxLongitude = longitude + longitudeDelta;
+	}
+	else
+	{
+		searchBox.minLongitude = -180.0;
+		searchBox.maxLongitude = 180.0;
+	}
+	if (searchBox.minLongitude < -180.0 || searchBox.maxLongitude > 180.0)
+	{
+		searchBox.minLongitude = -180.0;
+		searchBox.maxLongitude = 180.0;
+	}
+
+	return Query(db, searchBox, CircleContains, &circle, matches);
+}
+
+GeoIndexBackfill::GeoIndexBackfill(Database* pDb, std::mutex& dbLock) :
+	m_pDb(pDb),
+	m_dbLock(dbLock)
+{
+	m_numIndexed = 0;
+}
+
+GeoIndexBackfill::~GeoIndexBackfill()
+{
+	Stop();
+}
+
+bool GeoIndexBackfill::Start(void)
+{
+	if (!m_pDb)
+	{
+		return false;
+	}
+	if (m_job.IsRunning())
+	{
+		return true;
+	}
+
+	m_numIndexed = 0;
+	return m_job.Start([this](const std::atomic<bool>& stop) { Run(stop); });
+}
+
+void GeoIndexBackfill::Stop(void)
+{
+	m_job.Stop();
+}
+
+void GeoIndexBackfill::Run(const std::atomic<bool>& stop)
+{
+	GeoIndex index;
+	bool result = true;
+
+	while (result && !stop)
+	{
+		std::vector<std::string> activityIds;
+
+		m_dbLock.lock();
+		result = m_pDb->RetrieveActivityIdsNotInGeoIndex(GEO_INDEX_BACKFILL_BATCH_SIZE, activityIds);
+		m_dbLock.unlock();
+
+		if (activityIds.empty())
+		{
+			break;
+		}
+
+		for (auto iter = activityIds.begin(); result && !stop && iter != activityIds.end(); ++iter)
+		{
+			// Give up rather than retry, an activity that can't be indexed now won't be indexed on the next pass either.
+			m_dbLock.lock();
+			result = index.IndexActivity(*m_pDb, (*iter));
+			m_dbLock.unlock();
+
+			if (result)
+			{
+				++m_numIndexed;
+			}
+			std::this_thread::yield();
+		}
+	}
+}
@@ -0,0 +1,101 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __GEOINDEX__
+#define __GEOINDEX__
+
+#pragma once
+
+#include "BackgroundJob.h"
+#include "Database.h"
+#include "GeoIndexChunk.h"
+
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define GEO_INDEX_POINTS_PER_CHUNK    64 // Locations covered by each chunk's bounding box
+#define GEO_INDEX_BACKFILL_BATCH_SIZE 32 // Activities looked up at a time by the backfill
+
+typedef struct GeoIndexMatch
+{
+	std::string activityId;
+	uint64_t    startTime; // time in milliseconds of the first location inside the area
+	uint64_t    endTime;   // time in milliseconds of the last location inside the area, before the track leaves it
+} GeoIndexMatch;
+
+typedef std::vector<GeoIndexMatch> GeoIndexMatchList;
+
+/**
+* Finds the activities, and the parts of them, that passed through an area.
+*
+* Each activity's track is cut into chunks of GEO_INDEX_POINTS_PER_CHUNK locations and the bounding box of each chunk
+* is stored in an R*Tree, along with the bounding box of the whole activity. A query finds the chunks whose boxes
+* overlap the area, then reads just those chunks' locations to find where the track actually was inside it. Each
+* visit to the area is returned as a separate match, so an out and back through the same spot gives two.
+*
+* All methods expect the caller to hold the database lock.
+*/
+class GeoIndex
+{
+public:
+	GeoIndex();
+	virtual ~GeoIndex();
+
+	/// @brief Indexes the activity's locations, replacing anything already indexed for it.
+	bool IndexActivity(Database& db, const std::string& activityId);
+
+	/// @brief Finds the activities with locations inside the box. The box must not cross the antimeridian.
+	bool QueryBoundingBox(Database& db, const GeoBoundingBox& box, GeoIndexMatchList& matches);
+
+	/// @brief Finds the activities whose overall bounding box overlaps the box, without reading any locations. Quicker
+	/// than QueryBoundingBox, but an activity that went around the box without entering it is also returned.
+	bool QueryActivities(Database& db, const GeoBoundingBox& box, std::vector<std::string>& activityIds);
+
+	/// @brief Finds the activities with locations within the given distance of a point.
+	bool QueryRadius(Database& db, double latitude, double longitude, double radiusM, GeoIndexMatchList& matches);
+
+private:
+	typedef bool (*ContainsFunc)(double latitude, double longitude, const void* area);
+
+	bool Query(Database& db, const GeoBoundingBox& searchBox, ContainsFunc contains, const void* area, GeoIndexMatchList& matches);
+};
+
+/**
+* Indexes every activity recorded before the geospatial index existed, on a background thread.
+*
+* Activities are indexed one at a time, each in its own transaction, and the database lock is released between them
+* so the foreground is never held up for long. The index itself records which activities are done, so a backfill
+* that is stopped, or cut short by the app being closed, picks up where it left off the next time it is started.
+*/
+class GeoIndexBackfill
+{
+public:
+	GeoIndexBackfill(Database* pDb, std::mutex& dbLock);
+	virtual ~GeoIndexBackfill();
+
+	/// @brief Starts the background thread, does nothing if it is already running.
+	bool Start(void);
+
+	/// @brief Asks the background thread to stop and waits for the activity it is working on to finish.
+	void Stop(void);
+
+	bool IsRunning(void) const { return m_job.IsRunning(); };
+	size_t NumIndexed(void) const { return m_numIndexed; };
+
+private:
+	Database*           m_pDb;
+	std::mutex&         m_dbLock;
+	BackgroundJob       m_job;
+	std::atomic<size_t> m_numIndexed; // Activities indexed since the backfill was started
+
+	void Run(const std::atomic<bool>& stop);
+};
+
+#endif
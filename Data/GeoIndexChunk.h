@@ -0,0 +1,35 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __GEOINDEXCHUNK__
+#define __GEOINDEXCHUNK__
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+typedef struct GeoBoundingBox
+{
+	double minLatitude;
+	double maxLatitude;
+	double minLongitude;
+	double maxLongitude;
+} GeoBoundingBox;
+
+typedef struct GeoIndexChunk
+{
+	std::string    activityId;
+	uint32_t       chunkNum;   // position of the chunk within the activity, starting at zero
+	int64_t        firstRowId; // first and last rows of the gps table covered by the chunk
+	int64_t        lastRowId;
+	uint64_t       startTime;  // time in milliseconds
+	uint64_t       endTime;    // time in milliseconds
+	GeoBoundingBox box;
+} GeoIndexChunk;
+
+#endif
@@ -6,45 +6,281 @@
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include "HeatMapGenerator.h"
-#include "Distance.h"
+#include "BackgroundJob.h"
+#include "SensorCursor.h"
 
+#include <algorithm>
 #include <math.h>
+#include <string.h>
 
-void HeatMapDatabaseCallback(uint64_t time, double latitude, double longitude, double altitude, void* context)
+#define MAX_MERCATOR_LATITUDE 85.05112878 // Web mercator is square, which cuts off everything beyond this
+
+// Number of cells across the whole world at the most detailed zoom level.
+#define HEAT_MAP_WORLD_CELL_BITS (HEAT_MAP_MAX_ZOOM + HEAT_MAP_CELL_BITS)
+
+HeatMapGenerator::HeatMapGenerator() :
+	m_queue(HEAT_MAP_MAX_QUEUED_TRACKS)
 {
-	HeatMap* pHeatmap = (HeatMap*)context;
+	m_numWorkers = WorkerPool::DefaultNumWorkers();
+}
 
-	Coordinate newCoordinate;
-	newCoordinate.latitude = latitude;
-	newCoordinate.longitude = longitude;
-	newCoordinate.altitude = altitude;
+HeatMapGenerator::~HeatMapGenerator()
+{
+}
+
+void HeatMapGenerator::CountTrack(const std::vector<Coordinate>& track, HeatMapCellCounts& counts)
+{
+	const double worldCells = (double)(1 << HEAT_MAP_WORLD_CELL_BITS);
+	const uint32_t maxCell = (1 << HEAT_MAP_WORLD_CELL_BITS) - 1;
 
-	HeatMap::iterator iter = pHeatmap->begin();
-	while (iter != pHeatmap->end())
+	uint64_t prevKeys[HEAT_MAP_MAX_ZOOM + 1];
+	bool havePrev = false;
+
+	for (auto iter = track.begin(); iter != track.end(); ++iter)
 	{
-		const Coordinate& oldCoordinate = (*iter).coord;
+		double latitude = (*iter).latitude;
+		double longitude = (*iter).longitude;
 
-		if (oldCoordinate.latitude > newCoordinate.latitude)
+		if (isnan(latitude) || isnan(longitude))
 		{
-			return;
+			continue;
 		}
+		if (latitude > MAX_MERCATOR_LATITUDE)
+			latitude = MAX_MERCATOR_LATITUDE;
+		else if (latitude < -MAX_MERCATOR_LATITUDE)
+			latitude = -MAX_MERCATOR_LATITUDE;
+
+		// Project once, at the most detailed zoom level. Every other zoom level is the same position shifted right.
+		double latRadians = latitude * M_PI / 180.0;
+		double x = (longitude + 180.0) / 360.0;
+		double y = (1.0 - log(tan(latRadians) + 1.0 / cos(latRadians)) / M_PI) / 2.0;
+		double cellX = floor(x * worldCells);
+		double cellY = floor(y * worldCells);
+		uint32_t worldX = (cellX < 0.0) ? 0 : (cellX > (double)maxCell) ? maxCell : (uint32_t)cellX;
+		uint32_t worldY = (cellY < 0.0) ? 0 : (cellY > (double)maxCell) ? maxCell : (uint32_t)cellY;
 
-		if ((fabs(oldCoordinate.latitude - newCoordinate.latitude) < 0.005) &&
-			(fabs(oldCoordinate.longitude - newCoordinate.longitude) < 0.005))
+		for (uint32_t zoom = HEAT_MAP_MAX_ZOOM; zoom >= HEAT_MAP_MIN_ZOOM; --zoom)
 		{
-			double distance = LibMath::Distance::haversineDistance(newCoordinate.latitude, newCoordinate.longitude, newCoordinate.altitude, oldCoordinate.latitude, oldCoordinate.longitude, oldCoordinate.altitude);
-			if (distance < 100)
+			uint32_t zoomX = worldX >> (HEAT_MAP_MAX_ZOOM - zoom);
+			uint32_t zoomY = worldY >> (HEAT_MAP_MAX_ZOOM - zoom);
+			uint64_t key = HEAT_MAP_CELL_KEY(zoom, zoomX >> HEAT_MAP_CELL_BITS, zoomY >> HEAT_MAP_CELL_BITS, zoomX & (HEAT_MAP_CELLS_PER_TILE - 1), zoomY & (HEAT_MAP_CELLS_PER_TILE - 1));
+
+			// Only count the track when it enters a cell. Each coarser cell contains the finer one, so once the
+			// track is still in the same cell at one zoom level it is still in the same cell at all of the coarser ones.
+			if (havePrev && prevKeys[zoom] == key)
 			{
-				(*iter).count++;
-				return;
+				break;
 			}
+			prevKeys[zoom] = key;
+			++counts[key];
 		}
+		havePrev = true;
+	}
+}
 
-		++iter;
+void HeatMapGenerator::CellCenter(uint64_t key, double& latitude, double& longitude)
+{
+	uint32_t zoom = HEAT_MAP_CELL_ZOOM(key);
+	double zoomCells = (double)((uint64_t)1 << (zoom + HEAT_MAP_CELL_BITS));
+	double x = ((double)((HEAT_MAP_CELL_TILE_X(key) << HEAT_MAP_CELL_BITS) + HEAT_MAP_CELL_X(key)) + 0.5) / zoomCells;
+	double y = ((double)((HEAT_MAP_CELL_TILE_Y(key) << HEAT_MAP_CELL_BITS) + HEAT_MAP_CELL_Y(key)) + 0.5) / zoomCells;
+
+	longitude = x * 360.0 - 180.0;
+	latitude = atan(sinh(M_PI * (1.0 - 2.0 * y))) * 180.0 / M_PI;
+}
+
+bool HeatMapGenerator::ReadTrack(Database& db, const std::string& activityId, Track& track)
+{
+	SensorCursor cursor;
+
+	track.clear();
+
+	if (!db.OpenSensorCursor(activityId, SENSOR_TYPE_LOCATION, cursor))
+	{
+		return false;
+	}
+	while (cursor.IsValid())
+	{
+		Coordinate coordinate;
+
+		coordinate.latitude = cursor.Value(0);
+		coordinate.longitude = cursor.Value(1);
+		coordinate.altitude = cursor.Value(2);
+		coordinate.horizontalAccuracy = (double)0.0;
+		coordinate.verticalAccuracy = (double)0.0;
+		coordinate.time = cursor.Time();
+		track.push_back(coordinate);
+		cursor.Next();
 	}
+	return !cursor.Failed();
 }
 
-bool HeatMapGenerator::CreateHeatMap(Database& db, HeatMap& heatMap)
+void HeatMapGenerator::CountTracks(HeatMapCellCounts* pCounts)
 {
-	return db.ProcessAllCoordinates(HeatMapDatabaseCallback, (void*)&heatMap);
+	std::unique_ptr<Track> track;
+
+	while (m_queue.Pop(track))
+	{
+		CountTrack(*track, *pCounts);
+	}
+}
+
+bool HeatMapGenerator::Update(Database& db)
+{
+	std::vector<std::string> activityIds;
+
+	if (!db.RetrieveActivityIdsNotInHeatMap(activityIds))
+	{
+		return false;
+	}
+	if (activityIds.empty())
+	{
+		return true;
+	}
+
+	// The database is only read from this thread. Each worker counts whole tracks into its own map, so the workers
+	// never contend for anything but the queue, and the maps are merged once everything has been counted.
+	size_t numWorkers = std::min(m_numWorkers, activityIds.size());
+	std::vector<HeatMapCellCounts> workerCounts(numWorkers);
+	WorkerPool workers;
+	bool result = true;
+
+	m_queue.Open(1);
+	workers.Start(numWorkers, [this, &workerCounts](size_t workerIndex) { CountTracks(&workerCounts[workerIndex]); });
+
+	for (auto iter = activityIds.begin(); result && iter != activityIds.end(); ++iter)
+	{
+		std::unique_ptr<Track> track(new Track());
+
+		result = ReadTrack(db, (*iter), *track);
+		if (result)
+		{
+			m_queue.Push(std::move(track));
+		}
+	}
+
+	m_queue.ProducerFinished();
+	workers.Join();
+
+	if (!result)
+	{
+		return false;
+	}
+
+	HeatMapCellCounts& counts = workerCounts[0];
+
+	for (size_t i = 1; i < numWorkers; ++i)
+	{
+		for (auto iter = workerCounts[i].begin(); iter != workerCounts[i].end(); ++iter)
+		{
+			counts[iter->first] += iter->second;
+		}
+		workerCounts[i].clear();
+	}
+
+	return db.AddHeatMapCounts(counts, activityIds);
+}
+
+bool HeatMapGenerator::AddActivity(Database& db, const std::string& activityId)
+{
+	// Building the heat map the first time reads the whole history, so that is left until it is asked for.
+	size_t numActivities = 0;
+
+	if (!db.RetrieveHeatMapActivityCount(numActivities))
+	{
+		return false;
+	}
+	if (numActivities == 0 || db.IsActivityInHeatMap(activityId))
+	{
+		return true;
+	}
+
+	Track track;
+	HeatMapCellCounts counts;
+
+	if (!ReadTrack(db, activityId, track))
+	{
+		return false;
+	}
+	CountTrack(track, counts);
+	return db.AddHeatMapCounts(counts, std::vector<std::string>(1, activityId));
+}
+
+bool HeatMapGenerator::RemoveActivity(Database& db, const std::string& activityId)
+{
+	if (!db.IsActivityInHeatMap(activityId))
+	{
+		return true;
+	}
+
+	Track track;
+	HeatMapCellCounts counts;
+
+	if (!ReadTrack(db, activityId, track))
+	{
+		return false;
+	}
+	CountTrack(track, counts);
+	return db.SubtractHeatMapCounts(counts, activityId);
+}
+
+typedef struct TileContext
+{
+	HeatMapTileCallback            callback;
+	void*                          context;
+	uint32_t                       zoom;
+	uint32_t                       tileX;
+	uint32_t                       tileY;
+	bool                           haveTile;
+	uint32_t                       counts[HEAT_MAP_CELLS_PER_TILE * HEAT_MAP_CELLS_PER_TILE];
+} TileContext;
+
+static void FlushTile(TileContext* pTile)
+{
+	if (pTile->haveTile)
+	{
+		pTile->callback(pTile->zoom, pTile->tileX, pTile->tileY, pTile->counts, pTile->context);
+		pTile->haveTile = false;
+	}
+}
+
+static void HeatMapCellCallback(uint64_t key, uint32_t count, void* context)
+{
+	TileContext* pTile = (TileContext*)context;
+	uint32_t tileX = HEAT_MAP_CELL_TILE_X(key);
+	uint32_t tileY = HEAT_MAP_CELL_TILE_Y(key);
+
+	// Cells arrive sorted by key, so all of a tile's cells arrive together and only one tile is needed at a time.
+	if (!pTile->haveTile || tileX != pTile->tileX || tileY != pTile->tileY)
+	{
+		FlushTile(pTile);
+		memset(pTile->counts, 0, sizeof(pTile->counts));
+		pTile->tileX = tileX;
+		pTile->tileY = tileY;
+		pTile->haveTile = true;
+	}
+	pTile->counts[HEAT_MAP_CELL_Y(key) * HEAT_MAP_CELLS_PER_TILE + HEAT_MAP_CELL_X(key)] = count;
+}
+
+bool HeatMapGenerator::CreateHeatMap(Database& db, uint32_t zoom, HeatMapTileCallback callback, void* context)
+{
+	if (zoom < HEAT_MAP_MIN_ZOOM || zoom > HEAT_MAP_MAX_ZOOM)
+	{
+		return false;
+	}
+	if (!Update(db))
+	{
+		return false;
+	}
+
+	std::unique_ptr<TileContext> tile(new TileContext());
+
+	tile->callback = callback;
+	tile->context = context;
+	tile->zoom = zoom;
+	tile->haveTile = false;
+
+	bool result = db.ProcessHeatMapCells(HEAT_MAP_CELL_KEY(zoom, 0, 0, 0, 0), HEAT_MAP_CELL_KEY(zoom + 1, 0, 0, 0, 0), HeatMapCellCallback, tile.get());
+	FlushTile(tile.get());
+	return result;
 }
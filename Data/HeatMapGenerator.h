@@ -9,24 +9,73 @@
 #define __HEATMAPGENERATOR__
 
 #include "Database.h"
+#include "WorkQueue.h"
 
-#include <list>
+#include <memory>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
 
-typedef struct HeatMapValue
-{
-	Coordinate coord;
-	uint32_t   count;
-} HeatMapValue;
+#define HEAT_MAP_MIN_ZOOM         2
+#define HEAT_MAP_MAX_ZOOM         16
+#define HEAT_MAP_CELL_BITS        6                         // Each 256 pixel map tile is divided into 64x64 cells
+#define HEAT_MAP_CELLS_PER_TILE   (1 << HEAT_MAP_CELL_BITS)
+#define HEAT_MAP_MAX_QUEUED_TRACKS 8                        // Tracks read from the database but not yet counted, bounds memory use
+
+// Cells are identified by zoom level, web mercator tile, and position within the tile, packed so that sorting the keys
+// groups each tile's cells together.
+#define HEAT_MAP_CELL_KEY(zoom, tileX, tileY, cellX, cellY) \
+	(((uint64_t)(zoom) << 56) | ((uint64_t)(tileX) << 36) | ((uint64_t)(tileY) << 16) | ((uint64_t)(cellY) << 8) | (uint64_t)(cellX))
+#define HEAT_MAP_CELL_ZOOM(key)   ((uint32_t)((key) >> 56))
+#define HEAT_MAP_CELL_TILE_X(key) ((uint32_t)(((key) >> 36) & 0xfffff))
+#define HEAT_MAP_CELL_TILE_Y(key) ((uint32_t)(((key) >> 16) & 0xfffff))
+#define HEAT_MAP_CELL_Y(key)      ((uint32_t)(((key) >> 8) & 0xff))
+#define HEAT_MAP_CELL_X(key)      ((uint32_t)((key) & 0xff))
 
-typedef std::list<HeatMapValue> HeatMap;
+typedef std::unordered_map<uint64_t, uint32_t> HeatMapCellCounts;
 
+/**
+* Counts how many times the recorded tracks pass through each cell of a web mercator tile grid, at every zoom level
+* from HEAT_MAP_MIN_ZOOM to HEAT_MAP_MAX_ZOOM.
+*
+* A track is counted once each time it enters a cell, rather than once per location, so that standing still doesn't
+* make a spot look popular. The counts are kept in the database along with the activities they include, so after
+* the first build only new activities have to be read.
+*/
 class HeatMapGenerator
 {
 public:
-	HeatMapGenerator() {};
-	virtual ~HeatMapGenerator() {};
-	
-	bool CreateHeatMap(Database& db, HeatMap& heatMap);
+	HeatMapGenerator();
+	virtual ~HeatMapGenerator();
+
+	/// @brief Adds every activity that isn't already in the heat map. Tracks are counted in parallel across activities.
+	bool Update(Database& db);
+
+	/// @brief Adds a newly saved activity. Does nothing until the heat map has been built by Update.
+	bool AddActivity(Database& db, const std::string& activityId);
+
+	/// @brief Takes an activity out of the heat map. Must be called before its locations are deleted.
+	bool RemoveActivity(Database& db, const std::string& activityId);
+
+	/// @brief Brings the heat map up to date, then calls the callback with each tile at the given zoom level that has
+	/// any counts. The tile's counts are HEAT_MAP_CELLS_PER_TILE rows of HEAT_MAP_CELLS_PER_TILE cells, starting from
+	/// the north west corner.
+	bool CreateHeatMap(Database& db, uint32_t zoom, HeatMapTileCallback callback, void* context);
+
+	/// @brief Counts the cells of a single track, at every zoom level.
+	static void CountTrack(const std::vector<Coordinate>& track, HeatMapCellCounts& counts);
+
+	/// @brief Converts a cell back to the latitude and longitude of its center.
+	static void CellCenter(uint64_t key, double& latitude, double& longitude);
+
+private:
+	typedef std::vector<Coordinate> Track;
+
+	WorkQueue<std::unique_ptr<Track>> m_queue;      // Tracks waiting to be counted
+	size_t                            m_numWorkers;
+
+	bool ReadTrack(Database& db, const std::string& activityId, Track& track);
+	void CountTracks(HeatMapCellCounts* pCounts);
 };
 
 #endif
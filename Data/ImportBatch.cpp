@@ -0,0 +1,146 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "ImportBatch.h"
+#include "ActivityAttribute.h"
+#include "AxisName.h"
+
+static bool FindValue(const SensorReading& reading, const char* const name, double& value)
+{
+	auto iter = reading.reading.find(name);
+
+	if (iter == reading.reading.end())
+	{
+		return false;
+	}
+	value = iter->second;
+	return true;
+}
+
+ImportBatch::ImportBatch()
+{
+	Clear();
+}
+
+ImportBatch::~ImportBatch()
+{
+}
+
+void ImportBatch::Clear(void)
+{
+	activityId.clear();
+	activityType.clear();
+	fileName.clear();
+	startTime = 0;
+	endTime = 0;
+	started = false;
+	hash.clear();
+
+	locationTimes.clear();
+	latitudes.clear();
+	longitudes.clear();
+	altitudes.clear();
+
+	accelerometerTimes.clear();
+	accelerometerX.clear();
+	accelerometerY.clear();
+	accelerometerZ.clear();
+
+	heartRateTimes.clear();
+	heartRates.clear();
+
+	cadenceTimes.clear();
+	cadences.clear();
+
+	powerTimes.clear();
+	powers.clear();
+
+	laps.clear();
+}
+
+bool ImportBatch::AddSensorReading(const SensorReading& reading)
+{
+	switch (reading.type)
+	{
+		case SENSOR_TYPE_LOCATION:
+			{
+				double lat, lon, alt;
+
+				if (FindValue(reading, ACTIVITY_ATTRIBUTE_LATITUDE, lat) &&
+					FindValue(reading, ACTIVITY_ATTRIBUTE_LONGITUDE, lon) &&
+					FindValue(reading, ACTIVITY_ATTRIBUTE_ALTITUDE, alt))
+				{
+					locationTimes.push_back(reading.time);
+					latitudes.push_back(lat);
+					longitudes.push_back(lon);
+					altitudes.push_back(alt);
+					return true;
+				}
+			}
+			break;
+		case SENSOR_TYPE_ACCELEROMETER:
+			{
+				double x, y, z;
+
+				if (FindValue(reading, AXIS_NAME_X, x) &&
+					FindValue(reading, AXIS_NAME_Y, y) &&
+					FindValue(reading, AXIS_NAME_Z, z))
+				{
+					accelerometerTimes.push_back(reading.time);
+					accelerometerX.push_back(x);
+					accelerometerY.push_back(y);
+					accelerometerZ.push_back(z);
+					return true;
+				}
+			}
+			break;
+		case SENSOR_TYPE_HEART_RATE:
+			{
+				double value;
+
+				if (FindValue(reading, ACTIVITY_ATTRIBUTE_HEART_RATE, value))
+				{
+					heartRateTimes.push_back(reading.time);
+					heartRates.push_back(value);
+					return true;
+				}
+			}
+			break;
+		case SENSOR_TYPE_CADENCE:
+			{
+				double value;
+
+				if (FindValue(reading, ACTIVITY_ATTRIBUTE_CADENCE, value))
+				{
+					cadenceTimes.push_back(reading.time);
+					cadences.push_back(value);
+					return true;
+				}
+			}
+			break;
+		case SENSOR_TYPE_POWER:
+			{
+				double value;
+
+				if (FindValue(reading, ACTIVITY_ATTRIBUTE_POWER, value))
+				{
+					powerTimes.push_back(reading.time);
+					powers.push_back(value);
+					return true;
+				}
+			}
+			break;
+		default:
+			break;
+	}
+	return false;
+}
+
+size_t ImportBatch::NumReadings(void) const
+{
+	return locationTimes.size() + accelerometerTimes.size() + heartRateTimes.size() + cadenceTimes.size() + powerTimes.size();
+}
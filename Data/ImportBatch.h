@@ -0,0 +1,71 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __IMPORTBATCH__
+#define __IMPORTBATCH__
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <time.h>
+#include <vector>
+
+#include "MovingActivity.h"
+#include "SensorReading.h"
+
+/**
+* Everything parsed from one activity file, held in memory until it can be written to the database.
+*
+* Readings are stored column by column (one vector per table column) rather than as a list of SensorReading
+* objects, which avoids a map allocation per sample and lets the database bind each row straight out of the arrays.
+*/
+class ImportBatch
+{
+public:
+	ImportBatch();
+	virtual ~ImportBatch();
+
+	void Clear(void);
+
+	/// @brief Appends the reading to the matching columns. Readings of types that aren't imported, or that
+	/// are missing a value, are dropped, just as the database would drop them.
+	bool AddSensorReading(const SensorReading& reading);
+
+	size_t NumReadings(void) const;
+
+	std::string           activityId;
+	std::string           activityType;
+	std::string           fileName;
+	time_t                startTime;
+	time_t                endTime;
+	bool                  started;
+	std::string           hash;      // See ActivityHasher, stored with the activity and used to spot duplicates
+
+	std::vector<uint64_t> locationTimes;
+	std::vector<double>   latitudes;
+	std::vector<double>   longitudes;
+	std::vector<double>   altitudes;
+
+	std::vector<uint64_t> accelerometerTimes;
+	std::vector<double>   accelerometerX;
+	std::vector<double>   accelerometerY;
+	std::vector<double>   accelerometerZ;
+
+	std::vector<uint64_t> heartRateTimes;
+	std::vector<double>   heartRates;
+
+	std::vector<uint64_t> cadenceTimes;
+	std::vector<double>   cadences;
+
+	std::vector<uint64_t> powerTimes;
+	std::vector<double>   powers;
+
+	LapSummaryList        laps;
+};
+
+#endif
@@ -0,0 +1,353 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "PersonalRecords.h"
+#include "Distance.h"
+#include "Measure.h"
+#include "SensorCursor.h"
+#include "UnitConversionFactors.h"
+
+#include <algorithm>
+#include <math.h>
+
+// The distances that the fastest segments of a moving activity are reported over (see MovingActivity).
+static const double g_defaultDistances[] = { 400.0, 1000.0, METERS_PER_MILE, 5000.0, 10000.0, METERS_PER_HALF_MARATHON, METERS_PER_MARATHON, 100000.0, METERS_PER_CENTURY };
+
+PersonalRecords::PersonalRecords() :
+	m_queue(PERSONAL_RECORD_MAX_QUEUED_TRACKS)
+{
+	m_numWorkers = WorkerPool::DefaultNumWorkers();
+}
+
+PersonalRecords::~PersonalRecords()
+{
+}
+
+void PersonalRecords::ComputeBestEfforts(const std::vector<Coordinate>& track, const std::vector<double>& distancesM, BestEffortList& efforts)
+{
+	std::vector<uint64_t> times;
+	std::vector<double> cumulative;
+	const Coordinate* pPrev = NULL;
+
+	// Cumulative distance at each location, the same way a moving activity measures it as it is recorded.
+	times.reserve(track.size());
+	cumulative.reserve(track.size());
+	for (auto iter = track.begin(); iter != track.end(); ++iter)
+	{
+		const Coordinate& coordinate = (*iter);
+
+		if (isnan(coordinate.latitude) || isnan(coordinate.longitude))
+		{
+			continue;
+		}
+
+		double distance = cumulative.empty() ? 0.0 : cumulative.back();
+
+		if (pPrev)
+		{
+			distance += LibMath::Distance::haversineDistance(pPrev->latitude, pPrev->longitude, pPrev->altitude, coordinate.latitude, coordinate.longitude, coordinate.altitude);
+		}
+		times.push_back(coordinate.time);
+		cumulative.push_back(distance);
+		pPrev = &coordinate;
+	}
+
+	size_t numPoints = cumulative.size();
+
+	if (numPoints < 2)
+	{
+		return;
+	}
+
+	for (auto distanceIter = distancesM.begin(); distanceIter != distancesM.end(); ++distanceIter)
+	{
+		double target = (*distanceIter);
+
+		if (target <= (double)0.0 || cumulative.back() < target)
+		{
+			continue;
+		}
+
+		// The window ends at each location in turn. Its start only ever moves forward, to the last location that
+		// still leaves at least the target distance between it and the end.
+		double bestElapsed = 0.0;
+		double bestStart = 0.0;
+		bool haveBest = false;
+		size_t start = 0;
+
+		for (size_t end = 1; end < numPoints; ++end)
+		{
+			if (cumulative[end] - cumulative[0] < target)
+			{
+				continue;
+			}
+			while (start + 1 < end && cumulative[end] - cumulative[start + 1] >= target)
+			{
+				++start;
+			}
+
+			// Move the start along the segment after it, assuming a steady speed, so the effort is exactly the target.
+			double segmentDistance = cumulative[start + 1] - cumulative[start];
+			double fraction = (segmentDistance > (double)0.0) ? ((cumulative[end] - cumulative[start] - target) / segmentDistance) : 0.0;
+			double startTime = (double)times[start] + fraction * ((double)times[start + 1] - (double)times[start]);
+			double elapsed = (double)times[end] - startTime;
+
+			if (!haveBest || elapsed < bestElapsed)
+			{
+				bestElapsed = elapsed;
+				bestStart = startTime;
+				haveBest = true;
+			}
+		}
+
+		if (haveBest && bestElapsed > (double)0.0)
+		{
+			BestEffort effort;
+
+			effort.distanceM = target;
+			effort.elapsedMs = (uint64_t)llround(bestElapsed);
+			effort.startTime = (uint64_t)llround(bestStart);
+			efforts.push_back(effort);
+		}
+	}
+}
+
+bool PersonalRecords::ReadTrack(Database& db, const std::string& activityId, std::vector<Coordinate>& coordinates)
+{
+	SensorCursor cursor;
+
+	coordinates.clear();
+
+	if (!db.OpenSensorCursor(activityId, SENSOR_TYPE_LOCATION, cursor))
+	{
+		return false;
+	}
+	while (cursor.IsValid())
+	{
+		Coordinate coordinate;
+
+		coordinate.latitude = cursor.Value(0);
+		coordinate.longitude = cursor.Value(1);
+		coordinate.altitude = cursor.Value(2);
+		coordinate.horizontalAccuracy = (double)0.0;
+		coordinate.verticalAccuracy = (double)0.0;
+		coordinate.time = cursor.Time();
+		coordinates.push_back(coordinate);
+		cursor.Next();
+	}
+	return !cursor.Failed();
+}
+
+bool PersonalRecords::AddActivity(Database& db, const std::string& activityId)
+{
+	ActivitySummary summary;
+	std::vector<Coordinate> coordinates;
+	std::vector<double> distances;
+	BestEffortList efforts;
+
+	if (!(db.RetrieveActivity(activityId, summary) && GetDistances(db, distances) && ReadTrack(db, activityId, coordinates)))
+	{
+		return false;
+	}
+
+	ComputeBestEfforts(coordinates, distances, efforts);
+	for (auto iter = efforts.begin(); iter != efforts.end(); ++iter)
+	{
+		(*iter).activityId = activityId;
+		(*iter).activityType = summary.type;
+	}
+
+	// Activities without any efforts are still recorded, so Update knows they're done.
+	return db.CreateBestEfforts(std::vector<std::string>(1, activityId), efforts, true);
+}
+
+bool PersonalRecords::RemoveActivity(Database& db, const std::string& activityId)
+{
+	return db.DeleteBestEfforts(activityId);
+}
+
+bool PersonalRecords::AddDistance(Database& db, double distanceM)
+{
+	if (isnan(distanceM) || distanceM <= (double)0.0)
+	{
+		return false;
+	}
+	return db.CreateBestEffortDistance(distanceM);
+}
+
+bool PersonalRecords::RemoveDistance(Database& db, double distanceM)
+{
+	return db.DeleteBestEffortDistance(distanceM);
+}
+
+bool PersonalRecords::GetDistances(Database& db, std::vector<double>& distancesM)
+{
+	distancesM.assign(g_defaultDistances, g_defaultDistances + sizeof(g_defaultDistances) / sizeof(g_defaultDistances[0]));
+	return db.RetrieveBestEffortDistances(distancesM);
+}
+
+bool PersonalRecords::GetRecord(Database& db, const std::string& activityType, double distanceM, BestEffort& record)
+{
+	return db.RetrievePersonalRecord(activityType, distanceM, record);
+}
+
+bool PersonalRecords::GetRecords(Database& db, const std::string& activityType, BestEffortList& records)
+{
+	return db.RetrievePersonalRecords(activityType, records);
+}
+
+bool PersonalRecords::GetActivityBestEfforts(Database& db, const std::string& activityId, BestEffortList& efforts)
+{
+	return db.RetrieveBestEfforts(activityId, efforts);
+}
+
+void PersonalRecords::SweepTracks(void)
+{
+	std::unique_ptr<Track> track;
+
+	while (m_queue.Pop(track))
+	{
+		BestEffortList efforts;
+
+		ComputeBestEfforts(track->coordinates, m_distances, efforts);
+		for (auto iter = efforts.begin(); iter != efforts.end(); ++iter)
+		{
+			(*iter).activityId = track->activityId;
+			(*iter).activityType = track->activityType;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sweptMutex);
+		m_sweptIds.push_back(track->activityId);
+		m_sweptEfforts.insert(m_sweptEfforts.end(), efforts.begin(), efforts.end());
+	}
+}
+
+bool PersonalRecords::Update(Database* pDb, std::mutex& dbLock, const std::atomic<bool>* pStop)
+{
+	ActivitySummaryList activities;
+	bool result;
+
+	dbLock.lock();
+	result = pDb->RetrieveActivitiesWithoutBestEfforts(activities) && GetDistances(*pDb, m_distances);
+	dbLock.unlock();
+
+	if (!result)
+	{
+		return false;
+	}
+	if (activities.empty())
+	{
+		return true;
+	}
+
+	// The database is only used from this thread, which reads each track, and every so often stores the efforts the
+	// workers have found so far. The lock is only held for one of those at a time.
+	size_t numWorkers = std::min(m_numWorkers, activities.size());
+	WorkerPool workers;
+	std::vector<std::string> storeIds;
+	BestEffortList storeEfforts;
+
+	m_sweptIds.clear();
+	m_sweptEfforts.clear();
+	m_queue.Open(1);
+	workers.Start(numWorkers, [this](size_t) { SweepTracks(); });
+
+	for (auto iter = activities.begin(); result && !(pStop && *pStop) && iter != activities.end(); ++iter)
+	{
+		std::unique_ptr<Track> track(new Track());
+
+		track->activityId = (*iter).activityId;
+		track->activityType = (*iter).type;
+
+		dbLock.lock();
+		result = ReadTrack(*pDb, track->activityId, track->coordinates);
+		dbLock.unlock();
+
+		if (result)
+		{
+			m_queue.Push(std::move(track));
+
+			std::unique_lock<std::mutex> lock(m_sweptMutex);
+			if (m_sweptIds.size() >= PERSONAL_RECORD_STORE_BATCH_SIZE)
+			{
+				storeIds.swap(m_sweptIds);
+				storeEfforts.swap(m_sweptEfforts);
+			}
+		}
+
+		if (!storeIds.empty())
+		{
+			dbLock.lock();
+			result = pDb->CreateBestEfforts(storeIds, storeEfforts, false);
+			dbLock.unlock();
+
+			storeIds.clear();
+			storeEfforts.clear();
+		}
+	}
+
+	m_queue.ProducerFinished();
+	workers.Join();
+
+	if (result && !m_sweptIds.empty())
+	{
+		dbLock.lock();
+		result = pDb->CreateBestEfforts(m_sweptIds, m_sweptEfforts, false);
+		dbLock.unlock();
+	}
+
+	m_sweptIds.clear();
+	m_sweptEfforts.clear();
+	return result;
+}
+
+bool PersonalRecords::Rebuild(Database* pDb, std::mutex& dbLock, const std::atomic<bool>* pStop)
+{
+	bool result;
+
+	dbLock.lock();
+	result = pDb->DeleteAllBestEfforts();
+	dbLock.unlock();
+
+	return result && Update(pDb, dbLock, pStop);
+}
+
+PersonalRecordsUpdater::PersonalRecordsUpdater(Database* pDb, std::mutex& dbLock) :
+	m_pDb(pDb),
+	m_dbLock(dbLock)
+{
+}
+
+PersonalRecordsUpdater::~PersonalRecordsUpdater()
+{
+	Stop();
+}
+
+bool PersonalRecordsUpdater::Start(bool rebuild)
+{
+	if (!m_pDb)
+	{
+		return false;
+	}
+
+	return m_job.Start([this, rebuild](const std::atomic<bool>& stop)
+	{
+		if (rebuild)
+		{
+			m_records.Rebuild(m_pDb, m_dbLock, &stop);
+		}
+		else
+		{
+			m_records.Update(m_pDb, m_dbLock, &stop);
+		}
+	});
+}
+
+void PersonalRecordsUpdater::Stop(void)
+{
+	m_job.Stop();
+}
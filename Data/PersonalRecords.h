@@ -0,0 +1,128 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __PERSONALRECORDS__
+#define __PERSONALRECORDS__
+
+#pragma once
+
+#include "BackgroundJob.h"
+#include "BestEffort.h"
+#include "Coordinate.h"
+#include "Database.h"
+#include "WorkQueue.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define PERSONAL_RECORD_MAX_QUEUED_TRACKS 8  // Tracks read from the database but not yet swept, bounds memory use
+#define PERSONAL_RECORD_STORE_BATCH_SIZE  32 // Activities whose best efforts are written in each transaction by Update
+
+/**
+* Keeps each activity's best effort over a set of distances, and the personal record (the fastest of those efforts)
+* for each activity type and distance.
+*
+* The distances are the usual race distances plus any that the user adds. An activity's best efforts are found with
+* a single sweep over its cumulative distance per distance, with a pair of pointers marking the start and end of the
+* window, and the start of the window interpolated so that each effort covers exactly the distance. The personal
+* records are kept in their own table, refreshed for just the affected activity type and distances whenever an
+* activity's efforts change, so looking one up is a single row.
+*
+* All methods expect the caller to hold the database lock, except for Update and Rebuild.
+*/
+class PersonalRecords
+{
+public:
+	PersonalRecords();
+	virtual ~PersonalRecords();
+
+	/// @brief Finds the activity's best efforts, replacing any that were found before, e.g. when the activity is trimmed.
+	bool AddActivity(Database& db, const std::string& activityId);
+
+	/// @brief Forgets the activity's best efforts. Database::DeleteActivity already does this.
+	bool RemoveActivity(Database& db, const std::string& activityId);
+
+	/// @brief Adds a distance to track, in addition to the defaults. Efforts over the new distance are not found until
+	/// the next Rebuild.
+	bool AddDistance(Database& db, double distanceM);
+	bool RemoveDistance(Database& db, double distanceM);
+
+	/// @brief The default distances followed by any the user has added.
+	bool GetDistances(Database& db, std::vector<double>& distancesM);
+
+	/// @brief Looks up the fastest effort over the distance for the activity type.
+	bool GetRecord(Database& db, const std::string& activityType, double distanceM, BestEffort& record);
+
+	/// @brief Looks up the fastest effort over each distance for the activity type, i.e. the best effort curve,
+	/// sorted by distance.
+	bool GetRecords(Database& db, const std::string& activityType, BestEffortList& records);
+
+	/// @brief Looks up the activity's best effort over each distance, sorted by distance.
+	bool GetActivityBestEfforts(Database& db, const std::string& activityId, BestEffortList& efforts);
+
+	/// @brief Finds the best efforts of every activity that doesn't have them yet, e.g. activities recorded before
+	/// personal records were kept. Tracks are swept in parallel across activities. Takes the database lock itself, and
+	/// releases it between activities. Efforts are stored as they are found, so if pStop is set part way through, the
+	/// next Update carries on from there.
+	bool Update(Database* pDb, std::mutex& dbLock, const std::atomic<bool>* pStop = NULL);
+
+	/// @brief Throws away every best effort and finds them all again, e.g. after adding a distance.
+	bool Rebuild(Database* pDb, std::mutex& dbLock, const std::atomic<bool>* pStop = NULL);
+
+	/// @brief Finds the quickest time over each of the distances. Times are in milliseconds. Efforts that the track is
+	/// too short for are left out.
+	static void ComputeBestEfforts(const std::vector<Coordinate>& track, const std::vector<double>& distancesM, BestEffortList& efforts);
+
+private:
+	typedef struct Track
+	{
+		std::string             activityId;
+		std::string             activityType;
+		std::vector<Coordinate> coordinates;
+	} Track;
+
+	WorkQueue<std::unique_ptr<Track>> m_queue;        // Tracks waiting to be swept
+	size_t                            m_numWorkers;
+	std::vector<double>               m_distances;    // Distances swept by the workers
+	std::mutex                        m_sweptMutex;
+	std::vector<std::string>          m_sweptIds;     // Activities swept by the workers, but not yet stored
+	BestEffortList                    m_sweptEfforts; // Their efforts
+
+	bool ReadTrack(Database& db, const std::string& activityId, std::vector<Coordinate>& coordinates);
+	void SweepTracks(void);
+};
+
+/**
+* Runs PersonalRecords::Update, or Rebuild, on a background thread, so that it can be stopped before the database is
+* closed.
+*/
+class PersonalRecordsUpdater
+{
+public:
+	PersonalRecordsUpdater(Database* pDb, std::mutex& dbLock);
+	virtual ~PersonalRecordsUpdater();
+
+	/// @brief Starts the background thread, does nothing if it is already running.
+	bool Start(bool rebuild);
+
+	/// @brief Asks the background thread to stop and waits for it to store what it has found so far.
+	void Stop(void);
+
+	bool IsRunning(void) const { return m_job.IsRunning(); };
+
+private:
+	Database*       m_pDb;
+	std::mutex&     m_dbLock;
+	PersonalRecords m_records;
+	BackgroundJob   m_job;
+};
+
+#endif
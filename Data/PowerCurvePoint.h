@@ -0,0 +1,24 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __POWERCURVEPOINT__
+#define __POWERCURVEPOINT__
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+typedef struct PowerCurvePoint
+{
+	uint32_t durationSecs;
+	double   watts;        // best average power over the duration
+} PowerCurvePoint;
+
+typedef std::vector<PowerCurvePoint> PowerCurvePointList;
+
+#endif
@@ -0,0 +1,507 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "RouteMatcher.h"
+#include "RoutePolyline.h"
+#include "SensorCursor.h"
+
+#include <algorithm>
+#include <limits>
+#include <math.h>
+#include <unordered_map>
+
+#define METERS_PER_DEGREE 111319.49 // At the equator
+
+// A point projected onto a flat plane around the track, in meters.
+typedef struct MatchPoint
+{
+	double   x;
+	double   y;
+	uint64_t time;  // time in milliseconds
+	size_t   index; // index of the nearest location in the original track
+} MatchPoint;
+
+typedef std::vector<MatchPoint> MatchPointList;
+
+// The track, resampled, with a grid of its points for finding the ones near a route's start and end.
+typedef struct TrackSamples
+{
+	double                                            originLatitude;
+	double                                            originLongitude;
+	double                                            metersPerDegreeLongitude;
+	MatchPointList                                    points;
+	std::unordered_map<uint64_t, std::vector<size_t>> grid; // cell -> indexes of the points in it
+} TrackSamples;
+
+#define GRID_KEY(cellX, cellY) (((uint64_t)(uint32_t)(cellX) << 32) | (uint64_t)(uint32_t)(cellY))
+
+static void Project(const TrackSamples& track, const Coordinate& coordinate, MatchPoint& point)
+{
+	// Equirectangular around the middle of the track. Tracks span a few tens of kilometers at most, over which the
+	// distortion is far less than the distances being compared.
+	point.x = (coordinate.longitude - track.originLongitude) * track.metersPerDegreeLongitude;
+	point.y = (coordinate.latitude - track.originLatitude) * METERS_PER_DEGREE;
+	point.time = coordinate.time;
+	point.index = 0;
+}
+
+static double DistanceSquared(const MatchPoint& a, const MatchPoint& b)
+{
+	double dx = a.x - b.x;
+	double dy = a.y - b.y;
+	return dx * dx + dy * dy;
+}
+
+static void Resample(const MatchPointList& points, double spacingM, MatchPointList& samples)
+{
+	samples.clear();
+
+	if (points.empty())
+	{
+		return;
+	}
+
+	double carried = (double)0.0; // distance travelled since the last sample
+
+	samples.push_back(points.front());
+
+	for (size_t i = 1; i < points.size(); ++i)
+	{
+		const MatchPoint& a = points[i - 1];
+		const MatchPoint& b = points[i];
+		double segmentLen = sqrt(DistanceSquared(a, b));
+		double pos = spacingM - carried;
+
+		for (; pos <= segmentLen; pos += spacingM)
+		{
+			double fraction = pos / segmentLen;
+			MatchPoint sample;
+
+			sample.x = a.x + (b.x - a.x) * fraction;
+			sample.y = a.y + (b.y - a.y) * fraction;
+			sample.time = a.time + (int64_t)((double)(int64_t)(b.time - a.time) * fraction);
+			sample.index = (fraction < 0.5) ? a.index : b.index;
+			samples.push_back(sample);
+		}
+		carried = segmentLen - (pos - spacingM);
+	}
+
+	if (carried > (double)0.0)
+	{
+		samples.push_back(points.back());
+	}
+}
+
+static int64_t GridCell(double meters)
+{
+	return (int64_t)floor(meters / ROUTE_MATCH_MAX_DISTANCE_M);
+}
+
+static void BuildTrackSamples(const std::vector<Coordinate>& track, TrackSamples& samples)
+{
+	double minLatitude = track.front().latitude;
+	double maxLatitude = minLatitude;
+	double minLongitude = track.front().longitude;
+	double maxLongitude = minLongitude;
+
+	for (auto iter = track.begin(); iter != track.end(); ++iter)
+	{
+		minLatitude = std::min(minLatitude, (*iter).latitude);
+		maxLatitude = std::max(maxLatitude, (*iter).latitude);
+		minLongitude = std::min(minLongitude, (*iter).longitude);
+		maxLongitude = std::max(maxLongitude, (*iter).longitude);
+	}
+
+	samples.originLatitude = (minLatitude + maxLatitude) / 2.0;
+	samples.originLongitude = (minLongitude + maxLongitude) / 2.0;
+	samples.metersPerDegreeLongitude = METERS_PER_DEGREE * cos(samples.originLatitude * M_PI / 180.0);
+
+	// Simplifying first gets rid of the zig-zags GPS noise makes while standing still, which would otherwise make the
+	// track look longer than the route and push it out of the band.
+	std::vector<Coordinate> simplified;
+	MatchPointList projected;
+
+	RoutePolyline::Simplify(track, ROUTE_MATCH_TOLERANCE_M, simplified);
+
+	size_t trackIndex = 0;
+
+	for (auto iter = simplified.begin(); iter != simplified.end(); ++iter)
+	{
+		MatchPoint point;
+
+		// Simplification keeps a subset of the points, in order, so the original index is found by walking forward.
+		while (trackIndex < track.size() && track[trackIndex].time != (*iter).time)
+		{
+			++trackIndex;
+		}
+
+		Project(samples, (*iter), point);
+		point.index = (trackIndex < track.size()) ? trackIndex : track.size() - 1;
+		projected.push_back(point);
+	}
+
+	Resample(projected, ROUTE_MATCH_SAMPLE_SPACING_M, samples.points);
+
+	for (size_t i = 0; i < samples.points.size(); ++i)
+	{
+		const MatchPoint& point = samples.points[i];
+		samples.grid[GRID_KEY(GridCell(point.x), GridCell(point.y))].push_back(i);
+	}
+}
+
+// Returns the indexes, in order, of the track samples within ROUTE_MATCH_MAX_DISTANCE_M of the point.
+static void NearbySamples(const TrackSamples& track, const MatchPoint& point, std::vector<size_t>& indexes)
+{
+	const double maxDistanceSquared = ROUTE_MATCH_MAX_DISTANCE_M * ROUTE_MATCH_MAX_DISTANCE_M;
+	int64_t cellX = GridCell(point.x);
+	int64_t cellY = GridCell(point.y);
+
+	indexes.clear();
+
+	for (int64_t x = cellX - 1; x <= cellX + 1; ++x)
+	{
+		for (int64_t y = cellY - 1; y <= cellY + 1; ++y)
+		{
+			auto cellIter = track.grid.find(GRID_KEY(x, y));
+
+			if (cellIter != track.grid.end())
+			{
+				for (auto iter = cellIter->second.begin(); iter != cellIter->second.end(); ++iter)
+				{
+					if (DistanceSquared(track.points[(*iter)], point) <= maxDistanceSquared)
+					{
+						indexes.push_back((*iter));
+					}
+				}
+			}
+		}
+	}
+	std::sort(indexes.begin(), indexes.end());
+}
+
+// Discrete Frechet distance between the route and the track starting at the entry sample, with the track free to
+// finish anywhere. Cells further than ROUTE_MATCH_MAX_DISTANCE_M are dropped, so each row only covers the stretch of
+// track still within reach of the route, at most maxWidth samples. GPS noise can make the track noticeably longer
+// than the route, so the band follows the reachable cells rather than a fixed diagonal. Returns FALSE if the track
+// strays too far, otherwise sets the exit sample and the (squared) distance.
+static bool BandedFrechet(const MatchPointList& route, const MatchPointList& track, size_t entry, size_t maxWidth, size_t& exit, double& distanceSquared)
+{
+	const double maxDistanceSquared = ROUTE_MATCH_MAX_DISTANCE_M * ROUTE_MATCH_MAX_DISTANCE_M;
+	const double infinity = std::numeric_limits<double>::infinity();
+
+	std::vector<double> prevRow; // values for the track samples from prevFirst
+	std::vector<double> row;
+	size_t prevFirst = entry;
+
+	for (size_t i = 0; i < route.size(); ++i)
+	{
+		row.clear();
+
+		for (size_t j = prevFirst; j < track.size() && row.size() < maxWidth; ++j)
+		{
+			size_t k = j - prevFirst;
+			double best = infinity;
+
+			if (i == 0)
+			{
+				best = (k == 0) ? (double)0.0 : row[k - 1];
+			}
+			else
+			{
+				if (k < prevRow.size())
+					best = std::min(best, prevRow[k]);     // route advanced, track stayed
+				if (k > 0 && k - 1 < prevRow.size())
+					best = std::min(best, prevRow[k - 1]); // both advanced
+				if (k > 0)
+					best = std::min(best, row[k - 1]);     // track advanced, route stayed
+			}
+
+			double value = std::max(best, DistanceSquared(route[i], track[j]));
+
+			if (value > maxDistanceSquared)
+			{
+				value = infinity;
+			}
+			row.push_back(value);
+
+			// Past the end of the previous row, the only way in is from the left.
+			if (value == infinity && k + 1 >= prevRow.size())
+			{
+				break;
+			}
+		}
+
+		// Drop the unreachable cells from both ends, so the next row starts at the first reachable one.
+		size_t first = 0;
+		while (first < row.size() && row[first] == infinity)
+		{
+			++first;
+		}
+		if (first == row.size())
+		{
+			return false; // every way of getting this far has strayed too far from the route
+		}
+		while (row.back() == infinity)
+		{
+			row.pop_back();
+		}
+
+		prevFirst += first;
+		prevRow.assign(row.begin() + first, row.end());
+	}
+
+	// Leave the route where the track comes closest to its end, among the exits with the smallest distance.
+	double bestEndDistance = infinity;
+	bool found = false;
+
+	for (size_t k = 0; k < prevRow.size(); ++k)
+	{
+		if (prevRow[k] == infinity)
+		{
+			continue;
+		}
+
+		size_t j = prevFirst + k;
+		double endDistance = DistanceSquared(route.back(), track[j]);
+
+		if (!found || prevRow[k] < distanceSquared || (prevRow[k] == distanceSquared && endDistance < bestEndDistance))
+		{
+			distanceSquared = prevRow[k];
+			bestEndDistance = endDistance;
+			exit = j;
+			found = true;
+		}
+	}
+	return found;
+}
+
+static void MatchSamples(const std::string& routeId, const std::vector<Coordinate>& routeCoordinates, const TrackSamples& track, RouteMatchList& matches)
+{
+	if (routeCoordinates.size() < 2 || track.points.empty())
+	{
+		return;
+	}
+
+	MatchPointList projected;
+	MatchPointList route;
+	MatchPoint start;
+	MatchPoint end;
+	std::vector<size_t> nearEnd;
+	std::vector<size_t> nearStart;
+
+	// Check the ends first, it's cheap and rules out most routes.
+	Project(track, routeCoordinates.back(), end);
+	NearbySamples(track, end, nearEnd);
+	if (nearEnd.empty())
+	{
+		return;
+	}
+	Project(track, routeCoordinates.front(), start);
+	NearbySamples(track, start, nearStart);
+	if (nearStart.empty())
+	{
+		return;
+	}
+
+	for (auto iter = routeCoordinates.begin(); iter != routeCoordinates.end(); ++iter)
+	{
+		MatchPoint point;
+
+		Project(track, (*iter), point);
+		projected.push_back(point);
+	}
+	Resample(projected, ROUTE_MATCH_SAMPLE_SPACING_M, route);
+
+	double routeLengthM = (double)(route.size() - 1) * ROUTE_MATCH_SAMPLE_SPACING_M;
+	size_t bandWidth = (size_t)ceil(std::max(ROUTE_MATCH_MIN_BAND_M, routeLengthM * ROUTE_MATCH_BAND_FRACTION) / ROUTE_MATCH_SAMPLE_SPACING_M);
+	size_t maxWidth = 2 * bandWidth + 1;
+	size_t nextEntry = 0;
+	size_t i = 0;
+
+	// Each pass by the start is a possible entry. Try the closest sample of each pass.
+	while (i < nearStart.size())
+	{
+		size_t entry = nearStart[i];
+		double entryDistance = DistanceSquared(track.points[entry], start);
+		size_t j = i + 1;
+
+		for (; j < nearStart.size() && nearStart[j] == nearStart[j - 1] + 1; ++j)
+		{
+			double distance = DistanceSquared(track.points[nearStart[j]], start);
+
+			if (distance < entryDistance)
+			{
+				entry = nearStart[j];
+				entryDistance = distance;
+			}
+		}
+		i = j;
+
+		// Don't match the same stretch of track twice, though the next lap of a loop may start where this one ended.
+		if (entry < nextEntry)
+		{
+			continue;
+		}
+
+		size_t exit = 0;
+		double distanceSquared = (double)0.0;
+
+		if (BandedFrechet(route, track.points, entry, maxWidth, exit, distanceSquared))
+		{
+			RouteMatch match;
+
+			match.routeId = routeId;
+			match.entryIndex = track.points[entry].index;
+			match.exitIndex = track.points[exit].index;
+			match.entryTime = track.points[entry].time;
+			match.exitTime = track.points[exit].time;
+			match.distanceM = sqrt(distanceSquared);
+			matches.push_back(match);
+
+			nextEntry = exit;
+		}
+	}
+}
+
+static bool CompareMatches(const RouteMatch& a, const RouteMatch& b)
+{
+	return a.entryTime < b.entryTime;
+}
+
+RouteMatcher::RouteMatcher()
+{
+}
+
+RouteMatcher::~RouteMatcher()
+{
+}
+
+bool RouteMatcher::Update(Database& db)
+{
+	std::vector<std::string> routeIds;
+
+	if (!db.RetrieveRouteIdsNotInRouteIndex(routeIds))
+	{
+		return false;
+	}
+
+	bool result = true;
+
+	for (auto iter = routeIds.begin(); result && iter != routeIds.end(); ++iter)
+	{
+		CoordinateList coordinates;
+		double toleranceM = (double)0.0;
+
+		// Routes imported before polylines were added only have a row per point.
+		if (!db.RetrieveRoutePolyline((*iter), (double)0.0, coordinates, toleranceM))
+		{
+			db.RetrieveRouteCoordinates((*iter), coordinates);
+		}
+		if (!coordinates.empty())
+		{
+			result = db.DeleteRoutePolylines((*iter)) && db.CreateRoutePolylines((*iter), coordinates);
+		}
+	}
+	return result;
+}
+
+bool RouteMatcher::MatchActivity(Database& db, const std::string& activityId, RouteMatchList& matches)
+{
+	std::vector<Coordinate> track;
+	SensorCursor cursor;
+
+	if (!db.OpenSensorCursor(activityId, SENSOR_TYPE_LOCATION, cursor))
+	{
+		return false;
+	}
+	while (cursor.IsValid())
+	{
+		Coordinate coordinate;
+
+		coordinate.latitude = cursor.Value(0);
+		coordinate.longitude = cursor.Value(1);
+		coordinate.altitude = cursor.Value(2);
+		coordinate.horizontalAccuracy = (double)0.0;
+		coordinate.verticalAccuracy = (double)0.0;
+		coordinate.time = cursor.Time();
+		track.push_back(coordinate);
+		cursor.Next();
+	}
+	if (cursor.Failed())
+	{
+		return false;
+	}
+
+	return Update(db) && MatchTrack(db, track, matches);
+}
+
+bool RouteMatcher::MatchTrack(Database& db, const std::vector<Coordinate>& track, RouteMatchList& matches)
+{
+	if (track.size() < 2)
+	{
+		return true;
+	}
+
+	TrackSamples samples;
+	BuildTrackSamples(track, samples);
+
+	// A route the track followed from end to end can't stick out of the track's bounding box by more than the
+	// distance the track is allowed to stray.
+	GeoBoundingBox box;
+	double latitudeMargin = ROUTE_MATCH_MAX_DISTANCE_M / METERS_PER_DEGREE;
+	double longitudeMargin = ROUTE_MATCH_MAX_DISTANCE_M / std::max(samples.metersPerDegreeLongitude, (double)1.0);
+
+	box.minLatitude = box.maxLatitude = track.front().latitude;
+	box.minLongitude = box.maxLongitude = track.front().longitude;
+	for (auto iter = track.begin(); iter != track.end(); ++iter)
+	{
+		box.minLatitude = std::min(box.minLatitude, (*iter).latitude);
+		box.maxLatitude = std::max(box.maxLatitude, (*iter).latitude);
+		box.minLongitude = std::min(box.minLongitude, (*iter).longitude);
+		box.maxLongitude = std::max(box.maxLongitude, (*iter).longitude);
+	}
+	box.minLatitude -= latitudeMargin;
+	box.maxLatitude += latitudeMargin;
+	box.minLongitude -= longitudeMargin;
+	box.maxLongitude += longitudeMargin;
+
+	std::vector<std::string> routeIds;
+
+	if (!db.RetrieveRouteIdsWithinBox(box, routeIds))
+	{
+		return false;
+	}
+
+	for (auto iter = routeIds.begin(); iter != routeIds.end(); ++iter)
+	{
+		CoordinateList coordinates;
+		double toleranceM = (double)0.0;
+
+		if (db.RetrieveRoutePolyline((*iter), ROUTE_MATCH_TOLERANCE_M, coordinates, toleranceM))
+		{
+			MatchSamples((*iter), coordinates, samples, matches);
+		}
+	}
+
+	std::stable_sort(matches.begin(), matches.end(), CompareMatches);
+	return true;
+}
+
+void RouteMatcher::MatchTrackToRoute(const std::vector<Coordinate>& route, const std::vector<Coordinate>& track, RouteMatchList& matches)
+{
+	if (track.size() < 2)
+	{
+		return;
+	}
+
+	TrackSamples samples;
+	std::vector<Coordinate> simplified;
+
+	BuildTrackSamples(track, samples);
+	RoutePolyline::Simplify(route, ROUTE_MATCH_TOLERANCE_M, simplified);
+	MatchSamples("", simplified, samples, matches);
+}
@@ -0,0 +1,69 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __ROUTEMATCHER__
+#define __ROUTEMATCHER__
+
+#pragma once
+
+#include "Coordinate.h"
+#include "Database.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define ROUTE_MATCH_MAX_DISTANCE_M   40.0  // The furthest the track may stray from the route and still be following it
+#define ROUTE_MATCH_SAMPLE_SPACING_M 10.0  // Both lines are resampled to points this far apart before they are compared
+#define ROUTE_MATCH_TOLERANCE_M      10.0  // Simplification applied to the track, and the stored copy of the route that is used
+#define ROUTE_MATCH_MIN_BAND_M       200.0 // Length of track compared against each route point is at most twice this...
+#define ROUTE_MATCH_BAND_FRACTION    0.2   // ...or twice this fraction of the route's length, if that is more
+
+typedef struct RouteMatch
+{
+	std::string routeId;
+	size_t      entryIndex; // index, into the track's locations, of where the track joined the route
+	size_t      exitIndex;  // index, into the track's locations, of where the track left the route
+	uint64_t    entryTime;  // time in milliseconds
+	uint64_t    exitTime;   // time in milliseconds
+	double      distanceM;  // the furthest the track strayed from the route
+} RouteMatch;
+
+typedef std::vector<RouteMatch> RouteMatchList;
+
+/**
+* Recognizes the saved routes that an activity followed.
+*
+* Candidates are the routes whose bounding box (see Database::CreateRoutePolylines) fits inside the track's, and whose
+* start and end the track passed near. Each candidate is confirmed with the discrete Frechet distance between the route
+* and the track, both resampled to evenly spaced points. Each route point is only compared against the stretch of track
+* that can still reach it without straying too far (a band that follows the route), which keeps the work proportional
+* to the length of the route rather than to the length of the route times the length of the track.
+*
+* A route is matched each time the track follows it from start to finish, so laps of a loop are matched separately.
+*/
+class RouteMatcher
+{
+public:
+	RouteMatcher();
+	virtual ~RouteMatcher();
+
+	/// @brief Adds routes that were stored before routes had bounding boxes to the spatial index.
+	bool Update(Database& db);
+
+	/// @brief Finds the routes that the activity followed, sorted by the time at which they were joined.
+	bool MatchActivity(Database& db, const std::string& activityId, RouteMatchList& matches);
+
+	/// @brief Finds the stored routes that the track followed. Track locations must be in time order.
+	bool MatchTrack(Database& db, const std::vector<Coordinate>& track, RouteMatchList& matches);
+
+	/// @brief Finds each time the track followed the given route, e.g. the track of a previous activity. Doesn't need
+	/// the database. The route ID of the matches is left empty.
+	static void MatchTrackToRoute(const std::vector<Coordinate>& route, const std::vector<Coordinate>& track, RouteMatchList& matches);
+};
+
+#endif
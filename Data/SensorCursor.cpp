@@ -0,0 +1,131 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "SensorCursor.h"
+
+SensorCursor::SensorCursor()
+{
+	m_statement = NULL;
+	m_numValues = 0;
+	m_failed = false;
+	m_prev.valid = false;
+	m_cur.valid = false;
+	m_curIndex = 0;
+	m_atPrev = false;
+}
+
+SensorCursor::~SensorCursor()
+{
+	Close();
+}
+
+void SensorCursor::Attach(sqlite3_stmt* statement, size_t numValues)
+{
+	Close();
+
+	m_statement = statement;
+	m_numValues = (numValues < SENSOR_CURSOR_MAX_VALUES) ? numValues : SENSOR_CURSOR_MAX_VALUES;
+	m_failed = (statement == NULL);
+	m_prev.valid = false;
+	m_cur.valid = false;
+	m_curIndex = 0;
+	m_atPrev = false;
+
+	Step();
+}
+
+void SensorCursor::Close(void)
+{
+	if (m_statement)
+	{
+		sqlite3_finalize(m_statement);
+		m_statement = NULL;
+	}
+	m_cur.valid = false;
+}
+
+bool SensorCursor::Step(void)
+{
+	m_cur.valid = false;
+
+	if (m_statement)
+	{
+		int rc = sqlite3_step(m_statement);
+
+		if (rc == SQLITE_ROW)
+		{
+			m_cur.valid = true;
+			m_cur.time = sqlite3_column_int64(m_statement, 0);
+			for (size_t i = 0; i < m_numValues; ++i)
+				m_cur.values[i] = sqlite3_column_double(m_statement, (int)i + 1);
+		}
+		else
+		{
+			m_failed = (rc != SQLITE_DONE);
+
+			// Nothing more to read, so let go of the statement now rather than when the cursor is destroyed.
+			sqlite3_finalize(m_statement);
+			m_statement = NULL;
+		}
+	}
+	return m_cur.valid;
+}
+
+bool SensorCursor::Next(void)
+{
+	if (!m_cur.valid)
+	{
+		return false;
+	}
+
+	m_prev = m_cur;
+	++m_curIndex;
+	m_atPrev = false;
+	return Step();
+}
+
+bool SensorCursor::SeekNearest(uint64_t timeMs, double& value)
+{
+	// Move forward past everything before the requested time.
+	if (m_atPrev && m_prev.time < timeMs)
+	{
+		m_atPrev = false;
+	}
+	if (!m_atPrev)
+	{
+		while (m_cur.valid && m_cur.time < timeMs)
+		{
+			Next();
+		}
+
+		// Back up to the last reading before the requested time. Everything skipped above was before
+		// the requested time, so this never needs to go back more than one row. Once the readings have
+		// run out nothing else is matched.
+		if (m_curIndex > 0 && m_cur.valid && m_cur.time > timeMs)
+		{
+			m_atPrev = true;
+		}
+	}
+
+	// The first reading is never used.
+	size_t index = m_atPrev ? (m_curIndex - 1) : m_curIndex;
+	const Row& row = m_atPrev ? m_prev : m_cur;
+
+	if (index == 0 || !row.valid)
+	{
+		return false;
+	}
+
+	uint64_t timeDiff = (row.time > timeMs) ? (row.time - timeMs) : (timeMs - row.time);
+	if (timeDiff >= SENSOR_CURSOR_MATCH_WINDOW_MS)
+	{
+		return false;
+	}
+
+	value = row.values[0];
+	return true;
+}
@@ -0,0 +1,74 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __SENSORCURSOR__
+#define __SENSORCURSOR__
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sqlite3.h>
+
+#define SENSOR_CURSOR_MAX_VALUES 3        // Location and accelerometer rows have three values, everything else has one
+#define SENSOR_CURSOR_MATCH_WINDOW_MS 3000 // How close a reading has to be to be matched with a point in time
+
+/**
+* Steps through the readings for one sensor, one row at a time, straight out of a prepared statement.
+*
+* Exporters use one cursor per sensor table and merge them by time, so that memory use stays the same
+* no matter how long the activity is. The cursor is created by Database::OpenSensorCursor.
+*/
+class SensorCursor
+{
+public:
+	SensorCursor();
+	virtual ~SensorCursor();
+
+	/// @brief Takes ownership of a statement whose first column is the time, followed by up to SENSOR_CURSOR_MAX_VALUES values.
+	/// Rows must come back in time order. The first row is read immediately.
+	void Attach(sqlite3_stmt* statement, size_t numValues);
+	void Close(void);
+
+	/// @brief TRUE if the cursor is positioned on a row. FALSE once every row has been read, or if the query failed.
+	bool IsValid(void) const { return m_cur.valid; };
+	bool Failed(void) const { return m_failed; };
+
+	uint64_t Time(void) const { return m_cur.time; };
+	double Value(size_t index) const { return m_cur.values[index]; };
+
+	/// @brief Moves to the next row.
+	bool Next(void);
+
+	/// @brief Finds the reading to use for a point at the given time. Calls must be in time order.
+	///
+	/// This matches the list based search the exporters have always used: the reading is the first one at the
+	/// given time, or the last one before it, and must be within SENSOR_CURSOR_MATCH_WINDOW_MS. The very first
+	/// reading is never matched, and nothing is matched after the last reading. Only the current row and the
+	/// row before it are ever needed.
+	bool SeekNearest(uint64_t timeMs, double& value);
+
+private:
+	typedef struct Row
+	{
+		bool     valid;
+		uint64_t time;
+		double   values[SENSOR_CURSOR_MAX_VALUES];
+	} Row;
+
+	sqlite3_stmt* m_statement;
+	size_t        m_numValues;
+	bool          m_failed;
+	Row           m_prev;      // Row before the current one
+	Row           m_cur;       // Most recently read row, invalid at the end
+	size_t        m_curIndex;  // Index of the current row
+	bool          m_atPrev;    // Search position is on the previous row rather than the current row
+
+	bool Step(void);
+};
+
+#endif
@@ -0,0 +1,350 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "SummaryRecomputer.h"
+#include "ActivityFactory.h"
+#include "ActivitySnapshot.h"
+#include "CriticalPower.h"
+#include "MovingActivity.h"
+#include "ZoneTimeRollup.h"
+
+#include <algorithm>
+
+SummaryRecomputer::SummaryRecomputer(Database* pDb, std::mutex& dbLock) :
+	m_pDb(pDb),
+	m_dbLock(dbLock),
+	m_nextActivity(0),
+	m_queue(SUMMARY_RECOMPUTE_MAX_QUEUED_RESULTS)
+{
+	m_numWorkers = WorkerPool::DefaultNumWorkers();
+	m_progressCallback = NULL;
+	m_progressContext = NULL;
+	m_pStop = NULL;
+	m_numRecomputed = 0;
+	m_numFailed = 0;
+}
+
+SummaryRecomputer::~SummaryRecomputer()
+{
+}
+
+bool SummaryRecomputer::ReplaySensor(Database& db, ActivitySummary& summary, SensorType sensor)
+{
+	SensorReadingList readings;
+
+	// Same readings as LoadHistoricalActivitySensorData sends to the activity when it is loaded in the foreground.
+	switch (sensor)
+	{
+	case SENSOR_TYPE_ACCELEROMETER:
+	case SENSOR_TYPE_LOCATION:
+	case SENSOR_TYPE_HEART_RATE:
+	case SENSOR_TYPE_CADENCE:
+	case SENSOR_TYPE_POWER:
+		if (!db.RetrieveSensorReadingsOfType(summary.activityId, sensor, readings))
+		{
+			return false;
+		}
+		break;
+	case SENSOR_TYPE_RADAR:
+		if (!db.RetrieveActivityEventReadings(summary.activityId, readings))
+		{
+			return false;
+		}
+		break;
+	case SENSOR_TYPE_UNKNOWN:
+	case SENSOR_TYPE_FOOT_POD:
+	case SENSOR_TYPE_SCALE:
+	case SENSOR_TYPE_LIGHT:
+	case NUM_SENSOR_TYPES:
+		return false;
+	case SENSOR_TYPE_WHEEL_SPEED:
+	case SENSOR_TYPE_GOPRO:
+	case SENSOR_TYPE_NEARBY:
+		return true;
+	}
+
+	for (auto iter = readings.begin(); iter != readings.end(); ++iter)
+	{
+		if ((*iter).type == sensor)
+		{
+			summary.pActivity->ProcessSensorReading((*iter));
+		}
+	}
+	return true;
+}
+
+bool SummaryRecomputer::Recompute(Database& db, ActivitySummary& summary, RecomputedActivity& result)
+{
+	ActivityFactory factory;
+	std::vector<SensorType> sensorTypes;
+	std::vector<std::string> attributes;
+	bool succeeded = true;
+
+	factory.SetUser(m_user);
+	factory.CreateActivity(summary, db);
+	if (!summary.pActivity)
+	{
+		return false;
+	}
+
+	MovingActivity* pMovingActivity = dynamic_cast<MovingActivity*>(summary.pActivity);
+	if (pMovingActivity)
+	{
+		LapSummaryList laps;
+
+		db.RetrieveLaps(summary.activityId, laps);
+		pMovingActivity->SetLaps(laps);
+	}
+
+	summary.pActivity->ListUsableSensors(sensorTypes);
+	for (auto iter = sensorTypes.begin(); iter != sensorTypes.end() && succeeded; ++iter)
+	{
+		succeeded = ReplaySensor(db, summary, (*iter));
+	}
+
+	if (succeeded)
+	{
+		summary.pActivity->OnFinishedLoadingSensorData();
+		summary.pActivity->BuildSummaryAttributeList(attributes);
+
+		for (auto iter = attributes.begin(); iter != attributes.end(); ++iter)
+		{
+			ActivityAttributeType value = summary.pActivity->QueryActivityAttribute((*iter));
+
+			if (value.valid)
+			{
+				result.attributes.push_back(std::make_pair((*iter), value));
+			}
+		}
+
+		// The object now reflects the complete activity, so the snapshot can be refreshed while it's at hand.
+		ActivitySnapshot snapshot;
+
+		snapshot.WriteHeader(summary.pActivity->GetType());
+		if (summary.pActivity->SaveState(snapshot))
+		{
+			result.snapshot = snapshot.GetData();
+		}
+	}
+
+	delete summary.pActivity;
+	summary.pActivity = NULL;
+	return succeeded;
+}
+
+void SummaryRecomputer::RecomputeActivities(void)
+{
+	Database db;
+
+	// Each worker reads through its own connection, so the workers don't queue up behind each other, or behind the
+	// writer, on the shared one.
+	if (db.OpenReadOnly(m_dbFileName))
+	{
+		size_t activityIndex = 0;
+
+		db.SetBusyTimeout(SUMMARY_RECOMPUTE_BUSY_TIMEOUT_MS);
+
+		while (!Stopping() && (activityIndex = m_nextActivity++) < m_activities.size())
+		{
+			ActivitySummary summary = m_activities.at(activityIndex);
+			RecomputedActivity recomputed;
+
+			recomputed.activityId = summary.activityId;
+			recomputed.succeeded = Recompute(db, summary, recomputed);
+			m_queue.Push(std::move(recomputed));
+		}
+		db.Close();
+	}
+
+	m_queue.ProducerFinished();
+}
+
+bool SummaryRecomputer::StoreActivities(std::vector<RecomputedActivity>& batch, size_t numActivities)
+{
+	bool stored = false;
+
+	m_dbLock.lock();
+
+	if (m_pDb->BeginTransaction())
+	{
+		stored = true;
+
+		for (auto iter = batch.begin(); iter != batch.end() && stored; ++iter)
+		{
+			const RecomputedActivity& recomputed = (*iter);
+			ActivitySummary summary;
+
+			// Skip anything that failed, or that was deleted while it was being replayed.
+			if (!recomputed.succeeded || !m_pDb->RetrieveActivity(recomputed.activityId, summary))
+			{
+				continue;
+			}
+
+			stored = m_pDb->DeleteSummaryData(recomputed.activityId);
+			for (auto attrIter = recomputed.attributes.begin(); attrIter != recomputed.attributes.end() && stored; ++attrIter)
+			{
+				stored = m_pDb->CreateSummaryData(recomputed.activityId, (*attrIter).first, (*attrIter).second);
+			}
+			if (stored && recomputed.snapshot.size() > 0)
+			{
+				stored = m_pDb->CreateActivitySnapshot(recomputed.activityId, ACTIVITY_SNAPSHOT_VERSION, recomputed.snapshot);
+			}
+			if (stored)
+			{
+				stored = m_pDb->UpdateSummaryVersion(recomputed.activityId, ACTIVITY_SUMMARY_VERSION);
+			}
+			if (stored)
+			{
+				ZoneTimeRollup rollup;
+				stored = rollup.AddActivity(*m_pDb, recomputed.activityId);
+			}
+			if (stored)
+			{
+				CriticalPower criticalPower;
+				stored = criticalPower.AddActivity(*m_pDb, recomputed.activityId);
+			}
+		}
+
+		if (stored)
+		{
+			stored = m_pDb->CommitTransaction();
+		}
+		else
+		{
+			m_pDb->RollbackTransaction();
+		}
+	}
+
+	m_dbLock.unlock();
+
+	for (auto iter = batch.begin(); iter != batch.end(); ++iter)
+	{
+		bool succeeded = stored && (*iter).succeeded;
+
+		if (succeeded)
+		{
+			++m_numRecomputed;
+		}
+		else
+		{
+			++m_numFailed;
+		}
+		if (m_progressCallback)
+		{
+			m_progressCallback((*iter).activityId.c_str(), succeeded, m_numRecomputed + m_numFailed, numActivities, m_progressContext);
+		}
+	}
+
+	batch.clear();
+	return stored;
+}
+
+bool SummaryRecomputer::Update(const std::atomic<bool>* pStop)
+{
+	bool result;
+
+	m_activities.clear();
+	m_nextActivity = 0;
+	m_pStop = pStop;
+	m_numRecomputed = 0;
+	m_numFailed = 0;
+
+	m_dbLock.lock();
+	result = m_pDb->RetrieveActivitiesWithStaleSummaries(ACTIVITY_SUMMARY_VERSION, m_activities);
+	m_dbFileName = m_pDb->GetFileName();
+	m_dbLock.unlock();
+
+	if (!result || m_dbFileName.empty())
+	{
+		return false;
+	}
+	if (m_activities.empty())
+	{
+		return true;
+	}
+
+	size_t numWorkers = std::min(m_numWorkers, m_activities.size());
+	WorkerPool workers;
+	std::vector<RecomputedActivity> batch;
+	RecomputedActivity recomputed;
+
+	m_queue.Open(numWorkers);
+	workers.Start(numWorkers, [this](size_t) { RecomputeActivities(); });
+
+	// Store the results a batch at a time, as the workers finish them.
+	while (m_queue.Pop(recomputed))
+	{
+		batch.push_back(std::move(recomputed));
+
+		if (batch.size() >= SUMMARY_RECOMPUTE_STORE_BATCH_SIZE)
+		{
+			result &= StoreActivities(batch, m_activities.size());
+		}
+	}
+	if (batch.size() > 0)
+	{
+		result &= StoreActivities(batch, m_activities.size());
+	}
+
+	workers.Join();
+
+	// Activities that weren't reached, because the workers couldn't open the database, count as failures. Those
+	// skipped because of a stop are just left for the next Update.
+	if (!Stopping() && m_numRecomputed + m_numFailed < m_activities.size())
+	{
+		result = false;
+	}
+
+	m_activities.clear();
+	m_pStop = NULL;
+	return result && (m_numFailed == 0);
+}
+
+bool SummaryRecomputer::Rebuild(const std::atomic<bool>* pStop)
+{
+	bool result;
+
+	m_dbLock.lock();
+	result = m_pDb->DeleteAllSummaryVersions();
+	m_dbLock.unlock();
+
+	return result && Update(pStop);
+}
+
+SummaryRecomputeUpdater::SummaryRecomputeUpdater(Database* pDb, std::mutex& dbLock) :
+	m_recomputer(pDb, dbLock)
+{
+}
+
+SummaryRecomputeUpdater::~SummaryRecomputeUpdater()
+{
+	Stop();
+}
+
+bool SummaryRecomputeUpdater::Start(bool rebuild, User user, SummaryRecomputeProgressFunc func, void* context)
+{
+	// The recomputer is only touched from the background thread, so it's set up there too.
+	return m_job.Start([this, rebuild, user, func, context](const std::atomic<bool>& stop)
+	{
+		m_recomputer.SetUser(user);
+		m_recomputer.SetProgressCallback(func, context);
+
+		if (rebuild)
+		{
+			m_recomputer.Rebuild(&stop);
+		}
+		else
+		{
+			m_recomputer.Update(&stop);
+		}
+	});
+}
+
+void SummaryRecomputeUpdater::Stop(void)
+{
+	m_job.Stop();
+}
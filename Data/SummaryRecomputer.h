@@ -0,0 +1,130 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __SUMMARYRECOMPUTER__
+#define __SUMMARYRECOMPUTER__
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ActivityAttributeType.h"
+#include "BackgroundJob.h"
+#include "Database.h"
+#include "User.h"
+#include "WorkQueue.h"
+
+// Bump this whenever a change to the activity code (smoothing, the calorie model, etc.) changes what ends up in an
+// activity's summary. Activities summarized by an older version are recomputed by the next SummaryRecomputer::Update.
+#define ACTIVITY_SUMMARY_VERSION 3
+
+#define SUMMARY_RECOMPUTE_MAX_QUEUED_RESULTS 16   // Recomputed activities waiting for the writer, bounds memory use
+#define SUMMARY_RECOMPUTE_STORE_BATCH_SIZE   16   // Activities whose summaries are written in each transaction
+#define SUMMARY_RECOMPUTE_BUSY_TIMEOUT_MS    5000 // How long the workers' connections wait for a lock on the file
+
+// Called on the writer thread after each activity has either been stored or has failed.
+typedef void (*SummaryRecomputeProgressFunc)(const char* const activityId, bool succeeded, size_t numCompleted, size_t numActivities, void* context);
+
+/**
+* Recomputes the summaries of historical activities by replaying their sensor data through new activity objects.
+*
+* Replaying is the expensive part and only needs to read the database, so a pool of worker threads each opens its own
+* read only connection to the database file, creates its own activity objects, and replays one activity at a time.
+* A single writer (the calling thread) takes the results off a bounded queue and stores them, a batch of activities
+* per transaction, holding the database lock only while it does. Each activity's summary is replaced along with its
+* snapshot, and stamped with ACTIVITY_SUMMARY_VERSION, so if the job is stopped part way through, the next Update
+* carries on from there.
+*
+* The database has to be a file, since an in-memory database can't be opened a second time.
+*/
+class SummaryRecomputer
+{
+public:
+	SummaryRecomputer(Database* pDb, std::mutex& dbLock);
+	virtual ~SummaryRecomputer();
+
+	/// @brief The user's profile is given to each activity, the same way ActivityFactory does.
+	void SetUser(User user) { m_user = user; };
+	void SetNumWorkers(size_t numWorkers) { m_numWorkers = numWorkers; };
+	void SetProgressCallback(SummaryRecomputeProgressFunc func, void* context) { m_progressCallback = func; m_progressContext = context; };
+
+	/// @brief Recomputes every activity whose summary was computed by an older version of the activity code.
+	/// Returns FALSE if the database couldn't be read, or if any of the activities failed.
+	bool Update(const std::atomic<bool>* pStop = NULL);
+
+	/// @brief Recomputes every activity, regardless of its version.
+	bool Rebuild(const std::atomic<bool>* pStop = NULL);
+
+	size_t GetNumRecomputed(void) const { return m_numRecomputed; };
+	size_t GetNumFailed(void) const { return m_numFailed; };
+
+private:
+	typedef std::vector<std::pair<std::string, ActivityAttributeType>> AttributeList;
+
+	typedef struct RecomputedActivity
+	{
+		std::string          activityId;
+		bool                 succeeded;
+		AttributeList        attributes;
+		std::vector<uint8_t> snapshot;   // Empty if the activity type can't be snapshotted
+	} RecomputedActivity;
+
+	Database*                      m_pDb;
+	std::mutex&                    m_dbLock;
+	User                           m_user;
+	size_t                         m_numWorkers;
+	SummaryRecomputeProgressFunc   m_progressCallback;
+	void*                          m_progressContext;
+
+	std::string                    m_dbFileName;
+	ActivitySummaryList            m_activities;    // Activities to recompute, oldest first
+	std::atomic<size_t>            m_nextActivity;  // Index of the next activity for a worker to replay
+	const std::atomic<bool>*       m_pStop;
+
+	WorkQueue<RecomputedActivity>  m_queue;         // Recomputed activities waiting for the writer
+
+	size_t                         m_numRecomputed;
+	size_t                         m_numFailed;
+
+	bool Stopping(void) const { return m_pStop && (*m_pStop); };
+
+	void RecomputeActivities(void);
+	bool Recompute(Database& db, ActivitySummary& summary, RecomputedActivity& result);
+	bool ReplaySensor(Database& db, ActivitySummary& summary, SensorType sensor);
+	bool StoreActivities(std::vector<RecomputedActivity>& batch, size_t numActivities);
+};
+
+/**
+* Runs SummaryRecomputer::Update, or Rebuild, on a background thread, so that it can be stopped before the database
+* is closed.
+*/
+class SummaryRecomputeUpdater
+{
+public:
+	SummaryRecomputeUpdater(Database* pDb, std::mutex& dbLock);
+	virtual ~SummaryRecomputeUpdater();
+
+	/// @brief Starts the background thread, does nothing if it is already running. The progress callback is called
+	/// on the background thread.
+	bool Start(bool rebuild, User user, SummaryRecomputeProgressFunc func, void* context);
+
+	/// @brief Asks the background thread to stop and waits for it to store what it has recomputed so far.
+	void Stop(void);
+
+	bool IsRunning(void) const { return m_job.IsRunning(); };
+
+private:
+	SummaryRecomputer m_recomputer;
+	BackgroundJob     m_job;
+};
+
+#endif
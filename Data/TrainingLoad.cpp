@@ -0,0 +1,390 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "TrainingLoad.h"
+#include "ActivityType.h"
+#include "Distance.h"
+#include "IntensityCalculator.h"
+#include "SensorCursor.h"
+
+#include <algorithm>
+#include <math.h>
+
+#define SECS_PER_DAY 86400
+
+TrainingLoad::TrainingLoad()
+{
+}
+
+TrainingLoad::~TrainingLoad()
+{
+}
+
+int64_t TrainingLoad::DayNumber(time_t timestamp)
+{
+	struct tm localTime;
+	int64_t localSecs = (int64_t)timestamp;
+
+	if (localtime_r(&timestamp, &localTime))
+	{
+		localSecs += localTime.tm_gmtoff;
+	}
+
+	// Round towards minus infinity, so times before the epoch land on the right day too.
+	return (localSecs >= 0) ? (localSecs / SECS_PER_DAY) : ((localSecs - SECS_PER_DAY + 1) / SECS_PER_DAY);
+}
+
+bool TrainingLoad::IsCyclingType(const std::string& activityType)
+{
+	return activityType.compare(ACTIVITY_TYPE_CYCLING) == 0 ||
+	       activityType.compare(ACTIVITY_TYPE_MOUNTAIN_BIKING) == 0 ||
+	       activityType.compare(ACTIVITY_TYPE_STATIONARY_CYCLING) == 0 ||
+	       activityType.compare(ACTIVITY_TYPE_VIRTUAL_CYCLING) == 0;
+}
+
+double TrainingLoad::NormalizedPower(const TrainingLoadSampleList& power, double& durationSecs)
+{
+	std::vector<double> window(TRAINING_LOAD_NP_WINDOW_SECS, 0.0);
+	double windowSum = 0.0;
+	double sumFourthPowers = 0.0;
+	uint64_t elapsedMs = 0;
+	size_t numSecs = 0;
+	size_t numAverages = 0;
+
+	// Power meters report at irregular intervals, so hold each reading until the next one to get a value for every
+	// second, then take the rolling average over the window. Pauses are left out rather than counted as zero watts.
+	// Seconds are counted from the accumulated time, so readings less than a second apart still add up.
+	for (size_t i = 0; i + 1 < power.size(); ++i)
+	{
+		uint64_t gapMs = (power[i + 1].time > power[i].time) ? (power[i + 1].time - power[i].time) : 0;
+
+		if (gapMs > TRAINING_LOAD_MAX_READING_GAP_MS)
+		{
+			gapMs = TRAINING_LOAD_MAX_READING_GAP_MS;
+		}
+		elapsedMs += gapMs;
+
+		while (numSecs < elapsedMs / 1000)
+		{
+			double watts = power[i].value;
+			size_t slot = numSecs % TRAINING_LOAD_NP_WINDOW_SECS;
+
+			windowSum += watts - window[slot];
+			window[slot] = watts;
+			++numSecs;
+
+			if (numSecs >= TRAINING_LOAD_NP_WINDOW_SECS)
+			{
+				double average = windowSum / (double)TRAINING_LOAD_NP_WINDOW_SECS;
+
+				sumFourthPowers += average * average * average * average;
+				++numAverages;
+			}
+		}
+	}
+
+	durationSecs = (double)numSecs;
+	if (numAverages == 0)
+	{
+		return (double)0.0;
+	}
+	return pow(sumFourthPowers / (double)numAverages, 0.25);
+}
+
+double TrainingLoad::Trimp(const TrainingLoadSampleList& heartRate, double restingHr, double maxHr, bool female)
+{
+	IntensityCalculator calc;
+	double trimp = 0.0;
+
+	if (maxHr <= restingHr)
+	{
+		return (double)0.0;
+	}
+
+	for (size_t i = 0; i + 1 < heartRate.size(); ++i)
+	{
+		uint64_t gapMs = (heartRate[i + 1].time > heartRate[i].time) ? (heartRate[i + 1].time - heartRate[i].time) : 0;
+		double reserveFraction = (heartRate[i].value - restingHr) / (maxHr - restingHr);
+
+		if (gapMs > TRAINING_LOAD_MAX_READING_GAP_MS)
+		{
+			gapMs = TRAINING_LOAD_MAX_READING_GAP_MS;
+		}
+		reserveFraction = std::min(std::max(reserveFraction, 0.0), 1.0);
+		trimp += calc.CalculateTrimp((double)gapMs / 60000.0, reserveFraction, female);
+	}
+	return trimp;
+}
+
+bool TrainingLoad::ReadSamples(Database& db, const std::string& activityId, SensorType type, TrainingLoadSampleList& samples)
+{
+	SensorCursor cursor;
+
+	samples.clear();
+
+	if (!db.OpenSensorCursor(activityId, type, cursor))
+	{
+		return false;
+	}
+	while (cursor.IsValid())
+	{
+		TrainingLoadSample sample;
+
+		sample.time = cursor.Time();
+		sample.value = cursor.Value(0);
+		samples.push_back(sample);
+		cursor.Next();
+	}
+	return !cursor.Failed();
+}
+
+bool TrainingLoad::ScoreActivity(Database& db, const std::string& activityId, const std::string& activityType, time_t startTime, time_t endTime, TrainingLoadActivity& activity)
+{
+	IntensityCalculator calc;
+	TrainingLoadSampleList samples;
+	SensorCursor cursor;
+
+	activity.activityId = activityId;
+	activity.activityType = activityType;
+	activity.startTime = startTime;
+	activity.endTime = endTime;
+	activity.day = DayNumber(startTime);
+	activity.distanceM = 0.0;
+	activity.stress = 0.0;
+
+	// Distance, measured the same way a moving activity measures it while it is recorded.
+	if (!db.OpenSensorCursor(activityId, SENSOR_TYPE_LOCATION, cursor))
+	{
+		return false;
+	}
+	if (cursor.IsValid())
+	{
+		double prevLatitude = cursor.Value(0);
+		double prevLongitude = cursor.Value(1);
+		double prevAltitude = cursor.Value(2);
+
+		for (cursor.Next(); cursor.IsValid(); cursor.Next())
+		{
+			activity.distanceM += LibMath::Distance::haversineDistance(prevLatitude, prevLongitude, prevAltitude, cursor.Value(0), cursor.Value(1), cursor.Value(2));
+			prevLatitude = cursor.Value(0);
+			prevLongitude = cursor.Value(1);
+			prevAltitude = cursor.Value(2);
+		}
+	}
+	if (cursor.Failed())
+	{
+		return false;
+	}
+
+	if (IsCyclingType(activityType) && m_user.GetFtp() > (double)0.0)
+	{
+		if (!ReadSamples(db, activityId, SENSOR_TYPE_POWER, samples))
+		{
+			return false;
+		}
+
+		double durationSecs = 0.0;
+		double np = NormalizedPower(samples, durationSecs);
+
+		if (np > (double)0.0)
+		{
+			activity.stress = calc.CalculateIntensityScoreFromPower(durationSecs, np, m_user.GetFtp());
+			return true;
+		}
+	}
+
+	if (m_user.HasMaxHr())
+	{
+		if (!ReadSamples(db, activityId, SENSOR_TYPE_HEART_RATE, samples))
+		{
+			return false;
+		}
+
+		bool female = m_user.GetGender() == GENDER_FEMALE;
+		double trimp = Trimp(samples, m_user.GetRestingHr(), m_user.GetMaxHr(), female);
+
+		activity.stress = calc.CalculateIntensityScoreFromTrimp(trimp, female);
+	}
+	return true;
+}
+
+void TrainingLoad::Decay(double& ctl, double& atl, int64_t numDays)
+{
+	if (numDays > 0)
+	{
+		ctl *= pow(1.0 - 1.0 / TRAINING_LOAD_CTL_DAYS, (double)numDays);
+		atl *= pow(1.0 - 1.0 / TRAINING_LOAD_ATL_DAYS, (double)numDays);
+	}
+}
+
+bool TrainingLoad::RollUp(Database& db, int64_t fromDay)
+{
+	TrainingLoadDay prevDay;
+	std::vector<std::pair<int64_t, double>> dailyStress;
+
+	if (!db.RetrieveTrainingLoadDailyStress(fromDay, dailyStress))
+	{
+		return false;
+	}
+	if (!db.RetrieveTrainingLoadDayBefore(fromDay, prevDay))
+	{
+		prevDay.day = fromDay - 1;
+		prevDay.ctl = 0.0;
+		prevDay.atl = 0.0;
+	}
+
+	TrainingLoadDayList days;
+	double ctl = prevDay.ctl;
+	double atl = prevDay.atl;
+	int64_t lastDay = prevDay.day;
+
+	for (auto iter = dailyStress.begin(); iter != dailyStress.end(); ++iter)
+	{
+		TrainingLoadDay day;
+
+		day.day = iter->first;
+		day.stress = iter->second;
+
+		// Bring the loads up to the end of the day before, then add this day's stress.
+		Decay(ctl, atl, day.day - lastDay - 1);
+		day.tsb = ctl - atl;
+		ctl += (day.stress - ctl) / TRAINING_LOAD_CTL_DAYS;
+		atl += (day.stress - atl) / TRAINING_LOAD_ATL_DAYS;
+		day.ctl = ctl;
+		day.atl = atl;
+		days.push_back(day);
+
+		lastDay = day.day;
+	}
+
+	return db.ReplaceTrainingLoadDays(fromDay, days);
+}
+
+bool TrainingLoad::AddActivity(Database& db, const std::string& activityId)
+{
+	ActivitySummary summary;
+	TrainingLoadActivity activity;
+	TrainingLoadActivity oldActivity;
+
+	if (!(db.RetrieveActivity(activityId, summary) && ScoreActivity(db, activityId, summary.type, summary.startTime, summary.endTime, activity)))
+	{
+		return false;
+	}
+
+	// Trimming the start of an activity can move it to the day before.
+	int64_t fromDay = activity.day;
+
+	if (db.RetrieveTrainingLoadActivity(activityId, oldActivity))
+	{
+		fromDay = std::min(fromDay, oldActivity.day);
+	}
+
+	return db.CreateTrainingLoadActivities(TrainingLoadActivityList(1, activity)) && RollUp(db, fromDay);
+}
+
+bool TrainingLoad::RemoveActivity(Database& db, const std::string& activityId)
+{
+	TrainingLoadActivity activity;
+
+	if (!db.RetrieveTrainingLoadActivity(activityId, activity))
+	{
+		return true;
+	}
+	return db.DeleteTrainingLoadActivity(activityId) && RollUp(db, activity.day);
+}
+
+bool TrainingLoad::Update(Database& db)
+{
+	ActivitySummaryList summaries;
+	TrainingLoadActivityList activities;
+
+	if (!db.RetrieveActivitiesWithoutTrainingLoad(summaries))
+	{
+		return false;
+	}
+	if (summaries.empty())
+	{
+		return true;
+	}
+
+	int64_t fromDay = INT64_MAX;
+
+	for (auto iter = summaries.begin(); iter != summaries.end(); ++iter)
+	{
+		TrainingLoadActivity activity;
+
+		if (!ScoreActivity(db, (*iter).activityId, (*iter).type, (*iter).startTime, (*iter).endTime, activity))
+		{
+			return false;
+		}
+		fromDay = std::min(fromDay, activity.day);
+		activities.push_back(activity);
+	}
+
+	return db.CreateTrainingLoadActivities(activities) && RollUp(db, fromDay);
+}
+
+bool TrainingLoad::Rebuild(Database& db)
+{
+	return db.DeleteAllTrainingLoad() && Update(db);
+}
+
+bool TrainingLoad::GetDays(Database& db, int64_t firstDay, int64_t lastDay, TrainingLoadDayList& days)
+{
+	TrainingLoadDayList storedDays;
+	TrainingLoadDay prevDay;
+
+	if (!db.RetrieveTrainingLoadDays(firstDay, lastDay, storedDays))
+	{
+		return false;
+	}
+	if (!db.RetrieveTrainingLoadDayBefore(firstDay, prevDay))
+	{
+		prevDay.day = firstDay - 1;
+		prevDay.ctl = 0.0;
+		prevDay.atl = 0.0;
+	}
+
+	double ctl = prevDay.ctl;
+	double atl = prevDay.atl;
+	int64_t lastStoredDay = prevDay.day;
+	auto storedIter = storedDays.begin();
+
+	for (int64_t dayNum = firstDay; dayNum <= lastDay; ++dayNum)
+	{
+		if (storedIter != storedDays.end() && (*storedIter).day == dayNum)
+		{
+			days.push_back(*storedIter);
+			ctl = (*storedIter).ctl;
+			atl = (*storedIter).atl;
+			lastStoredDay = dayNum;
+			++storedIter;
+		}
+		else
+		{
+			TrainingLoadDay day;
+			double dayCtl = ctl;
+			double dayAtl = atl;
+
+			// A rest day: both loads just decay from the last day that had any activities.
+			Decay(dayCtl, dayAtl, dayNum - lastStoredDay - 1);
+			day.day = dayNum;
+			day.stress = 0.0;
+			day.tsb = dayCtl - dayAtl;
+			Decay(dayCtl, dayAtl, 1);
+			day.ctl = dayCtl;
+			day.atl = dayAtl;
+			days.push_back(day);
+		}
+	}
+	return true;
+}
+
+bool TrainingLoad::GetActivities(Database& db, time_t startTime, time_t endTime, TrainingLoadActivityList& activities)
+{
+	return db.RetrieveTrainingLoadActivities(startTime, endTime, activities);
+}
@@ -0,0 +1,98 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __TRAININGLOAD__
+#define __TRAININGLOAD__
+
+#pragma once
+
+#include "Database.h"
+#include "TrainingLoadDay.h"
+#include "User.h"
+
+#include <stdint.h>
+#include <string>
+#include <time.h>
+#include <vector>
+
+#define TRAINING_LOAD_CTL_DAYS           42.0  // Time constant of the chronic training load (fitness)
+#define TRAINING_LOAD_ATL_DAYS           7.0   // Time constant of the acute training load (fatigue)
+#define TRAINING_LOAD_NP_WINDOW_SECS     30    // Rolling average applied to power before normalizing it
+#define TRAINING_LOAD_MAX_READING_GAP_MS 10000 // Gaps between readings longer than this are pauses, and don't count
+
+typedef struct TrainingLoadSample
+{
+	uint64_t time; // time in milliseconds
+	double   value;
+} TrainingLoadSample;
+
+typedef std::vector<TrainingLoadSample> TrainingLoadSampleList;
+
+/**
+* Scores the training stress of each activity, and keeps a daily rollup of chronic training load (CTL), acute
+* training load (ATL), and training stress balance (TSB).
+*
+* Cycling activities with power data are scored from normalized power and the user's FTP. Everything else is scored
+* from heart rate with Banister's TRIMP, scaled so that an hour at threshold scores 100, as it does with power.
+* Activities without either are recorded with no stress.
+*
+* CTL and ATL are exponentially weighted averages of the daily stress. Only days with activities have a row, the days
+* in between are worked out from the row before them. Adding or removing an activity only rewrites the rows from its
+* day onwards, which is usually just today's, and reading a range of days reads no more than one row per day.
+*
+* All methods expect the caller to hold the database lock.
+*/
+class TrainingLoad
+{
+public:
+	TrainingLoad();
+	virtual ~TrainingLoad();
+
+	/// @brief The user's FTP, heart rates, and gender are needed to score activities.
+	void SetUser(User user) { m_user = user; };
+
+	/// @brief Scores the activity, replacing any score it already had, e.g. when the activity is trimmed, and rolls up
+	/// the days that it affects.
+	bool AddActivity(Database& db, const std::string& activityId);
+
+	/// @brief Takes the activity out of the daily rollup. Must be called before the activity is deleted.
+	bool RemoveActivity(Database& db, const std::string& activityId);
+
+	/// @brief Scores every activity that doesn't have a score yet, e.g. activities recorded before the training load was
+	/// kept, or bulk imported, then rolls up the affected days once.
+	bool Update(Database& db);
+
+	/// @brief Throws away every score and works them out again, e.g. after the user's FTP or heart rates change.
+	bool Rebuild(Database& db);
+
+	/// @brief Retrieves one entry for each day from firstDay to lastDay, including days without any activities.
+	bool GetDays(Database& db, int64_t firstDay, int64_t lastDay, TrainingLoadDayList& days);
+
+	/// @brief Retrieves the scored activities that started in the given time range, oldest first.
+	bool GetActivities(Database& db, time_t startTime, time_t endTime, TrainingLoadActivityList& activities);
+
+	/// @brief Converts a time to the local calendar day it falls on.
+	static int64_t DayNumber(time_t timestamp);
+
+	/// @brief Normalized power of the readings, and the number of seconds of riding that it covers.
+	static double NormalizedPower(const TrainingLoadSampleList& power, double& durationSecs);
+
+	/// @brief Banister's TRIMP for the heart rate readings.
+	static double Trimp(const TrainingLoadSampleList& heartRate, double restingHr, double maxHr, bool female);
+
+private:
+	User m_user;
+
+	bool ScoreActivity(Database& db, const std::string& activityId, const std::string& activityType, time_t startTime, time_t endTime, TrainingLoadActivity& activity);
+	bool ReadSamples(Database& db, const std::string& activityId, SensorType type, TrainingLoadSampleList& samples);
+	bool RollUp(Database& db, int64_t fromDay);
+
+	static bool IsCyclingType(const std::string& activityType);
+	static void Decay(double& ctl, double& atl, int64_t numDays);
+};
+
+#endif
@@ -0,0 +1,42 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __TRAININGLOADDAY__
+#define __TRAININGLOADDAY__
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <time.h>
+#include <vector>
+
+typedef struct TrainingLoadActivity
+{
+	std::string activityId;
+	std::string activityType;
+	time_t      startTime;
+	time_t      endTime;
+	int64_t     day;       // local calendar day on which the activity started, as days since the Unix epoch
+	double      distanceM; // zero for activities without a location track
+	double      stress;    // training stress score
+} TrainingLoadActivity;
+
+typedef std::vector<TrainingLoadActivity> TrainingLoadActivityList;
+
+typedef struct TrainingLoadDay
+{
+	int64_t day;    // days since the Unix epoch
+	double  stress; // total training stress score of the day's activities
+	double  ctl;    // chronic training load (fitness), at the end of the day
+	double  atl;    // acute training load (fatigue), at the end of the day
+	double  tsb;    // training stress balance (form) going into the day, i.e. the previous day's CTL minus ATL
+} TrainingLoadDay;
+
+typedef std::vector<TrainingLoadDay> TrainingLoadDayList;
+
+#endif
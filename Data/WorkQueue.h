@@ -0,0 +1,87 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __WORKQUEUE__
+#define __WORKQUEUE__
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+/**
+* A bounded queue for handing work from one set of threads to another, e.g. from the thread reading the database to a
+* pool of workers, or from a pool of workers to the thread writing the database.
+*
+* Push blocks while the queue is full, which bounds memory use when the producers are quicker than the consumers. Each
+* producer calls ProducerFinished when it has nothing more to push, and once they all have, and the queue is empty,
+* Pop returns FALSE so the consumers know to stop.
+*/
+template <typename T>
+class WorkQueue
+{
+public:
+	WorkQueue(size_t maxQueued) : m_maxQueued(maxQueued), m_numProducers(0) {};
+	virtual ~WorkQueue() {};
+
+	/// @brief Empties the queue and sets the number of producers that have to finish before it is done.
+	void Open(size_t numProducers)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_queue.clear();
+		m_numProducers = numProducers;
+	};
+
+	/// @brief Adds an item, waiting for there to be room for it.
+	void Push(T&& item)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_notFull.wait(lock, [this] { return m_queue.size() < m_maxQueued; });
+		m_queue.push_back(std::move(item));
+		m_notEmpty.notify_one();
+	};
+
+	/// @brief Takes the oldest item, waiting for one to be pushed. Returns FALSE once every producer has finished and
+	/// there is nothing left.
+	bool Pop(T& item)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_notEmpty.wait(lock, [this] { return !m_queue.empty() || m_numProducers == 0; });
+
+		if (m_queue.empty())
+		{
+			return false;
+		}
+		item = std::move(m_queue.front());
+		m_queue.pop_front();
+		m_notFull.notify_one();
+		return true;
+	};
+
+	/// @brief Called by each producer once it has nothing more to push.
+	void ProducerFinished(void)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (m_numProducers > 0)
+		{
+			--m_numProducers;
+		}
+		m_notEmpty.notify_all();
+	};
+
+private:
+	size_t                  m_maxQueued;
+	size_t                  m_numProducers; // Producers that haven't finished yet
+	std::deque<T>           m_queue;
+	std::mutex              m_mutex;
+	std::condition_variable m_notEmpty;
+	std::condition_variable m_notFull;
+};
+
+#endif
@@ -0,0 +1,27 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __ZONETIME__
+#define __ZONETIME__
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "ZoneType.h"
+
+typedef struct ZoneTime
+{
+	ZoneType zoneType;
+	uint8_t  zone;    // numbered from 1, as they are by User
+	double   seconds; // time spent in the zone
+} ZoneTime;
+
+typedef std::vector<ZoneTime> ZoneTimeList;
+
+#endif
@@ -0,0 +1,220 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "ZoneTimeRollup.h"
+#include "ActivityAttribute.h"
+#include "TrainingLoad.h"
+#include "ZoneHistogram.h"
+
+#define ZONE_TIME_DAYS_PER_WEEK 7
+#define MONDAY_DAY_OFFSET       3 // The Unix epoch was a Thursday, so the Monday before it is day -3
+
+ZoneTimeRollup::ZoneTimeRollup()
+{
+}
+
+ZoneTimeRollup::~ZoneTimeRollup()
+{
+}
+
+int64_t ZoneTimeRollup::WeekNumber(int64_t day)
+{
+	int64_t shifted = day + MONDAY_DAY_OFFSET;
+	int64_t week = shifted / ZONE_TIME_DAYS_PER_WEEK;
+
+	// Round towards negative infinity, for days before the epoch.
+	if (shifted % ZONE_TIME_DAYS_PER_WEEK < 0)
+	{
+		--week;
+	}
+	return week;
+}
+
+int64_t ZoneTimeRollup::FirstDayOfWeek(int64_t week)
+{
+	return (week * ZONE_TIME_DAYS_PER_WEEK) - MONDAY_DAY_OFFSET;
+}
+
+void ZoneTimeRollup::ParseSummary(const ActivityAttributeMap& summary, ZoneTimeList& times)
+{
+	for (auto iter = summary.begin(); iter != summary.end(); ++iter)
+	{
+		const std::string& attributeName = (*iter).first;
+		const ActivityAttributeType& value = (*iter).second;
+		ZoneTime time;
+
+		if (!value.valid || value.valueType != TYPE_TIME)
+		{
+			continue;
+		}
+
+		if ((time.zone = ZoneHistogram::ZoneFromAttributeName(attributeName, ACTIVITY_ATTRIBUTE_TIME_IN_HR_ZONE)) > 0)
+		{
+			time.zoneType = ZONE_TYPE_HEART_RATE;
+		}
+		else if ((time.zone = ZoneHistogram::ZoneFromAttributeName(attributeName, ACTIVITY_ATTRIBUTE_TIME_IN_POWER_ZONE)) > 0)
+		{
+			time.zoneType = ZONE_TYPE_POWER;
+		}
+		else
+		{
+			continue;
+		}
+
+		time.seconds = (double)value.value.timeVal;
+		times.push_back(time);
+	}
+}
+
+bool ZoneTimeRollup::AddActivity(Database& db, const std::string& activityId)
+{
+	ActivitySummary summary;
+	ActivityAttributeMap values;
+	ZoneTimeList times;
+	int64_t oldWeek = 0;
+
+	if (!db.RetrieveActivity(activityId, summary))
+	{
+		return false;
+	}
+
+	// An activity without a summary just doesn't have any times.
+	db.RetrieveSummaryData(activityId, values);
+	ParseSummary(values, times);
+
+	bool hadTimes = db.RetrieveZoneTimeWeek(activityId, oldWeek);
+	int64_t day = TrainingLoad::DayNumber(summary.startTime);
+	int64_t week = WeekNumber(day);
+
+	if (!db.CreateZoneTimes(activityId, day, week, times))
+	{
+		return false;
+	}
+
+	// Trimming an activity can move its start into another week.
+	if (hadTimes && oldWeek != week && !db.UpdateZoneTimeWeeks(oldWeek, oldWeek))
+	{
+		return false;
+	}
+	return db.UpdateZoneTimeWeeks(week, week);
+}
+
+bool ZoneTimeRollup::RemoveActivity(Database& db, const std::string& activityId)
+{
+	int64_t week = 0;
+
+	if (!db.RetrieveZoneTimeWeek(activityId, week))
+	{
+		return true;
+	}
+	return db.DeleteZoneTimes(activityId) && db.UpdateZoneTimeWeeks(week, week);
+}
+
+bool ZoneTimeRollup::Rebuild(Database& db)
+{
+	ActivitySummaryList activities;
+
+	if (!(db.DeleteAllZoneTimes() && db.RetrieveActivities(activities)))
+	{
+		return false;
+	}
+
+	// Store every activity's times first, then roll them all up at once.
+	for (auto iter = activities.begin(); iter != activities.end(); ++iter)
+	{
+		ActivityAttributeMap values;
+		ZoneTimeList times;
+		int64_t day = TrainingLoad::DayNumber((*iter).startTime);
+
+		db.RetrieveSummaryData((*iter).activityId, values);
+		ParseSummary(values, times);
+
+		if (times.size() > 0 && !db.CreateZoneTimes((*iter).activityId, day, WeekNumber(day), times))
+		{
+			return false;
+		}
+	}
+	return db.UpdateZoneTimeWeeks(INT64_MIN, INT64_MAX);
+}
+
+void ZoneTimeRollup::AddTimes(const ZoneTimeList& from, ZoneTimeList& to)
+{
+	for (auto fromIter = from.begin(); fromIter != from.end(); ++fromIter)
+	{
+		for (auto toIter = to.begin(); toIter != to.end(); ++toIter)
+		{
+			if ((*toIter).zoneType == (*fromIter).zoneType && (*toIter).zone == (*fromIter).zone)
+			{
+				(*toIter).seconds += (*fromIter).seconds;
+				break;
+			}
+		}
+	}
+}
+
+bool ZoneTimeRollup::GetZoneTimes(Database& db, int64_t firstDay, int64_t lastDay, ZoneTimeList& times)
+{
+	times.clear();
+
+	for (uint8_t zone = 1; zone <= NUM_HR_HISTOGRAM_ZONES; ++zone)
+	{
+		times.push_back({ ZONE_TYPE_HEART_RATE, zone, (double)0.0 });
+	}
+	for (uint8_t zone = 1; zone <= NUM_POWER_HISTOGRAM_ZONES; ++zone)
+	{
+		times.push_back({ ZONE_TYPE_POWER, zone, (double)0.0 });
+	}
+
+	if (lastDay < firstDay)
+	{
+		return true;
+	}
+
+	// The whole weeks in the range come from the weekly totals.
+	int64_t firstWeek = WeekNumber(firstDay);
+	int64_t lastWeek = WeekNumber(lastDay);
+
+	if (FirstDayOfWeek(firstWeek) < firstDay)
+	{
+		++firstWeek;
+	}
+	if (FirstDayOfWeek(lastWeek + 1) - 1 > lastDay)
+	{
+		--lastWeek;
+	}
+
+	ZoneTimeList partTimes;
+
+	if (firstWeek > lastWeek)
+	{
+		if (!db.RetrieveZoneTimesForDays(firstDay, lastDay, partTimes))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		int64_t firstWholeDay = FirstDayOfWeek(firstWeek);
+		int64_t lastWholeDay = FirstDayOfWeek(lastWeek + 1) - 1;
+
+		if (!db.RetrieveZoneTimesForWeeks(firstWeek, lastWeek, partTimes))
+		{
+			return false;
+		}
+		if (firstDay < firstWholeDay && !db.RetrieveZoneTimesForDays(firstDay, firstWholeDay - 1, partTimes))
+		{
+			return false;
+		}
+		if (lastWholeDay < lastDay && !db.RetrieveZoneTimesForDays(lastWholeDay + 1, lastDay, partTimes))
+		{
+			return false;
+		}
+	}
+
+	AddTimes(partTimes, times);
+	return true;
+}
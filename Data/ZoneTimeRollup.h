@@ -0,0 +1,61 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __ZONETIMEROLLUP__
+#define __ZONETIMEROLLUP__
+
+#pragma once
+
+#include "Database.h"
+#include "ZoneTime.h"
+
+#include <stdint.h>
+#include <string>
+
+/**
+* Keeps the time spent in each heart rate and power zone, per activity and per week, so that the distribution over
+* any range of days can be read without going back to the readings.
+*
+* Activities add up their own time in zone as the readings arrive (see ZoneHistogram) and store it in their summary.
+* This copies each activity's times out of its summary into a table of its own, and keeps a running total for each
+* week (Monday to Sunday, local time). A range of days is answered from the weekly totals for the whole weeks it
+* covers, plus the activities on the days at either end.
+*
+* All methods expect the caller to hold the database lock. None of them start a transaction.
+*/
+class ZoneTimeRollup
+{
+public:
+	ZoneTimeRollup();
+	virtual ~ZoneTimeRollup();
+
+	/// @brief Reads the activity's times from its summary, replacing any it already had. Must be called whenever the
+	/// summary is saved.
+	bool AddActivity(Database& db, const std::string& activityId);
+
+	/// @brief Takes the activity out of the weekly totals. Must be called before the activity is deleted.
+	bool RemoveActivity(Database& db, const std::string& activityId);
+
+	/// @brief Throws away every total and reads them all again from the summaries.
+	bool Rebuild(Database& db);
+
+	/// @brief Time in each zone, on the days from firstDay to lastDay (as counted by TrainingLoad::DayNumber). Every
+	/// zone is included, heart rate zones first, even if no time was spent in it.
+	bool GetZoneTimes(Database& db, int64_t firstDay, int64_t lastDay, ZoneTimeList& times);
+
+	/// @brief Weeks start on a Monday. Week zero is the one that contains the Unix epoch.
+	static int64_t WeekNumber(int64_t day);
+	static int64_t FirstDayOfWeek(int64_t week);
+
+	/// @brief Picks the time in zone attributes out of a summary.
+	static void ParseSummary(const ActivityAttributeMap& summary, ZoneTimeList& times);
+
+private:
+	static void AddTimes(const ZoneTimeList& from, ZoneTimeList& to);
+};
+
+#endif
@@ -0,0 +1,377 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "ColumnarFileWriter.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace FileLib
+{
+	static void PutUInt16(std::vector<uint8_t>& data, uint16_t value)
+	{
+		data.push_back((uint8_t)value);
+		data.push_back((uint8_t)(value >> 8));
+	}
+
+	static void PutUInt32(std::vector<uint8_t>& data, uint32_t value)
+	{
+		for (size_t i = 0; i < 4; ++i)
+		{
+			data.push_back((uint8_t)(value >> (8 * i)));
+		}
+	}
+
+	static void PutUInt64(std::vector<uint8_t>& data, uint64_t value)
+	{
+		for (size_t i = 0; i < 8; ++i)
+		{
+			data.push_back((uint8_t)(value >> (8 * i)));
+		}
+	}
+
+	static void PutBytes(std::vector<uint8_t>& data, const void* src, size_t len)
+	{
+		data.insert(data.end(), (const uint8_t*)src, (const uint8_t*)src + len);
+	}
+
+	static void PutVarint(std::vector<uint8_t>& data, uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			data.push_back((uint8_t)(value | 0x80));
+			value >>= 7;
+		}
+		data.push_back((uint8_t)value);
+	}
+
+	static void PutSignedVarint(std::vector<uint8_t>& data, int64_t value)
+	{
+		PutVarint(data, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+	}
+
+	static uint64_t DoubleBits(double value)
+	{
+		uint64_t bits = 0;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	static void StoreLittleEndian(uint8_t dest[8], uint64_t value)
+	{
+		for (size_t i = 0; i < 8; ++i)
+		{
+			dest[i] = (uint8_t)(value >> (8 * i));
+		}
+	}
+
+	ColumnarFileWriter::ColumnarFileWriter()
+	{
+		m_groupRows = 0;
+		m_numRows = 0;
+		m_offset = 0;
+	}
+
+	ColumnarFileWriter::~ColumnarFileWriter()
+	{
+	}
+
+	size_t ColumnarFileWriter::AddColumn(const std::string& name, ColumnType type)
+	{
+		Column column;
+
+		column.name = name;
+		column.type = type;
+		m_columns.push_back(column);
+		return m_columns.size() - 1;
+	}
+
+	bool ColumnarFileWriter::CreateFile(const std::string& fileName)
+	{
+		m_rowGroups.clear();
+		m_groupRows = 0;
+		m_numRows = 0;
+		m_offset = 0;
+
+		if (!File::CreateFile(fileName))
+		{
+			return false;
+		}
+
+		std::vector<uint8_t> header;
+
+		PutBytes(header, COLUMNAR_FILE_MAGIC, 4);
+		PutUInt32(header, COLUMNAR_FILE_VERSION);
+		return WriteBytes(header);
+	}
+
+	void ColumnarFileWriter::SetString(size_t column, const std::string& value)
+	{
+		Column& col = m_columns.at(column);
+
+		if (col.ints.size() > m_groupRows)
+		{
+			return;
+		}
+
+		auto iter = col.dictionaryIndex.find(value);
+		uint32_t index = 0;
+
+		if (iter == col.dictionaryIndex.end())
+		{
+			index = (uint32_t)col.dictionary.size();
+			col.dictionary.push_back(value);
+			col.dictionaryIndex.insert(std::make_pair(value, index));
+		}
+		else
+		{
+			index = iter->second;
+		}
+		col.ints.push_back(index);
+	}
+
+	void ColumnarFileWriter::SetInt(size_t column, int64_t value)
+	{
+		Column& col = m_columns.at(column);
+
+		if (col.ints.size() <= m_groupRows)
+		{
+			col.ints.push_back(value);
+		}
+	}
+
+	void ColumnarFileWriter::SetDouble(size_t column, double value)
+	{
+		Column& col = m_columns.at(column);
+
+		if (col.doubles.size() <= m_groupRows)
+		{
+			col.doubles.push_back(value);
+		}
+	}
+
+	bool ColumnarFileWriter::EndRow(void)
+	{
+		for (auto iter = m_columns.begin(); iter != m_columns.end(); ++iter)
+		{
+			Column& col = (*iter);
+
+			if (col.type == COLUMN_TYPE_STRING)
+			{
+				if (col.ints.size() <= m_groupRows)
+				{
+					SetString(iter - m_columns.begin(), "");
+				}
+			}
+			else if (col.type == COLUMN_TYPE_INT64)
+			{
+				if (col.ints.size() <= m_groupRows)
+				{
+					col.ints.push_back(0);
+				}
+			}
+			else if (col.doubles.size() <= m_groupRows)
+			{
+				col.doubles.push_back((double)0.0);
+			}
+		}
+
+		++m_groupRows;
+		++m_numRows;
+
+		if (m_groupRows >= COLUMNAR_FILE_ROWS_PER_GROUP)
+		{
+			return WriteRowGroup();
+		}
+		return true;
+	}
+
+	bool ColumnarFileWriter::Close(void)
+	{
+		bool result = IsOpen();
+
+		if (result)
+		{
+			result = WriteRowGroup();
+			result &= WriteFooter();
+			result &= CloseFile();
+		}
+		return result;
+	}
+
+	bool ColumnarFileWriter::WriteBytes(const std::vector<uint8_t>& data)
+	{
+		m_offset += data.size();
+		return WriteBinaryData(data.data(), data.size());
+	}
+
+	bool ColumnarFileWriter::WriteRowGroup(void)
+	{
+		if (m_groupRows == 0)
+		{
+			return true;
+		}
+
+		RowGroupInfo group;
+		bool result = true;
+
+		group.offset = m_offset;
+		group.numRows = (uint32_t)m_groupRows;
+
+		for (auto iter = m_columns.begin(); iter != m_columns.end(); ++iter)
+		{
+			ChunkInfo info;
+
+			EncodeColumn((*iter), info);
+			result &= WriteBytes(m_buffer);
+			group.chunks.push_back(info);
+
+			(*iter).ints.clear();
+			(*iter).doubles.clear();
+		}
+
+		m_rowGroups.push_back(group);
+		m_groupRows = 0;
+		return result;
+	}
+
+	void ColumnarFileWriter::EncodeColumn(const Column& column, ChunkInfo& info)
+	{
+		m_buffer.clear();
+
+		if (column.type == COLUMN_TYPE_DOUBLE)
+		{
+			double minValue = (double)0.0;
+			double maxValue = (double)0.0;
+			bool haveValue = false;
+			uint64_t prevBits = 0;
+
+			// Consecutive readings usually share their sign, exponent, and leading mantissa bits, so XOR'ing with
+			// the previous value leaves only the low bits set and the varint is short.
+			for (auto iter = column.doubles.begin(); iter != column.doubles.end(); ++iter)
+			{
+				double value = (*iter);
+				uint64_t bits = DoubleBits(value);
+
+				PutVarint(m_buffer, bits ^ prevBits);
+				prevBits = bits;
+
+				if (!isnan(value))
+				{
+					if (!haveValue || value < minValue)
+						minValue = value;
+					if (!haveValue || value > maxValue)
+						maxValue = value;
+					haveValue = true;
+				}
+			}
+			StoreLittleEndian(info.minValue, DoubleBits(minValue));
+			StoreLittleEndian(info.maxValue, DoubleBits(maxValue));
+		}
+		else if (column.type == COLUMN_TYPE_INT64)
+		{
+			int64_t minValue = column.ints.empty() ? 0 : column.ints.front();
+			int64_t maxValue = minValue;
+			int64_t prevValue = 0;
+
+			for (auto iter = column.ints.begin(); iter != column.ints.end(); ++iter)
+			{
+				int64_t value = (*iter);
+
+				PutSignedVarint(m_buffer, (int64_t)((uint64_t)value - (uint64_t)prevValue));
+				prevValue = value;
+
+				if (value < minValue)
+					minValue = value;
+				if (value > maxValue)
+					maxValue = value;
+			}
+			StoreLittleEndian(info.minValue, (uint64_t)minValue);
+			StoreLittleEndian(info.maxValue, (uint64_t)maxValue);
+		}
+		else
+		{
+			int64_t minValue = column.ints.empty() ? 0 : column.ints.front();
+			int64_t maxValue = minValue;
+			size_t i = 0;
+
+			// Runs of (dictionary index, count). Sensor tables are written one activity at a time, so the activity
+			// column is a handful of very long runs.
+			while (i < column.ints.size())
+			{
+				int64_t value = column.ints[i];
+				size_t runLen = 1;
+
+				while (i + runLen < column.ints.size() && column.ints[i + runLen] == value)
+				{
+					++runLen;
+				}
+
+				PutVarint(m_buffer, (uint64_t)value);
+				PutVarint(m_buffer, runLen);
+				i += runLen;
+
+				if (value < minValue)
+					minValue = value;
+				if (value > maxValue)
+					maxValue = value;
+			}
+			StoreLittleEndian(info.minValue, (uint64_t)minValue);
+			StoreLittleEndian(info.maxValue, (uint64_t)maxValue);
+		}
+
+		info.length = (uint32_t)m_buffer.size();
+	}
+
+	bool ColumnarFileWriter::WriteFooter(void)
+	{
+		std::vector<uint8_t> footer;
+
+		PutUInt32(footer, (uint32_t)m_columns.size());
+		for (auto iter = m_columns.begin(); iter != m_columns.end(); ++iter)
+		{
+			footer.push_back((uint8_t)(*iter).type);
+			PutUInt16(footer, (uint16_t)(*iter).name.size());
+			PutBytes(footer, (*iter).name.data(), (*iter).name.size());
+		}
+
+		for (auto iter = m_columns.begin(); iter != m_columns.end(); ++iter)
+		{
+			if ((*iter).type == COLUMN_TYPE_STRING)
+			{
+				const std::vector<std::string>& dictionary = (*iter).dictionary;
+
+				PutUInt32(footer, (uint32_t)dictionary.size());
+				for (auto entryIter = dictionary.begin(); entryIter != dictionary.end(); ++entryIter)
+				{
+					PutUInt32(footer, (uint32_t)(*entryIter).size());
+					PutBytes(footer, (*entryIter).data(), (*entryIter).size());
+				}
+			}
+		}
+
+		PutUInt32(footer, (uint32_t)m_rowGroups.size());
+		for (auto iter = m_rowGroups.begin(); iter != m_rowGroups.end(); ++iter)
+		{
+			PutUInt64(footer, (*iter).offset);
+			PutUInt32(footer, (*iter).numRows);
+
+			for (auto chunkIter = (*iter).chunks.begin(); chunkIter != (*iter).chunks.end(); ++chunkIter)
+			{
+				PutUInt32(footer, (*chunkIter).length);
+				PutBytes(footer, (*chunkIter).minValue, 8);
+				PutBytes(footer, (*chunkIter).maxValue, 8);
+			}
+		}
+
+		uint32_t footerLen = (uint32_t)footer.size();
+
+		PutUInt32(footer, footerLen);
+		PutBytes(footer, COLUMNAR_FILE_MAGIC, 4);
+		return WriteBytes(footer);
+	}
+}
@@ -0,0 +1,116 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __COLUMNARFILEWRITER__
+#define __COLUMNARFILEWRITER__
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "File.h"
+
+#define COLUMNAR_FILE_MAGIC          "OWTC"
+#define COLUMNAR_FILE_VERSION        1
+#define COLUMNAR_FILE_ROWS_PER_GROUP 65536 // Rows buffered before they are encoded and written, bounds memory use
+
+namespace FileLib
+{
+	typedef enum ColumnType
+	{
+		COLUMN_TYPE_STRING = 0, // Dictionary encoded, runs of the same entry are stored once
+		COLUMN_TYPE_INT64,      // Difference from the previous row, as a zig-zag varint
+		COLUMN_TYPE_DOUBLE      // Bits XOR'ed with the previous row, as a varint
+	} ColumnType;
+
+	/**
+	* Writes a table one column at a time, for bulk analysis of large amounts of data.
+	*
+	* Rows are buffered into row groups. Each row group is written as one chunk per column, so a reader only has to
+	* touch the columns it needs. Every value in a chunk is stored relative to the value before it, which for sensor
+	* data (where consecutive rows are nearly the same) takes a fraction of the space of the raw values.
+	*
+	* File layout, all integers little endian:
+	*   "OWTC", u32 version
+	*   Column chunks for each row group, in column order
+	*   Footer:
+	*     u32 number of columns, then for each column: u8 type, u16 name length, name
+	*     For each string column: u32 number of dictionary entries, then for each entry: u32 length, bytes
+	*     u32 number of row groups, then for each row group: u64 file offset, u32 number of rows, then for each
+	*       column: u32 chunk length, 8 byte minimum, 8 byte maximum (int64, double, or dictionary index)
+	*   u32 footer length, "OWTC"
+	*
+	* The minimum and maximum of each chunk (its zone map) let a reader skip row groups that can't match a query.
+	* Dictionary entries are numbered in the order they are first written, so when rows are written sorted on a
+	* string column its zone map is also a range of keys.
+	*/
+	class ColumnarFileWriter : public File
+	{
+	public:
+		ColumnarFileWriter();
+		virtual ~ColumnarFileWriter();
+
+		/// @brief Columns must be added before the file is created. Returns the column's index.
+		size_t AddColumn(const std::string& name, ColumnType type);
+
+		bool CreateFile(const std::string& fileName);
+
+		void SetString(size_t column, const std::string& value);
+		void SetInt(size_t column, int64_t value);
+		void SetDouble(size_t column, double value);
+
+		/// @brief Finishes the current row. Columns that weren't set get an empty string or zero.
+		bool EndRow(void);
+
+		/// @brief Writes any buffered rows and the footer, then closes the file.
+		bool Close(void);
+
+		uint64_t NumRows(void) const { return m_numRows; };
+
+	private:
+		typedef struct Column
+		{
+			std::string                               name;
+			ColumnType                                type;
+			std::vector<int64_t>                      ints;       // Values of int64 columns, dictionary indexes of string columns
+			std::vector<double>                       doubles;
+			std::vector<std::string>                  dictionary;
+			std::unordered_map<std::string, uint32_t> dictionaryIndex;
+		} Column;
+
+		typedef struct ChunkInfo
+		{
+			uint32_t length;
+			uint8_t  minValue[8];
+			uint8_t  maxValue[8];
+		} ChunkInfo;
+
+		typedef struct RowGroupInfo
+		{
+			uint64_t               offset;
+			uint32_t               numRows;
+			std::vector<ChunkInfo> chunks;
+		} RowGroupInfo;
+
+		std::vector<Column>       m_columns;
+		std::vector<RowGroupInfo> m_rowGroups;
+		std::vector<uint8_t>      m_buffer;     // Reused for encoding each chunk
+		size_t                    m_groupRows;  // Rows buffered in the current row group
+		uint64_t                  m_numRows;
+		uint64_t                  m_offset;     // Bytes written so far
+
+		bool WriteBytes(const std::vector<uint8_t>& data);
+		bool WriteRowGroup(void);
+		void EncodeColumn(const Column& column, ChunkInfo& info);
+		bool WriteFooter(void);
+	};
+}
+
+#endif
@@ -0,0 +1,502 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "CompressedStream.h"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <limits.h>
+#include <new>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#define GZIP_MAGIC_SIZE 2
+#define ZSTD_MAGIC_SIZE 4
+#define GZIP_WINDOW_BITS 15
+#define GZIP_HEADER_WINDOW_BITS (GZIP_WINDOW_BITS + 16)      // Write a gzip header and trailer instead of a zlib one
+#define GZIP_AUTO_HEADER_WINDOW_BITS (GZIP_WINDOW_BITS + 32) // Accept either a gzip or a zlib header
+#define ZSTD_LEVEL 3
+#define MAX_ZLIB_INPUT (1 << 30) // zlib lengths are 32 bits
+
+namespace FileLib
+{
+	static const uint8_t GZIP_MAGIC[GZIP_MAGIC_SIZE] = { 0x1f, 0x8b };
+	static const uint8_t ZSTD_MAGIC[ZSTD_MAGIC_SIZE] = { 0x28, 0xb5, 0x2f, 0xfd };
+
+	CompressionType DetectCompression(const uint8_t* data, size_t dataLen)
+	{
+		if (dataLen >= GZIP_MAGIC_SIZE && memcmp(data, GZIP_MAGIC, GZIP_MAGIC_SIZE) == 0)
+		{
+			return COMPRESSION_GZIP;
+		}
+		if (dataLen >= ZSTD_MAGIC_SIZE && memcmp(data, ZSTD_MAGIC, ZSTD_MAGIC_SIZE) == 0)
+		{
+			return COMPRESSION_ZSTD;
+		}
+		return COMPRESSION_NONE;
+	}
+
+	static bool EndsWithIgnoringCase(const std::string& str, const char* suffix)
+	{
+		size_t suffixLen = strlen(suffix);
+		return str.size() >= suffixLen && strncasecmp(str.c_str() + str.size() - suffixLen, suffix, suffixLen) == 0;
+	}
+
+	CompressionType CompressionTypeForFileName(const std::string& fileName)
+	{
+		if (EndsWithIgnoringCase(fileName, CompressionFileExtension(COMPRESSION_GZIP)))
+		{
+			return COMPRESSION_GZIP;
+		}
+		if (EndsWithIgnoringCase(fileName, CompressionFileExtension(COMPRESSION_ZSTD)))
+		{
+			return COMPRESSION_ZSTD;
+		}
+		return COMPRESSION_NONE;
+	}
+
+	const char* CompressionFileExtension(CompressionType compression)
+	{
+		switch (compression)
+		{
+			case COMPRESSION_NONE:
+				return "";
+			case COMPRESSION_GZIP:
+				return ".gz";
+			case COMPRESSION_ZSTD:
+				return ".zst";
+		}
+		return "";
+	}
+
+	std::string FileExtensionIgnoringCompression(const std::string& fileName)
+	{
+		std::string name = fileName.substr(0, fileName.size() - strlen(CompressionFileExtension(CompressionTypeForFileName(fileName))));
+		size_t dotPos = name.find_last_of(".");
+		size_t slashPos = name.find_last_of("/");
+
+		if (dotPos == std::string::npos || (slashPos != std::string::npos && dotPos < slashPos))
+		{
+			return "";
+		}
+
+		std::string extension = name.substr(dotPos + 1);
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+		return extension;
+	}
+
+	InputFile::InputFile()
+	{
+		m_data = NULL;
+		m_size = 0;
+		m_readOffset = 0;
+		m_mapping = NULL;
+		m_mappingSize = 0;
+		m_compression = COMPRESSION_NONE;
+		m_zstdContext = NULL;
+		m_finished = false;
+		memset(&m_zstream, 0, sizeof(m_zstream));
+	}
+
+	InputFile::~InputFile()
+	{
+		Close();
+	}
+
+	bool InputFile::Open(const std::string& fileName)
+	{
+		Close();
+
+		int fd = open(fileName.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			return false;
+		}
+
+		bool result = false;
+		struct stat st;
+
+		if (fstat(fd, &st) == 0)
+		{
+			if (st.st_size == 0)
+			{
+				result = true;
+			}
+			else
+			{
+				void* mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+				if (mapping != MAP_FAILED)
+				{
+					m_mapping = mapping;
+					m_mappingSize = (size_t)st.st_size;
+
+					// Everything that reads these files only ever walks forward through them.
+					madvise(m_mapping, m_mappingSize, MADV_SEQUENTIAL);
+
+					m_data = (const uint8_t*)m_mapping;
+					m_size = m_mappingSize;
+					m_compression = DetectCompression(m_data, m_size);
+					result = StartDecompressing();
+				}
+			}
+		}
+
+		close(fd);
+
+		if (!result)
+		{
+			Close();
+		}
+		return result;
+	}
+
+	void InputFile::Close()
+	{
+		StopDecompressing();
+
+		if (m_mapping)
+		{
+			munmap(m_mapping, m_mappingSize);
+			m_mapping = NULL;
+			m_mappingSize = 0;
+		}
+		m_data = NULL;
+		m_size = 0;
+		m_readOffset = 0;
+		m_compression = COMPRESSION_NONE;
+		m_finished = false;
+	}
+
+	bool InputFile::StartDecompressing(void)
+	{
+		switch (m_compression)
+		{
+			case COMPRESSION_NONE:
+				return true;
+			case COMPRESSION_GZIP:
+				memset(&m_zstream, 0, sizeof(m_zstream));
+				return inflateInit2(&m_zstream, GZIP_AUTO_HEADER_WINDOW_BITS) == Z_OK;
+			case COMPRESSION_ZSTD:
+#ifdef HAVE_ZSTD
+				m_zstdContext = ZSTD_createDCtx();
+				return m_zstdContext != NULL;
+#else
+				return false;
+#endif
+		}
+		return false;
+	}
+
+	void InputFile::StopDecompressing(void)
+	{
+		switch (m_compression)
+		{
+			case COMPRESSION_NONE:
+				break;
+			case COMPRESSION_GZIP:
+				inflateEnd(&m_zstream);
+				break;
+			case COMPRESSION_ZSTD:
+#ifdef HAVE_ZSTD
+				ZSTD_freeDCtx((ZSTD_DCtx*)m_zstdContext);
+#endif
+				m_zstdContext = NULL;
+				break;
+		}
+	}
+
+	bool InputFile::Read(uint8_t* buf, size_t bufLen, size_t& bytesRead)
+	{
+		bytesRead = 0;
+
+		switch (m_compression)
+		{
+			case COMPRESSION_NONE:
+				bytesRead = std::min(bufLen, m_size - m_readOffset);
+				memcpy(buf, m_data + m_readOffset, bytesRead);
+				m_readOffset += bytesRead;
+				return true;
+			case COMPRESSION_GZIP:
+				return ReadGzip(buf, bufLen, bytesRead);
+			case COMPRESSION_ZSTD:
+				return ReadZstd(buf, bufLen, bytesRead);
+		}
+		return false;
+	}
+
+	bool InputFile::ReadAll(std::vector<uint8_t>& contents)
+	{
+		// Grows with the data that actually comes out, never with a size claimed by the file itself.
+		size_t used = contents.size();
+		size_t bytesRead = 0;
+
+		try
+		{
+			do
+			{
+				contents.resize(used + COMPRESSION_CHUNK_SIZE);
+				if (!Read(contents.data() + used, COMPRESSION_CHUNK_SIZE, bytesRead))
+				{
+					contents.resize(used);
+					return false;
+				}
+				used += bytesRead;
+			} while (bytesRead > 0);
+		}
+		catch (const std::bad_alloc&)
+		{
+			contents.clear();
+			contents.shrink_to_fit();
+			return false;
+		}
+
+		contents.resize(used);
+		return true;
+	}
+
+	bool InputFile::ReadGzip(uint8_t* buf, size_t bufLen, size_t& bytesRead)
+	{
+		while (bytesRead < bufLen && !m_finished)
+		{
+			if (m_zstream.avail_in == 0 && m_readOffset < m_size)
+			{
+				size_t inLen = std::min(m_size - m_readOffset, (size_t)MAX_ZLIB_INPUT);
+
+				m_zstream.next_in = (Bytef*)(m_data + m_readOffset);
+				m_zstream.avail_in = (uInt)inLen;
+				m_readOffset += inLen;
+			}
+
+			size_t outLen = std::min(bufLen - bytesRead, (size_t)MAX_ZLIB_INPUT);
+
+			m_zstream.next_out = buf + bytesRead;
+			m_zstream.avail_out = (uInt)outLen;
+
+			int status = inflate(&m_zstream, Z_NO_FLUSH);
+			bytesRead += outLen - m_zstream.avail_out;
+
+			if (status == Z_STREAM_END)
+			{
+				// Files made by concatenating gzip files are valid gzip files. Anything else after the end is ignored.
+				const uint8_t* next = (m_zstream.avail_in > 0) ? m_zstream.next_in : m_data + m_readOffset;
+				size_t remaining = m_zstream.avail_in + (m_size - m_readOffset);
+
+				if (DetectCompression(next, remaining) != COMPRESSION_GZIP || inflateReset(&m_zstream) != Z_OK)
+				{
+					m_finished = true;
+				}
+				continue;
+			}
+			if (status != Z_OK && status != Z_BUF_ERROR)
+			{
+				return false; // Corrupt
+			}
+			if (m_zstream.avail_in == 0 && m_readOffset == m_size && m_zstream.avail_out > 0)
+			{
+				return false; // Truncated
+			}
+		}
+		return true;
+	}
+
+	bool InputFile::ReadZstd(uint8_t* buf, size_t bufLen, size_t& bytesRead)
+	{
+#ifdef HAVE_ZSTD
+		ZSTD_inBuffer in = { m_data, m_size, m_readOffset };
+		ZSTD_outBuffer out = { buf, bufLen, 0 };
+		bool result = true;
+
+		while (out.pos < out.size && !m_finished)
+		{
+			size_t prevInPos = in.pos;
+			size_t prevOutPos = out.pos;
+			size_t status = ZSTD_decompressStream((ZSTD_DCtx*)m_zstdContext, &out, &in);
+
+			if (ZSTD_isError(status))
+			{
+				result = false; // Corrupt
+				break;
+			}
+
+			// A zero status means the frame is complete. There may be more frames after it.
+			if (status == 0 && in.pos == in.size)
+			{
+				m_finished = true;
+			}
+			else if (in.pos == in.size && in.pos == prevInPos && out.pos == prevOutPos)
+			{
+				result = false; // Truncated
+				break;
+			}
+		}
+
+		m_readOffset = in.pos;
+		bytesRead = out.pos;
+		return result;
+#else
+		(void)buf;
+		(void)bufLen;
+		(void)bytesRead;
+		return false;
+#endif
+	}
+
+	OutputCompressor::OutputCompressor()
+	{
+		m_compression = COMPRESSION_NONE;
+		m_zstdContext = NULL;
+		memset(&m_zstream, 0, sizeof(m_zstream));
+	}
+
+	OutputCompressor::~OutputCompressor()
+	{
+		End();
+	}
+
+	bool OutputCompressor::Start(CompressionType compression)
+	{
+		End();
+
+		switch (compression)
+		{
+			case COMPRESSION_NONE:
+				return false;
+			case COMPRESSION_GZIP:
+				memset(&m_zstream, 0, sizeof(m_zstream));
+				if (deflateInit2(&m_zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, GZIP_HEADER_WINDOW_BITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+				{
+					return false;
+				}
+				break;
+			case COMPRESSION_ZSTD:
+#ifdef HAVE_ZSTD
+				m_zstdContext = ZSTD_createCCtx();
+				if (!m_zstdContext)
+				{
+					return false;
+				}
+				ZSTD_CCtx_setParameter((ZSTD_CCtx*)m_zstdContext, ZSTD_c_compressionLevel, ZSTD_LEVEL);
+				break;
+#else
+				return false;
+#endif
+		}
+
+		m_compression = compression;
+		m_chunk.resize(COMPRESSION_CHUNK_SIZE);
+		return true;
+	}
+
+	bool OutputCompressor::Write(std::ostream& out, const uint8_t* data, size_t dataLen)
+	{
+		return Compress(out, data, dataLen, false);
+	}
+
+	bool OutputCompressor::Finish(std::ostream& out)
+	{
+		bool result = Compress(out, NULL, 0, true);
+		End();
+		return result;
+	}
+
+	bool OutputCompressor::Compress(std::ostream& out, const uint8_t* data, size_t dataLen, bool finish)
+	{
+		switch (m_compression)
+		{
+			case COMPRESSION_NONE:
+				return false;
+			case COMPRESSION_GZIP:
+				do
+				{
+					size_t inLen = std::min(dataLen, (size_t)MAX_ZLIB_INPUT);
+
+					m_zstream.next_in = (Bytef*)data;
+					m_zstream.avail_in = (uInt)inLen;
+					data += inLen;
+					dataLen -= inLen;
+
+					// Only finish once the last of the input has been handed to zlib.
+					int flush = (finish && dataLen == 0) ? Z_FINISH : Z_NO_FLUSH;
+					int status = Z_OK;
+
+					do
+					{
+						m_zstream.next_out = m_chunk.data();
+						m_zstream.avail_out = (uInt)m_chunk.size();
+
+						status = deflate(&m_zstream, flush);
+						if (status == Z_STREAM_ERROR)
+						{
+							return false;
+						}
+
+						size_t compressedLen = m_chunk.size() - m_zstream.avail_out;
+						if (compressedLen > 0)
+						{
+							out.write((const char*)m_chunk.data(), compressedLen);
+						}
+					} while ((flush == Z_FINISH) ? (status != Z_STREAM_END) : (m_zstream.avail_out == 0));
+				} while (dataLen > 0);
+				return out.good();
+			case COMPRESSION_ZSTD:
+#ifdef HAVE_ZSTD
+				{
+					ZSTD_inBuffer in = { data, dataLen, 0 };
+					ZSTD_EndDirective mode = finish ? ZSTD_e_end : ZSTD_e_continue;
+					size_t remaining = 0;
+
+					do
+					{
+						ZSTD_outBuffer outBuf = { m_chunk.data(), m_chunk.size(), 0 };
+
+						remaining = ZSTD_compressStream2((ZSTD_CCtx*)m_zstdContext, &outBuf, &in, mode);
+						if (ZSTD_isError(remaining))
+						{
+							return false;
+						}
+						if (outBuf.pos > 0)
+						{
+							out.write((const char*)m_chunk.data(), outBuf.pos);
+						}
+					} while (finish ? (remaining != 0) : (in.pos < in.size));
+				}
+				return out.good();
+#else
+				return false;
+#endif
+		}
+		return false;
+	}
+
+	void OutputCompressor::End()
+	{
+		switch (m_compression)
+		{
+			case COMPRESSION_NONE:
+				break;
+			case COMPRESSION_GZIP:
+				deflateEnd(&m_zstream);
+				break;
+			case COMPRESSION_ZSTD:
+#ifdef HAVE_ZSTD
+				ZSTD_freeCCtx((ZSTD_CCtx*)m_zstdContext);
+#endif
+				m_zstdContext = NULL;
+				break;
+		}
+		m_compression = COMPRESSION_NONE;
+		m_chunk.clear();
+		m_chunk.shrink_to_fit();
+	}
+}
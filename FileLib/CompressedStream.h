@@ -0,0 +1,118 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __COMPRESSEDSTREAM__
+#define __COMPRESSEDSTREAM__
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+#define COMPRESSION_CHUNK_SIZE 65536 // Size of the buffer that compressed data is collected in before being written
+
+namespace FileLib
+{
+	typedef enum CompressionType
+	{
+		COMPRESSION_NONE = 0,
+		COMPRESSION_GZIP,
+		COMPRESSION_ZSTD // Only available when built with HAVE_ZSTD
+	} CompressionType;
+
+	/// @brief Identifies compressed data from its magic number.
+	CompressionType DetectCompression(const uint8_t* data, size_t dataLen);
+
+	/// @brief Compression implied by the file name, i.e. ".gz" or ".zst".
+	CompressionType CompressionTypeForFileName(const std::string& fileName);
+
+	/// @brief Returns the extension that compressed files of the given type are expected to have, including the dot.
+	const char* CompressionFileExtension(CompressionType compression);
+
+	/// @brief Returns the lower case file extension, without the dot, ignoring any compression extension.
+	/// For example, "Run.TCX.gz" returns "tcx".
+	std::string FileExtensionIgnoringCompression(const std::string& fileName);
+
+	/**
+	* Read only access to a file, compressed or not.
+	*
+	* Uncompressed files are memory mapped and can be used in place through Data() and Size(). Files that start with
+	* a gzip or zstd magic number, regardless of their name, are decompressed as they are read, so memory use doesn't
+	* depend on how large the file is once it has been expanded. Read works for both kinds of file.
+	*/
+	class InputFile
+	{
+	public:
+		InputFile();
+		virtual ~InputFile();
+
+		bool Open(const std::string& fileName);
+		void Close();
+
+		/// @brief Copies up to bufLen bytes of the (decompressed) contents into the buffer. At the end of the file
+		/// bytesRead is zero. Returns FALSE if the compressed data is corrupt or truncated.
+		bool Read(uint8_t* buf, size_t bufLen, size_t& bytesRead);
+
+		/// @brief Reads whatever is left into memory, for parsers that need the whole file at once.
+		bool ReadAll(std::vector<uint8_t>& contents);
+
+		/// @brief The whole file, only available when it isn't compressed (otherwise NULL).
+		const uint8_t* Data() const { return m_compression == COMPRESSION_NONE ? m_data : NULL; };
+		size_t Size() const { return m_compression == COMPRESSION_NONE ? m_size : 0; };
+		CompressionType Compression() const { return m_compression; };
+
+	private:
+		const uint8_t*       m_data;         // Mapped file contents, compressed or not
+		size_t               m_size;
+		size_t               m_readOffset;   // Position of the next Read in m_data
+		void*                m_mapping;      // Memory mapped file, NULL if nothing is mapped
+		size_t               m_mappingSize;
+		CompressionType      m_compression;
+		z_stream             m_zstream;
+		void*                m_zstdContext;
+		bool                 m_finished;     // Reached the end of the compressed data
+
+		bool StartDecompressing(void);
+		void StopDecompressing(void);
+		bool ReadGzip(uint8_t* buf, size_t bufLen, size_t& bytesRead);
+		bool ReadZstd(uint8_t* buf, size_t bufLen, size_t& bytesRead);
+	};
+
+	/**
+	* Compresses data as it is written and passes the compressed data on to an output stream.
+	*/
+	class OutputCompressor
+	{
+	public:
+		OutputCompressor();
+		virtual ~OutputCompressor();
+
+		bool Start(CompressionType compression);
+
+		/// @brief Compresses the data, writing to the stream whenever a chunk of compressed data is ready.
+		bool Write(std::ostream& out, const uint8_t* data, size_t dataLen);
+
+		/// @brief Flushes everything that is left and writes the end of the compressed stream.
+		bool Finish(std::ostream& out);
+
+	private:
+		CompressionType      m_compression;
+		z_stream             m_zstream;
+		void*                m_zstdContext;
+		std::vector<uint8_t> m_chunk;
+
+		bool Compress(std::ostream& out, const uint8_t* data, size_t dataLen, bool finish);
+		void End();
+	};
+}
+
+#endif
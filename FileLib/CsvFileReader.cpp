@@ -0,0 +1,243 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "CsvFileReader.h"
+#include "CompressedStream.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#define CSV_BLOCK_SIZE 16 // Bytes examined at once when looking for delimiters
+
+namespace FileLib
+{
+	static inline bool IsDelimiter(char c)
+	{
+		return c == ',' || c == '\n' || c == '\r';
+	}
+
+	// Finds field and row delimiters a block at a time. The positions of all of the delimiters in the current block
+	// are kept as a bit mask, so consecutive short fields (the common case, since almost every field is a number)
+	// don't have to rescan the same bytes.
+	class DelimiterScanner
+	{
+	public:
+		DelimiterScanner(const char* data, size_t dataLen) :
+			m_end(data + dataLen),
+			m_block(NULL),
+			m_blockEnd(NULL),
+			m_mask(0)
+		{
+		};
+
+		/// @brief Returns the first delimiter at or after the given position, or the end of the data if there isn't one.
+		/// Positions must never go backwards.
+		inline const char* Find(const char* pos)
+		{
+			while (pos < m_end)
+			{
+				if (pos >= m_blockEnd)
+				{
+					LoadBlock(pos);
+				}
+
+				uint32_t mask = m_mask & (0xffffffff << (pos - m_block));
+				if (mask)
+				{
+					return m_block + __builtin_ctz(mask);
+				}
+				pos = m_blockEnd;
+			}
+			return m_end;
+		};
+
+	private:
+		const char* m_end;
+		const char* m_block;    // Start of the block described by m_mask
+		const char* m_blockEnd;
+		uint32_t    m_mask;     // Bit N is set if m_block[N] is a delimiter
+
+		inline void LoadBlock(const char* pos)
+		{
+			m_block = pos;
+			m_mask = 0;
+
+			if (m_end - pos >= CSV_BLOCK_SIZE)
+			{
+				m_blockEnd = pos + CSV_BLOCK_SIZE;
+
+#if defined(__SSE2__)
+				__m128i chunk = _mm_loadu_si128((const __m128i*)pos);
+				__m128i matches = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(',')),
+				                                            _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))),
+				                               _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')));
+				m_mask = (uint32_t)_mm_movemask_epi8(matches);
+				return;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+				static const uint8_t bitValues[CSV_BLOCK_SIZE] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+
+				// NEON doesn't have a movemask, so give each matching lane its bit value and add up each half.
+				uint8x16_t chunk = vld1q_u8((const uint8_t*)pos);
+				uint8x16_t matches = vorrq_u8(vorrq_u8(vceqq_u8(chunk, vdupq_n_u8(',')),
+				                                       vceqq_u8(chunk, vdupq_n_u8('\n'))),
+				                              vceqq_u8(chunk, vdupq_n_u8('\r')));
+				uint8x16_t bits = vandq_u8(matches, vld1q_u8(bitValues));
+				m_mask = (uint32_t)vaddv_u8(vget_low_u8(bits)) | ((uint32_t)vaddv_u8(vget_high_u8(bits)) << 8);
+				return;
+#endif
+			}
+			else
+			{
+				m_blockEnd = m_end;
+			}
+
+			// End of the data, or no vector instructions.
+			for (const char* c = m_block; c < m_blockEnd; ++c)
+			{
+				if (IsDelimiter(*c))
+				{
+					m_mask |= (1 << (c - m_block));
+				}
+			}
+		};
+	};
+
+	CsvFileReader::CsvFileReader()
+	{
+		m_newRowCallback = NULL;
+		m_newRowContext = NULL;
+	}
+
+	CsvFileReader::~CsvFileReader()
+	{
+	}
+
+	bool CsvFileReader::ParseFile(const std::string& fileName)
+	{
+		// Uncompressed files are memory mapped, compressed files are expanded in memory since rows are views into the buffer.
+		InputFile input;
+
+		if (!input.Open(fileName))
+		{
+			return false;
+		}
+		if (input.Compression() == COMPRESSION_NONE)
+		{
+			return ParseBuffer((const char*)input.Data(), input.Size());
+		}
+
+		std::vector<uint8_t> contents;
+		return input.ReadAll(contents) && ParseBuffer((const char*)contents.data(), contents.size());
+	}
+
+	bool CsvFileReader::ParseBuffer(const char* data, size_t dataLen)
+	{
+		DelimiterScanner scanner(data, dataLen);
+		const char* pos = data;
+		const char* end = data + dataLen;
+
+		// Skip the UTF-8 byte order mark that some spreadsheet programs write.
+		if (dataLen >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+		{
+			pos += 3;
+		}
+
+		m_fields.clear();
+		m_unescaped.clear();
+
+		while (pos < end)
+		{
+			const char* fieldEnd = NULL;
+
+			if (*pos == '"')
+			{
+				// Quoted field, which may contain delimiters. Doubled quotes stand for a single quote.
+				const char* closingQuote = pos + 1;
+				bool escaped = false;
+
+				while ((closingQuote = (const char*)memchr(closingQuote, '"', end - closingQuote)) != NULL)
+				{
+					if (closingQuote + 1 < end && closingQuote[1] == '"')
+					{
+						closingQuote += 2;
+						escaped = true;
+					}
+					else
+						break;
+				}
+				if (closingQuote == NULL)
+				{
+					closingQuote = end;
+				}
+
+				if (escaped)
+				{
+					std::string value;
+
+					value.reserve(closingQuote - (pos + 1));
+					for (const char* c = pos + 1; c < closingQuote; ++c)
+					{
+						value.push_back(*c);
+						if (*c == '"')
+						{
+							++c;
+						}
+					}
+					m_unescaped.push_back(std::move(value));
+					m_fields.push_back(std::string_view(m_unescaped.back()));
+				}
+				else
+				{
+					m_fields.push_back(std::string_view(pos + 1, closingQuote - (pos + 1)));
+				}
+
+				// Anything between the closing quote and the delimiter is ignored.
+				fieldEnd = scanner.Find(closingQuote < end ? closingQuote + 1 : end);
+			}
+			else
+			{
+				fieldEnd = scanner.Find(pos);
+				m_fields.push_back(std::string_view(pos, fieldEnd - pos));
+			}
+
+			if (fieldEnd < end && *fieldEnd == ',')
+			{
+				pos = fieldEnd + 1;
+
+				// A trailing comma at the very end of the data still ends with an empty field.
+				if (pos < end)
+				{
+					continue;
+				}
+				m_fields.push_back(std::string_view());
+				fieldEnd = end;
+			}
+
+			// End of the row.
+			if (m_newRowCallback && !m_newRowCallback(m_fields, m_newRowContext))
+			{
+				return false;
+			}
+			m_fields.clear();
+			m_unescaped.clear();
+
+			// Handles \n, \r\n, and \r line endings, as well as blank lines.
+			pos = fieldEnd;
+			while (pos < end && (*pos == '\n' || *pos == '\r'))
+			{
+				++pos;
+			}
+		}
+		return true;
+	}
+}
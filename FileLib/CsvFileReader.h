@@ -0,0 +1,54 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __CSVFILEREADER__
+#define __CSVFILEREADER__
+
+#pragma once
+
+#include <deque>
+#include <stddef.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace FileLib
+{
+	/**
+	* Reads comma separated value files.
+	*
+	* The file is memory mapped and split into rows and fields in place, so no strings are allocated while parsing.
+	* Delimiters are located sixteen bytes at a time with SSE2 or NEON when available. Fields may be enclosed in
+	* double quotes, in which case the quotes are removed and doubled quotes inside them become a single quote, the
+	* only case that needs a copy of the field. Empty lines are skipped.
+	*/
+	class CsvFileReader
+	{
+	public:
+		CsvFileReader();
+		virtual ~CsvFileReader();
+
+		/// @brief Memory maps the file and reads it in a single pass. Compressed files are expanded in memory first.
+		bool ParseFile(const std::string& fileName);
+
+		/// @brief Reads CSV data that is already in memory.
+		bool ParseBuffer(const char* data, size_t dataLen);
+
+		// Registers the callback that is triggered for each row. The fields point into the file, or into a copy for
+		// fields with escaped quotes, and are only valid for the duration of the callback. Returning false stops the parse.
+		typedef bool (*NewRowFunc)(const std::vector<std::string_view>& fields, void* context);
+		virtual void SetNewRowCallback(NewRowFunc func, void* context) { m_newRowCallback = func; m_newRowContext = context; };
+
+	private:
+		std::vector<std::string_view> m_fields;    // Reused for every row
+		std::deque<std::string>       m_unescaped; // Copies of the row's fields that had doubled quotes in them
+		NewRowFunc                    m_newRowCallback;
+		void*                         m_newRowContext;
+	};
+}
+
+#endif
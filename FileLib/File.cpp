@@ -35,7 +35,19 @@ namespace FileLib
 	{
 		if (!m_file.is_open())
 		{
-			m_file.open(fileName.c_str(), std::ios::out);
+			CompressionType compression = CompressionTypeForFileName(fileName);
+
+			if (compression != COMPRESSION_NONE)
+			{
+				m_compressor.reset(new OutputCompressor());
+				if (!m_compressor->Start(compression))
+				{
+					m_compressor.reset();
+					return false;
+				}
+			}
+
+			m_file.open(fileName.c_str(), std::ios::out | std::ios::binary);
 			m_fileName = fileName;
 			return m_file.is_open();
 		}
@@ -46,9 +58,17 @@ namespace FileLib
 	{
 		if (m_file.is_open())
 		{
+			bool result = true;
+
+			if (m_compressor)
+			{
+				result = m_compressor->Finish(m_file);
+				m_compressor.reset();
+			}
 			m_file.close();
-			return true;
+			return result;
 		}
+		m_compressor.reset();
 		return false;
 	}
 
@@ -65,21 +85,25 @@ namespace FileLib
 
 	bool File::WriteString(const std::string& str)
 	{
-		if (m_file.is_open())
-		{
-			m_file << str;
-			return true;
-		}
-		return false;
+		return Write(str.c_str(), str.size());
 	}
 
 	bool File::WriteBinaryData(const uint8_t* data, size_t len)
 	{
-		if (m_file.is_open())
+		return Write((const char*)data, len);
+	}
+
+	bool File::Write(const char* data, size_t len)
+	{
+		if (!m_file.is_open())
 		{
-			m_file.write((const char*)data, len);
-			return true;
+			return false;
 		}
-		return false;
+		if (m_compressor)
+		{
+			return m_compressor->Write(m_file, (const uint8_t*)data, len);
+		}
+		m_file.write(data, len);
+		return true;
 	}
 }
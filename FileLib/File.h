@@ -12,6 +12,9 @@
 
 #include <iostream>
 #include <fstream>
+#include <memory>
+
+#include "CompressedStream.h"
 
 namespace FileLib
 {
@@ -22,6 +25,8 @@ namespace FileLib
 		virtual ~File();
 		
 		bool OpenFile(const std::string& fileName);
+
+		/// @brief Files whose names end in ".gz" (or ".zst") are compressed as they are written.
 		bool CreateFile(const std::string& fileName);
 		bool CloseFile();
 		bool IsOpen() const;
@@ -31,8 +36,11 @@ namespace FileLib
 		virtual bool WriteBinaryData(const uint8_t* data, size_t len);
 
 	protected:
-		std::string  m_fileName;
-		std::fstream m_file;
+		std::string                       m_fileName;
+		std::fstream                      m_file;
+		std::unique_ptr<OutputCompressor> m_compressor; // NULL unless the file is being compressed
+
+		bool Write(const char* data, size_t len);
 	};
 }
 
@@ -0,0 +1,716 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "FitFileReader.h"
+#include "FitTags.h"
+#include "ActivityType.h"
+#include "CompressedStream.h"
+
+#include <string.h>
+
+#define FIT_MIN_HEADER_SIZE 12
+#define FIT_FULL_HEADER_SIZE 14 // Includes the header CRC
+#define FIT_CRC_SIZE 2
+
+// Record message field numbers.
+#define FIT_RECORD_FIELD_POSITION_LAT 0
+#define FIT_RECORD_FIELD_POSITION_LONG 1
+#define FIT_RECORD_FIELD_ALTITUDE 2
+#define FIT_RECORD_FIELD_HEART_RATE 3
+#define FIT_RECORD_FIELD_CADENCE 4
+#define FIT_RECORD_FIELD_DISTANCE 5
+#define FIT_RECORD_FIELD_SPEED 6
+#define FIT_RECORD_FIELD_POWER 7
+#define FIT_RECORD_FIELD_ENHANCED_SPEED 73
+#define FIT_RECORD_FIELD_ENHANCED_ALTITUDE 78
+
+// Lap and session message field numbers (the two messages agree on these).
+#define FIT_LAP_FIELD_START_TIME 2
+#define FIT_SESSION_FIELD_SPORT 5
+#define FIT_SESSION_FIELD_SUB_SPORT 6
+#define FIT_LAP_FIELD_TOTAL_ELAPSED_TIME 7
+#define FIT_LAP_FIELD_TOTAL_TIMER_TIME 8
+#define FIT_LAP_FIELD_TOTAL_DISTANCE 9
+#define FIT_LAP_FIELD_TOTAL_CALORIES 11
+#define FIT_LAP_FIELD_SPORT 25
+#define FIT_LAP_FIELD_SUB_SPORT 39
+
+// Event message field numbers.
+#define FIT_EVENT_FIELD_EVENT 0
+#define FIT_EVENT_FIELD_EVENT_TYPE 1
+#define FIT_EVENT_FIELD_DATA 3
+
+// HRV message field numbers.
+#define FIT_HRV_FIELD_TIME 0
+
+// Sport message field numbers.
+#define FIT_SPORT_FIELD_SPORT 0
+#define FIT_SPORT_FIELD_SUB_SPORT 1
+
+#define SEMICIRCLES_TO_DEGREES (180.0 / 2147483648.0)
+
+namespace FileLib
+{
+	FitFileReader::FitFileReader()
+	{
+		m_lastTimestamp = 0;
+		m_newRecordCallback = NULL;
+		m_newRecordContext = NULL;
+		m_newLapCallback = NULL;
+		m_newLapContext = NULL;
+		m_newSessionCallback = NULL;
+		m_newSessionContext = NULL;
+		m_newEventCallback = NULL;
+		m_newEventContext = NULL;
+		m_newHrvCallback = NULL;
+		m_newHrvContext = NULL;
+		m_activityTypeCallback = NULL;
+		m_activityTypeContext = NULL;
+	}
+
+	FitFileReader::~FitFileReader()
+	{
+	}
+
+	bool FitFileReader::ParseFile(const std::string& fileName)
+	{
+		// Uncompressed files are memory mapped. FIT files are small, so compressed ones are simply expanded in memory.
+		InputFile input;
+
+		if (!input.Open(fileName))
+		{
+			return false;
+		}
+		if (input.Compression() == COMPRESSION_NONE)
+		{
+			return ParseBuffer(input.Data(), input.Size());
+		}
+
+		std::vector<uint8_t> contents;
+		return input.ReadAll(contents) && ParseBuffer(contents.data(), contents.size());
+	}
+
+	bool FitFileReader::ParseBuffer(const uint8_t* data, size_t dataLen)
+	{
+		size_t offset = 0;
+		bool result = false;
+
+		// Devices are allowed to concatenate several FIT files together, each with its own header and CRC.
+		while (offset < dataLen)
+		{
+			size_t bytesUsed = 0;
+
+			if (!ParseFitFile(data + offset, dataLen - offset, bytesUsed))
+			{
+				return false;
+			}
+			offset += bytesUsed;
+			result = true;
+		}
+		return result;
+	}
+
+	bool FitFileReader::ParseFitFile(const uint8_t* data, size_t dataLen, size_t& bytesUsed)
+	{
+		if (dataLen < FIT_MIN_HEADER_SIZE)
+		{
+			return false;
+		}
+
+		//
+		// File header.
+		//
+
+		uint8_t headerSize = data[0];
+		if (headerSize < FIT_MIN_HEADER_SIZE || headerSize > dataLen)
+		{
+			return false;
+		}
+		if (memcmp(data + 8, ".FIT", 4) != 0)
+		{
+			return false;
+		}
+
+		uint32_t recordsSize = (uint32_t)data[4] | ((uint32_t)data[5] << 8) | ((uint32_t)data[6] << 16) | ((uint32_t)data[7] << 24);
+		size_t fileSize = (size_t)headerSize + recordsSize + FIT_CRC_SIZE;
+		if (fileSize > dataLen)
+		{
+			return false;
+		}
+
+		// The header CRC is optional, zero means it wasn't computed.
+		if (headerSize >= FIT_FULL_HEADER_SIZE)
+		{
+			uint16_t expectedCrc = (uint16_t)data[12] | ((uint16_t)data[13] << 8);
+
+			if (expectedCrc != 0)
+			{
+				if (FitCrc16(0, data, FIT_MIN_HEADER_SIZE) != expectedCrc)
+				{
+					return false;
+				}
+			}
+		}
+
+		// The file CRC covers the header and all the records. Check it before doing any work so that
+		// a truncated or corrupted file never makes it into the database.
+		uint16_t crc = FitCrc16(0, data, fileSize - FIT_CRC_SIZE);
+		uint16_t expectedCrc = (uint16_t)data[fileSize - 2] | ((uint16_t)data[fileSize - 1] << 8);
+		if (crc != expectedCrc)
+		{
+			return false;
+		}
+
+		//
+		// Records.
+		//
+
+		for (size_t i = 0; i < 16; ++i)
+		{
+			m_localDefs[i].valid = false;
+			m_localDefs[i].fields.clear();
+		}
+		m_lastTimestamp = 0;
+
+		const uint8_t* records = data + headerSize;
+		size_t offset = 0;
+
+		while (offset < recordsSize)
+		{
+			uint8_t headerByte = records[offset++];
+
+			if (headerByte & RECORD_HDR_NORMAL)
+			{
+				// Compressed timestamp header, always a data message. The low five bits hold
+				// the time offset from the last full timestamp, rolling over every 32 seconds.
+				uint8_t localMsgType = (headerByte & RECORD_HDR_LOCAL_MSG_TYPE_COMPRESSED) >> 5;
+				uint32_t timeOffset = headerByte & RECORD_HDR_TIME_OFFSET;
+				const FitMessageDef& def = m_localDefs[localMsgType];
+
+				if (!def.valid || offset + def.dataSize > recordsSize)
+				{
+					return false;
+				}
+
+				uint32_t timestamp = (m_lastTimestamp & ~(uint32_t)RECORD_HDR_TIME_OFFSET) + timeOffset;
+				if (timeOffset < (m_lastTimestamp & RECORD_HDR_TIME_OFFSET))
+					timestamp += (RECORD_HDR_TIME_OFFSET + 1);
+				m_lastTimestamp = timestamp;
+
+				ProcessDataMessage(def, records + offset);
+				offset += def.dataSize;
+			}
+			else if (headerByte & RECORD_HDR_MSG_TYPE)
+			{
+				size_t defLen = 0;
+
+				if (!ParseDefinitionMessage(headerByte, records + offset, recordsSize - offset, defLen))
+				{
+					return false;
+				}
+				offset += defLen;
+			}
+			else
+			{
+				const FitMessageDef& def = m_localDefs[headerByte & RECORD_HDR_LOCAL_MSG_TYPE];
+
+				if (!def.valid || offset + def.dataSize > recordsSize)
+				{
+					return false;
+				}
+
+				ProcessDataMessage(def, records + offset);
+				offset += def.dataSize;
+			}
+		}
+
+		bytesUsed = fileSize;
+		return true;
+	}
+
+	bool FitFileReader::ParseDefinitionMessage(uint8_t headerByte, const uint8_t* data, size_t dataLen, size_t& bytesUsed)
+	{
+		const size_t FIXED_LEN = 5; // reserved, architecture, global message number, number of fields
+		const size_t FIELD_LEN = 3;
+
+		if (dataLen < FIXED_LEN)
+		{
+			return false;
+		}
+
+		FitMessageDef& def = m_localDefs[headerByte & RECORD_HDR_LOCAL_MSG_TYPE];
+
+		def.valid = false;
+		def.bigEndian = (data[1] == 1);
+		def.globalMsgNum = def.bigEndian ? (((uint16_t)data[2] << 8) | data[3]) : (((uint16_t)data[3] << 8) | data[2]);
+		def.dataSize = 0;
+		def.fields.clear();
+
+		size_t numFields = data[4];
+		size_t offset = FIXED_LEN;
+
+		if (offset + numFields * FIELD_LEN > dataLen)
+		{
+			return false;
+		}
+
+		def.fields.reserve(numFields);
+		for (size_t i = 0; i < numFields; ++i, offset += FIELD_LEN)
+		{
+			FitFieldDef field;
+
+			field.fieldNum = data[offset];
+			field.size = data[offset + 1];
+			field.baseType = data[offset + 2];
+			def.fields.push_back(field);
+			def.dataSize += field.size;
+		}
+
+		// Developer fields are skipped, but their size still has to be accounted for.
+		if (headerByte & RECORD_HDR_MSG_TYPE_SPECIFIC)
+		{
+			if (offset >= dataLen)
+			{
+				return false;
+			}
+
+			size_t numDevFields = data[offset++];
+
+			if (offset + numDevFields * FIELD_LEN > dataLen)
+			{
+				return false;
+			}
+			for (size_t i = 0; i < numDevFields; ++i, offset += FIELD_LEN)
+			{
+				def.dataSize += data[offset + 1];
+			}
+		}
+
+		def.valid = true;
+		bytesUsed = offset;
+		return true;
+	}
+
+	void FitFileReader::ProcessDataMessage(const FitMessageDef& def, const uint8_t* data)
+	{
+		// Any message may carry a full timestamp, and it becomes the reference for later compressed headers.
+		const uint8_t* fieldData = data;
+		for (auto iter = def.fields.begin(); iter != def.fields.end(); ++iter)
+		{
+			const FitFieldDef& field = (*iter);
+			double value = (double)0.0;
+
+			if (field.fieldNum == FIT_FIELD_TIMESTAMP && ReadFieldValue(fieldData, field.size, field.baseType, def.bigEndian, value))
+			{
+				m_lastTimestamp = (uint32_t)value;
+				break;
+			}
+			fieldData += field.size;
+		}
+
+		switch (def.globalMsgNum)
+		{
+		case GLOBAL_MSG_NUM_RECORD:
+			ProcessRecord(def, data);
+			break;
+		case GLOBAL_MSG_NUM_LAP:
+		case GLOBAL_MSG_NUM_SESSION:
+			ProcessLapOrSession(def, data);
+			break;
+		case GLOBAL_MSG_NUM_EVENT:
+			ProcessEvent(def, data);
+			break;
+		case GLOBAL_MSG_NUM_HRV:
+			ProcessHrv(def, data);
+			break;
+		case GLOBAL_MSG_NUM_SPORT:
+			ProcessSport(def, data);
+			break;
+		default:
+			break;
+		}
+	}
+
+	void FitFileReader::ProcessRecord(const FitMessageDef& def, const uint8_t* data)
+	{
+		if (!m_newRecordCallback)
+		{
+			return;
+		}
+
+		FitRecordData record;
+		double lat = (double)0.0;
+		double lon = (double)0.0;
+		bool hasLat = false;
+		bool hasLon = false;
+
+		record.timestampMs = FitTimestampToUnixMs(m_lastTimestamp);
+		record.hasPosition = false;
+		record.hasAltitude = false;
+		record.latitude = FIT_VALUE_NOT_SET;
+		record.longitude = FIT_VALUE_NOT_SET;
+		record.altitude = FIT_VALUE_NOT_SET;
+		record.heartRate = FIT_VALUE_NOT_SET;
+		record.power = FIT_VALUE_NOT_SET;
+		record.cadence = FIT_VALUE_NOT_SET;
+		record.speed = FIT_VALUE_NOT_SET;
+		record.distance = FIT_VALUE_NOT_SET;
+
+		for (auto iter = def.fields.begin(); iter != def.fields.end(); ++iter)
+		{
+			const FitFieldDef& field = (*iter);
+			double value = (double)0.0;
+
+			if (ReadFieldValue(data, field.size, field.baseType, def.bigEndian, value))
+			{
+				switch (field.fieldNum)
+				{
+				case FIT_RECORD_FIELD_POSITION_LAT:
+					lat = value * SEMICIRCLES_TO_DEGREES;
+					hasLat = true;
+					break;
+				case FIT_RECORD_FIELD_POSITION_LONG:
+					lon = value * SEMICIRCLES_TO_DEGREES;
+					hasLon = true;
+					break;
+				case FIT_RECORD_FIELD_ALTITUDE:
+					if (!record.hasAltitude)
+						record.altitude = (value / 5.0) - 500.0;
+					record.hasAltitude = true;
+					break;
+				case FIT_RECORD_FIELD_ENHANCED_ALTITUDE:
+					record.altitude = (value / 5.0) - 500.0;
+					record.hasAltitude = true;
+					break;
+				case FIT_RECORD_FIELD_HEART_RATE:
+					record.heartRate = value;
+					break;
+				case FIT_RECORD_FIELD_CADENCE:
+					record.cadence = value;
+					break;
+				case FIT_RECORD_FIELD_DISTANCE:
+					record.distance = value / 100.0;
+					break;
+				case FIT_RECORD_FIELD_SPEED:
+					if (record.speed == FIT_VALUE_NOT_SET)
+						record.speed = value / 1000.0;
+					break;
+				case FIT_RECORD_FIELD_ENHANCED_SPEED:
+					record.speed = value / 1000.0;
+					break;
+				case FIT_RECORD_FIELD_POWER:
+					record.power = value;
+					break;
+				default:
+					break;
+				}
+			}
+			data += field.size;
+		}
+
+		if (hasLat && hasLon)
+		{
+			record.hasPosition = true;
+			record.latitude = lat;
+			record.longitude = lon;
+		}
+
+		m_newRecordCallback(record, m_newRecordContext);
+	}
+
+	void FitFileReader::ProcessLapOrSession(const FitMessageDef& def, const uint8_t* data)
+	{
+		bool isSession = (def.globalMsgNum == GLOBAL_MSG_NUM_SESSION);
+
+		if (!(isSession ? (m_newSessionCallback || m_activityTypeCallback) : (bool)m_newLapCallback))
+		{
+			return;
+		}
+
+		FitLapData lap;
+
+		lap.startTimeMs = 0;
+		lap.endTimeMs = FitTimestampToUnixMs(m_lastTimestamp);
+		lap.totalElapsedSecs = FIT_VALUE_NOT_SET;
+		lap.totalTimerSecs = FIT_VALUE_NOT_SET;
+		lap.totalDistance = FIT_VALUE_NOT_SET;
+		lap.totalCalories = FIT_VALUE_NOT_SET;
+		lap.sport = FIT_ENUM_INVALID;
+		lap.subSport = FIT_ENUM_INVALID;
+
+		uint8_t sportField = isSession ? FIT_SESSION_FIELD_SPORT : FIT_LAP_FIELD_SPORT;
+		uint8_t subSportField = isSession ? FIT_SESSION_FIELD_SUB_SPORT : FIT_LAP_FIELD_SUB_SPORT;
+
+		for (auto iter = def.fields.begin(); iter != def.fields.end(); ++iter)
+		{
+			const FitFieldDef& field = (*iter);
+			double value = (double)0.0;
+
+			if (ReadFieldValue(data, field.size, field.baseType, def.bigEndian, value))
+			{
+				if (field.fieldNum == FIT_LAP_FIELD_START_TIME)
+					lap.startTimeMs = FitTimestampToUnixMs((uint32_t)value);
+				else if (field.fieldNum == FIT_LAP_FIELD_TOTAL_ELAPSED_TIME)
+					lap.totalElapsedSecs = value / 1000.0;
+				else if (field.fieldNum == FIT_LAP_FIELD_TOTAL_TIMER_TIME)
+					lap.totalTimerSecs = value / 1000.0;
+				else if (field.fieldNum == FIT_LAP_FIELD_TOTAL_DISTANCE)
+					lap.totalDistance = value / 100.0;
+				else if (field.fieldNum == FIT_LAP_FIELD_TOTAL_CALORIES)
+					lap.totalCalories = value;
+				else if (field.fieldNum == sportField)
+					lap.sport = (uint8_t)value;
+				else if (field.fieldNum == subSportField)
+					lap.subSport = (uint8_t)value;
+			}
+			data += field.size;
+		}
+
+		if (isSession)
+		{
+			if (m_activityTypeCallback && lap.sport != FIT_ENUM_INVALID)
+			{
+				std::string activityType = SportEnumToSportType(lap.sport, lap.subSport);
+
+				if (activityType.size() > 0)
+				{
+					m_activityTypeCallback(activityType.c_str(), m_activityTypeContext);
+				}
+			}
+			if (m_newSessionCallback)
+			{
+				m_newSessionCallback(lap, m_newSessionContext);
+			}
+		}
+		else
+		{
+			m_newLapCallback(lap, m_newLapContext);
+		}
+	}
+
+	void FitFileReader::ProcessEvent(const FitMessageDef& def, const uint8_t* data)
+	{
+		if (!m_newEventCallback)
+		{
+			return;
+		}
+
+		uint8_t event = FIT_ENUM_INVALID;
+		uint8_t eventType = FIT_ENUM_INVALID;
+		uint32_t eventData = 0;
+
+		for (auto iter = def.fields.begin(); iter != def.fields.end(); ++iter)
+		{
+			const FitFieldDef& field = (*iter);
+			double value = (double)0.0;
+
+			if (ReadFieldValue(data, field.size, field.baseType, def.bigEndian, value))
+			{
+				if (field.fieldNum == FIT_EVENT_FIELD_EVENT)
+					event = (uint8_t)value;
+				else if (field.fieldNum == FIT_EVENT_FIELD_EVENT_TYPE)
+					eventType = (uint8_t)value;
+				else if (field.fieldNum == FIT_EVENT_FIELD_DATA)
+					eventData = (uint32_t)value;
+			}
+			data += field.size;
+		}
+
+		m_newEventCallback(FitTimestampToUnixMs(m_lastTimestamp), event, eventType, eventData, m_newEventContext);
+	}
+
+	void FitFileReader::ProcessHrv(const FitMessageDef& def, const uint8_t* data)
+	{
+		if (!m_newHrvCallback)
+		{
+			return;
+		}
+
+		for (auto iter = def.fields.begin(); iter != def.fields.end(); ++iter)
+		{
+			const FitFieldDef& field = (*iter);
+
+			// The time field is an array of uint16 beat to beat intervals, in 1/1000 seconds.
+			if (field.fieldNum == FIT_HRV_FIELD_TIME)
+			{
+				const size_t ELEMENT_SIZE = 2;
+
+				for (size_t i = 0; i + ELEMENT_SIZE <= field.size; i += ELEMENT_SIZE)
+				{
+					double value = (double)0.0;
+
+					if (ReadFieldValue(data + i, ELEMENT_SIZE, field.baseType, def.bigEndian, value))
+					{
+						m_newHrvCallback(FitTimestampToUnixMs(m_lastTimestamp), value / 1000.0, m_newHrvContext);
+					}
+				}
+			}
+			data += field.size;
+		}
+	}
+
+	void FitFileReader::ProcessSport(const FitMessageDef& def, const uint8_t* data)
+	{
+		if (!m_activityTypeCallback)
+		{
+			return;
+		}
+
+		uint8_t sport = FIT_ENUM_INVALID;
+		uint8_t subSport = FIT_ENUM_INVALID;
+
+		for (auto iter = def.fields.begin(); iter != def.fields.end(); ++iter)
+		{
+			const FitFieldDef& field = (*iter);
+			double value = (double)0.0;
+
+			if (ReadFieldValue(data, field.size, field.baseType, def.bigEndian, value))
+			{
+				if (field.fieldNum == FIT_SPORT_FIELD_SPORT)
+					sport = (uint8_t)value;
+				else if (field.fieldNum == FIT_SPORT_FIELD_SUB_SPORT)
+					subSport = (uint8_t)value;
+			}
+			data += field.size;
+		}
+
+		std::string activityType = SportEnumToSportType(sport, subSport);
+		if (activityType.size() > 0)
+		{
+			m_activityTypeCallback(activityType.c_str(), m_activityTypeContext);
+		}
+	}
+
+	/// Decodes the first element of a field. Returns FALSE if the field holds the invalid value for its base type.
+	bool FitFileReader::ReadFieldValue(const uint8_t* data, uint8_t size, uint8_t baseType, bool bigEndian, double& value)
+	{
+		uint8_t numBytes = 0;
+
+		switch (baseType)
+		{
+		case FIT_BASE_TYPE_ENUM:
+		case FIT_BASE_TYPE_SINT8:
+		case FIT_BASE_TYPE_UINT8:
+		case FIT_BASE_TYPE_UINT8Z:
+		case FIT_BASE_TYPE_BYTE:
+			numBytes = 1;
+			break;
+		case FIT_BASE_TYPE_SINT16:
+		case FIT_BASE_TYPE_UINT16:
+		case FIT_BASE_TYPE_UINT16Z:
+			numBytes = 2;
+			break;
+		case FIT_BASE_TYPE_SINT32:
+		case FIT_BASE_TYPE_UINT32:
+		case FIT_BASE_TYPE_UINT32Z:
+		case FIT_BASE_TYPE_FLOAT32:
+			numBytes = 4;
+			break;
+		case FIT_BASE_TYPE_FLOAT64:
+		case FIT_BASE_TYPE_SINT64:
+		case FIT_BASE_TYPE_UINT64:
+		case FIT_BASE_TYPE_UINT64Z:
+			numBytes = 8;
+			break;
+		default:
+			return false; // Strings and unknown types
+		}
+
+		if (size < numBytes)
+		{
+			return false;
+		}
+
+		uint64_t raw = 0;
+		for (uint8_t i = 0; i < numBytes; ++i)
+		{
+			uint8_t byte = bigEndian ? data[i] : data[numBytes - 1 - i];
+			raw = (raw << 8) | byte;
+		}
+
+		uint64_t allOnes = (numBytes == 8) ? ~(uint64_t)0 : (((uint64_t)1 << (numBytes * 8)) - 1);
+		uint64_t signedMax = allOnes >> 1;
+
+		switch (baseType)
+		{
+		case FIT_BASE_TYPE_SINT8:
+		case FIT_BASE_TYPE_SINT16:
+		case FIT_BASE_TYPE_SINT32:
+		case FIT_BASE_TYPE_SINT64:
+			if (raw == signedMax)
+				return false;
+			if (raw > signedMax) // Sign extend
+				raw |= ~allOnes;
+			value = (double)(int64_t)raw;
+			return true;
+		case FIT_BASE_TYPE_UINT8Z:
+		case FIT_BASE_TYPE_UINT16Z:
+		case FIT_BASE_TYPE_UINT32Z:
+		case FIT_BASE_TYPE_UINT64Z:
+			if (raw == 0)
+				return false;
+			value = (double)raw;
+			return true;
+		case FIT_BASE_TYPE_FLOAT32:
+			{
+				if (raw == allOnes)
+					return false;
+				uint32_t temp = (uint32_t)raw;
+				float f = 0.0;
+				memcpy(&f, &temp, sizeof(f));
+				value = f;
+			}
+			return true;
+		case FIT_BASE_TYPE_FLOAT64:
+			if (raw == allOnes)
+				return false;
+			memcpy(&value, &raw, sizeof(value));
+			return true;
+		default:
+			if (raw == allOnes)
+				return false;
+			value = (double)raw;
+			return true;
+		}
+	}
+
+	uint64_t FitFileReader::FitTimestampToUnixMs(uint32_t fitTimestamp)
+	{
+		return ((uint64_t)fitTimestamp + FIT_EPOCH_OFFSET) * 1000;
+	}
+
+	std::string FitFileReader::SportEnumToSportType(uint8_t sport, uint8_t subSport)
+	{
+		switch (sport)
+		{
+		case FIT_SPORT_RUNNING:
+			if (subSport == FIT_SUB_SPORT_TREADMILL)
+				return ACTIVITY_TYPE_TREADMILL;
+			return ACTIVITY_TYPE_RUNNING;
+		case FIT_SPORT_CYCLING:
+		case FIT_SPORT_E_BIKING:
+			if (subSport == FIT_SUB_SPORT_MOUNTAIN)
+				return ACTIVITY_TYPE_MOUNTAIN_BIKING;
+			if (subSport == FIT_SUB_SPORT_INDOOR_CYCLING || subSport == FIT_SUB_SPORT_SPIN)
+				return ACTIVITY_TYPE_STATIONARY_CYCLING;
+			if (subSport == FIT_SUB_SPORT_VIRTUAL_ACTIVITY)
+				return ACTIVITY_TYPE_VIRTUAL_CYCLING;
+			return ACTIVITY_TYPE_CYCLING;
+		case FIT_SPORT_SWIMMING:
+			if (subSport == FIT_SUB_SPORT_LAP_SWIMMING)
+				return ACTIVITY_TYPE_POOL_SWIMMING;
+			return ACTIVITY_TYPE_OPEN_WATER_SWIMMING;
+		case FIT_SPORT_WALKING:
+			return ACTIVITY_TYPE_WALKING;
+		case FIT_SPORT_HIKING:
+			return ACTIVITY_TYPE_HIKING;
+		default:
+			break;
+		}
+		return "";
+	}
+}
@@ -0,0 +1,137 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __FITFILEREADER__
+#define __FITFILEREADER__
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define FIT_VALUE_NOT_SET -1.0
+
+namespace FileLib
+{
+	// Record message, converted to the units used by the rest of the app.
+	// Fields that were not present in the message are set to FIT_VALUE_NOT_SET.
+	typedef struct FitRecordData
+	{
+		uint64_t timestampMs;
+		bool     hasPosition;
+		bool     hasAltitude; // FIT_VALUE_NOT_SET is a valid altitude, so this is the only way to tell
+		double   latitude;   // Degrees
+		double   longitude;  // Degrees
+		double   altitude;   // Meters
+		double   heartRate;  // Beats per minute
+		double   power;      // Watts
+		double   cadence;    // Revolutions (or strides) per minute
+		double   speed;      // Meters per second
+		double   distance;   // Meters
+	} FitRecordData;
+
+	// Lap and session messages share the same summary fields.
+	typedef struct FitLapData
+	{
+		uint64_t startTimeMs;
+		uint64_t endTimeMs;
+		double   totalElapsedSecs;
+		double   totalTimerSecs;
+		double   totalDistance; // Meters
+		double   totalCalories; // kcal
+		uint8_t  sport;
+		uint8_t  subSport;
+	} FitLapData;
+
+	class FitFileReader
+	{
+	public:
+		FitFileReader();
+		virtual ~FitFileReader();
+
+		/// @brief Memory maps the file and decodes it in a single pass. Compressed files are expanded in memory first.
+		bool ParseFile(const std::string& fileName);
+
+		/// @brief Decodes a FIT file that is already in memory. Chained FIT files are supported.
+		bool ParseBuffer(const uint8_t* data, size_t dataLen);
+
+		// Registers the callback that is triggered when a record (track point) message is read.
+		typedef bool (*NewRecordFunc)(const FitRecordData& record, void* context);
+		virtual void SetNewRecordCallback(NewRecordFunc func, void* context) { m_newRecordCallback = func; m_newRecordContext = context; };
+
+		// Registers the callback that is triggered when a lap message is read.
+		typedef bool (*NewLapFunc)(const FitLapData& lap, void* context);
+		virtual void SetNewLapCallback(NewLapFunc func, void* context) { m_newLapCallback = func; m_newLapContext = context; };
+
+		// Registers the callback that is triggered when a session message is read.
+		typedef bool (*NewSessionFunc)(const FitLapData& session, void* context);
+		virtual void SetNewSessionCallback(NewSessionFunc func, void* context) { m_newSessionCallback = func; m_newSessionContext = context; };
+
+		// Registers the callback that is triggered when an event message is read.
+		typedef bool (*NewEventFunc)(uint64_t timestampMs, uint8_t event, uint8_t eventType, uint32_t data, void* context);
+		virtual void SetNewEventCallback(NewEventFunc func, void* context) { m_newEventCallback = func; m_newEventContext = context; };
+
+		// Registers the callback that is triggered for each beat to beat interval in an HRV message.
+		typedef bool (*NewHrvFunc)(uint64_t timestampMs, double rrIntervalSecs, void* context);
+		virtual void SetNewHrvCallback(NewHrvFunc func, void* context) { m_newHrvCallback = func; m_newHrvContext = context; };
+
+		// Registers the callback that is triggered when the activity type is read.
+		typedef void (*ActivityTypeFunc)(const char* const activityType, void* context);
+		virtual void SetActivityTypeCallback(ActivityTypeFunc func, void* context) { m_activityTypeCallback = func; m_activityTypeContext = context; };
+
+		static std::string SportEnumToSportType(uint8_t sport, uint8_t subSport);
+
+	private:
+		typedef struct FitFieldDef
+		{
+			uint8_t fieldNum;
+			uint8_t size;
+			uint8_t baseType;
+		} FitFieldDef;
+
+		typedef struct FitMessageDef
+		{
+			bool                     valid;
+			bool                     bigEndian;
+			uint16_t                 globalMsgNum;
+			size_t                   dataSize; // Total size of the data message, including developer fields
+			std::vector<FitFieldDef> fields;
+		} FitMessageDef;
+
+		FitMessageDef    m_localDefs[16];
+		uint32_t         m_lastTimestamp; // FIT time, needed to expand compressed timestamp headers
+
+		NewRecordFunc    m_newRecordCallback;
+		void*            m_newRecordContext;
+		NewLapFunc       m_newLapCallback;
+		void*            m_newLapContext;
+		NewSessionFunc   m_newSessionCallback;
+		void*            m_newSessionContext;
+		NewEventFunc     m_newEventCallback;
+		void*            m_newEventContext;
+		NewHrvFunc       m_newHrvCallback;
+		void*            m_newHrvContext;
+		ActivityTypeFunc m_activityTypeCallback;
+		void*            m_activityTypeContext;
+
+		bool ParseFitFile(const uint8_t* data, size_t dataLen, size_t& bytesUsed);
+		bool ParseDefinitionMessage(uint8_t headerByte, const uint8_t* data, size_t dataLen, size_t& bytesUsed);
+		void ProcessDataMessage(const FitMessageDef& def, const uint8_t* data);
+
+		void ProcessRecord(const FitMessageDef& def, const uint8_t* data);
+		void ProcessLapOrSession(const FitMessageDef& def, const uint8_t* data);
+		void ProcessEvent(const FitMessageDef& def, const uint8_t* data);
+		void ProcessHrv(const FitMessageDef& def, const uint8_t* data);
+		void ProcessSport(const FitMessageDef& def, const uint8_t* data);
+
+		static bool ReadFieldValue(const uint8_t* data, uint8_t size, uint8_t baseType, bool bigEndian, double& value);
+		static uint64_t FitTimestampToUnixMs(uint32_t fitTimestamp);
+	};
+}
+
+#endif
@@ -6,585 +6,518 @@
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include "FitFileWriter.h"
+#include "FitTags.h"
 #include "ActivityType.h"
 #include "Defines.h"
 
-// Record message header byte offsets.
-#define RECORD_HDR_NORMAL                    0x80 // 0 = Normal Header
-#define RECORD_HDR_MSG_TYPE                  0x40 // 1 = Definition, 0 = Data Message
-#define RECORD_HDR_MSG_TYPE_SPECIFIC         0x20 // Contains developer specific data
-#define RECORD_HDR_RESERVED                  0x10
-#define RECORD_HDR_LOCAL_MSG_TYPE            0x0f
-#define RECORD_HDR_LOCAL_MSG_TYPE_COMPRESSED 0x60
-
-// Protocol version.
-#define FIT_PROTOCOL_VERSION_MAJOR_SHIFT 4
-#define FIT_PROTOCOL_VERSION_10 ((uint8_t)(1 << FIT_PROTOCOL_VERSION_MAJOR_SHIFT) | 0)
-#define FIT_PROTOCOL_VERSION_20 ((uint8_t)(2 << FIT_PROTOCOL_VERSION_MAJOR_SHIFT) | 0)
-
-// Profile version.
-#define FIT_PROFILE_VERSION_MAJOR 21
-#define FIT_PROFILE_VERSION_MINOR 60
-
-// Global message numbers.
-#define GLOBAL_MSG_NUM_FILE_ID 0
-#define GLOBAL_MSG_NUM_CAPABILITIES 1
-#define GLOBAL_MSG_NUM_DEVICE_SETTINGS 2
-#define GLOBAL_MSG_NUM_USER_PROFILE 3
-#define GLOBAL_MSG_NUM_HRM_PROFILE 4
-#define GLOBAL_MSG_NUM_SDM_PROFILE 5
-#define GLOBAL_MSG_NUM_BIKE_PROFILE 6
-#define GLOBAL_MSG_NUM_ZONES_TARGET 7
-#define GLOBAL_MSG_NUM_HR_ZONE 8
-#define GLOBAL_MSG_NUM_POWER_ZONE 9
-#define GLOBAL_MSG_NUM_MET_ZONE 10
-#define GLOBAL_MSG_NUM_SPORT 12
-#define GLOBAL_MSG_NUM_GOAL 15
-#define GLOBAL_MSG_NUM_SESSION 18
-#define GLOBAL_MSG_NUM_LAP 19
-#define GLOBAL_MSG_NUM_RECORD 20
-#define GLOBAL_MSG_NUM_EVENT 21
-#define GLOBAL_MSG_NUM_DEVICE_INFO 23
-#define GLOBAL_MSG_NUM_WORKOUT 26
-#define GLOBAL_MSG_NUM_WORKOUT_STEP 27
-#define GLOBAL_MSG_NUM_SCHEDULE 28
-#define GLOBAL_MSG_NUM_WEIGHT_SCALE 30
-#define GLOBAL_MSG_NUM_COURSE 31
-#define GLOBAL_MSG_NUM_COURSE_POINT 32
-#define GLOBAL_MSG_NUM_TOTALS 33
-#define GLOBAL_MSG_NUM_ACTIVITY 34
-#define GLOBAL_MSG_NUM_SOFTWARE 35
-#define GLOBAL_MSG_NUM_FILE_CAPABILITIES 37
-#define GLOBAL_MSG_NUM_MESG_CAPABILITIES 38
-#define GLOBAL_MSG_NUM_FIELD_CAPABILITIES 39
-#define GLOBAL_MSG_NUM_FILE_CREATOR 49
-#define GLOBAL_MSG_NUM_BLOOD_PRESSURE 51
-#define GLOBAL_MSG_NUM_SPEED_ZONE 53
-#define GLOBAL_MSG_NUM_MONITORING 55
-#define GLOBAL_MSG_NUM_TRAINING_FILE 72
-#define GLOBAL_MSG_NUM_HRV 78
-#define GLOBAL_MSG_NUM_ANT_RX 80
-#define GLOBAL_MSG_NUM_ANT_TX 81
-#define GLOBAL_MSG_NUM_ANT_CHANNEL_ID 82
-#define GLOBAL_MSG_NUM_LENGTH 101
-#define GLOBAL_MSG_NUM_MONITORING_INFO 103
-#define GLOBAL_MSG_NUM_PAD 105
-#define GLOBAL_MSG_NUM_SLAVE_DEVICE 106
-#define GLOBAL_MSG_NUM_CONNECTIVITY 127
-#define GLOBAL_MSG_NUM_WEATHER_CONDITIONS 128
-#define GLOBAL_MSG_NUM_WEATHER_ALERT 129
-#define GLOBAL_MSG_NUM_CADENCE_ZONE 131
-#define GLOBAL_MSG_NUM_HR 132
-#define GLOBAL_MSG_NUM_SEGMENT_LAP 142
-#define GLOBAL_MSG_NUM_MEMO_GLOB 145
-#define GLOBAL_MSG_NUM_SEGMENT_ID 148
-#define GLOBAL_MSG_NUM_SEGMENT_LEADERBOARD_ENTRY 149
-#define GLOBAL_MSG_NUM_SEGMENT_POINT 150
-#define GLOBAL_MSG_NUM_SEGMENT_FILE 151
-#define GLOBAL_MSG_NUM_WORKOUT_SESSION 158
-#define GLOBAL_MSG_NUM_WATCHFACE_SETTINGS 159
-#define GLOBAL_MSG_NUM_GPS_METADATA 160
-#define GLOBAL_MSG_NUM_CAMERA_EVENT 161
-#define GLOBAL_MSG_NUM_TIMESTAMP_CORRELATION 162
-#define GLOBAL_MSG_NUM_GYROSCOPE_DATA 164
-#define GLOBAL_MSG_NUM_ACCELEROMETER_DATA 165
-#define GLOBAL_MSG_NUM_THREE_D_SENSOR_CALIBRATION 167
-#define GLOBAL_MSG_NUM_VIDEO_FRAME 169
-#define GLOBAL_MSG_NUM_OBDII_DATA 174
-#define GLOBAL_MSG_NUM_NMEA_SENTENCE 177
-#define GLOBAL_MSG_NUM_AVIATION_ATTITUDE 178
-#define GLOBAL_MSG_NUM_VIDEO 184
-#define GLOBAL_MSG_NUM_VIDEO_TITLE 185
-#define GLOBAL_MSG_NUM_VIDEO_DESCRIPTION 186
-#define GLOBAL_MSG_NUM_VIDEO_CLIP 187
-#define GLOBAL_MSG_NUM_OHR_SETTINGS 188
-#define GLOBAL_MSG_NUM_EXD_SCREEN_CONFIGURATION 200
-#define GLOBAL_MSG_NUM_EXD_DATA_FIELD_CONFIGURATION 201
-#define GLOBAL_MSG_NUM_EXD_DATA_CONCEPT_CONFIGURATION 202
-#define GLOBAL_MSG_NUM_FIELD_DESCRIPTION 206
-#define GLOBAL_MSG_NUM_DEVELOPER_DATA_ID 207
-#define GLOBAL_MSG_NUM_MAGNETOMETER_DATA 208
-#define GLOBAL_MSG_NUM_BAROMETER_DATA 209
-#define GLOBAL_MSG_NUM_ONE_D_SENSOR_CALIBRATION 210
-#define GLOBAL_MSG_NUM_SET 225
-#define GLOBAL_MSG_NUM_STRESS_LEVEL 227
-#define GLOBAL_MSG_NUM_DIVE_SETTINGS 258
-#define GLOBAL_MSG_NUM_DIVE_GAS 259
-#define GLOBAL_MSG_NUM_DIVE_ALARM 262
-#define GLOBAL_MSG_NUM_EXERCISE_TITLE 264
-#define GLOBAL_MSG_NUM_DIVE_SUMMARY 268
-#define GLOBAL_MSG_NUM_JUMP 285
-#define GLOBAL_MSG_NUM_CLIMB_PRO 317
-
-// File enumeration, used in the FileId message.
-#define FIT_FILE_DEVICE 1
-#define FIT_FILE_SETTINGS 2
-#define FIT_FILE_SPORT 3
-#define FIT_FILE_ACTIVITY 4
-#define FIT_FILE_WORKOUT 5
-#define FIT_FILE_COURSE 6
-#define FIT_FILE_SCHEDULES 7
-#define FIT_FILE_WEIGHT 9
-#define FIT_FILE_TOTALS 10
-#define FIT_FILE_GOALS 11
-#define FIT_FILE_BLOOD_PRESSURE 14
-#define FIT_FILE_MONITORING_A 15
-#define FIT_FILE_ACTIVITY_SUMMARY 20
-#define FIT_FILE_MONITORING_DAILY 28
-#define FIT_FILE_MONITORING_B 32
-#define FIT_FILE_SEGMENT 34
-#define FIT_FILE_SEGMENT_LIST 35
-#define FIT_FILE_EXD_CONFIGURATION 50
-#define FIT_FILE_MFG_RANGE_MIN 0xF7
-#define FIT_FILE_MFG_RANGE_MAX 0xFE
-
-// Sport enumeration.
-#define FIT_SPORT_GENERIC 0
-#define FIT_SPORT_RUNNING 1
-#define FIT_SPORT_CYCLING 2
-#define FIT_SPORT_TRANSITION 3 // Mulitsport transition
-#define FIT_SPORT_FITNESS_EQUIPMENT 4
-#define FIT_SPORT_SWIMMING 5
-#define FIT_SPORT_BASKETBALL 6
-#define FIT_SPORT_SOCCER 7
-#define FIT_SPORT_TENNIS 8
-#define FIT_SPORT_AMERICAN_FOOTBALL 9
-#define FIT_SPORT_TRAINING 10
-#define FIT_SPORT_WALKING 11
-#define FIT_SPORT_CROSS_COUNTRY_SKIING 12
-#define FIT_SPORT_ALPINE_SKIING 13
-#define FIT_SPORT_SNOWBOARDING 14
-#define FIT_SPORT_ROWING 15
-#define FIT_SPORT_MOUNTAINEERING 16
-#define FIT_SPORT_HIKING 17
-#define FIT_SPORT_MULTISPORT 18
-#define FIT_SPORT_PADDLING 19
-#define FIT_SPORT_FLYING 20
-#define FIT_SPORT_E_BIKING 21
-#define FIT_SPORT_MOTORCYCLING 22
-#define FIT_SPORT_BOATING 23
-#define FIT_SPORT_DRIVING 24
-#define FIT_SPORT_GOLF 25
-#define FIT_SPORT_HANG_GLIDING 26
-#define FIT_SPORT_HORSEBACK_RIDING 27
-#define FIT_SPORT_HUNTING 28
-#define FIT_SPORT_FISHING 29
-#define FIT_SPORT_INLINE_SKATING 30
-#define FIT_SPORT_ROCK_CLIMBING 31
-#define FIT_SPORT_SAILING 32
-#define FIT_SPORT_ICE_SKATING 33
-#define FIT_SPORT_SKY_DIVING 34
-#define FIT_SPORT_SNOWSHOEING 35
-#define FIT_SPORT_SNOWMOBILING 36
-#define FIT_SPORT_STAND_UP_PADDLEBOARDING 37
-#define FIT_SPORT_SURFING 38
-#define FIT_SPORT_WAKEBOARDING 39
-#define FIT_SPORT_WATER_SKIING 40
-#define FIT_SPORT_KAYAKING 41
-#define FIT_SPORT_RAFTING 42
-#define FIT_SPORT_WINDSURFING 43
-#define FIT_SPORT_KITESURFING 44
-#define FIT_SPORT_TACTICAL 45
-#define FIT_SPORT_JUMPMASTER 46
-#define FIT_SPORT_BOXING 47
-#define FIT_SPORT_FLOOR_CLIMBING 48
-#define FIT_SPORT_DIVING 53
-#define FIT_SPORT_ALL 254
-
-// Swim stroke enumeration.
-#define FIT_ENUM_INVALID 0xff
-#define FIT_STROKE_TYPE_INVALID FIT_ENUM_INVALID
-#define FIT_STROKE_TYPE_NO_EVENT 0
-#define FIT_STROKE_TYPE_OTHER 1 // stroke was detected but cannot be identified
-#define FIT_STROKE_TYPE_SERVE 2
-#define FIT_STROKE_TYPE_FOREHAND 3
-#define FIT_STROKE_TYPE_BACKHAND 4
-#define FIT_STROKE_TYPE_SMASH 5
-#define FIT_STROKE_TYPE_COUNT 6
-
-// Lap trigger enumation.
-#define FIT_LAP_TRIGGER_MANUAL 0
-#define FIT_LAP_TRIGGER_TIME 1
-#define FIT_LAP_TRIGGER_DISTANCE 2
-#define FIT_LAP_TRIGGER_POSITION_START 3
-#define FIT_LAP_TRIGGER_POSITION_LAP 4
-#define FIT_LAP_TRIGGER_POSITION_WAYPOINT 5
-#define FIT_LAP_TRIGGER_POSITION_MARKED 6
-#define FIT_LAP_TRIGGER_SESSION_END 7
-#define FIT_LAP_TRIGGER_FITNESS_EQUIPMENT 8
-
-// Base types.
-#define FIT_BASE_TYPE_ENUM 0x00
-#define FIT_BASE_TYPE_SINT8 0x01
-#define FIT_BASE_TYPE_UINT8 0x02
-#define FIT_BASE_TYPE_SINT16 0x83
-#define FIT_BASE_TYPE_UINT16 0x84
-#define FIT_BASE_TYPE_SINT32 0x85
-#define FIT_BASE_TYPE_UINT32 0x86
-#define FIT_BASE_TYPE_STRING 0x07
-#define FIT_BASE_TYPE_FLOAT32 0x88
-#define FIT_BASE_TYPE_FLOAT64 0x89
-#define FIT_BASE_TYPE_UINT8Z 0x0A
-#define FIT_BASE_TYPE_UINT16Z 0x8B
-#define FIT_BASE_TYPE_UINT32Z 0x8C
-#define FIT_BASE_TYPE_BYTE 0x0D
-#define FIT_BASE_TYPE_SINT64 0x8E
-#define FIT_BASE_TYPE_UINT64 0x8F
-#define FIT_BASE_TYPE_UINT64Z 0x90
-
+#include <algorithm>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+// Local message types. Compressed timestamp headers can only refer to types 0-3, so the
+// compressed record gets type 0, the other messages that can appear between records get 1-3.
+#define LOCAL_MSG_RECORD_COMPRESSED 0
+#define LOCAL_MSG_RECORD            1
+#define LOCAL_MSG_EVENT             2
+#define LOCAL_MSG_HRV               3
+#define LOCAL_MSG_LAP               4
+#define LOCAL_MSG_SESSION           5
+#define LOCAL_MSG_ACTIVITY          6
+#define LOCAL_MSG_DEVICE_INFO       7
+#define LOCAL_MSG_FILE_ID           8
+#define LOCAL_MSG_FILE_CREATOR      9
+#define LOCAL_MSG_SPORT             10
+
+#define NUM_FIELDS(fields) (sizeof(fields) / sizeof(fields[0]))
 
 namespace FileLib
 {
+	// Field definitions for each message. Every field is always written, unknown values are written as
+	// the invalid value for the field's type, so each message type only ever needs one definition.
+	// The Write* functions must put the values in the same order.
+
+	static const FieldDefinition FILE_ID_FIELDS[] = {
+		{ 0, 1, FIT_BASE_TYPE_ENUM },     // type
+		{ 1, 2, FIT_BASE_TYPE_UINT16 },   // manufacturer
+		{ 2, 2, FIT_BASE_TYPE_UINT16 },   // product
+		{ 3, 4, FIT_BASE_TYPE_UINT32Z },  // serial_number
+		{ 4, 4, FIT_BASE_TYPE_UINT32 },   // time_created
+		{ 5, 2, FIT_BASE_TYPE_UINT16 },   // number
+		{ 8, FIT_PRODUCT_NAME_SIZE, FIT_BASE_TYPE_STRING }, // product_name
+	};
+
+	static const FieldDefinition FILE_CREATOR_FIELDS[] = {
+		{ 0, 2, FIT_BASE_TYPE_UINT16 },   // software_version
+		{ 1, 1, FIT_BASE_TYPE_UINT8 },    // hardware_version
+	};
+
+	static const FieldDefinition DEVICE_INFO_FIELDS[] = {
+		{ FIT_FIELD_TIMESTAMP, 4, FIT_BASE_TYPE_UINT32 },
+		{ 0, 1, FIT_BASE_TYPE_UINT8 },    // device_index
+		{ 2, 2, FIT_BASE_TYPE_UINT16 },   // manufacturer
+		{ 3, 4, FIT_BASE_TYPE_UINT32Z },  // serial_number
+		{ 4, 2, FIT_BASE_TYPE_UINT16 },   // product
+		{ 5, 2, FIT_BASE_TYPE_UINT16 },   // software_version
+		{ 27, FIT_PRODUCT_NAME_SIZE, FIT_BASE_TYPE_STRING }, // product_name
+	};
+
+	static const FieldDefinition SPORT_FIELDS[] = {
+		{ 0, 1, FIT_BASE_TYPE_ENUM },     // sport
+		{ 1, 1, FIT_BASE_TYPE_ENUM },     // sub_sport
+	};
+
+	static const FieldDefinition EVENT_FIELDS[] = {
+		{ FIT_FIELD_TIMESTAMP, 4, FIT_BASE_TYPE_UINT32 },
+		{ 0, 1, FIT_BASE_TYPE_ENUM },     // event
+		{ 1, 1, FIT_BASE_TYPE_ENUM },     // event_type
+		{ 3, 4, FIT_BASE_TYPE_UINT32 },   // data
+		{ 4, 1, FIT_BASE_TYPE_UINT8 },    // event_group
+	};
+
+	// The compressed record is the same as the normal record, minus the timestamp.
+	static const FieldDefinition RECORD_FIELDS[] = {
+		{ FIT_FIELD_TIMESTAMP, 4, FIT_BASE_TYPE_UINT32 },
+		{ 0, 4, FIT_BASE_TYPE_SINT32 },   // position_lat
+		{ 1, 4, FIT_BASE_TYPE_SINT32 },   // position_long
+		{ 2, 2, FIT_BASE_TYPE_UINT16 },   // altitude
+		{ 3, 1, FIT_BASE_TYPE_UINT8 },    // heart_rate
+		{ 4, 1, FIT_BASE_TYPE_UINT8 },    // cadence
+		{ 5, 4, FIT_BASE_TYPE_UINT32 },   // distance
+		{ 6, 2, FIT_BASE_TYPE_UINT16 },   // speed
+		{ 7, 2, FIT_BASE_TYPE_UINT16 },   // power
+	};
+	static const FieldDefinition* COMPRESSED_RECORD_FIELDS = RECORD_FIELDS + 1;
+	static const size_t NUM_COMPRESSED_RECORD_FIELDS = NUM_FIELDS(RECORD_FIELDS) - 1;
+
+	static const FieldDefinition HRV_FIELDS[] = {
+		{ 0, 2 * FIT_HRV_INTERVALS_PER_MESSAGE, FIT_BASE_TYPE_UINT16 }, // time
+	};
+
+	static const FieldDefinition LAP_FIELDS[] = {
+		{ FIT_FIELD_TIMESTAMP, 4, FIT_BASE_TYPE_UINT32 },
+		{ 0, 1, FIT_BASE_TYPE_ENUM },     // event
+		{ 1, 1, FIT_BASE_TYPE_ENUM },     // event_type
+		{ 2, 4, FIT_BASE_TYPE_UINT32 },   // start_time
+		{ 7, 4, FIT_BASE_TYPE_UINT32 },   // total_elapsed_time
+		{ 8, 4, FIT_BASE_TYPE_UINT32 },   // total_timer_time
+		{ 9, 4, FIT_BASE_TYPE_UINT32 },   // total_distance
+		{ 11, 2, FIT_BASE_TYPE_UINT16 },  // total_calories
+		{ 13, 2, FIT_BASE_TYPE_UINT16 },  // avg_speed
+		{ 14, 2, FIT_BASE_TYPE_UINT16 },  // max_speed
+		{ 15, 1, FIT_BASE_TYPE_UINT8 },   // avg_heart_rate
+		{ 16, 1, FIT_BASE_TYPE_UINT8 },   // max_heart_rate
+		{ 17, 1, FIT_BASE_TYPE_UINT8 },   // avg_cadence
+		{ 18, 1, FIT_BASE_TYPE_UINT8 },   // max_cadence
+		{ 19, 2, FIT_BASE_TYPE_UINT16 },  // avg_power
+		{ 20, 2, FIT_BASE_TYPE_UINT16 },  // max_power
+		{ 21, 2, FIT_BASE_TYPE_UINT16 },  // total_ascent
+		{ 22, 2, FIT_BASE_TYPE_UINT16 },  // total_descent
+		{ 24, 1, FIT_BASE_TYPE_ENUM },    // lap_trigger
+		{ 25, 1, FIT_BASE_TYPE_ENUM },    // sport
+		{ 39, 1, FIT_BASE_TYPE_ENUM },    // sub_sport
+		{ FIT_FIELD_MESSAGE_INDEX, 2, FIT_BASE_TYPE_UINT16 },
+	};
+
+	static const FieldDefinition SESSION_FIELDS[] = {
+		{ FIT_FIELD_TIMESTAMP, 4, FIT_BASE_TYPE_UINT32 },
+		{ 0, 1, FIT_BASE_TYPE_ENUM },     // event
+		{ 1, 1, FIT_BASE_TYPE_ENUM },     // event_type
+		{ 2, 4, FIT_BASE_TYPE_UINT32 },   // start_time
+		{ 5, 1, FIT_BASE_TYPE_ENUM },     // sport
+		{ 6, 1, FIT_BASE_TYPE_ENUM },     // sub_sport
+		{ 7, 4, FIT_BASE_TYPE_UINT32 },   // total_elapsed_time
+		{ 8, 4, FIT_BASE_TYPE_UINT32 },   // total_timer_time
+		{ 9, 4, FIT_BASE_TYPE_UINT32 },   // total_distance
+		{ 11, 2, FIT_BASE_TYPE_UINT16 },  // total_calories
+		{ 14, 2, FIT_BASE_TYPE_UINT16 },  // avg_speed
+		{ 15, 2, FIT_BASE_TYPE_UINT16 },  // max_speed
+		{ 16, 1, FIT_BASE_TYPE_UINT8 },   // avg_heart_rate
+		{ 17, 1, FIT_BASE_TYPE_UINT8 },   // max_heart_rate
+		{ 18, 1, FIT_BASE_TYPE_UINT8 },   // avg_cadence
+		{ 19, 1, FIT_BASE_TYPE_UINT8 },   // max_cadence
+		{ 20, 2, FIT_BASE_TYPE_UINT16 },  // avg_power
+		{ 21, 2, FIT_BASE_TYPE_UINT16 },  // max_power
+		{ 22, 2, FIT_BASE_TYPE_UINT16 },  // total_ascent
+		{ 23, 2, FIT_BASE_TYPE_UINT16 },  // total_descent
+		{ 25, 2, FIT_BASE_TYPE_UINT16 },  // first_lap_index
+		{ 26, 2, FIT_BASE_TYPE_UINT16 },  // num_laps
+		{ 28, 1, FIT_BASE_TYPE_ENUM },    // trigger
+		{ FIT_FIELD_MESSAGE_INDEX, 2, FIT_BASE_TYPE_UINT16 },
+	};
+
+	static const FieldDefinition ACTIVITY_FIELDS[] = {
+		{ FIT_FIELD_TIMESTAMP, 4, FIT_BASE_TYPE_UINT32 },
+		{ 0, 4, FIT_BASE_TYPE_UINT32 },   // total_timer_time
+		{ 1, 2, FIT_BASE_TYPE_UINT16 },   // num_sessions
+		{ 2, 1, FIT_BASE_TYPE_ENUM },     // type
+		{ 3, 1, FIT_BASE_TYPE_ENUM },     // event
+		{ 4, 1, FIT_BASE_TYPE_ENUM },     // event_type
+		{ 5, 4, FIT_BASE_TYPE_UINT32 },   // local_timestamp
+	};
+
 	FitFileWriter::FitFileWriter()
 	{
-		m_needLapDefinition = true;
-		m_needRecordDefinition = true;
-		m_dataLen = 0;
-		m_crc = 0;
+		m_definedMessages = 0;
+		m_lastTimestamp = 0;
+		m_haveTimestamp = false;
 	}
 	
 	FitFileWriter::~FitFileWriter()
 	{
 	}
 
-	bool FitFileWriter::WriteBinaryData(const uint8_t* data, size_t len)
+	bool FitFileWriter::WriteString(const std::string& str)
 	{
-		if (File::WriteBinaryData(data, len))
-		{
-			for (size_t i = 0; i < len; ++i)
-				m_crc = CRC(m_crc, data[i]);
-			m_dataLen += len;
-			return true;
-		}
 		return false;
 	}
 
-	bool FitFileWriter::WriteFitFileHeader()
+	bool FitFileWriter::WriteBinaryData(const uint8_t* data, size_t len)
 	{
-		FitHeader header;
-
-		header.headerSize = sizeof(FitHeader);
-		header.protocolVersion = FIT_PROTOCOL_VERSION_20;
-		header.profileVersionLsb = FIT_PROFILE_VERSION_MAJOR;
-		header.profileVersionMsb = 0;
-		header.dataSize = 0;
-		header.dataType[0] = '.';
-		header.dataType[1] = 'F';
-		header.dataType[2] = 'I';
-		header.dataType[3] = 'T';
-		header.crc = 0;
-
-		return File::WriteBinaryData((uint8_t*)&header, sizeof(FitHeader));
+		m_buffer.insert(m_buffer.end(), data, data + len);
+		return true;
 	}
 
-	bool FitFileWriter::UpdateFitFileHeader()
+	void FitFileWriter::WriteDefinitionMessage(uint8_t localMsgType, uint16_t globalMsgNum, const FieldDefinition* fieldDefs, size_t numFields)
 	{
-		bool result = false;
-
-		//
-		// Update the data length.
-		//
+		DefinitionMessageHeader msgHeader;
 
-		if (SeekFromStart(4))
-		{
-			result = File::WriteBinaryData((const uint8_t*)&m_dataLen, sizeof(m_dataLen));
-		}
+		msgHeader.reserved = 0;
+		msgHeader.architecture = 0; // Little endian
+		msgHeader.globalMessageNumber = globalMsgNum;
+		msgHeader.numFields = (uint8_t)numFields;
 
-		//
-		// Update the header CRC.
-		//
+		Put8(RECORD_HDR_MSG_TYPE | (localMsgType & RECORD_HDR_LOCAL_MSG_TYPE));
+		Put8(msgHeader.reserved);
+		Put8(msgHeader.architecture);
+		Put16(msgHeader.globalMessageNumber);
+		Put8(msgHeader.numFields);
+		WriteBinaryData((const uint8_t*)fieldDefs, numFields * sizeof(FieldDefinition));
 
-		if (result && SeekFromStart(12))
-		{
-			result = File::WriteBinaryData((const uint8_t*)&m_crc, sizeof(m_crc));
-		}
-		return result;
+		m_definedMessages |= (1 << localMsgType);
 	}
 
-	bool FitFileWriter::WriteNormalDefinitionMessage(uint16_t globalMsgNum, uint8_t localMsgType, const std::vector<FieldDefinition>& fieldDefinitions)
+	bool FitFileWriter::BeginDataMessage(uint8_t localMsgType, uint16_t globalMsgNum, const FieldDefinition* fieldDefs, size_t numFields)
 	{
-		bool result = false;
-
-		//
-		// Normal record header for a definition message.
-		//
-
-		uint8_t headerByte = RECORD_HDR_MSG_TYPE;
-
-		if (WriteBinaryData(&headerByte, 1))
+		if (!IsOpen())
 		{
-			//
-			// Definition message.
-			//
-
-			DefinitionMessageHeader msgHeader;
-
-			msgHeader.reserved = 0;
-			msgHeader.architecture = 0;
-			msgHeader.globalMessageNumber = globalMsgNum;
-			msgHeader.numFields = fieldDefinitions.size();
-
-			if (WriteBinaryData((const uint8_t*)&msgHeader, sizeof(msgHeader)))
-			{
-				result = true;
-
-				//
-				// Fields
-				//
-
-				for (auto iter = fieldDefinitions.begin(); iter != fieldDefinitions.end(); ++iter)
-				{
-					const FieldDefinition& def = (*iter);
-
-					result &= WriteBinaryData((const uint8_t*)&def, sizeof(def));
-				}
-			}
+			return false;
 		}
-		return result;
+		if (!(m_definedMessages & (1 << localMsgType)))
+		{
+			WriteDefinitionMessage(localMsgType, globalMsgNum, fieldDefs, numFields);
+		}
+		Put8(localMsgType & RECORD_HDR_LOCAL_MSG_TYPE);
+		return true;
 	}
 
-	bool FitFileWriter::WriteNormalDataMessage(uint8_t localMsgType, const FieldDefinitions& fieldDefinitions, const FieldValues& fieldValues)
+	void FitFileWriter::WriteTimestamp(uint32_t timestamp)
 	{
-		bool result = false;
-
-		//
-		// Normal record header.
-		//
-
-		uint8_t headerByte = RECORD_HDR_NORMAL;
-		headerByte |= (localMsgType & RECORD_HDR_LOCAL_MSG_TYPE);
-
-		if (WriteBinaryData(&headerByte, 1))
+		// Every full timestamp becomes the reference for the compressed timestamps that follow, same as when reading.
+		if (timestamp != FIT_INVALID_UINT32)
 		{
-			result = true;
-
-			//
-			// Fields
-			//
-				
-			auto valIter = fieldValues.begin();
-			for (auto defIter = fieldDefinitions.begin();
-				 defIter != fieldDefinitions.end() && valIter != fieldValues.end();
-				 ++defIter, ++valIter)
-			{
-				const FieldDefinition& def = (*defIter);
-				const FieldValue& val = (*valIter);
-
-				result &= WriteBinaryData((const uint8_t*)&val.intVal, def.size);
-			}
+			m_lastTimestamp = timestamp;
+			m_haveTimestamp = true;
 		}
-		return result;
+		Put32(timestamp);
 	}
 
-	bool FitFileWriter::WriteString(const std::string& str)
+	void FitFileWriter::PutString(const std::string& str, size_t fieldSize)
 	{
-		return false;
+		size_t len = std::min(str.size(), fieldSize - 1);
+
+		WriteBinaryData((const uint8_t*)str.c_str(), len);
+		m_buffer.insert(m_buffer.end(), fieldSize - len, 0);
 	}
 
 	bool FitFileWriter::CreateFile(const std::string& fileName)
 	{
 		if (File::CreateFile(fileName))
 		{
-			if (WriteFitFileHeader())
-			{
-				FileId fileId;
+			m_buffer.clear();
+			m_buffer.reserve(64 * 1024);
+			m_definedMessages = 0;
+			m_lastTimestamp = 0;
+			m_haveTimestamp = false;
 
-				fileId.file = FIT_FILE_ACTIVITY;
-				fileId.manufacturer = 0;
-				fileId.product = 0;
-				fileId.serialNumber = 0;
-				fileId.timeCreated = UnixTimestampToFitTimestamp(time(NULL));
-				fileId.number = 0;
-				fileId.productName = APP_NAME;
+			// Placeholder for the header, it is filled in when the file is closed.
+			m_buffer.insert(m_buffer.end(), sizeof(FitHeader), 0);
 
-				if (WriteFileId(fileId))
-				{
-					FileCreator creator;
+			FileId fileId;
+			fileId.timeCreated = UnixTimestampToFitTimestamp(time(NULL));
+			fileId.productName = APP_NAME;
 
-					creator.softwareVersion = 0;
-					creator.hardwareVersion = 0;
+			FileCreator creator;
 
-					return WriteFileCreator(creator);
-				}
-			}
+			return WriteFileId(fileId) && WriteFileCreator(creator);
 		}
 		return false;
 	}
 
 	bool FitFileWriter::CloseFile()
 	{
-		return UpdateFitFileHeader() && File::CloseFile();
-	}
+		if (!IsOpen() || m_buffer.size() < sizeof(FitHeader))
+		{
+			return false;
+		}
 
-	bool FitFileWriter::StartActivity()
-	{
-		return true;
-	}
+		//
+		// Fill in the header now that the size of the data is known.
+		//
 
-	bool FitFileWriter::EndActivity()
-	{
-		return true;
-	}
+		FitHeader header;
 
-	bool FitFileWriter::StartLap(uint32_t lapStartedTime)
-	{
-		FieldDefinitions fieldDefs;
-		FieldValues fieldValues;
+		header.headerSize = sizeof(FitHeader);
+		header.protocolVersion = FIT_PROTOCOL_VERSION_20;
+		header.profileVersion = FIT_PROFILE_VERSION_MAJOR * 100 + FIT_PROFILE_VERSION_MINOR;
+		header.dataSize = (uint32_t)(m_buffer.size() - sizeof(FitHeader));
+		header.dataType[0] = '.';
+		header.dataType[1] = 'F';
+		header.dataType[2] = 'I';
+		header.dataType[3] = 'T';
+		header.crc = 0;
+		memcpy(m_buffer.data(), &header, sizeof(FitHeader));
+
+		uint16_t headerCrc = FitCrc16(0, m_buffer.data(), offsetof(FitHeader, crc));
+		m_buffer[offsetof(FitHeader, crc)] = (uint8_t)headerCrc;
+		m_buffer[offsetof(FitHeader, crc) + 1] = (uint8_t)(headerCrc >> 8);
 
-		fieldDefs.push_back( { 253, sizeof(lapStartedTime), FIT_BASE_TYPE_UINT32 } );
-		fieldValues.push_back( { .uintVal = lapStartedTime } );
+		//
+		// The file CRC covers everything, including the header.
+		//
 
-		fieldDefs.push_back( { 2, sizeof(lapStartedTime), FIT_BASE_TYPE_UINT32 } );
-		fieldValues.push_back( { .uintVal = lapStartedTime } );
+		Put16(FitCrc16(0, m_buffer.data(), m_buffer.size()));
 
-		fieldDefs.push_back( { 24, 1, FIT_BASE_TYPE_ENUM } );
-		fieldValues.push_back( { .uintVal = FIT_LAP_TRIGGER_MANUAL } );
-		
-		uint16_t globalMsgNum = GLOBAL_MSG_NUM_LAP;
-		uint8_t localMsgType = 0;
+		bool result = File::WriteBinaryData(m_buffer.data(), m_buffer.size());
+		result &= m_file.good();
+		result &= File::CloseFile();
 
-		bool result = true;
-		
-		if (m_needLapDefinition)
-		{
-			result = WriteNormalDefinitionMessage(globalMsgNum, localMsgType, fieldDefs);
-			if (result)
-				m_needLapDefinition = false;
-		}
-		return result && WriteNormalDataMessage(localMsgType, fieldDefs, fieldValues);
+		m_buffer.clear();
+		m_buffer.shrink_to_fit();
+		return result;
 	}
 
-	bool FitFileWriter::WriteFileId(const FileId& fileId)
+	bool FitFileWriter::StartActivity(uint32_t timestamp)
 	{
-		FieldDefinitions fieldDefs;
-		FieldValues fieldValues;
+		FitEvent evt;
 
-		fieldDefs.push_back( { 0, sizeof(fileId.file), FIT_BASE_TYPE_ENUM } );
-		fieldValues.push_back( { .uintVal = fileId.file } );
+		evt.timestamp = timestamp;
+		evt.event = FIT_EVENT_TIMER;
+		evt.eventType = FIT_EVENT_TYPE_START;
+		evt.eventGroup = 0;
+		return WriteEvent(evt);
+	}
 
-		fieldDefs.push_back( { 4, sizeof(fileId.timeCreated), FIT_BASE_TYPE_UINT32 } );
-		fieldValues.push_back( { .uintVal = fileId.timeCreated } );
+	bool FitFileWriter::EndActivity(uint32_t timestamp)
+	{
+		FitEvent evt;
 
-		uint16_t globalMsgNum = GLOBAL_MSG_NUM_FILE_ID;
-		uint8_t localMsgType = 0;
+		evt.timestamp = timestamp;
+		evt.event = FIT_EVENT_TIMER;
+		evt.eventType = FIT_EVENT_TYPE_STOP_ALL;
+		evt.eventGroup = 0;
+		return WriteEvent(evt);
+	}
 
-		bool result = WriteNormalDefinitionMessage(globalMsgNum, localMsgType, fieldDefs);
-		return result && WriteNormalDataMessage(localMsgType, fieldDefs, fieldValues);
+	bool FitFileWriter::WriteFileId(const FileId& fileId)
+	{
+		if (!BeginDataMessage(LOCAL_MSG_FILE_ID, GLOBAL_MSG_NUM_FILE_ID, FILE_ID_FIELDS, NUM_FIELDS(FILE_ID_FIELDS)))
+			return false;
+
+		Put8(fileId.file);
+		Put16(fileId.manufacturer);
+		Put16(fileId.product);
+		Put32(fileId.serialNumber);
+		Put32(fileId.timeCreated);
+		Put16(fileId.number);
+		PutString(fileId.productName, FIT_PRODUCT_NAME_SIZE);
+		return true;
 	}
 
 	bool FitFileWriter::WriteFileCreator(const FileCreator& creator)
 	{
-		FieldDefinitions fieldDefs;
-		FieldValues fieldValues;
+		if (!BeginDataMessage(LOCAL_MSG_FILE_CREATOR, GLOBAL_MSG_NUM_FILE_CREATOR, FILE_CREATOR_FIELDS, NUM_FIELDS(FILE_CREATOR_FIELDS)))
+			return false;
 
-		uint16_t globalMsgNum = GLOBAL_MSG_NUM_FILE_CREATOR;
-		uint8_t localMsgType = 0;
+		Put16(creator.softwareVersion);
+		Put8(creator.hardwareVersion);
+		return true;
+	}
 
-		bool result = WriteNormalDefinitionMessage(globalMsgNum, localMsgType, fieldDefs);
-		return result && WriteNormalDataMessage(localMsgType, fieldDefs, fieldValues);
+	bool FitFileWriter::WriteDeviceInfo(const FitDeviceInfo& deviceInfo)
+	{
+		if (!BeginDataMessage(LOCAL_MSG_DEVICE_INFO, GLOBAL_MSG_NUM_DEVICE_INFO, DEVICE_INFO_FIELDS, NUM_FIELDS(DEVICE_INFO_FIELDS)))
+			return false;
+
+		WriteTimestamp(deviceInfo.timestamp);
+		Put8(deviceInfo.deviceIndex);
+		Put16(deviceInfo.manufacturer);
+		Put32(deviceInfo.serialNumber);
+		Put16(deviceInfo.product);
+		Put16(deviceInfo.softwareVersion);
+		PutString(deviceInfo.productName, FIT_PRODUCT_NAME_SIZE);
+		return true;
 	}
 
 	bool FitFileWriter::WriteSport(uint8_t sportType)
 	{
-		FieldDefinitions fieldDefs;
-		FieldValues fieldValues;
+		if (!BeginDataMessage(LOCAL_MSG_SPORT, GLOBAL_MSG_NUM_SPORT, SPORT_FIELDS, NUM_FIELDS(SPORT_FIELDS)))
+			return false;
 
-		fieldDefs.push_back( { 0, sizeof(sportType), FIT_BASE_TYPE_ENUM } );
-		fieldValues.push_back( { .uintVal = sportType } );
-
-		uint16_t globalMsgNum = GLOBAL_MSG_NUM_SPORT;
-		uint8_t localMsgType = 0;
-
-		bool result = WriteNormalDefinitionMessage(globalMsgNum, localMsgType, fieldDefs);
-		return result && WriteNormalDataMessage(localMsgType, fieldDefs, fieldValues);
+		Put8(sportType);
+		Put8(FIT_ENUM_INVALID);
+		return true;
 	}
 
 	bool FitFileWriter::WriteSession(const FitSession& session)
 	{
-		FieldDefinitions fieldDefs;
-		FieldValues fieldValues;
-
-		uint16_t globalMsgNum = GLOBAL_MSG_NUM_SESSION;
-		uint8_t localMsgType = 0;
+		if (!BeginDataMessage(LOCAL_MSG_SESSION, GLOBAL_MSG_NUM_SESSION, SESSION_FIELDS, NUM_FIELDS(SESSION_FIELDS)))
+			return false;
+
+		WriteTimestamp(session.timestamp);
+		Put8(session.event);
+		Put8(session.eventType);
+		Put32(session.startTime);
+		Put8(session.sport);
+		Put8(session.subSport);
+		Put32(session.totalElapsedTime);
+		Put32(session.totalTimerTime);
+		Put32(session.totalDistance);
+		Put16(session.totalCalories);
+		Put16(session.avgSpeed);
+		Put16(session.maxSpeed);
+		Put8(session.avgHeartRate);
+		Put8(session.maxHeartRate);
+		Put8(session.avgCadence);
+		Put8(session.maxCadence);
+		Put16(session.avgPower);
+		Put16(session.maxPower);
+		Put16(session.totalAscent);
+		Put16(session.totalDescent);
+		Put16(session.firstLapIndex);
+		Put16(session.numLaps);
+		Put8(session.trigger);
+		Put16(session.messageIndex);
+		return true;
+	}
 
-		bool result = WriteNormalDefinitionMessage(globalMsgNum, localMsgType, fieldDefs);
-		return result && WriteNormalDataMessage(localMsgType, fieldDefs, fieldValues);
+	bool FitFileWriter::WriteLap(const FitLap& lap)
+	{
+		if (!BeginDataMessage(LOCAL_MSG_LAP, GLOBAL_MSG_NUM_LAP, LAP_FIELDS, NUM_FIELDS(LAP_FIELDS)))
+			return false;
+
+		WriteTimestamp(lap.timestamp);
+		Put8(lap.event);
+		Put8(lap.eventType);
+		Put32(lap.startTime);
+		Put32(lap.totalElapsedTime);
+		Put32(lap.totalTimerTime);
+		Put32(lap.totalDistance);
+		Put16(lap.totalCalories);
+		Put16(lap.avgSpeed);
+		Put16(lap.maxSpeed);
+		Put8(lap.avgHeartRate);
+		Put8(lap.maxHeartRate);
+		Put8(lap.avgCadence);
+		Put8(lap.maxCadence);
+		Put16(lap.avgPower);
+		Put16(lap.maxPower);
+		Put16(lap.totalAscent);
+		Put16(lap.totalDescent);
+		Put8(lap.lapTrigger);
+		Put8(lap.sport);
+		Put8(lap.subSport);
+		Put16(lap.messageIndex);
+		return true;
 	}
 
 	bool FitFileWriter::WriteEvent(const FitEvent& evt)
 	{
-		FieldDefinitions fieldDefs;
-		FieldValues fieldValues;
-
-		uint16_t globalMsgNum = GLOBAL_MSG_NUM_EVENT;
-		uint8_t localMsgType = 0;
-
-		bool result = WriteNormalDefinitionMessage(globalMsgNum, localMsgType, fieldDefs);
-		return result && WriteNormalDataMessage(0, fieldDefs, fieldValues);
+		if (!BeginDataMessage(LOCAL_MSG_EVENT, GLOBAL_MSG_NUM_EVENT, EVENT_FIELDS, NUM_FIELDS(EVENT_FIELDS)))
+			return false;
+
+		WriteTimestamp(evt.timestamp);
+		Put8(evt.event);
+		Put8(evt.eventType);
+		Put32(evt.data);
+		Put8(evt.eventGroup);
+		return true;
 	}
 
 	bool FitFileWriter::WriteRecord(const FitRecord& rec)
 	{
-		FieldDefinitions fieldDefs;
-		FieldValues fieldValues;
-
-		fieldDefs.push_back( { 253, sizeof(rec.timestamp), FIT_BASE_TYPE_UINT32 } );
-		fieldValues.push_back( { .uintVal = rec.timestamp } );
-
-		fieldDefs.push_back( { 1, sizeof(rec.positionLong), FIT_BASE_TYPE_SINT32 } );
-		fieldValues.push_back( { .intVal = rec.positionLong } );
-
-		fieldDefs.push_back( { 0, sizeof(rec.positionLat), FIT_BASE_TYPE_SINT32 } );
-		fieldValues.push_back( { .intVal = rec.positionLat } );
-
-		fieldDefs.push_back( { 2, sizeof(rec.altitude), FIT_BASE_TYPE_UINT16 } );
-		fieldValues.push_back( { .uintVal = rec.altitude } );
-
-		fieldDefs.push_back( { 7, sizeof(rec.power), FIT_BASE_TYPE_UINT16 } );
-		fieldValues.push_back( { .uintVal = rec.power } );
-
-		fieldDefs.push_back( { 52, sizeof(rec.cadence256), FIT_BASE_TYPE_UINT16 } );
-		fieldValues.push_back( { .uintVal = rec.cadence256 } );
-
-		fieldDefs.push_back( { 3, sizeof(rec.heartRate), FIT_BASE_TYPE_UINT8 } );
-		fieldValues.push_back( { .uintVal = rec.heartRate } );
-
-		uint16_t globalMsgNum = GLOBAL_MSG_NUM_RECORD;
-		uint8_t localMsgType = 0;
+		// Use a compressed timestamp header when the record is within 31 seconds of the last full timestamp,
+		// which drops the four byte timestamp field from each record. The reader adds the five bit offset to the last full timestamp.
+		bool compressed = m_haveTimestamp &&
+			rec.timestamp != FIT_INVALID_UINT32 &&
+			rec.timestamp >= m_lastTimestamp &&
+			rec.timestamp - m_lastTimestamp <= RECORD_HDR_TIME_OFFSET;
+
+		if (compressed)
+		{
+			if (!IsOpen())
+				return false;
+			if (!(m_definedMessages & (1 << LOCAL_MSG_RECORD_COMPRESSED)))
+				WriteDefinitionMessage(LOCAL_MSG_RECORD_COMPRESSED, GLOBAL_MSG_NUM_RECORD, COMPRESSED_RECORD_FIELDS, NUM_COMPRESSED_RECORD_FIELDS);
 
-		bool result = true;
-		
-		if (m_needRecordDefinition)
+			Put8(RECORD_HDR_NORMAL | ((LOCAL_MSG_RECORD_COMPRESSED << 5) & RECORD_HDR_LOCAL_MSG_TYPE_COMPRESSED) | (rec.timestamp & RECORD_HDR_TIME_OFFSET));
+			m_lastTimestamp = rec.timestamp;
+		}
+		else
 		{
-			result = WriteNormalDefinitionMessage(globalMsgNum, localMsgType, fieldDefs);
-			if (result)
-				m_needRecordDefinition = false;
+			if (!BeginDataMessage(LOCAL_MSG_RECORD, GLOBAL_MSG_NUM_RECORD, RECORD_FIELDS, NUM_FIELDS(RECORD_FIELDS)))
+				return false;
+			WriteTimestamp(rec.timestamp);
 		}
-		return result && WriteNormalDataMessage(0, fieldDefs, fieldValues);
+
+		Put32((uint32_t)rec.positionLat);
+		Put32((uint32_t)rec.positionLong);
+		Put16(rec.altitude);
+		Put8(rec.heartRate);
+		Put8(rec.cadence);
+		Put32(rec.distance);
+		Put16(rec.speed);
+		Put16(rec.power);
+		return true;
 	}
 
-	uint16_t FitFileWriter::CRC(uint16_t crc, uint8_t byte)
+	bool FitFileWriter::WriteHrv(const std::vector<double>& rrIntervalsSecs)
 	{
-		static const uint16_t CRC_TABLE[16] =
+		for (size_t i = 0; i < rrIntervalsSecs.size(); i += FIT_HRV_INTERVALS_PER_MESSAGE)
 		{
-			0x0000, 0xCC01, 0xD801, 0x1400, 0xF001, 0x3C00, 0x2800, 0xE401,
-			0xA001, 0x6C00, 0x7800, 0xB401, 0x5000, 0x9C01, 0x8801, 0x4400
-		};
-
-		uint16_t tmp = CRC_TABLE[crc & 0xF];
-		crc  = (crc >> 4) & 0x0FFF;
-		crc  = crc ^ tmp ^ CRC_TABLE[byte & 0xF];
+			if (!BeginDataMessage(LOCAL_MSG_HRV, GLOBAL_MSG_NUM_HRV, HRV_FIELDS, NUM_FIELDS(HRV_FIELDS)))
+				return false;
 
-		tmp = CRC_TABLE[crc & 0xF];
-		crc  = (crc >> 4) & 0x0FFF;
-		crc  = crc ^ tmp ^ CRC_TABLE[(byte >> 4) & 0xF];
+			// Unused elements of the last message are left invalid.
+			for (size_t j = i; j < i + FIT_HRV_INTERVALS_PER_MESSAGE; ++j)
+			{
+				if (j < rrIntervalsSecs.size() && rrIntervalsSecs[j] >= 0.0 && rrIntervalsSecs[j] * 1000.0 < FIT_INVALID_UINT16)
+					Put16((uint16_t)(rrIntervalsSecs[j] * 1000.0 + 0.5));
+				else
+					Put16(FIT_INVALID_UINT16);
+			}
+		}
+		return true;
+	}
 
-		return crc;
+	bool FitFileWriter::WriteActivity(const FitActivity& activity)
+	{
+		if (!BeginDataMessage(LOCAL_MSG_ACTIVITY, GLOBAL_MSG_NUM_ACTIVITY, ACTIVITY_FIELDS, NUM_FIELDS(ACTIVITY_FIELDS)))
+			return false;
+
+		WriteTimestamp(activity.timestamp);
+		Put32(activity.totalTimerTime);
+		Put16(activity.numSessions);
+		Put8(activity.type);
+		Put8(activity.event);
+		Put8(activity.eventType);
+		Put32(activity.localTimestamp);
+		return true;
 	}
 
 	uint32_t FitFileWriter::UnixTimestampToFitTimestamp(uint64_t unixTimestamp)
 	{
-		return (uint32_t)(unixTimestamp - 631065600);
+		return (uint32_t)(unixTimestamp - FIT_EPOCH_OFFSET);
 	}
 
 	int32_t FitFileWriter::DegreesToSemicircles(double degrees)
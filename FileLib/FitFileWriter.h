@@ -10,11 +10,13 @@
 
 #pragma once
 
+#include <string>
 #include <vector>
 #include "File.h"
+#include "FitTags.h"
 
-#define FIT_INVALID_UINT8 0xFF
-#define FIT_INVALID_UINT16 0xFFFF
+#define FIT_HRV_INTERVALS_PER_MESSAGE 5 // Beat to beat intervals in each hrv message
+#define FIT_PRODUCT_NAME_SIZE 20        // Product names are written as fixed length strings, including the terminator
 
 namespace FileLib
 {
@@ -32,67 +34,124 @@ namespace FileLib
 		uint8_t size;
 		uint8_t baseType;
 	} FieldDefinition;
-	typedef std::vector<FieldDefinition> FieldDefinitions;
-
-	typedef union FieldValue
-	{
-		uint32_t    uintVal;
-		int32_t     intVal;
-		double      floatVal;
-	} FieldValue;
-	typedef std::vector<FieldValue> FieldValues;
 
 	typedef struct __attribute__((__packed__)) FitHeader
 	{
 		uint8_t  headerSize;        // Indicates the length of this file header including header size. Minimum size is 12.
 		uint8_t  protocolVersion;   // Protocol version number as provided in SDK.
-		uint8_t  profileVersionLsb; // Profile version number as provided in SDK.
-		uint8_t  profileVersionMsb; // Profile version number as provided in SDK.
+		uint16_t profileVersion;    // Profile version number as provided in SDK (major * 100 + minor).
 		uint32_t dataSize;          // Length of the Data Records section in bytes. Does not include Header or CRC.
 		uint8_t  dataType[4];       // ASCII values for “.FIT”.
-		uint16_t crc;               // CRC.
+		uint16_t crc;               // CRC of the first 12 bytes.
 	} FitHeader;
 
+	// Fields that aren't known should be left at their default (invalid) values.
+
 	typedef struct FileId
 	{
-		uint8_t  file;
-		uint16_t manufacturer;
-		uint16_t product;
-		uint32_t serialNumber;
-		uint32_t timeCreated;
-		uint16_t number;
-		std::string productName;		
+		uint8_t  file = FIT_FILE_ACTIVITY;
+		uint16_t manufacturer = FIT_MANUFACTURER_DEVELOPMENT;
+		uint16_t product = 0;
+		uint32_t serialNumber = 0; // uint32z, zero is invalid
+		uint32_t timeCreated = FIT_INVALID_UINT32;
+		uint16_t number = FIT_INVALID_UINT16;
+		std::string productName;
 	} FileId;
 
 	typedef struct FileCreator
 	{
-		uint16_t softwareVersion;
-		uint8_t  hardwareVersion;
+		uint16_t softwareVersion = FIT_INVALID_UINT16;
+		uint8_t  hardwareVersion = FIT_INVALID_UINT8;
 	} FileCreator;
 
-	typedef struct FitSession
+	typedef struct FitDeviceInfo
 	{
-	} FitSession;
+		uint32_t timestamp = FIT_INVALID_UINT32;
+		uint8_t  deviceIndex = 0; // 0 = creator
+		uint16_t manufacturer = FIT_MANUFACTURER_DEVELOPMENT;
+		uint32_t serialNumber = 0; // uint32z, zero is invalid
+		uint16_t product = FIT_INVALID_UINT16;
+		uint16_t softwareVersion = FIT_INVALID_UINT16; // Version * 100
+		std::string productName;
+	} FitDeviceInfo;
 
 	typedef struct FitLap
 	{
+		uint32_t timestamp = FIT_INVALID_UINT32;        // End of the lap
+		uint8_t  event = FIT_EVENT_LAP;
+		uint8_t  eventType = FIT_EVENT_TYPE_STOP;
+		uint32_t startTime = FIT_INVALID_UINT32;
+		uint32_t totalElapsedTime = FIT_INVALID_UINT32; // Milliseconds
+		uint32_t totalTimerTime = FIT_INVALID_UINT32;   // Milliseconds, excluding pauses
+		uint32_t totalDistance = FIT_INVALID_UINT32;    // Centimeters
+		uint16_t totalCalories = FIT_INVALID_UINT16;    // kcal
+		uint16_t avgSpeed = FIT_INVALID_UINT16;         // Millimeters per second
+		uint16_t maxSpeed = FIT_INVALID_UINT16;         // Millimeters per second
+		uint8_t  avgHeartRate = FIT_INVALID_UINT8;
+		uint8_t  maxHeartRate = FIT_INVALID_UINT8;
+		uint8_t  avgCadence = FIT_INVALID_UINT8;
+		uint8_t  maxCadence = FIT_INVALID_UINT8;
+		uint16_t avgPower = FIT_INVALID_UINT16;
+		uint16_t maxPower = FIT_INVALID_UINT16;
+		uint16_t totalAscent = FIT_INVALID_UINT16;      // Meters
+		uint16_t totalDescent = FIT_INVALID_UINT16;     // Meters
+		uint16_t messageIndex = FIT_INVALID_UINT16;
+		uint8_t  lapTrigger = FIT_LAP_TRIGGER_MANUAL;
+		uint8_t  sport = FIT_ENUM_INVALID;
+		uint8_t  subSport = FIT_ENUM_INVALID;
 	} FitLap;
 
+	// A session summarizes every lap of one sport, so it has the same fields as a lap plus the laps it covers.
+	typedef struct FitSession : public FitLap
+	{
+		FitSession() { event = FIT_EVENT_SESSION; };
+
+		uint16_t firstLapIndex = 0;
+		uint16_t numLaps = FIT_INVALID_UINT16;
+		uint8_t  trigger = FIT_SESSION_TRIGGER_ACTIVITY_END;
+	} FitSession;
+
 	typedef struct FitEvent
 	{
+		uint32_t timestamp = FIT_INVALID_UINT32;
+		uint8_t  event = FIT_EVENT_TIMER;
+		uint8_t  eventType = FIT_EVENT_TYPE_START;
+		uint32_t data = FIT_INVALID_UINT32;
+		uint8_t  eventGroup = FIT_INVALID_UINT8;
 	} FitEvent;
 
+	typedef struct FitActivity
+	{
+		uint32_t timestamp = FIT_INVALID_UINT32;
+		uint32_t totalTimerTime = FIT_INVALID_UINT32;   // Milliseconds
+		uint16_t numSessions = 1;
+		uint8_t  type = FIT_ACTIVITY_MANUAL;
+		uint8_t  event = FIT_EVENT_ACTIVITY;
+		uint8_t  eventType = FIT_EVENT_TYPE_STOP;
+		uint32_t localTimestamp = FIT_INVALID_UINT32;   // Timestamp adjusted to the local time zone
+	} FitActivity;
+
 	typedef struct FitRecord
 	{
-		uint32_t timestamp;
-		int32_t  positionLong; // Longitude, in semicircles
-		int32_t  positionLat;  // Longitude, in semicircles
-		uint16_t altitude;
-		uint16_t power;        // Power, in watts, or 0xFFFF if not set
-		uint16_t cadence256;   // Cadence, in rpm, or 0xFFFF if not set
-		uint8_t  heartRate;    // Heart rate, in bpm
+		uint32_t timestamp = FIT_INVALID_UINT32;
+		int32_t  positionLong = FIT_INVALID_SINT32;  // Longitude, in semicircles
+		int32_t  positionLat = FIT_INVALID_SINT32;   // Latitude, in semicircles
+		uint16_t altitude = FIT_INVALID_UINT16;      // (Meters + 500) * 5
+		uint8_t  heartRate = FIT_INVALID_UINT8;      // Heart rate, in bpm
+		uint8_t  cadence = FIT_INVALID_UINT8;        // Cadence, in rpm
+		uint32_t distance = FIT_INVALID_UINT32;      // Cumulative distance, in centimeters
+		uint16_t speed = FIT_INVALID_UINT16;         // Millimeters per second
+		uint16_t power = FIT_INVALID_UINT16;         // Power, in watts
 	} FitRecord;
 
+	/**
+	* Writes FIT activity files.
+	*
+	* The whole file is assembled in memory and written with a single call when the file is closed, since the header
+	* needs the final data size and the trailer needs a CRC of everything before it. Each message type has a fixed
+	* local message number, and its definition is written the first time the message type is used. Records whose
+	* timestamp is within 31 seconds of the previous timestamp use a compressed timestamp header.
+	*/
 	class FitFileWriter : public File
 	{
 	public:
@@ -102,40 +161,45 @@ namespace FileLib
 		bool CreateFile(const std::string& fileName);
 		bool CloseFile();
 
-		bool StartActivity();
-		bool EndActivity();
+		/// @brief Writes the timer start event.
+		bool StartActivity(uint32_t timestamp);
 
-		bool StartLap(uint32_t lapStartedTime);
+		/// @brief Writes the timer stop event. Should be followed by the lap, session, and activity messages.
+		bool EndActivity(uint32_t timestamp);
 
 		bool WriteFileId(const FileId& fileId);
 		bool WriteFileCreator(const FileCreator& creator);
+		bool WriteDeviceInfo(const FitDeviceInfo& deviceInfo);
 		bool WriteSport(uint8_t sportType);
 		bool WriteSession(const FitSession& session);
+		bool WriteLap(const FitLap& lap);
 		bool WriteEvent(const FitEvent& evt);
 		bool WriteRecord(const FitRecord& rec);
+		bool WriteHrv(const std::vector<double>& rrIntervalsSecs); // Intervals are timestamped by the preceding message
+		bool WriteActivity(const FitActivity& activity);
 
 		static uint32_t UnixTimestampToFitTimestamp(uint64_t unixTimestamp);
 		static int32_t DegreesToSemicircles(double degrees);
 		static uint8_t SportTypeToEnum(const std::string& sportType);
 
 	private:
-		bool m_needLapDefinition;
-		bool m_needRecordDefinition;
-		uint16_t m_dataLen;
-		uint16_t m_crc;
+		std::vector<uint8_t> m_buffer;          // The entire file, written when the file is closed
+		uint32_t             m_definedMessages; // Bit mask of the local message types that have been defined
+		uint32_t             m_lastTimestamp;   // Last full timestamp written, the reference for compressed timestamps
+		bool                 m_haveTimestamp;
 
 	private:
+		bool WriteString(const std::string& str);
 		bool WriteBinaryData(const uint8_t* data, size_t len);
 
-		bool WriteFitFileHeader();
-		bool UpdateFitFileHeader();
-
-		bool WriteNormalDefinitionMessage(uint16_t globalMsgNum, uint8_t localMsgType, const std::vector<FieldDefinition>& fieldDefinitions);
-		bool WriteNormalDataMessage(uint8_t localMsgType, const FieldDefinitions& fieldDefinitions, const FieldValues& fieldValues);
-
-		bool WriteString(const std::string& str);
+		void WriteDefinitionMessage(uint8_t localMsgType, uint16_t globalMsgNum, const FieldDefinition* fieldDefs, size_t numFields);
+		bool BeginDataMessage(uint8_t localMsgType, uint16_t globalMsgNum, const FieldDefinition* fieldDefs, size_t numFields);
+		void WriteTimestamp(uint32_t timestamp);
 
-		uint16_t CRC(uint16_t crc, uint8_t byte);
+		inline void Put8(uint8_t value) { m_buffer.push_back(value); };
+		inline void Put16(uint16_t value) { m_buffer.push_back((uint8_t)value); m_buffer.push_back((uint8_t)(value >> 8)); };
+		inline void Put32(uint32_t value) { Put16((uint16_t)value); Put16((uint16_t)(value >> 16)); };
+		void PutString(const std::string& str, size_t fieldSize);
 	};
 }
 
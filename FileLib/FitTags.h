@@ -0,0 +1,344 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __FITTAGS__
+#define __FITTAGS__
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Record message header byte offsets.
+#define RECORD_HDR_NORMAL                    0x80 // 0 = Normal Header
+#define RECORD_HDR_MSG_TYPE                  0x40 // 1 = Definition, 0 = Data Message
+#define RECORD_HDR_MSG_TYPE_SPECIFIC         0x20 // Contains developer specific data
+#define RECORD_HDR_RESERVED                  0x10
+#define RECORD_HDR_LOCAL_MSG_TYPE            0x0f
+#define RECORD_HDR_LOCAL_MSG_TYPE_COMPRESSED 0x60
+#define RECORD_HDR_TIME_OFFSET               0x1f // Compressed timestamp headers only
+
+// Protocol version.
+#define FIT_PROTOCOL_VERSION_MAJOR_SHIFT 4
+#define FIT_PROTOCOL_VERSION_10 ((uint8_t)(1 << FIT_PROTOCOL_VERSION_MAJOR_SHIFT) | 0)
+#define FIT_PROTOCOL_VERSION_20 ((uint8_t)(2 << FIT_PROTOCOL_VERSION_MAJOR_SHIFT) | 0)
+
+// Profile version.
+#define FIT_PROFILE_VERSION_MAJOR 21
+#define FIT_PROFILE_VERSION_MINOR 60
+
+// Global message numbers.
+#define GLOBAL_MSG_NUM_FILE_ID 0
+#define GLOBAL_MSG_NUM_CAPABILITIES 1
+#define GLOBAL_MSG_NUM_DEVICE_SETTINGS 2
+#define GLOBAL_MSG_NUM_USER_PROFILE 3
+#define GLOBAL_MSG_NUM_HRM_PROFILE 4
+#define GLOBAL_MSG_NUM_SDM_PROFILE 5
+#define GLOBAL_MSG_NUM_BIKE_PROFILE 6
+#define GLOBAL_MSG_NUM_ZONES_TARGET 7
+#define GLOBAL_MSG_NUM_HR_ZONE 8
+#define GLOBAL_MSG_NUM_POWER_ZONE 9
+#define GLOBAL_MSG_NUM_MET_ZONE 10
+#define GLOBAL_MSG_NUM_SPORT 12
+#define GLOBAL_MSG_NUM_GOAL 15
+#define GLOBAL_MSG_NUM_SESSION 18
+#define GLOBAL_MSG_NUM_LAP 19
+#define GLOBAL_MSG_NUM_RECORD 20
+#define GLOBAL_MSG_NUM_EVENT 21
+#define GLOBAL_MSG_NUM_DEVICE_INFO 23
+#define GLOBAL_MSG_NUM_WORKOUT 26
+#define GLOBAL_MSG_NUM_WORKOUT_STEP 27
+#define GLOBAL_MSG_NUM_SCHEDULE 28
+#define GLOBAL_MSG_NUM_WEIGHT_SCALE 30
+#define GLOBAL_MSG_NUM_COURSE 31
+#define GLOBAL_MSG_NUM_COURSE_POINT 32
+#define GLOBAL_MSG_NUM_TOTALS 33
+#define GLOBAL_MSG_NUM_ACTIVITY 34
+#define GLOBAL_MSG_NUM_SOFTWARE 35
+#define GLOBAL_MSG_NUM_FILE_CAPABILITIES 37
+#define GLOBAL_MSG_NUM_MESG_CAPABILITIES 38
+#define GLOBAL_MSG_NUM_FIELD_CAPABILITIES 39
+#define GLOBAL_MSG_NUM_FILE_CREATOR 49
+#define GLOBAL_MSG_NUM_BLOOD_PRESSURE 51
+#define GLOBAL_MSG_NUM_SPEED_ZONE 53
+#define GLOBAL_MSG_NUM_MONITORING 55
+#define GLOBAL_MSG_NUM_TRAINING_FILE 72
+#define GLOBAL_MSG_NUM_HRV 78
+#define GLOBAL_MSG_NUM_ANT_RX 80
+#define GLOBAL_MSG_NUM_ANT_TX 81
+#define GLOBAL_MSG_NUM_ANT_CHANNEL_ID 82
+#define GLOBAL_MSG_NUM_LENGTH 101
+#define GLOBAL_MSG_NUM_MONITORING_INFO 103
+#define GLOBAL_MSG_NUM_PAD 105
+#define GLOBAL_MSG_NUM_SLAVE_DEVICE 106
+#define GLOBAL_MSG_NUM_CONNECTIVITY 127
+#define GLOBAL_MSG_NUM_WEATHER_CONDITIONS 128
+#define GLOBAL_MSG_NUM_WEATHER_ALERT 129
+#define GLOBAL_MSG_NUM_CADENCE_ZONE 131
+#define GLOBAL_MSG_NUM_HR 132
+#define GLOBAL_MSG_NUM_SEGMENT_LAP 142
+#define GLOBAL_MSG_NUM_MEMO_GLOB 145
+#define GLOBAL_MSG_NUM_SEGMENT_ID 148
+#define GLOBAL_MSG_NUM_SEGMENT_LEADERBOARD_ENTRY 149
+#define GLOBAL_MSG_NUM_SEGMENT_POINT 150
+#define GLOBAL_MSG_NUM_SEGMENT_FILE 151
+#define GLOBAL_MSG_NUM_WORKOUT_SESSION 158
+#define GLOBAL_MSG_NUM_WATCHFACE_SETTINGS 159
+#define GLOBAL_MSG_NUM_GPS_METADATA 160
+#define GLOBAL_MSG_NUM_CAMERA_EVENT 161
+#define GLOBAL_MSG_NUM_TIMESTAMP_CORRELATION 162
+#define GLOBAL_MSG_NUM_GYROSCOPE_DATA 164
+#define GLOBAL_MSG_NUM_ACCELEROMETER_DATA 165
+#define GLOBAL_MSG_NUM_THREE_D_SENSOR_CALIBRATION 167
+#define GLOBAL_MSG_NUM_VIDEO_FRAME 169
+#define GLOBAL_MSG_NUM_OBDII_DATA 174
+#define GLOBAL_MSG_NUM_NMEA_SENTENCE 177
+#define GLOBAL_MSG_NUM_AVIATION_ATTITUDE 178
+#define GLOBAL_MSG_NUM_VIDEO 184
+#define GLOBAL_MSG_NUM_VIDEO_TITLE 185
+#define GLOBAL_MSG_NUM_VIDEO_DESCRIPTION 186
+#define GLOBAL_MSG_NUM_VIDEO_CLIP 187
+#define GLOBAL_MSG_NUM_OHR_SETTINGS 188
+#define GLOBAL_MSG_NUM_EXD_SCREEN_CONFIGURATION 200
+#define GLOBAL_MSG_NUM_EXD_DATA_FIELD_CONFIGURATION 201
+#define GLOBAL_MSG_NUM_EXD_DATA_CONCEPT_CONFIGURATION 202
+#define GLOBAL_MSG_NUM_FIELD_DESCRIPTION 206
+#define GLOBAL_MSG_NUM_DEVELOPER_DATA_ID 207
+#define GLOBAL_MSG_NUM_MAGNETOMETER_DATA 208
+#define GLOBAL_MSG_NUM_BAROMETER_DATA 209
+#define GLOBAL_MSG_NUM_ONE_D_SENSOR_CALIBRATION 210
+#define GLOBAL_MSG_NUM_SET 225
+#define GLOBAL_MSG_NUM_STRESS_LEVEL 227
+#define GLOBAL_MSG_NUM_DIVE_SETTINGS 258
+#define GLOBAL_MSG_NUM_DIVE_GAS 259
+#define GLOBAL_MSG_NUM_DIVE_ALARM 262
+#define GLOBAL_MSG_NUM_EXERCISE_TITLE 264
+#define GLOBAL_MSG_NUM_DIVE_SUMMARY 268
+#define GLOBAL_MSG_NUM_JUMP 285
+#define GLOBAL_MSG_NUM_CLIMB_PRO 317
+
+// File enumeration, used in the FileId message.
+#define FIT_FILE_DEVICE 1
+#define FIT_FILE_SETTINGS 2
+#define FIT_FILE_SPORT 3
+#define FIT_FILE_ACTIVITY 4
+#define FIT_FILE_WORKOUT 5
+#define FIT_FILE_COURSE 6
+#define FIT_FILE_SCHEDULES 7
+#define FIT_FILE_WEIGHT 9
+#define FIT_FILE_TOTALS 10
+#define FIT_FILE_GOALS 11
+#define FIT_FILE_BLOOD_PRESSURE 14
+#define FIT_FILE_MONITORING_A 15
+#define FIT_FILE_ACTIVITY_SUMMARY 20
+#define FIT_FILE_MONITORING_DAILY 28
+#define FIT_FILE_MONITORING_B 32
+#define FIT_FILE_SEGMENT 34
+#define FIT_FILE_SEGMENT_LIST 35
+#define FIT_FILE_EXD_CONFIGURATION 50
+#define FIT_FILE_MFG_RANGE_MIN 0xF7
+#define FIT_FILE_MFG_RANGE_MAX 0xFE
+
+// Sport enumeration.
+#define FIT_SPORT_GENERIC 0
+#define FIT_SPORT_RUNNING 1
+#define FIT_SPORT_CYCLING 2
+#define FIT_SPORT_TRANSITION 3 // Mulitsport transition
+#define FIT_SPORT_FITNESS_EQUIPMENT 4
+#define FIT_SPORT_SWIMMING 5
+#define FIT_SPORT_BASKETBALL 6
+#define FIT_SPORT_SOCCER 7
+#define FIT_SPORT_TENNIS 8
+#define FIT_SPORT_AMERICAN_FOOTBALL 9
+#define FIT_SPORT_TRAINING 10
+#define FIT_SPORT_WALKING 11
+#define FIT_SPORT_CROSS_COUNTRY_SKIING 12
+#define FIT_SPORT_ALPINE_SKIING 13
+#define FIT_SPORT_SNOWBOARDING 14
+#define FIT_SPORT_ROWING 15
+#define FIT_SPORT_MOUNTAINEERING 16
+#define FIT_SPORT_HIKING 17
+#define FIT_SPORT_MULTISPORT 18
+#define FIT_SPORT_PADDLING 19
+#define FIT_SPORT_FLYING 20
+#define FIT_SPORT_E_BIKING 21
+#define FIT_SPORT_MOTORCYCLING 22
+#define FIT_SPORT_BOATING 23
+#define FIT_SPORT_DRIVING 24
+#define FIT_SPORT_GOLF 25
+#define FIT_SPORT_HANG_GLIDING 26
+#define FIT_SPORT_HORSEBACK_RIDING 27
+#define FIT_SPORT_HUNTING 28
+#define FIT_SPORT_FISHING 29
+#define FIT_SPORT_INLINE_SKATING 30
+#define FIT_SPORT_ROCK_CLIMBING 31
+#define FIT_SPORT_SAILING 32
+#define FIT_SPORT_ICE_SKATING 33
+#define FIT_SPORT_SKY_DIVING 34
+#define FIT_SPORT_SNOWSHOEING 35
+#define FIT_SPORT_SNOWMOBILING 36
+#define FIT_SPORT_STAND_UP_PADDLEBOARDING 37
+#define FIT_SPORT_SURFING 38
+#define FIT_SPORT_WAKEBOARDING 39
+#define FIT_SPORT_WATER_SKIING 40
+#define FIT_SPORT_KAYAKING 41
+#define FIT_SPORT_RAFTING 42
+#define FIT_SPORT_WINDSURFING 43
+#define FIT_SPORT_KITESURFING 44
+#define FIT_SPORT_TACTICAL 45
+#define FIT_SPORT_JUMPMASTER 46
+#define FIT_SPORT_BOXING 47
+#define FIT_SPORT_FLOOR_CLIMBING 48
+#define FIT_SPORT_DIVING 53
+#define FIT_SPORT_ALL 254
+
+// Sub sport enumeration (partial).
+#define FIT_SUB_SPORT_GENERIC 0
+#define FIT_SUB_SPORT_TREADMILL 1
+#define FIT_SUB_SPORT_STREET 2
+#define FIT_SUB_SPORT_TRAIL 3
+#define FIT_SUB_SPORT_TRACK 4
+#define FIT_SUB_SPORT_SPIN 5
+#define FIT_SUB_SPORT_INDOOR_CYCLING 6
+#define FIT_SUB_SPORT_ROAD 7
+#define FIT_SUB_SPORT_MOUNTAIN 8
+#define FIT_SUB_SPORT_LAP_SWIMMING 17
+#define FIT_SUB_SPORT_OPEN_WATER 18
+#define FIT_SUB_SPORT_VIRTUAL_ACTIVITY 58
+
+// Swim stroke enumeration.
+#define FIT_ENUM_INVALID 0xff
+#define FIT_STROKE_TYPE_INVALID FIT_ENUM_INVALID
+#define FIT_STROKE_TYPE_NO_EVENT 0
+#define FIT_STROKE_TYPE_OTHER 1 // stroke was detected but cannot be identified
+#define FIT_STROKE_TYPE_SERVE 2
+#define FIT_STROKE_TYPE_FOREHAND 3
+#define FIT_STROKE_TYPE_BACKHAND 4
+#define FIT_STROKE_TYPE_SMASH 5
+#define FIT_STROKE_TYPE_COUNT 6
+
+// Lap trigger enumation.
+#define FIT_LAP_TRIGGER_MANUAL 0
+#define FIT_LAP_TRIGGER_TIME 1
+#define FIT_LAP_TRIGGER_DISTANCE 2
+#define FIT_LAP_TRIGGER_POSITION_START 3
+#define FIT_LAP_TRIGGER_POSITION_LAP 4
+#define FIT_LAP_TRIGGER_POSITION_WAYPOINT 5
+#define FIT_LAP_TRIGGER_POSITION_MARKED 6
+#define FIT_LAP_TRIGGER_SESSION_END 7
+#define FIT_LAP_TRIGGER_FITNESS_EQUIPMENT 8
+
+// Base types.
+#define FIT_BASE_TYPE_ENUM 0x00
+#define FIT_BASE_TYPE_SINT8 0x01
+#define FIT_BASE_TYPE_UINT8 0x02
+#define FIT_BASE_TYPE_SINT16 0x83
+#define FIT_BASE_TYPE_UINT16 0x84
+#define FIT_BASE_TYPE_SINT32 0x85
+#define FIT_BASE_TYPE_UINT32 0x86
+#define FIT_BASE_TYPE_STRING 0x07
+#define FIT_BASE_TYPE_FLOAT32 0x88
+#define FIT_BASE_TYPE_FLOAT64 0x89
+#define FIT_BASE_TYPE_UINT8Z 0x0A
+#define FIT_BASE_TYPE_UINT16Z 0x8B
+#define FIT_BASE_TYPE_UINT32Z 0x8C
+#define FIT_BASE_TYPE_BYTE 0x0D
+#define FIT_BASE_TYPE_SINT64 0x8E
+#define FIT_BASE_TYPE_UINT64 0x8F
+#define FIT_BASE_TYPE_UINT64Z 0x90
+
+// Event enumeration.
+#define FIT_EVENT_TIMER 0
+#define FIT_EVENT_WORKOUT 3
+#define FIT_EVENT_WORKOUT_STEP 4
+#define FIT_EVENT_SESSION 8
+#define FIT_EVENT_LAP 9
+#define FIT_EVENT_ACTIVITY 26
+#define FIT_EVENT_RECOVERY_HR 23
+
+// Event type enumeration.
+#define FIT_EVENT_TYPE_START 0
+#define FIT_EVENT_TYPE_STOP 1
+#define FIT_EVENT_TYPE_MARKER 3
+#define FIT_EVENT_TYPE_STOP_ALL 4
+
+// Session trigger enumeration.
+#define FIT_SESSION_TRIGGER_ACTIVITY_END 0
+
+// Activity enumeration.
+#define FIT_ACTIVITY_MANUAL 0
+#define FIT_ACTIVITY_AUTO_MULTI_SPORT 1
+
+// Manufacturer enumeration.
+#define FIT_MANUFACTURER_DEVELOPMENT 255
+
+// Invalid values for each base type.
+#define FIT_INVALID_UINT8 0xFF
+#define FIT_INVALID_UINT16 0xFFFF
+#define FIT_INVALID_UINT32 0xFFFFFFFF
+#define FIT_INVALID_SINT32 0x7FFFFFFF
+
+// Common field numbers.
+#define FIT_FIELD_TIMESTAMP 253
+#define FIT_FIELD_MESSAGE_INDEX 254
+
+// Seconds between the Unix epoch and the FIT epoch (UTC 00:00 Dec 31 1989).
+#define FIT_EPOCH_OFFSET 631065600
+
+// CRC-16 used for both the file header and the file trailer (CRC-16/ARC, reflected polynomial 0xA001).
+// The tables allow the CRC to be updated eight bytes at a time (slice-by-8).
+struct FitCrcTables
+{
+	uint16_t table[8][256];
+
+	constexpr FitCrcTables() : table()
+	{
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			uint16_t crc = (uint16_t)i;
+
+			for (uint32_t bit = 0; bit < 8; ++bit)
+				crc = (crc & 1) ? (uint16_t)((crc >> 1) ^ 0xA001) : (uint16_t)(crc >> 1);
+			table[0][i] = crc;
+		}
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			for (uint32_t slice = 1; slice < 8; ++slice)
+				table[slice][i] = (uint16_t)((table[slice - 1][i] >> 8) ^ table[0][table[slice - 1][i] & 0xFF]);
+		}
+	}
+};
+
+inline constexpr FitCrcTables FIT_CRC_TABLES;
+
+static inline uint16_t FitCrc16(uint16_t crc, uint8_t byte)
+{
+	return (uint16_t)((crc >> 8) ^ FIT_CRC_TABLES.table[0][(crc ^ byte) & 0xFF]);
+}
+
+static inline uint16_t FitCrc16(uint16_t crc, const uint8_t* data, size_t len)
+{
+	const uint16_t (*table)[256] = FIT_CRC_TABLES.table;
+
+	while (len >= 8)
+	{
+		crc ^= (uint16_t)data[0] | ((uint16_t)data[1] << 8);
+		crc = table[7][crc & 0xFF] ^ table[6][crc >> 8] ^
+			table[5][data[2]] ^ table[4][data[3]] ^ table[3][data[4]] ^
+			table[2][data[5]] ^ table[1][data[6]] ^ table[0][data[7]];
+		data += 8;
+		len -= 8;
+	}
+	while (len > 0)
+	{
+		crc = FitCrc16(crc, *data++);
+		--len;
+	}
+	return crc;
+}
+
+#endif
@@ -7,6 +7,7 @@
 
 #include "GpxFileReader.h"
 #include "GpxTags.h"
+#include "ParseUtils.h"
 
 namespace FileLib
 {	
@@ -47,25 +48,19 @@ namespace FileLib
 				{
 					if (state.compare(GPX_ATTR_NAME_LATITUDE) == 0)
 					{
-						m_curLat = atof((const char*)node->content);
+						m_curLat = ToDouble((const char*)node->content);
 					}
 					else if (state.compare(GPX_ATTR_NAME_LONGITUDE) == 0)
 					{
-						m_curLon = atof((const char*)node->content);
+						m_curLon = ToDouble((const char*)node->content);
 					}
 					else if (state.compare(GPX_TAG_NAME_ELEVATION) == 0)
 					{
-						m_curEle = atof((const char*)node->content);
+						m_curEle = ToDouble((const char*)node->content);
 					}
 					else if (state.compare(GPX_TAG_NAME_TIME) == 0)
 					{
-						struct tm tm;
-
-						if (strptime((const char*)node->content, "%Y-%m-%dT%H:%M:%OS", &tm))
-						{
-							m_curTime = timegm(&tm);
-							m_curTime *= 1000;
-						}
+						ParseIso8601((const char*)node->content, m_curTime);
 					}
 				}
 				break;
@@ -127,11 +122,11 @@ namespace FileLib
 		{
 			if (attrName.compare(GPX_ATTR_NAME_LATITUDE) == 0)
 			{
-				m_curLat = atof((const char*)attr->children->content);
+				m_curLat = ToDouble((const char*)attr->children->content);
 			}
 			else if (attrName.compare(GPX_ATTR_NAME_LONGITUDE) == 0)
 			{
-				m_curLon = atof((const char*)attr->children->content);
+				m_curLon = ToDouble((const char*)attr->children->content);
 			}
 		}
 	}
@@ -66,7 +66,9 @@ namespace FileLib
 
 	bool GpxFileWriter::CloseFile()
 	{
-		return CloseAllTags();
+		bool result = CloseAllTags();
+		result &= File::CloseFile(); // Finishes the compressed stream, if there is one
+		return result;
 	}
 
 	bool GpxFileWriter::WriteMetadata(time_t startTimeMs)
@@ -76,7 +78,8 @@ namespace FileLib
 		if (OpenTag(GPX_TAG_NAME_METADATA))
 		{
 			char buf[32];
-			strftime(buf, sizeof(buf) - 1, "%Y-%m-%dT%H:%M:%SZ", gmtime(&startTimeMs));
+			struct tm utc;
+			strftime(buf, sizeof(buf) - 1, "%Y-%m-%dT%H:%M:%SZ", gmtime_r(&startTimeMs, &utc));
 
 			WriteTagAndValue(GPX_TAG_NAME_TIME, buf);
 			CloseTag();
@@ -209,7 +212,8 @@ namespace FileLib
 		uint16_t ms = t % 1000;
 
 		char buf1[32];
-		strftime(buf1, sizeof(buf1) - 1, "%Y-%m-%dT%H:%M:%S", gmtime(&sec));
+		struct tm utc;
+		strftime(buf1, sizeof(buf1) - 1, "%Y-%m-%dT%H:%M:%S", gmtime_r(&sec, &utc));
 
 		char buf2[32];
 		snprintf(buf2, sizeof(buf2) - 1, "%s.%04uZ", buf1, ms);
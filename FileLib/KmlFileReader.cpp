@@ -6,7 +6,7 @@
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include "KmlFileReader.h"
-#include <stdlib.h>
+#include "ParseUtils.h"
 
 namespace FileLib
 {	
@@ -116,43 +116,43 @@ namespace FileLib
 
 	void KmlFileReader::ParseCoordinatesStr(const char* str)
 	{
-		std::string tokenStr;
-		std::vector<double> tempCoordinates;
-		char* end;
+		// Coordinates are whitespace separated tuples of longitude,latitude[,altitude].
+		const char* cur = str;
 
-		for (size_t i = 0; i < strlen(str); ++i)
+		while (*cur)
 		{
-			switch (str[i])
+			while (*cur == ' ' || *cur == '\t' || *cur == '\n' || *cur == '\r')
+				++cur;
+			if (!*cur)
+				break;
+
+			const char* tupleStart = cur;
+			while (*cur && *cur != ' ' && *cur != '\t' && *cur != '\n' && *cur != '\r')
+				++cur;
+
+			double values[3] = { 0.0, 0.0, 0.0 };
+			size_t numValues = 0;
+			const char* valueStart = tupleStart;
+
+			for (const char* p = tupleStart; p <= cur && numValues < 3; ++p)
 			{
-				case ' ':
-					if (tempCoordinates.size() == 2)
-					{
-						KmlCoordinate coordinate;
-						coordinate.latitude = tempCoordinates.at(1);
-						coordinate.longitude = tempCoordinates.at(0);
-						coordinate.altitude = strtod(tokenStr.c_str(), &end);
-						m_currentPlacemark.coordinates.push_back(coordinate);
-					}
-					tempCoordinates.clear();
-					tokenStr.clear();
-					break;
-				case ',':
-					tempCoordinates.push_back(strtod(tokenStr.c_str(), &end));
-					tokenStr.clear();
-					break;
-				default:
-					tokenStr += str[i];
-					break;
+				if (p == cur || *p == ',')
+				{
+					if (!ParseDouble(valueStart, (size_t)(p - valueStart), values[numValues]))
+						break;
+					++numValues;
+					valueStart = p + 1;
+				}
 			}
-		}
 
-		if (tempCoordinates.size() == 2)
-		{
-			KmlCoordinate coordinate;
-			coordinate.latitude = tempCoordinates.at(1);
-			coordinate.longitude = tempCoordinates.at(0);
-			coordinate.altitude = strtod(tokenStr.c_str(), &end);
-			m_currentPlacemark.coordinates.push_back(coordinate);
+			if (numValues >= 2)
+			{
+				KmlCoordinate coordinate;
+				coordinate.latitude = values[1];
+				coordinate.longitude = values[0];
+				coordinate.altitude = values[2];
+				m_currentPlacemark.coordinates.push_back(coordinate);
+			}
 		}
 	}
 }
@@ -0,0 +1,239 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "ParseUtils.h"
+
+#include <charconv>
+#include <locale.h>
+#include <stdlib.h>
+
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
+
+namespace FileLib
+{
+	static inline bool IsSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+	}
+
+	static inline void TrimWhitespace(const char*& str, size_t& len)
+	{
+		while (len > 0 && IsSpace(*str))
+		{
+			++str;
+			--len;
+		}
+		while (len > 0 && IsSpace(str[len - 1]))
+		{
+			--len;
+		}
+	}
+
+#if !defined(__cpp_lib_to_chars)
+	/// The "C" locale, created once. strtod follows the current locale, which would read "1.5" as 1 in de_DE.
+	static locale_t CLocale(void)
+	{
+		static locale_t cLocale = newlocale(LC_ALL_MASK, "C", (locale_t)0);
+		return cLocale;
+	}
+#endif
+
+	/// Reads exactly numDigits decimal digits.
+	static inline bool ReadDigits(const char*& str, const char* end, size_t numDigits, int& value)
+	{
+		if ((size_t)(end - str) < numDigits)
+		{
+			return false;
+		}
+
+		value = 0;
+		for (size_t i = 0; i < numDigits; ++i)
+		{
+			char c = str[i];
+
+			if (c < '0' || c > '9')
+			{
+				return false;
+			}
+			value = (value * 10) + (c - '0');
+		}
+		str += numDigits;
+		return true;
+	}
+
+	/// Number of days between 1970-01-01 and the given date in the proleptic Gregorian calendar.
+	static int64_t DaysFromCivil(int64_t year, unsigned month, unsigned day)
+	{
+		year -= (month <= 2);
+
+		const int64_t era = (year >= 0 ? year : year - 399) / 400;
+		const unsigned yoe = (unsigned)(year - era * 400);
+		const unsigned doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+		const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+		return era * 146097 + (int64_t)doe - 719468;
+	}
+
+	bool ParseIso8601(const char* str, size_t len, uint64_t& epochMs)
+	{
+		TrimWhitespace(str, len);
+
+		const char* end = str + len;
+		int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+
+		// Date.
+		if (!ReadDigits(str, end, 4, year) || str >= end || *str++ != '-')
+			return false;
+		if (!ReadDigits(str, end, 2, month) || str >= end || *str++ != '-')
+			return false;
+		if (!ReadDigits(str, end, 2, day))
+			return false;
+		if (month < 1 || month > 12 || day < 1 || day > 31)
+			return false;
+
+		// Time. The separator is usually 'T' but RFC 3339 allows a space.
+		if (str >= end || (*str != 'T' && *str != 't' && *str != ' '))
+			return false;
+		++str;
+		if (!ReadDigits(str, end, 2, hour) || str >= end || *str++ != ':')
+			return false;
+		if (!ReadDigits(str, end, 2, minute) || str >= end || *str++ != ':')
+			return false;
+		if (!ReadDigits(str, end, 2, second))
+			return false;
+		if (hour > 23 || minute > 59 || second > 60) // 60 for leap seconds
+			return false;
+
+		// Optional fractional seconds, only millisecond precision is kept.
+		int64_t millis = 0;
+		if (str < end && (*str == '.' || *str == ','))
+		{
+			int64_t scale = 100;
+
+			++str;
+			if (str >= end || *str < '0' || *str > '9')
+				return false;
+			while (str < end && *str >= '0' && *str <= '9')
+			{
+				millis += (*str - '0') * scale;
+				scale /= 10;
+				++str;
+			}
+		}
+
+		// Optional offset from UTC.
+		int64_t offsetSecs = 0;
+		if (str < end)
+		{
+			if (*str == 'Z' || *str == 'z')
+			{
+				++str;
+			}
+			else if (*str == '+' || *str == '-')
+			{
+				int sign = (*str == '-') ? -1 : 1;
+				int offsetHours = 0, offsetMinutes = 0;
+
+				++str;
+				if (!ReadDigits(str, end, 2, offsetHours))
+					return false;
+				if (str < end && *str == ':')
+					++str;
+				if (str < end && !ReadDigits(str, end, 2, offsetMinutes))
+					return false;
+				offsetSecs = sign * (offsetHours * 3600 + offsetMinutes * 60);
+			}
+		}
+		if (str != end)
+		{
+			return false;
+		}
+
+		int64_t secs = DaysFromCivil(year, (unsigned)month, (unsigned)day) * 86400 + hour * 3600 + minute * 60 + second - offsetSecs;
+		if (secs < 0)
+		{
+			return false;
+		}
+
+		epochMs = (uint64_t)secs * 1000 + (uint64_t)millis;
+		return true;
+	}
+
+	bool ParseDouble(const char* str, size_t len, double& value)
+	{
+		TrimWhitespace(str, len);
+
+		// from_chars doesn't accept a leading plus sign.
+		if (len > 0 && *str == '+')
+		{
+			++str;
+			--len;
+		}
+		if (len == 0)
+		{
+			return false;
+		}
+
+#if defined(__cpp_lib_to_chars)
+		double temp = 0.0;
+		std::from_chars_result result = std::from_chars(str, str + len, temp);
+
+		if (result.ec != std::errc() || result.ptr != str + len)
+		{
+			return false;
+		}
+		value = temp;
+		return true;
+#else
+		// Older standard libraries (Apple's libc++ and the NDK) only implement the integer overloads of from_chars.
+		char buf[64];
+		char* parseEnd = NULL;
+
+		if (len >= sizeof(buf))
+		{
+			return false;
+		}
+		memcpy(buf, str, len);
+		buf[len] = '\0';
+
+		double temp = strtod_l(buf, &parseEnd, CLocale());
+		if (parseEnd != buf + len)
+		{
+			return false;
+		}
+		value = temp;
+		return true;
+#endif
+	}
+
+	bool ParseInt64(const char* str, size_t len, int64_t& value)
+	{
+		TrimWhitespace(str, len);
+
+		if (len > 0 && *str == '+')
+		{
+			++str;
+			--len;
+		}
+		if (len == 0)
+		{
+			return false;
+		}
+
+		int64_t temp = 0;
+		std::from_chars_result result = std::from_chars(str, str + len, temp);
+
+		if (result.ec != std::errc() || result.ptr != str + len)
+		{
+			return false;
+		}
+		value = temp;
+		return true;
+	}
+}
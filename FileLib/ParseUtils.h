@@ -0,0 +1,37 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef __PARSEUTILS__
+#define __PARSEUTILS__
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// Locale independent, allocation free parsing of the values found in activity files.
+// Leading and trailing whitespace is ignored. All functions return false if the string
+// doesn't hold a value of the expected type, in which case the output is left unchanged.
+namespace FileLib
+{
+	/// @brief Parses an ISO 8601 date and time (e.g. 2021-01-19T17:33:40.123Z or 2021-01-19T09:33:40-08:00)
+	/// into milliseconds since the Unix epoch. Times without an offset are treated as UTC.
+	bool ParseIso8601(const char* str, size_t len, uint64_t& epochMs);
+	inline bool ParseIso8601(const char* str, uint64_t& epochMs) { return str && ParseIso8601(str, strlen(str), epochMs); };
+
+	bool ParseDouble(const char* str, size_t len, double& value);
+	inline bool ParseDouble(const char* str, double& value) { return str && ParseDouble(str, strlen(str), value); };
+
+	bool ParseInt64(const char* str, size_t len, int64_t& value);
+	inline bool ParseInt64(const char* str, int64_t& value) { return str && ParseInt64(str, strlen(str), value); };
+
+	/// @brief Drop in replacements for atof/atol. Return zero when the string can't be parsed.
+	inline double ToDouble(const char* str) { double value = 0.0; ParseDouble(str, value); return value; };
+	inline int64_t ToInt64(const char* str) { int64_t value = 0; ParseInt64(str, value); return value; };
+}
+
+#endif
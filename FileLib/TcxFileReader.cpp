@@ -7,6 +7,7 @@
 
 #include "TcxFileReader.h"
 #include "TcxTags.h"
+#include "ParseUtils.h"
 
 namespace FileLib
 {	
@@ -48,37 +49,31 @@ namespace FileLib
 				{
 					if (state.compare(TCX_TAG_NAME_LATITUDE) == 0)
 					{
-						m_curLat = atof((const char*)node->content);
+						m_curLat = ToDouble((const char*)node->content);
 					}
 					else if (state.compare(TCX_TAG_NAME_LONGITUDE) == 0)
 					{
-						m_curLon = atof((const char*)node->content);
+						m_curLon = ToDouble((const char*)node->content);
 					}
 					else if (state.compare(TCX_TAG_NAME_ALTITUDE_METERS) == 0)
 					{
-						m_curEle = atof((const char*)node->content);
+						m_curEle = ToDouble((const char*)node->content);
 					}
 					else if (state.compare(TCX_TAG_NAME_VALUE) == 0 && prevState.compare(TCX_TAG_NAME_HEART_RATE_BPM) == 0)
 					{
-						m_curHeartRate = atof((const char*)node->content);
+						m_curHeartRate = ToDouble((const char*)node->content);
 					}
 					else if (state.compare(TCX_TAG_NAME_POWER) == 0)
 					{
-						m_curPower = atof((const char*)node->content);
+						m_curPower = ToDouble((const char*)node->content);
 					}
 					else if (state.compare(TCX_TAG_NAME_CADENCE) == 0)
 					{
-						m_curCadence = atof((const char*)node->content);
+						m_curCadence = ToDouble((const char*)node->content);
 					}
 					else if (state.compare(TCX_TAG_NAME_TIME) == 0)
 					{
-						struct tm tm;
-
-						if (strptime((const char*)node->content, "%Y-%m-%dT%H:%M:%OS", &tm))
-						{
-							m_curTime = timegm(&tm);
-							m_curTime *= 1000;
-						}
+						ParseIso8601((const char*)node->content, m_curTime);
 					}
 				}
 				break;
@@ -148,24 +143,24 @@ namespace FileLib
 		{
 			if (attrName.compare(TCX_TAG_NAME_LATITUDE) == 0)
 			{
-				m_curLat = atof((const char*)attr->children->content);
+				m_curLat = ToDouble((const char*)attr->children->content);
 			}
 			else if (attrName.compare(TCX_TAG_NAME_LONGITUDE) == 0)
 			{
-				m_curLon = atof((const char*)attr->children->content);
+				m_curLon = ToDouble((const char*)attr->children->content);
 			}
 		}
 		else if (state.compare(TCX_TAG_NAME_VALUE) == 0 && prevState.compare(TCX_TAG_NAME_HEART_RATE_BPM) == 0)
 		{
-			m_curHeartRate = atof((const char*)attr->children->content);
+			m_curHeartRate = ToDouble((const char*)attr->children->content);
 		}
 		else if (state.compare(TCX_TAG_NAME_POWER) == 0)
 		{
-			m_curPower = atof((const char*)attr->children->content);
+			m_curPower = ToDouble((const char*)attr->children->content);
 		}
 		else if (state.compare(TCX_TAG_NAME_CADENCE) == 0)
 		{
-			m_curCadence = atof((const char*)attr->children->content);
+			m_curCadence = ToDouble((const char*)attr->children->content);
 		}
 	}
 
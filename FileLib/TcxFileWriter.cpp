@@ -63,7 +63,9 @@ namespace FileLib
 
 	bool TcxFileWriter::CloseFile()
 	{
-		return CloseAllTags();
+		bool result = CloseAllTags();
+		result &= File::CloseFile(); // Finishes the compressed stream, if there is one
+		return result;
 	}
 
 	bool TcxFileWriter::WriteId(time_t startTimeMs)
@@ -273,7 +275,8 @@ namespace FileLib
 	std::string TcxFileWriter::FormatTimeSec(time_t t)
 	{
 		char buf[32];
-		strftime(buf, sizeof(buf) - 1, "%Y-%m-%dT%H:%M:%SZ", gmtime(&t));
+		struct tm utc;
+		strftime(buf, sizeof(buf) - 1, "%Y-%m-%dT%H:%M:%SZ", gmtime_r(&t, &utc));
 		return buf;
 	}
 
@@ -283,7 +286,8 @@ namespace FileLib
 		uint16_t ms = t % 1000;
 
 		char buf1[32];
-		strftime(buf1, sizeof(buf1) - 1, "%Y-%m-%dT%H:%M:%S", gmtime(&sec));
+		struct tm utc;
+		strftime(buf1, sizeof(buf1) - 1, "%Y-%m-%dT%H:%M:%S", gmtime_r(&sec, &utc));
 
 		char buf2[32];
 		snprintf(buf2, sizeof(buf2) - 1, "%s.%03uZ", buf1, ms);
@@ -6,6 +6,10 @@
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include "XmlFileReader.h"
+#include "CompressedStream.h"
+
+#include <limits.h>
+#include <mutex>
 
 namespace FileLib
 {
@@ -17,57 +21,119 @@ namespace FileLib
 	{
 	}
 
-	void ParseNode(XmlFileReader* reader, xmlNode* node)
+	/// libxml2 only needs to be set up once per process. It is never torn down, since xmlCleanupParser
+	/// is not safe to call while another thread might still be parsing.
+	static void InitializeXmlParser()
 	{
-		for (xmlNode* curNode = node; curNode; curNode = curNode->next)
-		{
-			if (curNode->type == XML_ELEMENT_NODE)
-			{
-				reader->PushState((const char*)curNode->name);
-			}
+		static std::once_flag initFlag;
 
-			reader->ProcessNode(curNode);
-			ParseNode(reader, curNode->children);
+		std::call_once(initFlag, []() {
+			xmlInitParser();
 
-			xmlAttr* curAttr = curNode->properties;
-			while (curAttr)
-			{
-				reader->ProcessProperties(curAttr);
-				curAttr = curAttr->next;
-			}
-			if (curNode->type == XML_ELEMENT_NODE)
-			{
-				reader->PopState();
-			}
+			// This initialize the library and check potential ABI mismatches between
+			// the version it was compiled for and the actual shared.
+			LIBXML_TEST_VERSION
+		});
+	}
+
+	/// libxml2 input callback for compressed files, which are decompressed a block at a time as the parser asks for more.
+	static int ReadCompressedInput(void* context, char* buffer, int len)
+	{
+		size_t bytesRead = 0;
+
+		if (len < 0 || !((InputFile*)context)->Read((uint8_t*)buffer, (size_t)len, bytesRead))
+		{
+			return -1;
 		}
+		return (int)bytesRead;
 	}
 
 	bool XmlFileReader::ParseFile(const std::string& fileName)
 	{
-		bool result = false;
+		InitializeXmlParser();
 
-		xmlInitParser();
+		InputFile input;
+		if (!input.Open(fileName))
+		{
+			return false;
+		}
 
-		// This initialize the library and check potential ABI mismatches between
-		// the version it was compiled for and the actual shared.
-		LIBXML_TEST_VERSION
+		// Stream the file rather than building a DOM, so that memory use does not grow with the
+		// size of the file and each element reaches the subclass as soon as it closes.
+		// Uncompressed files are memory mapped and parsed in place, compressed ones are decompressed as they're read.
+		xmlTextReaderPtr reader = NULL;
+		if (input.Compression() == COMPRESSION_NONE)
+		{
+			if (input.Size() == 0 || input.Size() > INT_MAX)
+			{
+				return false;
+			}
+			reader = xmlReaderForMemory((const char*)input.Data(), (int)input.Size(), fileName.c_str(), NULL, XML_PARSE_NONET);
+		}
+		else
+		{
+			reader = xmlReaderForIO(ReadCompressedInput, NULL, &input, fileName.c_str(), NULL, XML_PARSE_NONET);
+		}
+		if (!reader)
+		{
+			return false;
+		}
+
+		int status = xmlTextReaderRead(reader);
 
-		xmlDoc* doc = xmlParseFile(fileName.c_str());
-		if (doc)
+		while (status == 1)
 		{
-			xmlNode* rootElement = xmlDocGetRootElement(doc);
-			if (rootElement)
+			switch (xmlTextReaderNodeType(reader))
 			{
-				ParseNode(this, rootElement);
-				result = true;
+				case XML_READER_TYPE_ELEMENT:
+					{
+						xmlNode* node = xmlTextReaderCurrentNode(reader);
+						const xmlChar* name = xmlTextReaderConstLocalName(reader);
+						bool isEmpty = xmlTextReaderIsEmptyElement(reader) == 1;
+
+						PushState(name ? (const char*)name : "");
+
+						if (node)
+						{
+							ProcessNode(node);
+
+							for (xmlAttr* curAttr = node->properties; curAttr; curAttr = curAttr->next)
+							{
+								ProcessProperties(curAttr);
+							}
+						}
+
+						// Self closing elements won't get an end element event.
+						if (isEmpty)
+						{
+							PopState();
+						}
+					}
+					break;
+				case XML_READER_TYPE_TEXT:
+				case XML_READER_TYPE_CDATA:
+					{
+						xmlNode* node = xmlTextReaderCurrentNode(reader);
+
+						if (node)
+						{
+							ProcessNode(node);
+						}
+					}
+					break;
+				case XML_READER_TYPE_END_ELEMENT:
+					PopState();
+					break;
+				default:
+					break;
 			}
 
-			xmlFreeDoc(doc);
+			status = xmlTextReaderRead(reader);
 		}
 
-		// Cleanup function for the XML library.
-		xmlCleanupParser();
+		xmlFreeTextReader(reader);
 
-		return result;
+		// Zero means we reached the end of the document, -1 means a parse error.
+		return status == 0;
 	}
 }
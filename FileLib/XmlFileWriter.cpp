@@ -5,8 +5,10 @@
 // License, v. 2.0. If a copy of the MPL was not distributed with this
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
+#include <charconv>
 #include <iostream>
-#include <sstream>
+#include <limits>
+#include <stdio.h>
 
 #include "XmlFileWriter.h"
 
@@ -14,124 +16,231 @@ namespace FileLib
 {
 	XmlFileWriter::XmlFileWriter()
 	{
+		m_numTags = 0;
+		m_buffer.reserve(XML_WRITER_BUFFER_SIZE + 1024);
 	}
 
 	XmlFileWriter::~XmlFileWriter()
 	{
+		Flush();
 	}
 
 	bool XmlFileWriter::CreateFile(const std::string& fileName)
 	{
 		if (File::CreateFile(fileName))
 		{
-			std::string str = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\" ?>\n";
-			return File::WriteString(str);
+			m_buffer.clear();
+			m_indent.clear();
+			m_numTags = 0;
+			m_buffer += "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\" ?>\n";
+			return true;
 		}
 		return false;
 	}
 
-	bool XmlFileWriter::OpenTag(const std::string& tagName)
+	bool XmlFileWriter::OpenTag(std::string_view tagName)
 	{
-		std::string str = FormatIndent();
-		str += "<";
-		str += tagName;
-		str += ">\n";
+		m_buffer += m_indent;
+		m_buffer += '<';
+		m_buffer += tagName;
+		m_buffer += ">\n";
 
-		m_tags.push(tagName);
-		return File::WriteString(str);
+		PushTag(tagName);
+		return FlushIfFull();
 	}
 
-	bool XmlFileWriter::OpenTag(const std::string& tagName, const XmlKeyValueList& keyValues, bool valuesOnIndividualLines)
+	bool XmlFileWriter::OpenTag(std::string_view tagName, const XmlKeyValueList& keyValues, bool valuesOnIndividualLines)
 	{
-		std::string indent = FormatIndent();
+		m_buffer += m_indent;
+		m_buffer += '<';
+		m_buffer += tagName;
+		m_buffer += ' ';
 
-		std::string str = indent;
-		str += "<";
-		str += tagName;
-		str += " ";
-		
 		for (auto iter = keyValues.begin(); iter != keyValues.end(); ++iter)
 		{
 			if (valuesOnIndividualLines)
 			{
-				str += "\n";
-				str += indent;
-				str += " ";
+				m_buffer += '\n';
+				m_buffer += m_indent;
+				m_buffer += ' ';
 			}
 			else if (iter != keyValues.begin())
 			{
-				str += " ";
+				m_buffer += ' ';
 			}
-			str += (*iter).key;
-			str += "=\"";
-			str += (*iter).value;
-			str += "\"";
+			m_buffer += (*iter).key;
+			m_buffer += "=\"";
+			AppendEscaped((*iter).value, true);
+			m_buffer += '\"';
 		}
-		str += ">\n";
-		
-		m_tags.push(tagName);
-		return File::WriteString(str);		
+		m_buffer += ">\n";
+
+		PushTag(tagName);
+		return FlushIfFull();
 	}
 
-	bool XmlFileWriter::WriteTagAndValue(const std::string& tagName, uint32_t value)
+	bool XmlFileWriter::WriteTagAndValue(std::string_view tagName, uint32_t value)
 	{
-		std::stringstream strValue;
-		strValue << value;
-		return WriteTagAndValue(tagName, strValue.str());
+		char buf[16];
+		std::to_chars_result result = std::to_chars(buf, buf + sizeof(buf), value);
+
+		// Digits never need escaping.
+		m_buffer += m_indent;
+		m_buffer += '<';
+		m_buffer += tagName;
+		m_buffer += '>';
+		m_buffer.append(buf, result.ptr - buf);
+		m_buffer += "</";
+		m_buffer += tagName;
+		m_buffer += ">\n";
+		return FlushIfFull();
 	}
-	
-	bool XmlFileWriter::WriteTagAndValue(const std::string& tagName, double value)
+
+	bool XmlFileWriter::WriteTagAndValue(std::string_view tagName, double value)
 	{
-		std::stringstream strValue;
-		strValue.precision(std::numeric_limits<double>::digits10 + 2);
-		strValue << value;
-		return WriteTagAndValue(tagName, strValue.str());
+		const int precision = std::numeric_limits<double>::digits10 + 2;
+
+		char buf[48];
+		size_t len = 0;
+
+		// Same output as a stringstream with this precision, which is what these files have always contained.
+#if defined(__cpp_lib_to_chars)
+		std::to_chars_result result = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::general, precision);
+		len = result.ptr - buf;
+#else
+		len = snprintf(buf, sizeof(buf), "%.*g", precision, value);
+#endif
+
+		m_buffer += m_indent;
+		m_buffer += '<';
+		m_buffer += tagName;
+		m_buffer += '>';
+		m_buffer.append(buf, len);
+		m_buffer += "</";
+		m_buffer += tagName;
+		m_buffer += ">\n";
+		return FlushIfFull();
 	}
-	
-	bool XmlFileWriter::WriteTagAndValue(const std::string& tagName, const std::string& value)
+
+	bool XmlFileWriter::WriteTagAndValue(std::string_view tagName, std::string_view value)
 	{
-		std::string str = FormatIndent();
-		str += "<";
-		str += tagName;
-		str += ">";
-		str += value;
-		str += "</";
-		str += tagName;
-		str += ">\n";
-		return File::WriteString(str);		
+		m_buffer += m_indent;
+		m_buffer += '<';
+		m_buffer += tagName;
+		m_buffer += '>';
+		AppendEscaped(value, false);
+		m_buffer += "</";
+		m_buffer += tagName;
+		m_buffer += ">\n";
+		return FlushIfFull();
 	}
-	
+
 	bool XmlFileWriter::CloseTag()
 	{
-		std::string tagName = m_tags.top();
-		m_tags.pop();
+		PopTag();
 
-		std::string str = FormatIndent();
-		str += "</";
-		str += tagName;
-		str += ">\n";
-		return File::WriteString(str);		
+		m_buffer += m_indent;
+		m_buffer += "</";
+		m_buffer += m_tags[m_numTags];
+		m_buffer += ">\n";
+		return FlushIfFull();
 	}
-	
+
 	bool XmlFileWriter::CloseAllTags()
 	{
 		bool result = true;
 
-		while (m_tags.size() > 0 && result)
+		while (m_numTags > 0 && result)
 		{
 			result &= CloseTag();
 		}
+		result &= Flush();
 		return result;
 	}
 
-	std::string XmlFileWriter::FormatIndent()
+	bool XmlFileWriter::Flush()
+	{
+		if (!m_file.is_open())
+		{
+			return false;
+		}
+		bool result = true;
+
+		if (m_buffer.size() > 0)
+		{
+			result = Write(m_buffer.data(), m_buffer.size());
+			m_buffer.clear();
+		}
+		return result && m_file.good();
+	}
+
+	bool XmlFileWriter::WriteString(const std::string& str)
 	{
-		std::string str;
+		m_buffer += str;
+		return FlushIfFull();
+	}
 
-		for (uint8_t i = 0; i < m_tags.size(); ++i)
+	bool XmlFileWriter::WriteBinaryData(const uint8_t* data, size_t len)
+	{
+		m_buffer.append((const char*)data, len);
+		return FlushIfFull();
+	}
+
+	void XmlFileWriter::PushTag(std::string_view tagName)
+	{
+		if (m_numTags < m_tags.size())
+			m_tags[m_numTags].assign(tagName);
+		else
+			m_tags.emplace_back(tagName);
+		++m_numTags;
+		m_indent += "  ";
+	}
+
+	void XmlFileWriter::PopTag()
+	{
+		--m_numTags;
+		m_indent.resize(m_numTags * 2);
+	}
+
+	void XmlFileWriter::AppendEscaped(std::string_view str, bool isAttribute)
+	{
+		// Almost every value is a number, a timestamp, or a plain name, so check before doing it the slow way.
+		const char* specialChars = isAttribute ? "&<>\"" : "&<>";
+		if (str.find_first_of(specialChars) == std::string_view::npos)
+		{
+			m_buffer += str;
+			return;
+		}
+
+		for (char c : str)
+		{
+			switch (c)
+			{
+				case '&':
+					m_buffer += "&amp;";
+					break;
+				case '<':
+					m_buffer += "&lt;";
+					break;
+				case '>':
+					m_buffer += "&gt;";
+					break;
+				case '\"':
+					m_buffer += isAttribute ? "&quot;" : "\"";
+					break;
+				default:
+					m_buffer += c;
+					break;
+			}
+		}
+	}
+
+	bool XmlFileWriter::FlushIfFull()
+	{
+		if (m_buffer.size() >= XML_WRITER_BUFFER_SIZE)
 		{
-			str += "  ";
+			return Flush();
 		}
-		return str;
+		return m_file.is_open();
 	}
 }
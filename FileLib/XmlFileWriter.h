@@ -11,11 +11,13 @@
 #pragma once
 
 #include <iostream>
-#include <stack>
+#include <string_view>
 #include <vector>
 
 #include "File.h"
 
+#define XML_WRITER_BUFFER_SIZE (64 * 1024) // Output is collected in memory and written to the file in chunks of about this size
+
 namespace FileLib
 {
 	typedef struct XmlKeyValuePair
@@ -34,22 +36,34 @@ namespace FileLib
 		
 		bool CreateFile(const std::string& fileName);
 		
-		bool OpenTag(const std::string& tagName);
-		bool OpenTag(const std::string& tagName, const XmlKeyValueList& keyValues, bool valuesOnIndividualLines = false);
+		bool OpenTag(std::string_view tagName);
+		bool OpenTag(std::string_view tagName, const XmlKeyValueList& keyValues, bool valuesOnIndividualLines = false);
 
-		bool WriteTagAndValue(const std::string& tagName, uint32_t value);
-		bool WriteTagAndValue(const std::string& tagName, double value);
-		bool WriteTagAndValue(const std::string& tagName, const std::string& value);
+		bool WriteTagAndValue(std::string_view tagName, uint32_t value);
+		bool WriteTagAndValue(std::string_view tagName, double value);
+		bool WriteTagAndValue(std::string_view tagName, std::string_view value);
 
 		bool CloseTag();
 		bool CloseAllTags();
 		
-		const std::string& CurrentTag() const { return m_tags.top(); }
-		
+		const std::string& CurrentTag() const { return m_tags[m_numTags - 1]; }
+
+		/// @brief Writes any buffered output to the file. Called automatically once all tags are closed.
+		bool Flush();
+
+		virtual bool WriteString(const std::string& str);
+		virtual bool WriteBinaryData(const uint8_t* data, size_t len);
+
 	private:
-		std::stack<std::string> m_tags;
+		std::string              m_buffer;  // Output that hasn't been written to the file yet
+		std::string              m_indent;  // Indentation for the current depth, updated as tags are opened and closed
+		std::vector<std::string> m_tags;    // Open tags, entries beyond m_numTags are kept so their storage can be reused
+		size_t                   m_numTags;
 
-		std::string FormatIndent();
+		void PushTag(std::string_view tagName);
+		void PopTag();
+		void AppendEscaped(std::string_view str, bool isAttribute);
+		bool FlushIfFull();
 	};
 }
 
@@ -7,6 +7,7 @@
 
 #include "ZwoFileReader.h"
 #include "ZwoTags.h"
+#include "ParseUtils.h"
 
 namespace FileLib
 {	
@@ -143,38 +144,38 @@ namespace FileLib
 		{
 			if (attrName.compare(ZWO_ATTR_NAME_DURATION) == 0)
 			{
-				m_warmup.duration = (uint32_t)atol((const char*)attr->children->content);
+				m_warmup.duration = (uint32_t)ToDouble((const char*)attr->children->content);
 			}
 			else if (attrName.compare(ZWO_ATTR_NAME_POWERLOW) == 0)
 			{
-				m_warmup.powerLow = atof((const char*)attr->children->content);
+				m_warmup.powerLow = ToDouble((const char*)attr->children->content);
 			}
 			else if (attrName.compare(ZWO_ATTR_NAME_POWERHIGH) == 0)
 			{
-				m_warmup.powerHigh = atof((const char*)attr->children->content);
+				m_warmup.powerHigh = ToDouble((const char*)attr->children->content);
 			}
 			else if (attrName.compare(ZWO_ATTR_NAME_PACE) == 0)
 			{
-				m_warmup.pace = atof((const char*)attr->children->content);
+				m_warmup.pace = ToDouble((const char*)attr->children->content);
 			}
 		}
 		else if (state.compare(ZWO_TAG_WORKOUT_COOLDOWN) == 0)
 		{
 			if (attrName.compare(ZWO_ATTR_NAME_DURATION) == 0)
 			{
-				m_cooldown.duration = (uint32_t)atol((const char*)attr->children->content);
+				m_cooldown.duration = (uint32_t)ToDouble((const char*)attr->children->content);
 			}
 			else if (attrName.compare(ZWO_ATTR_NAME_POWERLOW) == 0)
 			{
-				m_cooldown.powerLow = atof((const char*)attr->children->content);
+				m_cooldown.powerLow = ToDouble((const char*)attr->children->content);
 			}
 			else if (attrName.compare(ZWO_ATTR_NAME_POWERHIGH) == 0)
 			{
-				m_cooldown.powerHigh = atof((const char*)attr->children->content);
+				m_cooldown.powerHigh = ToDouble((const char*)attr->children->content);
 			}
 			else if (attrName.compare(ZWO_ATTR_NAME_PACE) == 0)
 			{
-				m_cooldown.pace = atof((const char*)attr->children->content);
+				m_cooldown.pace = ToDouble((const char*)attr->children->content);
 			}
 		}
 		else if (state.compare(ZWO_TAG_WORKOUT_STEADYSTATE) == 0)
@@ -184,34 +185,34 @@ namespace FileLib
 		{
 			if (attrName.compare(ZWO_ATTR_NAME_REPEAT) == 0)
 			{
-				m_currentInterval.repeat = (uint32_t)atol((const char*)attr->children->content);
+				m_currentInterval.repeat = (uint32_t)ToDouble((const char*)attr->children->content);
 			}
 			else if (attrName.compare(ZWO_ATTR_NAME_ONDURATION) == 0)
 			{
-				m_currentInterval.onDuration = (uint32_t)atol((const char*)attr->children->content);
+				m_currentInterval.onDuration = (uint32_t)ToDouble((const char*)attr->children->content);
 			}
 			else if (attrName.compare(ZWO_ATTR_NAME_OFFDURATION) == 0)
 			{
-				m_currentInterval.offDuration = (uint32_t)atol((const char*)attr->children->content);
+				m_currentInterval.offDuration = (uint32_t)ToDouble((const char*)attr->children->content);
 			}
 			else if (attrName.compare(ZWO_ATTR_NAME_ONPOWER) == 0)
 			{
-				m_currentInterval.onPower = atof((const char*)attr->children->content);
+				m_currentInterval.onPower = ToDouble((const char*)attr->children->content);
 			}
 			else if (attrName.compare(ZWO_ATTR_NAME_OFFPOWER) == 0)
 			{
-				m_currentInterval.offPower = atof((const char*)attr->children->content);
+				m_currentInterval.offPower = ToDouble((const char*)attr->children->content);
 			}
 		}
 		else if (state.compare(ZWO_TAG_WORKOUT_FREERIDE) == 0)
 		{
 			if (attrName.compare(ZWO_ATTR_NAME_DURATION) == 0)
 			{
-				m_currentFreeRide.duration = (uint32_t)atol((const char*)attr->children->content);
+				m_currentFreeRide.duration = (uint32_t)ToDouble((const char*)attr->children->content);
 			}
 			else if (attrName.compare(ZWO_ATTR_NAME_FLATROAD) == 0)
 			{
-				m_currentFreeRide.flatRoad = atof((const char*)attr->children->content);
+				m_currentFreeRide.flatRoad = ToDouble((const char*)attr->children->content);
 			}
 		}
 	}
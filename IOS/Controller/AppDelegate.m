@@ -9,7 +9,6 @@
 #import "TargetConditionals.h"
 
 #import "AppDelegate.h"
-#import "ActivityHash.h"
 #import "ActivityMgr.h"
 #import "Accelerometer.h"
 #import "ActivityAttribute.h"
@@ -2262,13 +2261,20 @@ void startSensorCallback(SensorType type, void* context)
 
 - (NSString*)hashCurrentActivity
 {
-	ActivityHash* hash = [[ActivityHash alloc] init];
 	NSString* activityId = [[NSString alloc] initWithFormat:@"%s", GetCurrentActivityId()];
-	NSString* hashStr = [hash calculateWithActivityId:activityId];
 
-	if (hashStr)
+	// The hash is kept up to date while recording and saved when the activity is stopped.
+	NSString* hashStr = [self getActivityHash:activityId];
+
+	if (!hashStr)
 	{
-		CreateOrUpdateActivityHash([activityId UTF8String], [hashStr UTF8String]);
+		char* activityHash = ComputeActivityHash([activityId UTF8String]);
+
+		if (activityHash)
+		{
+			hashStr = [NSString stringWithFormat:@"%s", activityHash];
+			free((void*)activityHash);
+		}
 	}
 	return hashStr;
 }
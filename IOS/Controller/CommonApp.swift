@@ -31,6 +31,14 @@ class CommonApp : ObservableObject {
 			NSLog("Initialize failed.")
 		}
 
+		// Index any activities recorded before the geospatial index existed, and find the personal records in any
+		// recorded before they were kept. Both run in the background and pick up where they left off if the app was
+		// closed part way through.
+#if !os(watchOS)
+		let _ = StartGeoIndexBackfill()
+		let _ = StartPersonalRecordsUpdate()
+#endif
+
 		// Build the list of activity types the backend can handle.
 		CommonApp.activityTypes = []
 #if os(watchOS)
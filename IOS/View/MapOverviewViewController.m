@@ -414,31 +414,58 @@
 
 #pragma mark heat map functionality
 
-void HeapMapPointReceived(Coordinate coordinate, uint32_t count, void* context)
+#define HEAT_MAP_OVERVIEW_ZOOM 10
+
+typedef struct HeatMapBounds
+{
+	CLLocationDegrees maxLat;
+	CLLocationDegrees maxLon;
+	CLLocationDegrees minLat;
+	CLLocationDegrees minLon;
+	uint32_t          tileCount;
+} HeatMapBounds;
+
+static CLLocationDegrees TileLatitude(uint32_t zoom, uint32_t tileY)
+{
+	double n = M_PI * (1.0 - 2.0 * (double)tileY / (double)(1 << zoom));
+	return atan(sinh(n)) * 180.0 / M_PI;
+}
+
+static CLLocationDegrees TileLongitude(uint32_t zoom, uint32_t tileX)
+{
+	return (double)tileX / (double)(1 << zoom) * 360.0 - 180.0;
+}
+
+void HeatMapTileReceived(uint32_t zoom, uint32_t tileX, uint32_t tileY, const uint32_t* counts, void* context)
 {
-//	MapOverviewViewController* ptrToViewController = (__bridge MapOverviewViewController*)context;
+	HeatMapBounds* bounds = (HeatMapBounds*)context;
+
+	bounds->maxLat = MAX(bounds->maxLat, TileLatitude(zoom, tileY));
+	bounds->minLat = MIN(bounds->minLat, TileLatitude(zoom, tileY + 1));
+	bounds->minLon = MIN(bounds->minLon, TileLongitude(zoom, tileX));
+	bounds->maxLon = MAX(bounds->maxLon, TileLongitude(zoom, tileX + 1));
+	bounds->tileCount++;
 }
 
 - (void)showHeatMap
 {
-	CLLocationDegrees maxLat = -90;
-	CLLocationDegrees maxLon = -180;
-	CLLocationDegrees minLat = 90;
-	CLLocationDegrees minLon = 180;
-
-	uint32_t pointCount = 0;
-	
-	if (CreateHeatMap(HeapMapPointReceived, (__bridge void*)self))
-	{
-	}
-	
-	if (pointCount > 0)
+	HeatMapBounds bounds;
+
+	bounds.maxLat = -90;
+	bounds.maxLon = -180;
+	bounds.minLat = 90;
+	bounds.minLon = 180;
+	bounds.tileCount = 0;
+
+	CreateHeatMap(HEAT_MAP_OVERVIEW_ZOOM, HeatMapTileReceived, &bounds);
+
+	if (bounds.tileCount > 0)
 	{
 		MKCoordinateRegion region;
-		region.center.latitude = (maxLat + minLat) / 2;
-		region.center.longitude = (maxLon + minLon) / 2;
-		region.span.latitudeDelta = maxLat - minLat;
-		region.span.longitudeDelta = maxLon - minLon;
+		region.center.latitude = (bounds.maxLat + bounds.minLat) / 2;
+		region.center.longitude = (bounds.maxLon + bounds.minLon) / 2;
+		region.span.latitudeDelta = bounds.maxLat - bounds.minLat;
+		region.span.longitudeDelta = bounds.maxLon - bounds.minLon;
 		
 		[self.mapView setRegion:region];
 	}
@@ -0,0 +1,121 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#import <XCTest/XCTest.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "CompressedStream.h"
+#include "GpxFileReader.h"
+
+#define TEST_NUM_POINTS 20000
+
+static std::string Gzip(const std::string& data)
+{
+	std::ostringstream out;
+	FileLib::OutputCompressor compressor;
+
+	compressor.Start(FileLib::COMPRESSION_GZIP);
+	compressor.Write(out, (const uint8_t*)data.c_str(), data.size());
+	compressor.Finish(out);
+	return out.str();
+}
+
+static std::string WriteTempFile(const char* const name, const std::string& contents)
+{
+	std::string fileName = [[NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithUTF8String:name]] UTF8String];
+	std::ofstream out(fileName, std::ios::binary);
+
+	out.write(contents.c_str(), contents.size());
+	return fileName;
+}
+
+static bool OnLocation(double lat, double lon, double ele, uint64_t time, void* context)
+{
+	++(*(size_t*)context);
+	return true;
+}
+
+@interface CompressedStreamTest : XCTestCase
+
+@end
+
+@implementation CompressedStreamTest
+
+- (void)setUp
+{
+	// Put setup code here. This method is called before the invocation of each test method in the class.
+}
+
+- (void)tearDown
+{
+	// Put teardown code here. This method is called after the invocation of each test method in the class.
+}
+
+- (void)testReadGzip
+{
+	std::string data;
+	for (size_t i = 0; i < TEST_NUM_POINTS; ++i)
+		data += "line " + std::to_string(i) + "\n";
+
+	// Read back in small pieces, so the decompressor has to stop and resume many times.
+	std::string fileName = WriteTempFile("read.txt.gz", Gzip(data));
+	FileLib::InputFile input;
+	std::string contents;
+	uint8_t buf[1000];
+	size_t bytesRead = 0;
+
+	XCTAssert(input.Open(fileName));
+	XCTAssertEqual(input.Compression(), FileLib::COMPRESSION_GZIP);
+	XCTAssert(input.Data() == NULL);
+	while (input.Read(buf, sizeof(buf), bytesRead) && bytesRead > 0)
+		contents.append((const char*)buf, bytesRead);
+	XCTAssert(contents == data);
+
+	// Concatenated gzip members are one file.
+	fileName = WriteTempFile("concatenated.txt.gz", Gzip(data) + Gzip("tail"));
+	std::vector<uint8_t> all;
+	XCTAssert(input.Open(fileName));
+	XCTAssert(input.ReadAll(all));
+	XCTAssert(std::string(all.begin(), all.end()) == data + "tail");
+
+	// Truncated data is an error, not a short file.
+	std::string compressed = Gzip(data);
+	fileName = WriteTempFile("truncated.txt.gz", compressed.substr(0, compressed.size() / 2));
+	all.clear();
+	XCTAssert(input.Open(fileName));
+	XCTAssertFalse(input.ReadAll(all));
+
+	// A trailer that claims a 4 GB file mustn't cause a 4 GB allocation, it's just a bad checksum.
+	std::string bogusSize = Gzip("x");
+	bogusSize.replace(bogusSize.size() - 4, 4, "\xff\xff\xff\xff");
+	fileName = WriteTempFile("bogus_size.txt.gz", bogusSize);
+	all.clear();
+	XCTAssert(input.Open(fileName));
+	XCTAssertFalse(input.ReadAll(all));
+	XCTAssert(all.capacity() < 1024 * 1024);
+	input.Close();
+}
+
+- (void)testReadGzippedGpx
+{
+	std::string gpx = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<gpx version=\"1.1\"><trk><trkseg>\n";
+	for (size_t i = 0; i < TEST_NUM_POINTS; ++i)
+		gpx += "<trkpt lat=\"37." + std::to_string(i) + "\" lon=\"-122.0\"><ele>10.5</ele><time>2021-01-19T17:33:40Z</time></trkpt>\n";
+	gpx += "</trkseg></trk></gpx>\n";
+
+	std::string fileName = WriteTempFile("track.gpx.gz", Gzip(gpx));
+	FileLib::GpxFileReader reader;
+	size_t numPoints = 0;
+
+	reader.SetNewLocationCallback(OnLocation, &numPoints);
+	XCTAssert(reader.ParseFile(fileName));
+	XCTAssertEqual(numPoints, TEST_NUM_POINTS);
+}
+
+@end
@@ -0,0 +1,117 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#import <XCTest/XCTest.h>
+#include <string>
+#include <vector>
+#include "CsvFileReader.h"
+#include "DataImporter.h"
+
+typedef std::vector<std::vector<std::string>> CsvRows;
+
+static bool OnRow(const std::vector<std::string_view>& fields, void* context)
+{
+	CsvRows* rows = (CsvRows*)context;
+
+	rows->push_back(std::vector<std::string>());
+	for (auto iter = fields.begin(); iter != fields.end(); ++iter)
+		rows->back().push_back(std::string(*iter));
+	return true;
+}
+
+@interface CsvImportTest : XCTestCase
+
+@end
+
+@implementation CsvImportTest
+
+- (void)setUp
+{
+	// Put setup code here. This method is called before the invocation of each test method in the class.
+}
+
+- (void)tearDown
+{
+	// Put teardown code here. This method is called after the invocation of each test method in the class.
+}
+
+- (NSString*)writeCsv:(NSString*)contents name:(NSString*)name
+{
+	NSString* fileName = [NSTemporaryDirectory() stringByAppendingPathComponent:name];
+	[contents writeToFile:fileName atomically:YES encoding:NSUTF8StringEncoding error:nil];
+	return fileName;
+}
+
+- (void)testReader
+{
+	// Fields longer than a SIMD block, quoted delimiters, empty fields, and every kind of line ending.
+	std::string data = "a,b,\"c,d\"\r\n\r\n1,,2\n\"x\"\"y\",3,0123456789012345678901234567890123456789\rlast,";
+	CsvRows rows;
+	FileLib::CsvFileReader reader;
+
+	reader.SetNewRowCallback(OnRow, &rows);
+	XCTAssert(reader.ParseBuffer(data.c_str(), data.size()));
+
+	CsvRows expected = {
+		{ "a", "b", "c,d" },
+		{ "1", "", "2" },
+		{ "x\"y", "3", "0123456789012345678901234567890123456789" },
+		{ "last", "" },
+	};
+	XCTAssert(rows == expected);
+}
+
+- (void)testSensorTagging
+{
+	// Regression test, power and cadence values used to be stored as heart rate readings.
+	NSString* fileName = [self writeCsv:@"Elapsed Time,Latitude,Longitude,Altitude,Heart Rate,Power,Cadence\n"
+		"1611077620000.00000000,37.00000000,-122.00000000,10.00000000,140.00000000,250.00000000,85.00000000\n"
+		"1611077621000.00000000,37.00010000,-122.00000000,11.00000000,141.00000000,251.00000000,86.00000000\n"
+		"Elapsed Time,Heart Rate\n"
+		"1611077622000.00000000,142.00000000\n"
+		"Elapsed Time,Cadence\n"
+		"1611077622000.00000000,87.00000000\n"
+		name:@"sensor_tagging.csv"];
+
+	ImportBatch batch;
+	DataImporter importer;
+
+	XCTAssert(importer.ImportFromFile([fileName UTF8String], "Cycling", "CSV-IMPORT-TEST", batch));
+	XCTAssertEqual(batch.startTime, 1611077620);
+	XCTAssertEqual(batch.endTime, 1611077622);
+	XCTAssertEqual(batch.latitudes.size(), 2);
+
+	std::vector<double> expectedHeartRates = { 140.0, 141.0, 142.0 };
+	std::vector<double> expectedPowers = { 250.0, 251.0 };
+	std::vector<double> expectedCadences = { 85.0, 86.0, 87.0 };
+	XCTAssert(batch.heartRates == expectedHeartRates);
+	XCTAssert(batch.powers == expectedPowers);
+	XCTAssert(batch.cadences == expectedCadences);
+	XCTAssertEqual(batch.powerTimes.at(1), 1611077621000);
+	XCTAssertEqual(batch.cadenceTimes.at(2), 1611077622000);
+
+	[[NSFileManager defaultManager] removeItemAtPath:fileName error:nil];
+}
+
+- (void)testAccelerometerWithoutTitles
+{
+	NSString* fileName = [self writeCsv:@"1611077620000,0.1,0.2,0.3\r\n1611077620010,0.4,0.5,0.6\r\n0,1.0,1.0,1.0\r\n" name:@"accelerometer.csv"];
+
+	ImportBatch batch;
+	DataImporter importer;
+
+	XCTAssert(importer.ImportFromFile([fileName UTF8String], "Running", "CSV-IMPORT-TEST", batch));
+	XCTAssertEqual(batch.accelerometerTimes.size(), 2); // The row with a zero timestamp is skipped
+	XCTAssertEqual(batch.accelerometerX.at(1), 0.4);
+	XCTAssertEqual(batch.accelerometerY.at(1), 0.5);
+	XCTAssertEqual(batch.accelerometerZ.at(1), 0.6);
+	XCTAssertEqual(batch.heartRates.size(), 0);
+
+	[[NSFileManager defaultManager] removeItemAtPath:fileName error:nil];
+}
+
+@end
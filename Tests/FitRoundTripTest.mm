@@ -0,0 +1,303 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#import <XCTest/XCTest.h>
+#include <vector>
+#include "FitFileReader.h"
+#include "FitFileWriter.h"
+
+#define TEST_START_TIME 1611077620 // Unix time
+#define TEST_NUM_RECORDS 120
+
+typedef struct RoundTripResults
+{
+	std::vector<FileLib::FitRecordData> records;
+	std::vector<FileLib::FitLapData> laps;
+	std::vector<FileLib::FitLapData> sessions;
+	std::vector<uint8_t> eventTypes;
+	std::vector<double> rrIntervals;
+	std::string activityType;
+} RoundTripResults;
+
+static bool OnRecord(const FileLib::FitRecordData& record, void* context)
+{
+	((RoundTripResults*)context)->records.push_back(record);
+	return true;
+}
+
+static bool OnLap(const FileLib::FitLapData& lap, void* context)
+{
+	((RoundTripResults*)context)->laps.push_back(lap);
+	return true;
+}
+
+static bool OnSession(const FileLib::FitLapData& session, void* context)
+{
+	((RoundTripResults*)context)->sessions.push_back(session);
+	return true;
+}
+
+static bool OnEvent(uint64_t timestampMs, uint8_t event, uint8_t eventType, uint32_t data, void* context)
+{
+	((RoundTripResults*)context)->eventTypes.push_back(eventType);
+	return true;
+}
+
+static bool OnHrv(uint64_t timestampMs, double rrIntervalSecs, void* context)
+{
+	((RoundTripResults*)context)->rrIntervals.push_back(rrIntervalSecs);
+	return true;
+}
+
+static void OnActivityType(const char* const activityType, void* context)
+{
+	((RoundTripResults*)context)->activityType = activityType;
+}
+
+/// The nibble table CRC from the FIT SDK (FitCRC_Get16), used as an independent reference.
+static uint16_t SdkCrc16(const uint8_t* data, size_t len)
+{
+	static const uint16_t crcTable[16] = {
+		0x0000, 0xCC01, 0xD801, 0x1400, 0xF001, 0x3C00, 0x2800, 0xE401,
+		0xA001, 0x6C00, 0x7800, 0xB401, 0x5000, 0x9C01, 0x8801, 0x4400
+	};
+	uint16_t crc = 0;
+
+	for (size_t i = 0; i < len; ++i)
+	{
+		uint16_t tmp = crcTable[crc & 0xF];
+		crc = (crc >> 4) & 0x0FFF;
+		crc = crc ^ tmp ^ crcTable[data[i] & 0xF];
+
+		tmp = crcTable[crc & 0xF];
+		crc = (crc >> 4) & 0x0FFF;
+		crc = crc ^ tmp ^ crcTable[(data[i] >> 4) & 0xF];
+	}
+	return crc;
+}
+
+@interface FitRoundTripTest : XCTestCase
+
+@end
+
+@implementation FitRoundTripTest
+
+- (void)setUp
+{
+	// Put setup code here. This method is called before the invocation of each test method in the class.
+}
+
+- (void)tearDown
+{
+	// Put teardown code here. This method is called after the invocation of each test method in the class.
+}
+
+- (void)testCrc
+{
+	// The slice-by-8 CRC has to match the byte at a time CRC for every length and alignment.
+	std::vector<uint8_t> data;
+	for (size_t i = 0; i < 1000; ++i)
+		data.push_back((uint8_t)(i * 31 + 7));
+
+	for (size_t offset = 0; offset < 8; ++offset)
+	{
+		for (size_t len = 0; len + offset <= data.size(); len += 13)
+		{
+			uint16_t expected = 0;
+			for (size_t i = 0; i < len; ++i)
+				expected = FitCrc16(expected, data[offset + i]);
+			XCTAssertEqual(FitCrc16(0, data.data() + offset, len), expected);
+		}
+	}
+
+	// CRC-16/ARC check value.
+	XCTAssertEqual(FitCrc16(0, (const uint8_t*)"123456789", 9), 0xBB3D);
+
+	// Header CRC of a 14 byte, protocol 2.0, profile 21.60 header with 16 bytes of data, as computed by the FIT SDK.
+	const uint8_t header[12] = { 0x0E, 0x20, 0x70, 0x08, 0x10, 0x00, 0x00, 0x00, '.', 'F', 'I', 'T' };
+	XCTAssertEqual(SdkCrc16(header, sizeof(header)), 0x62F8);
+	XCTAssertEqual(FitCrc16(0, header, sizeof(header)), 0x62F8);
+}
+
+- (void)testFileLayout
+{
+	// Check the bytes we write against the FIT protocol rather than against our own reader.
+	NSString* fileName = [NSTemporaryDirectory() stringByAppendingPathComponent:@"layout.fit"];
+	FileLib::FitFileWriter writer;
+
+	XCTAssert(writer.CreateFile([fileName UTF8String]));
+	XCTAssert(writer.CloseFile());
+
+	NSData* contents = [NSData dataWithContentsOfFile:fileName];
+	const uint8_t* bytes = (const uint8_t*)[contents bytes];
+	size_t len = [contents length];
+
+	XCTAssert(len > 14 + 2);
+	if (len <= 14 + 2)
+		return;
+
+	// File header.
+	XCTAssertEqual(bytes[0], 14);
+	XCTAssertEqual(bytes[1], 0x20);
+	XCTAssertEqual(bytes[2] | (bytes[3] << 8), FIT_PROFILE_VERSION_MAJOR * 100 + FIT_PROFILE_VERSION_MINOR);
+	XCTAssertEqual((size_t)(bytes[4] | (bytes[5] << 8) | (bytes[6] << 16) | ((uint32_t)bytes[7] << 24)), len - 14 - 2);
+	XCTAssert(memcmp(bytes + 8, ".FIT", 4) == 0);
+	XCTAssertEqual(bytes[12] | (bytes[13] << 8), SdkCrc16(bytes, 12));
+
+	// The first message defines file_id (global message 0), little endian.
+	XCTAssertEqual(bytes[14] & 0xF0, 0x40);
+	XCTAssertEqual(bytes[15], 0);
+	XCTAssertEqual(bytes[16], 0);
+	XCTAssertEqual(bytes[17] | (bytes[18] << 8), 0);
+
+	// The trailing CRC covers everything before it, so the CRC of the whole file is zero.
+	XCTAssertEqual(bytes[len - 2] | (bytes[len - 1] << 8), SdkCrc16(bytes, len - 2));
+	XCTAssertEqual(SdkCrc16(bytes, len), 0);
+
+	[[NSFileManager defaultManager] removeItemAtPath:fileName error:nil];
+}
+
+- (void)testRoundTrip
+{
+	NSString* fileName = [NSTemporaryDirectory() stringByAppendingPathComponent:@"round_trip.fit"];
+	uint32_t startTime = FileLib::FitFileWriter::UnixTimestampToFitTimestamp(TEST_START_TIME);
+	uint32_t endTime = startTime;
+
+	//
+	// Write: one record per second, with a gap longer than a compressed timestamp can represent in the middle.
+	//
+
+	FileLib::FitFileWriter writer;
+
+	XCTAssert(writer.CreateFile([fileName UTF8String]));
+	XCTAssert(writer.WriteSport(FIT_SPORT_RUNNING));
+	XCTAssert(writer.StartActivity(startTime));
+
+	for (size_t i = 0; i < TEST_NUM_RECORDS; ++i)
+	{
+		FileLib::FitRecord rec;
+
+		endTime = startTime + (uint32_t)i + ((i >= TEST_NUM_RECORDS / 2) ? 100 : 0);
+		rec.timestamp = endTime;
+		rec.positionLat = FileLib::FitFileWriter::DegreesToSemicircles(37.0 + i * 0.0001);
+		rec.positionLong = FileLib::FitFileWriter::DegreesToSemicircles(-122.0);
+		rec.altitude = (uint16_t)((100.0 + 500.0) * 5.0);
+		rec.heartRate = 140;
+		rec.cadence = 85;
+		rec.distance = (uint32_t)(i * 300);
+		rec.speed = 3000;
+		if (i % 2 == 0)
+			rec.power = 250;
+		XCTAssert(writer.WriteRecord(rec));
+
+		if (i == 10)
+			XCTAssert(writer.WriteHrv({ 0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 1.1 }));
+
+		if (i == TEST_NUM_RECORDS / 2 - 1)
+		{
+			FileLib::FitLap lap;
+
+			lap.timestamp = endTime;
+			lap.startTime = startTime;
+			lap.totalElapsedTime = (endTime - startTime) * 1000;
+			lap.totalTimerTime = lap.totalElapsedTime;
+			lap.totalDistance = rec.distance;
+			lap.totalCalories = 25;
+			lap.messageIndex = 0;
+			lap.sport = FIT_SPORT_RUNNING;
+			XCTAssert(writer.WriteLap(lap));
+		}
+	}
+
+	FileLib::FitSession session;
+	session.timestamp = endTime;
+	session.startTime = startTime;
+	session.totalElapsedTime = (endTime - startTime) * 1000;
+	session.totalTimerTime = session.totalElapsedTime;
+	session.totalDistance = (TEST_NUM_RECORDS - 1) * 300;
+	session.totalCalories = 50;
+	session.sport = FIT_SPORT_RUNNING;
+	session.numLaps = 1;
+	session.messageIndex = 0;
+
+	FileLib::FitActivity activity;
+	activity.timestamp = endTime;
+	activity.totalTimerTime = session.totalTimerTime;
+
+	XCTAssert(writer.EndActivity(endTime));
+	XCTAssert(writer.WriteSession(session));
+	XCTAssert(writer.WriteActivity(activity));
+	XCTAssert(writer.CloseFile());
+
+	//
+	// Read it back. The reader rejects the file if either CRC is wrong.
+	//
+
+	RoundTripResults results;
+	FileLib::FitFileReader reader;
+
+	reader.SetNewRecordCallback(OnRecord, &results);
+	reader.SetNewLapCallback(OnLap, &results);
+	reader.SetNewSessionCallback(OnSession, &results);
+	reader.SetNewEventCallback(OnEvent, &results);
+	reader.SetNewHrvCallback(OnHrv, &results);
+	reader.SetActivityTypeCallback(OnActivityType, &results);
+	XCTAssert(reader.ParseFile([fileName UTF8String]));
+
+	XCTAssertEqual(results.records.size(), TEST_NUM_RECORDS);
+	for (size_t i = 0; i < results.records.size(); ++i)
+	{
+		const FileLib::FitRecordData& record = results.records.at(i);
+		uint64_t expectedTimeMs = (uint64_t)(TEST_START_TIME + i + ((i >= TEST_NUM_RECORDS / 2) ? 100 : 0)) * 1000;
+
+		XCTAssertEqual(record.timestampMs, expectedTimeMs);
+		XCTAssert(record.hasPosition);
+		XCTAssertEqualWithAccuracy(record.latitude, 37.0 + i * 0.0001, 0.000001);
+		XCTAssertEqualWithAccuracy(record.longitude, -122.0, 0.000001);
+		XCTAssert(record.hasAltitude);
+		XCTAssertEqualWithAccuracy(record.altitude, 100.0, 0.001);
+		XCTAssertEqual(record.heartRate, 140.0);
+		XCTAssertEqual(record.cadence, 85.0);
+		XCTAssertEqualWithAccuracy(record.distance, i * 3.0, 0.001);
+		XCTAssertEqualWithAccuracy(record.speed, 3.0, 0.001);
+		XCTAssertEqual(record.power, (i % 2 == 0) ? 250.0 : FIT_VALUE_NOT_SET);
+	}
+
+	XCTAssertEqual(results.laps.size(), 1);
+	XCTAssertEqual(results.laps.at(0).startTimeMs, (uint64_t)TEST_START_TIME * 1000);
+	XCTAssertEqual(results.laps.at(0).totalDistance, (TEST_NUM_RECORDS / 2 - 1) * 3.0);
+	XCTAssertEqual(results.laps.at(0).totalCalories, 25.0);
+
+	XCTAssertEqual(results.sessions.size(), 1);
+	XCTAssertEqual(results.sessions.at(0).endTimeMs, (uint64_t)(TEST_START_TIME + TEST_NUM_RECORDS - 1 + 100) * 1000);
+	XCTAssertEqual(results.sessions.at(0).totalElapsedSecs, TEST_NUM_RECORDS - 1 + 100.0);
+	XCTAssertEqual(results.sessions.at(0).totalCalories, 50.0);
+	XCTAssertEqual(results.sessions.at(0).sport, FIT_SPORT_RUNNING);
+
+	XCTAssertEqual(results.eventTypes.size(), 2);
+	XCTAssertEqual(results.eventTypes.at(0), FIT_EVENT_TYPE_START);
+	XCTAssertEqual(results.eventTypes.at(1), FIT_EVENT_TYPE_STOP_ALL);
+
+	std::vector<double> expectedIntervals = { 0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 1.1 };
+	XCTAssertEqual(results.rrIntervals.size(), expectedIntervals.size());
+	for (size_t i = 0; i < results.rrIntervals.size() && i < expectedIntervals.size(); ++i)
+		XCTAssertEqualWithAccuracy(results.rrIntervals.at(i), expectedIntervals.at(i), 0.0005);
+
+	XCTAssert(results.activityType.size() > 0);
+
+	//
+	// Compressed timestamps should have been used for every record except the first and the one after the gap.
+	// That makes each record 21 bytes (header + 20 bytes of fields) instead of 25.
+	//
+
+	NSDictionary* attrs = [[NSFileManager defaultManager] attributesOfItemAtPath:fileName error:nil];
+	XCTAssert([attrs fileSize] < TEST_NUM_RECORDS * 22 + 512);
+
+	[[NSFileManager defaultManager] removeItemAtPath:fileName error:nil];
+}
+
+@end
@@ -0,0 +1,138 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#import <XCTest/XCTest.h>
+#include <locale.h>
+#include <string>
+#include <time.h>
+#include "ParseUtils.h"
+
+#define NUM_BENCHMARK_ITERATIONS 100000
+
+@interface ParseUtilsTest : XCTestCase
+
+@end
+
+@implementation ParseUtilsTest
+
+- (void)setUp
+{
+	// Put setup code here. This method is called before the invocation of each test method in the class.
+}
+
+- (void)tearDown
+{
+	// Put teardown code here. This method is called after the invocation of each test method in the class.
+}
+
+- (void)testIso8601
+{
+	uint64_t epochMs = 0;
+
+	XCTAssert(FileLib::ParseIso8601("2021-01-19T17:33:40Z", epochMs));
+	XCTAssert(epochMs == 1611077620000);
+	XCTAssert(FileLib::ParseIso8601("2021-01-19T17:33:40.123Z", epochMs));
+	XCTAssert(epochMs == 1611077620123);
+	XCTAssert(FileLib::ParseIso8601("2021-01-19T09:33:40-08:00", epochMs));
+	XCTAssert(epochMs == 1611077620000);
+	XCTAssert(FileLib::ParseIso8601("2021-01-19T23:03:40+0530", epochMs));
+	XCTAssert(epochMs == 1611077620000);
+	XCTAssert(FileLib::ParseIso8601(" 2000-02-29T00:00:00\n", epochMs));
+	XCTAssert(epochMs == 951782400000);
+
+	XCTAssertFalse(FileLib::ParseIso8601("2021-13-01T00:00:00Z", epochMs));
+	XCTAssertFalse(FileLib::ParseIso8601("2021-01-19", epochMs));
+	XCTAssertFalse(FileLib::ParseIso8601("2021-01-19T17:33:40Zjunk", epochMs));
+}
+
+- (void)testNumbers
+{
+	double value = 0.0;
+	int64_t intValue = 0;
+
+	XCTAssert(FileLib::ParseDouble("-122.25", value));
+	XCTAssertEqual(value, -122.25);
+	XCTAssert(FileLib::ParseDouble(" +1e3 ", value));
+	XCTAssertEqual(value, 1000.0);
+	XCTAssertFalse(FileLib::ParseDouble("abc", value));
+	XCTAssertFalse(FileLib::ParseDouble("", value));
+
+	XCTAssert(FileLib::ParseInt64("1611077620123", intValue));
+	XCTAssertEqual(intValue, 1611077620123);
+	XCTAssertFalse(FileLib::ParseInt64("12.5", intValue));
+}
+
+- (void)testNumbersWithCommaDecimalLocale
+{
+	// Users in these locales write "1,5", but the files we read always use a period.
+	const char* const commaLocales[] = { "de_DE.UTF-8", "de_DE", "fr_FR.UTF-8", "fr_FR" };
+	std::string oldLocale = setlocale(LC_NUMERIC, NULL);
+	bool localeSet = false;
+
+	for (size_t i = 0; i < sizeof(commaLocales) / sizeof(commaLocales[0]) && !localeSet; ++i)
+	{
+		localeSet = setlocale(LC_NUMERIC, commaLocales[i]) != NULL;
+	}
+	XCTAssert(localeSet);
+	XCTAssert(strcmp(localeconv()->decimal_point, ",") == 0);
+
+	double value = 0.0;
+	bool parsed = FileLib::ParseDouble("1.5", value);
+	double converted = FileLib::ToDouble("-122.25");
+	bool parsedComma = FileLib::ParseDouble("1,5", value);
+
+	setlocale(LC_NUMERIC, oldLocale.c_str());
+
+	XCTAssert(parsed);
+	XCTAssertEqual(value, 1.5);
+	XCTAssertEqual(converted, -122.25);
+	XCTAssertFalse(parsedComma);
+}
+
+- (void)testBenchmarkStrptime
+{
+	// Baseline: what the TCX and GPX readers used to do for every <Time> and numeric element.
+	[self measureBlock:^{
+		uint64_t sum = 0;
+		double total = 0.0;
+
+		for (size_t i = 0; i < NUM_BENCHMARK_ITERATIONS; ++i)
+		{
+			struct tm tm;
+
+			memset(&tm, 0, sizeof(tm));
+			if (strptime("2021-01-19T17:33:40.123Z", "%Y-%m-%dT%H:%M:%OS", &tm))
+			{
+				sum += timegm(&tm) * 1000;
+			}
+			total += atof("-122.123456789");
+		}
+		XCTAssert(sum > 0 && total < 0.0);
+	}];
+}
+
+- (void)testBenchmarkParseUtils
+{
+	[self measureBlock:^{
+		uint64_t sum = 0;
+		double total = 0.0;
+
+		for (size_t i = 0; i < NUM_BENCHMARK_ITERATIONS; ++i)
+		{
+			uint64_t epochMs = 0;
+
+			if (FileLib::ParseIso8601("2021-01-19T17:33:40.123Z", epochMs))
+			{
+				sum += epochMs;
+			}
+			total += FileLib::ToDouble("-122.123456789");
+		}
+		XCTAssert(sum > 0 && total < 0.0);
+	}];
+}
+
+@end
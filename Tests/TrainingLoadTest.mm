@@ -0,0 +1,77 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#import <XCTest/XCTest.h>
+#include <math.h>
+#include "TrainingLoad.h"
+
+@interface TrainingLoadTest : XCTestCase
+
+@end
+
+@implementation TrainingLoadTest
+
+- (void)setUp
+{
+	// Put setup code here. This method is called before the invocation of each test method in the class.
+}
+
+- (void)tearDown
+{
+	// Put teardown code here. This method is called after the invocation of each test method in the class.
+}
+
+static TrainingLoadSampleList MakePowerSamples(uint64_t intervalMs, uint64_t durationMs, double lowWatts, double highWatts)
+{
+	TrainingLoadSampleList samples;
+
+	// A minute of low power followed by a minute of high power, repeated.
+	for (uint64_t timeMs = 0; timeMs <= durationMs; timeMs += intervalMs)
+	{
+		TrainingLoadSample sample;
+
+		sample.time = 1000000 + timeMs;
+		sample.value = ((timeMs / 60000) % 2 == 0) ? lowWatts : highWatts;
+		samples.push_back(sample);
+	}
+	return samples;
+}
+
+- (void)testNormalizedPowerSteady
+{
+	TrainingLoadSampleList samples = MakePowerSamples(1000, 600000, 200.0, 200.0);
+	double durationSecs = 0.0;
+	double np = TrainingLoad::NormalizedPower(samples, durationSecs);
+
+	XCTAssertEqualWithAccuracy(np, 200.0, 0.001);
+	XCTAssertEqualWithAccuracy(durationSecs, 600.0, 0.001);
+}
+
+- (void)testNormalizedPowerSubSecondReadings
+{
+	// Readings 250 ms apart have to count for as much as readings a second apart.
+	TrainingLoadSampleList oneHz = MakePowerSamples(1000, 600000, 100.0, 300.0);
+	TrainingLoadSampleList fourHz = MakePowerSamples(250, 600000, 100.0, 300.0);
+	double oneHzSecs = 0.0;
+	double fourHzSecs = 0.0;
+	double oneHzNp = TrainingLoad::NormalizedPower(oneHz, oneHzSecs);
+	double fourHzNp = TrainingLoad::NormalizedPower(fourHz, fourHzSecs);
+
+	XCTAssertEqualWithAccuracy(fourHzSecs, 600.0, 0.001);
+	XCTAssert(oneHzNp > 200.0);
+	XCTAssertEqualWithAccuracy(fourHzNp, oneHzNp, 0.001);
+
+	// As does jitter that leaves readings just under a second apart.
+	TrainingLoadSampleList jittered = MakePowerSamples(990, 600000, 200.0, 200.0);
+	double jitteredSecs = 0.0;
+	double jitteredNp = TrainingLoad::NormalizedPower(jittered, jitteredSecs);
+
+	XCTAssertEqualWithAccuracy(jitteredNp, 200.0, 0.001);
+	XCTAssert(jitteredSecs >= 599.0);
+}
+
+@end
@@ -0,0 +1,141 @@
+// Created by Michael Simms on 10/19/26.
+// Copyright (c) 2026 Michael J. Simms. All rights reserved.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#import <XCTest/XCTest.h>
+#include <random>
+#include <string>
+#include "WorkoutScheduler.h"
+
+#define NUM_BENCHMARK_WEEKS 200
+#define SECS_PER_DAY        86400
+
+@interface WorkoutSchedulerTest : XCTestCase
+
+@end
+
+@implementation WorkoutSchedulerTest
+
+- (void)setUp
+{
+	// Put setup code here. This method is called before the invocation of each test method in the class.
+}
+
+- (void)tearDown
+{
+	// Put teardown code here. This method is called after the invocation of each test method in the class.
+}
+
+/// @brief A week of easy runs with random stress, plus a long run.
+static WorkoutList MakeWeek(std::mt19937& generator, size_t numWorkouts)
+{
+	WorkoutList workouts;
+
+	for (size_t i = 0; i < numWorkouts; ++i)
+	{
+		WorkoutType type = (i == 0) ? WORKOUT_TYPE_LONG_RUN : WORKOUT_TYPE_EASY_RUN;
+		Workout* workout = new Workout(std::to_string(i), type, "Running");
+
+		workout->SetScheduledTime(0);
+		workout->SetEstimatedIntensityScore(20.0 + (double)(generator() % 120));
+		workouts.push_back(std::unique_ptr<Workout>(workout));
+	}
+	return workouts;
+}
+
+static time_t StartOfWeek(void)
+{
+	time_t now = time(NULL);
+	return now - (now % SECS_PER_DAY);
+}
+
+- (void)testOptimizerIsDeterministic
+{
+	std::mt19937 generator(1);
+	time_t startTime = StartOfWeek();
+
+	// More workouts than free days, so the annealer is used rather than the exhaustive search.
+	WorkoutList workouts = MakeWeek(generator, 11);
+	WorkoutList workouts2 = CopyWorkoutList(workouts);
+
+	WorkoutScheduler oneThread;
+	oneThread.SetNumThreads(1);
+	WorkoutList schedule1 = oneThread.ScheduleWorkouts(workouts, startTime, DAY_TYPE_SUNDAY);
+
+	WorkoutScheduler fourThreads;
+	fourThreads.SetNumThreads(4);
+	WorkoutList schedule2 = fourThreads.ScheduleWorkouts(workouts2, startTime, DAY_TYPE_SUNDAY);
+
+	XCTAssert(schedule1.size() == schedule2.size());
+	for (size_t i = 0; i < schedule1.size(); ++i)
+	{
+		XCTAssert(schedule1[i]->GetScheduledTime() == schedule2[i]->GetScheduledTime());
+		XCTAssert(schedule1[i]->GetScheduledTime() >= startTime);
+		XCTAssert(schedule1[i]->GetScheduledTime() < startTime + (DAYS_PER_WEEK * SECS_PER_DAY));
+	}
+}
+
+- (void)testOptimizerQuality
+{
+	std::mt19937 generator(2);
+	time_t startTime = StartOfWeek();
+	double totalRandomScore = 0.0;
+	double totalOptimizerScore = 0.0;
+
+	for (size_t week = 0; week < NUM_BENCHMARK_WEEKS; ++week)
+	{
+		WorkoutList workouts = MakeWeek(generator, 3 + (generator() % 10));
+		WorkoutList workouts2 = CopyWorkoutList(workouts);
+
+		WorkoutScheduler randomRestarts;
+		randomRestarts.SetAlgorithm(SCHEDULING_ALGORITHM_RANDOM_RESTARTS);
+		WorkoutList schedule1 = randomRestarts.ScheduleWorkouts(workouts, startTime, DAY_TYPE_SUNDAY);
+
+		WorkoutScheduler optimizer;
+		WorkoutList schedule2 = optimizer.ScheduleWorkouts(workouts2, startTime, DAY_TYPE_SUNDAY);
+
+		totalRandomScore += randomRestarts.ScoreSchedule(schedule1, startTime);
+		totalOptimizerScore += optimizer.ScoreSchedule(schedule2, startTime);
+	}
+
+	NSLog(@"Average schedule score (lower is better): random restarts %f, optimizer %f", totalRandomScore / NUM_BENCHMARK_WEEKS, totalOptimizerScore / NUM_BENCHMARK_WEEKS);
+	XCTAssert(totalOptimizerScore < totalRandomScore);
+}
+
+- (void)testBenchmarkRandomRestarts
+{
+	[self measureBlock:^{
+		std::mt19937 generator(3);
+		time_t startTime = StartOfWeek();
+
+		for (size_t week = 0; week < NUM_BENCHMARK_WEEKS; ++week)
+		{
+			WorkoutList workouts = MakeWeek(generator, 3 + (generator() % 10));
+			WorkoutScheduler scheduler;
+
+			scheduler.SetAlgorithm(SCHEDULING_ALGORITHM_RANDOM_RESTARTS);
+			scheduler.ScheduleWorkouts(workouts, startTime, DAY_TYPE_SUNDAY);
+		}
+	}];
+}
+
+- (void)testBenchmarkOptimizer
+{
+	[self measureBlock:^{
+		std::mt19937 generator(3);
+		time_t startTime = StartOfWeek();
+
+		for (size_t week = 0; week < NUM_BENCHMARK_WEEKS; ++week)
+		{
+			WorkoutList workouts = MakeWeek(generator, 3 + (generator() % 10));
+			WorkoutScheduler scheduler;
+
+			scheduler.ScheduleWorkouts(workouts, startTime, DAY_TYPE_SUNDAY);
+		}
+	}];
+}
+
+@end
@@ -72,6 +72,12 @@ public:
 	void SetFtp(double ftp) { m_ftp = ftp; };
 	double GetFtp() const { return m_ftp; };
 
+	// Critical power (watts) and W' (joules), for cycling
+	void SetCriticalPower(double criticalPower, double wPrime) { m_criticalPower = criticalPower; m_wPrime = wPrime; };
+	double GetCriticalPower() const { return m_criticalPower; };
+	double GetWPrime() const { return m_wPrime; };
+	bool HasCriticalPower() const { return m_criticalPower > 1.0 && m_wPrime > 1.0; };
+
 	// Resting heart rate
 	void SetRestingHr(double restingHr) { m_restingHr = restingHr; };
 	double GetRestingHr() const { return m_restingHr; };
@@ -122,6 +128,8 @@ private:
 	double        m_weightKg;
 	double        m_leanBodyMassKg;
 	double        m_ftp;
+	double        m_criticalPower;
+	double        m_wPrime;
 	double        m_restingHr;
 	double        m_maxHr;
 	double        m_vo2Max;
@@ -35,6 +35,8 @@ class RouteSummary : Identifiable, Hashable, Equatable {
 	}
 }
 
+let ROUTE_DISPLAY_TOLERANCE_METERS = 10.0 // Routes are only drawn on small maps, so full resolution isn't needed
+
 class RoutesVM : ObservableObject {
 	@Published var routes: Array<RouteSummary> = []
 
@@ -84,7 +86,7 @@ class RoutesVM : ObservableObject {
 	func listRoutes() -> Array<RouteSummary> {
 		var routes: Array<RouteSummary> = []
 		
-		if InitializeRouteList() {
+		if InitializeRouteListAtTolerance(ROUTE_DISPLAY_TOLERANCE_METERS) {
 			var routeIndex = 0
 			var done: Bool = false
 			
@@ -129,6 +129,9 @@ class StoredActivityVM : ObservableObject, Identifiable, Hashable, Equatable {
 			LoadHistoricalActivityLapData(self.activityId) &&
 			LoadAllHistoricalActivitySensorData(self.activityId) {
 			
+			// Start loading the activities the user is likely to look at next
+			PrefetchAdjacentHistoricalActivities(self.activityId)
+			
 			// Location points
 			self.locationTrack = []
 			self.pace = []
@@ -8,7 +8,6 @@
 #import "ExtensionDelegate.h"
 #import "Accelerometer.h"
 #import "ActivityAttribute.h"
-#import "ActivityHash.h"
 #import "ActivityType.h"
 #import "ActivityMgr.h"
 #import "ApiClient.h"
@@ -644,14 +643,20 @@ void syncStatusCallback(const char* const destination, void* context)
 
 - (NSString*)hashCurrentActivity
 {
-	ActivityHash* hash = [[ActivityHash alloc] init];
-
 	NSString* activityId = [[NSString alloc] initWithFormat:@"%s", GetCurrentActivityId()];
-	NSString* hashStr = [hash calculateWithActivityId:activityId];
 
-	if (hashStr)
+	// The hash is kept up to date while recording and saved when the activity is stopped.
+	NSString* hashStr = [self retrieveHashForActivityId:activityId];
+
+	if (!hashStr)
 	{
-		CreateOrUpdateActivityHash([activityId UTF8String], [hashStr UTF8String]);
+		char* activityHash = ComputeActivityHash([activityId UTF8String]);
+
+		if (activityHash)
+		{
+			hashStr = [NSString stringWithFormat:@"%s", activityHash];
+			free((void*)activityHash);
+		}
 	}
 	return hashStr;
 }